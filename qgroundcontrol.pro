@@ -425,12 +425,17 @@ DebugBuild { PX4FirmwarePlugin { PX4FirmwarePluginFactory  { APMFirmwarePlugin {
         src/qgcunittest
 
     HEADERS += \
+        src/AnalyzeView/GeoTagParserTest.h \
         src/AnalyzeView/LogDownloadTest.h \
         src/Audio/AudioOutputTest.h \
         src/FactSystem/FactSystemTestBase.h \
         src/FactSystem/FactSystemTestGeneric.h \
         src/FactSystem/FactSystemTestPX4.h \
+        src/FactSystem/FactUpdateSchedulerTest.h \
+        src/FactSystem/ParameterCacheTest.h \
         src/FactSystem/ParameterManagerTest.h \
+        src/FactSystem/ParameterRequestSchedulerTest.h \
+        src/GPS/RTCM/RTCMMavlinkTest.h \
         src/MissionManager/CameraCalcTest.h \
         src/MissionManager/CameraSectionTest.h \
         src/MissionManager/CorridorScanComplexItemTest.h \
@@ -441,6 +446,7 @@ DebugBuild { PX4FirmwarePlugin { PX4FirmwarePluginFactory  { APMFirmwarePlugin {
         src/MissionManager/MissionManagerTest.h \
         src/MissionManager/MissionSettingsTest.h \
         src/MissionManager/PlanMasterControllerTest.h \
+        src/MissionManager/PolygonScanlineClipperTest.h \
         src/MissionManager/QGCMapPolygonTest.h \
         src/MissionManager/QGCMapPolylineTest.h \
         src/MissionManager/SectionTest.h \
@@ -448,13 +454,19 @@ DebugBuild { PX4FirmwarePlugin { PX4FirmwarePluginFactory  { APMFirmwarePlugin {
         src/MissionManager/SpeedSectionTest.h \
         src/MissionManager/StructureScanComplexItemTest.h \
         src/MissionManager/SurveyComplexItemTest.h \
+        src/MissionManager/TransectRouteOptimizerTest.h \
         src/MissionManager/TransectStyleComplexItemTest.h \
         src/MissionManager/VisualMissionItemTest.h \
+        src/QtLocationPlugin/QGCTileDownloadSchedulerTest.h \
+        src/Terrain/TerrainQueryTest.h \
+        src/Terrain/TerrainTileStoreTest.h \
         src/qgcunittest/FileDialogTest.h \
         src/qgcunittest/FileManagerTest.h \
         src/qgcunittest/FlightGearTest.h \
         src/qgcunittest/GeoTest.h \
         src/qgcunittest/LinkManagerTest.h \
+        src/qgcunittest/LinkSendQueueTest.h \
+        src/qgcunittest/LogReplayIndexTest.h \
         src/qgcunittest/MainWindowTest.h \
         src/qgcunittest/MavlinkLogTest.h \
         src/qgcunittest/MessageBoxTest.h \
@@ -463,15 +475,23 @@ DebugBuild { PX4FirmwarePlugin { PX4FirmwarePluginFactory  { APMFirmwarePlugin {
         src/qgcunittest/TCPLinkTest.h \
         src/qgcunittest/TCPLoopBackServer.h \
         src/qgcunittest/UnitTest.h \
+        src/Vehicle/ADSBTrafficStoreTest.h \
         src/Vehicle/SendMavCommandTest.h \
+        src/Vehicle/TrajectoryHistoryTest.h \
+        src/VideoStreaming/VideoReceiverTest.h \
 
     SOURCES += \
+        src/AnalyzeView/GeoTagParserTest.cc \
         src/AnalyzeView/LogDownloadTest.cc \
         src/Audio/AudioOutputTest.cc \
         src/FactSystem/FactSystemTestBase.cc \
         src/FactSystem/FactSystemTestGeneric.cc \
         src/FactSystem/FactSystemTestPX4.cc \
+        src/FactSystem/FactUpdateSchedulerTest.cc \
+        src/FactSystem/ParameterCacheTest.cc \
         src/FactSystem/ParameterManagerTest.cc \
+        src/FactSystem/ParameterRequestSchedulerTest.cc \
+        src/GPS/RTCM/RTCMMavlinkTest.cc \
         src/MissionManager/CameraCalcTest.cc \
         src/MissionManager/CameraSectionTest.cc \
         src/MissionManager/CorridorScanComplexItemTest.cc \
@@ -482,6 +502,7 @@ DebugBuild { PX4FirmwarePlugin { PX4FirmwarePluginFactory  { APMFirmwarePlugin {
         src/MissionManager/MissionManagerTest.cc \
         src/MissionManager/MissionSettingsTest.cc \
         src/MissionManager/PlanMasterControllerTest.cc \
+        src/MissionManager/PolygonScanlineClipperTest.cc \
         src/MissionManager/QGCMapPolygonTest.cc \
         src/MissionManager/QGCMapPolylineTest.cc \
         src/MissionManager/SectionTest.cc \
@@ -489,13 +510,19 @@ DebugBuild { PX4FirmwarePlugin { PX4FirmwarePluginFactory  { APMFirmwarePlugin {
         src/MissionManager/SpeedSectionTest.cc \
         src/MissionManager/StructureScanComplexItemTest.cc \
         src/MissionManager/SurveyComplexItemTest.cc \
+        src/MissionManager/TransectRouteOptimizerTest.cc \
         src/MissionManager/TransectStyleComplexItemTest.cc \
         src/MissionManager/VisualMissionItemTest.cc \
+        src/QtLocationPlugin/QGCTileDownloadSchedulerTest.cc \
+        src/Terrain/TerrainQueryTest.cc \
+        src/Terrain/TerrainTileStoreTest.cc \
         src/qgcunittest/FileDialogTest.cc \
         src/qgcunittest/FileManagerTest.cc \
         src/qgcunittest/FlightGearTest.cc \
         src/qgcunittest/GeoTest.cc \
         src/qgcunittest/LinkManagerTest.cc \
+        src/qgcunittest/LinkSendQueueTest.cc \
+        src/qgcunittest/LogReplayIndexTest.cc \
         src/qgcunittest/MainWindowTest.cc \
         src/qgcunittest/MavlinkLogTest.cc \
         src/qgcunittest/MessageBoxTest.cc \
@@ -505,7 +532,10 @@ DebugBuild { PX4FirmwarePlugin { PX4FirmwarePluginFactory  { APMFirmwarePlugin {
         src/qgcunittest/TCPLoopBackServer.cc \
         src/qgcunittest/UnitTest.cc \
         src/qgcunittest/UnitTestList.cc \
+        src/Vehicle/ADSBTrafficStoreTest.cc \
         src/Vehicle/SendMavCommandTest.cc \
+        src/Vehicle/TrajectoryHistoryTest.cc \
+        src/VideoStreaming/VideoReceiverTest.cc \
 } } } } } }
 
 # Main QGC Headers and Source files
@@ -549,6 +579,7 @@ HEADERS += \
     src/MissionManager/PlanElementController.h \
     src/MissionManager/PlanManager.h \
     src/MissionManager/PlanMasterController.h \
+    src/MissionManager/PolygonScanlineClipper.h \
     src/MissionManager/QGCFenceCircle.h \
     src/MissionManager/QGCFencePolygon.h \
     src/MissionManager/QGCMapCircle.h \
@@ -562,6 +593,7 @@ HEADERS += \
     src/MissionManager/SpeedSection.h \
     src/MissionManager/StructureScanComplexItem.h \
     src/MissionManager/SurveyComplexItem.h \
+    src/MissionManager/TransectRouteOptimizer.h \
     src/MissionManager/TransectStyleComplexItem.h \
     src/MissionManager/VisualMissionItem.h \
     src/PositionManager/PositionManager.h \
@@ -604,16 +636,21 @@ HEADERS += \
     src/Settings/UnitsSettings.h \
     src/Settings/VideoSettings.h \
     src/Terrain/TerrainQuery.h \
+    src/Terrain/TerrainTileStore.h \
     src/TerrainTile.h \
     src/Vehicle/MAVLinkLogManager.h \
     src/VehicleSetup/JoystickConfigController.h \
     src/comm/LinkConfiguration.h \
     src/comm/LinkInterface.h \
     src/comm/LinkManager.h \
+    src/comm/LinkSendQueue.h \
+    src/comm/LogReplayIndex.h \
+    src/comm/MAVLinkParser.h \
     src/comm/MAVLinkProtocol.h \
     src/comm/ProtocolInterface.h \
     src/comm/QGCMAVLink.h \
     src/comm/TCPLink.h \
+    src/comm/TelemetryLogWriter.h \
     src/comm/UDPLink.h \
     src/uas/UAS.h \
     src/uas/UASInterface.h \
@@ -749,6 +786,7 @@ SOURCES += \
     src/MissionManager/PlanElementController.cc \
     src/MissionManager/PlanManager.cc \
     src/MissionManager/PlanMasterController.cc \
+    src/MissionManager/PolygonScanlineClipper.cc \
     src/MissionManager/QGCFenceCircle.cc \
     src/MissionManager/QGCFencePolygon.cc \
     src/MissionManager/QGCMapCircle.cc \
@@ -761,6 +799,7 @@ SOURCES += \
     src/MissionManager/SpeedSection.cc \
     src/MissionManager/StructureScanComplexItem.cc \
     src/MissionManager/SurveyComplexItem.cc \
+    src/MissionManager/TransectRouteOptimizer.cc \
     src/MissionManager/TransectStyleComplexItem.cc \
     src/MissionManager/VisualMissionItem.cc \
     src/PositionManager/PositionManager.cpp \
@@ -802,15 +841,20 @@ SOURCES += \
     src/Settings/UnitsSettings.cc \
     src/Settings/VideoSettings.cc \
     src/Terrain/TerrainQuery.cc \
+    src/Terrain/TerrainTileStore.cc \
     src/TerrainTile.cc\
     src/Vehicle/MAVLinkLogManager.cc \
     src/VehicleSetup/JoystickConfigController.cc \
     src/comm/LinkConfiguration.cc \
     src/comm/LinkInterface.cc \
     src/comm/LinkManager.cc \
+    src/comm/LinkSendQueue.cc \
+    src/comm/LogReplayIndex.cc \
+    src/comm/MAVLinkParser.cc \
     src/comm/MAVLinkProtocol.cc \
     src/comm/QGCMAVLink.cc \
     src/comm/TCPLink.cc \
+    src/comm/TelemetryLogWriter.cc \
     src/comm/UDPLink.cc \
     src/main.cc \
     src/uas/UAS.cc \
@@ -908,9 +952,11 @@ HEADERS+= \
     src/FirmwarePlugin/CameraMetaData.h \
     src/FirmwarePlugin/FirmwarePlugin.h \
     src/FirmwarePlugin/FirmwarePluginManager.h \
+    src/Vehicle/ADSBTrafficStore.h \
     src/Vehicle/ADSBVehicle.h \
     src/Vehicle/MultiVehicleManager.h \
     src/Vehicle/GPSRTKFactGroup.h \
+    src/Vehicle/TrajectoryHistory.h \
     src/Vehicle/Vehicle.h \
     src/VehicleSetup/VehicleComponent.h \
 
@@ -934,9 +980,11 @@ SOURCES += \
     src/FirmwarePlugin/CameraMetaData.cc \
     src/FirmwarePlugin/FirmwarePlugin.cc \
     src/FirmwarePlugin/FirmwarePluginManager.cc \
+    src/Vehicle/ADSBTrafficStore.cc \
     src/Vehicle/ADSBVehicle.cc \
     src/Vehicle/MultiVehicleManager.cc \
     src/Vehicle/GPSRTKFactGroup.cc \
+    src/Vehicle/TrajectoryHistory.cc \
     src/Vehicle/Vehicle.cc \
     src/VehicleSetup/VehicleComponent.cc \
 
@@ -1082,8 +1130,12 @@ HEADERS += \
     src/FactSystem/FactGroup.h \
     src/FactSystem/FactMetaData.h \
     src/FactSystem/FactSystem.h \
+    src/FactSystem/FactUpdateScheduler.h \
     src/FactSystem/FactValueSliderListModel.h \
+    src/FactSystem/ParameterCache.h \
+    src/FactSystem/ParameterFTPLoader.h \
     src/FactSystem/ParameterManager.h \
+    src/FactSystem/ParameterRequestScheduler.h \
     src/FactSystem/SettingsFact.h \
 
 SOURCES += \
@@ -1092,8 +1144,12 @@ SOURCES += \
     src/FactSystem/FactGroup.cc \
     src/FactSystem/FactMetaData.cc \
     src/FactSystem/FactSystem.cc \
+    src/FactSystem/FactUpdateScheduler.cc \
     src/FactSystem/FactValueSliderListModel.cc \
+    src/FactSystem/ParameterCache.cc \
+    src/FactSystem/ParameterFTPLoader.cc \
     src/FactSystem/ParameterManager.cc \
+    src/FactSystem/ParameterRequestScheduler.cc \
     src/FactSystem/SettingsFact.cc \
 
 #-------------------------------------------------------------------------------------
@@ -13,6 +13,40 @@ ExifParser::~ExifParser()
 
 }
 
+QByteArray ExifParser::readHeader(QIODevice& file)
+{
+    const int maxSegments = 32;
+
+    if (!file.seek(0)) {
+        return QByteArray();
+    }
+
+    // Start of image marker
+    uchar marker[4];
+    if (file.read(reinterpret_cast<char*>(marker), 2) != 2 || marker[0] != 0xFF || marker[1] != 0xD8) {
+        return QByteArray();
+    }
+
+    // Walk the segments which come before the image data until we hit APP1
+    for (int i = 0; i < maxSegments; i++) {
+        if (file.read(reinterpret_cast<char*>(marker), 4) != 4 || marker[0] != 0xFF) {
+            break;
+        }
+        // Segment length is big endian and includes the length bytes
+        qint64 segmentEnd = file.pos() - 2 + ((marker[2] << 8) | marker[3]);
+        if (marker[1] == 0xE1) {
+            file.seek(0);
+            QByteArray header = file.read(segmentEnd);
+            return header.size() == segmentEnd ? header : QByteArray();
+        } else if (marker[1] == 0xDA || !file.seek(segmentEnd)) {
+            // Start of scan, no EXIF data before the image data
+            break;
+        }
+    }
+
+    return QByteArray();
+}
+
 double ExifParser::readTime(QByteArray& buf)
 {
     QByteArray tiffHeader("\x49\x49\x2A", 3);
@@ -3,6 +3,7 @@
 
 #include <QGeoCoordinate>
 #include <QDebug>
+#include <QIODevice>
 
 #include "GeoTagController.h"
 
@@ -13,6 +14,11 @@ public:
     ~ExifParser();
     double readTime(QByteArray& buf);
     bool write(QByteArray& buf, GeoTagWorker::cameraFeedbackPacket& geotag);
+
+    /// Reads the start of a JPEG file up to the end of its EXIF (APP1) segment. Both readTime and write only work on
+    /// this part of the image, so the image data itself never has to be loaded.
+    ///     @return Header bytes, empty if the file has no EXIF segment or can't be read
+    static QByteArray readHeader(QIODevice& file);
 };
 
 #endif // EXIFPARSER_H
@@ -15,7 +15,9 @@
 #include <QtEndian>
 #include <QMessageBox>
 #include <QDebug>
+#include <QtConcurrent>
 #include <cfloat>
+#include <functional>
 
 #include "ExifParser.h"
 #include "ULogParser.h"
@@ -175,52 +177,46 @@ void GeoTagWorker::run(void)
     }
     emit progressChanged((100/nSteps));
 
-    // Parse EXIF
-    ExifParser exifParser;
-    _imageTime.clear();
-    for (int i = 0; i < _imageList.size(); ++i) {
-        QFile file(_imageList.at(i).absoluteFilePath());
+    // The log doesn't depend on the images, parse it while the images are being read
+    QString errorString;
+    QFuture<bool> logFuture = QtConcurrent::run([this, &errorString]() { return _parseLog(errorString); });
+
+    // Parse EXIF. Only the EXIF header of each image is read.
+    QElapsedTimer stageTimer;
+    stageTimer.start();
+    std::function<double(const QFileInfo&)> readImageTime = [](const QFileInfo& imageInfo) {
+        QFile file(imageInfo.absoluteFilePath());
         if (!file.open(QIODevice::ReadOnly)) {
+            return -2.0;
+        }
+        QByteArray header = ExifParser::readHeader(file);
+        return header.isEmpty() ? -1.0 : ExifParser().readTime(header);
+    };
+    int batchSize = QThread::idealThreadCount() * _batchImagesPerThread;
+    _imageTime.clear();
+    for (int i = 0; i < _imageList.size(); i += batchSize) {
+        QList<double> batchTimes = QtConcurrent::blockingMapped(_imageList.mid(i, batchSize), readImageTime);
+        if (batchTimes.contains(-2.0)) {
+            _cancel = true;
+            logFuture.waitForFinished();
             emit error(tr("Geotagging failed. Couldn't open an image."));
             return;
         }
-        QByteArray imageBuffer = file.readAll();
-        file.close();
-
-        _imageTime.append(exifParser.readTime(imageBuffer));
+        _imageTime.append(batchTimes);
 
-        emit progressChanged((100/nSteps) + ((100/nSteps) / _imageList.size())*i);
+        emit progressChanged((100/nSteps) + ((100/nSteps) / _imageList.size())*(i + batchTimes.count()));
 
-        if (_cancel) {
-            qCDebug(GeotaggingLog) << "Tagging cancelled";
-            emit error(tr("Tagging cancelled"));
+        if (_checkCancel()) {
+            logFuture.waitForFinished();
             return;
         }
     }
+    _logThroughput("EXIF read", _imageList.count(), 0, stageTimer);
 
-    // Load log
-    bool isULog = _logFile.endsWith(".ulg", Qt::CaseSensitive);
-    QFile file(_logFile);
-    if (!file.open(QIODevice::ReadOnly)) {
-        emit error(tr("Geotagging failed. Couldn't open log file."));
-        return;
-    }
-    QByteArray log = file.readAll();
-    file.close();
-
-    // Instantiate appropriate parser
-    _triggerList.clear();
-    bool parseComplete = false;
-    QString errorString;
-    if (isULog) {
-        ULogParser parser;
-        parseComplete = parser.getTagsFromLog(log, _triggerList, errorString);
-
-    } else {
-        PX4LogParser parser;
-        parseComplete = parser.getTagsFromLog(log, _triggerList);
-
-    }
+    // Wait for the log
+    stageTimer.start();
+    bool parseComplete = logFuture.result();
+    _logThroughput("Log wait", _triggerList.count(), 0, stageTimer);
 
     if (!parseComplete) {
         if (_cancel) {
@@ -238,9 +234,7 @@ void GeoTagWorker::run(void)
 
     qCDebug(GeotaggingLog) << "Found " << _triggerList.count() << " trigger logs.";
 
-    if (_cancel) {
-        qCDebug(GeotaggingLog) << "Tagging cancelled";
-        emit error(tr("Tagging cancelled"));
+    if (_checkCancel()) {
         return;
     }
 
@@ -252,62 +246,134 @@ void GeoTagWorker::run(void)
     }
     emit progressChanged(4*(100/nSteps));
 
-    if (_cancel) {
-        qCDebug(GeotaggingLog) << "Tagging cancelled";
-        emit error(tr("Tagging cancelled"));
+    if (_checkCancel()) {
         return;
     }
 
     // Tag images
+    stageTimer.start();
     int maxIndex = std::min(_imageIndices.count(), _triggerIndices.count());
     maxIndex = std::min(maxIndex, _imageList.count());
+    QList<int> tagIndices;
+    qint64 tagBytes = 0;
     for(int i = 0; i < maxIndex; i++) {
-        int imageIndex = _imageIndices[i];
-        if (imageIndex >= _imageList.count()) {
+        if (_imageIndices[i] >= _imageList.count()) {
             emit error(tr("Geotagging failed. Image requested not present."));
             return;
         }
-        QFile fileRead(_imageList.at(_imageIndices[i]).absoluteFilePath());
-        if (!fileRead.open(QIODevice::ReadOnly)) {
-            emit error(tr("Geotagging failed. Couldn't open an image."));
-            return;
-        }
-        QByteArray imageBuffer = fileRead.readAll();
-        fileRead.close();
-
-        if (!exifParser.write(imageBuffer, _triggerList[_triggerIndices[i]])) {
-            emit error(tr("Geotagging failed. Couldn't write to image."));
-            return;
-        } else {
-            QFile fileWrite;
-            if(_saveDirectory == "") {
-                fileWrite.setFileName(_imageDirectory + "/TAGGED/" + _imageList.at(_imageIndices[i]).fileName());
-            } else {
-                fileWrite.setFileName(_saveDirectory + "/" + _imageList.at(_imageIndices[i]).fileName());
-            }
-            if (!fileWrite.open(QFile::WriteOnly)) {
-                emit error(tr("Geotagging failed. Couldn't write to an image."));
+        tagIndices.append(i);
+        tagBytes += _imageList.at(_imageIndices[i]).size();
+    }
+    std::function<QString(int)> tagImage = [this](int index) { return _tagImage(index); };
+    for (int i = 0; i < tagIndices.count(); i += batchSize) {
+        QStringList batchErrors = QtConcurrent::blockingMapped(tagIndices.mid(i, batchSize), tagImage);
+        foreach (const QString& batchError, batchErrors) {
+            if (!batchError.isEmpty()) {
+                emit error(batchError);
                 return;
             }
-            fileWrite.write(imageBuffer);
-            fileWrite.close();
         }
-        emit progressChanged(4*(100/nSteps) + ((100/nSteps) / maxIndex)*i);
 
-        if (_cancel) {
-            qCDebug(GeotaggingLog) << "Tagging cancelled";
-            emit error(tr("Tagging cancelled"));
+        emit progressChanged(4*(100/nSteps) + ((100/nSteps) / maxIndex)*(i + batchErrors.count()));
+
+        if (_checkCancel()) {
             return;
         }
     }
+    _logThroughput("Tagging", maxIndex, tagBytes, stageTimer);
 
+    emit progressChanged(100);
+}
+
+/// Loads the trigger list from the log file. Runs in parallel with reading the images.
+bool GeoTagWorker::_parseLog(QString& errorString)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    _triggerList.clear();
+
+    QFile file(_logFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        errorString = tr("Geotagging failed. Couldn't open log file.");
+        return false;
+    }
+
+    bool parseComplete = false;
+    if (_logFile.endsWith(".ulg", Qt::CaseSensitive)) {
+        ULogParser parser;
+        parseComplete = parser.getTagsFromLog(file, _triggerList, errorString);
+    } else {
+        // The PX4 log parser searches the whole log, map it instead of reading it into memory
+        qint64 size = file.size();
+        uchar* data = file.map(0, size);
+        QByteArray log = data ? QByteArray::fromRawData(reinterpret_cast<const char*>(data), static_cast<int>(size)) : file.readAll();
+        PX4LogParser parser;
+        parseComplete = parser.getTagsFromLog(log, _triggerList);
+    }
+
+    _logThroughput("Log parse", _triggerList.count(), file.size(), timer);
+    file.close();
+
+    return parseComplete && !_cancel;
+}
+
+/// Writes the geotag into one image. Only the EXIF header is changed in memory, the image data is copied across
+/// in blocks. Runs on the thread pool.
+///     @return Error message, empty for success
+QString GeoTagWorker::_tagImage(int index)
+{
+    const qint64 copyBlockSize = 256 * 1024;
+
+    // Lists are shared between the pool threads, only use const access
+    const QFileInfo& imageInfo = _imageList.at(_imageIndices.at(index));
+    GeoTagWorker::cameraFeedbackPacket feedback = _triggerList.at(_triggerIndices.at(index));
+
+    QFile fileRead(imageInfo.absoluteFilePath());
+    if (!fileRead.open(QIODevice::ReadOnly)) {
+        return tr("Geotagging failed. Couldn't open an image.");
+    }
+    QByteArray header = ExifParser::readHeader(fileRead);
+    qint64 imageDataOffset = header.size();
+
+    if (header.isEmpty() || !ExifParser().write(header, feedback)) {
+        return tr("Geotagging failed. Couldn't write to image.");
+    }
+
+    QFile fileWrite;
+    if(_saveDirectory == "") {
+        fileWrite.setFileName(_imageDirectory + "/TAGGED/" + imageInfo.fileName());
+    } else {
+        fileWrite.setFileName(_saveDirectory + "/" + imageInfo.fileName());
+    }
+    if (!fileWrite.open(QFile::WriteOnly)) {
+        return tr("Geotagging failed. Couldn't write to an image.");
+    }
+    fileWrite.write(header);
+    fileRead.seek(imageDataOffset);
+    while (!fileRead.atEnd()) {
+        if (fileWrite.write(fileRead.read(copyBlockSize)) < 0) {
+            return tr("Geotagging failed. Couldn't write to an image.");
+        }
+    }
+
+    return QString();
+}
+
+void GeoTagWorker::_logThroughput(const char* stage, int count, qint64 bytes, const QElapsedTimer& timer)
+{
+    double secs = qMax(timer.elapsed(), static_cast<qint64>(1)) / 1000.0;
+    qCDebug(GeotaggingLog) << stage << "count:" << count << "msecs:" << timer.elapsed()
+                           << "per sec:" << count / secs << "MB/s:" << (bytes / (1024.0 * 1024.0)) / secs;
+}
+
+bool GeoTagWorker::_checkCancel(void)
+{
     if (_cancel) {
         qCDebug(GeotaggingLog) << "Tagging cancelled";
         emit error(tr("Tagging cancelled"));
-        return;
     }
-
-    emit progressChanged(100);
+    return _cancel;
 }
 
 bool GeoTagWorker::triggerFiltering()
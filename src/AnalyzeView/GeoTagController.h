@@ -60,6 +60,13 @@ signals:
 
 private:
     bool triggerFiltering();
+    bool _parseLog          (QString& errorString);
+    QString _tagImage       (int index);
+    void _logThroughput     (const char* stage, int count, qint64 bytes, const QElapsedTimer& timer);
+    bool _checkCancel       (void);
+
+    /// Number of images handed to the thread pool at a time, progress and cancel are checked between batches
+    static const int _batchImagesPerThread = 4;
 
     bool                    _cancel;
     QString                 _logFile;
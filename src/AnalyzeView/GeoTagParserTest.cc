@@ -0,0 +1,206 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "GeoTagParserTest.h"
+#include "ExifParser.h"
+#include "ULogParser.h"
+
+#include <QBuffer>
+#include <QtEndian>
+
+#include <string.h>
+
+static const uint16_t   kCameraCaptureMsgId =   7;
+static const uint16_t   kFillerMsgId =          99;
+static const int        kCameraCaptureSize =    64;     // camera_capture fields, including padding
+
+/// @return JPEG segment with its marker and big endian length
+QByteArray GeoTagParserTest::_jpegSegment(uchar marker, const QByteArray& data)
+{
+    QByteArray segment;
+    segment.append(static_cast<char>(0xFF));
+    segment.append(static_cast<char>(marker));
+    segment.append(static_cast<char>(((data.size() + 2) >> 8) & 0xFF));
+    segment.append(static_cast<char>((data.size() + 2) & 0xFF));
+    segment.append(data);
+    return segment;
+}
+
+void GeoTagParserTest::_testExifReadHeader(void)
+{
+    QByteArray jpeg("\xFF\xD8", 2);
+    jpeg.append(_jpegSegment(0xE0, QByteArray("JFIF\0\x01\x01\0\0\x01\0\x01\0\0", 14)));
+    jpeg.append(_jpegSegment(0xE1, QByteArray("Exif\0\0II\x2A\0", 10)));
+    int headerSize = jpeg.size();
+    jpeg.append(_jpegSegment(0xDB, QByteArray(64, 1)));
+    jpeg.append(QByteArray("\xFF\xDA", 2));
+    jpeg.append(QByteArray(4096, 2));
+
+    // Everything up to the end of APP1, none of the image data
+    QBuffer file(&jpeg);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(ExifParser::readHeader(file), jpeg.left(headerSize));
+
+    // APP1 cut short by the end of the file
+    QByteArray truncated = jpeg.left(headerSize - 4);
+    QBuffer truncatedFile(&truncated);
+    QVERIFY(truncatedFile.open(QIODevice::ReadOnly));
+    QVERIFY(ExifParser::readHeader(truncatedFile).isEmpty());
+
+    // Not a JPEG
+    QByteArray png("\x89PNG\r\n\x1A\n", 8);
+    QBuffer pngFile(&png);
+    QVERIFY(pngFile.open(QIODevice::ReadOnly));
+    QVERIFY(ExifParser::readHeader(pngFile).isEmpty());
+}
+
+void GeoTagParserTest::_testExifReadHeaderNoApp1(void)
+{
+    // JFIF only image, the scan starts without an EXIF segment
+    QByteArray jpeg("\xFF\xD8", 2);
+    jpeg.append(_jpegSegment(0xE0, QByteArray("JFIF\0\x01\x01\0\0\x01\0\x01\0\0", 14)));
+    jpeg.append(_jpegSegment(0xDB, QByteArray(64, 1)));
+    jpeg.append(_jpegSegment(0xDA, QByteArray(10, 3)));
+    jpeg.append(QByteArray("\xFF\xE1\x00\x10", 4));     // Looks like APP1 inside the image data
+    jpeg.append(QByteArray(4096, 2));
+
+    QBuffer file(&jpeg);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(ExifParser::readHeader(file).isEmpty());
+}
+
+QByteArray GeoTagParserTest::_ulogHeader(void)
+{
+    QByteArray header("ULog\x01\x12\x35", 7);
+    header.append(static_cast<char>(1));    // Version
+    header.append(QByteArray(8, 0));        // Timestamp
+    return header;
+}
+
+QByteArray GeoTagParserTest::_ulogMessage(char type, const QByteArray& payload)
+{
+    QByteArray message(3, 0);
+    qToLittleEndian<quint16>(static_cast<quint16>(payload.size()), reinterpret_cast<uchar*>(message.data()));
+    message[2] = type;
+    message.append(payload);
+    return message;
+}
+
+/// @return Data messages of another topic which take up exactly length bytes of log
+QByteArray GeoTagParserTest::_ulogFiller(int length)
+{
+    const int maxMessageLength = 3 + 60000;
+    QByteArray filler;
+
+    while (length > 0) {
+        // Never leave less than a minimal message for the end
+        int messageLength = qMin(length, maxMessageLength);
+        if (length - messageLength > 0 && length - messageLength < 5) {
+            messageLength -= 5;
+        }
+        QByteArray payload(messageLength - 3, 0);
+        qToLittleEndian<quint16>(kFillerMsgId, reinterpret_cast<uchar*>(payload.data()));
+        filler.append(_ulogMessage('D', payload));
+        length -= messageLength;
+    }
+    return filler;
+}
+
+QByteArray GeoTagParserTest::_ulogCameraCapture(uint32_t seq, double latitude, double longitude)
+{
+    QByteArray payload(2 + kCameraCaptureSize, 0);
+    uchar* data = reinterpret_cast<uchar*>(payload.data());
+
+    qToLittleEndian<quint16>(kCameraCaptureMsgId, data);
+    data += 2;
+    qToLittleEndian<quint32>(seq, data + 16);
+    memcpy(data + 20, &latitude, sizeof(latitude));
+    memcpy(data + 28, &longitude, sizeof(longitude));
+    data[60] = 1;   // result
+
+    return _ulogMessage('D', payload);
+}
+
+/// @return Log header followed by the camera_capture format and subscription
+QByteArray GeoTagParserTest::_ulogCameraCaptureLog(void)
+{
+    QByteArray format("camera_capture:uint64_t timestamp;uint64_t timestamp_utc;uint32_t seq;double lat;double lon;"
+                      "float alt;float ground_distance;float[4] q;uint8_t result;uint8_t[3] _padding0;");
+
+    QByteArray addLogged(3, 0);
+    qToLittleEndian<quint16>(kCameraCaptureMsgId, reinterpret_cast<uchar*>(addLogged.data()) + 1);
+    addLogged.append("camera_capture");
+
+    return _ulogHeader() + _ulogMessage('F', format) + _ulogMessage('A', addLogged);
+}
+
+void GeoTagParserTest::_testULogBlockBoundary(void)
+{
+    QByteArray log = _ulogCameraCaptureLog();
+
+    // The first capture straddles the end of the first block read from the log, the second one is well inside the
+    // second block
+    const int blockSize = ULogParser::_readBlockSize;
+    log.append(_ulogFiller(blockSize - 20 - log.size()));
+    log.append(_ulogCameraCapture(1, 47.5, 8.25));
+    QVERIFY(log.size() > blockSize);
+    log.append(_ulogFiller(1000));
+    log.append(_ulogCameraCapture(2, -33.5, 151.25));
+
+    QBuffer file(&log);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+
+    ULogParser parser;
+    QList<GeoTagWorker::cameraFeedbackPacket> feedback;
+    QString errorMessage;
+    QVERIFY(parser.getTagsFromLog(file, feedback, errorMessage));
+    QVERIFY(errorMessage.isEmpty());
+    QCOMPARE(feedback.count(), 2);
+    QCOMPARE(feedback[0].imageSequence, 1u);
+    QCOMPARE(feedback[0].latitude, 47.5);
+    QCOMPARE(feedback[0].longitude, 8.25);
+    QCOMPARE(feedback[0].captureResult, static_cast<uint8_t>(1));
+    QCOMPARE(feedback[1].imageSequence, 2u);
+    QCOMPARE(feedback[1].latitude, -33.5);
+    QCOMPARE(feedback[1].longitude, 151.25);
+}
+
+void GeoTagParserTest::_testULogTruncated(void)
+{
+    QByteArray firstCapture = _ulogCameraCapture(1, 47.5, 8.25);
+    QByteArray log = _ulogCameraCaptureLog() + firstCapture + _ulogCameraCapture(2, 47.6, 8.26);
+
+    ULogParser parser;
+    QList<GeoTagWorker::cameraFeedbackPacket> feedback;
+    QString errorMessage;
+
+    // Log cut off in the middle of the last message, everything before it is still used
+    QByteArray truncated = log.left(log.size() - 10);
+    QBuffer truncatedFile(&truncated);
+    QVERIFY(truncatedFile.open(QIODevice::ReadOnly));
+    QVERIFY(parser.getTagsFromLog(truncatedFile, feedback, errorMessage));
+    QCOMPARE(feedback.count(), 1);
+    QCOMPARE(feedback[0].imageSequence, 1u);
+
+    // Cut off before the first capture is complete
+    feedback.clear();
+    truncated = log.left(log.size() - (firstCapture.size() * 2) + 10);
+    QBuffer noCaptureFile(&truncated);
+    QVERIFY(noCaptureFile.open(QIODevice::ReadOnly));
+    QVERIFY(!parser.getTagsFromLog(noCaptureFile, feedback, errorMessage));
+    QCOMPARE(feedback.count(), 0);
+    QVERIFY(!errorMessage.isEmpty());
+
+    // Cut off inside the file header
+    truncated = log.left(ULOG_FILE_HEADER_LEN - 4);
+    QBuffer headerFile(&truncated);
+    QVERIFY(headerFile.open(QIODevice::ReadOnly));
+    QVERIFY(!parser.getTagsFromLog(headerFile, feedback, errorMessage));
+    QVERIFY(!errorMessage.isEmpty());
+}
@@ -0,0 +1,32 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit test for the EXIF header reader and the streaming ULog camera_capture parser used by geotagging
+class GeoTagParserTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testExifReadHeader        (void);
+    void _testExifReadHeaderNoApp1  (void);
+    void _testULogBlockBoundary     (void);
+    void _testULogTruncated         (void);
+
+private:
+    QByteArray _jpegSegment     (uchar marker, const QByteArray& data);
+    QByteArray _ulogHeader      (void);
+    QByteArray _ulogMessage     (char type, const QByteArray& payload);
+    QByteArray _ulogFiller      (int length);
+    QByteArray _ulogCameraCapture(uint32_t seq, double latitude, double longitude);
+    QByteArray _ulogCameraCaptureLog(void);
+};
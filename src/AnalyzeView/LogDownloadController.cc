@@ -32,15 +32,20 @@
 #define kTimeOutMilliseconds 500
 #define kGUIRateMilliseconds 17
 #define kTableBins           512
-#define kChunkSize           (kTableBins * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN)
+#define kMinRequestBins      64
+#define kMaxRequestBins      8192
+#define kRequestMilliseconds 2000
 
 QGC_LOGGING_CATEGORY(LogDownloadLog, "LogDownloadLog")
 
 //-----------------------------------------------------------------------------
 struct LogDownloadData {
     LogDownloadData(QGCLogEntry* entry);
-    QBitArray     chunk_table;
-    uint32_t      current_chunk;
+    QBitArray     bins;             ///< One bit per MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN bin of the log, set once written
+    uint32_t      bins_received;
+    uint32_t      first_missing;    ///< Every bin before this one has been received
+    uint32_t      request_end;      ///< One past the last bin of the outstanding request
+    uint32_t      request_bins;     ///< Maximum number of bins to ask for in one request
     QFile         file;
     QString       filename;
     uint          ID;
@@ -49,37 +54,40 @@ struct LogDownloadData {
     size_t        rate_bytes;
     qreal         rate_avg;
     QElapsedTimer elapsed;
+    QElapsedTimer total;
 
-    void advanceChunk()
+    // The number of MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN bins in the file
+    uint32_t numBins() const
     {
-           current_chunk++;
-           chunk_table = QBitArray(chunkBins(), false);
+        return qCeil(entry->size() / static_cast<qreal>(MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN));
     }
 
-    // The number of MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN bins in the current chunk
-    uint32_t chunkBins() const
+    // Moves first_missing past the bins which have been received
+    void advanceFirstMissing()
     {
-        return qMin(qCeil((entry->size() - current_chunk*kChunkSize)/static_cast<qreal>(MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN)),
-                    kTableBins);
-    }
-
-    // The number of kChunkSize chunks in the file
-    uint32_t numChunks() const
-    {
-        return qCeil(entry->size() / static_cast<qreal>(kChunkSize));
+        while (first_missing < static_cast<uint32_t>(bins.size()) && bins.testBit(first_missing)) {
+            first_missing++;
+        }
     }
 
-    // True if all bins in the chunk have been set to val
-    bool chunkEquals(const bool val) const
+    // Size requests so each one keeps the link busy for about kRequestMilliseconds at the measured rate. Short
+    // requests waste a round trip each, long ones leave gaps from lost packets unrepaired for longer.
+    void updateRequestBins()
     {
-        return chunk_table == QBitArray(chunk_table.size(), val);
+        if (rate_avg > 0) {
+            uint32_t rateBins = static_cast<uint32_t>((rate_avg * kRequestMilliseconds) / (1000.0 * MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN));
+            request_bins = qBound(static_cast<uint32_t>(kMinRequestBins), rateBins, static_cast<uint32_t>(kMaxRequestBins));
+        }
     }
-
 };
 
 //----------------------------------------------------------------------------------------
 LogDownloadData::LogDownloadData(QGCLogEntry* entry_)
-    : ID(entry_->id())
+    : bins_received(0)
+    , first_missing(0)
+    , request_end(0)
+    , request_bins(kTableBins)
+    , ID(entry_->id())
     , entry(entry_)
     , written(0)
     , rate_bytes(0)
@@ -316,87 +324,64 @@ LogDownloadController::_logData(UASInterface* uas, uint32_t ofs, uint16_t id, ui
         return;
     }
 
-    bool result = false;
-    uint32_t timeout_time = kTimeOutMilliseconds;
-    if(ofs <= _downloadData->entry->size()) {
-        const uint32_t chunk = ofs / kChunkSize;
-        if (chunk != _downloadData->current_chunk) {
-            qWarning() << "Ignored packet for out of order chunk actual:expected" << chunk << _downloadData->current_chunk;
-            return;
-        }
-        const uint16_t bin = (ofs - chunk*kChunkSize) / MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
-        if (bin >= _downloadData->chunk_table.size()) {
-            qWarning() << "Out of range bin received";
-        } else
-            _downloadData->chunk_table.setBit(bin);
-        if (_downloadData->file.pos() != ofs) {
-            // Seek to correct position
-            if (!_downloadData->file.seek(ofs)) {
-                qWarning() << "Error while seeking log file offset";
-                return;
-            }
-        }
-
-        //-- Write chunk to file
-        if(_downloadData->file.write((const char*)data, count)) {
-            _downloadData->written += count;
-            _downloadData->rate_bytes += count;
-            if (_downloadData->elapsed.elapsed() >= kGUIRateMilliseconds) {
-                //-- Update download rate
-                qreal rrate = _downloadData->rate_bytes/(_downloadData->elapsed.elapsed()/1000.0);
-                _downloadData->rate_avg = _downloadData->rate_avg*0.95 + rrate*0.05;
-                _downloadData->rate_bytes = 0;
-
-                //-- Update status
-                const QString status = QString("%1 (%2/s)").arg(QGCMapEngine::bigSizeToString(_downloadData->written),
-                                                                QGCMapEngine::bigSizeToString(_downloadData->rate_avg));
-
-                _downloadData->entry->setStatus(status);
-                _downloadData->elapsed.start();
-            }
-            result = true;
-            //-- reset retries
-            _retries = 0;
-            //-- Reset timer
-            _timer.start(timeout_time);
-            //-- Do we have it all?
-            if(_logComplete()) {
-                _downloadData->entry->setStatus(QString(tr("Downloaded")));
-                //-- Check for more
-                _receivedAllData();
-            } else if (_chunkComplete()) {
-                _downloadData->advanceChunk();
-                _requestLogData(_downloadData->ID,
-                                _downloadData->current_chunk*kChunkSize,
-                                _downloadData->chunk_table.size()*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
-            } else if (bin < _downloadData->chunk_table.size() - 1 && _downloadData->chunk_table.at(bin+1)) {
-                // Likely to be grabbing fragments and got to the end of a gap
-                _findMissingData();
-            }
-        } else {
-            qWarning() << "Error while writing log file chunk";
-        }
-    } else {
+    //-- Data is accepted anywhere in the log, not just in the outstanding request. Late packets from an earlier
+    //   request fill gaps just as well.
+    const uint32_t bin = ofs / MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
+    if(bin >= static_cast<uint32_t>(_downloadData->bins.size())) {
         qWarning() << "Received log offset greater than expected";
-    }
-    if(!result) {
         _downloadData->entry->setStatus(QString(tr("Error")));
+        return;
     }
-}
 
+    if(!_downloadData->bins.testBit(bin)) {
+        //-- Write bin to its place in the preallocated file
+        if(!_downloadData->file.seek(ofs) || _downloadData->file.write((const char*)data, count) != count) {
+            qWarning() << "Error while writing log file chunk";
+            _downloadData->entry->setStatus(QString(tr("Error")));
+            return;
+        }
+        _downloadData->bins.setBit(bin);
+        _downloadData->bins_received++;
+        _downloadData->written += count;
+        _downloadData->rate_bytes += count;
+        if (_downloadData->elapsed.elapsed() >= kGUIRateMilliseconds) {
+            //-- Update download rate
+            qreal rrate = _downloadData->rate_bytes/(_downloadData->elapsed.elapsed()/1000.0);
+            _downloadData->rate_avg = _downloadData->rate_avg*0.95 + rrate*0.05;
+            _downloadData->rate_bytes = 0;
+
+            //-- Update status
+            const QString status = QString("%1 (%2/s)").arg(QGCMapEngine::bigSizeToString(_downloadData->written),
+                                                            QGCMapEngine::bigSizeToString(_downloadData->rate_avg));
+
+            _downloadData->entry->setStatus(status);
+            _downloadData->elapsed.start();
+        }
+    }
 
-//----------------------------------------------------------------------------------------
-bool
-LogDownloadController::_chunkComplete() const
-{
-    return _downloadData->chunkEquals(true);
+    //-- reset retries
+    _retries = 0;
+    //-- Reset timer
+    _timer.start(kTimeOutMilliseconds);
+    //-- Do we have it all?
+    if(_logComplete()) {
+        qCDebug(LogDownloadLog) << "Log downloaded (id:" << _downloadData->ID << "bytes:" << _downloadData->written
+                                << "msecs:" << _downloadData->total.elapsed() << ")";
+        _downloadData->entry->setStatus(QString(tr("Downloaded")));
+        //-- Check for more
+        _receivedAllData();
+    } else if (bin + 1 == _downloadData->request_end) {
+        //-- The vehicle got to the end of the request, ask for what is still missing
+        _downloadData->updateRequestBins();
+        _requestMissingBins();
+    }
 }
 
 //----------------------------------------------------------------------------------------
 bool
 LogDownloadController::_logComplete() const
 {
-    return _chunkComplete() && (_downloadData->current_chunk+1) == _downloadData->numChunks();
+    return _downloadData->bins_received == static_cast<uint32_t>(_downloadData->bins.size());
 }
 
 //----------------------------------------------------------------------------------------
@@ -407,7 +392,7 @@ LogDownloadController::_receivedAllData()
     //-- Anything queued up for download?
     if(_prepareLogDownload()) {
         //-- Request Log
-        _requestLogData(_downloadData->ID, 0, _downloadData->chunk_table.size()*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
+        _requestMissingBins();
         _timer.start(kTimeOutMilliseconds);
     } else {
         _resetSelection();
@@ -422,8 +407,6 @@ LogDownloadController::_findMissingData()
     if (_logComplete()) {
          _receivedAllData();
          return;
-    } else if (_chunkComplete()) {
-        _downloadData->advanceChunk();
     }
 
     if(_retries++ > 2) {
@@ -434,23 +417,28 @@ LogDownloadController::_findMissingData()
         return;
     }
 
-    uint16_t start = 0, end = 0;
-    const int size = _downloadData->chunk_table.size();
-    for (; start < size; start++) {
-        if (!_downloadData->chunk_table.testBit(start)) {
-            break;
-        }
-    }
+    //-- The link stalled, back off to shorter requests
+    _downloadData->request_bins = qMax(_downloadData->request_bins / 2, static_cast<uint32_t>(kMinRequestBins));
+    _requestMissingBins();
+}
 
-    for (end = start; end < size; end++) {
-        if (_downloadData->chunk_table.testBit(end)) {
-            break;
-        }
+//----------------------------------------------------------------------------------------
+/// Requests the first run of missing bins, up to request_bins of them. On the first pass this streams the log in
+/// request_bins sized pieces, after that it fills the gaps left by lost packets.
+void
+LogDownloadController::_requestMissingBins()
+{
+    _downloadData->advanceFirstMissing();
+
+    const uint32_t size = _downloadData->bins.size();
+    const uint32_t start = _downloadData->first_missing;
+    uint32_t end = start;
+    while (end < size && end - start < _downloadData->request_bins && !_downloadData->bins.testBit(end)) {
+        end++;
     }
 
-    const uint32_t pos = _downloadData->current_chunk*kChunkSize + start*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN,
-                   len = (end - start)*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN;
-    _requestLogData(_downloadData->ID, pos, len);
+    _downloadData->request_end = end;
+    _requestLogData(_downloadData->ID, start*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN, (end - start)*MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
 }
 
 //----------------------------------------------------------------------------------------
@@ -626,9 +614,9 @@ LogDownloadController::_prepareLogDownload()
         if(!_downloadData->file.resize(entry->size())) {
             qWarning() << "Failed to allocate space for log file:" <<  _downloadData->filename;
         } else {
-            _downloadData->current_chunk = 0;
-            _downloadData->chunk_table = QBitArray(_downloadData->chunkBins(), false);
+            _downloadData->bins = QBitArray(_downloadData->numBins(), false);
             _downloadData->elapsed.start();
+            _downloadData->total.start();
             result = true;
         }
     }
@@ -12,55 +12,113 @@
 #include "MockLink.h"
 
 #include <QDir>
+#include <QElapsedTimer>
 
 LogDownloadTest::LogDownloadTest(void)
 {
 
 }
 
-void LogDownloadTest::downloadTest(void)
+/// Lists the logs and downloads the first one to the current directory
+///     @return Download time in msecs, -1 for failure
+qint64 LogDownloadTest::_downloadFirstLog(LogDownloadController* controller, int timeoutMsecs)
 {
-
-    _connectMockLink(MAV_AUTOPILOT_PX4);
-
-    LogDownloadController* controller = new LogDownloadController();
-
     _rgLogDownloadControllerSignals[requestingListChangedSignalIndex] =     SIGNAL(requestingListChanged());
     _rgLogDownloadControllerSignals[downloadingLogsChangedSignalIndex] =    SIGNAL(downloadingLogsChanged());
     _rgLogDownloadControllerSignals[modelChangedSignalIndex] =              SIGNAL(modelChanged());
 
-    _multiSpyLogDownloadController = new MultiSignalSpy();
-    QVERIFY(_multiSpyLogDownloadController->init(controller, _rgLogDownloadControllerSignals, _cLogDownloadControllerSignals));
+    MultiSignalSpy multiSpyLogDownloadController;
+    if (!multiSpyLogDownloadController.init(controller, _rgLogDownloadControllerSignals, _cLogDownloadControllerSignals)) {
+        return -1;
+    }
 
     controller->refresh();
-    QVERIFY(_multiSpyLogDownloadController->waitForSignalByIndex(requestingListChangedSignalIndex, 10000));
-    _multiSpyLogDownloadController->clearAllSignals();
+    if (!multiSpyLogDownloadController.waitForSignalByIndex(requestingListChangedSignalIndex, 10000)) {
+        return -1;
+    }
+    multiSpyLogDownloadController.clearAllSignals();
     if (controller->requestingList()) {
-        QVERIFY(_multiSpyLogDownloadController->waitForSignalByIndex(requestingListChangedSignalIndex, 10000));
-        QCOMPARE(controller->requestingList(), false);
+        if (!multiSpyLogDownloadController.waitForSignalByIndex(requestingListChangedSignalIndex, 10000) || controller->requestingList()) {
+            return -1;
+        }
     }
-    _multiSpyLogDownloadController->clearAllSignals();
+    multiSpyLogDownloadController.clearAllSignals();
 
     QGCLogModel* model = controller->model();
-    QVERIFY(model);
-    qDebug() << model->count();
+    if (!model || model->count() == 0) {
+        return -1;
+    }
     (*model)[0]->setSelected(true);
 
     QString downloadTo = QDir::currentPath();
-    qDebug() << "download to:" << downloadTo;
+    qCDebug(LogDownloadLog) << "download to:" << downloadTo;
+
+    QElapsedTimer downloadTimer;
+    downloadTimer.start();
     controller->downloadToDirectory(downloadTo);
-    QVERIFY(_multiSpyLogDownloadController->waitForSignalByIndex(downloadingLogsChangedSignalIndex, 10000));
-    _multiSpyLogDownloadController->clearAllSignals();
+    if (!multiSpyLogDownloadController.waitForSignalByIndex(downloadingLogsChangedSignalIndex, timeoutMsecs)) {
+        return -1;
+    }
+    multiSpyLogDownloadController.clearAllSignals();
     if (controller->downloadingLogs()) {
-        QVERIFY(_multiSpyLogDownloadController->waitForSignalByIndex(downloadingLogsChangedSignalIndex, 10000));
-        QCOMPARE(controller->downloadingLogs(), false);
+        if (!multiSpyLogDownloadController.waitForSignalByIndex(downloadingLogsChangedSignalIndex, timeoutMsecs) || controller->downloadingLogs()) {
+            return -1;
+        }
     }
-    _multiSpyLogDownloadController->clearAllSignals();
 
-    QString downloadFile = QDir(downloadTo).filePath("log_0_UnknownDate.ulg");
+    return downloadTimer.elapsed();
+}
+
+void LogDownloadTest::downloadTest(void)
+{
+    _connectMockLink(MAV_AUTOPILOT_PX4);
+
+    LogDownloadController* controller = new LogDownloadController();
+
+    QVERIFY(_downloadFirstLog(controller, 10000) >= 0);
+
+    QString downloadFile = QDir(QDir::currentPath()).filePath("log_0_UnknownDate.ulg");
     QVERIFY(UnitTest::fileCompare(downloadFile, _mockLink->logDownloadFile()));
 
     QFile::remove(downloadFile);
 
     delete controller;
 }
+
+/// Downloads a simulated log with lost packets and verifies the downloaded file
+///     @param msecs Returned download time
+void LogDownloadTest::_lossyDownload(uint32_t fileSize, int timeoutMsecs, qint64& msecs)
+{
+    _connectMockLink(MAV_AUTOPILOT_PX4);
+
+    // About 450 KB/s with 5% of the packets lost
+    _mockLink->setLogDownloadSimulation(fileSize, 10, 5);
+
+    LogDownloadController* controller = new LogDownloadController();
+
+    msecs = _downloadFirstLog(controller, timeoutMsecs);
+    delete controller;
+    QVERIFY(msecs > 0);
+
+    QString downloadFile = QDir(QDir::currentPath()).filePath("log_0_UnknownDate.ulg");
+    QVERIFY(UnitTest::fileCompare(downloadFile, _mockLink->logDownloadFile()));
+
+    QFile::remove(downloadFile);
+}
+
+void LogDownloadTest::downloadLossTest(void)
+{
+    // Lost packets must be requested again until the log is complete
+    qint64 msecs;
+    _lossyDownload(256 * 1024, 10000, msecs);
+}
+
+void LogDownloadTest::downloadBenchmark(void)
+{
+    UT_BENCHMARK();
+
+    const uint32_t fileSize = 2 * 1024 * 1024;
+    qint64 msecs;
+    _lossyDownload(fileSize, 60000, msecs);
+    qCDebug(LogDownloadLog) << "Log download benchmark: bytes" << fileSize << "msecs" << msecs << "MB/s" << (fileSize / (1024.0 * 1024.0)) / (msecs / 1000.0);
+}
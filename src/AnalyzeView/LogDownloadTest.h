@@ -13,6 +13,8 @@
 #include "UnitTest.h"
 #include "MultiSignalSpy.h"
 
+class LogDownloadController;
+
 class LogDownloadTest : public UnitTest
 {
     Q_OBJECT
@@ -25,8 +27,13 @@ private slots:
     //void cleanup(void) { _cleanup(); }
 
     void downloadTest(void);
+    void downloadLossTest(void);
+    void downloadBenchmark(void);
 
 private:
+    qint64 _downloadFirstLog(LogDownloadController* controller, int timeoutMsecs);
+    void _lossyDownload(uint32_t fileSize, int timeoutMsecs, qint64& msecs);
+
     // LogDownloadController signals
 
     enum {
@@ -42,7 +49,6 @@ private:
         modelChangedSignalIndexMask =       1 << modelChangedSignalIndex,
     };
 
-    MultiSignalSpy*     _multiSpyLogDownloadController;
     static const size_t _cLogDownloadControllerSignals = logDownloadControllerMaxSignalIndex;
     const char*         _rgLogDownloadControllerSignals[_cLogDownloadControllerSignals];
 
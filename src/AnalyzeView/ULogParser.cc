@@ -86,31 +86,55 @@ bool ULogParser::parseFieldFormat(QString& fields)
     return false;
 }
 
-bool ULogParser::getTagsFromLog(QByteArray& log, QList<GeoTagWorker::cameraFeedbackPacket>& cameraFeedback, QString& errorMessage)
+/// Makes sure at least requiredBytes are available in buffer from index on, reading another block from the log if needed
+/// @return false: end of log
+bool ULogParser::_fillBuffer(QIODevice& log, QByteArray& buffer, int& index, int requiredBytes)
+{
+    if (buffer.size() - index >= requiredBytes) {
+        return true;
+    }
+
+    buffer.remove(0, index);
+    index = 0;
+    buffer.append(log.read(qMax(_readBlockSize, requiredBytes - buffer.size())));
+
+    return buffer.size() >= requiredBytes;
+}
+
+bool ULogParser::getTagsFromLog(QIODevice& log, QList<GeoTagWorker::cameraFeedbackPacket>& cameraFeedback, QString& errorMessage)
 {
     errorMessage.clear();
 
+    QByteArray buffer;
+    int index = 0;
+
     //verify it's an ULog file
-    if(!log.contains(_ULogMagic)) {
+    if(!_fillBuffer(log, buffer, index, ULOG_FILE_HEADER_LEN) || !buffer.startsWith(_ULogMagic)) {
         errorMessage = tr("Could not detect ULog file header magic");
         return false;
     }
 
-    int index = ULOG_FILE_HEADER_LEN;
+    index = ULOG_FILE_HEADER_LEN;
     bool geotagFound = false;
 
-    while(index < log.count() - 1) {
+    while(_fillBuffer(log, buffer, index, ULOG_MSG_HEADER_LEN)) {
 
         ULogMessageHeader header;
         memset(&header, 0, sizeof(header));
-        memcpy(&header, log.data() + index, ULOG_MSG_HEADER_LEN);
+        memcpy(&header, buffer.constData() + index, ULOG_MSG_HEADER_LEN);
+
+        if (!_fillBuffer(log, buffer, index, ULOG_MSG_HEADER_LEN + header.msgSize)) {
+            // Truncated message at the end of the log
+            break;
+        }
+        const char* msg = buffer.constData() + index;
 
         switch (header.msgType) {
             case (int)ULogMessageType::FORMAT:
             {
                 ULogMessageFormat format_msg;
                 memset(&format_msg, 0, sizeof(format_msg));
-                memcpy(&format_msg, log.data() + index, ULOG_MSG_HEADER_LEN + header.msgSize);
+                memcpy(&format_msg, msg, qMin(static_cast<size_t>(ULOG_MSG_HEADER_LEN + header.msgSize), sizeof(format_msg) - 1));
 
                 QString fmt(format_msg.format);
                 int posSeparator = fmt.indexOf(':');
@@ -127,7 +151,7 @@ bool ULogParser::getTagsFromLog(QByteArray& log, QList<GeoTagWorker::cameraFeedb
             {
                 ULogMessageAddLogged addLoggedMsg;
                 memset(&addLoggedMsg, 0, sizeof(addLoggedMsg));
-                memcpy(&addLoggedMsg, log.data() + index, ULOG_MSG_HEADER_LEN + header.msgSize);
+                memcpy(&addLoggedMsg, msg, qMin(static_cast<size_t>(ULOG_MSG_HEADER_LEN + header.msgSize), sizeof(addLoggedMsg) - 1));
 
                 QString messageName(addLoggedMsg.msgName);
 
@@ -142,24 +166,24 @@ bool ULogParser::getTagsFromLog(QByteArray& log, QList<GeoTagWorker::cameraFeedb
             case (int)ULogMessageType::DATA:
             {
                 uint16_t msgID = -1;
-                memcpy(&msgID, log.data() + index + ULOG_MSG_HEADER_LEN, 2);
+                memcpy(&msgID, msg + ULOG_MSG_HEADER_LEN, 2);
 
                 if (geotagFound && msgID == _cameraCaptureMsgID) {
 
                     // Completely dynamic parsing, so that changing/reordering the message format will not break the parser
                     GeoTagWorker::cameraFeedbackPacket feedback;
                     memset(&feedback, 0, sizeof(feedback));
-                    memcpy(&feedback.timestamp, log.data() + index + 5 + _cameraCaptureOffsets.value(QStringLiteral("timestamp")), 8);
+                    memcpy(&feedback.timestamp, msg + 5 + _cameraCaptureOffsets.value(QStringLiteral("timestamp")), 8);
                     feedback.timestamp /= 1.0e6; // to seconds
-                    memcpy(&feedback.timestampUTC, log.data() + index + 5 + _cameraCaptureOffsets.value(QStringLiteral("timestamp_utc")), 8);
+                    memcpy(&feedback.timestampUTC, msg + 5 + _cameraCaptureOffsets.value(QStringLiteral("timestamp_utc")), 8);
                     feedback.timestampUTC /= 1.0e6; // to seconds
-                    memcpy(&feedback.imageSequence, log.data() + index + 5 + _cameraCaptureOffsets.value(QStringLiteral("seq")), 4);
-                    memcpy(&feedback.latitude, log.data() + index + 5 + _cameraCaptureOffsets.value(QStringLiteral("lat")), 8);
-                    memcpy(&feedback.longitude, log.data() + index + 5 + _cameraCaptureOffsets.value(QStringLiteral("lon")), 8);
+                    memcpy(&feedback.imageSequence, msg + 5 + _cameraCaptureOffsets.value(QStringLiteral("seq")), 4);
+                    memcpy(&feedback.latitude, msg + 5 + _cameraCaptureOffsets.value(QStringLiteral("lat")), 8);
+                    memcpy(&feedback.longitude, msg + 5 + _cameraCaptureOffsets.value(QStringLiteral("lon")), 8);
                     feedback.longitude = fmod(180.0 + feedback.longitude, 360.0) - 180.0;
-                    memcpy(&feedback.altitude, log.data() + index + 5 + _cameraCaptureOffsets.value(QStringLiteral("alt")), 4);
-                    memcpy(&feedback.groundDistance, log.data() + index + 5 + _cameraCaptureOffsets.value(QStringLiteral("ground_distance")), 4);
-                    memcpy(&feedback.captureResult, log.data() + index + 5 + _cameraCaptureOffsets.value(QStringLiteral("result")), 1);
+                    memcpy(&feedback.altitude, msg + 5 + _cameraCaptureOffsets.value(QStringLiteral("alt")), 4);
+                    memcpy(&feedback.groundDistance, msg + 5 + _cameraCaptureOffsets.value(QStringLiteral("ground_distance")), 4);
+                    memcpy(&feedback.captureResult, msg + 5 + _cameraCaptureOffsets.value(QStringLiteral("result")), 1);
 
                     cameraFeedback.append(feedback);
 
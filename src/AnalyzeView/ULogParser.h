@@ -4,6 +4,7 @@
 #include <QGeoCoordinate>
 #include <QDebug>
 #include <QCoreApplication>
+#include <QIODevice>
 
 #include "GeoTagController.h"
 
@@ -17,8 +18,9 @@ public:
     ULogParser();
     ~ULogParser();
 
-    /// @return true: failed, errorMessage set
-    bool getTagsFromLog(QByteArray& log, QList<GeoTagWorker::cameraFeedbackPacket>& cameraFeedback, QString& errorMessage);
+    /// Reads the log sequentially in blocks, so memory use does not depend on the log size.
+    /// @return false: failed, errorMessage set
+    bool getTagsFromLog(QIODevice& log, QList<GeoTagWorker::cameraFeedbackPacket>& cameraFeedback, QString& errorMessage);
 
 private:
 
@@ -27,9 +29,12 @@ private:
 
     const char _ULogMagic[8] = {'U', 'L', 'o', 'g', 0x01, 0x12, 0x35};
 
+    static const int _readBlockSize = 1024 * 1024;
+
     int sizeOfType(QString& typeName);
     int sizeOfFullType(QString &typeNameFull);
     QString extractArraySize(QString& typeNameFull, int& arraySize);
+    bool _fillBuffer(QIODevice& log, QByteArray& buffer, int& index, int requiredBytes);
 
     bool parseFieldFormat(QString& fields);
 
@@ -67,6 +72,7 @@ private:
 	  char msgName[255];
 	};
 
+    friend class GeoTagParserTest;
 };
 
 #endif // ULOGPARSER_H
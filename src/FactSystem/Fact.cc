@@ -8,6 +8,8 @@
  ****************************************************************************/
 
 #include "Fact.h"
+#include "FactGroup.h"
+#include "FactUpdateScheduler.h"
 #include "FactValueSliderListModel.h"
 #include "QGCMAVLink.h"
 #include "QGCApplication.h"
@@ -26,6 +28,7 @@ Fact::Fact(QObject* parent)
     , _metaData                 (NULL)
     , _sendValueChangedSignals  (true)
     , _deferredValueChangeSignal(false)
+    , _updateGroup              (NULL)
     , _valueSliderModel         (NULL)
 {    
     FactMetaData* metaData = new FactMetaData(_type, this);
@@ -44,6 +47,7 @@ Fact::Fact(int componentId, QString name, FactMetaData::ValueType_t type, QObjec
     , _metaData                 (NULL)
     , _sendValueChangedSignals  (true)
     , _deferredValueChangeSignal(false)
+    , _updateGroup              (NULL)
     , _valueSliderModel         (NULL)
 {
     FactMetaData* metaData = new FactMetaData(_type, this);
@@ -60,6 +64,7 @@ Fact::Fact(const QString& settingsGroup, FactMetaData* metaData, QObject* parent
     , _metaData                 (NULL)
     , _sendValueChangedSignals  (true)
     , _deferredValueChangeSignal(false)
+    , _updateGroup              (NULL)
     , _valueSliderModel         (NULL)
 {
     qgcApp()->toolbox()->corePlugin()->adjustSettingMetaData(settingsGroup, *metaData);
@@ -67,7 +72,8 @@ Fact::Fact(const QString& settingsGroup, FactMetaData* metaData, QObject* parent
 }
 
 Fact::Fact(const Fact& other, QObject* parent)
-    : QObject(parent)
+    : QObject       (parent)
+    , _updateGroup  (NULL)
 {
     *this = other;
     QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
@@ -99,7 +105,7 @@ void Fact::forceSetRawValue(const QVariant& value)
         
         if (_metaData->convertAndValidateRaw(value, true /* convertOnly */, typedValue, errorString)) {
             _rawValue.setValue(typedValue);
-            _sendValueChangedSignal(cookedValue());
+            _sendValueChangedSignal();
             //-- Must be in this order
             emit _containerRawValueChanged(rawValue());
             emit rawValueChanged(_rawValue);
@@ -118,7 +124,7 @@ void Fact::setRawValue(const QVariant& value)
         if (_metaData->convertAndValidateRaw(value, true /* convertOnly */, typedValue, errorString)) {
             if (typedValue != _rawValue) {
                 _rawValue.setValue(typedValue);
-                _sendValueChangedSignal(cookedValue());
+                _sendValueChangedSignal();
                 //-- Must be in this order
                 emit _containerRawValueChanged(rawValue());
                 emit rawValueChanged(_rawValue);
@@ -163,7 +169,7 @@ void Fact::_containerSetRawValue(const QVariant& value)
 {
     if(_rawValue != value) {
         _rawValue = value;
-        _sendValueChangedSignal(cookedValue());
+        _sendValueChangedSignal();
         emit rawValueChanged(_rawValue);
     }
 
@@ -607,13 +613,21 @@ void Fact::setSendValueChangedSignals (bool sendValueChangedSignals)
     }
 }
 
-void Fact::_sendValueChangedSignal(QVariant value)
+void Fact::_sendValueChangedSignal(void)
 {
     if (_sendValueChangedSignals) {
-        emit valueChanged(value);
+        emit valueChanged(cookedValue());
         _deferredValueChangeSignal = false;
+    } else if (_deferredValueChangeSignal) {
+        // Previous change hasn't been published yet, it will be replaced by this one
+        if (_updateGroup) {
+            FactUpdateScheduler::instance()->updateSuppressed();
+        }
     } else {
         _deferredValueChangeSignal = true;
+        if (_updateGroup) {
+            _updateGroup->_factDirty(this);
+        }
     }
 }
 
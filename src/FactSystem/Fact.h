@@ -23,6 +23,7 @@
 #include <QAbstractListModel>
 
 class FactValueSliderListModel;
+class FactGroup;
 
 /// @brief A Fact is used to hold a single value within the system.
 class Fact : public QObject
@@ -146,6 +147,9 @@ public:
     void clearDeferredValueChangeSignal(void) { _deferredValueChangeSignal = false; }
     void sendDeferredValueChangedSignal(void);
 
+    /// Sets the group which publishes the deferred valueChanged signals for this Fact. Called by FactGroup.
+    void _setUpdateGroup(FactGroup* group) { _updateGroup = group; }
+
     // C++ methods
 
     /// Sets and sends new value to vehicle even if value is the same
@@ -189,7 +193,7 @@ signals:
     
 protected:
     QString _variantToString(const QVariant& variant, int decimalPlaces) const;
-    void _sendValueChangedSignal(QVariant value);
+    void _sendValueChangedSignal(void);
 
     QString                     _name;
     int                         _componentId;
@@ -198,6 +202,7 @@ protected:
     FactMetaData*               _metaData;
     bool                        _sendValueChangedSignals;
     bool                        _deferredValueChangeSignal;
+    FactGroup*                  _updateGroup;
     FactValueSliderListModel*   _valueSliderModel;
 };
 
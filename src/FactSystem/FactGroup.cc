@@ -10,6 +10,7 @@
 
 #include "FactGroup.h"
 #include "JsonHelper.h"
+#include "FactUpdateScheduler.h"
 
 #include <QJsonDocument>
 #include <QJsonParseError>
@@ -21,18 +22,24 @@
 QGC_LOGGING_CATEGORY(FactGroupLog, "FactGroupLog")
 
 FactGroup::FactGroup(int updateRateMsecs, const QString& metaDataFile, QObject* parent)
-    : QObject(parent)
-    , _updateRateMSecs(updateRateMsecs)
+    : QObject           (parent)
+    , _updateRateMSecs  (updateRateMsecs)
+    , _lastPublishMSecs (-1)
 {
-    _setupTimer();
     _nameToFactMetaDataMap = FactMetaData::createMapFromJsonFile(metaDataFile, this);
 }
 
 FactGroup::FactGroup(int updateRateMsecs, QObject* parent)
-    : QObject(parent)
-    , _updateRateMSecs(updateRateMsecs)
+    : QObject           (parent)
+    , _updateRateMSecs  (updateRateMsecs)
+    , _lastPublishMSecs (-1)
 {
-    _setupTimer();
+
+}
+
+FactGroup::~FactGroup()
+{
+    FactUpdateScheduler::instance()->removeGroup(this);
 }
 
 void FactGroup::_loadFromJsonArray(const QJsonArray jsonArray)
@@ -40,12 +47,19 @@ void FactGroup::_loadFromJsonArray(const QJsonArray jsonArray)
     _nameToFactMetaDataMap = FactMetaData::createMapFromJsonArray(jsonArray, this);
 }
 
-void FactGroup::_setupTimer()
+void FactGroup::setUpdateRateMSecs(int updateRateMsecs)
 {
-    if (_updateRateMSecs > 0) {
-        connect(&_updateTimer, &QTimer::timeout, this, &FactGroup::_updateAllValues);
-        _updateTimer.setSingleShot(false);
-        _updateTimer.start(_updateRateMSecs);
+    _updateRateMSecs = updateRateMsecs;
+    foreach(Fact* fact, _nameToFactMap) {
+        fact->setSendValueChangedSignals(_updateRateMSecs == 0);
+        fact->_setUpdateGroup(_updateRateMSecs == 0 ? NULL : this);
+        if (_updateRateMSecs == 0) {
+            fact->sendDeferredValueChangedSignal();
+        }
+    }
+    if (_updateRateMSecs == 0) {
+        _dirtyFacts.clear();
+        FactUpdateScheduler::instance()->removeGroup(this);
     }
 }
 
@@ -101,6 +115,7 @@ void FactGroup::_addFact(Fact* fact, const QString& name)
     }
 
     fact->setSendValueChangedSignals(_updateRateMSecs == 0);
+    fact->_setUpdateGroup(_updateRateMSecs == 0 ? NULL : this);
     if (_nameToFactMetaDataMap.contains(name)) {
         fact->setMetaData(_nameToFactMetaDataMap[name]);
     }
@@ -118,9 +133,38 @@ void FactGroup::_addFactGroup(FactGroup* factGroup, const QString& name)
     _nameToFactGroupMap[name] = factGroup;
 }
 
-void FactGroup::_updateAllValues(void)
+void FactGroup::_factDirty(Fact* fact)
 {
-    foreach(Fact* fact, _nameToFactMap) {
-        fact->sendDeferredValueChangedSignal();
+    _dirtyFacts.append(fact);
+    if (_dirtyFacts.count() == 1) {
+        FactUpdateScheduler::instance()->groupDirty(this);
+    }
+}
+
+qint64 FactGroup::_nextPublishMSecs(void) const
+{
+    return _lastPublishMSecs < 0 ? 0 : _lastPublishMSecs + _updateRateMSecs;
+}
+
+void FactGroup::_publishDirtyFacts(qint64 nowMSecs)
+{
+    FactUpdateScheduler* scheduler = FactUpdateScheduler::instance();
+
+    _lastPublishMSecs = nowMSecs;
+
+    // A valueChanged handler may change Facts again, those go to the next publish
+    QVector<Fact*> dirtyFacts;
+    dirtyFacts.swap(_dirtyFacts);
+    foreach(Fact* fact, dirtyFacts) {
+        if (fact->deferredValueChangeSignal()) {
+            fact->sendDeferredValueChangedSignal();
+            scheduler->updatePublished();
+        }
+    }
+
+    // Hand the allocation back to avoid reallocating on every publish
+    if (_dirtyFacts.isEmpty()) {
+        dirtyFacts.resize(0);
+        _dirtyFacts.swap(dirtyFacts);
     }
 }
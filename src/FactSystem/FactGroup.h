@@ -16,7 +16,7 @@
 
 #include <QStringList>
 #include <QMap>
-#include <QTimer>
+#include <QVector>
 
 Q_DECLARE_LOGGING_CATEGORY(VehicleLog)
 
@@ -28,6 +28,7 @@ class FactGroup : public QObject
 public:
     FactGroup(int updateRateMsecs, const QString& metaDataFile, QObject* parent = NULL);
     FactGroup(int updateRateMsecs, QObject* parent = NULL);
+    ~FactGroup();
 
     Q_PROPERTY(QStringList factNames        READ factNames      CONSTANT)
     Q_PROPERTY(QStringList factGroupNames   READ factGroupNames CONSTANT)
@@ -41,6 +42,14 @@ public:
     QStringList factNames(void) const { return _factNames; }
     QStringList factGroupNames(void) const { return _nameToFactGroupMap.keys(); }
 
+    /// Sets the rate cap for Fact::valueChanged signals. 0: immediate update. Otherwise changes are coalesced and
+    /// published through FactUpdateScheduler no more often than once per UI frame and once per updateRateMsecs.
+    void setUpdateRateMSecs(int updateRateMsecs);
+    int updateRateMSecs(void) const { return _updateRateMSecs; }
+
+    /// Called by a Fact in this group when it has a deferred valueChanged signal to publish
+    void _factDirty(Fact* fact);
+
 protected:
     void _addFact(Fact* fact, const QString& name);
     void _addFactGroup(FactGroup* factGroup, const QString& name);
@@ -48,12 +57,14 @@ protected:
 
     int _updateRateMSecs;   ///< Update rate for Fact::valueChanged signals, 0: immediate update
 
-protected slots:
-    virtual void _updateAllValues(void);
-
 private:
-    void _setupTimer();
-    QTimer _updateTimer;
+    qint64  _nextPublishMSecs   (void) const;
+    void    _publishDirtyFacts  (qint64 nowMSecs);
+
+    QVector<Fact*>  _dirtyFacts;        ///< Facts with deferred valueChanged signals, in order of change
+    qint64          _lastPublishMSecs;  ///< FactUpdateScheduler time of last publish, -1 for never
+
+    friend class FactUpdateScheduler;
 
 protected:
     QMap<QString, Fact*>            _nameToFactMap;
@@ -0,0 +1,109 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "FactUpdateScheduler.h"
+#include "FactGroup.h"
+#include "QGCLoggingCategory.h"
+
+QGC_LOGGING_CATEGORY(FactUpdateSchedulerLog, "FactUpdateSchedulerLog")
+
+FactUpdateScheduler* FactUpdateScheduler::instance(void)
+{
+    static FactUpdateScheduler* scheduler = NULL;
+
+    if (!scheduler) {
+        scheduler = new FactUpdateScheduler();
+    }
+    return scheduler;
+}
+
+FactUpdateScheduler::FactUpdateScheduler(void)
+    : QObject           (NULL)
+    , _publishedCount   (0)
+    , _suppressedCount  (0)
+    , _lastFrameMSecs   (0)
+    , _frameDeadlineMSecs(0)
+    , _lastStatsMSecs   (0)
+{
+    _frameTimer.setSingleShot(true);
+    _frameTimer.setTimerType(Qt::PreciseTimer);
+    connect(&_frameTimer, &QTimer::timeout, this, &FactUpdateScheduler::_publishFrame);
+    _clock.start();
+}
+
+void FactUpdateScheduler::groupDirty(FactGroup* group)
+{
+    if (!_dirtyGroups.contains(group)) {
+        _dirtyGroups.append(group);
+        _scheduleNextFrame();
+    }
+}
+
+void FactUpdateScheduler::removeGroup(FactGroup* group)
+{
+    _dirtyGroups.removeAll(group);
+    _publishingGroups.removeAll(group);
+    if (_dirtyGroups.isEmpty()) {
+        _frameTimer.stop();
+    }
+}
+
+/// Starts the frame timer for the soonest time one of the dirty groups is allowed to publish. Frames are at
+/// least a frame interval apart. A frame which is already due no later is left alone, so groups which become
+/// dirty while waiting for it don't push it back.
+void FactUpdateScheduler::_scheduleNextFrame(void)
+{
+    if (_dirtyGroups.isEmpty()) {
+        _frameTimer.stop();
+        return;
+    }
+
+    qint64 nextPublishMSecs = _dirtyGroups[0]->_nextPublishMSecs();
+    for (int i=1; i<_dirtyGroups.count(); i++) {
+        nextPublishMSecs = qMin(nextPublishMSecs, _dirtyGroups[i]->_nextPublishMSecs());
+    }
+    qint64 deadlineMSecs = qMax(nextPublishMSecs, _lastFrameMSecs + frameIntervalMSecs);
+
+    if (_frameTimer.isActive() && _frameDeadlineMSecs <= deadlineMSecs) {
+        return;
+    }
+    _frameDeadlineMSecs = deadlineMSecs;
+    _frameTimer.start(static_cast<int>(qMax(deadlineMSecs - _clock.elapsed(), static_cast<qint64>(0))));
+}
+
+void FactUpdateScheduler::_publishFrame(void)
+{
+    _publishFrameAt(_clock.elapsed());
+}
+
+void FactUpdateScheduler::_publishFrameAt(qint64 nowMSecs)
+{
+    _frameTimer.stop();
+    _lastFrameMSecs = nowMSecs;
+
+    // Signal handlers may dirty groups again, or delete them, while we are publishing. Groups dirtied during
+    // publishing go back to _dirtyGroups for the next frame.
+    _publishingGroups.swap(_dirtyGroups);
+    while (!_publishingGroups.isEmpty()) {
+        FactGroup* group = _publishingGroups.takeFirst();
+        if (group->_nextPublishMSecs() > nowMSecs) {
+            // Rate cap for group has not expired yet
+            _dirtyGroups.append(group);
+        } else {
+            group->_publishDirtyFacts(nowMSecs);
+        }
+    }
+
+    if (FactUpdateSchedulerLog().isDebugEnabled() && nowMSecs - _lastStatsMSecs > _statsIntervalMSecs) {
+        _lastStatsMSecs = nowMSecs;
+        qCDebug(FactUpdateSchedulerLog) << "published:suppressed" << _publishedCount << _suppressedCount;
+    }
+
+    _scheduleNextFrame();
+}
@@ -0,0 +1,77 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QList>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(FactUpdateSchedulerLog)
+
+class FactGroup;
+
+/// Publishes the deferred valueChanged signals of FactGroup Facts. High rate telemetry can update the same
+/// Fact many times between two UI frames. Instead of signalling the ui on each update, a Fact which changes
+/// marks itself dirty in its FactGroup and the group is queued here. Dirty groups are published once per
+/// frame, at most one valueChanged per Fact, further limited by the group's own update rate cap.
+///
+/// All access must be from the main thread.
+class FactUpdateScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static FactUpdateScheduler* instance(void);
+
+    /// Queues a group with dirty Facts for publishing
+    void groupDirty(FactGroup* group);
+
+    /// Removes a group from the publish queue. Must be called before the group is destroyed.
+    void removeGroup(FactGroup* group);
+
+    /// Called by Fact when it changes again before its previous change was published
+    void updateSuppressed(void) { _suppressedCount++; }
+
+    /// Called by FactGroup for each valueChanged signal published
+    void updatePublished(void) { _publishedCount++; }
+
+    /// @return Number of valueChanged signals published through the scheduler
+    quint64 publishedCount(void) const { return _publishedCount; }
+
+    /// @return Number of Fact updates which were coalesced into a later valueChanged signal
+    quint64 suppressedCount(void) const { return _suppressedCount; }
+
+    static const int frameIntervalMSecs = 16;   ///< Dirty groups are published at most this often
+
+private slots:
+    void _publishFrame(void);
+
+private:
+    FactUpdateScheduler(void);
+
+    void _scheduleNextFrame (void);
+    void _publishFrameAt    (qint64 nowMSecs);
+
+    QList<FactGroup*>   _dirtyGroups;
+    QList<FactGroup*>   _publishingGroups;  ///< Groups still to be published in the current frame
+    QTimer              _frameTimer;
+    QElapsedTimer       _clock;
+    qint64              _lastFrameMSecs;        ///< Clock time of the last published frame
+    qint64              _frameDeadlineMSecs;    ///< Clock time the frame timer is due, valid while it is active
+    quint64             _publishedCount;
+    quint64             _suppressedCount;
+    qint64              _lastStatsMSecs;
+
+    static const qint64 _statsIntervalMSecs = 10000;
+
+    friend class FactUpdateSchedulerTest;
+};
@@ -0,0 +1,119 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "FactUpdateSchedulerTest.h"
+#include "FactUpdateScheduler.h"
+
+#include <QSignalSpy>
+
+FactUpdateSchedulerTestGroup::FactUpdateSchedulerTestGroup(int updateRateMsecs)
+    : FactGroup (updateRateMsecs)
+    , fact      (0, "fact", FactMetaData::valueTypeInt32)
+{
+    _addFact(&fact, "fact");
+}
+
+/// Publishes the pending frame at the time it is due, without waiting for the frame timer
+void FactUpdateSchedulerTest::_publishDueFrame(void)
+{
+    FactUpdateScheduler* scheduler = FactUpdateScheduler::instance();
+
+    QVERIFY(scheduler->_frameTimer.isActive());
+    scheduler->_publishFrameAt(scheduler->_frameDeadlineMSecs);
+}
+
+void FactUpdateSchedulerTest::_coalesce_test(void)
+{
+    FactUpdateScheduler*            scheduler = FactUpdateScheduler::instance();
+    FactUpdateSchedulerTestGroup    group(1);
+    QSignalSpy                      spy(&group.fact, &Fact::valueChanged);
+
+    quint64 suppressedCount = scheduler->suppressedCount();
+    for (int i=1; i<=10; i++) {
+        group.fact.setRawValue(i);
+    }
+
+    // Nothing is signalled until the next frame, then only the last value
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(scheduler->suppressedCount() - suppressedCount, 9ull);
+    _publishDueFrame();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy[0][0].toInt(), 10);
+    QVERIFY(!scheduler->_frameTimer.isActive());
+}
+
+void FactUpdateSchedulerTest::_rateCap_test(void)
+{
+    FactUpdateScheduler*            scheduler = FactUpdateScheduler::instance();
+    const int                       rateMSecs = 500;
+    FactUpdateSchedulerTestGroup    group(rateMSecs);
+    QSignalSpy                      spy(&group.fact, &Fact::valueChanged);
+
+    group.fact.setRawValue(1);
+    qint64 firstPublishMSecs = scheduler->_frameDeadlineMSecs;
+    _publishDueFrame();
+    QCOMPARE(spy.count(), 1);
+
+    // The second change must wait out the group rate
+    group.fact.setRawValue(2);
+    QCOMPARE(scheduler->_frameDeadlineMSecs, firstPublishMSecs + rateMSecs);
+    scheduler->_publishFrameAt(firstPublishMSecs + (rateMSecs / 4));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(scheduler->_frameDeadlineMSecs, firstPublishMSecs + rateMSecs);
+    _publishDueFrame();
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy[1][0].toInt(), 2);
+}
+
+void FactUpdateSchedulerTest::_immediate_test(void)
+{
+    FactUpdateSchedulerTestGroup    group(0);
+    QSignalSpy                      spy(&group.fact, &Fact::valueChanged);
+
+    group.fact.setRawValue(1);
+    group.fact.setRawValue(2);
+    QCOMPARE(spy.count(), 2);
+
+    // Switching to a rate cap coalesces from then on
+    group.setUpdateRateMSecs(1);
+    group.fact.setRawValue(3);
+    group.fact.setRawValue(4);
+    QCOMPARE(spy.count(), 2);
+    _publishDueFrame();
+    QCOMPARE(spy.count(), 3);
+    QCOMPARE(spy[2][0].toInt(), 4);
+}
+
+void FactUpdateSchedulerTest::_frameCadence_test(void)
+{
+    FactUpdateScheduler*            scheduler = FactUpdateScheduler::instance();
+    FactUpdateSchedulerTestGroup    group1(1);
+    FactUpdateSchedulerTestGroup    group2(1);
+    QSignalSpy                      spy1(&group1.fact, &Fact::valueChanged);
+    QSignalSpy                      spy2(&group2.fact, &Fact::valueChanged);
+
+    group1.fact.setRawValue(1);
+    qint64 frameMSecs = scheduler->_frameDeadlineMSecs;
+
+    // A group which becomes dirty while waiting for the frame joins it instead of pushing it back
+    group2.fact.setRawValue(1);
+    QCOMPARE(scheduler->_frameDeadlineMSecs, frameMSecs);
+    _publishDueFrame();
+    QCOMPARE(spy1.count(), 1);
+    QCOMPARE(spy2.count(), 1);
+
+    // Next frame is a frame interval after the last one
+    group1.fact.setRawValue(2);
+    QCOMPARE(scheduler->_frameDeadlineMSecs, frameMSecs + FactUpdateScheduler::frameIntervalMSecs);
+    group2.fact.setRawValue(2);
+    QCOMPARE(scheduler->_frameDeadlineMSecs, frameMSecs + FactUpdateScheduler::frameIntervalMSecs);
+    _publishDueFrame();
+    QCOMPARE(spy1.count(), 2);
+    QCOMPARE(spy2.count(), 2);
+}
@@ -0,0 +1,38 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+#include "FactGroup.h"
+
+/// Unit test for coalesced FactGroup updates through FactUpdateScheduler
+class FactUpdateSchedulerTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _coalesce_test(void);
+    void _rateCap_test(void);
+    void _immediate_test(void);
+    void _frameCadence_test(void);
+
+private:
+    void _publishDueFrame(void);
+};
+
+class FactUpdateSchedulerTestGroup : public FactGroup
+{
+    Q_OBJECT
+
+public:
+    FactUpdateSchedulerTestGroup(int updateRateMsecs);
+
+    Fact fact;
+};
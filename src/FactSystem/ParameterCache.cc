@@ -0,0 +1,342 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterCache.h"
+#include "QGC.h"
+
+#include <QSaveFile>
+#include <QVector>
+#include <QDebug>
+
+#include <algorithm>
+#include <string.h>
+
+ParameterCache::ParameterCache(void)
+    : _header   (NULL)
+    , _records  (NULL)
+{
+
+}
+
+ParameterCache::~ParameterCache()
+{
+    close();
+}
+
+/// Fills in a record from a parameter
+/// @return false: parameter can't be stored in a record
+bool ParameterCache::_toRecord(const Param_t& param, Record_t& record)
+{
+    memset(&record, 0, sizeof(record));
+
+    QByteArray name = param.name.toLatin1();
+    if (name.isEmpty() || name.length() > static_cast<int>(sizeof(record.name))) {
+        return false;
+    }
+    memcpy(record.name, name.constData(), name.length());
+    record.type = static_cast<quint8>(param.type);
+
+    switch (param.type) {
+    case FactMetaData::valueTypeUint8:
+    {
+        quint8 value = static_cast<quint8>(param.value.toUInt());
+        memcpy(record.value.raw, &value, sizeof(value));
+    }
+        break;
+    case FactMetaData::valueTypeInt8:
+    {
+        qint8 value = static_cast<qint8>(param.value.toInt());
+        memcpy(record.value.raw, &value, sizeof(value));
+    }
+        break;
+    case FactMetaData::valueTypeUint16:
+    {
+        quint16 value = static_cast<quint16>(param.value.toUInt());
+        memcpy(record.value.raw, &value, sizeof(value));
+    }
+        break;
+    case FactMetaData::valueTypeInt16:
+    {
+        qint16 value = static_cast<qint16>(param.value.toInt());
+        memcpy(record.value.raw, &value, sizeof(value));
+    }
+        break;
+    case FactMetaData::valueTypeUint32:
+    {
+        quint32 value = param.value.toUInt();
+        memcpy(record.value.raw, &value, sizeof(value));
+    }
+        break;
+    case FactMetaData::valueTypeInt32:
+    {
+        qint32 value = param.value.toInt();
+        memcpy(record.value.raw, &value, sizeof(value));
+    }
+        break;
+    case FactMetaData::valueTypeUint64:
+    {
+        quint64 value = param.value.toULongLong();
+        memcpy(record.value.raw, &value, sizeof(value));
+    }
+        break;
+    case FactMetaData::valueTypeInt64:
+    {
+        qint64 value = param.value.toLongLong();
+        memcpy(record.value.raw, &value, sizeof(value));
+    }
+        break;
+    case FactMetaData::valueTypeFloat:
+    {
+        float value = param.value.toFloat();
+        memcpy(record.value.raw, &value, sizeof(value));
+    }
+        break;
+    case FactMetaData::valueTypeDouble:
+    {
+        double value = param.value.toDouble();
+        memcpy(record.value.raw, &value, sizeof(value));
+    }
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+int ParameterCache::_compareName(const Record_t& record, const QByteArray& name)
+{
+    char paddedName[sizeof(record.name)];
+
+    memset(paddedName, 0, sizeof(paddedName));
+    memcpy(paddedName, name.constData(), qMin(name.length(), static_cast<int>(sizeof(paddedName))));
+    return memcmp(record.name, paddedName, sizeof(paddedName));
+}
+
+/// Adds a record to a running crc. This must match the hash computed by the vehicle: name bytes followed by the value
+/// bytes in the native parameter type.
+quint32 ParameterCache::_crcAccumulate(const Record_t& record, quint32 crc)
+{
+    unsigned nameLength = static_cast<unsigned>(strnlen(record.name, sizeof(record.name)));
+    FactMetaData::ValueType_t type = static_cast<FactMetaData::ValueType_t>(record.type);
+
+    crc = QGC::crc32(reinterpret_cast<const quint8*>(record.name), nameLength, crc);
+    return QGC::crc32(record.value.raw, static_cast<unsigned>(FactMetaData::typeToSize(type)), crc);
+}
+
+quint32 ParameterCache::crc(const QList<Param_t>& params)
+{
+    QList<Param_t> sortedParams = params;
+    std::sort(sortedParams.begin(), sortedParams.end(), [](const Param_t& a, const Param_t& b) { return a.name < b.name; });
+
+    quint32 crc = 0;
+    foreach (const Param_t& param, sortedParams) {
+        Record_t record;
+        if (!param.volatileValue && _toRecord(param, record)) {
+            crc = _crcAccumulate(record, crc);
+        }
+    }
+
+    return crc;
+}
+
+bool ParameterCache::write(const QString& fileName, const QList<Param_t>& params)
+{
+    QList<Param_t> sortedParams = params;
+    std::sort(sortedParams.begin(), sortedParams.end(), [](const Param_t& a, const Param_t& b) { return a.name < b.name; });
+
+    QVector<Record_t> records;
+    records.reserve(sortedParams.count());
+
+    quint32 crc = 0;
+    foreach (const Param_t& param, sortedParams) {
+        Record_t record;
+        if (!_toRecord(param, record)) {
+            qWarning() << "ParameterCache::write unable to cache parameter" << param.name << param.type;
+            continue;
+        }
+        if (!param.volatileValue) {
+            crc = _crcAccumulate(record, crc);
+        }
+        records.append(record);
+    }
+
+    Header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic        = magic;
+    header.version      = version;
+    header.recordSize   = sizeof(Record_t);
+    header.crc          = crc;
+    header.count        = static_cast<quint32>(records.count());
+
+    // Write to a temporary file and rename, a cache which is mapped by someone else is never seen half written
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "ParameterCache::write unable to open" << fileName << file.errorString();
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records.constData()), records.count() * sizeof(Record_t));
+
+    return file.commit();
+}
+
+bool ParameterCache::open(const QString& fileName)
+{
+    close();
+
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    qint64 size = _file.size();
+    if (size < static_cast<qint64>(sizeof(Header_t))) {
+        close();
+        return false;
+    }
+
+    const uchar* data = _file.map(0, size);
+    if (!data) {
+        close();
+        return false;
+    }
+
+    const Header_t* header = reinterpret_cast<const Header_t*>(data);
+    if (header->magic != magic || header->version != version || header->recordSize != sizeof(Record_t) ||
+            size < static_cast<qint64>(sizeof(Header_t) + (static_cast<qint64>(header->count) * sizeof(Record_t)))) {
+        close();
+        return false;
+    }
+
+    _header = header;
+    _records = reinterpret_cast<const Record_t*>(data + sizeof(Header_t));
+
+    return true;
+}
+
+void ParameterCache::close(void)
+{
+    // Unmapping is done by QFile::close
+    _header = NULL;
+    _records = NULL;
+    _file.close();
+}
+
+quint32 ParameterCache::crc(void) const
+{
+    return _header ? _header->crc : 0;
+}
+
+int ParameterCache::count(void) const
+{
+    return _header ? static_cast<int>(_header->count) : 0;
+}
+
+QString ParameterCache::name(int index) const
+{
+    const Record_t& record = _records[index];
+    return QString::fromLatin1(record.name, static_cast<int>(strnlen(record.name, sizeof(record.name))));
+}
+
+FactMetaData::ValueType_t ParameterCache::type(int index) const
+{
+    return static_cast<FactMetaData::ValueType_t>(_records[index].type);
+}
+
+QVariant ParameterCache::value(int index) const
+{
+    const Record_t& record = _records[index];
+
+    switch (record.type) {
+    case FactMetaData::valueTypeUint8:
+    {
+        quint8 value;
+        memcpy(&value, record.value.raw, sizeof(value));
+        return QVariant(static_cast<uint>(value));
+    }
+    case FactMetaData::valueTypeInt8:
+    {
+        qint8 value;
+        memcpy(&value, record.value.raw, sizeof(value));
+        return QVariant(static_cast<int>(value));
+    }
+    case FactMetaData::valueTypeUint16:
+    {
+        quint16 value;
+        memcpy(&value, record.value.raw, sizeof(value));
+        return QVariant(static_cast<uint>(value));
+    }
+    case FactMetaData::valueTypeInt16:
+    {
+        qint16 value;
+        memcpy(&value, record.value.raw, sizeof(value));
+        return QVariant(static_cast<int>(value));
+    }
+    case FactMetaData::valueTypeUint32:
+    {
+        quint32 value;
+        memcpy(&value, record.value.raw, sizeof(value));
+        return QVariant(static_cast<uint>(value));
+    }
+    case FactMetaData::valueTypeInt32:
+    {
+        qint32 value;
+        memcpy(&value, record.value.raw, sizeof(value));
+        return QVariant(static_cast<int>(value));
+    }
+    case FactMetaData::valueTypeUint64:
+    {
+        quint64 value;
+        memcpy(&value, record.value.raw, sizeof(value));
+        return QVariant(static_cast<qulonglong>(value));
+    }
+    case FactMetaData::valueTypeInt64:
+    {
+        qint64 value;
+        memcpy(&value, record.value.raw, sizeof(value));
+        return QVariant(static_cast<qlonglong>(value));
+    }
+    case FactMetaData::valueTypeFloat:
+    {
+        float value;
+        memcpy(&value, record.value.raw, sizeof(value));
+        return QVariant(value);
+    }
+    case FactMetaData::valueTypeDouble:
+    {
+        double value;
+        memcpy(&value, record.value.raw, sizeof(value));
+        return QVariant(value);
+    }
+    default:
+        return QVariant();
+    }
+}
+
+int ParameterCache::indexOf(const QString& name) const
+{
+    QByteArray latin1Name = name.toLatin1();
+    int first = 0;
+    int last = count() - 1;
+
+    while (first <= last) {
+        int middle = first + ((last - first) / 2);
+        int compare = _compareName(_records[middle], latin1Name);
+        if (compare == 0) {
+            return middle;
+        } else if (compare < 0) {
+            first = middle + 1;
+        } else {
+            last = middle - 1;
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,92 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QVariant>
+
+#include "FactMetaData.h"
+
+/// Local cache of the parameter set for one vehicle component.
+///
+/// The file is a fixed size header followed by a table of fixed size records sorted by parameter name. The file is
+/// memory mapped and read in place, so opening a cache and checking its crc against the vehicle hash does not parse
+/// anything. The crc is computed once when the cache is written, the same way the vehicle computes its parameter hash,
+/// which lets a cache hit be decided from the header alone.
+class ParameterCache
+{
+public:
+    typedef struct {
+        QString                     name;
+        FactMetaData::ValueType_t   type;
+        QVariant                    value;
+        bool                        volatileValue;  ///< true: value changes on its own, excluded from the crc
+    } Param_t;
+
+    ParameterCache(void);
+    ~ParameterCache();
+
+    /// Writes a cache file
+    ///     @param params Parameters to write, the order does not matter
+    /// @return false: file could not be written
+    static bool write(const QString& fileName, const QList<Param_t>& params);
+
+    /// Computes the parameter set crc the same way as the vehicle parameter hash
+    static quint32 crc(const QList<Param_t>& params);
+
+    /// Maps the specified cache file
+    /// @return false: file is missing, truncated or not a cache file
+    bool open(const QString& fileName);
+
+    void close(void);
+
+    bool    isOpen  (void) const { return _records != NULL; }
+    quint32 crc     (void) const;
+    int     count   (void) const;
+
+    QString                     name    (int index) const;
+    FactMetaData::ValueType_t   type    (int index) const;
+    QVariant                    value   (int index) const;
+
+    /// @return Index of the named parameter, -1 if not in the cache
+    int indexOf(const QString& name) const;
+
+    static const quint32 magic = 0x51504331;    ///< "QPC1"
+    static const quint16 version = 1;
+
+private:
+    typedef struct {
+        quint32 magic;
+        quint16 version;
+        quint16 recordSize;
+        quint32 crc;
+        quint32 count;
+    } Header_t;
+
+    typedef struct {
+        char    name[16];   ///< Not nul terminated when the name uses all 16 characters
+        quint8  type;       ///< FactMetaData::ValueType_t
+        quint8  reserved[7];
+        union {
+            quint8  raw[8];
+            quint64 alignment;
+        } value;            ///< Value in its native type, as many bytes as FactMetaData::typeToSize
+    } Record_t;
+
+    static bool     _toRecord           (const Param_t& param, Record_t& record);
+    static quint32  _crcAccumulate      (const Record_t& record, quint32 crc);
+    static int      _compareName        (const Record_t& record, const QByteArray& name);
+
+    QFile           _file;
+    const Header_t* _header;
+    const Record_t* _records;
+};
@@ -0,0 +1,319 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterCacheTest.h"
+#include "ParameterFTPLoader.h"
+#include "ParameterManager.h"
+#include "QGC.h"
+
+#include <QElapsedTimer>
+#include <QDataStream>
+#include <QtEndian>
+
+ParameterCache::Param_t ParameterCacheTest::_param(const QString& name, FactMetaData::ValueType_t type, const QVariant& value, bool volatileValue)
+{
+    ParameterCache::Param_t param;
+
+    param.name          = name;
+    param.type          = type;
+    param.value         = value;
+    param.volatileValue = volatileValue;
+
+    return param;
+}
+
+QList<ParameterCache::Param_t> ParameterCacheTest::_params(void)
+{
+    QList<ParameterCache::Param_t> params;
+
+    // Deliberately not in name order
+    params.append(_param("SYS_AUTOSTART",     FactMetaData::valueTypeInt32,   4001));
+    params.append(_param("BAT_V_CHARGED",     FactMetaData::valueTypeFloat,   4.05f));
+    params.append(_param("MAV_SYS_ID",        FactMetaData::valueTypeUint8,   255));
+    params.append(_param("CAL_ACC0_ID",       FactMetaData::valueTypeInt8,    -12));
+    params.append(_param("COM_FLTMODE1",      FactMetaData::valueTypeUint16,  65000));
+    params.append(_param("COM_FLTMODE2",      FactMetaData::valueTypeInt16,   -32000));
+    params.append(_param("SENS_BOARD_ID_XX",  FactMetaData::valueTypeUint32,  4000000000u));
+    params.append(_param("EXT_U64",           FactMetaData::valueTypeUint64,  Q_UINT64_C(0x123456789abcdef0)));
+    params.append(_param("EXT_I64",           FactMetaData::valueTypeInt64,   Q_INT64_C(-1234567890123)));
+    params.append(_param("EXT_DOUBLE",        FactMetaData::valueTypeDouble,  47.397742123456));
+    params.append(_param("LND_FLIGHT_T_HI",   FactMetaData::valueTypeInt32,   77, true /* volatile */));
+
+    return params;
+}
+
+void ParameterCacheTest::_testRoundTrip(void)
+{
+    QVERIFY(_tempDir.isValid());
+    QString fileName = _tempDir.filePath("roundtrip.v3");
+    QList<ParameterCache::Param_t> params = _params();
+
+    QVERIFY(ParameterCache::write(fileName, params));
+
+    ParameterCache cache;
+    QVERIFY(cache.open(fileName));
+    QCOMPARE(cache.count(), params.count());
+
+    // Records are sorted by name
+    for (int i=1; i<cache.count(); i++) {
+        QVERIFY(cache.name(i - 1) < cache.name(i));
+    }
+
+    foreach (const ParameterCache::Param_t& param, params) {
+        int index = cache.indexOf(param.name);
+        QVERIFY(index >= 0);
+        QCOMPARE(cache.name(index), param.name);
+        QCOMPARE(cache.type(index), param.type);
+        if (param.type == FactMetaData::valueTypeFloat) {
+            QCOMPARE(cache.value(index).toFloat(), param.value.toFloat());
+        } else if (param.type == FactMetaData::valueTypeDouble) {
+            QCOMPARE(cache.value(index).toDouble(), param.value.toDouble());
+        } else if (param.type == FactMetaData::valueTypeUint64 || param.type == FactMetaData::valueTypeUint32 || param.type == FactMetaData::valueTypeUint16 || param.type == FactMetaData::valueTypeUint8) {
+            QCOMPARE(cache.value(index).toULongLong(), param.value.toULongLong());
+        } else {
+            QCOMPARE(cache.value(index).toLongLong(), param.value.toLongLong());
+        }
+    }
+
+    QCOMPARE(cache.indexOf("NOT_A_PARAM"), -1);
+    QCOMPARE(cache.indexOf("A"), -1);
+    QCOMPARE(cache.indexOf("ZZZZ"), -1);
+}
+
+void ParameterCacheTest::_testCrc(void)
+{
+    QVERIFY(_tempDir.isValid());
+    QString fileName = _tempDir.filePath("crc.v3");
+    QList<ParameterCache::Param_t> params = _params();
+
+    // Same calculation as the vehicle parameter hash: name then value bytes, in name order, volatile params skipped
+    quint32 expectedCrc = 0;
+    QMap<QString, ParameterCache::Param_t> sortedParams;
+    foreach (const ParameterCache::Param_t& param, params) {
+        sortedParams[param.name] = param;
+    }
+    foreach (const ParameterCache::Param_t& param, sortedParams) {
+        if (param.volatileValue) {
+            continue;
+        }
+        QByteArray value(static_cast<int>(FactMetaData::typeToSize(param.type)), 0);
+        switch (param.type) {
+        case FactMetaData::valueTypeUint8:  { quint8  v = param.value.toUInt();         memcpy(value.data(), &v, sizeof(v)); } break;
+        case FactMetaData::valueTypeInt8:   { qint8   v = param.value.toInt();          memcpy(value.data(), &v, sizeof(v)); } break;
+        case FactMetaData::valueTypeUint16: { quint16 v = param.value.toUInt();         memcpy(value.data(), &v, sizeof(v)); } break;
+        case FactMetaData::valueTypeInt16:  { qint16  v = param.value.toInt();          memcpy(value.data(), &v, sizeof(v)); } break;
+        case FactMetaData::valueTypeUint32: { quint32 v = param.value.toUInt();         memcpy(value.data(), &v, sizeof(v)); } break;
+        case FactMetaData::valueTypeInt32:  { qint32  v = param.value.toInt();          memcpy(value.data(), &v, sizeof(v)); } break;
+        case FactMetaData::valueTypeUint64: { quint64 v = param.value.toULongLong();    memcpy(value.data(), &v, sizeof(v)); } break;
+        case FactMetaData::valueTypeInt64:  { qint64  v = param.value.toLongLong();     memcpy(value.data(), &v, sizeof(v)); } break;
+        case FactMetaData::valueTypeFloat:  { float   v = param.value.toFloat();        memcpy(value.data(), &v, sizeof(v)); } break;
+        case FactMetaData::valueTypeDouble: { double  v = param.value.toDouble();       memcpy(value.data(), &v, sizeof(v)); } break;
+        default: break;
+        }
+        QByteArray name = param.name.toLatin1();
+        expectedCrc = QGC::crc32(reinterpret_cast<const quint8*>(name.constData()), name.length(), expectedCrc);
+        expectedCrc = QGC::crc32(reinterpret_cast<const quint8*>(value.constData()), value.length(), expectedCrc);
+    }
+
+    QCOMPARE(ParameterCache::crc(params), expectedCrc);
+
+    QVERIFY(ParameterCache::write(fileName, params));
+    ParameterCache cache;
+    QVERIFY(cache.open(fileName));
+    QCOMPARE(cache.crc(), expectedCrc);
+
+    // Volatile values don't change the crc, others do
+    params[params.count() - 1].value = 78;
+    QCOMPARE(ParameterCache::crc(params), expectedCrc);
+    params[0].value = 4002;
+    QVERIFY(ParameterCache::crc(params) != expectedCrc);
+}
+
+void ParameterCacheTest::_testInvalidFile(void)
+{
+    QVERIFY(_tempDir.isValid());
+    ParameterCache cache;
+
+    QVERIFY(!cache.open(_tempDir.filePath("missing.v3")));
+    QVERIFY(!cache.isOpen());
+
+    // Legacy QDataStream cache is not accepted
+    QString legacyFileName = _tempDir.filePath("legacy.v3");
+    {
+        QMap<QString, QPair<int, QVariant>> legacyMap;
+        legacyMap["SYS_AUTOSTART"] = QPair<int, QVariant>(FactMetaData::valueTypeInt32, 4001);
+        QFile legacyFile(legacyFileName);
+        QVERIFY(legacyFile.open(QIODevice::WriteOnly));
+        QDataStream ds(&legacyFile);
+        ds << legacyMap;
+    }
+    QVERIFY(!cache.open(legacyFileName));
+
+    // Truncated record table
+    QString fileName = _tempDir.filePath("truncated.v3");
+    QVERIFY(ParameterCache::write(fileName, _params()));
+    QFile file(fileName);
+    QVERIFY(file.resize(file.size() - 1));
+    QVERIFY(!cache.open(fileName));
+    QVERIFY(!cache.isOpen());
+    QCOMPARE(cache.count(), 0);
+}
+
+void ParameterCacheTest::_appendPackedEntry(QByteArray& bytes, int type, int flags, int commonCount, const QByteArray& nameSuffix, const QByteArray& value)
+{
+    bytes.append(static_cast<char>(type | (flags << 4)));
+    bytes.append(static_cast<char>(commonCount | ((nameSuffix.length() - 1) << 4)));
+    bytes.append(nameSuffix);
+    bytes.append(value);
+}
+
+void ParameterCacheTest::_testPackedFile(void)
+{
+    uchar buffer[4];
+
+    QByteArray bytes;
+    qToLittleEndian<quint16>(ParameterFTPLoader::packedFileMagicWithDefaults, buffer);
+    bytes.append(reinterpret_cast<const char*>(buffer), 2);
+    qToLittleEndian<quint16>(4, buffer);
+    bytes.append(reinterpret_cast<const char*>(buffer), 2);
+    bytes.append(reinterpret_cast<const char*>(buffer), 2);
+
+    // ACRO_LOCKING: int8 = -3
+    _appendPackedEntry(bytes, 1, 0, 0, "ACRO_LOCKING", QByteArray(1, static_cast<char>(-3)));
+
+    // ACRO_OPTIONS: int16 = 1000, shares "ACRO_" with previous, has a default value which must be skipped
+    qToLittleEndian<qint16>(1000, buffer);
+    QByteArray int16Value(reinterpret_cast<const char*>(buffer), 2);
+    qToLittleEndian<qint16>(0, buffer);
+    _appendPackedEntry(bytes, 2, 1, 5, "OPTIONS", int16Value + QByteArray(reinterpret_cast<const char*>(buffer), 2));
+
+    // Padding
+    bytes.append(QByteArray(3, 0));
+
+    // ACRO_RP_P: float = 4.5, shares "ACRO_"
+    float floatValue = 4.5f;
+    quint32 floatBits;
+    memcpy(&floatBits, &floatValue, sizeof(floatBits));
+    qToLittleEndian<quint32>(floatBits, buffer);
+    _appendPackedEntry(bytes, 4, 0, 5, "RP_P", QByteArray(reinterpret_cast<const char*>(buffer), 4));
+
+    // SYSID_THISMAV: int32 = -70000, nothing in common
+    qToLittleEndian<qint32>(-70000, buffer);
+    _appendPackedEntry(bytes, 3, 0, 0, "SYSID_THISMAV", QByteArray(reinterpret_cast<const char*>(buffer), 4));
+
+    QList<ParameterCache::Param_t> params;
+    QString errorString;
+    QVERIFY(ParameterFTPLoader::parsePackedFile(bytes, params, errorString));
+    QCOMPARE(params.count(), 4);
+
+    QCOMPARE(params[0].name, QStringLiteral("ACRO_LOCKING"));
+    QCOMPARE(params[0].type, FactMetaData::valueTypeInt8);
+    QCOMPARE(params[0].value.toInt(), -3);
+
+    QCOMPARE(params[1].name, QStringLiteral("ACRO_OPTIONS"));
+    QCOMPARE(params[1].type, FactMetaData::valueTypeInt16);
+    QCOMPARE(params[1].value.toInt(), 1000);
+
+    QCOMPARE(params[2].name, QStringLiteral("ACRO_RP_P"));
+    QCOMPARE(params[2].type, FactMetaData::valueTypeFloat);
+    QCOMPARE(params[2].value.toFloat(), 4.5f);
+
+    QCOMPARE(params[3].name, QStringLiteral("SYSID_THISMAV"));
+    QCOMPARE(params[3].type, FactMetaData::valueTypeInt32);
+    QCOMPARE(params[3].value.toInt(), -70000);
+}
+
+void ParameterCacheTest::_testPackedFileTruncated(void)
+{
+    uchar buffer[2];
+
+    QByteArray bytes;
+    qToLittleEndian<quint16>(ParameterFTPLoader::packedFileMagic, buffer);
+    bytes.append(reinterpret_cast<const char*>(buffer), 2);
+    qToLittleEndian<quint16>(2, buffer);
+    bytes.append(reinterpret_cast<const char*>(buffer), 2);
+    bytes.append(reinterpret_cast<const char*>(buffer), 2);
+    _appendPackedEntry(bytes, 1, 0, 0, "ACRO_LOCKING", QByteArray(1, 1));
+
+    QList<ParameterCache::Param_t> params;
+    QString errorString;
+
+    // Second parameter is missing
+    QVERIFY(!ParameterFTPLoader::parsePackedFile(bytes, params, errorString));
+    QVERIFY(params.isEmpty());
+    QVERIFY(!errorString.isEmpty());
+
+    // Too short for a header
+    QVERIFY(!ParameterFTPLoader::parsePackedFile(bytes.left(4), params, errorString));
+
+    // Wrong magic
+    bytes[0] = 0;
+    QVERIFY(!ParameterFTPLoader::parsePackedFile(bytes, params, errorString));
+}
+
+void ParameterCacheTest::_benchmarkCacheLoad(void)
+{
+    UT_BENCHMARK();
+
+    const int paramCount = 1500;
+    const int loops = 20;
+
+    QVERIFY(_tempDir.isValid());
+
+    QList<ParameterCache::Param_t> params;
+    QMap<QString, QPair<int, QVariant>> legacyMap;
+    for (int i=0; i<paramCount; i++) {
+        QString name = QStringLiteral("PARAM_%1").arg(i, 6, 10, QChar('0'));
+        params.append(_param(name, FactMetaData::valueTypeFloat, static_cast<float>(i) * 0.5f));
+        legacyMap[name] = QPair<int, QVariant>(FactMetaData::valueTypeFloat, QVariant(static_cast<float>(i) * 0.5f));
+    }
+
+    QString fileName = _tempDir.filePath("benchmark.v3");
+    QString legacyFileName = _tempDir.filePath("benchmark.v2");
+    QVERIFY(ParameterCache::write(fileName, params));
+    {
+        QFile legacyFile(legacyFileName);
+        QVERIFY(legacyFile.open(QIODevice::WriteOnly));
+        QDataStream ds(&legacyFile);
+        ds << legacyMap;
+    }
+
+    // Legacy cache: deserialize the whole map and compute the crc before a hit can be decided
+    QElapsedTimer timer;
+    timer.start();
+    quint32 legacyCrc = 0;
+    for (int loop=0; loop<loops; loop++) {
+        QMap<QString, QPair<int, QVariant>> map;
+        QFile legacyFile(legacyFileName);
+        QVERIFY(legacyFile.open(QIODevice::ReadOnly));
+        QDataStream ds(&legacyFile);
+        ds >> map;
+        legacyCrc = 0;
+        foreach (const QString& name, map.keys()) {
+            float value = map[name].second.toFloat();
+            QByteArray latin1Name = name.toLatin1();
+            legacyCrc = QGC::crc32(reinterpret_cast<const quint8*>(latin1Name.constData()), latin1Name.length(), legacyCrc);
+            legacyCrc = QGC::crc32(reinterpret_cast<const quint8*>(&value), sizeof(value), legacyCrc);
+        }
+    }
+    qint64 legacyMSecs = timer.elapsed();
+
+    // Mapped cache: the crc is in the header
+    timer.restart();
+    quint32 cacheCrc = 0;
+    for (int loop=0; loop<loops; loop++) {
+        ParameterCache cache;
+        QVERIFY(cache.open(fileName));
+        cacheCrc = cache.crc();
+    }
+    qint64 cacheMSecs = timer.elapsed();
+
+    QCOMPARE(cacheCrc, legacyCrc);
+    qCDebug(ParameterManagerVerbose1Log) << "ParameterCache hash check - params:loops:legacyMSecs:mappedMSecs" << paramCount << loops << legacyMSecs << cacheMSecs;
+}
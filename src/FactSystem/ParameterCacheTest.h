@@ -0,0 +1,36 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+#include "ParameterCache.h"
+
+#include <QTemporaryDir>
+
+/// Unit test for the binary parameter cache and the packed parameter file parser
+class ParameterCacheTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testRoundTrip(void);
+    void _testCrc(void);
+    void _testInvalidFile(void);
+    void _testPackedFile(void);
+    void _testPackedFileTruncated(void);
+    void _benchmarkCacheLoad(void);
+
+private:
+    QList<ParameterCache::Param_t> _params(void);
+    ParameterCache::Param_t _param(const QString& name, FactMetaData::ValueType_t type, const QVariant& value, bool volatileValue = false);
+    void _appendPackedEntry(QByteArray& bytes, int type, int flags, int commonCount, const QByteArray& nameSuffix, const QByteArray& value);
+
+    QTemporaryDir _tempDir;
+};
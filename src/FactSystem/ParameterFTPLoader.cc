@@ -0,0 +1,204 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterFTPLoader.h"
+#include "QGCLoggingCategory.h"
+#include "Vehicle.h"
+#include "UAS.h"
+#include "FileManager.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include <string.h>
+
+QGC_LOGGING_CATEGORY(ParameterFTPLoaderLog, "ParameterFTPLoaderLog")
+
+const char* ParameterFTPLoader::packedFilePath = "@PARAM/param.pck";
+
+ParameterFTPLoader::ParameterFTPLoader(Vehicle* vehicle, QObject* parent)
+    : QObject       (parent)
+    , _vehicle      (vehicle)
+    , _fileManager  (vehicle->uas()->getFileManager())
+    , _active       (false)
+{
+
+}
+
+void ParameterFTPLoader::load(void)
+{
+    if (_active) {
+        qWarning() << "ParameterFTPLoader::load called while download is in progress";
+        return;
+    }
+    if (!_downloadDir.isValid()) {
+        emit loadFailed(tr("Unable to create temporary directory for parameter download"));
+        return;
+    }
+
+    // The file manager is shared with other users, only listen to it while our download is running
+    _active = true;
+    connect(_fileManager, &FileManager::commandComplete,    this, &ParameterFTPLoader::_commandComplete);
+    connect(_fileManager, &FileManager::commandError,       this, &ParameterFTPLoader::_commandError);
+
+    qCDebug(ParameterFTPLoaderLog) << "Downloading" << packedFilePath;
+    _downloadTimer.start();
+    _fileManager->streamPath(packedFilePath, QDir(_downloadDir.path()));
+}
+
+void ParameterFTPLoader::_disconnectFileManager(void)
+{
+    _active = false;
+    disconnect(_fileManager, &FileManager::commandComplete,    this, &ParameterFTPLoader::_commandComplete);
+    disconnect(_fileManager, &FileManager::commandError,       this, &ParameterFTPLoader::_commandError);
+}
+
+void ParameterFTPLoader::_commandComplete(void)
+{
+    _disconnectFileManager();
+
+    QFile file(QDir(_downloadDir.path()).absoluteFilePath(QFileInfo(packedFilePath).fileName()));
+    if (!file.open(QIODevice::ReadOnly)) {
+        emit loadFailed(tr("Unable to open downloaded parameter file: %1").arg(file.errorString()));
+        return;
+    }
+    QByteArray bytes = file.readAll();
+    file.close();
+    file.remove();
+
+    QList<ParameterCache::Param_t> params;
+    QString errorString;
+    if (!parsePackedFile(bytes, params, errorString)) {
+        emit loadFailed(errorString);
+        return;
+    }
+
+    qCDebug(ParameterFTPLoaderLog) << "Download complete - bytes:params:msecs" << bytes.count() << params.count() << _downloadTimer.elapsed();
+    emit loadComplete(params);
+}
+
+void ParameterFTPLoader::_commandError(const QString& msg)
+{
+    _disconnectFileManager();
+    qCDebug(ParameterFTPLoaderLog) << "Download failed - msecs" << _downloadTimer.elapsed() << msg;
+    emit loadFailed(msg);
+}
+
+bool ParameterFTPLoader::parsePackedFile(const QByteArray& bytes, QList<ParameterCache::Param_t>& params, QString& errorString)
+{
+    const int headerSize = 6;
+    const uchar* data = reinterpret_cast<const uchar*>(bytes.constData());
+    int size = bytes.count();
+
+    params.clear();
+
+    if (size < headerSize) {
+        errorString = tr("Parameter file is too short");
+        return false;
+    }
+
+    quint16 magic = qFromLittleEndian<quint16>(data);
+    int paramCount = qFromLittleEndian<quint16>(data + 2);
+    if (magic != packedFileMagic && magic != packedFileMagicWithDefaults) {
+        errorString = tr("Parameter file has unknown format: %1").arg(magic, 0, 16);
+        return false;
+    }
+
+    QString previousName;
+    int offset = headerSize;
+    while (offset < size && params.count() < paramCount) {
+        // Zero bytes are padding which keep entries from straddling block boundaries
+        if (data[offset] == 0) {
+            offset++;
+            continue;
+        }
+        if (offset + 2 > size) {
+            break;
+        }
+
+        int type        = data[offset] & 0x0F;
+        int flags       = data[offset] >> 4;
+        int commonCount = data[offset + 1] & 0x0F;
+        int nameCount   = (data[offset + 1] >> 4) + 1;
+        offset += 2;
+
+        if (commonCount > previousName.length() || offset + nameCount > size) {
+            break;
+        }
+
+        ParameterCache::Param_t param;
+        param.name = previousName.left(commonCount) + QString::fromLatin1(reinterpret_cast<const char*>(data + offset), nameCount);
+        param.volatileValue = false;
+        offset += nameCount;
+
+        int valueSize;
+        switch (type) {
+        case 1:
+            param.type = FactMetaData::valueTypeInt8;
+            valueSize = 1;
+            break;
+        case 2:
+            param.type = FactMetaData::valueTypeInt16;
+            valueSize = 2;
+            break;
+        case 3:
+            param.type = FactMetaData::valueTypeInt32;
+            valueSize = 4;
+            break;
+        case 4:
+            param.type = FactMetaData::valueTypeFloat;
+            valueSize = 4;
+            break;
+        default:
+            errorString = tr("Parameter file has unknown type %1 for %2").arg(type).arg(param.name);
+            return false;
+        }
+        if (offset + valueSize > size) {
+            break;
+        }
+
+        switch (type) {
+        case 1:
+            param.value = QVariant(static_cast<int>(static_cast<qint8>(data[offset])));
+            break;
+        case 2:
+            param.value = QVariant(static_cast<int>(qFromLittleEndian<qint16>(data + offset)));
+            break;
+        case 3:
+            param.value = QVariant(static_cast<int>(qFromLittleEndian<qint32>(data + offset)));
+            break;
+        case 4:
+        {
+            quint32 bits = qFromLittleEndian<quint32>(data + offset);
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            param.value = QVariant(value);
+        }
+            break;
+        }
+        offset += valueSize;
+
+        if (magic == packedFileMagicWithDefaults && (flags & 1)) {
+            // Skip default value
+            offset += valueSize;
+        }
+
+        params.append(param);
+        previousName = param.name;
+    }
+
+    if (params.count() != paramCount) {
+        errorString = tr("Parameter file is truncated, %1 of %2 parameters").arg(params.count()).arg(paramCount);
+        params.clear();
+        return false;
+    }
+
+    return true;
+}
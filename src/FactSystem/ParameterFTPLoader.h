@@ -0,0 +1,70 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QLoggingCategory>
+
+#include "ParameterCache.h"
+
+Q_DECLARE_LOGGING_CATEGORY(ParameterFTPLoaderLog)
+
+class Vehicle;
+class FileManager;
+
+/// Downloads the full parameter set of the autopilot component as a single packed file using MAVLink FTP. This is
+/// one file transfer instead of a PARAM_VALUE message per parameter, so it is much less affected by link loss.
+///
+/// The packed file format is the one served by ArduPilot at @PARAM/param.pck: a six byte header (magic, parameter
+/// count, total parameter count) followed by one entry per parameter. Entries are sorted by name and each entry only
+/// stores the part of its name which differs from the previous entry.
+class ParameterFTPLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    ParameterFTPLoader(Vehicle* vehicle, QObject* parent = NULL);
+
+    /// Starts the download. Signals loadComplete or loadFailed when done.
+    void load(void);
+
+    /// @return true: download in progress
+    bool active(void) const { return _active; }
+
+    /// Parses the contents of a packed parameter file
+    ///     @param[out] params Parameters in file order
+    ///     @param[out] errorString Error if return is false
+    /// @return false: file is not a valid packed parameter file
+    static bool parsePackedFile(const QByteArray& bytes, QList<ParameterCache::Param_t>& params, QString& errorString);
+
+    static const char* packedFilePath;
+
+    static const quint16 packedFileMagic =              0x671b;
+    static const quint16 packedFileMagicWithDefaults =  0x671c;    ///< Entries flagged with a default also store the default value
+
+signals:
+    void loadComplete(const QList<ParameterCache::Param_t>& params);
+    void loadFailed(const QString& errorString);
+
+private slots:
+    void _commandComplete   (void);
+    void _commandError      (const QString& msg);
+
+private:
+    void _disconnectFileManager(void);
+
+    Vehicle*        _vehicle;
+    FileManager*    _fileManager;
+    QTemporaryDir   _downloadDir;
+    QElapsedTimer   _downloadTimer;
+    bool            _active;
+};
@@ -15,6 +15,8 @@
 #include "FirmwarePlugin.h"
 #include "UAS.h"
 #include "JsonHelper.h"
+#include "SettingsManager.h"
+#include "ParameterFTPLoader.h"
 
 #include <QEasingCurve>
 #include <QFile>
@@ -48,6 +50,9 @@ ParameterManager::ParameterManager(Vehicle* vehicle)
     , _logReplay                        (vehicle->priorityLink() && vehicle->priorityLink()->isLogReplay())
     , _parameterSetMajorVersion         (-1)
     , _parameterMetaData                (NULL)
+    , _ftpLoader                        (NULL)
+    , _loadSource                       (LoadSourceStream)
+    , _loadTimeMSecs                    (-1)
     , _prevWaitingReadParamIndexCount   (0)
     , _prevWaitingReadParamNameCount    (0)
     , _prevWaitingWriteParamNameCount   (0)
@@ -56,6 +61,7 @@ ParameterManager::ParameterManager(Vehicle* vehicle)
     , _indexBatchQueueActive            (false)
     , _totalParamCount                  (0)
 {
+    _loadTimer.start();
     _versionParam = vehicle->firmwarePlugin()->getVersionParam();
 
     if (_vehicle->isOfflineEditingVehicle()) {
@@ -73,7 +79,7 @@ ParameterManager::ParameterManager(Vehicle* vehicle)
     _waitingParamTimeoutTimer.setInterval(3000);
     connect(&_waitingParamTimeoutTimer, &QTimer::timeout, this, &ParameterManager::_waitingParamTimeout);
 
-    connect(_vehicle->uas(), &UASInterface::parameterUpdate, this, &ParameterManager::_parameterUpdate);
+    connect(_vehicle->uas(), &UASInterface::parameterUpdate, this, &ParameterManager::_vehicleParameterUpdate);
 
     // Ensure the cache directory exists
     QFileInfo(QSettings().fileName()).dir().mkdir("ParamCache");
@@ -87,7 +93,17 @@ ParameterManager::ParameterManager(Vehicle* vehicle)
         emit parametersReadyChanged(_parametersReady);
         emit missingParametersChanged(_missingParameters);
     } else if (!_logReplay){
-        refreshAllParameters();
+        if (qgcApp()->toolbox()->settingsManager()->appSettings()->parameterDownloadFTP()->rawValue().toBool()) {
+            // Try to get the whole autopilot parameter set as a single file first, falls back to the normal load on failure
+            _ftpLoader = new ParameterFTPLoader(_vehicle, this);
+            connect(_ftpLoader, &ParameterFTPLoader::loadComplete,  this, &ParameterManager::_ftpLoadComplete);
+            connect(_ftpLoader, &ParameterFTPLoader::loadFailed,    this, &ParameterManager::_ftpLoadFailed);
+            // The file only holds the autopilot parameters, other components are found from their heartbeats
+            connect(_vehicle, &Vehicle::mavlinkMessageReceived,     this, &ParameterManager::_ftpMavlinkMessageReceived);
+            _ftpLoader->load();
+        } else {
+            refreshAllParameters();
+        }
     }
 }
 
@@ -96,6 +112,17 @@ ParameterManager::~ParameterManager()
     delete _parameterMetaData;
 }
 
+/// Called for parameters which come from the vehicle, as opposed to the cache or a file
+void ParameterManager::_vehicleParameterUpdate(int vehicleId, int componentId, QString parameterName, int parameterCount, int parameterId, int mavType, QVariant value)
+{
+    if (vehicleId == _vehicle->id()) {
+        _requestScheduler.paramReceived(_loadTimer.elapsed());
+        emit loadStatsChanged();
+    }
+
+    _parameterUpdate(vehicleId, componentId, parameterName, parameterCount, parameterId, mavType, value);
+}
+
 /// Called whenever a parameter is updated or first seen.
 void ParameterManager::_parameterUpdate(int vehicleId, int componentId, QString parameterName, int parameterCount, int parameterId, int mavType, QVariant value)
 {
@@ -115,12 +142,13 @@ void ParameterManager::_parameterUpdate(int vehicleId, int componentId, QString
 
     // ArduPilot has this strange behavior of streaming parameters that we didn't ask for. This even happens before it responds to the
     // PARAM_REQUEST_LIST. We disregard any of this until the initial request is responded to.
-    if (parameterId == 65535 && parameterName != "_HASH_CHECK" && _initialRequestTimeoutTimer.isActive()) {
+    if (parameterId == 65535 && parameterName != "_HASH_CHECK" && (_initialRequestTimeoutTimer.isActive() || (_ftpLoader && _ftpLoader->active()))) {
         qCDebug(ParameterManagerVerbose1Log) << "Disregarding unrequested param prior to initial list response" << parameterName;
         return;
     }
 
     _initialRequestTimeoutTimer.stop();
+    _ftpWaitingComponentIds.remove(componentId);
 
 #if 0
     if (!_initialLoadComplete && !_indexBatchQueueActive) {
@@ -207,7 +235,9 @@ void ParameterManager::_parameterUpdate(int vehicleId, int componentId, QString
     // Remove this parameter from the waiting lists
     if (_waitingReadParamIndexMap[componentId].contains(parameterId)) {
         _waitingReadParamIndexMap[componentId].remove(parameterId);
-        _indexBatchQueue.removeOne(parameterId);
+        if (_indexBatchQueue.removeOne(parameterId)) {
+            _requestScheduler.responseReceived();
+        }
         _fillIndexBatchQueue(false /* waitingParamTimeout */);
     }
     _waitingReadParamNameMap[componentId].remove(parameterName);
@@ -421,6 +451,11 @@ void ParameterManager::refreshAllParameters(uint8_t componentId)
         _initialRequestTimeoutTimer.start();
     }
 
+    if (componentId == MAV_COMP_ID_ALL) {
+        // A full load starts over, the window learned from the previous load may no longer fit the link
+        _requestScheduler.reset();
+    }
+
     // Reset index wait lists
     foreach (int cid, _paramCountMap.keys()) {
         // Add/Update all indices to the wait list, parameter index is 0-based
@@ -444,6 +479,9 @@ void ParameterManager::refreshAllParameters(uint8_t componentId)
                                              _vehicle->id(),
                                              componentId);
     _vehicle->sendMessageOnLink(_vehicle->priorityLink(), msg);
+    if (componentId == MAV_COMP_ID_ALL) {
+        emit loadStatsChanged();
+    }
 
     QString what = (componentId == MAV_COMP_ID_ALL) ? "MAV_COMP_ID_ALL" : QString::number(componentId);
     qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "Request to refresh all parameters for component ID:" << what;
@@ -558,11 +596,14 @@ bool ParameterManager::_fillIndexBatchQueue(bool waitingParamTimeout)
         return false;
     }
 
-    const int maxBatchSize = 10;
+    _updateRequestSchedulerLink();
 
     if (waitingParamTimeout) {
         // We timed out, clear the queue and try again
         qCDebug(ParameterManagerLog) << "Refilling index based batch queue due to timeout";
+        if (_indexBatchQueue.count()) {
+            _requestScheduler.requestTimeout();
+        }
         _indexBatchQueue.clear();
     } else {
         qCDebug(ParameterManagerLog) << "Refilling index based batch queue due to received parameter";
@@ -580,7 +621,7 @@ bool ParameterManager::_fillIndexBatchQueue(bool waitingParamTimeout)
                 continue;
             }
 
-            if (_indexBatchQueue.count() > maxBatchSize) {
+            if (_indexBatchQueue.count() >= _requestScheduler.window()) {
                 break;
             }
 
@@ -594,14 +635,29 @@ bool ParameterManager::_fillIndexBatchQueue(bool waitingParamTimeout)
                 // Retry again
                 _indexBatchQueue.append(paramIndex);
                 _readParameterRaw(componentId, "", paramIndex);
+                _requestScheduler.requestSent();
                 qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Read re-request for (paramIndex:" << paramIndex << "retryCount:" << _waitingReadParamIndexMap[componentId][paramIndex] << ")";
             }
         }
     }
 
+    qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "Index batch queue - count:window:linkWindow" << _indexBatchQueue.count() << _requestScheduler.window() << _requestScheduler.linkWindow();
+    emit loadStatsChanged();
+
     return _indexBatchQueue.count() != 0;
 }
 
+/// Updates the request scheduler with the current state of the link to the vehicle
+void ParameterManager::_updateRequestSchedulerLink(void)
+{
+    LinkInterface* link = _vehicle->priorityLink();
+
+    if (link) {
+        _requestScheduler.setLinkRate(link->getConnectionSpeed(), link->getCurrentInputDataRate());
+    }
+    _requestScheduler.setLossPercent(_vehicle->mavlinkLossPercent());
+}
+
 void ParameterManager::_waitingParamTimeout(void)
 {
     if (_logReplay) {
@@ -609,7 +665,6 @@ void ParameterManager::_waitingParamTimeout(void)
     }
 
     bool paramsRequested = false;
-    const int maxBatchSize = 10;
     int batchCount = 0;
 
     qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "_waitingParamTimeout";
@@ -640,7 +695,7 @@ void ParameterManager::_waitingParamTimeout(void)
                 if (_waitingWriteParamNameMap[componentId][paramName] <= _maxReadWriteRetry) {
                     _writeParameterRaw(componentId, paramName, getParameter(componentId, paramName)->rawValue());
                     qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Write resend for (paramName:" << paramName << "retryCount:" << _waitingWriteParamNameMap[componentId][paramName] << ")";
-                    if (++batchCount > maxBatchSize) {
+                    if (++batchCount >= _requestScheduler.window()) {
                         goto Out;
                     }
                 } else {
@@ -662,7 +717,7 @@ void ParameterManager::_waitingParamTimeout(void)
                 if (_waitingReadParamNameMap[componentId][paramName] <= _maxReadWriteRetry) {
                     _readParameterRaw(componentId, paramName, -1);
                     qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Read re-request for (paramName:" << paramName << "retryCount:" << _waitingReadParamNameMap[componentId][paramName] << ")";
-                    if (++batchCount > maxBatchSize) {
+                    if (++batchCount >= _requestScheduler.window()) {
                         goto Out;
                     }
                 } else {
@@ -761,18 +816,21 @@ void ParameterManager::_writeParameterRaw(int componentId, const QString& paramN
 
 void ParameterManager::_writeLocalParamCache(int vehicleId, int componentId)
 {
-    CacheMapName2ParamTypeVal cacheMap;
+    QList<ParameterCache::Param_t> params;
 
-    foreach(const QString& name, _mapParameterName2Variant[componentId].keys()) {
-        const Fact *fact = _mapParameterName2Variant[componentId][name].value<Fact*>();
-        cacheMap[name] = ParamTypeVal(fact->type(), fact->rawValue());
+    foreach(const QVariant& factVariant, _mapParameterName2Variant[componentId]) {
+        const Fact* fact = factVariant.value<Fact*>();
+        ParameterCache::Param_t param;
+        param.name = fact->name();
+        param.type = fact->type();
+        param.value = fact->rawValue();
+        param.volatileValue = fact->volatileValue();
+        params.append(param);
     }
 
-    QFile cacheFile(parameterCacheFile(vehicleId, componentId));
-    cacheFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
-
-    QDataStream ds(&cacheFile);
-    ds << cacheMap;
+    if (!ParameterCache::write(parameterCacheFile(vehicleId, componentId), params)) {
+        qCWarning(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Unable to write parameter cache";
+    }
 }
 
 QDir ParameterManager::parameterCacheDir()
@@ -783,69 +841,37 @@ QDir ParameterManager::parameterCacheDir()
 
 QString ParameterManager::parameterCacheFile(int vehicleId, int componentId)
 {
-    return parameterCacheDir().filePath(QString("%1_%2.v2").arg(vehicleId).arg(componentId));
+    return parameterCacheDir().filePath(QString("%1_%2.v3").arg(vehicleId).arg(componentId));
 }
 
 void ParameterManager::_tryCacheHashLoad(int vehicleId, int componentId, QVariant hash_value)
 {
     qCInfo(ParameterManagerLog) << "Attemping load from cache";
 
-    uint32_t crc32_value = 0;
-    /* The datastructure of the cache table */
-    CacheMapName2ParamTypeVal cacheMap;
-    QFile cacheFile(parameterCacheFile(vehicleId, componentId));
-    if (!cacheFile.exists()) {
+    QElapsedTimer cacheTimer;
+    cacheTimer.start();
+
+    // The cache crc was computed when the cache was written, so a hit or miss is decided from the cache header alone
+    ParameterCache cache;
+    QString cacheFileName = parameterCacheFile(vehicleId, componentId);
+    if (!cache.open(cacheFileName)) {
         /* no local cache, just wait for them to come in*/
         return;
     }
-    cacheFile.open(QIODevice::ReadOnly);
-
-    /* Deserialize the parameter cache table */
-    QDataStream ds(&cacheFile);
-    ds >> cacheMap;
-
-    // Load parameter meta data for the version number stored in cache.
-    // We need meta data so we have access to the volatile bit
-    if (cacheMap.contains(_versionParam)) {
-        _parameterSetMajorVersion = cacheMap[_versionParam].second.toInt();
-    }
-    _loadMetaData();
-
-    /* compute the crc of the local cache to check against the remote */
-
-    FirmwarePlugin* firmwarePlugin = _vehicle->firmwarePlugin();
-    foreach (const QString& name, cacheMap.keys()) {
-        bool volatileValue = false;
-
-        FactMetaData* metaData = firmwarePlugin->getMetaDataForFact(_parameterMetaData, name, _vehicle->vehicleType());
-        if (metaData) {
-            volatileValue = metaData->volatileValue();
-        }
-
-        if (volatileValue) {
-            // Does not take part in CRC
-            qCDebug(ParameterManagerLog) << "Volatile parameter" << name;
-        } else {
-            const ParamTypeVal& paramTypeVal = cacheMap[name];
-            const void *vdat = paramTypeVal.second.constData();
-            const FactMetaData::ValueType_t fact_type = static_cast<FactMetaData::ValueType_t>(paramTypeVal.first);
-            crc32_value = QGC::crc32((const uint8_t *)qPrintable(name), name.length(),  crc32_value);
-            crc32_value = QGC::crc32((const uint8_t *)vdat, FactMetaData::typeToSize(fact_type), crc32_value);
-        }
-    }
+    uint32_t crc32_value = cache.crc();
 
     /* if the two param set hashes match, just load from the disk */
     if (crc32_value == hash_value.toUInt()) {
-        qCInfo(ParameterManagerLog) << "Parameters loaded from cache" << qPrintable(QFileInfo(cacheFile).absoluteFilePath());
-
-        int count = cacheMap.count();
-        int index = 0;
-        foreach (const QString& name, cacheMap.keys()) {
-            const ParamTypeVal& paramTypeVal = cacheMap[name];
-            const FactMetaData::ValueType_t fact_type = static_cast<FactMetaData::ValueType_t>(paramTypeVal.first);
-            const int mavType = _factTypeToMavType(fact_type);
-            _parameterUpdate(vehicleId, componentId, name, count, index++, mavType, paramTypeVal.second);
+        qCInfo(ParameterManagerLog) << "Parameters loaded from cache" << qPrintable(QFileInfo(cacheFileName).absoluteFilePath());
+
+        _loadSource = LoadSourceCache;
+
+        int count = cache.count();
+        for (int index=0; index<count; index++) {
+            const int mavType = _factTypeToMavType(cache.type(index));
+            _parameterUpdate(vehicleId, componentId, cache.name(index), count, index, mavType, cache.value(index));
         }
+        qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Cache load msecs" << cacheTimer.elapsed();
 
         // Return the hash value to notify we don't want any more updates
         mavlink_param_set_t     p;
@@ -885,14 +911,12 @@ void ParameterManager::_tryCacheHashLoad(int vehicleId, int componentId, QVarian
 
         ani->start(QAbstractAnimation::DeleteWhenStopped);
     } else {
-        // Cache parameter version may differ from vehicle parameter version so we can't trust information loaded from cache parameter version number
-        _parameterSetMajorVersion = -1;
-        _clearMetaData();
-        qCInfo(ParameterManagerLog) << "Parameters cache match failed" << qPrintable(QFileInfo(cacheFile).absoluteFilePath());
+        qCInfo(ParameterManagerLog) << "Parameters cache match failed" << qPrintable(QFileInfo(cacheFileName).absoluteFilePath());
         if (ParameterManagerDebugCacheFailureLog().isDebugEnabled()) {
             _debugCacheCRC[componentId] = true;
-            _debugCacheMap[componentId] = cacheMap;
-            foreach (const QString& name, cacheMap.keys()) {
+            for (int index=0; index<cache.count(); index++) {
+                QString name = cache.name(index);
+                _debugCacheMap[componentId][name] = ParamTypeVal(cache.type(index), cache.value(index));
                 _debugCacheParamSeen[componentId][name] = false;
             }
             qgcApp()->showMessage(tr("Parameter cache CRC match failed"));
@@ -1054,14 +1078,6 @@ FactMetaData::ValueType_t ParameterManager::_mavTypeToFactType(MAV_PARAM_TYPE ma
     }
 }
 
-void ParameterManager::_clearMetaData(void)
-{
-    if (_parameterMetaData) {
-        _parameterMetaData->deleteLater();
-        _parameterMetaData = NULL;
-    }
-}
-
 void ParameterManager::_loadMetaData(void)
 {
     if (_parameterMetaData) {
@@ -1112,9 +1128,18 @@ void ParameterManager::_checkInitialLoadComplete(void)
         return;
     }
 
+    if (!_ftpWaitingComponentIds.isEmpty()) {
+        // Components which are not part of the FTP parameter file have not started sending yet
+        return;
+    }
+
     // We aren't waiting for any more initial parameter updates, initial parameter loading is complete
     _initialLoadComplete = true;
 
+    static const char* loadSourceNames[] = { "stream", "cache", "ftp" };
+    _loadTimeMSecs = static_cast<int>(_loadTimer.elapsed());
+    qCInfo(ParameterManagerLog) << _logVehiclePrefix() << "Parameters ready - source:msecs:count" << loadSourceNames[_loadSource] << _loadTimeMSecs << _totalParamCount;
+
 	// Parameter cache crc failure debugging
 	foreach (int componentId, _debugCacheParamSeen.keys()) {
         if (!_logReplay && _debugCacheCRC.contains(componentId) && _debugCacheCRC[componentId]) {
@@ -1166,6 +1191,14 @@ void ParameterManager::_checkInitialLoadComplete(void)
 
 void ParameterManager::_initialRequestTimeout(void)
 {
+    if (!_ftpWaitingComponentIds.isEmpty()) {
+        // Not all components have parameters, so ones which don't answer the request are not retried
+        qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "No parameters from components after FTP load" << _ftpWaitingComponentIds.toList();
+        _ftpWaitingComponentIds.clear();
+        _checkInitialLoadComplete();
+        return;
+    }
+
     if (!_disableAllRetries && ++_initialRequestRetryCount <= _maxInitialRequestListRetry) {
         qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "Retrying initial parameter request list";
         refreshAllParameters();
@@ -1180,6 +1213,79 @@ void ParameterManager::_initialRequestTimeout(void)
     }
 }
 
+void ParameterManager::_ftpLoadComplete(const QList<ParameterCache::Param_t>& params)
+{
+    _ftpLoader->deleteLater();
+    _ftpLoader = NULL;
+
+    if (_initialLoadComplete) {
+        return;
+    }
+    if (params.isEmpty()) {
+        _ftpLoadFailed(tr("Parameter file is empty"));
+        return;
+    }
+
+    // The packed file holds the autopilot parameters. Feed them through the same path as PARAM_VALUE messages.
+    // The initial load is held open for the other components which have been heard from until they answer their
+    // own request list.
+    _loadSource = LoadSourceFTP;
+    _ftpWaitingComponentIds = _ftpComponentIds;
+    int vehicleId = _vehicle->id();
+    int componentId = _vehicle->defaultComponentId();
+    int count = params.count();
+    for (int index=0; index<count; index++) {
+        const ParameterCache::Param_t& param = params[index];
+        _parameterUpdate(vehicleId, componentId, param.name, count, index, _factTypeToMavType(param.type), param.value);
+    }
+    foreach (int otherComponentId, _ftpComponentIds) {
+        _ftpRequestComponent(otherComponentId);
+    }
+}
+
+void ParameterManager::_ftpLoadFailed(const QString& errorString)
+{
+    if (_ftpLoader) {
+        _ftpLoader->deleteLater();
+        _ftpLoader = NULL;
+    }
+
+    qCDebug(ParameterManagerLog) << _logVehiclePrefix() << "FTP parameter load failed, falling back to parameter stream:" << errorString;
+    if (!_initialLoadComplete) {
+        // The stream request goes to all components so there is no need to track them any more
+        disconnect(_vehicle, &Vehicle::mavlinkMessageReceived, this, &ParameterManager::_ftpMavlinkMessageReceived);
+        _ftpComponentIds.clear();
+        refreshAllParameters();
+    }
+}
+
+/// Tracks the components of the vehicle which are not covered by the FTP parameter file
+void ParameterManager::_ftpMavlinkMessageReceived(const mavlink_message_t& message)
+{
+    if (message.msgid != MAVLINK_MSG_ID_HEARTBEAT || message.sysid != _vehicle->id() || message.compid == _vehicle->defaultComponentId()) {
+        return;
+    }
+    if (_ftpComponentIds.contains(message.compid) || _paramCountMap.contains(message.compid)) {
+        return;
+    }
+
+    qCDebug(ParameterManagerLog) << _logVehiclePrefix(message.compid) << "Component found during FTP parameter load";
+    _ftpComponentIds.insert(message.compid);
+    if (_loadSource == LoadSourceFTP) {
+        // Parameter file is already loaded
+        if (!_initialLoadComplete) {
+            _ftpWaitingComponentIds.insert(message.compid);
+        }
+        _ftpRequestComponent(message.compid);
+    }
+}
+
+void ParameterManager::_ftpRequestComponent(int componentId)
+{
+    qCDebug(ParameterManagerLog) << _logVehiclePrefix(componentId) << "Requesting parameters not covered by FTP load";
+    refreshAllParameters(static_cast<uint8_t>(componentId));
+}
+
 QString ParameterManager::parameterMetaDataFile(Vehicle* vehicle, MAV_AUTOPILOT firmwareType, int wantedMajorVersion, int& majorVersion, int& minorVersion)
 {
     bool            cacheHit = false;
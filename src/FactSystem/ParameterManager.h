@@ -16,17 +16,23 @@
 #include <QMutex>
 #include <QDir>
 #include <QJsonObject>
+#include <QElapsedTimer>
+#include <QSet>
 
 #include "FactSystem.h"
 #include "MAVLinkProtocol.h"
 #include "AutoPilotPlugin.h"
 #include "QGCMAVLink.h"
 #include "Vehicle.h"
+#include "ParameterCache.h"
+#include "ParameterRequestScheduler.h"
 
 Q_DECLARE_LOGGING_CATEGORY(ParameterManagerVerbose1Log)
 Q_DECLARE_LOGGING_CATEGORY(ParameterManagerVerbose2Log)
 Q_DECLARE_LOGGING_CATEGORY(ParameterManagerDebugCacheFailureLog)
 
+class ParameterFTPLoader;
+
 class ParameterManager : public QObject
 {
     Q_OBJECT
@@ -39,10 +45,28 @@ public:
     Q_PROPERTY(bool     parametersReady     READ parametersReady    NOTIFY parametersReadyChanged)      ///< true: Parameters are ready for use
     Q_PROPERTY(bool     missingParameters   READ missingParameters  NOTIFY missingParametersChanged)    ///< true: Parameters are missing from firmware response, false: all parameters received from firmware
     Q_PROPERTY(double   loadProgress        READ loadProgress       NOTIFY loadProgressChanged)
+    Q_PROPERTY(int      receivedCount       READ receivedCount      NOTIFY loadStatsChanged)        ///< PARAM_VALUE messages received from the vehicle
+    Q_PROPERTY(int      requestCount        READ requestCount       NOTIFY loadStatsChanged)        ///< Parameter re-requests sent to the vehicle
+    Q_PROPERTY(int      requestWindow       READ requestWindow      NOTIFY loadStatsChanged)        ///< Re-requests allowed to be outstanding
+    Q_PROPERTY(double   paramsPerSecond     READ paramsPerSecond    NOTIFY loadStatsChanged)
 
     bool parametersReady    (void) const { return _parametersReady; }
     bool missingParameters  (void) const { return _missingParameters; }
     double loadProgress     (void) const { return _loadProgress; }
+    int    receivedCount    (void) const { return _requestScheduler.receivedCount(); }
+    int    requestCount     (void) const { return _requestScheduler.requestCount(); }
+    int    requestWindow    (void) const { return _requestScheduler.window(); }
+    double paramsPerSecond  (void) const { return _requestScheduler.paramsPerSecond(_loadTimer.elapsed()); }
+
+    /// Where the initial parameter set came from
+    typedef enum {
+        LoadSourceStream,   ///< PARAM_VALUE messages requested with PARAM_REQUEST_LIST
+        LoadSourceCache,    ///< Local parameter cache matching the vehicle parameter hash
+        LoadSourceFTP,      ///< Packed parameter file downloaded with MAVLink FTP
+    } LoadSource_t;
+
+    LoadSource_t    loadSource      (void) const { return _loadSource; }
+    int             loadTimeMSecs   (void) const { return _loadTimeMSecs; }     ///< Time from creation to parameters ready, -1 if not ready yet
 
     /// @return Directory of parameter caches
     static QDir parameterCacheDir();
@@ -114,16 +138,21 @@ signals:
     void parametersReadyChanged(bool parametersReady);
     void missingParametersChanged(bool missingParameters);
     void loadProgressChanged(float value);
+    void loadStatsChanged(void);
     
 protected:
     Vehicle*            _vehicle;
     MAVLinkProtocol*    _mavlink;
     
     void _parameterUpdate(int vehicleId, int componentId, QString parameterName, int parameterCount, int parameterId, int mavType, QVariant value);
+    void _vehicleParameterUpdate(int vehicleId, int componentId, QString parameterName, int parameterCount, int parameterId, int mavType, QVariant value);
     void _valueUpdated(const QVariant& value);
     void _waitingParamTimeout(void);
     void _tryCacheLookup(void);
     void _initialRequestTimeout(void);
+    void _ftpLoadComplete(const QList<ParameterCache::Param_t>& params);
+    void _ftpLoadFailed(const QString& errorString);
+    void _ftpMavlinkMessageReceived(const mavlink_message_t& message);
 
 private:
     static QVariant _stringToTypedVariant(const QString& string, FactMetaData::ValueType_t type, bool failOk = false);
@@ -134,13 +163,14 @@ private:
     void _writeLocalParamCache(int vehicleId, int componentId);
     void _tryCacheHashLoad(int vehicleId, int componentId, QVariant hash_value);
     void _loadMetaData(void);
-    void _clearMetaData(void);
     void _addMetaDataToDefaultComponent(void);
     QString _remapParamNameToVersion(const QString& paramName);
     void _loadOfflineEditingParams(void);
     QString _logVehiclePrefix(int componentId = -1);
     void _setLoadProgress(double loadProgress);
     bool _fillIndexBatchQueue(bool waitingParamTimeout);
+    void _updateRequestSchedulerLink(void);
+    void _ftpRequestComponent(int componentId);
 
     MAV_PARAM_TYPE _factTypeToMavType(FactMetaData::ValueType_t factType);
     FactMetaData::ValueType_t _mavTypeToFactType(MAV_PARAM_TYPE mavType);
@@ -164,6 +194,12 @@ private:
     QString     _versionParam;                  ///< Parameter which contains parameter set version
     int         _parameterSetMajorVersion;      ///< Version for parameter set, -1 if not known
     QObject*    _parameterMetaData;             ///< Opaque data from FirmwarePlugin::loadParameterMetaDataCall
+    ParameterFTPLoader* _ftpLoader;             ///< Non-NULL while the initial load uses MAVLink FTP
+    QSet<int>       _ftpComponentIds;           ///< Components other than the default one heard from while loading with FTP
+    QSet<int>       _ftpWaitingComponentIds;    ///< Components the initial load waits on for a first parameter after an FTP load
+    LoadSource_t    _loadSource;
+    QElapsedTimer   _loadTimer;                 ///< Time since creation, used for load time metrics
+    int             _loadTimeMSecs;
 
     typedef QPair<int /* FactMetaData::ValueType_t */, QVariant /* Fact::rawValue */> ParamTypeVal;
     typedef QMap<QString /* parameter name */, ParamTypeVal> CacheMapName2ParamTypeVal;
@@ -186,6 +222,8 @@ private:
     bool        _indexBatchQueueActive; ///< true: we are actively batching re-requests for missing index base params, false: index based re-request has not yet started
     QList<int>  _indexBatchQueue;       ///< The current queue of index re-requests
 
+    ParameterRequestScheduler _requestScheduler;    ///< Sizes re-request batches from link bandwidth, loss and responses
+
     QMap<int, int>                  _paramCountMap;             ///< Key: Component id, Value: count of parameters in this component
     QMap<int, QMap<int, int> >      _waitingReadParamIndexMap;  ///< Key: Component id, Value: Map { Key: parameter index still waiting for, Value: retry count }
     QMap<int, QMap<QString, int> >  _waitingReadParamNameMap;   ///< Key: Component id, Value: Map { Key: parameter name still waiting for, Value: retry count }
@@ -12,6 +12,16 @@
 #include "MultiVehicleManager.h"
 #include "QGCApplication.h"
 #include "ParameterManager.h"
+#include "SettingsManager.h"
+#include "AppSettings.h"
+
+void ParameterManagerTest::cleanup(void)
+{
+    Fact* parameterDownloadFTP = qgcApp()->toolbox()->settingsManager()->appSettings()->parameterDownloadFTP();
+    parameterDownloadFTP->setRawValue(parameterDownloadFTP->rawDefaultValue());
+
+    UnitTest::cleanup();
+}
 
 /// Test failure modes which should still lead to param load success
 void ParameterManagerTest::_noFailureWorker(MockConfiguration::FailureMode_t failureMode)
@@ -138,3 +148,39 @@ void ParameterManagerTest::_requestListMissingParamFail(void)
     // User should have been notified
     checkExpectedMessageBox();
 }
+
+// The autopilot parameters are loaded as a single file over MAVLink FTP instead of being streamed
+void ParameterManagerTest::_ftpLoad(void)
+{
+    qgcApp()->toolbox()->settingsManager()->appSettings()->parameterDownloadFTP()->setRawValue(true);
+
+    Q_ASSERT(!_mockLink);
+    _mockLink = MockLink::startAPMArduCopterMockLink(false);
+
+    MultiVehicleManager* vehicleMgr = qgcApp()->toolbox()->multiVehicleManager();
+    QVERIFY(vehicleMgr);
+
+    // Wait for the Vehicle to get created
+    QSignalSpy spyVehicle(vehicleMgr, SIGNAL(activeVehicleAvailableChanged(bool)));
+    QCOMPARE(spyVehicle.wait(5000), true);
+    Vehicle* vehicle = vehicleMgr->activeVehicle();
+    QVERIFY(vehicle);
+    ParameterManager* paramMgr = vehicle->parameterManager();
+
+    QSignalSpy spyParamsReady(paramMgr, SIGNAL(parametersReadyChanged(bool)));
+    if (!paramMgr->parametersReady()) {
+        QCOMPARE(spyParamsReady.wait(20000), true);
+    }
+    QCOMPARE(paramMgr->missingParameters(), false);
+
+    // Load metrics
+    QCOMPARE(paramMgr->loadSource(), ParameterManager::LoadSourceFTP);
+    QVERIFY(paramMgr->loadTimeMSecs() >= 0);
+
+    // Values of each packed type come through
+    int componentId = vehicle->defaultComponentId();
+    QCOMPARE(paramMgr->getParameter(componentId, "BRD_IMU_TARGTEMP")->rawValue().toInt(), -1);
+    QCOMPARE(paramMgr->getParameter(componentId, "SYSID_THISMAV")->rawValue().toInt(), 1);
+    QCOMPARE(paramMgr->getParameter(componentId, "BATT_CAPACITY")->rawValue().toInt(), 5100);
+    QCOMPARE(paramMgr->getParameter(componentId, "ACCEL_Z_IMAX")->rawValue().toFloat(), 800.0f);
+}
@@ -21,10 +21,13 @@ class ParameterManagerTest : public UnitTest
     Q_OBJECT
     
 private slots:
+    void cleanup(void);
+
     void _noFailure(void);
     void _requestListNoResponse(void);
     void _requestListMissingParamSuccess(void);
     void _requestListMissingParamFail(void);
+    void _ftpLoad(void);
 
 private:
     void _noFailureWorker(MockConfiguration::FailureMode_t failureMode);
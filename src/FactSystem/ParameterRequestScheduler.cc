@@ -0,0 +1,132 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterRequestScheduler.h"
+
+ParameterRequestScheduler::ParameterRequestScheduler(void)
+    : _availableBytesPerSecond  (0)
+    , _lossPercent              (0)
+{
+    reset();
+}
+
+void ParameterRequestScheduler::reset(void)
+{
+    _window                 = initialWindow;
+    _slowStartThreshold     = maxWindow;
+    _requestCount           = 0;
+    _timeoutCount           = 0;
+    _receivedCount          = 0;
+    _rateIntervalStartMSecs = -1;
+    _rateIntervalCount      = 0;
+    _paramsPerSecond        = 0;
+}
+
+void ParameterRequestScheduler::setLinkRate(qint64 nominalBitsPerSecond, qint64 inputBitsPerSecond)
+{
+    if (nominalBitsPerSecond <= 0) {
+        _availableBytesPerSecond = 0;
+        return;
+    }
+
+    // Other traffic shares the link. Without a measurement assume half of it is free, with one never plan on less than
+    // a quarter since the measurement includes the parameter traffic itself.
+    qint64 availableBitsPerSecond;
+    if (inputBitsPerSecond > 0) {
+        availableBitsPerSecond = qMax(nominalBitsPerSecond - inputBitsPerSecond, nominalBitsPerSecond / 4);
+    } else {
+        availableBitsPerSecond = nominalBitsPerSecond / 2;
+    }
+    _availableBytesPerSecond = availableBitsPerSecond / 8;
+}
+
+void ParameterRequestScheduler::setLossPercent(double lossPercent)
+{
+    _lossPercent = qBound(0.0, lossPercent, 100.0);
+}
+
+int ParameterRequestScheduler::linkWindow(void) const
+{
+    double window = maxWindow;
+
+    if (_availableBytesPerSecond > 0) {
+        window = (static_cast<double>(_availableBytesPerSecond) * linkWindowMSecs) / (1000.0 * paramValueBytes);
+    }
+
+    // Every lost response costs a full timeout, so send less into a lossy link
+    window *= (100.0 - _lossPercent) / 100.0;
+
+    return qBound(minWindow, static_cast<int>(window), maxWindow);
+}
+
+int ParameterRequestScheduler::window(void) const
+{
+    return qBound(minWindow, qMin(static_cast<int>(_window), linkWindow()), maxWindow);
+}
+
+void ParameterRequestScheduler::requestSent(void)
+{
+    _requestCount++;
+}
+
+void ParameterRequestScheduler::responseReceived(void)
+{
+    if (_window < _slowStartThreshold) {
+        _window += 1;
+    } else {
+        _window += 1.0 / _window;
+    }
+
+    // Don't let the window run away past what the link allows, it would take many timeouts to bring it back
+    _window = qMin(_window, static_cast<double>(linkWindow()));
+}
+
+void ParameterRequestScheduler::requestTimeout(void)
+{
+    _timeoutCount++;
+    _slowStartThreshold = qMax(static_cast<double>(minWindow), _window / 2);
+    _window = _slowStartThreshold;
+}
+
+void ParameterRequestScheduler::paramReceived(qint64 nowMSecs)
+{
+    _receivedCount++;
+
+    if (_rateIntervalStartMSecs < 0) {
+        _rateIntervalStartMSecs = nowMSecs;
+    }
+
+    qint64 elapsedMSecs = nowMSecs - _rateIntervalStartMSecs;
+    if (elapsedMSecs >= rateIntervalMSecs) {
+        double intervalRate = (_rateIntervalCount * 1000.0) / elapsedMSecs;
+        _paramsPerSecond = _paramsPerSecond == 0 ? intervalRate : (_paramsPerSecond + intervalRate) / 2;
+        _rateIntervalStartMSecs = nowMSecs;
+        _rateIntervalCount = 0;
+    }
+    _rateIntervalCount++;
+}
+
+double ParameterRequestScheduler::paramsPerSecond(qint64 nowMSecs) const
+{
+    if (_rateIntervalStartMSecs < 0) {
+        return 0;
+    }
+
+    qint64 elapsedMSecs = nowMSecs - _rateIntervalStartMSecs;
+    if (_paramsPerSecond == 0 && elapsedMSecs > 0) {
+        // No full interval yet
+        return (_rateIntervalCount * 1000.0) / qMax(elapsedMSecs, static_cast<qint64>(rateIntervalMSecs));
+    }
+    if (elapsedMSecs > 2 * rateIntervalMSecs) {
+        // Stalled, fold the time since the last parameter in
+        return (_paramsPerSecond + ((_rateIntervalCount * 1000.0) / elapsedMSecs)) / 2;
+    }
+
+    return _paramsPerSecond;
+}
@@ -0,0 +1,75 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QtGlobal>
+
+/// Decides how many parameter re-requests can be outstanding at once and keeps load statistics.
+///
+/// The window grows while requested parameters come back and is halved when a batch times out, the same additive
+/// increase / multiplicative decrease scheme TCP uses. It is also capped by what the link can carry: the share of the
+/// link bandwidth which is not already used by other traffic, reduced by the measured message loss. That way a slow
+/// radio isn't flooded with requests it can't answer and a fast link isn't left idle waiting on small batches.
+class ParameterRequestScheduler
+{
+public:
+    ParameterRequestScheduler(void);
+
+    /// Resets the window and statistics for a new load
+    void reset(void);
+
+    /// Sets the link bandwidth available for parameter traffic
+    ///     @param nominalBitsPerSecond Maximum link speed, 0 if unknown
+    ///     @param inputBitsPerSecond Measured incoming data rate, 0 if unknown
+    void setLinkRate(qint64 nominalBitsPerSecond, qint64 inputBitsPerSecond);
+
+    /// Sets the message loss measured on the link
+    void setLossPercent(double lossPercent);
+
+    /// @return Number of requests which can be outstanding
+    int window(void) const;
+
+    /// @return Upper bound for the window from link bandwidth and loss
+    int linkWindow(void) const;
+
+    void requestSent        (void);                 ///< A parameter was requested
+    void responseReceived   (void);                 ///< A requested parameter arrived
+    void requestTimeout     (void);                 ///< Outstanding requests timed out
+    void paramReceived      (qint64 nowMSecs);      ///< Any parameter arrived from the vehicle
+
+    int     requestCount    (void) const { return _requestCount; }
+    int     timeoutCount    (void) const { return _timeoutCount; }
+    int     receivedCount   (void) const { return _receivedCount; }
+
+    /// @return Parameters received per second, averaged over the last few seconds
+    double  paramsPerSecond (qint64 nowMSecs) const;
+
+    static const int minWindow =        1;
+    static const int maxWindow =        64;
+    static const int initialWindow =    10;
+
+    static const int paramValueBytes =      37;     ///< PARAM_VALUE on the wire with MAVLink 2 framing
+    static const int linkWindowMSecs =      1000;   ///< Link time a full window of responses may use
+    static const int rateIntervalMSecs =    1000;   ///< Interval for throughput samples
+
+private:
+    double  _window;
+    double  _slowStartThreshold;
+    qint64  _availableBytesPerSecond;
+    double  _lossPercent;
+
+    int     _requestCount;
+    int     _timeoutCount;
+    int     _receivedCount;
+
+    qint64  _rateIntervalStartMSecs;
+    int     _rateIntervalCount;
+    double  _paramsPerSecond;
+};
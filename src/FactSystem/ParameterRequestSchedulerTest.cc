@@ -0,0 +1,120 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ParameterRequestSchedulerTest.h"
+#include "ParameterRequestScheduler.h"
+
+void ParameterRequestSchedulerTest::_testGrowAndShrink(void)
+{
+    ParameterRequestScheduler scheduler;
+
+    QCOMPARE(scheduler.window(), static_cast<int>(ParameterRequestScheduler::initialWindow));
+
+    // Slow start: one more slot per response
+    for (int i=0; i<5; i++) {
+        scheduler.responseReceived();
+    }
+    QCOMPARE(scheduler.window(), ParameterRequestScheduler::initialWindow + 5);
+
+    // Timeout halves the window
+    scheduler.requestTimeout();
+    QCOMPARE(scheduler.window(), (ParameterRequestScheduler::initialWindow + 5) / 2);
+    QCOMPARE(scheduler.timeoutCount(), 1);
+
+    // After a timeout the window grows by about one slot per window of responses
+    int window = scheduler.window();
+    for (int i=0; i<window; i++) {
+        scheduler.responseReceived();
+    }
+    QCOMPARE(scheduler.window(), window + 1);
+
+    // Never below the minimum, never above the maximum
+    for (int i=0; i<20; i++) {
+        scheduler.requestTimeout();
+    }
+    QCOMPARE(scheduler.window(), static_cast<int>(ParameterRequestScheduler::minWindow));
+
+    scheduler.reset();
+    for (int i=0; i<1000; i++) {
+        scheduler.responseReceived();
+    }
+    QCOMPARE(scheduler.window(), static_cast<int>(ParameterRequestScheduler::maxWindow));
+    QCOMPARE(scheduler.timeoutCount(), 0);
+}
+
+void ParameterRequestSchedulerTest::_testLinkWindow(void)
+{
+    ParameterRequestScheduler scheduler;
+
+    // Unknown link speed doesn't limit the window
+    QCOMPARE(scheduler.linkWindow(), static_cast<int>(ParameterRequestScheduler::maxWindow));
+
+    // 9600 baud radio with no rate measurement: half of 1200 bytes/sec over one second is 16 PARAM_VALUEs
+    scheduler.setLinkRate(9600, 0);
+    QCOMPARE(scheduler.linkWindow(), 600 / ParameterRequestScheduler::paramValueBytes);
+
+    // Busy link leaves less room, but never less than a quarter
+    scheduler.setLinkRate(9600, 7200);
+    QCOMPARE(scheduler.linkWindow(), 300 / ParameterRequestScheduler::paramValueBytes);
+    scheduler.setLinkRate(9600, 9600);
+    QCOMPARE(scheduler.linkWindow(), 300 / ParameterRequestScheduler::paramValueBytes);
+
+    // Window growth stops at the link window
+    for (int i=0; i<100; i++) {
+        scheduler.responseReceived();
+    }
+    QCOMPARE(scheduler.window(), scheduler.linkWindow());
+
+    // Fast link is capped at the maximum
+    scheduler.setLinkRate(100000000, 0);
+    QCOMPARE(scheduler.linkWindow(), static_cast<int>(ParameterRequestScheduler::maxWindow));
+}
+
+void ParameterRequestSchedulerTest::_testLossWindow(void)
+{
+    ParameterRequestScheduler scheduler;
+
+    scheduler.setLinkRate(19200, 0);
+    int lossFreeWindow = scheduler.linkWindow();
+
+    scheduler.setLossPercent(50);
+    QCOMPARE(scheduler.linkWindow(), static_cast<int>(lossFreeWindow * 0.5));
+
+    scheduler.setLossPercent(100);
+    QCOMPARE(scheduler.linkWindow(), static_cast<int>(ParameterRequestScheduler::minWindow));
+    QCOMPARE(scheduler.window(), static_cast<int>(ParameterRequestScheduler::minWindow));
+}
+
+void ParameterRequestSchedulerTest::_testThroughput(void)
+{
+    ParameterRequestScheduler scheduler;
+
+    QCOMPARE(scheduler.paramsPerSecond(0), 0.0);
+
+    // 50 params/sec for three seconds
+    qint64 nowMSecs = 0;
+    for (int i=0; i<150; i++) {
+        scheduler.paramReceived(nowMSecs);
+        nowMSecs += 20;
+    }
+    QCOMPARE(scheduler.receivedCount(), 150);
+    QVERIFY(qAbs(scheduler.paramsPerSecond(nowMSecs) - 50.0) < 2.0);
+
+    // Rate falls off once parameters stop arriving
+    QVERIFY(scheduler.paramsPerSecond(nowMSecs + 10000) < 30.0);
+
+    scheduler.requestSent();
+    scheduler.requestSent();
+    QCOMPARE(scheduler.requestCount(), 2);
+
+    scheduler.reset();
+    QCOMPARE(scheduler.receivedCount(), 0);
+    QCOMPARE(scheduler.requestCount(), 0);
+    QCOMPARE(scheduler.paramsPerSecond(nowMSecs), 0.0);
+}
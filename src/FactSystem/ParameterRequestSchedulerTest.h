@@ -0,0 +1,24 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit test for ParameterRequestScheduler window sizing and statistics
+class ParameterRequestSchedulerTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testGrowAndShrink(void);
+    void _testLinkWindow(void);
+    void _testLossWindow(void);
+    void _testThroughput(void);
+};
@@ -191,18 +191,30 @@ FlightMap {
         property real leftToolWidth:    toolStrip.x + toolStrip.width
     }
 
-    // Add trajectory points to the map
-    MapItemView {
-        model: _mainIsMap ? _activeVehicle ? _activeVehicle.trajectoryPoints : 0 : 0
-
-        delegate: MapPolyline {
-            line.width: 3
-            line.color: "red"
-            z:          QGroundControl.zOrderTrajectoryLines
-            path: [
-                object.coordinate1,
-                object.coordinate2,
-            ]
+    // Add the trajectory to the map, simplified for the current zoom level
+    MapPolyline {
+        id:         trajectoryPolyline
+        line.width: 3
+        line.color: "red"
+        z:          QGroundControl.zOrderTrajectoryLines
+        visible:    _mainIsMap
+
+        property var _trajectory: _mainIsMap && _activeVehicle ? _activeVehicle.trajectory : null
+
+        // New points are added to the end of the polyline, the whole path is only set again when the trajectory rebuilds it
+        on_TrajectoryChanged: path = _trajectory ? _trajectory.path : []
+
+        Connections {
+            target:         trajectoryPolyline._trajectory
+            onPathChanged:  trajectoryPolyline.path = trajectoryPolyline._trajectory.path
+            onPointAdded:   trajectoryPolyline.addCoordinate(coordinate)
+        }
+
+        Binding {
+            target:     _activeVehicle ? _activeVehicle.trajectory : null
+            property:   "zoomLevel"
+            value:      flightMap.zoomLevel
+            when:       _mainIsMap
         }
     }
 
@@ -61,6 +61,7 @@ VideoManager::setToolbox(QGCToolbox *toolbox)
    connect(_videoSettings->udpPort(),       &Fact::rawValueChanged, this, &VideoManager::_udpPortChanged);
    connect(_videoSettings->rtspUrl(),       &Fact::rawValueChanged, this, &VideoManager::_rtspUrlChanged);
    connect(_videoSettings->tcpUrl(),        &Fact::rawValueChanged, this, &VideoManager::_tcpUrlChanged);
+   connect(_videoSettings->lowLatencyMode(),&Fact::rawValueChanged, this, &VideoManager::_lowLatencyModeChanged);
 
 #if defined(QGC_GST_STREAMING)
 #ifndef QGC_DISABLE_UVC
@@ -119,6 +120,13 @@ VideoManager::_tcpUrlChanged()
     _restartVideo();
 }
 
+//-----------------------------------------------------------------------------
+void
+VideoManager::_lowLatencyModeChanged()
+{
+    _restartVideo();
+}
+
 //-----------------------------------------------------------------------------
 bool
 VideoManager::hasVideo()
@@ -48,6 +48,7 @@ void GPSManager::connectGPS(const QString& device, const QString& gps_type)
     _rtcmMavlink = new RTCMMavlink(*_toolbox);
 
     connect(_gpsProvider, &GPSProvider::RTCMDataUpdate, _rtcmMavlink, &RTCMMavlink::RTCMDataUpdate);
+    emit rtcmMavlinkChanged();
 
     //test: connect to position update
     connect(_gpsProvider, &GPSProvider::positionUpdate, this, &GPSManager::GPSPositionUpdate);
@@ -68,11 +69,12 @@ void GPSManager::disconnectGPS(void)
         }
         delete(_gpsProvider);
     }
+    _gpsProvider = NULL;
     if (_rtcmMavlink) {
         delete(_rtcmMavlink);
+        _rtcmMavlink = NULL;
+        emit rtcmMavlinkChanged();
     }
-    _gpsProvider = NULL;
-    _rtcmMavlink = NULL;
 }
 
 
@@ -28,15 +28,21 @@ public:
     GPSManager(QGCApplication* app, QGCToolbox* toolbox);
     ~GPSManager();
 
+    Q_PROPERTY(RTCMMavlink* rtcmMavlink READ rtcmMavlink NOTIFY rtcmMavlinkChanged)
+
     void connectGPS     (const QString& device, const QString& gps_type);
     void disconnectGPS  (void);
     bool connected      (void) const { return _gpsProvider && _gpsProvider->isRunning(); }
 
+    /// @return Correction injection statistics, NULL while no GPS is connected
+    RTCMMavlink* rtcmMavlink(void) { return _rtcmMavlink; }
+
 signals:
     void onConnect();
     void onDisconnect();
     void surveyInStatus(float duration, float accuracyMM, bool valid, bool active);
     void satelliteUpdate(int numSats);
+    void rtcmMavlinkChanged(void);
 
 private slots:
     void GPSPositionUpdate(GPSPositionMessage msg);
@@ -12,37 +12,84 @@
 
 #include "MultiVehicleManager.h"
 #include "Vehicle.h"
-
-#include <cstdio>
+#include "SettingsManager.h"
+#include "QGCLoggingCategory.h"
 
 RTCMMavlink::RTCMMavlink(QGCToolbox& toolbox)
     : _toolbox(toolbox)
 {
-    _bandwidthTimer.start();
+    Fact* bandwidthLimitFact = _toolbox.settingsManager()->rtkSettings()->correctionBandwidthLimit();
+    setBandwidthLimit(bandwidthLimitFact->rawValue().toInt());
+    connect(bandwidthLimitFact, &Fact::rawValueChanged, this, &RTCMMavlink::_bandwidthLimitChanged);
+
+    _sendTimer.setInterval(_sendIntervalMSecs);
+    connect(&_sendTimer, &QTimer::timeout, this, &RTCMMavlink::_sendPending);
+
+    _statisticsTimer.setInterval(_statisticsIntervalMSecs);
+    connect(&_statisticsTimer, &QTimer::timeout, this, &RTCMMavlink::_updateStatistics);
+    _statisticsTimer.start();
+    _statisticsIntervalTimer.start();
+}
+
+void RTCMMavlink::setBandwidthLimit(int bytesPerSecond)
+{
+    _bandwidthLimit = qMax(0, bytesPerSecond);
+    _tokens = 0;
+    _tokenTimer.start();
+}
+
+void RTCMMavlink::_bandwidthLimitChanged(QVariant value)
+{
+    setBandwidthLimit(value.toInt());
+}
+
+int RTCMMavlink::wireBytes(const mavlink_gps_rtcm_data_t& fragment)
+{
+    // flags and len fields followed by the data
+    return MAVLINK_NUM_NON_PAYLOAD_BYTES + 2 + fragment.len;
 }
 
 void RTCMMavlink::RTCMDataUpdate(QByteArray message)
 {
-    /* statistics */
-    _bandwidthByteCounter += message.size();
-    qint64 elapsed = _bandwidthTimer.elapsed();
-    if (elapsed > 1000) {
-        printf("RTCM bandwidth: %.2f kB/s\n", (float) _bandwidthByteCounter / elapsed * 1000.f / 1024.f);
-        _bandwidthTimer.restart();
-        _bandwidthByteCounter = 0;
+    _inputByteCounter += message.size();
+
+    RTCMMessage_t rtcmMessage;
+    if (_fragment(message, rtcmMessage)) {
+        _pendingMessages.enqueue(rtcmMessage);
+        _pendingBytes += rtcmMessage.bytes;
+        if (_bandwidthLimit > 0) {
+            _dropStaleMessages();
+        }
+    } else {
+        qCWarning(RTKGPSLog) << "RTCM message too large to send" << message.size();
+        _droppedMessages++;
     }
+    ++_sequenceId;
+
+    _sendPending();
+}
 
+/// Splits an RTCM message into GPS_RTCM_DATA payloads
+/// @return false: message needs more fragments than the receiver can reassemble
+bool RTCMMavlink::_fragment(const QByteArray& message, RTCMMessage_t& rtcmMessage)
+{
     const int maxMessageLength = MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN;
     mavlink_gps_rtcm_data_t mavlinkRtcmData;
     memset(&mavlinkRtcmData, 0, sizeof(mavlink_gps_rtcm_data_t));
 
+    rtcmMessage.nextFragment = 0;
+    rtcmMessage.bytes = 0;
+
     if (message.size() < maxMessageLength) {
         mavlinkRtcmData.len = message.size();
         mavlinkRtcmData.flags = (_sequenceId & 0x1F) << 3;
         memcpy(&mavlinkRtcmData.data, message.data(), message.size());
-        sendMessageToVehicle(mavlinkRtcmData);
+        rtcmMessage.fragments.append(mavlinkRtcmData);
     } else {
         // We need to fragment
+        if ((message.size() + maxMessageLength - 1) / maxMessageLength > _maxFragments) {
+            return false;
+        }
 
         uint8_t fragmentId = 0;         // Fragment id indicates the fragment within a set
         int start = 0;
@@ -53,25 +100,146 @@ void RTCMMavlink::RTCMDataUpdate(QByteArray message)
             mavlinkRtcmData.flags |= (_sequenceId & 0x1F) << 3;     // Next 5 bits are sequence id
             mavlinkRtcmData.len = length;
             memcpy(&mavlinkRtcmData.data, message.data() + start, length);
-            sendMessageToVehicle(mavlinkRtcmData);
+            rtcmMessage.fragments.append(mavlinkRtcmData);
             start += length;
         }
     }
-    ++_sequenceId;
+
+    foreach (const mavlink_gps_rtcm_data_t& fragment, rtcmMessage.fragments) {
+        rtcmMessage.bytes += wireBytes(fragment);
+    }
+
+    return true;
 }
 
-void RTCMMavlink::sendMessageToVehicle(const mavlink_gps_rtcm_data_t& msg)
+/// Drops the oldest corrections which can't be sent within _maxLatencyMSecs at the current bandwidth limit. A message
+/// which is partially sent is always finished, the vehicle can't use the fragments it already has otherwise.
+void RTCMMavlink::_dropStaleMessages(void)
 {
+    int maxPendingBytes = (_bandwidthLimit * _maxLatencyMSecs) / 1000;
+    int index = !_pendingMessages.isEmpty() && _pendingMessages.head().nextFragment != 0 ? 1 : 0;
+
+    while (_pendingBytes > maxPendingBytes && index < _pendingMessages.count()) {
+        _pendingBytes -= _pendingMessages[index].bytes;
+        _pendingMessages.removeAt(index);
+        _droppedMessages++;
+    }
+}
+
+void RTCMMavlink::_refillTokens(qint64 elapsedMSecs)
+{
+    // Always allow enough for the largest fragment, otherwise a very low limit would never send anything
+    double maxTokens = qMax((_bandwidthLimit * _burstMSecs) / 1000.0, static_cast<double>(MAVLINK_NUM_NON_PAYLOAD_BYTES + 2 + MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN));
+    _tokens = qMin(_tokens + ((elapsedMSecs * _bandwidthLimit) / 1000.0), maxTokens);
+}
+
+/// @return One vehicle for each link corrections should go out on
+QList<RTCMMavlink::Target_t> RTCMMavlink::_targets(void)
+{
+    QList<Target_t> targets;
     QmlObjectListModel& vehicles = *_toolbox.multiVehicleManager()->vehicles();
-    MAVLinkProtocol* mavlinkProtocol = _toolbox.mavlinkProtocol();
+
     for (int i = 0; i < vehicles.count(); i++) {
         Vehicle* vehicle = qobject_cast<Vehicle*>(vehicles[i]);
+        LinkInterface* link = vehicle->priorityLink();
+
+        // No point in pushing corrections through a high latency link
+        if (!link || link->highLatency()) {
+            continue;
+        }
+
+        bool sharedLink = false;
+        foreach (const Target_t& target, targets) {
+            if (target.link == link) {
+                sharedLink = true;
+                break;
+            }
+        }
+        if (!sharedLink) {
+            Target_t target = { vehicle, link };
+            targets.append(target);
+        }
+    }
+
+    return targets;
+}
+
+void RTCMMavlink::_sendFragment(const QList<Target_t>& targets, const mavlink_gps_rtcm_data_t& fragment)
+{
+    MAVLinkProtocol* mavlinkProtocol = _toolbox.mavlinkProtocol();
+
+    foreach (const Target_t& target, targets) {
         mavlink_message_t message;
         mavlink_msg_gps_rtcm_data_encode_chan(mavlinkProtocol->getSystemId(),
                                               mavlinkProtocol->getComponentId(),
-                                              vehicle->priorityLink()->mavlinkChannel(),
+                                              target.link->mavlinkChannel(),
                                               &message,
-                                              &msg);
-        vehicle->sendMessageOnLink(vehicle->priorityLink(), message);
+                                              &fragment);
+        target.vehicle->sendMessageOnLink(target.link, message);
+    }
+    _outputByteCounter += wireBytes(fragment);
+}
+
+void RTCMMavlink::_sendPending(void)
+{
+    QList<Target_t> targets = _targets();
+
+    if (targets.isEmpty()) {
+        // Nobody to send to, holding on to corrections would only make them stale
+        _droppedMessages += _pendingMessages.count();
+        _pendingMessages.clear();
+        _pendingBytes = 0;
     }
+
+    if (_bandwidthLimit > 0) {
+        _refillTokens(_tokenTimer.restart());
+    }
+
+    while (!_pendingMessages.isEmpty()) {
+        RTCMMessage_t& rtcmMessage = _pendingMessages.head();
+        const mavlink_gps_rtcm_data_t& fragment = rtcmMessage.fragments[rtcmMessage.nextFragment];
+        int bytes = wireBytes(fragment);
+
+        if (_bandwidthLimit > 0) {
+            if (_tokens < bytes) {
+                break;
+            }
+            _tokens -= bytes;
+        }
+
+        _sendFragment(targets, fragment);
+        _pendingBytes -= bytes;
+        rtcmMessage.bytes -= bytes;
+        if (++rtcmMessage.nextFragment == rtcmMessage.fragments.count()) {
+            _pendingMessages.dequeue();
+        }
+    }
+
+    if (_pendingMessages.isEmpty()) {
+        _sendTimer.stop();
+    } else if (!_sendTimer.isActive()) {
+        _sendTimer.start();
+    }
+}
+
+void RTCMMavlink::_updateStatistics(void)
+{
+    qint64 elapsedMSecs = _statisticsIntervalTimer.restart();
+    if (elapsedMSecs <= 0) {
+        return;
+    }
+
+    _inputBytesPerSecond = (_inputByteCounter * 1000.0) / elapsedMSecs;
+    _outputBytesPerSecond = (_outputByteCounter * 1000.0) / elapsedMSecs;
+    _linkCount = _targets().count();
+    _inputByteCounter = 0;
+    _outputByteCounter = 0;
+
+    qCDebug(RTKGPSLog) << "RTCM in(B/s)" << _inputBytesPerSecond
+                       << "out per link(B/s)" << _outputBytesPerSecond
+                       << "links" << _linkCount
+                       << "pending(bytes)" << _pendingBytes
+                       << "dropped messages" << _droppedMessages;
+
+    emit statisticsChanged();
 }
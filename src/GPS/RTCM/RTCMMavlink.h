@@ -12,13 +12,24 @@
 
 #include <QObject>
 #include <QElapsedTimer>
+#include <QQueue>
+#include <QVector>
+#include <QTimer>
 
 #include "QGCToolbox.h"
 #include "MAVLinkProtocol.h"
 
+class Vehicle;
+class LinkInterface;
+
 /**
  ** class RTCMMavlink
  * Receives RTCM updates and sends them via MAVLINK to the device
+ *
+ * Each RTCM message is fragmented once and every fragment is encoded once per link. GPS_RTCM_DATA is a broadcast
+ * message, so vehicles which share a link (for example a fleet behind one radio) receive a single copy. Output is
+ * paced to the correction bandwidth limit from the RTK settings, corrections which would arrive too late to be useful
+ * are dropped instead of backing up the link.
  */
 class RTCMMavlink : public QObject
 {
@@ -27,14 +38,78 @@ public:
     RTCMMavlink(QGCToolbox& toolbox);
     //TODO: API to select device(s)?
 
+    Q_PROPERTY(double   inputBytesPerSecond     READ inputBytesPerSecond    NOTIFY statisticsChanged)
+    Q_PROPERTY(double   outputBytesPerSecond    READ outputBytesPerSecond   NOTIFY statisticsChanged)
+    Q_PROPERTY(int      linkCount               READ linkCount              NOTIFY statisticsChanged)
+    Q_PROPERTY(int      pendingBytes            READ pendingBytes           NOTIFY statisticsChanged)
+    Q_PROPERTY(int      droppedMessages         READ droppedMessages        NOTIFY statisticsChanged)
+
+    double  inputBytesPerSecond (void) const { return _inputBytesPerSecond; }   ///< Correction data arriving from the base station
+    double  outputBytesPerSecond(void) const { return _outputBytesPerSecond; }  ///< Wire bytes sent on each link
+    int     linkCount           (void) const { return _linkCount; }             ///< Links corrections are sent on
+    int     pendingBytes        (void) const { return _pendingBytes; }          ///< Wire bytes waiting for bandwidth
+    int     droppedMessages     (void) const { return _droppedMessages; }       ///< RTCM messages which were never sent
+
+    /// Sets the bandwidth budget for correction data on each link
+    ///     @param bytesPerSecond 0 for no limit
+    void setBandwidthLimit(int bytesPerSecond);
+
+    /// @return Number of bytes a fragment takes on the wire
+    static int wireBytes(const mavlink_gps_rtcm_data_t& fragment);
+
 public slots:
     void RTCMDataUpdate(QByteArray message);
 
+signals:
+    void statisticsChanged(void);
+
+private slots:
+    void _sendPending           (void);
+    void _updateStatistics      (void);
+    void _bandwidthLimitChanged (QVariant value);
+
 private:
-    void sendMessageToVehicle(const mavlink_gps_rtcm_data_t& msg);
+    typedef struct {
+        QVector<mavlink_gps_rtcm_data_t>    fragments;
+        int                                 nextFragment;
+        int                                 bytes;          ///< Wire bytes of the fragments not sent yet
+    } RTCMMessage_t;
+
+    typedef struct {
+        Vehicle*        vehicle;    ///< Vehicle used to send on the link
+        LinkInterface*  link;
+    } Target_t;
+
+    bool            _fragment           (const QByteArray& message, RTCMMessage_t& rtcmMessage);
+    QList<Target_t> _targets            (void);
+    void            _sendFragment       (const QList<Target_t>& targets, const mavlink_gps_rtcm_data_t& fragment);
+    void            _dropStaleMessages  (void);
+    void            _refillTokens       (qint64 elapsedMSecs);
+
+    QGCToolbox&             _toolbox;
+    QQueue<RTCMMessage_t>   _pendingMessages;
+    QTimer                  _sendTimer;
+    QTimer                  _statisticsTimer;
+    QElapsedTimer           _tokenTimer;
+    QElapsedTimer           _statisticsIntervalTimer;
 
-    QGCToolbox& _toolbox;
-    QElapsedTimer _bandwidthTimer;
-    int _bandwidthByteCounter = 0;
+    int     _bandwidthLimit = 0;        ///< Bytes per second per link, 0 for no limit
+    double  _tokens = 0;                ///< Bytes which can be sent right now
     uint8_t _sequenceId = 0;
+
+    int     _inputByteCounter = 0;      ///< Bytes since the last statistics update
+    int     _outputByteCounter = 0;
+    double  _inputBytesPerSecond = 0;
+    double  _outputBytesPerSecond = 0;
+    int     _linkCount = 0;
+    int     _pendingBytes = 0;
+    int     _droppedMessages = 0;
+
+    static const int _maxFragments =            4;      ///< Fragment id is two bits
+    static const int _sendIntervalMSecs =       50;
+    static const int _burstMSecs =              250;    ///< Bandwidth which can be saved up while idle
+    static const int _maxLatencyMSecs =         2000;   ///< Older corrections are dropped while waiting for bandwidth
+    static const int _statisticsIntervalMSecs = 1000;
+
+    friend class RTCMMavlinkTest;
 };
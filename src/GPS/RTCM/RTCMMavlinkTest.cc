@@ -0,0 +1,137 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "RTCMMavlinkTest.h"
+#include "RTCMMavlink.h"
+#include "QGCApplication.h"
+
+#include <string.h>
+
+/// @return Wire bytes of a fragment carrying dataLength bytes of correction data
+int RTCMMavlinkTest::_wireBytes(int dataLength)
+{
+    mavlink_gps_rtcm_data_t fragment;
+
+    memset(&fragment, 0, sizeof(fragment));
+    fragment.len = static_cast<uint8_t>(dataLength);
+    return RTCMMavlink::wireBytes(fragment);
+}
+
+void RTCMMavlinkTest::_testTokenBucket(void)
+{
+    RTCMMavlink rtcm(*qgcApp()->toolbox());
+
+    // Changing the limit starts over with an empty bucket
+    rtcm.setBandwidthLimit(1000);
+    QCOMPARE(rtcm._tokens, 0.0);
+
+    rtcm._refillTokens(100);
+    QCOMPARE(rtcm._tokens, 100.0);
+
+    // Savings while idle are capped
+    rtcm._refillTokens(10000);
+    QCOMPARE(rtcm._tokens, (1000.0 * RTCMMavlink::_burstMSecs) / 1000.0);
+
+    // A very low limit can still save up for the largest fragment
+    rtcm.setBandwidthLimit(10);
+    rtcm._refillTokens(1000000);
+    QCOMPARE(rtcm._tokens, static_cast<double>(_wireBytes(MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN)));
+}
+
+void RTCMMavlinkTest::_testPacing(void)
+{
+    _connectMockLink(MAV_AUTOPILOT_PX4);
+
+    RTCMMavlink rtcm(*qgcApp()->toolbox());
+    const int messageBytes = _wireBytes(50);
+
+    // The bucket fills to at most one large fragment, which holds three of these messages but not four
+    rtcm.setBandwidthLimit(200);
+    QVERIFY(_wireBytes(MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN) < messageBytes * 4);
+    rtcm._tokens = 1000;
+    for (int i=0; i<4; i++) {
+        rtcm.RTCMDataUpdate(QByteArray(50, 'x'));
+    }
+    QCOMPARE(rtcm._outputByteCounter, messageBytes * 3);
+    QCOMPARE(rtcm._pendingBytes, messageBytes);
+    QCOMPARE(rtcm._pendingMessages.count(), 1);
+    QVERIFY(rtcm._sendTimer.isActive());
+
+    // Goes out once there is bandwidth for it
+    rtcm._tokens = messageBytes;
+    rtcm._sendPending();
+    QCOMPARE(rtcm._outputByteCounter, messageBytes * 4);
+    QCOMPARE(rtcm._pendingBytes, 0);
+    QVERIFY(!rtcm._sendTimer.isActive());
+    QCOMPARE(rtcm.droppedMessages(), 0);
+}
+
+void RTCMMavlinkTest::_testStaleDrop(void)
+{
+    _connectMockLink(MAV_AUTOPILOT_PX4);
+
+    RTCMMavlink rtcm(*qgcApp()->toolbox());
+    const int messageBytes = _wireBytes(50);
+    const int messageCount = 8;
+
+    // Nothing can be sent, only what goes out within the latency budget is kept
+    rtcm.setBandwidthLimit(200);
+    const int maxPendingBytes = (200 * RTCMMavlink::_maxLatencyMSecs) / 1000;
+    const int keptCount = maxPendingBytes / messageBytes;
+    QVERIFY(keptCount < messageCount);
+
+    for (int i=0; i<messageCount; i++) {
+        rtcm.RTCMDataUpdate(QByteArray(50, 'x'));
+    }
+    QCOMPARE(rtcm._outputByteCounter, 0);
+    QCOMPARE(rtcm.droppedMessages(), messageCount - keptCount);
+    QCOMPARE(rtcm._pendingBytes, keptCount * messageBytes);
+    QCOMPARE(rtcm._pendingMessages.count(), keptCount);
+
+    // The oldest corrections are the ones dropped
+    QCOMPARE(rtcm._pendingMessages.head().fragments[0].flags >> 3, messageCount - keptCount);
+    QCOMPARE(rtcm._pendingMessages.last().fragments[0].flags >> 3, messageCount - 1);
+
+    // Without a limit nothing is dropped for being late
+    rtcm.setBandwidthLimit(0);
+    rtcm._sendPending();
+    QCOMPARE(rtcm._pendingMessages.count(), 0);
+    QCOMPARE(rtcm._outputByteCounter, keptCount * messageBytes);
+}
+
+void RTCMMavlinkTest::_testStaleDropPartial(void)
+{
+    _connectMockLink(MAV_AUTOPILOT_PX4);
+
+    RTCMMavlink rtcm(*qgcApp()->toolbox());
+    const int fragmentBytes = _wireBytes(MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN);
+    const int messageBytes = _wireBytes(50);
+    const int messageCount = 4;
+
+    rtcm.setBandwidthLimit(200);
+    const int maxPendingBytes = (200 * RTCMMavlink::_maxLatencyMSecs) / 1000;
+
+    // Two fragment message, the bucket only has room for the first fragment
+    rtcm._tokens = 1000;
+    rtcm.RTCMDataUpdate(QByteArray(MAVLINK_MSG_GPS_RTCM_DATA_FIELD_DATA_LEN * 2, 'x'));
+    QCOMPARE(rtcm._outputByteCounter, fragmentBytes);
+    QCOMPARE(rtcm._pendingMessages.count(), 1);
+    QCOMPARE(rtcm._pendingMessages.head().nextFragment, 1);
+
+    // The partially sent message is finished, newer messages are dropped around it
+    const int keptCount = (maxPendingBytes - fragmentBytes) / messageBytes;
+    QVERIFY(keptCount < messageCount);
+    for (int i=0; i<messageCount; i++) {
+        rtcm.RTCMDataUpdate(QByteArray(50, 'x'));
+    }
+    QCOMPARE(rtcm.droppedMessages(), messageCount - keptCount);
+    QCOMPARE(rtcm._pendingMessages.count(), keptCount + 1);
+    QCOMPARE(rtcm._pendingMessages.head().nextFragment, 1);
+    QCOMPARE(rtcm._pendingBytes, fragmentBytes + (keptCount * messageBytes));
+}
@@ -0,0 +1,27 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit test for RTCMMavlink correction pacing
+class RTCMMavlinkTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testTokenBucket       (void);
+    void _testPacing            (void);
+    void _testStaleDrop         (void);
+    void _testStaleDropPartial  (void);
+
+private:
+    int _wireBytes(int dataLength);
+};
@@ -18,6 +18,7 @@
 #include "QGCQGeoCoordinate.h"
 
 #include <QPolygonF>
+#include <QtNumeric>
 
 QGC_LOGGING_CATEGORY(CorridorScanComplexItemLog, "CorridorScanComplexItemLog")
 
@@ -294,6 +295,15 @@ void CorridorScanComplexItem::rotateEntryPoint(void)
     _rebuildTransects();
 }
 
+void CorridorScanComplexItem::setEntryLocation(int entryLocation)
+{
+    if (entryLocation != _entryPoint) {
+        _entryPoint = entryLocation;
+        _rebuildTransects();
+        setDirty(true);
+    }
+}
+
 void CorridorScanComplexItem::_rebuildCorridorPolygon(void)
 {
     if (_corridorPolyline.count() < 2) {
@@ -324,26 +334,65 @@ void CorridorScanComplexItem::_rebuildTransectsPhase1(void)
         return;
     }
 
-    // If the transects are getting rebuilt then any previsouly loaded mission items are now invalid
-    if (_loadedMissionItemsParent) {
-        _loadedMissionItems.clear();
-        _loadedMissionItemsParent->deleteLater();
-        _loadedMissionItemsParent = NULL;
-    }
+    QAtomicInt notCancelled(0);
 
-    _transects.clear();
+    // If the transects are getting rebuilt then any previsouly loaded mission items are now invalid
+    _clearLoadedMissionItems();
     _transectsPathHeightInfo.clear();
+    _transects = _generateTransects(_transectParams(), notCancelled);
+}
+
+CorridorScanComplexItem::TransectParams_t CorridorScanComplexItem::_transectParams(void)
+{
+    TransectParams_t params;
+
+    params.polyline             = _corridorPolyline.coordinateList();
+    params.transectSpacing      = _cameraCalc.adjustedFootprintSide()->rawValue().toDouble();
+    params.corridorWidth        = _corridorWidthFact.rawValue().toDouble();
+    params.transectCount        = _transectCount();
+    params.entryPoint           = _entryPoint;
+    params.turnAroundDistance   = _hasTurnaround() ? _turnAroundDistanceFact.rawValue().toDouble() : 0;
+
+    return params;
+}
 
+TransectStyleComplexItem::TransectGenerator_t CorridorScanComplexItem::_transectGenerator(void)
+{
+    TransectParams_t params = _transectParams();
+
+    return [params](const QAtomicInt& cancelled) { return _generateTransects(params, cancelled); };
+}
+
+double CorridorScanComplexItem::_transectGenerationCost(void)
+{
+    // Each transect offsets the full polyline
     double transectSpacing = _cameraCalc.adjustedFootprintSide()->rawValue().toDouble();
-    double fullWidth = _corridorWidthFact.rawValue().toDouble();
+    if (transectSpacing <= 0 || !qIsFinite(transectSpacing)) {
+        return 0;
+    }
+    return static_cast<double>(_transectCount()) * _corridorPolyline.count();
+}
+
+/// Generates the transects using only the values in params so it can be run from a worker thread.
+///     @param cancelled Generation stops early once this is set, the returned transects are then incomplete
+QList<QList<TransectStyleComplexItem::CoordInfo_t>> CorridorScanComplexItem::_generateTransects(const TransectParams_t& params, const QAtomicInt& cancelled)
+{
+    QList<QList<CoordInfo_t>> transects;
+
+    double transectSpacing = params.transectSpacing;
+    double fullWidth = params.corridorWidth;
     double halfWidth = fullWidth / 2.0;
-    int transectCount = _transectCount();
+    int transectCount = params.transectCount;
     double normalizedTransectPosition = transectSpacing / 2.0;
 
-    if (_corridorPolyline.count() >= 2) {
+    if (params.polyline.count() >= 2) {
         // First build up the transects all going the same direction
         //qDebug() << "_rebuildTransectsPhase1";
         for (int i=0; i<transectCount; i++) {
+            if (cancelled.loadAcquire()) {
+                return transects;
+            }
+
             //qDebug() << "start transect";
             double offsetDistance;
             if (transectCount == 1) {
@@ -356,7 +405,7 @@ void CorridorScanComplexItem::_rebuildTransectsPhase1(void)
 
             // Turn transect into CoordInfo transect
             QList<TransectStyleComplexItem::CoordInfo_t> transect;
-            QList<QGeoCoordinate> transectCoords = _corridorPolyline.offsetPolyline(offsetDistance);
+            QList<QGeoCoordinate> transectCoords = QGCMapPolyline::offsetPolyline(params.polyline, offsetDistance);
             for (int j=1; j<transectCoords.count() - 1; j++) {
                 TransectStyleComplexItem::CoordInfo_t coordInfo = { transectCoords[j], CoordTypeInterior };
                 transect.append(coordInfo);
@@ -367,9 +416,9 @@ void CorridorScanComplexItem::_rebuildTransectsPhase1(void)
             transect.append(coordInfo);
 
             // Extend the transect ends for turnaround
-            if (_hasTurnaround()) {
+            if (params.turnAroundDistance > 0) {
                  QGeoCoordinate turnaroundCoord;
-                 double turnAroundDistance = _turnAroundDistanceFact.rawValue().toDouble();
+                 double turnAroundDistance = params.turnAroundDistance;
 
                  double azimuth = transectCoords[0].azimuthTo(transectCoords[1]);
                  turnaroundCoord = transectCoords[0].atDistanceAndAzimuth(-turnAroundDistance, azimuth);
@@ -391,7 +440,7 @@ void CorridorScanComplexItem::_rebuildTransectsPhase1(void)
             }
 #endif
 
-            _transects.append(transect);
+            transects.append(transect);
             normalizedTransectPosition += transectSpacing;
         }
 
@@ -403,7 +452,7 @@ void CorridorScanComplexItem::_rebuildTransectsPhase1(void)
 
         bool reverseTransects = false;
         bool reverseVertices = false;
-        switch (_entryPoint) {
+        switch (params.entryPoint) {
         case 0:
             reverseTransects = false;
             reverseVertices = false;
@@ -423,26 +472,26 @@ void CorridorScanComplexItem::_rebuildTransectsPhase1(void)
         }
         if (reverseTransects) {
             QList<QList<TransectStyleComplexItem::CoordInfo_t>> reversedTransects;
-            foreach (const QList<TransectStyleComplexItem::CoordInfo_t>& transect, _transects) {
+            foreach (const QList<TransectStyleComplexItem::CoordInfo_t>& transect, transects) {
                 reversedTransects.prepend(transect);
             }
-            _transects = reversedTransects;
+            transects = reversedTransects;
         }
         if (reverseVertices) {
-            for (int i=0; i<_transects.count(); i++) {
+            for (int i=0; i<transects.count(); i++) {
                 QList<TransectStyleComplexItem::CoordInfo_t> reversedVertices;
-                foreach (const TransectStyleComplexItem::CoordInfo_t& vertex, _transects[i]) {
+                foreach (const TransectStyleComplexItem::CoordInfo_t& vertex, transects[i]) {
                     reversedVertices.prepend(vertex);
                 }
-                _transects[i] = reversedVertices;
+                transects[i] = reversedVertices;
             }
         }
 
         // Adjust to lawnmower pattern
         reverseVertices = false;
-        for (int i=0; i<_transects.count(); i++) {
+        for (int i=0; i<transects.count(); i++) {
             // We must reverse the vertices for every other transect in order to make a lawnmower pattern
-            QList<TransectStyleComplexItem::CoordInfo_t> transectVertices = _transects[i];
+            QList<TransectStyleComplexItem::CoordInfo_t> transectVertices = transects[i];
             if (reverseVertices) {
                 reverseVertices = false;
                 QList<TransectStyleComplexItem::CoordInfo_t> reversedVertices;
@@ -453,9 +502,11 @@ void CorridorScanComplexItem::_rebuildTransectsPhase1(void)
             } else {
                 reverseVertices = true;
             }
-            _transects[i] = transectVertices;
+            transects[i] = transectVertices;
         }
     }
+
+    return transects;
 }
 
 void CorridorScanComplexItem::_rebuildTransectsPhase2(void)
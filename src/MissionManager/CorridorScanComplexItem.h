@@ -37,6 +37,9 @@ public:
     Q_INVOKABLE void rotateEntryPoint(void);
 
     // Overrides from TransectStyleComplexItem
+    int     entryLocationCount  (void) const final { return 4; }
+    int     entryLocation       (void) const final { return _entryPoint; }
+    void    setEntryLocation    (int entryLocation) final;
     void    save                (QJsonArray&  planItems) final;
     bool    specifiesCoordinate (void) const final;
     void    appendMissionItems  (QList<MissionItem*>& items, QObject* missionItemParent) final;
@@ -66,7 +69,26 @@ private slots:
     void _rebuildTransectsPhase1    (void) final;
     void _rebuildTransectsPhase2    (void) final;
 
+protected:
+    // Overrides from TransectStyleComplexItem
+    TransectGenerator_t _transectGenerator      (void) final;
+    double              _transectGenerationCost (void) final;
+    bool                _lawnmowerEntryLocations(void) const final { return true; }
+
 private:
+    /// Values transect generation depends on. Captured on the gui thread so generation can run on a worker thread.
+    typedef struct {
+        QList<QGeoCoordinate>   polyline;
+        double                  transectSpacing;
+        double                  corridorWidth;
+        int                     transectCount;
+        int                     entryPoint;
+        double                  turnAroundDistance;     ///< 0 for no turnaround
+    } TransectParams_t;
+
+    TransectParams_t _transectParams(void);
+    static QList<QList<CoordInfo_t>> _generateTransects(const TransectParams_t& params, const QAtomicInt& cancelled);
+
     int _transectCount              (void) const;
     void _buildAndAppendMissionItems(QList<MissionItem*>& items, QObject* missionItemParent);
     void _appendLoadedMissionItems  (QList<MissionItem*>& items, QObject* missionItemParent);
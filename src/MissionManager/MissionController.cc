@@ -20,6 +20,7 @@
 #include "FixedWingLandingComplexItem.h"
 #include "StructureScanComplexItem.h"
 #include "CorridorScanComplexItem.h"
+#include "TransectRouteOptimizer.h"
 #include "JsonHelper.h"
 #include "ParameterManager.h"
 #include "QGroundControlQmlGlobal.h"
@@ -54,6 +55,7 @@ const char* MissionController::_jsonComplexItemsKey =           "complexItems";
 const char* MissionController::_jsonMavAutopilotKey =           "MAV_AUTOPILOT";
 
 const int   MissionController::_missionFileVersion =            2;
+const int   MissionController::_complexItemRouteBudgetMsecs =   250;
 
 MissionController::MissionController(PlanMasterController* masterController, QObject *parent)
     : PlanElementController         (masterController, parent)
@@ -63,6 +65,8 @@ MissionController::MissionController(PlanMasterController* masterController, QOb
     , _firstItemsFromVehicle        (false)
     , _itemsRequested               (false)
     , _inRecalcSequence             (false)
+    , _altPercentMin                (qQNaN())
+    , _altPercentMax                (qQNaN())
     , _surveyMissionItemName        (tr("Survey"))
     , _fwLandingMissionItemName     (tr("Fixed Wing Landing"))
     , _structureScanMissionItemName (tr("Structure Scan"))
@@ -1054,6 +1058,38 @@ void MissionController::_calcPrevWaypointValues(double homeAlt, VisualMissionIte
     }
 }
 
+/// Same as _calcPrevWaypointValues for the leg into currentItem, plus the distance from home. The geodesic
+/// calculations are cached per item and only redone when one of the coordinates changes.
+void MissionController::_calcLegValues(double homeAlt, VisualMissionItem* currentItem, VisualMissionItem* prevItem, double* azimuth, double* distance, double* altDifference, double* distanceToHome)
+{
+    QGeoCoordinate  currentCoord =  currentItem->coordinate();
+    QGeoCoordinate  prevCoord =     prevItem->exitCoordinate();
+    QGeoCoordinate  homeCoord =     _settingsItem->exitCoordinate();
+
+    LegCache_t& leg = _legCache[currentItem];
+    if (leg.coord != currentCoord || leg.prevCoord != prevCoord || leg.homeCoord != homeCoord) {
+        leg.coord =             currentCoord;
+        leg.prevCoord =         prevCoord;
+        leg.homeCoord =         homeCoord;
+        leg.distance =          prevCoord.distanceTo(currentCoord);
+        leg.azimuth =           prevCoord.azimuthTo(currentCoord);
+        leg.distanceToHome =    homeCoord.distanceTo(currentCoord);
+    }
+
+    // Convert to fixed altitudes
+    if (currentItem != _settingsItem && currentItem->coordinateHasRelativeAltitude()) {
+        currentCoord.setAltitude(homeAlt + currentCoord.altitude());
+    }
+    if (prevItem != _settingsItem && prevItem->exitCoordinateHasRelativeAltitude()) {
+        prevCoord.setAltitude(homeAlt + prevCoord.altitude());
+    }
+
+    *altDifference =    currentCoord.altitude() - prevCoord.altitude();
+    *azimuth =          leg.azimuth;
+    *distance =         leg.distance;
+    *distanceToHome =   leg.distanceToHome;
+}
+
 double MissionController::_calcDistanceToHome(VisualMissionItem* currentItem, VisualMissionItem* homeItem)
 {
     QGeoCoordinate  currentCoord =  currentItem->coordinate();
@@ -1082,7 +1118,7 @@ void MissionController::_addWaypointLineSegment(CoordVectHashTable& prevItemPair
 
         // FIXME: We should ideally have signals for 2D position change, alt change, and 3D position change
         // Not optimal, but still pretty fast, do a full update of range/bearing/altitudes
-        connect(pair.second, &VisualMissionItem::coordinateChanged, this, &MissionController::_recalcMissionFlightStatus);
+        connect(pair.second, &VisualMissionItem::coordinateChanged, this, &MissionController::_itemFlightStatusChanged, Qt::UniqueConnection);
         _linesTable[pair] = linevect;
     }
 }
@@ -1239,39 +1275,89 @@ void MissionController::_addTimeDistance(bool vtolInHover, double hoverTime, dou
 
 void MissionController::_recalcMissionFlightStatus()
 {
-    if (!_visualItems->count()) {
+    _recalcFlightStatusFrom(0);
+}
+
+/// Called when a value of a single item which affects flight status changes. Only the sending item and the items
+/// after it need to be recalculated.
+void MissionController::_itemFlightStatusChanged(void)
+{
+    int index = _visualItems ? _visualItems->indexOf(sender()) : -1;
+    _recalcFlightStatusFrom(qMax(index, 0));
+}
+
+/// Recalculates the flight status values starting at the specified visual item index. The state of the calculation
+/// prior to startIndex is restored from the last full recalc. Totals are running values so all items from startIndex
+/// to the end of the mission are always walked again.
+void MissionController::_recalcFlightStatusFrom(int startIndex)
+{
+    if (!_visualItems || !_visualItems->count()) {
         return;
     }
 
-    bool                firstCoordinateItem =   true;
-    VisualMissionItem*  lastCoordinateItem =    qobject_cast<VisualMissionItem*>(_visualItems->get(0));
+    const int itemCount = _visualItems->count();
+    if (_flightStatusWalkStates.count() != itemCount || startIndex >= itemCount) {
+        startIndex = 0;
+    }
 
     bool showHomePosition = _settingsItem->coordinate().isValid();
 
-    qCDebug(MissionControllerLog) << "_recalcMissionFlightStatus";
+    qCDebug(MissionControllerLog) << "_recalcMissionFlightStatus startIndex" << startIndex;
 
     // If home position is valid we can calculate distances between all waypoints.
     // If home position is not valid we can only calculate distances between waypoints which are
     // both relative altitude.
 
-    // No values for first item
-    lastCoordinateItem->setAltDifference(0.0);
-    lastCoordinateItem->setAzimuth(0.0);
-    lastCoordinateItem->setDistance(0.0);
-
-    double minAltSeen = 0.0;
-    double maxAltSeen = 0.0;
     const double homePositionAltitude = _settingsItem->coordinate().altitude();
-    minAltSeen = maxAltSeen = _settingsItem->coordinate().altitude();
 
-    _resetMissionFlightStatus();
+    bool                firstCoordinateItem;
+    bool                vtolInHover;
+    bool                linkStartToHome;
+    double              minAltSeen;
+    double              maxAltSeen;
+    VisualMissionItem*  lastCoordinateItem;
 
-    bool vtolInHover = true;
-    bool linkStartToHome = false;
-    bool linkEndToHome = false;
+    if (startIndex == 0) {
+        lastCoordinateItem = qobject_cast<VisualMissionItem*>(_visualItems->get(0));
+
+        // No values for first item
+        lastCoordinateItem->setAltDifference(0.0);
+        lastCoordinateItem->setAzimuth(0.0);
+        lastCoordinateItem->setDistance(0.0);
+
+        minAltSeen = maxAltSeen = homePositionAltitude;
+
+        _resetMissionFlightStatus();
+
+        firstCoordinateItem =   true;
+        vtolInHover =           true;
+        linkStartToHome =       false;
+
+        _flightStatusWalkStates.resize(itemCount);
+
+        // Leg values for items which are no longer part of the mission can go
+        QHash<VisualMissionItem*, LegCache_t> legCache;
+        for (int i=1; i<itemCount; i++) {
+            VisualMissionItem* item = qobject_cast<VisualMissionItem*>(_visualItems->get(i));
+            if (_legCache.contains(item)) {
+                legCache[item] = _legCache[item];
+            }
+        }
+        _legCache.swap(legCache);
+    } else {
+        const FlightStatusWalkState_t& walkState = _flightStatusWalkStates[startIndex];
+        _missionFlightStatus =  walkState.flightStatus;
+        lastCoordinateItem =    walkState.lastCoordinateItem;
+        firstCoordinateItem =   walkState.firstCoordinateItem;
+        vtolInHover =           walkState.vtolInHover;
+        linkStartToHome =       walkState.linkStartToHome;
+        minAltSeen =            walkState.minAltSeen;
+        maxAltSeen =            walkState.maxAltSeen;
+    }
 
+    bool linkEndToHome = false;
     if (showHomePosition) {
-        SimpleMissionItem* lastItem = _visualItems->value<SimpleMissionItem*>(_visualItems->count() - 1);
+        SimpleMissionItem* lastItem = _visualItems->value<SimpleMissionItem*>(itemCount - 1);
         if (lastItem && (int)lastItem->command() == MAV_CMD_NAV_RETURN_TO_LAUNCH) {
             linkEndToHome = true;
         } else {
@@ -1279,14 +1365,23 @@ void MissionController::_recalcMissionFlightStatus()
         }
     }
 
-    for (int i=0; i<_visualItems->count(); i++) {
+    for (int i=startIndex; i<itemCount; i++) {
         VisualMissionItem* item = qobject_cast<VisualMissionItem*>(_visualItems->get(i));
         SimpleMissionItem* simpleItem = qobject_cast<SimpleMissionItem*>(item);
         ComplexMissionItem* complexItem = qobject_cast<ComplexMissionItem*>(item);
 
+        FlightStatusWalkState_t& walkState = _flightStatusWalkStates[i];
+        walkState.flightStatus =        _missionFlightStatus;
+        walkState.lastCoordinateItem =  lastCoordinateItem;
+        walkState.firstCoordinateItem = firstCoordinateItem;
+        walkState.vtolInHover =         vtolInHover;
+        walkState.linkStartToHome =     linkStartToHome;
+        walkState.minAltSeen =          minAltSeen;
+        walkState.maxAltSeen =          maxAltSeen;
+
         // Assume the worst
-        item->setAzimuth(0.0);
-        item->setDistance(0.0);
+        double itemAzimuth =    0.0;
+        double itemDistance =   0.0;
 
         // Look for speed changed
         double newSpeed = item->specifiedFlightSpeed();
@@ -1317,6 +1412,8 @@ void MissionController::_recalcMissionFlightStatus()
 
         if (i == 0) {
             // We only process speed and gimbal from Mission Settings item
+            item->setAzimuth(itemAzimuth);
+            item->setDistance(itemDistance);
             continue;
         }
 
@@ -1385,27 +1482,29 @@ void MissionController::_recalcMissionFlightStatus()
             if (!item->isStandaloneCoordinate()) {
                 firstCoordinateItem = false;
 
-                // Update vehicle yaw assuming direction to next waypoint
-                if (item != lastCoordinateItem) {
-                    _missionFlightStatus.vehicleYaw = lastCoordinateItem->exitCoordinate().azimuthTo(item->coordinate());
-                    lastCoordinateItem->setMissionVehicleYaw(_missionFlightStatus.vehicleYaw);
-                }
-
                 if (lastCoordinateItem != _settingsItem || linkStartToHome) {
                     // This is a subsequent waypoint or we are forcing the first waypoint back to home
-                    double azimuth, distance, altDifference;
+                    double azimuth, distance, altDifference, distanceToHome;
 
-                    _calcPrevWaypointValues(homePositionAltitude, item, lastCoordinateItem, &azimuth, &distance, &altDifference);
+                    _calcLegValues(homePositionAltitude, item, lastCoordinateItem, &azimuth, &distance, &altDifference, &distanceToHome);
                     item->setAltDifference(altDifference);
-                    item->setAzimuth(azimuth);
-                    item->setDistance(distance);
+                    itemAzimuth = azimuth;
+                    itemDistance = distance;
 
-                    _missionFlightStatus.maxTelemetryDistance = qMax(_missionFlightStatus.maxTelemetryDistance, _calcDistanceToHome(item, _settingsItem));
+                    // Update vehicle yaw assuming direction to next waypoint
+                    _missionFlightStatus.vehicleYaw = azimuth;
+                    lastCoordinateItem->setMissionVehicleYaw(_missionFlightStatus.vehicleYaw);
+
+                    _missionFlightStatus.maxTelemetryDistance = qMax(_missionFlightStatus.maxTelemetryDistance, distanceToHome);
 
                     // Calculate time/distance
                     double hoverTime = distance / _missionFlightStatus.hoverSpeed;
                     double cruiseTime = distance / _missionFlightStatus.cruiseSpeed;
                     _addTimeDistance(vtolInHover, hoverTime, cruiseTime, 0, distance, item->sequenceNumber());
+                } else if (item != lastCoordinateItem) {
+                    // Update vehicle yaw assuming direction to next waypoint
+                    _missionFlightStatus.vehicleYaw = lastCoordinateItem->exitCoordinate().azimuthTo(item->coordinate());
+                    lastCoordinateItem->setMissionVehicleYaw(_missionFlightStatus.vehicleYaw);
                 }
 
                 if (complexItem) {
@@ -1423,6 +1522,9 @@ void MissionController::_recalcMissionFlightStatus()
                 lastCoordinateItem = item;
             }
         }
+
+        item->setAzimuth(itemAzimuth);
+        item->setDistance(itemDistance);
     }
     lastCoordinateItem->setMissionVehicleYaw(_missionFlightStatus.vehicleYaw);
 
@@ -1451,9 +1553,13 @@ void MissionController::_recalcMissionFlightStatus()
     emit batteryChangePointChanged(_missionFlightStatus.batteryChangePoint);
     emit batteriesRequiredChanged(_missionFlightStatus.batteriesRequired);
 
-    // Walk the list again calculating altitude percentages
+    // Walk the list again calculating altitude percentages. Items prior to startIndex only need updating if the
+    // altitude range changed.
+    int percentStartIndex = (minAltSeen == _altPercentMin && maxAltSeen == _altPercentMax) ? startIndex : 0;
+    _altPercentMin = minAltSeen;
+    _altPercentMax = maxAltSeen;
     double altRange = maxAltSeen - minAltSeen;
-    for (int i=0; i<_visualItems->count(); i++) {
+    for (int i=percentStartIndex; i<itemCount; i++) {
         VisualMissionItem* item = qobject_cast<VisualMissionItem*>(_visualItems->get(i));
 
         if (item->specifiesCoordinate()) {
@@ -1611,11 +1717,11 @@ void MissionController::_initVisualItem(VisualMissionItem* visualItem)
     connect(visualItem, &VisualMissionItem::specifiesCoordinateChanged,                 this, &MissionController::_recalcWaypointLines);
     connect(visualItem, &VisualMissionItem::coordinateHasRelativeAltitudeChanged,       this, &MissionController::_recalcWaypointLines);
     connect(visualItem, &VisualMissionItem::exitCoordinateHasRelativeAltitudeChanged,   this, &MissionController::_recalcWaypointLines);
-    connect(visualItem, &VisualMissionItem::specifiedFlightSpeedChanged,                this, &MissionController::_recalcMissionFlightStatus);
-    connect(visualItem, &VisualMissionItem::specifiedGimbalYawChanged,                  this, &MissionController::_recalcMissionFlightStatus);
-    connect(visualItem, &VisualMissionItem::specifiedGimbalPitchChanged,                this, &MissionController::_recalcMissionFlightStatus);
-    connect(visualItem, &VisualMissionItem::terrainAltitudeChanged,                     this, &MissionController::_recalcMissionFlightStatus);
-    connect(visualItem, &VisualMissionItem::additionalTimeDelayChanged,                 this, &MissionController::_recalcMissionFlightStatus);
+    connect(visualItem, &VisualMissionItem::specifiedFlightSpeedChanged,                this, &MissionController::_itemFlightStatusChanged);
+    connect(visualItem, &VisualMissionItem::specifiedGimbalYawChanged,                  this, &MissionController::_itemFlightStatusChanged);
+    connect(visualItem, &VisualMissionItem::specifiedGimbalPitchChanged,                this, &MissionController::_itemFlightStatusChanged);
+    connect(visualItem, &VisualMissionItem::terrainAltitudeChanged,                     this, &MissionController::_itemFlightStatusChanged);
+    connect(visualItem, &VisualMissionItem::additionalTimeDelayChanged,                 this, &MissionController::_itemFlightStatusChanged);
     connect(visualItem, &VisualMissionItem::lastSequenceNumberChanged,                  this, &MissionController::_recalcSequence);
 
     if (visualItem->isSimpleItem()) {
@@ -1629,8 +1735,8 @@ void MissionController::_initVisualItem(VisualMissionItem* visualItem)
     } else {
         ComplexMissionItem* complexItem = qobject_cast<ComplexMissionItem*>(visualItem);
         if (complexItem) {
-            connect(complexItem, &ComplexMissionItem::complexDistanceChanged,       this, &MissionController::_recalcMissionFlightStatus);
-            connect(complexItem, &ComplexMissionItem::greatestDistanceToChanged,    this, &MissionController::_recalcMissionFlightStatus);
+            connect(complexItem, &ComplexMissionItem::complexDistanceChanged,       this, &MissionController::_itemFlightStatusChanged);
+            connect(complexItem, &ComplexMissionItem::greatestDistanceToChanged,    this, &MissionController::_itemFlightStatusChanged);
         } else {
             qWarning() << "ComplexMissionItem not found";
         }
@@ -1960,6 +2066,112 @@ void MissionController::applyDefaultMissionAltitude(void)
     }
 }
 
+void MissionController::optimizeComplexItemRoute(void)
+{
+    bool changed = false;
+    int index = 1;
+
+    while (index < _visualItems->count()) {
+        if (!qobject_cast<TransectStyleComplexItem*>(_visualItems->get(index))) {
+            index++;
+            continue;
+        }
+
+        int firstIndex = index;
+        while (index < _visualItems->count() && qobject_cast<TransectStyleComplexItem*>(_visualItems->get(index))) {
+            index++;
+        }
+        if (_optimizeComplexItemRun(firstIndex, index - 1)) {
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        // Flight status, waypoint lines and sequence numbers all depend on the new order
+        _recalcAll();
+        setDirty(true);
+    }
+}
+
+/// Optimizes the route through a run of consecutive transect style items
+///     @return true: Items were reordered or had their entry location changed
+bool MissionController::_optimizeComplexItemRun(int firstIndex, int lastIndex)
+{
+    // The route starts from the exit of the closest earlier item the vehicle flies through and ends at the next one
+    QGeoCoordinate startCoord = _settingsItem->coordinate();
+    for (int i=firstIndex-1; i>0; i--) {
+        VisualMissionItem* item = _visualItems->value<VisualMissionItem*>(i);
+        if (item->specifiesCoordinate() && !item->isStandaloneCoordinate()) {
+            startCoord = item->exitCoordinate();
+            break;
+        }
+    }
+    QGeoCoordinate endCoord;
+    for (int i=lastIndex+1; i<_visualItems->count(); i++) {
+        VisualMissionItem* item = _visualItems->value<VisualMissionItem*>(i);
+        if (item->specifiesCoordinate() && !item->isStandaloneCoordinate()) {
+            endCoord = item->coordinate();
+            break;
+        }
+    }
+    if (!startCoord.isValid()) {
+        return false;
+    }
+
+    TransectRouteOptimizer              optimizer(startCoord, endCoord);
+    QList<TransectStyleComplexItem*>    items;
+    QList<QList<int>>                   itemEntryLocations;     // Entry location for each optimizer option of an item
+
+    for (int i=firstIndex; i<=lastIndex; i++) {
+        TransectStyleComplexItem*               item = _visualItems->value<TransectStyleComplexItem*>(i);
+        QList<TransectRouteOptimizer::Option_t> options;
+        QList<int>                              entryLocations;
+        int                                     currentOption = 0;
+
+        for (int entryLocation=0; entryLocation<item->entryLocationCount(); entryLocation++) {
+            TransectRouteOptimizer::Option_t option;
+            if (item->entryLocationCoordinates(entryLocation, option.entry, option.exit)) {
+                if (entryLocation == item->entryLocation()) {
+                    currentOption = options.count();
+                }
+                options.append(option);
+                entryLocations.append(entryLocation);
+            }
+        }
+        if (options.isEmpty()) {
+            // Item has nothing to fly yet, so there is no sensible place to move it to
+            qCDebug(MissionControllerLog) << "_optimizeComplexItemRun item without transects, skipping run" << i;
+            return false;
+        }
+
+        items.append(item);
+        itemEntryLocations.append(entryLocations);
+        optimizer.addNode(options, currentOption);
+    }
+
+    optimizer.optimize(_complexItemRouteBudgetMsecs);
+    if (optimizer.distance() >= optimizer.initialDistance()) {
+        return false;
+    }
+
+    QList<int> order = optimizer.order();
+    for (int position=0; position<order.count(); position++) {
+        int node = order[position];
+        TransectStyleComplexItem* item = items[node];
+
+        int currentIndex = _visualItems->indexOf(item);
+        if (currentIndex != firstIndex + position) {
+            _visualItems->removeAt(currentIndex);
+            _visualItems->insert(firstIndex + position, item);
+        }
+        item->setEntryLocation(itemEntryLocations[node][optimizer.option(node)]);
+    }
+
+    qCDebug(MissionControllerLog) << "_optimizeComplexItemRun first:last:initial:optimized" << firstIndex << lastIndex << optimizer.initialDistance() << optimizer.distance();
+
+    return true;
+}
+
 void MissionController::_progressPctChanged(double progressPct)
 {
     if (!qFuzzyCompare(progressPct, _progressPct)) {
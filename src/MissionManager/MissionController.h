@@ -19,6 +19,7 @@
 #include "QGCGeoBoundingCube.h"
 
 #include <QHash>
+#include <QVector>
 
 class CoordinateVector;
 class VisualMissionItem;
@@ -127,6 +128,11 @@ public:
     /// Updates the altitudes of the items in the current mission to the new default altitude
     Q_INVOKABLE void applyDefaultMissionAltitude(void);
 
+    /// Shortens the legs flown between survey style items. Each run of consecutive survey/corridor items is reordered
+    /// and the entry location of each item is picked to give the shortest route from the item before the run to the
+    /// item after it. Items are never moved across other item types.
+    Q_INVOKABLE void optimizeComplexItemRoute(void);
+
     /// Sets a new current mission item (PlanView).
     ///     @param sequenceNumber - index for new item, -1 to clear current item
     Q_INVOKABLE void setCurrentPlanViewIndex(int sequenceNumber, bool force);
@@ -224,6 +230,7 @@ private slots:
     void _currentMissionIndexChanged(int sequenceNumber);
     void _recalcWaypointLines(void);
     void _recalcMissionFlightStatus(void);
+    void _itemFlightStatusChanged(void);
     void _updateContainsItems(void);
     void _progressPctChanged(double progressPct);
     void _visualItemsDirtyChanged(bool dirty);
@@ -233,6 +240,29 @@ private slots:
     void _complexBoundingBoxChanged();
 
 private:
+    /// State of the flight status calculation before an item is processed. One is saved for each item so that a change
+    /// to an item only needs to recalculate from that item forward.
+    typedef struct {
+        MissionFlightStatus_t   flightStatus;
+        VisualMissionItem*      lastCoordinateItem;
+        bool                    firstCoordinateItem;
+        bool                    vtolInHover;
+        bool                    linkStartToHome;
+        double                  minAltSeen;
+        double                  maxAltSeen;
+    } FlightStatusWalkState_t;
+
+    /// Geodesic values for the leg into an item. These are the expensive part of the flight status calculation so they
+    /// are only recalculated when one of the coordinates changes.
+    typedef struct {
+        QGeoCoordinate  prevCoord;
+        QGeoCoordinate  coord;
+        QGeoCoordinate  homeCoord;
+        double          azimuth;
+        double          distance;
+        double          distanceToHome;
+    } LegCache_t;
+
     void _init(void);
     void _recalcSequence(void);
     void _recalcChildItems(void);
@@ -243,7 +273,9 @@ private:
     void _deinitVisualItem(VisualMissionItem* item);
     void _setupActiveVehicle(Vehicle* activeVehicle, bool forceLoadFromVehicle);
     void _calcPrevWaypointValues(double homeAlt, VisualMissionItem* currentItem, VisualMissionItem* prevItem, double* azimuth, double* distance, double* altDifference);
+    void _calcLegValues(double homeAlt, VisualMissionItem* currentItem, VisualMissionItem* prevItem, double* azimuth, double* distance, double* altDifference, double* distanceToHome);
     static double _calcDistanceToHome(VisualMissionItem* currentItem, VisualMissionItem* homeItem);
+    void _recalcFlightStatusFrom(int startIndex);
     bool _findPreviousAltitude(int newIndex, double* prevAltitude, int* prevAltitudeMode);
     static double _normalizeLat(double lat);
     static double _normalizeLon(double lon);
@@ -266,6 +298,7 @@ private:
     void _addTimeDistance(bool vtolInHover, double hoverTime, double cruiseTime, double extraTime, double distance, int seqNum);
     int _insertComplexMissionItemWorker(ComplexMissionItem* complexItem, int i);
     void _warnIfTerrainFrameUsed(void);
+    bool _optimizeComplexItemRun(int firstIndex, int lastIndex);
 
 private:
     MissionManager*         _missionManager;
@@ -278,6 +311,10 @@ private:
     bool                    _itemsRequested;
     bool                    _inRecalcSequence;
     MissionFlightStatus_t   _missionFlightStatus;
+    QVector<FlightStatusWalkState_t>        _flightStatusWalkStates;    ///< Indexed by visual item index
+    QHash<VisualMissionItem*, LegCache_t>   _legCache;
+    double                  _altPercentMin;
+    double                  _altPercentMax;
     QString                 _surveyMissionItemName;
     QString                 _fwLandingMissionItemName;
     QString                 _structureScanMissionItemName;
@@ -307,6 +344,7 @@ private:
     static const char*  _jsonComplexItemsKey;
 
     static const int    _missionFileVersion;
+    static const int    _complexItemRouteBudgetMsecs;
 };
 
 #endif
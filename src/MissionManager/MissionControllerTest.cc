@@ -13,10 +13,14 @@
 #include "MultiVehicleManager.h"
 #include "SimpleMissionItem.h"
 #include "MissionSettingsItem.h"
+#include "SurveyComplexItem.h"
 #include "QGCApplication.h"
 #include "SettingsManager.h"
 #include "AppSettings.h"
 
+#include <QElapsedTimer>
+#include <QJsonArray>
+
 MissionControllerTest::MissionControllerTest(void)
     : _multiSpyMissionController(NULL)
     , _multiSpyMissionItem(NULL)
@@ -225,6 +229,51 @@ void MissionControllerTest::_testGimbalRecalc(void)
     }
 }
 
+void MissionControllerTest::_testOptimizeComplexItemRoute(void)
+{
+    _initForFirmwareType(MAV_AUTOPILOT_PX4);
+    _loadWaypointMission(1);
+
+    // Surveys are added farthest first, so flying them in order zig zags back and forth from the takeoff
+    QGeoCoordinate              takeoffCoordinate = _missionController->visualItems()->value<VisualMissionItem*>(1)->coordinate();
+    double                      rgSurveyDistance[] = { 3000, 1000, 2000 };
+    QList<SurveyComplexItem*>   rgSurveys;
+    for (int i=0; i<3; i++) {
+        QGeoCoordinate center = takeoffCoordinate.atDistanceAndAzimuth(rgSurveyDistance[i], 90);
+        _missionController->insertComplexMissionItem(_missionController->surveyComplexItemName(), center, _missionController->visualItems()->count());
+        SurveyComplexItem* survey = _missionController->visualItems()->value<SurveyComplexItem*>(_missionController->visualItems()->count() - 1);
+        QVERIFY(survey);
+        survey->surveyAreaPolygon()->clear();
+        for (int j=0; j<4; j++) {
+            survey->surveyAreaPolygon()->appendVertex(center.atDistanceAndAzimuth(150, 45 + (j * 90)));
+        }
+        QVERIFY(!survey->transectGenerationInProgress());
+        rgSurveys.append(survey);
+    }
+    _missionController->setDirty(false);
+
+    double initialDistance = _missionController->missionDistance();
+    _missionController->optimizeComplexItemRoute();
+
+    // Closest survey is flown first and each survey is only flown through once
+    QmlObjectListModel* visualItems = _missionController->visualItems();
+    QCOMPARE(visualItems->count(), 5);
+    QCOMPARE(visualItems->value<SurveyComplexItem*>(2), rgSurveys[1]);
+    QCOMPARE(visualItems->value<SurveyComplexItem*>(3), rgSurveys[2]);
+    QCOMPARE(visualItems->value<SurveyComplexItem*>(4), rgSurveys[0]);
+    QVERIFY(_missionController->missionDistance() < initialDistance);
+    QVERIFY(_missionController->dirty());
+    _compareToFullRecalc();
+
+    // Running it again on an already optimized route keeps the order and never makes it longer
+    double optimizedDistance = _missionController->missionDistance();
+    _missionController->optimizeComplexItemRoute();
+    QCOMPARE(visualItems->value<SurveyComplexItem*>(2), rgSurveys[1]);
+    QCOMPARE(visualItems->value<SurveyComplexItem*>(3), rgSurveys[2]);
+    QCOMPARE(visualItems->value<SurveyComplexItem*>(4), rgSurveys[0]);
+    QVERIFY(_missionController->missionDistance() <= optimizedDistance);
+}
+
 void MissionControllerTest::_testLoadJsonSectionAvailable(void)
 {
     _initForFirmwareType(MAV_AUTOPILOT_PX4);
@@ -248,3 +297,131 @@ void MissionControllerTest::_testLoadJsonSectionAvailable(void)
 
     }
 }
+
+/// Loads a mission made up of a takeoff followed by waypoints in a zig zag pattern
+void MissionControllerTest::_loadWaypointMission(int waypointCount)
+{
+    QJsonArray  rgItems;
+    double      homeLat = 47.633;
+    double      homeLon = -122.09;
+
+    for (int i=0; i<waypointCount; i++) {
+        QJsonObject item;
+        item["type"] =          "SimpleItem";
+        item["autoContinue"] =  true;
+        item["command"] =       i == 0 ? MAV_CMD_NAV_TAKEOFF : MAV_CMD_NAV_WAYPOINT;
+        item["frame"] =         MAV_FRAME_GLOBAL_RELATIVE_ALT;
+        item["doJumpId"] =      i + 1;
+        item["params"] =        QJsonArray({ 0, 0, 0, QJsonValue() });
+        item["coordinate"] =    QJsonArray({ homeLat + (i / 100) * 0.0005, homeLon + ((i / 100) % 2 ? 100 - (i % 100) : i % 100) * 0.0005, 20 + (i % 7) });
+        rgItems.append(item);
+    }
+
+    QJsonObject json;
+    json["plannedHomePosition"] =   QJsonArray({ homeLat, homeLon, 10 });
+    json["items"] =                 rgItems;
+    json["firmwareType"] =          MAV_AUTOPILOT_PX4;
+    json["cruiseSpeed"] =           15;
+    json["hoverSpeed"] =            5;
+
+    QString errorString;
+    QVERIFY2(_missionController->load(json, errorString), qPrintable(errorString));
+    QCOMPARE(_missionController->visualItems()->count(), waypointCount + 1);
+}
+
+/// Validates the current incrementally calculated values against a full recalculation
+void MissionControllerTest::_compareToFullRecalc(void)
+{
+    QmlObjectListModel* visualItems = _missionController->visualItems();
+
+    double          distance =  _missionController->missionDistance();
+    double          time =      _missionController->missionTime();
+    double          telemetry = _missionController->missionMaxTelemetry();
+    QList<double>   rgAzimuth;
+    QList<double>   rgDistance;
+    for (int i=0; i<visualItems->count(); i++) {
+        rgAzimuth.append(visualItems->value<VisualMissionItem*>(i)->azimuth());
+        rgDistance.append(visualItems->value<VisualMissionItem*>(i)->distance());
+    }
+
+    QVERIFY(QMetaObject::invokeMethod(_missionController, "_recalcMissionFlightStatus"));
+
+    QCOMPARE(_missionController->missionDistance(), distance);
+    QCOMPARE(_missionController->missionTime(), time);
+    QCOMPARE(_missionController->missionMaxTelemetry(), telemetry);
+    for (int i=0; i<visualItems->count(); i++) {
+        QCOMPARE(visualItems->value<VisualMissionItem*>(i)->azimuth(), rgAzimuth[i]);
+        QCOMPARE(visualItems->value<VisualMissionItem*>(i)->distance(), rgDistance[i]);
+    }
+}
+
+void MissionControllerTest::_testIncrementalFlightStatus(void)
+{
+    _initForFirmwareType(MAV_AUTOPILOT_PX4);
+    _loadWaypointMission(250);
+
+    QmlObjectListModel* visualItems = _missionController->visualItems();
+    double              distance =  _missionController->missionDistance();
+    double              time =      _missionController->missionTime();
+    QVERIFY(distance > 0);
+
+    // Moving a waypoint out and back changes the distance of the legs in and out of it
+    SimpleMissionItem*  simpleItem = visualItems->value<SimpleMissionItem*>(120);
+    QGeoCoordinate      coordinate = simpleItem->coordinate();
+    simpleItem->setCoordinate(coordinate.atDistanceAndAzimuth(500, 90));
+    QVERIFY(_missionController->missionDistance() > distance);
+    QVERIFY(visualItems->value<VisualMissionItem*>(121)->distance() > 0);
+    _compareToFullRecalc();
+    simpleItem->setCoordinate(coordinate);
+    QVERIFY(qAbs(_missionController->missionDistance() - distance) < 0.01);
+    _compareToFullRecalc();
+
+    // Speed change only affects the time from that item forward
+    simpleItem->speedSection()->setSpecifyFlightSpeed(true);
+    simpleItem->speedSection()->flightSpeed()->setRawValue(1);
+    QVERIFY(_missionController->missionTime() > time);
+    QVERIFY(qAbs(_missionController->missionDistance() - distance) < 0.01);
+    _compareToFullRecalc();
+
+    // Edits before an earlier edit must pick up the state of the later one
+    SimpleMissionItem* earlierItem = visualItems->value<SimpleMissionItem*>(10);
+    earlierItem->setCoordinate(earlierItem->coordinate().atDistanceAndAzimuth(200, 0));
+    _compareToFullRecalc();
+}
+
+/// Measures the time from moving a single waypoint in a large mission to the updated values being available
+/// to the ui. Compared against the cost of a full recalculation.
+void MissionControllerTest::_benchmarkFlightStatusEdit(void)
+{
+    UT_BENCHMARK();
+
+    const int cEdits = 20;
+
+    _initForFirmwareType(MAV_AUTOPILOT_PX4);
+    _loadWaypointMission(5000);
+
+    QmlObjectListModel* visualItems =   _missionController->visualItems();
+    SimpleMissionItem*  simpleItem =    visualItems->value<SimpleMissionItem*>(visualItems->count() / 2);
+    QGeoCoordinate      coordinate =    simpleItem->coordinate();
+    QElapsedTimer       timer;
+
+    QCoreApplication::processEvents();
+    timer.start();
+    for (int i=0; i<cEdits; i++) {
+        // Simulates dragging the waypoint on the map
+        simpleItem->setCoordinate(coordinate.atDistanceAndAzimuth(i + 1, 45));
+        QCoreApplication::processEvents();
+    }
+    qint64 editNSecs = timer.nsecsElapsed() / cEdits;
+
+    timer.start();
+    for (int i=0; i<cEdits; i++) {
+        QMetaObject::invokeMethod(_missionController, "_recalcMissionFlightStatus");
+        QCoreApplication::processEvents();
+    }
+    qint64 fullNSecs = timer.nsecsElapsed() / cEdits;
+
+    qCDebug(MissionControllerLog) << "MissionController 5000 item plan: edit to update msecs" << editNSecs / 1.0e6 << "full recalc msecs" << fullNSecs / 1.0e6;
+
+    _compareToFullRecalc();
+}
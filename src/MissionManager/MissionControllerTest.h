@@ -33,11 +33,14 @@ private slots:
     void cleanup(void);
 
     void _testGimbalRecalc(void);
+    void _testOptimizeComplexItemRoute(void);
     void _testLoadJsonSectionAvailable(void);
     void _testEmptyVehicleAPM(void);
     void _testEmptyVehiclePX4(void);
     void _testAddWayppointAPM(void);
     void _testAddWayppointPX4(void);
+    void _testIncrementalFlightStatus(void);
+    void _benchmarkFlightStatusEdit(void);
 
 private:
 #if 0
@@ -53,6 +56,8 @@ private:
     void _testOfflineToOnlineWorker(MAV_AUTOPILOT firmwareType);
 #endif
     void _setupVisualItemSignals(VisualMissionItem* visualItem);
+    void _loadWaypointMission(int waypointCount);
+    void _compareToFullRecalc(void);
 
     // MissiomItems signals
 
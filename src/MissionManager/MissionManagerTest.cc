@@ -11,6 +11,10 @@
 #include "MissionManagerTest.h"
 #include "LinkManager.h"
 #include "MultiVehicleManager.h"
+#include "SettingsManager.h"
+#include "AppSettings.h"
+
+#include <QElapsedTimer>
 
 const MissionManagerTest::TestCase_t MissionManagerTest::_rgTestCases[] = {
     { "0\t0\t3\t16\t10\t20\t30\t40\t-10\t-20\t-30\t1\r\n",  { 0, QGeoCoordinate(-10.0, -20.0, -30.0), MAV_CMD_NAV_WAYPOINT,     10.0, 20.0, 30.0, 40.0, true, false, MAV_FRAME_GLOBAL_RELATIVE_ALT } },
@@ -329,3 +333,100 @@ void MissionManagerTest::_testReadFailureHandlingPX4(void)
     _initForFirmwareType(MAV_AUTOPILOT_PX4);
     _testReadFailureHandlingWorker();
 }
+
+/// Writes a plain waypoint mission to the vehicle, each waypoint at a different coordinate
+void MissionManagerTest::_writeWaypointItems(int count)
+{
+    QList<MissionItem*> missionItems;
+
+    for (int i=0; i<count; i++) {
+        missionItems.append(new MissionItem(i, MAV_CMD_NAV_WAYPOINT, MAV_FRAME_GLOBAL_RELATIVE_ALT,
+                                            0, 0, 0, 0,
+                                            47.3769 + (i * 0.0001), 8.549444, 50,
+                                            true,       // autoContinue
+                                            i == 0,     // isCurrentItem
+                                            this));
+    }
+
+    _missionManager->writeMissionItems(missionItems);
+    QVERIFY(_multiSpyMissionManager->waitForSignalByIndex(sendCompleteSignalIndex, _missionManagerSignalWaitTime));
+    QCOMPARE(_multiSpyMissionManager->checkNoSignalByMask(errorSignalMask), true);
+    _multiSpyMissionManager->clearAllSignals();
+}
+
+void MissionManagerTest::cleanup(void)
+{
+    // Restored here rather than at the end of each test so a failing test doesn't leave the setting behind
+    Fact* planTransferWindow = qgcApp()->toolbox()->settingsManager()->appSettings()->planTransferWindow();
+    planTransferWindow->setRawValue(planTransferWindow->rawDefaultValue());
+
+    MissionControllerManagerTest::cleanup();
+}
+
+/// Reads the mission back from the vehicle and checks it matches what was written
+void MissionManagerTest::_timedRead(int readWindowSize, qint64& elapsedMsecs)
+{
+    QList<QGeoCoordinate> expectedCoordinates;
+    foreach (const MissionItem* item, _missionManager->missionItems()) {
+        expectedCoordinates.append(item->coordinate());
+    }
+
+    qgcApp()->toolbox()->settingsManager()->appSettings()->planTransferWindow()->setRawValue(readWindowSize);
+
+    QElapsedTimer timer;
+    timer.start();
+    _missionManager->loadFromVehicle();
+    QCOMPARE(_missionManager->readWindowSize(), readWindowSize);
+    QVERIFY(_multiSpyMissionManager->waitForSignalByIndex(newMissionItemsAvailableSignalIndex, 60 * 1000));
+    elapsedMsecs = timer.elapsed();
+
+    QCOMPARE(_multiSpyMissionManager->checkNoSignalByMask(errorSignalMask), true);
+    _multiSpyMissionManager->clearAllSignals();
+
+    const QList<MissionItem*>& missionItems = _missionManager->missionItems();
+    QCOMPARE(missionItems.count(), expectedCoordinates.count());
+    for (int i=0; i<missionItems.count(); i++) {
+        QCOMPARE(missionItems[i]->sequenceNumber(), i);
+        // Vehicle stores coordinates as float
+        QVERIFY(missionItems[i]->coordinate().distanceTo(expectedCoordinates[i]) < 1.0);
+    }
+}
+
+void MissionManagerTest::_testPipelinedReadPX4(void)
+{
+    _initForFirmwareType(MAV_AUTOPILOT_PX4);
+    _writeWaypointItems(40);
+
+    // Items which are dropped must be filled in, and items arriving out of order must end up in sequence order
+    qint64 elapsedMsecs;
+    _mockLink->setMissionItemLinkSimulation(20, 10);
+    _timedRead(8, elapsedMsecs);
+    _mockLink->setMissionItemLinkSimulation(0, 0);
+
+    QVERIFY(_missionManager->smoothedRttMSecs() >= 20);
+    QVERIFY(_missionManager->retryTimeoutMSecs() >= MissionManager::_retryTimeoutMilliseconds);
+}
+
+void MissionManagerTest::_benchmarkPipelinedRead(void)
+{
+    UT_BENCHMARK();
+
+    const int itemCount =       60;
+    const int latencyMsecs =    50;
+    const int lossPct =         5;
+
+    _initForFirmwareType(MAV_AUTOPILOT_PX4);
+    _writeWaypointItems(itemCount);
+
+    _mockLink->setMissionItemLinkSimulation(latencyMsecs, lossPct);
+
+    qint64 sequentialMsecs;
+    _timedRead(1, sequentialMsecs);
+    qint64 pipelinedMsecs;
+    _timedRead(16, pipelinedMsecs);
+
+    _mockLink->setMissionItemLinkSimulation(0, 0);
+
+    qCDebug(PlanManagerLog) << "Mission read items:latency:loss:sequentialMsecs:pipelinedMsecs" << itemCount << latencyMsecs << lossPct << sequentialMsecs << pipelinedMsecs;
+    QVERIFY(pipelinedMsecs < sequentialMsecs);
+}
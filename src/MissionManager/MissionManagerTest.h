@@ -27,16 +27,22 @@ public:
     MissionManagerTest(void);
     
 private slots:
+    void cleanup(void);
+
     void _testWriteFailureHandlingPX4(void);
     void _testWriteFailureHandlingAPM(void);
     void _testReadFailureHandlingPX4(void);
     void _testReadFailureHandlingAPM(void);
+    void _testPipelinedReadPX4(void);
+    void _benchmarkPipelinedRead(void);
 
 private:
     void _roundTripItems(MockLinkMissionItemHandler::FailureMode_t failureMode, bool shouldFail);
     void _writeItems(MockLinkMissionItemHandler::FailureMode_t failureMode, bool shouldFail);
     void _testWriteFailureHandlingWorker(void);
     void _testReadFailureHandlingWorker(void);
+    void _writeWaypointItems(int count);
+    void _timedRead(int readWindowSize, qint64& elapsedMsecs);
     
     static const TestCase_t _rgTestCases[];
     static const size_t     _cTestCases;
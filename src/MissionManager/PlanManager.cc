@@ -18,6 +18,10 @@
 #include "QGCApplication.h"
 #include "MissionCommandTree.h"
 #include "MissionCommandUIInfo.h"
+#include "SettingsManager.h"
+#include "AppSettings.h"
+
+#include <algorithm>
 
 QGC_LOGGING_CATEGORY(PlanManagerLog, "PlanManagerLog")
 
@@ -31,11 +35,19 @@ PlanManager::PlanManager(Vehicle* vehicle, MAV_MISSION_TYPE planType)
     , _resumeMission            (false)
     , _lastMissionRequest       (-1)
     , _missionItemCountToRead   (-1)
+    , _readWindowSize           (1)
+    , _readSendIndex            (0)
+    , _ackSentMSecs             (-1)
+    , _ackResent                (false)
+    , _srttMSecs                (-1)
+    , _rttVarMSecs              (0)
+    , _retryTimeoutMSecs        (_retryTimeoutMilliseconds)
     , _currentMissionIndex      (-1)
     , _lastCurrentIndex         (-1)
 {
     _ackTimeoutTimer = new QTimer(this);
     _ackTimeoutTimer->setSingleShot(true);
+    _rttClock.start();
 
     connect(_ackTimeoutTimer, &QTimer::timeout, this, &PlanManager::_ackTimeout);
 }
@@ -119,6 +131,7 @@ void PlanManager::_writeMissionCount(void)
                                         _planType);
 
     _vehicle->sendMessageOnLink(_dedicatedLink, message);
+    _setAckSent(_retryCount > 0);
     _startAckTimeout(AckMissionRequest);
 }
 
@@ -135,6 +148,8 @@ void PlanManager::loadFromVehicle(void)
         return;
     }
 
+    _readWindowSize = qMax(qgcApp()->toolbox()->settingsManager()->appSettings()->planTransferWindow()->rawValue().toInt(), 1);
+
     _retryCount = 0;
     _setTransactionInProgress(TransactionRead);
     _connectToMavlink();
@@ -149,6 +164,7 @@ void PlanManager::_requestList(void)
     mavlink_message_t message;
 
     _itemIndicesToRead.clear();
+    _outstandingReadRequests.clear();
     _clearMissionItems();
 
     _dedicatedLink = _vehicle->priorityLink();
@@ -161,6 +177,7 @@ void PlanManager::_requestList(void)
                                                _planType);
 
     _vehicle->sendMessageOnLink(_dedicatedLink, message);
+    _setAckSent(_retryCount > 0);
     _startAckTimeout(AckMissionCount);
 }
 
@@ -193,8 +210,10 @@ void PlanManager::_ackTimeout(void)
             _finishTransaction(false);
         } else {
             _retryCount++;
-            qCDebug(PlanManagerLog) << tr("Retrying %1 MISSION_REQUEST retry Count").arg(_planTypeString()) << _retryCount;
-            _requestNextMissionItem();
+            // Back off in case the link got slower, the timeout adapts again from the next clean round trip
+            _retryTimeoutMSecs = qMin(_retryTimeoutMSecs * 2, _maxRetryTimeoutMilliseconds);
+            qCDebug(PlanManagerLog) << tr("Retrying %1 MISSION_REQUEST retry Count").arg(_planTypeString()) << _retryCount << _retryTimeoutMSecs;
+            _resendMissionItemRequests();
         }
         break;
     case AckMissionRequest:
@@ -245,7 +264,7 @@ void PlanManager::_startAckTimeout(AckType_t ack)
     switch (ack) {
     case AckMissionItem:
         // We are actively trying to get the mission item, so we don't want to wait as long.
-        _ackTimeoutTimer->setInterval(_retryTimeoutMilliseconds);
+        _ackTimeoutTimer->setInterval(_retryTimeoutMSecs);
         break;
     case AckNone:
         // FALLTHROUGH
@@ -256,7 +275,8 @@ void PlanManager::_startAckTimeout(AckType_t ack)
     case AckMissionClearAll:
         // FALLTHROUGH
     case AckGuidedItem:
-        _ackTimeoutTimer->setInterval(_ackTimeoutMilliseconds);
+        // Slow links still get at least a full round trip
+        _ackTimeoutTimer->setInterval(qMax(_ackTimeoutMilliseconds, _retryTimeoutMSecs));
         break;
     }
 
@@ -269,6 +289,11 @@ void PlanManager::_startAckTimeout(AckType_t ack)
 bool PlanManager::_checkForExpectedAck(AckType_t receivedAck)
 {
     if (receivedAck == _expectedAck) {
+        // Item reads keep their own per request send times
+        if (receivedAck != AckMissionItem && _ackSentMSecs >= 0 && !_ackResent) {
+            _addRttSample(_rttClock.elapsed() - _ackSentMSecs);
+        }
+        _ackSentMSecs = -1;
         _expectedAck = AckNone;
         _ackTimeoutTimer->stop();
         return true;
@@ -285,9 +310,36 @@ bool PlanManager::_checkForExpectedAck(AckType_t receivedAck)
     }
 }
 
+/// Records the send time of a message which is answered by the next expected ack
+///     @param resent true: message was sent before, the answer can't be used as a round trip sample
+void PlanManager::_setAckSent(bool resent)
+{
+    _ackSentMSecs = _rttClock.elapsed();
+    _ackResent = resent;
+}
+
+/// Updates the smoothed round trip time and the retry timeout derived from it, using the same estimator as TCP
+void PlanManager::_addRttSample(qint64 rttMSecs)
+{
+    if (_srttMSecs < 0) {
+        _srttMSecs = rttMSecs;
+        _rttVarMSecs = rttMSecs / 2.0;
+    } else {
+        _rttVarMSecs = (0.75 * _rttVarMSecs) + (0.25 * qAbs(_srttMSecs - rttMSecs));
+        _srttMSecs = (0.875 * _srttMSecs) + (0.125 * rttMSecs);
+    }
+
+    _retryTimeoutMSecs = qBound(_retryTimeoutMilliseconds, static_cast<int>(_srttMSecs + (4 * _rttVarMSecs)), _maxRetryTimeoutMilliseconds);
+}
+
 void PlanManager::_readTransactionComplete(void)
 {
     qCDebug(PlanManagerLog) << "_readTransactionComplete read sequence complete";
+
+    // Pipelined reads can receive items out of order
+    std::sort(_missionItems.begin(), _missionItems.end(), [](const MissionItem* item1, const MissionItem* item2) {
+        return item1->sequenceNumber() < item2->sequenceNumber();
+    });
     
     mavlink_message_t message;
     
@@ -334,10 +386,12 @@ void PlanManager::_handleMissionCount(const mavlink_message_t& message)
             _itemIndicesToRead << i;
         }
         _missionItemCountToRead = missionCount.count;
+        _outstandingReadRequests.clear();
         _requestNextMissionItem();
     }
 }
 
+/// Requests items which have not been requested yet until the read window is full
 void PlanManager::_requestNextMissionItem(void)
 {
     if (_itemIndicesToRead.count() == 0) {
@@ -345,7 +399,45 @@ void PlanManager::_requestNextMissionItem(void)
         return;
     }
 
-    qCDebug(PlanManagerLog) << QStringLiteral("_requestNextMissionItem %1 sequenceNumber:retry").arg(_planTypeString()) << _itemIndicesToRead[0] << _retryCount;
+    // Requests go out in _itemIndicesToRead order, so the outstanding requests are at the front of the list
+    for (int i=0; i<_itemIndicesToRead.count() && _outstandingReadRequests.count() < _readWindowSize; i++) {
+        if (!_outstandingReadRequests.contains(_itemIndicesToRead[i])) {
+            _requestMissionItem(_itemIndicesToRead[i]);
+        }
+    }
+
+    _startAckTimeout(AckMissionItem);
+}
+
+/// Asks again for all outstanding items. Used when the request timeout expires.
+void PlanManager::_resendMissionItemRequests(void)
+{
+    foreach (int sequenceNumber, _outstandingReadRequests.keys()) {
+        _requestMissionItem(sequenceNumber);
+    }
+    _requestNextMissionItem();
+}
+
+/// Items come back in the order they were requested. So when an item arrives, the outstanding requests which were sent
+/// before it most likely lost their item. Those are sent again straight away instead of waiting for the timeout.
+/// Each request is only resent this way once, after that it is left to the timeout.
+///     @param receivedSendIndex Send index of the request for the item which just arrived
+void PlanManager::_resendLostMissionItemRequests(int receivedSendIndex)
+{
+    foreach (int sequenceNumber, _outstandingReadRequests.keys()) {
+        const ReadRequest_t& request = _outstandingReadRequests[sequenceNumber];
+        if (request.sendIndex < receivedSendIndex && !request.resent) {
+            qCDebug(PlanManagerLog) << QStringLiteral("_resendLostMissionItemRequests %1 sequenceNumber").arg(_planTypeString()) << sequenceNumber;
+            _requestMissionItem(sequenceNumber);
+        }
+    }
+}
+
+void PlanManager::_requestMissionItem(int sequenceNumber)
+{
+    bool resent = _outstandingReadRequests.contains(sequenceNumber);
+
+    qCDebug(PlanManagerLog) << QStringLiteral("_requestMissionItem %1 sequenceNumber:retry:resent").arg(_planTypeString()) << sequenceNumber << _retryCount << resent;
 
     mavlink_message_t message;
     if (_vehicle->capabilityBits() & MAV_PROTOCOL_CAPABILITY_MISSION_INT) {
@@ -355,7 +447,7 @@ void PlanManager::_requestNextMissionItem(void)
                                                   &message,
                                                   _vehicle->id(),
                                                   MAV_COMP_ID_MISSIONPLANNER,
-                                                  _itemIndicesToRead[0],
+                                                  sequenceNumber,
                 _planType);
     } else {
         mavlink_msg_mission_request_pack_chan(qgcApp()->toolbox()->mavlinkProtocol()->getSystemId(),
@@ -364,12 +456,14 @@ void PlanManager::_requestNextMissionItem(void)
                                               &message,
                                               _vehicle->id(),
                                               MAV_COMP_ID_MISSIONPLANNER,
-                                              _itemIndicesToRead[0],
+                                              sequenceNumber,
                 _planType);
     }
     
     _vehicle->sendMessageOnLink(_dedicatedLink, message);
-    _startAckTimeout(AckMissionItem);
+
+    ReadRequest_t request = { _rttClock.elapsed(), _readSendIndex++, resent };
+    _outstandingReadRequests[sequenceNumber] = request;
 }
 
 void PlanManager::_handleMissionItem(const mavlink_message_t& message, bool missionItemInt)
@@ -449,6 +543,16 @@ void PlanManager::_handleMissionItem(const mavlink_message_t& message, bool miss
     if (_itemIndicesToRead.contains(seq)) {
         _itemIndicesToRead.removeOne(seq);
 
+        if (_outstandingReadRequests.contains(seq)) {
+            ReadRequest_t request = _outstandingReadRequests.take(seq);
+            if (!request.resent) {
+                _addRttSample(_rttClock.elapsed() - request.sentMSecs);
+            }
+            if (_readWindowSize > 1) {
+                _resendLostMissionItemRequests(request.sendIndex);
+            }
+        }
+
         MissionItem* item = new MissionItem(seq,
                                             command,
                                             frame,
@@ -476,7 +580,7 @@ void PlanManager::_handleMissionItem(const mavlink_message_t& message, bool miss
         return;
     }
 
-    emit progressPct((double)seq / (double)_missionItemCountToRead);
+    emit progressPct((double)(_missionItemCountToRead - _itemIndicesToRead.count()) / (double)_missionItemCountToRead);
     
     _retryCount = 0;
     if (_itemIndicesToRead.count() == 0) {
@@ -520,7 +624,8 @@ void PlanManager::_handleMissionRequest(const mavlink_message_t& message, bool m
     emit progressPct((double)missionRequest.seq / (double)_writeMissionItems.count());
 
     _lastMissionRequest = missionRequest.seq;
-    if (!_itemIndicesToWrite.contains(missionRequest.seq)) {
+    bool resent = !_itemIndicesToWrite.contains(missionRequest.seq);
+    if (resent) {
         qCDebug(PlanManagerLog) << QStringLiteral("_handleMissionRequest %1 sequence number requested which has already been sent, sending again:").arg(_planTypeString()) << missionRequest.seq;
     } else {
         _itemIndicesToWrite.removeOne(missionRequest.seq);
@@ -573,6 +678,7 @@ void PlanManager::_handleMissionRequest(const mavlink_message_t& message, bool m
     }
     
     _vehicle->sendMessageOnLink(_dedicatedLink, messageOut);
+    _setAckSent(resent);
     _startAckTimeout(AckMissionRequest);
 }
 
@@ -824,6 +930,7 @@ void PlanManager::_finishTransaction(bool success, bool apmGuidedItemWrite)
 
     _itemIndicesToRead.clear();
     _itemIndicesToWrite.clear();
+    _outstandingReadRequests.clear();
 
     // First thing we do is clear the transaction. This way inProgesss is off when we signal transaction complete.
     TransactionType_t currentTransactionType = _transactionInProgress;
@@ -900,6 +1007,7 @@ void PlanManager::_removeAllWorker(void)
                                             MAV_COMP_ID_MISSIONPLANNER,
                                             _planType);
     _vehicle->sendMessageOnLink(_vehicle->priorityLink(), message);
+    _setAckSent(_retryCount > 0);
     _startAckTimeout(AckMissionClearAll);
 }
 
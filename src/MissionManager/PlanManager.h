@@ -13,6 +13,8 @@
 #include <QObject>
 #include <QLoggingCategory>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QMap>
 
 #include "MissionItem.h"
 #include "QGCMAVLink.h"
@@ -56,6 +58,17 @@ public:
     ///     Signals removeAllComplete when done
     void removeAll(void);
 
+    /// Maximum number of item requests which are sent without waiting for the matching item during a read. A window
+    /// of 1 is the strict one item at a time sequence. Larger windows hide link latency but require firmware which
+    /// answers item requests in any order. Comes from the PlanTransferWindow setting at the start of each read.
+    int readWindowSize(void) const { return _readWindowSize; }
+
+    /// Smoothed round trip time to the vehicle in milliseconds, -1 if no round trip has been measured yet
+    double smoothedRttMSecs(void) const { return _srttMSecs; }
+
+    /// Current timeout for item requests in milliseconds, adapts to the measured round trip time
+    int retryTimeoutMSecs(void) const { return _retryTimeoutMSecs; }
+
     /// Error codes returned in error signal
     typedef enum {
         InternalError,
@@ -72,8 +85,12 @@ public:
     // These values are public so the unit test can set appropriate signal wait times
     // When passively waiting for a mission process, use a longer timeout.
     static const int _ackTimeoutMilliseconds = 1500;
-    // When actively retrying to request mission items, use a shorter timeout instead.
+    // When actively retrying to request mission items, use a shorter timeout instead. This is the lower bound for
+    // the adaptive retry timeout.
     static const int _retryTimeoutMilliseconds = 250;
+    // Upper bound for the adaptive retry timeout. Keeps the worst case time to detect a dead vehicle close to what
+    // it was with fixed timeouts.
+    static const int _maxRetryTimeoutMilliseconds = 2000;
     static const int _maxRetryCount = 5;
 
 signals:
@@ -117,6 +134,11 @@ protected:
     void _handleMissionRequest(const mavlink_message_t& message, bool missionItemInt);
     void _handleMissionAck(const mavlink_message_t& message);
     void _requestNextMissionItem(void);
+    void _requestMissionItem(int sequenceNumber);
+    void _resendMissionItemRequests(void);
+    void _resendLostMissionItemRequests(int receivedSendIndex);
+    void _setAckSent(bool resent);
+    void _addRttSample(qint64 rttMSecs);
     void _clearMissionItems(void);
     void _sendError(ErrorCode_t errorCode, const QString& errorMsg);
     QString _ackTypeToString(AckType_t ackType);
@@ -149,6 +171,23 @@ protected:
     int                 _lastMissionRequest;    ///< Index of item last requested by MISSION_REQUEST
     int                 _missionItemCountToRead;///< Count of all mission items to read
 
+    typedef struct {
+        qint64  sentMSecs;      ///< Time the request was last sent
+        int     sendIndex;      ///< Position of the last send in the overall send order
+        bool    resent;         ///< true: sent more than once, the response can't be used as a round trip sample
+    } ReadRequest_t;
+
+    QMap<int, ReadRequest_t>    _outstandingReadRequests;   ///< Items requested from the vehicle but not received yet, by sequence number
+    int                         _readWindowSize;            ///< Maximum number of outstanding item requests during a read
+    int                         _readSendIndex;
+
+    QElapsedTimer       _rttClock;
+    qint64              _ackSentMSecs;          ///< Time the message waiting on _expectedAck was sent, -1 for unknown
+    bool                _ackResent;
+    double              _srttMSecs;             ///< Smoothed round trip time, -1 for no samples yet
+    double              _rttVarMSecs;           ///< Round trip time variation
+    int                 _retryTimeoutMSecs;     ///< Current adaptive retry timeout
+
     QList<MissionItem*> _missionItems;          ///< Set of mission items on vehicle
     QList<MissionItem*> _writeMissionItems;     ///< Set of mission items currently being written to vehicle
     int                 _currentMissionIndex;
@@ -0,0 +1,192 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "PolygonScanlineClipper.h"
+
+#include <QtMath>
+
+#include <algorithm>
+
+PolygonScanlineClipper::PolygonScanlineClipper(void)
+    : _cos      (1)
+    , _sin      (0)
+    , _firstX   (0)
+    , _spacing  (1)
+{
+
+}
+
+void PolygonScanlineClipper::clear(void)
+{
+    _vertices.clear();
+    _ringStarts.clear();
+    _crossings.clear();
+    _lineStarts.clear();
+}
+
+void PolygonScanlineClipper::setPolygon(const QPolygonF& polygon)
+{
+    clear();
+    _addRing(polygon);
+}
+
+void PolygonScanlineClipper::addHole(const QPolygonF& hole)
+{
+    _addRing(hole);
+}
+
+void PolygonScanlineClipper::_addRing(const QPolygonF& ring)
+{
+    int count = ring.count();
+    if (count > 1 && ring.first() == ring.last()) {
+        // Closing vertex is implied
+        count--;
+    }
+    if (count < 3) {
+        return;
+    }
+
+    _ringStarts.append(_vertices.count());
+    for (int i=0; i<count; i++) {
+        Vertex_t vertex = { ring[i].x(), ring[i].y() };
+        _vertices.append(vertex);
+    }
+}
+
+void PolygonScanlineClipper::clip(const QPointF& origin, double angle, double firstX, double spacing, int lineCount)
+{
+    double radians = qDegreesToRadians(angle);
+
+    _origin     = origin;
+    _cos        = qCos(radians);
+    _sin        = qSin(radians);
+    _firstX     = firstX;
+    _spacing    = spacing;
+
+    lineCount = qMax(lineCount, 0);
+    _crossings.resize(0);
+    _lineStarts.fill(0, lineCount + 1);
+
+    if (lineCount == 0 || spacing <= 0) {
+        return;
+    }
+
+    // Rotate the polygon into the frame where the scan lines are vertical. This is the inverse of the rotation
+    // which is applied to the scan lines.
+    _rotated.resize(_vertices.count());
+    for (int i=0; i<_vertices.count(); i++) {
+        double dx = _vertices[i].x - origin.x();
+        double dy = _vertices[i].y - origin.y();
+        _rotated[i].x = (dx * _cos) - (dy * _sin) + origin.x();
+        _rotated[i].y = (dx * _sin) + (dy * _cos) + origin.y();
+    }
+
+    // Two passes over the edges. The first counts the crossings for each line so the second can write them
+    // straight into their final position in the flat crossing array.
+    for (int pass=0; pass<2; pass++) {
+        QVector<int> writeIndex;
+        if (pass == 1) {
+            for (int i=0; i<lineCount; i++) {
+                _lineStarts[i + 1] += _lineStarts[i];
+            }
+            _crossings.resize(_lineStarts[lineCount]);
+            writeIndex = _lineStarts;
+        }
+
+        for (int ring=0; ring<_ringStarts.count(); ring++) {
+            int ringStart = _ringStarts[ring];
+            int ringEnd = ring + 1 < _ringStarts.count() ? _ringStarts[ring + 1] : _rotated.count();
+
+            for (int edge=ringStart; edge<ringEnd; edge++) {
+                const Vertex_t& from = _rotated[edge];
+                const Vertex_t& to = _rotated[edge + 1 < ringEnd ? edge + 1 : ringStart];
+
+                if (from.x == to.x) {
+                    // Parallel to the scan lines
+                    continue;
+                }
+
+                double minX = qMin(from.x, to.x);
+                double maxX = qMax(from.x, to.x);
+                double slope = (to.y - from.y) / (to.x - from.x);
+
+                // Pad the index range by one on each side and let the half open test decide, that way rounding in
+                // the index calculation can't drop or double count a crossing.
+                int firstLine = qMax(0, static_cast<int>(qCeil((minX - firstX) / spacing)) - 1);
+                int lastLine = qMin(lineCount - 1, static_cast<int>(qCeil((maxX - firstX) / spacing)));
+
+                for (int line=firstLine; line<=lastLine; line++) {
+                    double lineX = firstX + (line * spacing);
+                    if (lineX < minX || lineX >= maxX) {
+                        continue;
+                    }
+                    if (pass == 0) {
+                        _lineStarts[line + 1]++;
+                    } else {
+                        Crossing_t crossing = { from.y + ((lineX - from.x) * slope), edge };
+                        _crossings[writeIndex[line]++] = crossing;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int i=0; i<lineCount; i++) {
+        if (crossingCount(i) > 1) {
+            std::sort(_crossings.begin() + _lineStarts[i], _crossings.begin() + _lineStarts[i + 1],
+                      [](const Crossing_t& a, const Crossing_t& b) { return a.y < b.y; });
+        }
+    }
+}
+
+/// Converts a point in the scan frame back to polygon coordinates
+QPointF PolygonScanlineClipper::_unrotate(double x, double y) const
+{
+    double dx = x - _origin.x();
+    double dy = y - _origin.y();
+    return QPointF((dx * _cos) + (dy * _sin) + _origin.x(), -(dx * _sin) + (dy * _cos) + _origin.y());
+}
+
+bool PolygonScanlineClipper::span(int lineIndex, QLineF& span) const
+{
+    if (crossingCount(lineIndex) < 2) {
+        return false;
+    }
+
+    const Crossing_t& first = _crossings[_lineStarts[lineIndex]];
+    const Crossing_t& last = _crossings[_lineStarts[lineIndex + 1] - 1];
+    if (first.y == last.y) {
+        return false;
+    }
+
+    double lineX = _firstX + (lineIndex * _spacing);
+    QPointF firstPoint = _unrotate(lineX, first.y);
+    QPointF lastPoint = _unrotate(lineX, last.y);
+    if (first.edge <= last.edge) {
+        span.setPoints(firstPoint, lastPoint);
+    } else {
+        span.setPoints(lastPoint, firstPoint);
+    }
+
+    return true;
+}
+
+QList<QLineF> PolygonScanlineClipper::segments(int lineIndex) const
+{
+    QList<QLineF> segments;
+
+    double lineX = _firstX + (lineIndex * _spacing);
+    for (int i=_lineStarts[lineIndex]; i+1<_lineStarts[lineIndex + 1]; i+=2) {
+        if (_crossings[i].y != _crossings[i + 1].y) {
+            segments.append(QLineF(_unrotate(lineX, _crossings[i].y), _unrotate(lineX, _crossings[i + 1].y)));
+        }
+    }
+
+    return segments;
+}
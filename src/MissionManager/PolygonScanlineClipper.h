@@ -0,0 +1,89 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QVector>
+#include <QList>
+#include <QPointF>
+#include <QLineF>
+#include <QPolygonF>
+
+/// Clips a set of evenly spaced parallel scan lines against a polygon with optional holes.
+///
+/// The polygon is rotated into a frame where the scan lines are vertical. Each edge is then visited once and its
+/// crossings are computed directly for the range of scan lines it spans, so the cost is O(edges + crossings)
+/// instead of testing every line against every edge. Vertices and crossings are kept in flat arrays which are
+/// reused between calls to clip.
+///
+/// Crossings are counted with a half open rule on the scan axis so a line passing exactly through a vertex is
+/// counted once. Inside segments use the even-odd rule, which handles concave polygons and holes.
+class PolygonScanlineClipper
+{
+public:
+    PolygonScanlineClipper(void);
+
+    /// Sets the outer boundary. Any previous boundary and holes are removed. The ring can be open or closed.
+    void setPolygon(const QPolygonF& polygon);
+
+    /// Adds a hole inside the outer boundary. The ring can be open or closed.
+    void addHole(const QPolygonF& hole);
+
+    void clear(void);
+
+    int vertexCount (void) const { return _vertices.count(); }
+    int ringCount   (void) const { return _ringStarts.count(); }
+
+    /// Clips scan lines against the polygon. Before rotation scan line i is the vertical line x = firstX + i * spacing.
+    /// The lines are then rotated around origin by angle degrees, using the same convention as the survey grid: positive
+    /// angles rotate clockwise when y points north.
+    void clip(const QPointF& origin, double angle, double firstX, double spacing, int lineCount);
+
+    /// @return Number of scan lines from the last call to clip
+    int lineCount(void) const { return _lineStarts.count() ? _lineStarts.count() - 1 : 0; }
+
+    /// @return Number of polygon edges crossed by the specified scan line
+    int crossingCount(int lineIndex) const { return _lineStarts[lineIndex + 1] - _lineStarts[lineIndex]; }
+
+    /// Returns the line between the two outermost crossings of a scan line. This ignores concavities and holes.
+    /// P1 is the crossing on the lower numbered polygon edge. This is the same order the original brute force
+    /// intersection produced, the survey entry point corners depend on it.
+    ///     @return false: Scan line crosses less than two edges
+    bool span(int lineIndex, QLineF& span) const;
+
+    /// @return Segments of the scan line which are inside the polygon, ordered along the scan line
+    QList<QLineF> segments(int lineIndex) const;
+
+private:
+    typedef struct {
+        double  y;      ///< Position along the scan line in the rotated frame
+        int     edge;   ///< Index of the polygon edge which was crossed
+    } Crossing_t;
+
+    typedef struct {
+        double x;
+        double y;
+    } Vertex_t;
+
+    void    _addRing    (const QPolygonF& ring);
+    QPointF _unrotate   (double x, double y) const;
+
+    QVector<Vertex_t>   _vertices;      ///< All ring vertices back to back
+    QVector<int>        _ringStarts;    ///< Index into _vertices of the first vertex for each ring
+
+    QVector<Vertex_t>   _rotated;       ///< _vertices rotated into the scan frame by the last clip
+    QVector<Crossing_t> _crossings;     ///< Crossings of all scan lines, grouped by line and sorted along each line
+    QVector<int>        _lineStarts;    ///< Index into _crossings of the first crossing for each line, plus an end marker
+
+    QPointF _origin;
+    double  _cos;
+    double  _sin;
+    double  _firstX;
+    double  _spacing;
+};
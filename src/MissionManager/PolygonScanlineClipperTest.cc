@@ -0,0 +1,257 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "PolygonScanlineClipperTest.h"
+#include "SurveyComplexItem.h"
+
+#include <QElapsedTimer>
+#include <QtMath>
+
+PolygonScanlineClipperTest::PolygonScanlineClipperTest(void)
+{
+
+}
+
+/// Same rotation as the survey grid generation
+QPointF PolygonScanlineClipperTest::_rotatePoint(const QPointF& point, const QPointF& origin, double angle)
+{
+    QPointF rotated;
+    double radians = (M_PI / 180.0) * -angle;
+
+    rotated.setX(((point.x() - origin.x()) * cos(radians)) - ((point.y() - origin.y()) * sin(radians)) + origin.x());
+    rotated.setY(((point.x() - origin.x()) * sin(radians)) + ((point.y() - origin.y()) * cos(radians)) + origin.y());
+
+    return rotated;
+}
+
+bool PolygonScanlineClipperTest::_fuzzyCompare(const QPointF& point1, const QPointF& point2)
+{
+    return qAbs(point1.x() - point2.x()) < 1e-6 && qAbs(point1.y() - point2.y()) < 1e-6;
+}
+
+/// Concave star shaped polygon with irregular spikes
+QPolygonF PolygonScanlineClipperTest::_starPolygon(int vertexCount, double radius)
+{
+    QPolygonF polygon;
+
+    for (int i=0; i<vertexCount; i++) {
+        double angle = (2.0 * M_PI * i) / vertexCount;
+        double vertexRadius = radius * (i & 1 ? 0.6 + (0.3 * qSin(i * 0.37)) : 1.0);
+        polygon << QPointF(vertexRadius * qCos(angle), vertexRadius * qSin(angle));
+    }
+    polygon << polygon.first();
+
+    return polygon;
+}
+
+QList<QLineF> PolygonScanlineClipperTest::_scanLines(const QPointF& origin, double angle, double firstX, double spacing, int lineCount, double halfLength)
+{
+    QList<QLineF> lines;
+
+    for (int i=0; i<lineCount; i++) {
+        double x = firstX + (i * spacing);
+        lines += QLineF(_rotatePoint(QPointF(x, origin.y() - halfLength), origin, angle), _rotatePoint(QPointF(x, origin.y() + halfLength), origin, angle));
+    }
+
+    return lines;
+}
+
+/// This is the original survey intersection: each line is tested against every polygon edge
+bool PolygonScanlineClipperTest::_bruteForceSpan(const QLineF& line, const QPolygonF& polygon, QLineF& span)
+{
+    QList<QPointF> intersections;
+
+    for (int j=0; j<polygon.count()-1; j++) {
+        QPointF intersectPoint;
+        QLineF polygonLine = QLineF(polygon[j], polygon[j+1]);
+        if (line.intersect(polygonLine, &intersectPoint) == QLineF::BoundedIntersection) {
+            if (!intersections.contains(intersectPoint)) {
+                intersections.append(intersectPoint);
+            }
+        }
+    }
+
+    if (intersections.count() < 2) {
+        return false;
+    }
+
+    double currentMaxDistance = 0;
+    for (int i=0; i<intersections.count(); i++) {
+        for (int j=0; j<intersections.count(); j++) {
+            double newMaxDistance = QLineF(intersections[i], intersections[j]).length();
+            if (newMaxDistance > currentMaxDistance) {
+                span.setPoints(intersections[i], intersections[j]);
+                currentMaxDistance = newMaxDistance;
+            }
+        }
+    }
+
+    return true;
+}
+
+void PolygonScanlineClipperTest::_testConvex(void)
+{
+    PolygonScanlineClipper clipper;
+    QPolygonF square;
+
+    square << QPointF(0, 0) << QPointF(10, 0) << QPointF(10, 10) << QPointF(0, 10);
+    clipper.setPolygon(square);
+    QCOMPARE(clipper.vertexCount(), 4);
+
+    // Lines outside the polygon on either side have no span
+    clipper.clip(QPointF(5, 5), 0, -0.5, 1, 12);
+    QCOMPARE(clipper.lineCount(), 12);
+    QLineF span;
+    QVERIFY(!clipper.span(0, span));
+    QVERIFY(!clipper.span(11, span));
+    for (int i=1; i<11; i++) {
+        QCOMPARE(clipper.crossingCount(i), 2);
+        QVERIFY(clipper.span(i, span));
+        QCOMPARE(span.length(), 10.0);
+        QCOMPARE(clipper.segments(i).count(), 1);
+    }
+
+    // Rotated by 90 degrees the scan lines are horizontal
+    clipper.clip(QPointF(5, 5), 90, 5, 1, 1);
+    QVERIFY(clipper.span(0, span));
+    QVERIFY(qAbs(span.p1().y() - 5) < 1e-9);
+    QVERIFY(qAbs(span.p2().y() - 5) < 1e-9);
+    QVERIFY(qAbs(span.length() - 10) < 1e-9);
+}
+
+void PolygonScanlineClipperTest::_testConcave(void)
+{
+    PolygonScanlineClipper clipper;
+    QPolygonF u;
+
+    // U shape, open to the top with the notch between x 3 and 7
+    u << QPointF(0, 0) << QPointF(10, 0) << QPointF(10, 10) << QPointF(7, 10) << QPointF(7, 4) << QPointF(3, 4) << QPointF(3, 10) << QPointF(0, 10);
+    clipper.setPolygon(u);
+
+    clipper.clip(QPointF(5, 5), 0, 5, 1, 1);
+    QLineF span;
+    QVERIFY(clipper.span(0, span));
+    QCOMPARE(span.length(), 4.0);
+
+    // Horizontal line through both arms of the U
+    clipper.clip(QPointF(5, 5), 90, 5, 1, 1);
+    QCOMPARE(clipper.crossingCount(0), 4);
+    QVERIFY(clipper.span(0, span));
+    QVERIFY(qAbs(span.length() - 10) < 1e-9);
+    QList<QLineF> segments = clipper.segments(0);
+    QCOMPARE(segments.count(), 2);
+    QVERIFY(qAbs(segments[0].length() - 3) < 1e-9);
+    QVERIFY(qAbs(segments[1].length() - 3) < 1e-9);
+}
+
+void PolygonScanlineClipperTest::_testHole(void)
+{
+    PolygonScanlineClipper clipper;
+    QPolygonF outer;
+    QPolygonF hole;
+
+    outer << QPointF(0, 0) << QPointF(10, 0) << QPointF(10, 10) << QPointF(0, 10) << QPointF(0, 0);
+    hole << QPointF(4, 4) << QPointF(6, 4) << QPointF(6, 6) << QPointF(4, 6);
+    clipper.setPolygon(outer);
+    clipper.addHole(hole);
+    QCOMPARE(clipper.ringCount(), 2);
+    QCOMPARE(clipper.vertexCount(), 8);
+
+    clipper.clip(QPointF(5, 5), 0, 2, 3, 3);
+
+    // Lines at x 2 and 8 miss the hole
+    QCOMPARE(clipper.segments(0).count(), 1);
+    QCOMPARE(clipper.segments(2).count(), 1);
+
+    // Line at x 5 goes through the hole
+    QList<QLineF> segments = clipper.segments(1);
+    QCOMPARE(segments.count(), 2);
+    QCOMPARE(segments[0].length(), 4.0);
+    QCOMPARE(segments[1].length(), 4.0);
+    QVERIFY(segments[0].p2().y() <= segments[1].p1().y());
+
+    // Span ignores the hole
+    QLineF span;
+    QVERIFY(clipper.span(1, span));
+    QCOMPARE(span.length(), 10.0);
+}
+
+void PolygonScanlineClipperTest::_testMatchesBruteForce(void)
+{
+    QPolygonF polygon = _starPolygon(157, 500);
+    QPointF origin = polygon.boundingRect().center();
+    double halfLength = 1500;
+    double spacing = 7.3;
+    int lineCount = qCeil((2 * halfLength) / spacing);
+
+    PolygonScanlineClipper clipper;
+    clipper.setPolygon(polygon);
+
+    for (double angle=-90; angle<=180; angle+=17.5) {
+        clipper.clip(origin, angle, origin.x() - halfLength, spacing, lineCount);
+        QList<QLineF> lines = _scanLines(origin, angle, origin.x() - halfLength, spacing, lineCount, halfLength);
+        QCOMPARE(clipper.lineCount(), lines.count());
+
+        int spanCount = 0;
+        for (int i=0; i<lines.count(); i++) {
+            QLineF bruteForceSpan;
+            QLineF clipperSpan;
+            bool bruteForceFound = _bruteForceSpan(lines[i], polygon, bruteForceSpan);
+            QCOMPARE(clipper.span(i, clipperSpan), bruteForceFound);
+            if (bruteForceFound) {
+                // Same points, in the same order, as the brute force intersection
+                QVERIFY(_fuzzyCompare(clipperSpan.p1(), bruteForceSpan.p1()));
+                QVERIFY(_fuzzyCompare(clipperSpan.p2(), bruteForceSpan.p2()));
+                spanCount++;
+            }
+        }
+        QVERIFY(spanCount > 100);
+    }
+}
+
+void PolygonScanlineClipperTest::_benchmarkClip(void)
+{
+    UT_BENCHMARK();
+
+    // Similar to a detailed KML boundary with a tight grid
+    QPolygonF polygon = _starPolygon(5000, 2000);
+    QPointF origin = polygon.boundingRect().center();
+    double halfLength = 3000;
+    double spacing = 5;
+    int lineCount = qCeil((2 * halfLength) / spacing);
+    QElapsedTimer timer;
+
+    timer.start();
+    QList<QLineF> lines = _scanLines(origin, 30, origin.x() - halfLength, spacing, lineCount, halfLength);
+    int bruteForceCount = 0;
+    foreach (const QLineF& line, lines) {
+        QLineF span;
+        if (_bruteForceSpan(line, polygon, span)) {
+            bruteForceCount++;
+        }
+    }
+    qint64 bruteForceNSecs = timer.nsecsElapsed();
+
+    timer.start();
+    PolygonScanlineClipper clipper;
+    clipper.setPolygon(polygon);
+    clipper.clip(origin, 30, origin.x() - halfLength, spacing, lineCount);
+    int clipperCount = 0;
+    for (int i=0; i<clipper.lineCount(); i++) {
+        QLineF span;
+        if (clipper.span(i, span)) {
+            clipperCount++;
+        }
+    }
+    qint64 clipperNSecs = timer.nsecsElapsed();
+
+    qCDebug(SurveyComplexItemLog) << "Survey grid 5000 vertices" << lineCount << "lines: brute force msecs" << bruteForceNSecs / 1.0e6 << "scanline msecs" << clipperNSecs / 1.0e6;
+
+    QCOMPARE(clipperCount, bruteForceCount);
+}
@@ -0,0 +1,35 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+#include "PolygonScanlineClipper.h"
+
+class PolygonScanlineClipperTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    PolygonScanlineClipperTest(void);
+
+private slots:
+    void _testConvex(void);
+    void _testConcave(void);
+    void _testHole(void);
+    void _testMatchesBruteForce(void);
+    void _benchmarkClip(void);
+
+private:
+    QPolygonF   _starPolygon        (int vertexCount, double radius);
+    QList<QLineF> _scanLines        (const QPointF& origin, double angle, double firstX, double spacing, int lineCount, double halfLength);
+    bool        _bruteForceSpan     (const QLineF& line, const QPolygonF& polygon, QLineF& span);
+    static QPointF _rotatePoint     (const QPointF& point, const QPointF& origin, double angle);
+    static bool _fuzzyCompare       (const QPointF& point1, const QPointF& point2);
+};
@@ -282,14 +282,27 @@ QList<QPointF> QGCMapPolyline::nedPolyline(void)
 
 
 QList<QGeoCoordinate> QGCMapPolyline::offsetPolyline(double distance)
+{
+    return offsetPolyline(coordinateList(), distance);
+}
+
+QList<QGeoCoordinate> QGCMapPolyline::offsetPolyline(const QList<QGeoCoordinate>& polyline, double distance)
 {
     QList<QGeoCoordinate> rgNewPolyline;
 
     // I'm sure there is some beautiful famous algorithm to do this, but here is a brute force method
 
-    if (count() > 1) {
+    if (polyline.count() > 1) {
+        QGeoCoordinate  tangentOrigin = polyline[0];
+
         // Convert the polygon to NED
-        QList<QPointF> rgNedVertices = nedPolyline();
+        QList<QPointF> rgNedVertices;
+        rgNedVertices += QPointF(0, 0);     // This avoids a nan calculation that comes out of convertGeoToNed
+        for (int i=1; i<polyline.count(); i++) {
+            double y, x, down;
+            convertGeoToNed(polyline[i], tangentOrigin, &y, &x, &down);
+            rgNedVertices += QPointF(x, y);
+        }
 
         // Walk the edges, offsetting by the specified distance
         QList<QLineF> rgOffsetEdges;
@@ -310,8 +323,6 @@ QList<QGeoCoordinate> QGCMapPolyline::offsetPolyline(double distance)
             rgOffsetEdges.append(offsetEdge);
         }
 
-        QGeoCoordinate  tangentOrigin = vertexCoordinate(0);
-
         // Add first vertex
         QGeoCoordinate coord;
         convertNedToGeo(rgOffsetEdges[0].p1().y(), rgOffsetEdges[0].p1().x(), 0, tangentOrigin, &coord);
@@ -48,6 +48,10 @@ public:
     /// @return Offset set of vertices
     QList<QGeoCoordinate> offsetPolyline(double distance);
 
+    /// Offsets the edges of the specified polyline by the specified distance in meters. Safe to call from any thread.
+    /// @return Offset set of vertices
+    static QList<QGeoCoordinate> offsetPolyline(const QList<QGeoCoordinate>& polyline, double distance);
+
     /// Loads a polyline from a KML file
     /// @return true: success
     Q_INVOKABLE bool loadKMLFile(const QString& kmlFile);
@@ -16,8 +16,10 @@
 #include "QGCQGeoCoordinate.h"
 #include "SettingsManager.h"
 #include "AppSettings.h"
+#include "PolygonScanlineClipper.h"
 
 #include <QPolygonF>
+#include <QtNumeric>
 
 QGC_LOGGING_CATEGORY(SurveyComplexItemLog, "SurveyComplexItemLog")
 
@@ -372,7 +374,7 @@ void SurveyComplexItem::_optimizeTransectsForShortestDistance(const QGeoCoordina
 
     int shortestIndex = 0;
     double shortestDistance = rgTransectDistance[0];
-    for (int i=1; i<3; i++) {
+    for (int i=1; i<4; i++) {
         if (rgTransectDistance[i] < shortestDistance) {
             shortestIndex = i;
             shortestDistance = rgTransectDistance[i];
@@ -414,7 +416,7 @@ bool SurveyComplexItem::_gridAngleIsNorthSouthTransects()
     return gridAngle < 45.0 || (gridAngle > 360.0 - 45.0) || (gridAngle > 90.0 + 45.0 && gridAngle < 270.0 - 45.0);
 }
 
-void SurveyComplexItem::_adjustTransectsToEntryPointLocation(QList<QList<QGeoCoordinate>>& transects)
+void SurveyComplexItem::_adjustTransectsToEntryPointLocation(QList<QList<QGeoCoordinate>>& transects, int entryPoint)
 {
     if (transects.count() == 0) {
         return;
@@ -423,10 +425,10 @@ void SurveyComplexItem::_adjustTransectsToEntryPointLocation(QList<QList<QGeoCoo
     bool reversePoints = false;
     bool reverseTransects = false;
 
-    if (_entryPoint == EntryLocationBottomLeft || _entryPoint == EntryLocationBottomRight) {
+    if (entryPoint == EntryLocationBottomLeft || entryPoint == EntryLocationBottomRight) {
         reversePoints = true;
     }
-    if (_entryPoint == EntryLocationTopRight || _entryPoint == EntryLocationBottomRight) {
+    if (entryPoint == EntryLocationTopRight || entryPoint == EntryLocationBottomRight) {
         reverseTransects = true;
     }
 
@@ -439,7 +441,7 @@ void SurveyComplexItem::_adjustTransectsToEntryPointLocation(QList<QList<QGeoCoo
         _reverseTransectOrder(transects);
     }
 
-    qCDebug(SurveyComplexItemLog) << "_adjustTransectsToEntryPointLocation Modified entry point:entryLocation" << transects.first().first() << _entryPoint;
+    qCDebug(SurveyComplexItemLog) << "_adjustTransectsToEntryPointLocation Modified entry point:entryLocation" << transects.first().first() << entryPoint;
 }
 
 QPointF SurveyComplexItem::_rotatePoint(const QPointF& point, const QPointF& origin, double angle)
@@ -510,50 +512,6 @@ void SurveyComplexItem::_intersectLinesWithRect(const QList<QLineF>& lineList, c
     }
 }
 
-void SurveyComplexItem::_intersectLinesWithPolygon(const QList<QLineF>& lineList, const QPolygonF& polygon, QList<QLineF>& resultLines)
-{
-    resultLines.clear();
-
-    for (int i=0; i<lineList.count(); i++) {
-        const QLineF& line = lineList[i];
-        QList<QPointF> intersections;
-
-        // Intersect the line with all the polygon edges
-        for (int j=0; j<polygon.count()-1; j++) {
-            QPointF intersectPoint;
-            QLineF polygonLine = QLineF(polygon[j], polygon[j+1]);
-            if (line.intersect(polygonLine, &intersectPoint) == QLineF::BoundedIntersection) {
-                if (!intersections.contains(intersectPoint)) {
-                    intersections.append(intersectPoint);
-                }
-            }
-        }
-
-        // We now have one or more intersection points all along the same line. Find the two
-        // which are furthest away from each other to form the transect.
-        if (intersections.count() > 1) {
-            QPointF firstPoint;
-            QPointF secondPoint;
-            double currentMaxDistance = 0;
-
-            for (int i=0; i<intersections.count(); i++) {
-                for (int j=0; j<intersections.count(); j++) {
-                    QLineF lineTest(intersections[i], intersections[j]);
-                    \
-                    double newMaxDistance = lineTest.length();
-                    if (newMaxDistance > currentMaxDistance) {
-                        firstPoint = intersections[i];
-                        secondPoint = intersections[j];
-                        currentMaxDistance = newMaxDistance;
-                    }
-                }
-            }
-
-            resultLines += QLineF(firstPoint, secondPoint);
-        }
-    }
-}
-
 /// Adjust the line segments such that they are all going the same direction with respect to going from P1->P2
 void SurveyComplexItem::_adjustLineDirection(const QList<QLineF>& lineList, QList<QLineF>& resultLines)
 {
@@ -1060,43 +1018,94 @@ bool SurveyComplexItem::_hoverAndCaptureEnabled(void) const
 
 void SurveyComplexItem::_rebuildTransectsPhase1(void)
 {
-    _rebuildTransectsPhase1Worker(false /* refly */);
-    if (_refly90DegreesFact.rawValue().toBool()) {
-        _rebuildTransectsPhase1Worker(true /* refly */);
-    }
+    QAtomicInt notCancelled(0);
+
+    // If the transects are getting rebuilt then any previously loaded mission items are now invalid
+    _clearLoadedMissionItems();
+    _transectsPathHeightInfo.clear();
+    _transects = _generateTransects(_transectParams(), notCancelled);
 }
 
-void SurveyComplexItem::_rebuildTransectsPhase1Worker(bool refly)
+SurveyComplexItem::TransectParams_t SurveyComplexItem::_transectParams(void)
 {
-    if (_ignoreRecalc) {
-        return;
+    TransectParams_t params;
+
+    params.polygon                  = _surveyAreaPolygon.coordinateList();
+    params.gridAngle                = _gridAngleFact.rawValue().toDouble();
+    params.gridSpacing              = _cameraCalc.adjustedFootprintSide()->rawValue().toDouble();
+    params.entryPoint               = _entryPoint;
+    params.refly90Degrees           = _refly90DegreesFact.rawValue().toBool();
+    params.flyAlternateTransects    = _flyAlternateTransectsFact.rawValue().toBool();
+    params.hoverAndCapture          = triggerCamera() && hoverAndCaptureEnabled();
+    params.triggerDistance          = triggerDistance();
+    params.turnAroundDistance       = _hasTurnaround() ? _turnAroundDistanceFact.rawValue().toDouble() : 0;
+
+    return params;
+}
+
+TransectStyleComplexItem::TransectGenerator_t SurveyComplexItem::_transectGenerator(void)
+{
+    TransectParams_t params = _transectParams();
+
+    return [params](const QAtomicInt& cancelled) { return _generateTransects(params, cancelled); };
+}
+
+double SurveyComplexItem::_transectGenerationCost(void)
+{
+    // Clipping is linear in grid lines plus polygon edges, after that each transect point is converted back to geo
+    QList<QGeoCoordinate> polygon = _surveyAreaPolygon.coordinateList();
+    double gridSpacing = _cameraCalc.adjustedFootprintSide()->rawValue().toDouble();
+
+    if (polygon.count() < 3 || gridSpacing <= 0) {
+        return 0;
     }
 
-    // If the transects are getting rebuilt then any previously loaded mission items are now invalid
-    if (_loadedMissionItemsParent) {
-        _loadedMissionItems.clear();
-        _loadedMissionItemsParent->deleteLater();
-        _loadedMissionItemsParent = NULL;
+    double maxVertexDistance = 0;
+    for (int i=1; i<polygon.count(); i++) {
+        maxVertexDistance = qMax(maxVertexDistance, polygon[0].distanceTo(polygon[i]));
     }
 
-    // First pass will clear old transect data, refly will append to existing data
-    if (!refly) {
-        _transects.clear();
-        _transectsPathHeightInfo.clear();
+    // Grid lines cover the bounding rect plus 2000 meters, see _generateTransectsWorker
+    double lineCount = (maxVertexDistance + 2000.0) / gridSpacing;
+    double pointsPerTransect = 1;
+    double triggerSpacing = triggerDistance();
+    // Camera triggering off or a trigger distance of 0 means no extra points per transect
+    if (triggerCamera() && hoverAndCaptureEnabled() && triggerSpacing > 0 && qIsFinite(triggerSpacing)) {
+        pointsPerTransect += maxVertexDistance / triggerSpacing;
     }
+    double cost = ((lineCount * pointsPerTransect) + polygon.count()) * (_refly90DegreesFact.rawValue().toBool() ? 2 : 1);
+    return qIsFinite(cost) ? cost : 0;
+}
+
+/// Generates the full set of transects, including the refly pass. Only uses the values in params so it can be run
+/// from a worker thread.
+///     @param cancelled Generation stops early once this is set, the returned transects are then incomplete
+QList<QList<TransectStyleComplexItem::CoordInfo_t>> SurveyComplexItem::_generateTransects(const TransectParams_t& params, const QAtomicInt& cancelled)
+{
+    QList<QList<CoordInfo_t>> transects;
 
-    if (_surveyAreaPolygon.count() < 3) {
+    _generateTransectsWorker(params, false /* refly */, transects, cancelled);
+    if (params.refly90Degrees && !cancelled.loadAcquire()) {
+        _generateTransectsWorker(params, true /* refly */, transects, cancelled);
+    }
+
+    return transects;
+}
+
+void SurveyComplexItem::_generateTransectsWorker(const TransectParams_t& params, bool refly, QList<QList<CoordInfo_t>>& coordInfoTransects, const QAtomicInt& cancelled)
+{
+    if (params.polygon.count() < 3 || params.gridSpacing <= 0) {
         return;
     }
 
     // Convert polygon to NED
 
     QList<QPointF> polygonPoints;
-    QGeoCoordinate tangentOrigin = _surveyAreaPolygon.pathModel().value<QGCQGeoCoordinate*>(0)->coordinate();
-    qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 Convert polygon to NED - _surveyAreaPolygon.count():tangentOrigin" << _surveyAreaPolygon.count() << tangentOrigin;
-    for (int i=0; i<_surveyAreaPolygon.count(); i++) {
+    QGeoCoordinate tangentOrigin = params.polygon[0];
+    qCDebug(SurveyComplexItemLog) << "_generateTransectsWorker Convert polygon to NED - polygon.count():tangentOrigin" << params.polygon.count() << tangentOrigin;
+    for (int i=0; i<params.polygon.count(); i++) {
         double y, x, down;
-        QGeoCoordinate vertex = _surveyAreaPolygon.pathModel().value<QGCQGeoCoordinate*>(i)->coordinate();
+        const QGeoCoordinate& vertex = params.polygon[i];
         if (i == 0) {
             // This avoids a nan calculation that comes out of convertGeoToNed
             x = y = 0;
@@ -1104,23 +1113,23 @@ void SurveyComplexItem::_rebuildTransectsPhase1Worker(bool refly)
             convertGeoToNed(vertex, tangentOrigin, &y, &x, &down);
         }
         polygonPoints += QPointF(x, y);
-        qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 vertex:x:y" << vertex << polygonPoints.last().x() << polygonPoints.last().y();
+        qCDebug(SurveyComplexItemLog) << "_generateTransectsWorker vertex:x:y" << vertex << polygonPoints.last().x() << polygonPoints.last().y();
     }
 
     // Generate transects
 
-    double gridAngle = _gridAngleFact.rawValue().toDouble();
-    double gridSpacing = _cameraCalc.adjustedFootprintSide()->rawValue().toDouble();
+    double gridAngle = params.gridAngle;
+    double gridSpacing = params.gridSpacing;
 
     gridAngle = _clampGridAngle90(gridAngle);
     gridAngle += refly ? 90 : 0;
-    qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 Clamped grid angle" << gridAngle;
+    qCDebug(SurveyComplexItemLog) << "_generateTransectsWorker Clamped grid angle" << gridAngle;
 
-    qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 gridSpacing:gridAngle:refly" << gridSpacing << gridAngle << refly;
+    qCDebug(SurveyComplexItemLog) << "_generateTransectsWorker gridSpacing:gridAngle:refly" << gridSpacing << gridAngle << refly;
 
     // Convert polygon to bounding rect
 
-    qCDebug(SurveyComplexItemLog) << "_rebuildTransectsPhase1 Polygon";
+    qCDebug(SurveyComplexItemLog) << "_generateTransectsWorker Polygon";
     QPolygonF polygon;
     for (int i=0; i<polygonPoints.count(); i++) {
         qCDebug(SurveyComplexItemLog) << "Vertex" << polygonPoints[i];
@@ -1131,48 +1140,40 @@ void SurveyComplexItem::_rebuildTransectsPhase1Worker(bool refly)
     QPointF boundingCenter = boundingRect.center();
     qCDebug(SurveyComplexItemLog) << "Bounding rect" << boundingRect.topLeft().x() << boundingRect.topLeft().y() << boundingRect.bottomRight().x() << boundingRect.bottomRight().y();
 
-    // Create set of rotated parallel lines within the expanded bounding rect. Make the lines larger than the
-    // bounding box to guarantee intersection.
-
-    QList<QLineF> lineList;
-
-    // Transects are generated to be as long as the largest width/height of the bounding rect plus some fudge factor.
-    // This way they will always be guaranteed to intersect with a polygon edge no matter what angle they are rotated to.
+    // Clip a set of rotated parallel lines against the polygon. The lines cover the expanded bounding rect which guarantees
+    // they span the whole polygon no matter what angle they are rotated to.
+    //
     // They are initially generated with the transects flowing from west to east and then points within the transect north to south.
     double maxWidth = qMax(boundingRect.width(), boundingRect.height()) + 2000.0;
     double halfWidth = maxWidth / 2.0;
-    double transectX = boundingCenter.x() - halfWidth;
-    double transectXMax = transectX + maxWidth;
-    while (transectX < transectXMax) {
-        double transectYTop = boundingCenter.y() - halfWidth;
-        double transectYBottom = boundingCenter.y() + halfWidth;
+    int lineCount = qCeil(maxWidth / gridSpacing);
 
-        lineList += QLineF(_rotatePoint(QPointF(transectX, transectYTop), boundingCenter, gridAngle), _rotatePoint(QPointF(transectX, transectYBottom), boundingCenter, gridAngle));
-        transectX += gridSpacing;
+    PolygonScanlineClipper clipper;
+    clipper.setPolygon(polygon);
+    clipper.clip(boundingCenter, gridAngle, boundingCenter.x() - halfWidth, gridSpacing, lineCount);
+
+    if (cancelled.loadAcquire()) {
+        return;
     }
 
-    // Now intersect the lines with the polygon
     QList<QLineF> intersectLines;
-#if 1
-    _intersectLinesWithPolygon(lineList, polygon, intersectLines);
-#else
-    // This is handy for debugging grid problems, not for release
-    intersectLines = lineList;
-#endif
+    for (int i=0; i<clipper.lineCount(); i++) {
+        QLineF span;
+        if (clipper.span(i, span)) {
+            intersectLines += span;
+        }
+    }
 
     // Less than two transects intersected with the polygon:
     //      Create a single transect which goes through the center of the polygon
     //      Intersect it with the polygon
     if (intersectLines.count() < 2) {
-        _surveyAreaPolygon.center();
-        QLineF firstLine = lineList.first();
-        QPointF lineCenter = firstLine.pointAt(0.5);
-        QPointF centerOffset = boundingCenter - lineCenter;
-        firstLine.translate(centerOffset);
-        lineList.clear();
-        lineList.append(firstLine);
-        intersectLines = lineList;
-        _intersectLinesWithPolygon(lineList, polygon, intersectLines);
+        intersectLines.clear();
+        clipper.clip(boundingCenter, gridAngle, boundingCenter.x(), gridSpacing, 1);
+        QLineF span;
+        if (clipper.span(0, span)) {
+            intersectLines += span;
+        }
     }
 
     // Make sure all lines are going the same direction. Polygon intersection leads to lines which
@@ -1194,13 +1195,13 @@ void SurveyComplexItem::_rebuildTransectsPhase1Worker(bool refly)
         transects.append(transect);
     }
 
-    _adjustTransectsToEntryPointLocation(transects);
+    _adjustTransectsToEntryPointLocation(transects, params.entryPoint);
 
-    if (refly) {
-        _optimizeTransectsForShortestDistance(_transects.last().last().coord, transects);
+    if (refly && coordInfoTransects.count() && transects.count()) {
+        _optimizeTransectsForShortestDistance(coordInfoTransects.last().last().coord, transects);
     }
 
-    if (_flyAlternateTransectsFact.rawValue().toBool()) {
+    if (params.flyAlternateTransects) {
         QList<QList<QGeoCoordinate>> alternatingTransects;
         for (int i=0; i<transects.count(); i++) {
             if (!(i & 1)) {
@@ -1233,7 +1234,7 @@ void SurveyComplexItem::_rebuildTransectsPhase1Worker(bool refly)
         transects[i] = transectVertices;
     }
 
-    // Convert to CoordInfo transects and append to _transects
+    // Convert to CoordInfo transects and append to coordInfoTransects
     foreach (const QList<QGeoCoordinate>& transect, transects) {
         QGeoCoordinate                                  coord;
         QList<TransectStyleComplexItem::CoordInfo_t>    coordInfoTransect;
@@ -1245,14 +1246,14 @@ void SurveyComplexItem::_rebuildTransectsPhase1Worker(bool refly)
         coordInfoTransect.append(coordInfo);
 
         // For hover and capture we need points for each camera location within the transect
-        if (triggerCamera() && hoverAndCaptureEnabled()) {
+        if (params.hoverAndCapture) {
             double transectLength = transect[0].distanceTo(transect[1]);
             double transectAzimuth = transect[0].azimuthTo(transect[1]);
-            if (triggerDistance() < transectLength) {
-                int cInnerHoverPoints = floor(transectLength / triggerDistance());
+            if (params.triggerDistance < transectLength) {
+                int cInnerHoverPoints = floor(transectLength / params.triggerDistance);
                 qCDebug(SurveyComplexItemLog) << "cInnerHoverPoints" << cInnerHoverPoints;
                 for (int i=0; i<cInnerHoverPoints; i++) {
-                    QGeoCoordinate hoverCoord = transect[0].atDistanceAndAzimuth(triggerDistance() * (i + 1), transectAzimuth);
+                    QGeoCoordinate hoverCoord = transect[0].atDistanceAndAzimuth(params.triggerDistance * (i + 1), transectAzimuth);
                     TransectStyleComplexItem::CoordInfo_t coordInfo = { hoverCoord, CoordTypeInteriorHoverTrigger };
                     coordInfoTransect.insert(1 + i, coordInfo);
                 }
@@ -1260,9 +1261,9 @@ void SurveyComplexItem::_rebuildTransectsPhase1Worker(bool refly)
         }
 
         // Extend the transect ends for turnaround
-        if (_hasTurnaround()) {
+        if (params.turnAroundDistance > 0) {
             QGeoCoordinate turnaroundCoord;
-            double turnAroundDistance = _turnAroundDistanceFact.rawValue().toDouble();
+            double turnAroundDistance = params.turnAroundDistance;
 
             double azimuth = transect[0].azimuthTo(transect[1]);
             turnaroundCoord = transect[0].atDistanceAndAzimuth(-turnAroundDistance, azimuth);
@@ -1277,7 +1278,7 @@ void SurveyComplexItem::_rebuildTransectsPhase1Worker(bool refly)
             coordInfoTransect.append(coordInfo);
         }
 
-        _transects.append(coordInfoTransect);
+        coordInfoTransects.append(coordInfoTransect);
     }
 }
 
@@ -1354,15 +1355,22 @@ void SurveyComplexItem::_appendLoadedMissionItems(QList<MissionItem*>& items, QO
 
 void SurveyComplexItem::rotateEntryPoint(void)
 {
-    if (_entryPoint == EntryLocationLast) {
-        _entryPoint = EntryLocationFirst;
-    } else {
-        _entryPoint++;
-    }
+    setEntryLocation(_entryPoint == EntryLocationLast ? EntryLocationFirst : _entryPoint + 1);
+}
 
-    _rebuildTransects();
+void SurveyComplexItem::setEntryLocation(int entryLocation)
+{
+    if (entryLocation != _entryPoint) {
+        _entryPoint = entryLocation;
+        _rebuildTransects();
+        setDirty(true);
+    }
+}
 
-    setDirty(true);
+bool SurveyComplexItem::_lawnmowerEntryLocations(void) const
+{
+    // The refly pass is picked to be closest to the end of the first pass, and alternate transects interleave the order
+    return !_refly90DegreesFact.rawValue().toBool() && !_flyAlternateTransectsFact.rawValue().toBool();
 }
 
 double SurveyComplexItem::timeBetweenShots(void)
@@ -39,6 +39,9 @@ public:
     QString mapVisualQML        (void) const final { return QStringLiteral("SurveyMapVisual.qml"); }
 
     // Overrides from TransectStyleComplexItem
+    int     entryLocationCount  (void) const final { return EntryLocationLast + 1; }
+    int     entryLocation       (void) const final { return _entryPoint; }
+    void    setEntryLocation    (int entryLocation) final;
     void    save                (QJsonArray&  planItems) final;
     bool    specifiesCoordinate (void) const final { return true; }
     void    appendMissionItems  (QList<MissionItem*>& items, QObject* missionItemParent) final;
@@ -77,6 +80,12 @@ private slots:
     void _rebuildTransectsPhase1(void) final;
     void _rebuildTransectsPhase2(void) final;
 
+protected:
+    // Overrides from TransectStyleComplexItem
+    TransectGenerator_t _transectGenerator      (void) final;
+    double              _transectGenerationCost (void) final;
+    bool                _lawnmowerEntryLocations(void) const final;
+
 private:
     enum CameraTriggerCode {
         CameraTriggerNone,
@@ -85,22 +94,37 @@ private:
         CameraTriggerHoverAndCapture
     };
 
-    QPointF _rotatePoint(const QPointF& point, const QPointF& origin, double angle);
+    /// Values transect generation depends on. Captured on the gui thread so generation can run on a worker thread.
+    typedef struct {
+        QList<QGeoCoordinate>   polygon;
+        double                  gridAngle;
+        double                  gridSpacing;
+        int                     entryPoint;
+        bool                    refly90Degrees;
+        bool                    flyAlternateTransects;
+        bool                    hoverAndCapture;
+        double                  triggerDistance;
+        double                  turnAroundDistance;     ///< 0 for no turnaround
+    } TransectParams_t;
+
+    TransectParams_t _transectParams(void);
+    static QList<QList<CoordInfo_t>> _generateTransects(const TransectParams_t& params, const QAtomicInt& cancelled);
+    static void _generateTransectsWorker(const TransectParams_t& params, bool refly, QList<QList<CoordInfo_t>>& coordInfoTransects, const QAtomicInt& cancelled);
+    static QPointF _rotatePoint(const QPointF& point, const QPointF& origin, double angle);
     void _intersectLinesWithRect(const QList<QLineF>& lineList, const QRectF& boundRect, QList<QLineF>& resultLines);
-    void _intersectLinesWithPolygon(const QList<QLineF>& lineList, const QPolygonF& polygon, QList<QLineF>& resultLines);
-    void _adjustLineDirection(const QList<QLineF>& lineList, QList<QLineF>& resultLines);
+    static void _adjustLineDirection(const QList<QLineF>& lineList, QList<QLineF>& resultLines);
     int _appendWaypointToMission(QList<MissionItem*>& items, int seqNum, QGeoCoordinate& coord, CameraTriggerCode cameraTrigger, QObject* missionItemParent);
     bool _nextTransectCoord(const QList<QGeoCoordinate>& transectPoints, int pointIndex, QGeoCoordinate& coord);
     bool _appendMissionItemsWorker(QList<MissionItem*>& items, QObject* missionItemParent, int& seqNum, bool hasRefly, bool buildRefly);
-    void _optimizeTransectsForShortestDistance(const QGeoCoordinate& distanceCoord, QList<QList<QGeoCoordinate>>& transects);
+    static void _optimizeTransectsForShortestDistance(const QGeoCoordinate& distanceCoord, QList<QList<QGeoCoordinate>>& transects);
     qreal _ccw(QPointF pt1, QPointF pt2, QPointF pt3);
     qreal _dp(QPointF pt1, QPointF pt2);
     void _swapPoints(QList<QPointF>& points, int index1, int index2);
-    void _reverseTransectOrder(QList<QList<QGeoCoordinate>>& transects);
-    void _reverseInternalTransectPoints(QList<QList<QGeoCoordinate>>& transects);
-    void _adjustTransectsToEntryPointLocation(QList<QList<QGeoCoordinate>>& transects);
+    static void _reverseTransectOrder(QList<QList<QGeoCoordinate>>& transects);
+    static void _reverseInternalTransectPoints(QList<QList<QGeoCoordinate>>& transects);
+    static void _adjustTransectsToEntryPointLocation(QList<QList<QGeoCoordinate>>& transects, int entryPoint);
     bool _gridAngleIsNorthSouthTransects();
-    double _clampGridAngle90(double gridAngle);
+    static double _clampGridAngle90(double gridAngle);
     void _buildAndAppendMissionItems(QList<MissionItem*>& items, QObject* missionItemParent);
     void _appendLoadedMissionItems  (QList<MissionItem*>& items, QObject* missionItemParent);
     bool _imagesEverywhere(void) const;
@@ -110,7 +134,6 @@ private:
     bool _hoverAndCaptureEnabled(void) const;
     bool _loadV3(const QJsonObject& complexObject, int sequenceNumber, QString& errorString);
     bool _loadV4(const QJsonObject& complexObject, int sequenceNumber, QString& errorString);
-    void _rebuildTransectsPhase1Worker(bool refly);
 
     QMap<QString, FactMetaData*> _metaDataMap;
 
@@ -150,4 +173,6 @@ private:
 
 
     static const int _hoverAndCaptureDelaySeconds = 4;
+
+    friend class SurveyComplexItemTest;
 };
@@ -10,6 +10,8 @@
 #include "SurveyComplexItemTest.h"
 #include "QGCApplication.h"
 
+#include <QSignalSpy>
+
 SurveyComplexItemTest::SurveyComplexItemTest(void)
     : _offlineVehicle(NULL)
 {
@@ -185,3 +187,75 @@ void SurveyComplexItemTest::_testItemCount(void)
     QCOMPARE(items.count() - 1, _surveyItem->lastSequenceNumber());
     items.clear();
 }
+
+void SurveyComplexItemTest::_testAsyncRebuild(void)
+{
+    // Large polygon with a tight grid is expensive enough to be generated on a worker thread
+    QList<QGeoCoordinate> rgCircle;
+    QGeoCoordinate center(47.633550640000003, -122.08982199);
+    for (int i=0; i<200; i++) {
+        rgCircle.append(center.atDistanceAndAzimuth(2000, i * (360.0 / 200)));
+    }
+    _surveyItem->cameraCalc()->adjustedFootprintSide()->setRawValue(0.05);
+    _surveyItem->gridAngle()->setRawValue(0);
+
+    QSignalSpy visualTransectPointsSpy(_surveyItem, &TransectStyleComplexItem::visualTransectPointsChanged);
+
+    _mapPolygon->appendVertices(rgCircle);
+    // Keep well clear of the threshold so cost model tweaks don't silently turn this into a synchronous rebuild
+    QVERIFY(_surveyItem->_transectGenerationCost() > 2 * SurveyComplexItem::_asyncTransectGenerationCost);
+    QVERIFY(_surveyItem->transectGenerationInProgress());
+    QVERIFY(!_surveyItem->readyForSave());
+    QCOMPARE(visualTransectPointsSpy.count(), 0);
+
+    // Changes while generation is running cancel it. Only the transects for the last change are applied.
+    _surveyItem->gridAngle()->setRawValue(30);
+    _surveyItem->gridAngle()->setRawValue(60);
+    QVERIFY(_surveyItem->transectGenerationInProgress());
+    QVERIFY(visualTransectPointsSpy.wait(30000));
+    QTest::qWait(500);
+    QCOMPARE(visualTransectPointsSpy.count(), 1);
+    QVERIFY(!_surveyItem->transectGenerationInProgress());
+    QVERIFY(_surveyItem->readyForSave());
+
+    QVariantList gridPoints = _surveyItem->visualTransectPoints();
+    QVERIFY(gridPoints.count() > 2);
+    double azimuth = gridPoints[0].value<QGeoCoordinate>().azimuthTo(gridPoints[1].value<QGeoCoordinate>());
+    QVERIFY(qAbs(_clampGridAngle180(60) - _clampGridAngle180(azimuth)) < 1.0);
+}
+
+void SurveyComplexItemTest::_testEntryLocationCoordinates(void)
+{
+    _setPolygon();
+
+    // Corners worked out from the current transects must match the ones flown after switching entry location.
+    // Different grid spacings give both odd and even transect counts.
+    double rgTurnAroundDistance[] = { 0, 10 };
+    for (size_t turnAroundIndex=0; turnAroundIndex<sizeof(rgTurnAroundDistance)/sizeof(rgTurnAroundDistance[0]); turnAroundIndex++) {
+        _surveyItem->turnAroundDistance()->setRawValue(rgTurnAroundDistance[turnAroundIndex]);
+        for (double gridSpacing=10; gridSpacing<=25; gridSpacing+=2.5) {
+            _surveyItem->cameraCalc()->adjustedFootprintSide()->setRawValue(gridSpacing);
+            for (double gridAngle=0; gridAngle<180; gridAngle+=45) {
+                _surveyItem->gridAngle()->setRawValue(gridAngle);
+                for (int fromLocation=0; fromLocation<_surveyItem->entryLocationCount(); fromLocation++) {
+                    for (int toLocation=0; toLocation<_surveyItem->entryLocationCount(); toLocation++) {
+                        QGeoCoordinate entryCoordinate, exitCoordinate, expectedEntryCoordinate, expectedExitCoordinate;
+
+                        _surveyItem->setEntryLocation(fromLocation);
+                        QVERIFY(_surveyItem->entryLocationCoordinates(toLocation, entryCoordinate, exitCoordinate));
+                        _surveyItem->setEntryLocation(toLocation);
+                        QVERIFY(_surveyItem->entryLocationCoordinates(toLocation, expectedEntryCoordinate, expectedExitCoordinate));
+                        QVERIFY(entryCoordinate.distanceTo(expectedEntryCoordinate) < 0.01);
+                        QVERIFY(exitCoordinate.distanceTo(expectedExitCoordinate) < 0.01);
+                    }
+                }
+            }
+        }
+    }
+
+    // With refly the second pass depends on where the first one ends, so only the current entry location is known
+    QGeoCoordinate entryCoordinate, exitCoordinate;
+    _surveyItem->refly90Degrees()->setRawValue(true);
+    QVERIFY(_surveyItem->entryLocationCoordinates(_surveyItem->entryLocation(), entryCoordinate, exitCoordinate));
+    QVERIFY(!_surveyItem->entryLocationCoordinates(_surveyItem->entryLocation() ^ 1, entryCoordinate, exitCoordinate));
+}
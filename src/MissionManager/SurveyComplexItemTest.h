@@ -33,6 +33,8 @@ private slots:
     void _testGridAngle(void);
     void _testEntryLocation(void);
     void _testItemCount(void);
+    void _testAsyncRebuild(void);
+    void _testEntryLocationCoordinates(void);
 
 private:
 
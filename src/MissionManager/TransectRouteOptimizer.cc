@@ -0,0 +1,260 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TransectRouteOptimizer.h"
+#include "QGCGeo.h"
+#include "QGCLoggingCategory.h"
+
+#include <QElapsedTimer>
+#include <QtMath>
+
+#include <algorithm>
+#include <limits>
+
+QGC_LOGGING_CATEGORY(TransectRouteOptimizerLog, "TransectRouteOptimizerLog")
+
+TransectRouteOptimizer::TransectRouteOptimizer(const QGeoCoordinate& start, const QGeoCoordinate& end)
+    : _origin           (start)
+    , _hasEnd           (end.isValid())
+    , _initialDistance  (0)
+    , _distance         (0)
+{
+    _start = _toLocal(start);
+    _end = _hasEnd ? _toLocal(end) : _start;
+}
+
+/// Converts a coordinate to a flat x/y in meters around the start of the route. Legs are short enough compared to
+/// the size of the earth that distances in this frame are good enough for comparing routes.
+TransectRouteOptimizer::Point_t TransectRouteOptimizer::_toLocal(const QGeoCoordinate& coord) const
+{
+    Point_t point = { 0, 0 };
+
+    if (coord.isValid() && _origin.isValid() && coord != _origin) {
+        double down;
+        convertGeoToNed(coord, _origin, &point.x, &point.y, &down);
+    }
+
+    return point;
+}
+
+double TransectRouteOptimizer::_legDistance(const Point_t& from, const Point_t& to)
+{
+    return qSqrt(((to.x - from.x) * (to.x - from.x)) + ((to.y - from.y) * (to.y - from.y)));
+}
+
+int TransectRouteOptimizer::addNode(const QList<Option_t>& options, int currentOption)
+{
+    if (options.isEmpty()) {
+        qWarning() << "TransectRouteOptimizer::addNode called with no options";
+        return -1;
+    }
+
+    int node = _optionStarts.count();
+    _optionStarts.append(_entries.count());
+    foreach (const Option_t& option, options) {
+        _entries.append(_toLocal(option.entry));
+        _exits.append(_toLocal(option.exit));
+    }
+
+    _order.append(node);
+    _options.append(qBound(0, currentOption, options.count() - 1));
+    _initialDistance = _distance = _routeDistance(_order, _options);
+
+    return node;
+}
+
+/// @return Leg distance for the specified visit order and node options
+double TransectRouteOptimizer::_routeDistance(const QVector<int>& order, const QVector<int>& options) const
+{
+    double distance = 0;
+    Point_t position = _start;
+
+    foreach (int node, order) {
+        int optionIndex = _optionStarts[node] + options[node];
+        distance += _legDistance(position, _entries[optionIndex]);
+        position = _exits[optionIndex];
+    }
+    if (_hasEnd) {
+        distance += _legDistance(position, _end);
+    }
+
+    return distance;
+}
+
+/// Picks the best option for each node for the specified visit order
+///     @param[out] options Selected option for each node, indexed by node
+/// @return Leg distance of the route with the selected options
+double TransectRouteOptimizer::_bestOptions(const QVector<int>& order, QVector<int>& options) const
+{
+    int nodeCount = order.count();
+
+    options.resize(_optionStarts.count());
+    if (nodeCount == 0) {
+        return _hasEnd ? _legDistance(_start, _end) : 0;
+    }
+
+    // Shortest route up to each position in the visit order, for each way of leaving the node at that position
+    QVector<int> positionStarts(nodeCount + 1);
+    for (int position=0; position<nodeCount; position++) {
+        int node = order[position];
+        int optionEnd = node + 1 < _optionStarts.count() ? _optionStarts[node + 1] : _entries.count();
+        positionStarts[position + 1] = positionStarts[position] + optionEnd - _optionStarts[node];
+    }
+    QVector<double> cost(positionStarts[nodeCount]);
+    QVector<int> previousOption(positionStarts[nodeCount]);
+
+    for (int position=0; position<nodeCount; position++) {
+        int node = order[position];
+        int optionCount = positionStarts[position + 1] - positionStarts[position];
+
+        for (int option=0; option<optionCount; option++) {
+            const Point_t& entry = _entries[_optionStarts[node] + option];
+            double bestCost = std::numeric_limits<double>::max();
+            int bestPrevious = -1;
+
+            if (position == 0) {
+                bestCost = _legDistance(_start, entry);
+            } else {
+                int previousNode = order[position - 1];
+                int previousCount = positionStarts[position] - positionStarts[position - 1];
+                for (int previous=0; previous<previousCount; previous++) {
+                    double legCost = cost[positionStarts[position - 1] + previous] + _legDistance(_exits[_optionStarts[previousNode] + previous], entry);
+                    if (legCost < bestCost) {
+                        bestCost = legCost;
+                        bestPrevious = previous;
+                    }
+                }
+            }
+
+            cost[positionStarts[position] + option] = bestCost;
+            previousOption[positionStarts[position] + option] = bestPrevious;
+        }
+    }
+
+    int lastNode = order[nodeCount - 1];
+    double bestCost = std::numeric_limits<double>::max();
+    int bestOption = 0;
+    for (int option=0; option<positionStarts[nodeCount] - positionStarts[nodeCount - 1]; option++) {
+        double routeCost = cost[positionStarts[nodeCount - 1] + option];
+        if (_hasEnd) {
+            routeCost += _legDistance(_exits[_optionStarts[lastNode] + option], _end);
+        }
+        if (routeCost < bestCost) {
+            bestCost = routeCost;
+            bestOption = option;
+        }
+    }
+
+    for (int position=nodeCount-1; position>=0; position--) {
+        options[order[position]] = bestOption;
+        bestOption = previousOption[positionStarts[position] + bestOption];
+    }
+
+    return bestCost;
+}
+
+/// Builds a visit order by always flying to the closest entry of the remaining nodes
+void TransectRouteOptimizer::_nearestNeighbour(QVector<int>& order) const
+{
+    QVector<bool> visited(_optionStarts.count(), false);
+    Point_t position = _start;
+
+    order.clear();
+    for (int step=0; step<_optionStarts.count(); step++) {
+        double bestDistance = std::numeric_limits<double>::max();
+        int bestNode = -1;
+        int bestOption = -1;
+
+        for (int node=0; node<_optionStarts.count(); node++) {
+            if (visited[node]) {
+                continue;
+            }
+            int optionEnd = node + 1 < _optionStarts.count() ? _optionStarts[node + 1] : _entries.count();
+            for (int option=_optionStarts[node]; option<optionEnd; option++) {
+                double distance = _legDistance(position, _entries[option]);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    bestNode = node;
+                    bestOption = option;
+                }
+            }
+        }
+
+        visited[bestNode] = true;
+        order.append(bestNode);
+        position = _exits[bestOption];
+    }
+}
+
+void TransectRouteOptimizer::optimize(int timeBudgetMsecs)
+{
+    const double minImprovement = 0.01;    // meters, stops the search from chasing rounding noise
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int nodeCount = _optionStarts.count();
+    if (nodeCount == 0) {
+        return;
+    }
+
+    QVector<int> options;
+    QVector<int> bestOrder = _order;
+    QVector<int> bestOptions = _options;
+    double bestDistance = _routeDistance(_order, _options);
+
+    // The current order may only need different options
+    double distance = _bestOptions(_order, options);
+    if (distance < bestDistance) {
+        bestDistance = distance;
+        bestOptions = options;
+    }
+
+    QVector<int> order;
+    _nearestNeighbour(order);
+    distance = _bestOptions(order, options);
+    if (distance < bestDistance - minImprovement) {
+        bestDistance = distance;
+        bestOrder = order;
+        bestOptions = options;
+    }
+
+    // 2-opt: reverse the visit order of a run of nodes, options are picked again for each candidate order
+    int moves = 0;
+    bool improved = true;
+    bool outOfTime = false;
+    while (improved && !outOfTime) {
+        improved = false;
+        for (int i=0; i<nodeCount-1 && !outOfTime; i++) {
+            for (int j=i+1; j<nodeCount; j++) {
+                if (timer.elapsed() > timeBudgetMsecs) {
+                    outOfTime = true;
+                    break;
+                }
+
+                order = bestOrder;
+                std::reverse(order.begin() + i, order.begin() + j + 1);
+                distance = _bestOptions(order, options);
+                if (distance < bestDistance - minImprovement) {
+                    bestDistance = distance;
+                    bestOrder = order;
+                    bestOptions = options;
+                    improved = true;
+                    moves++;
+                }
+            }
+        }
+    }
+
+    _order = bestOrder;
+    _options = bestOptions;
+    _distance = bestDistance;
+
+    qCDebug(TransectRouteOptimizerLog) << "nodes:initial:optimized:moves:outOfTime:msecs" << nodeCount << _initialDistance << _distance << moves << outOfTime << timer.elapsed();
+}
@@ -0,0 +1,81 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QGeoCoordinate>
+#include <QList>
+#include <QVector>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(TransectRouteOptimizerLog)
+
+/// Finds a short route through a set of nodes which can each be flown in several ways, for example survey items
+/// which can be entered from any of their corners. Each way of flying a node is an option with its own entry and
+/// exit coordinate. The route cost is the length of the legs between nodes, the distance flown inside a node
+/// doesn't depend on the route.
+///
+/// The route is built with a nearest neighbour search and then improved with 2-opt moves until no move helps or the
+/// time budget runs out. For any given visit order the best option for each node is picked by dynamic programming.
+/// The result is never worse than the initial order and options.
+class TransectRouteOptimizer
+{
+public:
+    typedef struct {
+        QGeoCoordinate entry;
+        QGeoCoordinate exit;
+    } Option_t;
+
+    /// @param start Coordinate the route starts from
+    /// @param end Coordinate the route must finish at, an invalid coordinate for a route which can end anywhere
+    TransectRouteOptimizer(const QGeoCoordinate& start, const QGeoCoordinate& end = QGeoCoordinate());
+
+    /// Adds a node which the route must visit. The initial route visits nodes in the order they are added.
+    ///     @param options Ways the node can be flown, must not be empty
+    ///     @param currentOption Option used by the initial route
+    /// @return Index of the new node
+    int addNode(const QList<Option_t>& options, int currentOption = 0);
+
+    /// Searches for a shorter route
+    ///     @param timeBudgetMsecs Maximum time to spend improving the route
+    void optimize(int timeBudgetMsecs);
+
+    int         nodeCount       (void) const { return _optionStarts.count(); }
+    QList<int>  order           (void) const { return _order.toList(); }            ///< Node indices in visit order
+    int         option          (int node) const { return _options[node]; }         ///< Option selected for a node
+    double      initialDistance (void) const { return _initialDistance; }          ///< Leg distance of the initial route in meters
+    double      distance        (void) const { return _distance; }                 ///< Leg distance of the current route in meters
+
+private:
+    typedef struct {
+        double x;
+        double y;
+    } Point_t;
+
+    Point_t _toLocal        (const QGeoCoordinate& coord) const;
+    double  _routeDistance  (const QVector<int>& order, const QVector<int>& options) const;
+    double  _bestOptions    (const QVector<int>& order, QVector<int>& options) const;
+    void    _nearestNeighbour(QVector<int>& order) const;
+
+    static double _legDistance(const Point_t& from, const Point_t& to);
+
+    QGeoCoordinate      _origin;
+    Point_t             _start;
+    Point_t             _end;
+    bool                _hasEnd;
+
+    QVector<Point_t>    _entries;       ///< Entry points for all options of all nodes back to back
+    QVector<Point_t>    _exits;         ///< Exit points, same layout as _entries
+    QVector<int>        _optionStarts;  ///< Index into _entries of the first option for each node
+
+    QVector<int>        _order;
+    QVector<int>        _options;       ///< Selected option for each node, indexed by node
+    double              _initialDistance;
+    double              _distance;
+};
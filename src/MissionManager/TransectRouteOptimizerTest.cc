@@ -0,0 +1,142 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TransectRouteOptimizerTest.h"
+
+#include <QElapsedTimer>
+
+TransectRouteOptimizerTest::TransectRouteOptimizerTest(void)
+    : _origin(47.633033, -122.08794, 0)
+{
+
+}
+
+/// Builds an option from north/east offsets in meters from the test origin
+TransectRouteOptimizer::Option_t TransectRouteOptimizerTest::_option(double entryNorth, double entryEast, double exitNorth, double exitEast)
+{
+    TransectRouteOptimizer::Option_t option;
+
+    option.entry = _origin.atDistanceAndAzimuth(entryNorth, 0).atDistanceAndAzimuth(entryEast, 90);
+    option.exit = _origin.atDistanceAndAzimuth(exitNorth, 0).atDistanceAndAzimuth(exitEast, 90);
+    return option;
+}
+
+void TransectRouteOptimizerTest::_testOrder(void)
+{
+    // Nodes along a line north of the start, added out of order
+    TransectRouteOptimizer optimizer(_origin);
+    QList<double> norths = { 3000, 1000, 4000, 2000 };
+
+    foreach (double north, norths) {
+        QList<TransectRouteOptimizer::Option_t> options = { _option(north, 0, north + 100, 0) };
+        optimizer.addNode(options);
+    }
+
+    optimizer.optimize(1000);
+
+    QList<int> expectedOrder = { 1, 3, 0, 2 };
+    QCOMPARE(optimizer.order(), expectedOrder);
+    QVERIFY(optimizer.distance() < optimizer.initialDistance());
+    QVERIFY(qAbs(optimizer.distance() - 3700) < 1);
+}
+
+void TransectRouteOptimizerTest::_testOptions(void)
+{
+    // A single node which is currently entered from its far end. Entering from the near end is shorter.
+    TransectRouteOptimizer optimizer(_origin);
+    QList<TransectRouteOptimizer::Option_t> options = {
+        _option(1000, 0, 1500, 0),
+        _option(1500, 0, 1000, 0),
+        _option(1000, 500, 1000, 0),
+    };
+
+    optimizer.addNode(options, 1);
+    QVERIFY(qAbs(optimizer.initialDistance() - 1500) < 1);
+
+    optimizer.optimize(1000);
+    QCOMPARE(optimizer.option(0), 0);
+    QVERIFY(qAbs(optimizer.distance() - 1000) < 1);
+}
+
+void TransectRouteOptimizerTest::_testNeverWorse(void)
+{
+    // Nodes already in the best order must stay where they are
+    TransectRouteOptimizer optimizer(_origin, _origin.atDistanceAndAzimuth(5000, 0));
+
+    for (int i=0; i<4; i++) {
+        QList<TransectRouteOptimizer::Option_t> options = {
+            _option((i + 1) * 1000, 0, ((i + 1) * 1000) + 100, 0),
+            _option(((i + 1) * 1000) + 100, 0, (i + 1) * 1000, 0),
+        };
+        optimizer.addNode(options);
+    }
+
+    double initialDistance = optimizer.initialDistance();
+    optimizer.optimize(1000);
+
+    QList<int> expectedOrder = { 0, 1, 2, 3 };
+    QCOMPARE(optimizer.order(), expectedOrder);
+    for (int i=0; i<4; i++) {
+        QCOMPARE(optimizer.option(i), 0);
+    }
+    QVERIFY(qAbs(optimizer.distance() - initialDistance) < 0.01);
+}
+
+void TransectRouteOptimizerTest::_testZeroBudget(void)
+{
+    // Even without time for 2-opt the nearest neighbour route is used when it is shorter
+    TransectRouteOptimizer optimizer(_origin);
+    QList<double> norths = { 4000, 3000, 2000, 1000 };
+
+    foreach (double north, norths) {
+        QList<TransectRouteOptimizer::Option_t> options = { _option(north, 0, north, 0) };
+        optimizer.addNode(options);
+    }
+
+    optimizer.optimize(0);
+
+    QList<int> expectedOrder = { 3, 2, 1, 0 };
+    QCOMPARE(optimizer.order(), expectedOrder);
+    QVERIFY(optimizer.distance() < optimizer.initialDistance());
+}
+
+void TransectRouteOptimizerTest::_benchmarkOptimize(void)
+{
+    UT_BENCHMARK();
+
+    // Grid of survey sized nodes added in a scrambled order, each with four corner options
+    const int gridSize = 8;
+    const double cellSize = 1000;
+    const double itemSize = 400;
+
+    TransectRouteOptimizer optimizer(_origin);
+    for (int i=0; i<gridSize*gridSize; i++) {
+        int cell = (i * 37) % (gridSize * gridSize);
+        double north = (cell / gridSize) * cellSize;
+        double east = (cell % gridSize) * cellSize;
+
+        QList<TransectRouteOptimizer::Option_t> options = {
+            _option(north, east, north + itemSize, east + itemSize),
+            _option(north, east + itemSize, north + itemSize, east),
+            _option(north + itemSize, east, north, east + itemSize),
+            _option(north + itemSize, east + itemSize, north, east),
+        };
+        optimizer.addNode(options);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    optimizer.optimize(2000);
+    qint64 elapsed = timer.elapsed();
+
+    QVERIFY(optimizer.distance() < optimizer.initialDistance());
+    QVERIFY(elapsed < 4000);
+
+    qCDebug(TransectRouteOptimizerLog) << "TransectRouteOptimizer nodes:initial:optimized:msecs" << optimizer.nodeCount() << optimizer.initialDistance() << optimizer.distance() << elapsed;
+}
@@ -0,0 +1,33 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+#include "TransectRouteOptimizer.h"
+
+class TransectRouteOptimizerTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    TransectRouteOptimizerTest(void);
+
+private slots:
+    void _testOrder(void);
+    void _testOptions(void);
+    void _testNeverWorse(void);
+    void _testZeroBudget(void);
+    void _benchmarkOptimize(void);
+
+private:
+    TransectRouteOptimizer::Option_t _option(double entryNorth, double entryEast, double exitNorth, double exitEast);
+
+    QGeoCoordinate _origin;
+};
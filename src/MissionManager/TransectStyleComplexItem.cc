@@ -18,6 +18,7 @@
 #include "QGCQGeoCoordinate.h"
 
 #include <QPolygonF>
+#include <QtConcurrent>
 
 QGC_LOGGING_CATEGORY(TransectStyleComplexItemLog, "TransectStyleComplexItemLog")
 
@@ -37,6 +38,11 @@ const char* TransectStyleComplexItem::_jsonItemsKey =                       "Ite
 const char* TransectStyleComplexItem::_jsonFollowTerrainKey =               "FollowTerrain";
 
 const int   TransectStyleComplexItem::_terrainQueryTimeoutMsecs =           1000;
+// Typical surveys stay well below this and are rebuilt synchronously: a 1 km square field at 20 m grid spacing costs
+// about 200, at 2 m spacing about 1700, and with hover and capture every 10 m about 25000 (50000 with refly).
+// Corridors with a few hundred polyline vertices cost a few thousand. Only sub meter grids or hover and capture
+// over several kilometers go to a worker thread.
+const double TransectStyleComplexItem::_asyncTransectGenerationCost =       50000;
 
 TransectStyleComplexItem::TransectStyleComplexItem(Vehicle* vehicle, bool flyView, QString settingsGroup, QObject* parent)
     : ComplexMissionItem                (vehicle, flyView, parent)
@@ -57,6 +63,7 @@ TransectStyleComplexItem::TransectStyleComplexItem(Vehicle* vehicle, bool flyVie
     , _terrainAdjustToleranceFact       (settingsGroup, _metaDataMap[terrainAdjustToleranceName])
     , _terrainAdjustMaxClimbRateFact    (settingsGroup, _metaDataMap[terrainAdjustMaxClimbRateName])
     , _terrainAdjustMaxDescentRateFact  (settingsGroup, _metaDataMap[terrainAdjustMaxDescentRateName])
+    , _transectGenerationWatcher        (NULL)
 {
     _terrainQueryTimer.setInterval(_terrainQueryTimeoutMsecs);
     _terrainQueryTimer.setSingleShot(true);
@@ -331,6 +338,38 @@ double TransectStyleComplexItem::_turnaroundDistance(void) const
     return _turnAroundDistanceFact.rawValue().toDouble();
 }
 
+bool TransectStyleComplexItem::entryLocationCoordinates(int entryLocation, QGeoCoordinate& entryCoordinate, QGeoCoordinate& exitCoordinate) const
+{
+    // Transects still being generated belong to the new settings, not to the current entry location
+    if (_transects.isEmpty() || transectGenerationInProgress()) {
+        return false;
+    }
+
+    int change = entryLocation ^ this->entryLocation();
+    if (change != 0 && (!_lawnmowerEntryLocations() || change > 3)) {
+        return false;
+    }
+
+    const QList<CoordInfo_t>& firstTransect = _transects.first();
+    const QList<CoordInfo_t>& lastTransect = _transects.last();
+
+    // Reversing the direction of each transect flips every flown transect end to end. Reversing the order starts from the
+    // last transect. With an even transect count the lawnmower pattern then flies each transect the other way as well.
+    bool reverseDirection = change & 2;
+    if (change & 1) {
+        if (!(_transects.count() & 1)) {
+            reverseDirection = !reverseDirection;
+        }
+        entryCoordinate = reverseDirection ? lastTransect.last().coord : lastTransect.first().coord;
+        exitCoordinate = reverseDirection ? firstTransect.first().coord : firstTransect.last().coord;
+    } else {
+        entryCoordinate = reverseDirection ? firstTransect.last().coord : firstTransect.first().coord;
+        exitCoordinate = reverseDirection ? lastTransect.first().coord : lastTransect.last().coord;
+    }
+
+    return true;
+}
+
 bool TransectStyleComplexItem::hoverAndCaptureAllowed(void) const
 {
     return _vehicle->multiRotor() || _vehicle->vtol();
@@ -342,8 +381,77 @@ void TransectStyleComplexItem::_rebuildTransects(void)
         return;
     }
 
+    // Anything still being generated is now out of date
+    bool wasInProgress = transectGenerationInProgress();
+    _cancelTransectGeneration();
+
+    TransectGenerator_t generator;
+    if (_transectGenerationCost() > _asyncTransectGenerationCost) {
+        generator = _transectGenerator();
+    }
+
+    if (generator) {
+        // Expensive rebuild, generate on a worker thread. The current transects stay in place until the new ones are ready.
+        QSharedPointer<QAtomicInt> cancel(new QAtomicInt(0));
+        _transectGenerationCancel = cancel;
+        _transectGenerationWatcher = new QFutureWatcher<QList<QList<CoordInfo_t>>>(this);
+        connect(_transectGenerationWatcher, &QFutureWatcherBase::finished, this, &TransectStyleComplexItem::_transectGenerationFinished);
+        _transectGenerationWatcher->setFuture(QtConcurrent::run([generator, cancel]() { return generator(*cancel); }));
+        if (!wasInProgress) {
+            emit transectGenerationInProgressChanged(true);
+        }
+        return;
+    }
+
+    if (wasInProgress) {
+        emit transectGenerationInProgressChanged(false);
+    }
+
     _rebuildTransectsPhase1();
+    _transectsRebuilt();
+}
+
+void TransectStyleComplexItem::_cancelTransectGeneration(void)
+{
+    if (_transectGenerationWatcher) {
+        // The worker thread may still be running. It sees the cancel flag and its results are never looked at.
+        _transectGenerationCancel->storeRelease(1);
+        _transectGenerationCancel.clear();
+        disconnect(_transectGenerationWatcher, &QFutureWatcherBase::finished, this, &TransectStyleComplexItem::_transectGenerationFinished);
+        _transectGenerationWatcher->deleteLater();
+        _transectGenerationWatcher = NULL;
+    }
+}
+
+void TransectStyleComplexItem::_transectGenerationFinished(void)
+{
+    QList<QList<CoordInfo_t>> transects = _transectGenerationWatcher->result();
+
+    _transectGenerationCancel.clear();
+    _transectGenerationWatcher->deleteLater();
+    _transectGenerationWatcher = NULL;
+    emit transectGenerationInProgressChanged(false);
+
+    // If the transects are getting rebuilt then any previously loaded mission items are now invalid
+    _clearLoadedMissionItems();
+    _transectsPathHeightInfo.clear();
+    _transects = transects;
 
+    _transectsRebuilt();
+}
+
+void TransectStyleComplexItem::_clearLoadedMissionItems(void)
+{
+    if (_loadedMissionItemsParent) {
+        _loadedMissionItems.clear();
+        _loadedMissionItemsParent->deleteLater();
+        _loadedMissionItemsParent = NULL;
+    }
+}
+
+/// Updates everything which depends on _transects once _rebuildTransectsPhase1 or a worker thread has replaced them
+void TransectStyleComplexItem::_transectsRebuilt(void)
+{
     if (_followTerrain) {
         // Query the terrain data. Once available terrain heights will be calculated
         _queryTransectsPathHeightInfo();
@@ -413,6 +521,13 @@ void TransectStyleComplexItem::_queryTransectsPathHeightInfo(void)
 {
     _transectsPathHeightInfo.clear();
 
+    // A query which is still outstanding was made for the previous transects
+    if (_terrainPolyPathQuery) {
+        disconnect(_terrainPolyPathQuery, &TerrainPolyPathQuery::terrainDataReceived, this, &TransectStyleComplexItem::_polyPathTerrainData);
+        _terrainPolyPathQuery->deleteLater();
+        _terrainPolyPathQuery = NULL;
+    }
+
     if (_transects.count()) {
         // We don't actually send the query until this timer times out. This way we only send
         // the latest request if we get a bunch in a row.
@@ -424,15 +539,9 @@ void TransectStyleComplexItem::_reallyQueryTransectsPathHeightInfo(void)
 {
     // Clear any previous query
     if (_terrainPolyPathQuery) {
-        // FIXME: We should really be blowing away any previous query here. But internally that is difficult to implement so instead we let
-        // it complete and drop the results.
-#if 0
-        // Toss previous query
-        _terrainPolyPathQuery->deleteLater();
-#else
-        // Let the signal fall on the floor
+        // Toss previous query. Any tiles it is waiting on are still fetched for the next query.
         disconnect(_terrainPolyPathQuery, &TerrainPolyPathQuery::terrainDataReceived, this, &TransectStyleComplexItem::_polyPathTerrainData);
-#endif
+        _terrainPolyPathQuery->deleteLater();
         _terrainPolyPathQuery = NULL;
     }
 
@@ -477,11 +586,16 @@ void TransectStyleComplexItem::_polyPathTerrainData(bool success, const QList<Te
         qWarning() << "TransectStyleComplexItem::_polyPathTerrainData _terrainPolyPathQuery != sender()";
     }
     disconnect(_terrainPolyPathQuery, &TerrainPolyPathQuery::terrainDataReceived, this, &TransectStyleComplexItem::_polyPathTerrainData);
+    _terrainPolyPathQuery->deleteLater();
     _terrainPolyPathQuery = NULL;
 }
 
 bool TransectStyleComplexItem::readyForSave(void) const
 {
+    if (transectGenerationInProgress()) {
+        return false;
+    }
+
     // Make sure we have the terrain data we need
     return _followTerrain ? _transectsPathHeightInfo.count() : true;
 }
@@ -489,7 +603,7 @@ bool TransectStyleComplexItem::readyForSave(void) const
 void TransectStyleComplexItem::_adjustTransectsForTerrain(void)
 {
     if (_followTerrain) {
-        if (!readyForSave()) {
+        if (_transectsPathHeightInfo.count() != _transects.count()) {
             qCWarning(TransectStyleComplexItemLog) << "_adjustTransectPointsForTerrain called when terrain data not ready";
             qgcApp()->showMessage(tr("INTERNAL ERROR: TransectStyleComplexItem::_adjustTransectPointsForTerrain called when terrain data not ready. Plan will be incorrect."));
             return;
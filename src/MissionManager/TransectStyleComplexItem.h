@@ -18,6 +18,12 @@
 #include "CameraCalc.h"
 #include "TerrainQuery.h"
 
+#include <QFutureWatcher>
+#include <QAtomicInt>
+#include <QSharedPointer>
+
+#include <functional>
+
 Q_DECLARE_LOGGING_CATEGORY(TransectStyleComplexItemLog)
 
 class TransectStyleComplexItem : public ComplexMissionItem
@@ -39,6 +45,7 @@ public:
     Q_PROPERTY(double           coveredArea                 READ coveredArea                                        NOTIFY coveredAreaChanged)
     Q_PROPERTY(bool             hoverAndCaptureAllowed      READ hoverAndCaptureAllowed                             CONSTANT)
     Q_PROPERTY(QVariantList     visualTransectPoints        READ visualTransectPoints                               NOTIFY visualTransectPointsChanged)
+    Q_PROPERTY(bool             transectGenerationInProgress READ transectGenerationInProgress                      NOTIFY transectGenerationInProgressChanged)
 
     Q_PROPERTY(bool             followTerrain               READ followTerrain              WRITE setFollowTerrain  NOTIFY followTerrainChanged)
     Q_PROPERTY(Fact*            terrainAdjustTolerance      READ terrainAdjustTolerance                             CONSTANT)
@@ -64,10 +71,26 @@ public:
     bool            hoverAndCaptureAllowed  (void) const;
     bool            followTerrain           (void) const { return _followTerrain; }
 
+    /// true: New transects are being generated on a worker thread, the current transects are out of date
+    bool            transectGenerationInProgress(void) const { return _transectGenerationWatcher != NULL; }
+
     virtual double  timeBetweenShots        (void) { return 0; } // Most be overridden. Implementation here is needed for unit testing.
 
     void setFollowTerrain(bool followTerrain);
 
+    /// @return Number of different entry locations the transects can be flown from
+    virtual int entryLocationCount(void) const { return 1; }
+
+    virtual int entryLocation(void) const { return 0; }
+
+    /// Changes where the transects are entered from, rebuilds the transects
+    virtual void setEntryLocation(int entryLocation) { Q_UNUSED(entryLocation); }
+
+    /// Calculates where the transects would be entered and exited for the specified entry location, without changing the item.
+    /// This is worked out from the current transects, nothing is regenerated.
+    ///     @return false: No transects, or the entry location can't be worked out from the current transects
+    bool entryLocationCoordinates(int entryLocation, QGeoCoordinate& entryCoordinate, QGeoCoordinate& exitCoordinate) const;
+
     double  triggerDistance         (void) const { return _cameraCalc.adjustedFootprintFrontal()->rawValue().toDouble(); }
     bool    hoverAndCaptureEnabled  (void) const { return hoverAndCapture()->rawValue().toBool(); }
     bool    triggerCamera           (void) const { return triggerDistance() != 0; }
@@ -128,6 +151,7 @@ signals:
     void visualTransectPointsChanged    (void);
     void coveredAreaChanged             (void);
     void followTerrainChanged           (bool followTerrain);
+    void transectGenerationInProgressChanged(bool transectGenerationInProgress);
 
 protected slots:
     virtual void _rebuildTransectsPhase1    (void) = 0; ///< Rebuilds the _transects array
@@ -149,6 +173,10 @@ protected:
     double  _turnaroundDistance             (void) const;
     void    _setBoundingCube                (QGCGeoBoundingCube bc);
 
+    /// @return true: Entry location bit 0 reverses the order of the transects and bit 1 reverses the direction of each
+    /// transect, before the lawnmower pattern is applied. The entry and exit of each entry location then follow from the current transects.
+    virtual bool _lawnmowerEntryLocations(void) const { return false; }
+
     int                 _sequenceNumber;
     bool                _dirty;
     QGeoCoordinate      _coordinate;
@@ -169,6 +197,20 @@ protected:
         CoordType       coordType;
     } CoordInfo_t;
 
+    /// Generates transects from values captured on the gui thread. Runs on a worker thread so it must not touch the item.
+    /// Generation should stop early once cancelled is set, the results are thrown away.
+    typedef std::function<QList<QList<CoordInfo_t>>(const QAtomicInt& cancelled)> TransectGenerator_t;
+
+    /// Captures the current settings into a generator which can run on a worker thread. The default implementation
+    /// returns an empty generator, in which case transects are always rebuilt synchronously by _rebuildTransectsPhase1.
+    virtual TransectGenerator_t _transectGenerator(void) { return TransectGenerator_t(); }
+
+    /// @return Rough number of operations needed to generate transects for the current settings. Rebuilds which are
+    ///         more expensive than _asyncTransectGenerationCost are generated on a worker thread.
+    virtual double _transectGenerationCost(void) { return 0; }
+
+    void _clearLoadedMissionItems(void);
+
     QVariantList                                        _visualTransectPoints;
     QList<QList<CoordInfo_t>>                           _transects;
     QList<QList<TerrainPathQuery::PathHeightInfo_t>>    _transectsPathHeightInfo;
@@ -203,12 +245,16 @@ protected:
     static const char* _jsonFollowTerrainKey;
 
     static const int _terrainQueryTimeoutMsecs;
+    static const double _asyncTransectGenerationCost;
 
 private slots:
     void _reallyQueryTransectsPathHeightInfo(void);
     void _followTerrainChanged              (bool followTerrain);
+    void _transectGenerationFinished        (void);
 
 private:
+    void    _transectsRebuilt               (void);
+    void    _cancelTransectGeneration       (void);
     void    _queryTransectsPathHeightInfo   (void);
     void    _adjustTransectsForTerrain      (void);
     void    _addInterstitialTerrainPoints   (QList<CoordInfo_t>& transect, const QList<TerrainPathQuery::PathHeightInfo_t>& transectPathHeightInfo);
@@ -216,4 +262,7 @@ private:
     void    _adjustForTolerance             (QList<CoordInfo_t>& transect);
     double  _altitudeBetweenCoords          (const QGeoCoordinate& fromCoord, const QGeoCoordinate& toCoord, double percentTowardsTo);
     int     _maxPathHeight                  (const TerrainPathQuery::PathHeightInfo_t& pathHeightInfo, int fromIndex, int toIndex, double& maxHeight);
+
+    QFutureWatcher<QList<QList<CoordInfo_t>>>*  _transectGenerationWatcher; ///< Generation currently running on a worker thread, NULL for none
+    QSharedPointer<QAtomicInt>                  _transectGenerationCancel;  ///< Cancel flag shared with the running generation
 };
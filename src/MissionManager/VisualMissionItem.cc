@@ -189,6 +189,16 @@ void VisualMissionItem::_reallyUpdateTerrainAltitude(void)
     if (coord.isValid() && (qIsNaN(_terrainAltitude) || !qFuzzyCompare(_lastLatTerrainQuery, coord.latitude()) || qFuzzyCompare(_lastLonTerrainQuery, coord.longitude()))) {
         _lastLatTerrainQuery = coord.latitude();
         _lastLonTerrainQuery = coord.longitude();
+
+        // Use the tile cache directly if we can, which saves a round trip through the batch manager
+        bool            error;
+        QList<double>   altitudes;
+        if (TerrainAtCoordinateQuery::getAltitudesForCoordinates(QList<QGeoCoordinate>() << coord, altitudes, error)) {
+            _terrainAltitude = error ? qQNaN() : altitudes[0];
+            emit terrainAltitudeChanged(_terrainAltitude);
+            return;
+        }
+
         TerrainAtCoordinateQuery* terrain = new TerrainAtCoordinateQuery(this);
         connect(terrain, &TerrainAtCoordinateQuery::terrainDataReceived, this, &VisualMissionItem::_terrainDataReceived);
         QList<QGeoCoordinate> rgCoord;
@@ -1105,6 +1105,17 @@ QGCView {
                     }
                 }
 
+                QGCButton {
+                    text:               qsTr("Optimize Route")
+                    Layout.fillWidth:   true
+                    Layout.columnSpan:  2
+                    enabled:            !masterController.syncInProgress && _visualItems.count > 2
+                    onClicked: {
+                        dropPanel.hide()
+                        _missionController.optimizeComplexItemRoute()
+                    }
+                }
+
                 Rectangle {
                     width:              parent.width * 0.8
                     height:             1
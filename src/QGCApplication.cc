@@ -87,6 +87,7 @@
 #include "EditPositionDialogController.h"
 #include "FactValueSliderListModel.h"
 #include "KMLFileHelper.h"
+#include "LogReplayIndex.h"
 
 #ifndef NO_SERIAL_LINK
 #include "SerialLink.h"
@@ -383,6 +384,7 @@ void QGCApplication::_initCommon(void)
     qmlRegisterUncreatableType<QGCCameraManager>    ("QGroundControl.Vehicle",              1, 0, "QGCCameraManager",       "Reference only");
     qmlRegisterUncreatableType<QGCCameraControl>    ("QGroundControl.Vehicle",              1, 0, "QGCCameraControl",       "Reference only");
     qmlRegisterUncreatableType<LinkInterface>       ("QGroundControl.Vehicle",              1, 0, "LinkInterface",          "Reference only");
+    qmlRegisterUncreatableType<TrajectoryHistory>   ("QGroundControl.Vehicle",              1, 0, "TrajectoryHistory",      "Reference only");
     qmlRegisterUncreatableType<JoystickManager>     ("QGroundControl.JoystickManager",      1, 0, "JoystickManager",        "Reference only");
     qmlRegisterUncreatableType<Joystick>            ("QGroundControl.JoystickManager",      1, 0, "Joystick",               "Reference only");
     qmlRegisterUncreatableType<QGCPositionManager>  ("QGroundControl.QGCPositionManager",   1, 0, "QGCPositionManager",     "Reference only");
@@ -542,9 +544,13 @@ void QGCApplication::saveTelemetryLogOnMainThread(QString tempLogfile)
 #else
             showMessage(error);
 #endif
+        } else {
+            // The replay index is optional, replay will rebuild it if it's missing
+            QFile::copy(LogReplayIndex::indexFileName(tempLogfile), LogReplayIndex::indexFileName(saveFilePath));
         }
     }
     QFile::remove(tempLogfile);
+    QFile::remove(LogReplayIndex::indexFileName(tempLogfile));
 }
 
 void QGCApplication::checkTelemetrySavePathOnMainThread(void)
@@ -232,6 +232,15 @@ void QGroundControlQmlGlobal::setFlightMapZoom(double zoom)
     }
 }
 
+QObject* QGroundControlQmlGlobal::gpsManager()
+{
+#ifndef __mobile__
+    return _toolbox->gpsManager();
+#else
+    return NULL;
+#endif
+}
+
 void QGroundControlQmlGlobal::_onGPSConnect()
 {
     _gpsRtkFactGroup.connected()->setRawValue(true);
@@ -27,6 +27,7 @@
 
 #include "QGCMapEngine.h"
 #include "QGCMapTileSet.h"
+#include "QGCTileDownloadScheduler.h"
 
 Q_DECLARE_METATYPE(QGCMapTask::TaskType)
 Q_DECLARE_METATYPE(QGCTile)
@@ -132,6 +133,7 @@ destroyMapEngine()
 //-----------------------------------------------------------------------------
 QGCMapEngine::QGCMapEngine()
     : _urlFactory(new UrlFactory())
+    , _downloadScheduler(NULL)
 #ifdef WE_ARE_KOSHER
     //-- TODO: Get proper version
     #if defined Q_OS_MAC
@@ -161,6 +163,7 @@ QGCMapEngine::QGCMapEngine()
     qRegisterMetaType<QList<QGCTile*>>();
     connect(&_worker, &QGCCacheWorker::updateTotals,   this, &QGCMapEngine::_updateTotals);
     connect(&_worker, &QGCCacheWorker::internetStatus, this, &QGCMapEngine::_internetStatus);
+    _memCache.setMaxBytes((quint64)getMaxMemCache() * 1024L * 1024L);
 }
 
 //-----------------------------------------------------------------------------
@@ -168,6 +171,7 @@ QGCMapEngine::~QGCMapEngine()
 {
     _worker.quit();
     _worker.wait();
+    delete _downloadScheduler;
     if(_urlFactory)
         delete _urlFactory;
 }
@@ -279,6 +283,38 @@ QGCMapEngine::cacheTile(UrlFactory::MapType type, const QString& hash, const QBy
     _worker.enqueueTask(task);
 }
 
+//-----------------------------------------------------------------------------
+bool
+QGCMapEngine::findMemTile(const QString& hash, QByteArray& image, QString& format, UrlFactory::MapType& type)
+{
+    return _memCache.find(hash, image, format, type);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCMapEngine::cacheMemTile(const QString& hash, const QByteArray& image, const QString& format, UrlFactory::MapType type, int generation)
+{
+    _memCache.insert(hash, image, format, type, generation);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCMapEngine::clearMemCache()
+{
+    _memCache.clear();
+}
+
+//-----------------------------------------------------------------------------
+QGCTileDownloadScheduler*
+QGCMapEngine::downloadScheduler()
+{
+    //-- Created on first use so it lives in the thread of the tile sets (main thread)
+    if(!_downloadScheduler) {
+        _downloadScheduler = new QGCTileDownloadScheduler();
+    }
+    return _downloadScheduler;
+}
+
 //-----------------------------------------------------------------------------
 QString
 QGCMapEngine::getTileHash(UrlFactory::MapType type, int x, int y, int z)
@@ -449,6 +485,7 @@ QGCMapEngine::setMaxMemCache(quint32 size)
     QSettings settings;
     settings.setValue(kMaxMemCacheKey, size);
     _maxMemCache = size;
+    _memCache.setMaxBytes((quint64)size * 1024L * 1024L);
 }
 
 //-----------------------------------------------------------------------------
@@ -479,6 +516,7 @@ void
 QGCMapEngine::_updateTotals(quint32 totaltiles, quint64 totalsize, quint32 defaulttiles, quint64 defaultsize)
 {
     emit updateTotals(totaltiles, totalsize, defaulttiles, defaultsize);
+    qCDebug(QGCTileCacheLog) << "Memory cache hits:misses:bytes" << _memCache.hits() << _memCache.misses() << _memCache.bytes();
     quint64 maxSize = (quint64)getMaxDiskCache() * 1024L * 1024L;
     if(!_prunning && defaultsize > maxSize) {
         //-- Prune Disk Cache
@@ -24,6 +24,9 @@
 #include "QGCMapUrlEngine.h"
 #include "QGCMapEngineData.h"
 #include "QGCTileCacheWorker.h"
+#include "QGCTileMemCache.h"
+
+class QGCTileDownloadScheduler;
 
 //-----------------------------------------------------------------------------
 class QGCTileSet
@@ -74,6 +77,10 @@ public:
     void                        cacheTile           (UrlFactory::MapType type, int x, int y, int z, const QByteArray& image, const QString& format, qulonglong set = UINT64_MAX);
     void                        cacheTile           (UrlFactory::MapType type, const QString& hash, const QByteArray& image, const QString& format, qulonglong set = UINT64_MAX);
     QGCFetchTileTask*           createFetchTileTask (UrlFactory::MapType type, int x, int y, int z);
+    bool                        findMemTile         (const QString& hash, QByteArray& image, QString& format, UrlFactory::MapType& type);
+    void                        cacheMemTile        (const QString& hash, const QByteArray& image, const QString& format, UrlFactory::MapType type, int generation);
+    void                        clearMemCache       ();
+    int                         memCacheGeneration  () { return _memCache.generation(); }
     QStringList                 getMapNameList      ();
     const QString               userAgent           () { return _userAgent; }
     void                        setUserAgent        (const QString& ua) { _userAgent = ua; }
@@ -89,6 +96,7 @@ public:
     bool                        isInternetActive    () { return _isInternetActive; }
 
     UrlFactory*                 urlFactory          () { return _urlFactory; }
+    QGCTileDownloadScheduler*   downloadScheduler   ();
 
     //-- Tile Math
     static QGCTileSet           getTileCount        (int zoom, double topleftLon, double topleftLat, double bottomRightLon, double bottomRightLat, UrlFactory::MapType mapType);
@@ -121,9 +129,11 @@ private:
 
 private:
     QGCCacheWorker          _worker;
+    QGCTileMemCache         _memCache;
     QString                 _cachePath;
     QString                 _cacheFile;
     UrlFactory*             _urlFactory;
+    QGCTileDownloadScheduler* _downloadScheduler;
     QString                 _userAgent;
     quint32                 _maxDiskCache;
     quint32                 _maxMemCache;
@@ -285,21 +285,25 @@ class QGCUpdateTileDownloadStateTask : public QGCMapTask
 {
     Q_OBJECT
 public:
-    QGCUpdateTileDownloadStateTask(qulonglong setID, QGCTile::TyleState state, const QString& hash)
+    //-- With hash "*", fromState limits the update to tiles currently in that state
+    QGCUpdateTileDownloadStateTask(qulonglong setID, QGCTile::TyleState state, const QString& hash, int fromState = -1)
         : QGCMapTask(QGCMapTask::taskUpdateTileDownloadState)
         , _setID(setID)
         , _state(state)
         , _hash(hash)
+        , _fromState(fromState)
     {}
 
-    QString             hash    () { return _hash; }
-    qulonglong          setID   () { return _setID; }
-    QGCTile::TyleState  state   () { return _state; }
+    QString             hash        () { return _hash; }
+    qulonglong          setID       () { return _setID; }
+    QGCTile::TyleState  state       () { return _state; }
+    int                 fromState   () { return _fromState; }
 
 private:
     qulonglong          _setID;
     QGCTile::TyleState  _state;
     QString             _hash;
+    int                 _fromState;
 };
 
 //-----------------------------------------------------------------------------
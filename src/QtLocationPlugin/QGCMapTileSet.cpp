@@ -19,6 +19,7 @@
 #include "QGCMapEngine.h"
 #include "QGCMapTileSet.h"
 #include "QGCMapEngineManager.h"
+#include "QGCTileDownloadScheduler.h"
 #include "TerrainTile.h"
 
 #include <QSettings>
@@ -48,7 +49,6 @@ QGCCachedTileSet::QGCCachedTileSet(const QString& name)
     , _downloading(false)
     , _id(0)
     , _type(UrlFactory::Invalid)
-    , _networkManager(NULL)
     , _errorCount(0)
     , _noMoreTiles(false)
     , _batchRequested(false)
@@ -61,8 +61,8 @@ QGCCachedTileSet::QGCCachedTileSet(const QString& name)
 //-----------------------------------------------------------------------------
 QGCCachedTileSet::~QGCCachedTileSet()
 {
-    if(_networkManager) {
-        delete _networkManager;
+    if(_downloading) {
+        _stopDownload();
     }
 }
 
@@ -73,6 +73,27 @@ QGCCachedTileSet::errorCountStr()
     return QGCMapEngine::numberToString(_errorCount);
 }
 
+//-----------------------------------------------------------------------------
+double
+QGCCachedTileSet::downloadTileRate()
+{
+    return _downloading ? getQGCMapEngine()->downloadScheduler()->tilesPerSecond(_id) : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+double
+QGCCachedTileSet::downloadByteRate()
+{
+    return _downloading ? getQGCMapEngine()->downloadScheduler()->bytesPerSecond(_id) : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+QString
+QGCCachedTileSet::downloadRateStr()
+{
+    return QString("%1 tiles/s (%2/s)").arg(downloadTileRate(), 0, 'f', 1).arg(QGCMapEngine::bigSizeToString((quint64)downloadByteRate()));
+}
+
 //-----------------------------------------------------------------------------
 QString
 QGCCachedTileSet::totalTileCountStr()
@@ -137,6 +158,13 @@ QGCCachedTileSet::createDownloadTask()
         _errorCount   = 0;
         _downloading  = true;
         _noMoreTiles  = false;
+        QGCTileDownloadScheduler* scheduler = getQGCMapEngine()->downloadScheduler();
+        connect(scheduler, &QGCTileDownloadScheduler::tileDownloaded,    this, &QGCCachedTileSet::_tileDownloaded);
+        connect(scheduler, &QGCTileDownloadScheduler::tileFailed,        this, &QGCCachedTileSet::_tileFailed);
+        connect(scheduler, &QGCTileDownloadScheduler::throughputChanged, this, &QGCCachedTileSet::_throughputChanged);
+        //-- Tiles left in downloading state by an interrupted session are downloaded again
+        QGCUpdateTileDownloadStateTask* task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StatePending, "*", QGCTile::StateDownloading);
+        getQGCMapEngine()->addTask(task);
         emit downloadingChanged();
         emit errorCountChanged();
     }
@@ -166,38 +194,50 @@ void
 QGCCachedTileSet::cancelDownloadTask()
 {
     if(_downloading) {
-        _downloading = false;
+        _stopDownload();
         emit downloadingChanged();
+        emit downloadRateChanged();
     }
 }
 
+//-----------------------------------------------------------------------------
+void
+QGCCachedTileSet::_stopDownload()
+{
+    _downloading = false;
+    QGCTileDownloadScheduler* scheduler = getQGCMapEngine()->downloadScheduler();
+    disconnect(scheduler, 0, this, 0);
+    scheduler->cancelSet(_id);
+    //-- Tiles handed to the scheduler are marked as downloading. Put them back in the queue.
+    QGCUpdateTileDownloadStateTask* task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StatePending, "*", QGCTile::StateDownloading);
+    getQGCMapEngine()->addTask(task);
+}
+
 //-----------------------------------------------------------------------------
 void
 QGCCachedTileSet::_tileListFetched(QList<QGCTile *> tiles)
 {
     _batchRequested = false;
+    if(!_downloading) {
+        //-- Cancelled while the list was being fetched
+        qDeleteAll(tiles);
+        return;
+    }
     //-- Done?
     if(tiles.size() < TILE_BATCH_SIZE) {
         _noMoreTiles = true;
     }
-    if(!tiles.size()) {
-        _doneWithDownload();
-        return;
+    //-- Hand tiles over to the scheduler
+    if(tiles.size()) {
+        getQGCMapEngine()->downloadScheduler()->addTiles(_id, tiles);
     }
-    //-- If this is the first time, create Network Manager
-    if (!_networkManager) {
-        _networkManager = new QNetworkAccessManager(this);
-    }
-    //-- Add tiles to the list
-    _tilesToDownload += tiles;
-    //-- Kick downloads
-    _prepareDownload();
+    _checkQueue();
 }
 
 //-----------------------------------------------------------------------------
 void QGCCachedTileSet::_doneWithDownload()
 {
-    if(!_errorCount) {
+    if(!_errorCount && _savedTileCount) {
         _totalTileCount = _savedTileCount;
         _totalTileSize  = _savedTileSize;
         //-- Too expensive to compute the real size now. Estimate it for the time being.
@@ -210,142 +250,87 @@ void QGCCachedTileSet::_doneWithDownload()
     emit savedTileCountChanged();
     emit uniqueTileSizeChanged();
     _downloading = false;
+    disconnect(getQGCMapEngine()->downloadScheduler(), 0, this, 0);
     emit downloadingChanged();
+    emit downloadRateChanged();
     emit completeChanged();
 }
 
 //-----------------------------------------------------------------------------
-void QGCCachedTileSet::_prepareDownload()
+void QGCCachedTileSet::_checkQueue()
 {
-    if(!_tilesToDownload.count()) {
-        //-- Are we done?
-        if(_noMoreTiles) {
-            _doneWithDownload();
-        } else {
-            if(!_batchRequested)
-                createDownloadTask();
-        }
+    if(!_downloading) {
         return;
     }
-    //-- Prepare queue (QNetworkAccessManager has a limit for concurrent downloads)
-    for(int i = _replies.count(); i < QGCMapEngine::concurrentDownloads(_type); i++) {
-        if(_tilesToDownload.count()) {
-            QGCTile* tile = _tilesToDownload.first();
-            _tilesToDownload.removeFirst();
-            QNetworkRequest request = getQGCMapEngine()->urlFactory()->getTileURL(tile->type(), tile->x(), tile->y(), tile->z(), _networkManager);
-            request.setAttribute(QNetworkRequest::User, tile->hash());
-#if !defined(__mobile__)
-            QNetworkProxy proxy = _networkManager->proxy();
-            QNetworkProxy tProxy;
-            tProxy.setType(QNetworkProxy::DefaultProxy);
-            _networkManager->setProxy(tProxy);
-#endif
-            QNetworkReply* reply = _networkManager->get(request);
-            reply->setParent(0);
-            connect(reply, &QNetworkReply::finished, this, &QGCCachedTileSet::_networkReplyFinished);
-            connect(reply, static_cast<void (QNetworkReply::*)(QNetworkReply::NetworkError)>(&QNetworkReply::error), this, &QGCCachedTileSet::_networkReplyError);
-            _replies.insert(tile->hash(), reply);
-#if !defined(__mobile__)
-            _networkManager->setProxy(proxy);
-#endif
-            delete tile;
-            //-- Refill queue if running low
-            if(!_batchRequested && !_noMoreTiles && _tilesToDownload.count() < (QGCMapEngine::concurrentDownloads(_type) * 10)) {
-                //-- Request new batch of tiles
-                createDownloadTask();
-            }
-        }
+    QGCTileDownloadScheduler* scheduler = getQGCMapEngine()->downloadScheduler();
+    int pending = scheduler->pendingCount(_id);
+    //-- Are we done?
+    if(!pending && _noMoreTiles && !_batchRequested) {
+        _doneWithDownload();
+        return;
+    }
+    //-- Refill queue if running low
+    if(!_batchRequested && !_noMoreTiles && pending < (scheduler->providerConcurrency(_type) * 10)) {
+        createDownloadTask();
     }
 }
 
 //-----------------------------------------------------------------------------
 void
-QGCCachedTileSet::_networkReplyFinished()
+QGCCachedTileSet::_tileDownloaded(quint64 setID, QString hash, UrlFactory::MapType type, QByteArray image)
 {
-    //-- Figure out which reply this is
-    QNetworkReply* reply = qobject_cast<QNetworkReply*>(QObject::sender());
-    if(!reply) {
-        qWarning() << "QGCMapEngineManager::networkReplyFinished() NULL Reply";
+    if(setID != _id) {
         return;
     }
-    //-- Get tile hash
-    const QString hash = reply->request().attribute(QNetworkRequest::User).toString();
-    if(!hash.isEmpty()) {
-        if(_replies.contains(hash)) {
-            _replies.remove(hash);
-        } else {
-            qWarning() << "QGCMapEngineManager::networkReplyFinished() Reply not in list: " << hash;
-        }
-        if (reply->error() != QNetworkReply::NoError) {
-            qWarning() << "QGCMapEngineManager::networkReplyFinished() Error:" << reply->errorString();
-            return;
-        }
-        qCDebug(QGCCachedTileSetLog) << "Tile fetched" << hash;
-        QByteArray image = reply->readAll();
-        UrlFactory::MapType type = getQGCMapEngine()->hashToType(hash);
-        if (type == UrlFactory::MapType::AirmapElevation) {
-            image = TerrainTile::serialize(image);
-        }
-        QString format = getQGCMapEngine()->urlFactory()->getImageFormat(type, image);
-        if(!format.isEmpty()) {
-            //-- Cache tile
-            getQGCMapEngine()->cacheTile(type, hash, image, format, _id);
-            QGCUpdateTileDownloadStateTask* task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateComplete, hash);
-            getQGCMapEngine()->addTask(task);
-            //-- Updated cached (downloaded) data
-            _savedTileSize += image.size();
-            _savedTileCount++;
-            emit savedTileSizeChanged();
-            emit savedTileCountChanged();
-            //-- Update estimate
-            if(_savedTileCount % 10 == 0) {
-                quint32 avg = _savedTileSize / _savedTileCount;
-                _totalTileSize  = avg * _totalTileCount;
-                _uniqueTileSize = avg * _uniqueTileCount;
-                emit totalTilesSizeChanged();
-                emit uniqueTileSizeChanged();
-            }
+    qCDebug(QGCCachedTileSetLog) << "Tile fetched" << hash;
+    if (type == UrlFactory::MapType::AirmapElevation) {
+        image = TerrainTile::serialize(image);
+    }
+    QString format = getQGCMapEngine()->urlFactory()->getImageFormat(type, image);
+    if(!format.isEmpty()) {
+        //-- Cache tile. Saving it also removes it from the set's download list.
+        getQGCMapEngine()->cacheTile(type, hash, image, format, _id);
+        //-- Updated cached (downloaded) data
+        _savedTileSize += image.size();
+        _savedTileCount++;
+        emit savedTileSizeChanged();
+        emit savedTileCountChanged();
+        //-- Update estimate
+        if(_savedTileCount % 10 == 0) {
+            quint32 avg = _savedTileSize / _savedTileCount;
+            _totalTileSize  = avg * _totalTileCount;
+            _uniqueTileSize = avg * _uniqueTileCount;
+            emit totalTilesSizeChanged();
+            emit uniqueTileSizeChanged();
         }
-        //-- Setup a new download
-        _prepareDownload();
     } else {
-        qWarning() << "QGCMapEngineManager::networkReplyFinished() Empty Hash";
+        _tileFailed(setID, hash, tr("Unknown image format"));
+        return;
     }
-    reply->deleteLater();
+    _checkQueue();
 }
 
 //-----------------------------------------------------------------------------
 void
-QGCCachedTileSet::_networkReplyError(QNetworkReply::NetworkError error)
+QGCCachedTileSet::_tileFailed(quint64 setID, QString hash, QString errorString)
 {
-    //-- Figure out which reply this is
-    QNetworkReply* reply = qobject_cast<QNetworkReply*>(QObject::sender());
-    if (!reply) {
+    if(setID != _id) {
         return;
     }
+    qCDebug(QGCCachedTileSetLog) << "Error fetching tile" << hash << errorString;
     //-- Update error count
     _errorCount++;
     emit errorCountChanged();
-    //-- Get tile hash
-    QString hash = reply->request().attribute(QNetworkRequest::User).toString();
-    qCDebug(QGCCachedTileSetLog) << "Error fetching tile" << reply->errorString();
-    if(!hash.isEmpty()) {
-        if(_replies.contains(hash)) {
-            _replies.remove(hash);
-        } else {
-            qWarning() << "QGCMapEngineManager::networkReplyError() Reply not in list: " << hash;
-        }
-        if (error != QNetworkReply::OperationCanceledError) {
-            qWarning() << "QGCMapEngineManager::networkReplyError() Error:" << reply->errorString();
-        }
-        QGCUpdateTileDownloadStateTask* task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateError, hash);
-        getQGCMapEngine()->addTask(task);
-    } else {
-        qWarning() << "QGCMapEngineManager::networkReplyError() Empty Hash";
-    }
-    //-- Setup a new download
-    _prepareDownload();
-    reply->deleteLater();
+    QGCUpdateTileDownloadStateTask* task = new QGCUpdateTileDownloadStateTask(_id, QGCTile::StateError, hash);
+    getQGCMapEngine()->addTask(task);
+    _checkQueue();
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCachedTileSet::_throughputChanged()
+{
+    emit downloadRateChanged();
 }
 
 //-----------------------------------------------------------------------------
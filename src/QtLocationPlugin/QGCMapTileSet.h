@@ -71,6 +71,9 @@ public:
     Q_PROPERTY(bool         downloading         READ    downloading         NOTIFY downloadingChanged)
     Q_PROPERTY(quint32      errorCount          READ    errorCount          NOTIFY errorCountChanged)
     Q_PROPERTY(QString      errorCountStr       READ    errorCountStr       NOTIFY errorCountChanged)
+    Q_PROPERTY(double       downloadTileRate    READ    downloadTileRate    NOTIFY downloadRateChanged)
+    Q_PROPERTY(double       downloadByteRate    READ    downloadByteRate    NOTIFY downloadRateChanged)
+    Q_PROPERTY(QString      downloadRateStr     READ    downloadRateStr     NOTIFY downloadRateChanged)
 
     Q_PROPERTY(bool         selected            READ    selected            WRITE  setSelected  NOTIFY selectedChanged)
 
@@ -111,6 +114,9 @@ public:
     bool        downloading             () { return _downloading; }
     quint32     errorCount              () { return _errorCount; }
     QString     errorCountStr           ();
+    double      downloadTileRate        ();
+    double      downloadByteRate        ();
+    QString     downloadRateStr         ();
     bool        selected                () { return _selected; }
 
     void        setSelected             (bool sel);
@@ -148,15 +154,18 @@ signals:
     void        errorCountChanged       ();
     void        selectedChanged         ();
     void        nameChanged             ();
+    void        downloadRateChanged     ();
 
 private slots:
     void _tileListFetched               (QList<QGCTile*> tiles);
-    void _networkReplyFinished          ();
-    void _networkReplyError             (QNetworkReply::NetworkError error);
+    void _tileDownloaded                (quint64 setID, QString hash, UrlFactory::MapType type, QByteArray image);
+    void _tileFailed                    (quint64 setID, QString hash, QString errorString);
+    void _throughputChanged             ();
 
 private:
-    void        _prepareDownload        ();
+    void        _checkQueue             ();
     void        _doneWithDownload       ();
+    void        _stopDownload           ();
 
 private:
     QString     _name;
@@ -179,11 +188,8 @@ private:
     QDateTime   _creationDate;
     quint64     _id;
     UrlFactory::MapType _type;
-    QNetworkAccessManager*  _networkManager;
-    QHash<QString, QNetworkReply*> _replies;
     quint32     _errorCount;
     //-- Tile download
-    QList<QGCTile *> _tilesToDownload;
     bool        _noMoreTiles;
     bool        _batchRequested;
     QGCMapEngineManager* _manager;
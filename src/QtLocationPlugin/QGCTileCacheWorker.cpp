@@ -18,6 +18,7 @@
 
 #include "QGCMapEngine.h"
 #include "QGCMapTileSet.h"
+#include "TerrainTileStore.h"
 
 #include <QVariant>
 #include <QtSql/QSqlQuery>
@@ -40,9 +41,18 @@ QGC_LOGGING_CATEGORY(QGCTileCacheLog, "QGCTileCacheLog")
 #define LONG_TIMEOUT        5
 #define SHORT_TIMEOUT       2
 
+//-- Maximum number of queued tile saves written in a single transaction
+
+#define SAVE_BATCH_SIZE     64
+
 //-----------------------------------------------------------------------------
 QGCCacheWorker::QGCCacheWorker()
     : _db(NULL)
+    , _saveTileQuery(NULL)
+    , _saveSetTileQuery(NULL)
+    , _getTileQuery(NULL)
+    , _findTileQuery(NULL)
+    , _deleteDownloadQuery(NULL)
     , _valid(false)
     , _failed(false)
     , _defaultSet(UINT64_MAX)
@@ -78,10 +88,15 @@ QGCCacheWorker::quit()
         QHostInfo::abortHostLookup(_hostLookupID);
     }
     _mutex.lock();
+    while(_fetchQueue.count()) {
+        QGCMapTask* task = _fetchQueue.dequeue();
+        delete task;
+    }
     while(_taskQueue.count()) {
         QGCMapTask* task = _taskQueue.dequeue();
         delete task;
     }
+    _pendingSaves.clear();
     _mutex.unlock();
     if(this->isRunning()) {
         _waitc.wakeAll();
@@ -99,7 +114,16 @@ QGCCacheWorker::enqueueTask(QGCMapTask* task)
         return false;
     }
     _mutex.lock();
-    _taskQueue.enqueue(task);
+    if(task->type() == QGCMapTask::taskFetchTile) {
+        //-- Tiles being displayed skip ahead of bulk work
+        _fetchQueue.enqueue(task);
+    } else {
+        if(task->type() == QGCMapTask::taskCacheTile) {
+            QGCSaveTileTask* saveTask = static_cast<QGCSaveTileTask*>(task);
+            _pendingSaves.insert(saveTask->tile()->hash(), saveTask);
+        }
+        _taskQueue.enqueue(task);
+    }
     _mutex.unlock();
     if(this->isRunning()) {
         _waitc.wakeAll();
@@ -117,94 +141,159 @@ QGCCacheWorker::run()
         _init();
     }
     if(_valid) {
-        _db = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kSession));
-        _db->setDatabaseName(_databasePath);
-        _db->setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-        _valid = _db->open();
+        _connectDB();
     }
     while(true) {
-        QGCMapTask* task;
-        if(_taskQueue.count()) {
-            _mutex.lock();
-            task = _taskQueue.dequeue();
-            _mutex.unlock();
-            switch(task->type()) {
-                case QGCMapTask::taskInit:
-                    break;
-                case QGCMapTask::taskCacheTile:
-                    _saveTile(task);
-                    break;
-                case QGCMapTask::taskFetchTile:
-                    _getTile(task);
-                    break;
-                case QGCMapTask::taskFetchTileSets:
-                    _getTileSets(task);
-                    break;
-                case QGCMapTask::taskCreateTileSet:
-                    _createTileSet(task);
-                    break;
-                case QGCMapTask::taskGetTileDownloadList:
-                    _getTileDownloadList(task);
-                    break;
-                case QGCMapTask::taskUpdateTileDownloadState:
-                    _updateTileDownloadState(task);
-                    break;
-                case QGCMapTask::taskDeleteTileSet:
-                    _deleteTileSet(task);
-                    break;
-                case QGCMapTask::taskRenameTileSet:
-                    _renameTileSet(task);
-                    break;
-                case QGCMapTask::taskPruneCache:
-                    _pruneCache(task);
-                    break;
-                case QGCMapTask::taskReset:
-                    _resetCacheDatabase(task);
-                    break;
-                case QGCMapTask::taskExport:
-                    _exportSets(task);
-                    break;
-                case QGCMapTask::taskImport:
-                    _importSets(task);
-                    break;
-                case QGCMapTask::taskTestInternet:
-                    _testInternet();
-                    break;
-            }
-            task->deleteLater();
-            //-- Check for update timeout
-            size_t count = _taskQueue.count();
-            if(count > 100) {
-                _updateTimeout = LONG_TIMEOUT;
-            } else if(count < 25) {
-                _updateTimeout = SHORT_TIMEOUT;
-            }
-            if(!count || (time(0) - _lastUpdate > _updateTimeout)) {
-                if(_valid) {
-                    _updateTotals();
-                }
-            }
-        } else {
+        QList<QGCMapTask*> tasks;
+        _mutex.lock();
+        if(!_fetchQueue.count() && !_taskQueue.count()) {
             //-- Wait a bit before shutting things down
-            _waitmutex.lock();
-            int timeout = 5000;
-            _waitc.wait(&_waitmutex, timeout);
-            _waitmutex.unlock();
-            _mutex.lock();
+            _waitc.wait(&_mutex, 5000);
             //-- If nothing to do, close db and leave thread
-            if(!_taskQueue.count()) {
+            if(!_fetchQueue.count() && !_taskQueue.count()) {
                 _mutex.unlock();
                 break;
             }
+        }
+        if(_fetchQueue.count()) {
+            tasks.append(_fetchQueue.dequeue());
+        } else {
+            tasks.append(_taskQueue.dequeue());
+            //-- Consecutive tile saves are written together in one transaction
+            if(tasks[0]->type() == QGCMapTask::taskCacheTile) {
+                while(tasks.count() < SAVE_BATCH_SIZE && _taskQueue.count() && _taskQueue.head()->type() == QGCMapTask::taskCacheTile) {
+                    tasks.append(_taskQueue.dequeue());
+                }
+            }
+        }
+        _mutex.unlock();
+        QGCMapTask* task = tasks[0];
+        switch(task->type()) {
+            case QGCMapTask::taskInit:
+                break;
+            case QGCMapTask::taskCacheTile:
+                _saveTiles(tasks);
+                break;
+            case QGCMapTask::taskFetchTile:
+                _getTile(task);
+                break;
+            case QGCMapTask::taskFetchTileSets:
+                _getTileSets(task);
+                break;
+            case QGCMapTask::taskCreateTileSet:
+                _createTileSet(task);
+                break;
+            case QGCMapTask::taskGetTileDownloadList:
+                _getTileDownloadList(task);
+                break;
+            case QGCMapTask::taskUpdateTileDownloadState:
+                _updateTileDownloadState(task);
+                break;
+            case QGCMapTask::taskDeleteTileSet:
+                _deleteTileSet(task);
+                break;
+            case QGCMapTask::taskRenameTileSet:
+                _renameTileSet(task);
+                break;
+            case QGCMapTask::taskPruneCache:
+                _pruneCache(task);
+                break;
+            case QGCMapTask::taskReset:
+                _resetCacheDatabase(task);
+                break;
+            case QGCMapTask::taskExport:
+                _exportSets(task);
+                break;
+            case QGCMapTask::taskImport:
+                _importSets(task);
+                break;
+            case QGCMapTask::taskTestInternet:
+                _testInternet();
+                break;
+        }
+        if(task->type() == QGCMapTask::taskCacheTile) {
+            //-- Saved tiles are now in the database
+            _mutex.lock();
+            foreach(QGCMapTask* saveTask, tasks) {
+                QString hash = static_cast<QGCSaveTileTask*>(saveTask)->tile()->hash();
+                if(_pendingSaves.value(hash) == saveTask) {
+                    _pendingSaves.remove(hash);
+                }
+            }
             _mutex.unlock();
         }
+        foreach(QGCMapTask* doneTask, tasks) {
+            doneTask->deleteLater();
+        }
+        //-- Check for update timeout
+        _mutex.lock();
+        size_t count = _fetchQueue.count() + _taskQueue.count();
+        _mutex.unlock();
+        if(count > 100) {
+            _updateTimeout = LONG_TIMEOUT;
+        } else if(count < 25) {
+            _updateTimeout = SHORT_TIMEOUT;
+        }
+        if(!count || (time(0) - _lastUpdate > _updateTimeout)) {
+            if(_valid) {
+                _updateTotals();
+            }
+        }
     }
+    _disconnectDB();
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_connectDB()
+{
+    _db = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kSession));
+    _db->setDatabaseName(_databasePath);
+    _db->setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
+    _valid = _db->open();
+    if(_valid) {
+        QSqlQuery query(*_db);
+        //-- Readers don't block behind a saving transaction (and vice versa) in WAL mode. Syncing
+        //   on checkpoints only is safe for WAL, a crash can at most lose the last few tiles.
+        if(!query.exec("PRAGMA journal_mode=WAL")) {
+            qWarning() << "Map Cache SQL error (enable WAL):" << query.lastError().text();
+        }
+        query.exec("PRAGMA synchronous=NORMAL");
+        //-- Statements used for every tile are only prepared once
+        _saveTileQuery = new QSqlQuery(*_db);
+        _saveTileQuery->prepare("INSERT INTO Tiles(hash, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)");
+        _saveSetTileQuery = new QSqlQuery(*_db);
+        _saveSetTileQuery->prepare("INSERT INTO SetTiles(tileID, setID) VALUES(?, ?)");
+        _getTileQuery = new QSqlQuery(*_db);
+        _getTileQuery->prepare("SELECT tile, format, type FROM Tiles WHERE hash = ?");
+        _findTileQuery = new QSqlQuery(*_db);
+        _findTileQuery->prepare("SELECT tileID FROM Tiles WHERE hash = ?");
+        _deleteDownloadQuery = new QSqlQuery(*_db);
+        _deleteDownloadQuery->prepare("DELETE FROM TilesDownload WHERE setID = ? AND hash = ?");
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_disconnectDB()
+{
+    delete _saveTileQuery;
+    delete _saveSetTileQuery;
+    delete _getTileQuery;
+    delete _findTileQuery;
+    delete _deleteDownloadQuery;
+    _saveTileQuery      = NULL;
+    _saveSetTileQuery   = NULL;
+    _getTileQuery       = NULL;
+    _findTileQuery      = NULL;
+    _deleteDownloadQuery = NULL;
     if(_db) {
         delete _db;
         _db = NULL;
         QSqlDatabase::removeDatabase(kSession);
     }
 }
+
 //-----------------------------------------------------------------------------
 bool
 QGCCacheWorker::_findTileSetID(const QString name, quint64& setID)
@@ -237,35 +326,59 @@ QGCCacheWorker::_getDefaultTileSet()
     return 1L;
 }
 
+//-----------------------------------------------------------------------------
+void
+QGCCacheWorker::_saveTiles(const QList<QGCMapTask*>& tasks)
+{
+    if(!_valid) {
+        qWarning() << "Map Cache SQL error (saveTile() open db):" << _db->lastError();
+        return;
+    }
+    _db->transaction();
+    foreach(QGCMapTask* task, tasks) {
+        _saveTile(task);
+    }
+    if(!_db->commit()) {
+        qWarning() << "Map Cache SQL error (commit saved tiles):" << _db->lastError();
+        _db->rollback();
+    }
+}
+
 //-----------------------------------------------------------------------------
 void
 QGCCacheWorker::_saveTile(QGCMapTask *mtask)
 {
-    if(_valid) {
-        QGCSaveTileTask* task = static_cast<QGCSaveTileTask*>(mtask);
-        QSqlQuery query(*_db);
-        query.prepare("INSERT INTO Tiles(hash, format, tile, size, type, date) VALUES(?, ?, ?, ?, ?, ?)");
-        query.addBindValue(task->tile()->hash());
-        query.addBindValue(task->tile()->format());
-        query.addBindValue(task->tile()->img());
-        query.addBindValue(task->tile()->img().size());
-        query.addBindValue(task->tile()->type());
-        query.addBindValue(QDateTime::currentDateTime().toTime_t());
-        if(query.exec()) {
-            quint64 tileID = query.lastInsertId().toULongLong();
-            quint64 setID = task->tile()->set() == UINT64_MAX ? _getDefaultTileSet() : task->tile()->set();
-            QString s = QString("INSERT INTO SetTiles(tileID, setID) VALUES(%1, %2)").arg(tileID).arg(setID);
-            query.prepare(s);
-            if(!query.exec()) {
-                qWarning() << "Map Cache SQL error (add tile into SetTiles):" << query.lastError().text();
-            }
-            qCDebug(QGCTileCacheLog) << "_saveTile() HASH:" << task->tile()->hash();
-        } else {
-            //-- Tile was already there.
-            //   QtLocation some times requests the same tile twice in a row. The first is saved, the second is already there.
+    QGCSaveTileTask* task = static_cast<QGCSaveTileTask*>(mtask);
+    _saveTileQuery->bindValue(0, task->tile()->hash());
+    _saveTileQuery->bindValue(1, task->tile()->format());
+    _saveTileQuery->bindValue(2, task->tile()->img());
+    _saveTileQuery->bindValue(3, task->tile()->img().size());
+    _saveTileQuery->bindValue(4, task->tile()->type());
+    _saveTileQuery->bindValue(5, QDateTime::currentDateTime().toTime_t());
+    if(_saveTileQuery->exec()) {
+        quint64 tileID = _saveTileQuery->lastInsertId().toULongLong();
+        quint64 setID = task->tile()->set() == UINT64_MAX ? _getDefaultTileSet() : task->tile()->set();
+        _saveSetTileQuery->bindValue(0, tileID);
+        _saveSetTileQuery->bindValue(1, setID);
+        if(!_saveSetTileQuery->exec()) {
+            qWarning() << "Map Cache SQL error (add tile into SetTiles):" << _saveSetTileQuery->lastError().text();
         }
+        _saveSetTileQuery->finish();
+        qCDebug(QGCTileCacheLog) << "_saveTile() HASH:" << task->tile()->hash();
     } else {
-        qWarning() << "Map Cache SQL error (saveTile() open db):" << _db->lastError();
+        //-- Tile was already there.
+        //   QtLocation some times requests the same tile twice in a row. The first is saved, the second is already there.
+    }
+    _saveTileQuery->finish();
+    //-- Tiles downloaded for a tile set are done. Removing them from the download list within the same
+    //   transaction as the save means an interrupted download resumes exactly where it left off.
+    if(task->tile()->set() != UINT64_MAX) {
+        _deleteDownloadQuery->bindValue(0, task->tile()->set());
+        _deleteDownloadQuery->bindValue(1, task->tile()->hash());
+        if(!_deleteDownloadQuery->exec()) {
+            qWarning() << "Map Cache SQL error (remove tile from TilesDownload):" << _deleteDownloadQuery->lastError().text();
+        }
+        _deleteDownloadQuery->finish();
     }
 }
 
@@ -278,25 +391,49 @@ QGCCacheWorker::_getTile(QGCMapTask* mtask)
     }
     bool found = false;
     QGCFetchTileTask* task = static_cast<QGCFetchTileTask*>(mtask);
-    QSqlQuery query(*_db);
-    QString s = QString("SELECT tile, format, type FROM Tiles WHERE hash = \"%1\"").arg(task->hash());
-    if(query.exec(s)) {
-        if(query.next()) {
-            QByteArray ar   = query.value(0).toByteArray();
-            QString format  = query.value(1).toString();
-            UrlFactory::MapType type = (UrlFactory::MapType)query.value(2).toInt();
+    _getTileQuery->bindValue(0, task->hash());
+    if(_getTileQuery->exec()) {
+        if(_getTileQuery->next()) {
+            QByteArray ar   = _getTileQuery->value(0).toByteArray();
+            QString format  = _getTileQuery->value(1).toString();
+            UrlFactory::MapType type = (UrlFactory::MapType)_getTileQuery->value(2).toInt();
             qCDebug(QGCTileCacheLog) << "_getTile() (Found in DB) HASH:" << task->hash();
             QGCCacheTile* tile = new QGCCacheTile(task->hash(), ar, format, type);
             task->setTileFetched(tile);
             found = true;
         }
     }
+    _getTileQuery->finish();
+    if(!found) {
+        //-- Reads skip ahead of saves, so the tile may still be waiting to be written
+        found = _getPendingTile(task->hash(), task);
+    }
     if(!found) {
         qCDebug(QGCTileCacheLog) << "_getTile() (NOT in DB) HASH:" << task->hash();
         task->setError("Tile not in cache database");
     }
 }
 
+//-----------------------------------------------------------------------------
+bool
+QGCCacheWorker::_getPendingTile(const QString& hash, QGCMapTask* mtask)
+{
+    QGCCacheTile* tile = NULL;
+    _mutex.lock();
+    QGCSaveTileTask* saveTask = _pendingSaves.value(hash);
+    if(saveTask) {
+        QGCCacheTile* pendingTile = saveTask->tile();
+        tile = new QGCCacheTile(hash, pendingTile->img(), pendingTile->format(), pendingTile->type());
+    }
+    _mutex.unlock();
+    if(!tile) {
+        return false;
+    }
+    qCDebug(QGCTileCacheLog) << "_getTile() (Pending save) HASH:" << hash;
+    static_cast<QGCFetchTileTask*>(mtask)->setTileFetched(tile);
+    return true;
+}
+
 //-----------------------------------------------------------------------------
 void
 QGCCacheWorker::_getTileSets(QGCMapTask* mtask)
@@ -420,13 +557,13 @@ QGCCacheWorker::_updateTotals()
 quint64 QGCCacheWorker::_findTile(const QString hash)
 {
     quint64 tileID = 0;
-    QSqlQuery query(*_db);
-    QString s = QString("SELECT tileID FROM Tiles WHERE hash = \"%1\"").arg(hash);
-    if(query.exec(s)) {
-        if(query.next()) {
-            tileID = query.value(0).toULongLong();
+    _findTileQuery->bindValue(0, hash);
+    if(_findTileQuery->exec()) {
+        if(_findTileQuery->next()) {
+            tileID = _findTileQuery->value(0).toULongLong();
         }
     }
+    _findTileQuery->finish();
     return tileID;
 }
 
@@ -532,12 +669,14 @@ QGCCacheWorker::_getTileDownloadList(QGCMapTask* mtask)
             tile->setZ(query.value("z").toInt());
             tiles.append(tile);
         }
+        _db->transaction();
         for(int i = 0; i < tiles.size(); i++) {
             s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2 and hash = \"%3\"").arg((int)QGCTile::StateDownloading).arg(task->setID()).arg(tiles[i]->hash());
             if(!query.exec(s)) {
                 qWarning() << "Map Cache SQL error (set TilesDownload state):" << query.lastError().text();
             }
         }
+        _db->commit();
     }
     task->setTileListFetched(tiles);
 }
@@ -557,6 +696,9 @@ QGCCacheWorker::_updateTileDownloadState(QGCMapTask* mtask)
     } else {
         if(task->hash() == "*") {
             s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2").arg((int)task->state()).arg(task->setID());
+            if(task->fromState() >= 0) {
+                s += QString(" AND state = %1").arg(task->fromState());
+            }
         } else {
             s = QString("UPDATE TilesDownload SET state = %1 WHERE setID = %2 AND hash = \"%3\"").arg((int)task->state()).arg(task->setID()).arg(task->hash());
         }
@@ -614,6 +756,14 @@ QGCCacheWorker::_deleteTileSet(qulonglong id)
 {
     QSqlQuery query(*_db);
     QString s;
+    //-- Elevation tiles unique to this set also go from the terrain tile files
+    QStringList elevationHashes;
+    s = QString("SELECT hash FROM Tiles WHERE type = %1 AND tileID IN (SELECT A.tileID FROM SetTiles A JOIN SetTiles B ON A.tileID = B.tileID WHERE B.setID = %2 GROUP BY A.tileID HAVING COUNT(A.tileID) = 1)").arg((int)UrlFactory::AirmapElevation).arg(id);
+    if(query.exec(s)) {
+        while(query.next()) {
+            elevationHashes.append(query.value(0).toString());
+        }
+    }
     //-- Only delete tiles unique to this set
     s = QString("DELETE FROM Tiles WHERE tileID IN (SELECT A.tileID FROM SetTiles A JOIN SetTiles B ON A.tileID = B.tileID WHERE B.setID = %1 GROUP BY A.tileID HAVING COUNT(A.tileID) = 1)").arg(id);
     query.exec(s);
@@ -623,6 +773,11 @@ QGCCacheWorker::_deleteTileSet(qulonglong id)
     query.exec(s);
     s = QString("DELETE FROM SetTiles WHERE setID = %1").arg(id);
     query.exec(s);
+    //-- Deleted tiles must not keep being served from memory
+    getQGCMapEngine()->clearMemCache();
+    if(!elevationHashes.isEmpty()) {
+        TerrainTileStore::instance()->remove(elevationHashes);
+    }
     _updateTotals();
 }
 
@@ -661,6 +816,8 @@ QGCCacheWorker::_resetCacheDatabase(QGCMapTask* mtask)
     s = QString("DROP TABLE TilesDownload");
     query.exec(s);
     _valid = _createDB(_db);
+    getQGCMapEngine()->clearMemCache();
+    TerrainTileStore::instance()->removeAll();
     task->setResetCompleted();
 }
 
@@ -675,23 +832,17 @@ QGCCacheWorker::_importSets(QGCMapTask* mtask)
     //-- If replacing, simply copy over it
     if(task->replace()) {
         //-- Close and delete old database
-        if(_db) {
-            delete _db;
-            _db = NULL;
-            QSqlDatabase::removeDatabase(kSession);
-        }
+        _disconnectDB();
         QFile file(_databasePath);
         file.remove();
         //-- Copy given database
         QFile::copy(task->path(), _databasePath);
+        getQGCMapEngine()->clearMemCache();
         task->setProgress(25);
         _init();
         if(_valid) {
             task->setProgress(50);
-            _db = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", kSession));
-            _db->setDatabaseName(_databasePath);
-            _db->setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            _valid = _db->open();
+            _connectDB();
         }
         task->setProgress(100);
     } else {
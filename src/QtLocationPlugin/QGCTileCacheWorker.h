@@ -22,10 +22,12 @@
 #include <QString>
 #include <QThread>
 #include <QQueue>
+#include <QHash>
 #include <QMutex>
 #include <QWaitCondition>
 #include <QMutexLocker>
 #include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
 #include <QHostInfo>
 
 #include "QGCLoggingCategory.h"
@@ -33,6 +35,7 @@
 Q_DECLARE_LOGGING_CATEGORY(QGCTileCacheLog)
 
 class QGCMapTask;
+class QGCSaveTileTask;
 class QGCCachedTileSet;
 
 //-----------------------------------------------------------------------------
@@ -54,6 +57,7 @@ private slots:
     void        _lookupReady            (QHostInfo info);
 
 private:
+    void        _saveTiles              (const QList<QGCMapTask*>& tasks);
     void        _saveTile               (QGCMapTask* mtask);
     void        _getTile                (QGCMapTask* mtask);
     void        _getTileSets            (QGCMapTask* mtask);
@@ -73,6 +77,9 @@ private:
     bool        _findTileSetID          (const QString name, quint64& setID);
     void        _updateSetTotals        (QGCCachedTileSet* set);
     bool        _init                   ();
+    void        _connectDB              ();
+    void        _disconnectDB           ();
+    bool        _getPendingTile         (const QString& hash, QGCMapTask* mtask);
     bool        _createDB               (QSqlDatabase *db, bool createDefault = true);
     quint64     _getDefaultTileSet      ();
     void        _updateTotals           ();
@@ -83,12 +90,18 @@ signals:
     void        internetStatus          (bool active);
 
 private:
-    QQueue<QGCMapTask*>     _taskQueue;
-    QMutex                  _mutex;
-    QMutex                  _waitmutex;
+    QQueue<QGCMapTask*>     _fetchQueue;        ///< Tile reads, these always go first
+    QQueue<QGCMapTask*>     _taskQueue;         ///< Everything else, processed in order
+    QHash<QString, QGCSaveTileTask*> _pendingSaves; ///< Queued tile saves by hash
+    QMutex                  _mutex;             ///< Protects the queues above
     QWaitCondition          _waitc;
     QString                 _databasePath;
     QSqlDatabase*           _db;
+    QSqlQuery*              _saveTileQuery;     ///< Prepared statements, only valid while _db is open
+    QSqlQuery*              _saveSetTileQuery;
+    QSqlQuery*              _getTileQuery;
+    QSqlQuery*              _findTileQuery;
+    QSqlQuery*              _deleteDownloadQuery;
     bool                    _valid;
     bool                    _failed;
     quint64                 _defaultSet;
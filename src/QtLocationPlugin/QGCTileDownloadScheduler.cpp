@@ -0,0 +1,396 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file
+ *   @brief Offline tile set download scheduler
+ *
+ */
+
+#include "QGCTileDownloadScheduler.h"
+#include "QGCMapEngine.h"
+
+#include <QSettings>
+#include <QNetworkProxy>
+
+QGC_LOGGING_CATEGORY(QGCTileDownloadLog, "QGCTileDownloadLog")
+
+static const char* kConcurrencyGroup = "TileDownloadConcurrency";
+
+#define DEFAULT_MAX_RETRIES     3
+#define DEFAULT_RETRY_DELAY     1000        // Doubled on each attempt
+#define MAX_RETRY_DELAY         30000
+#define THROUGHPUT_WINDOW       5000        // Throughput is averaged over this many msecs
+
+//-----------------------------------------------------------------------------
+QGCTileDownloadScheduler::QGCTileDownloadScheduler(QObject* parent, const QString& settingsGroup)
+    : QObject(parent)
+    , _settingsGroup(settingsGroup.isEmpty() ? QString(kConcurrencyGroup) : settingsGroup)
+    , _networkManager(NULL)
+    , _ownNetworkManager(false)
+    , _maxRetries(DEFAULT_MAX_RETRIES)
+    , _retryDelay(DEFAULT_RETRY_DELAY)
+{
+    qRegisterMetaType<UrlFactory::MapType>();
+    _retryTimer.setSingleShot(true);
+    connect(&_retryTimer, &QTimer::timeout, this, &QGCTileDownloadScheduler::_retryTimeout);
+    _throughputTimer.setInterval(1000);
+    connect(&_throughputTimer, &QTimer::timeout, this, &QGCTileDownloadScheduler::_throughputTimeout);
+    _clock.start();
+}
+
+//-----------------------------------------------------------------------------
+QGCTileDownloadScheduler::~QGCTileDownloadScheduler()
+{
+    QList<QNetworkReply*> replies = _replies.keys();
+    _replies.clear();
+    foreach(QNetworkReply* reply, replies) {
+        reply->abort();
+        reply->deleteLater();
+    }
+    if(_ownNetworkManager) {
+        delete _networkManager;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::setNetworkManager(QNetworkAccessManager* networkManager)
+{
+    if(_ownNetworkManager) {
+        delete _networkManager;
+    }
+    _networkManager     = networkManager;
+    _ownNetworkManager  = false;
+}
+
+//-----------------------------------------------------------------------------
+QString
+QGCTileDownloadScheduler::provider(UrlFactory::MapType type)
+{
+    if(type >= UrlFactory::GoogleMap && type <= UrlFactory::GoogleHybrid) {
+        return QStringLiteral("Google");
+    } else if(type >= UrlFactory::OpenStreetMap && type <= UrlFactory::OpenStreetMapSurferTerrain) {
+        return QStringLiteral("OpenStreetMap");
+    } else if(type == UrlFactory::StatkartTopo) {
+        return QStringLiteral("Statkart");
+    } else if(type == UrlFactory::EniroTopo) {
+        return QStringLiteral("Eniro");
+    } else if(type >= UrlFactory::BingMap && type <= UrlFactory::BingHybrid) {
+        return QStringLiteral("Bing");
+    } else if(type == UrlFactory::MapQuestMap || type == UrlFactory::MapQuestSat) {
+        return QStringLiteral("MapQuest");
+    } else if(type >= UrlFactory::VWorldMap && type <= UrlFactory::VWorldStreet) {
+        return QStringLiteral("VWorld");
+    } else if(type >= UrlFactory::MapboxStreets && type <= UrlFactory::MapboxHighContrast) {
+        return QStringLiteral("Mapbox");
+    } else if(type >= UrlFactory::EsriWorldStreet && type <= UrlFactory::EsriTerrain) {
+        return QStringLiteral("Esri");
+    } else if(type == UrlFactory::AirmapElevation) {
+        return QStringLiteral("Airmap");
+    }
+    return QString::number(type);
+}
+
+//-----------------------------------------------------------------------------
+int
+QGCTileDownloadScheduler::providerConcurrency(UrlFactory::MapType type)
+{
+    QString name = provider(type);
+    if(!_concurrency.contains(name)) {
+        QSettings settings;
+        settings.beginGroup(_settingsGroup);
+        _concurrency[name] = qMax(1, settings.value(name, QGCMapEngine::concurrentDownloads(type)).toInt());
+    }
+    return _concurrency[name];
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::setProviderConcurrency(const QString& provider, int count)
+{
+    count = qMax(1, count);
+    QSettings settings;
+    settings.beginGroup(_settingsGroup);
+    settings.setValue(provider, count);
+    _concurrency[provider] = count;
+    _startDownloads(provider);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::addTiles(quint64 setID, const QList<QGCTile*>& tiles)
+{
+    foreach(QGCTile* tile, tiles) {
+        Download download;
+        download.setID      = setID;
+        download.tile       = *tile;
+        download.attempts   = 0;
+        download.retryTime  = 0;
+        download.provider   = provider(tile->type());
+        _queues[download.provider].append(download);
+        delete tile;
+    }
+    _pending[setID] += tiles.count();
+    if(!_throughputTimer.isActive()) {
+        _throughputTimer.start();
+    }
+    _startDownloads();
+}
+
+//-----------------------------------------------------------------------------
+QStringList
+QGCTileDownloadScheduler::cancelSet(quint64 setID)
+{
+    QStringList hashes;
+    QMutableHashIterator<QString, QList<Download> > it(_queues);
+    while(it.hasNext()) {
+        it.next();
+        QList<Download>& queue = it.value();
+        for(int i = queue.count() - 1; i >= 0; i--) {
+            if(queue[i].setID == setID) {
+                hashes.append(queue[i].tile.hash());
+                queue.removeAt(i);
+            }
+        }
+        if(queue.isEmpty()) {
+            it.remove();
+        }
+    }
+    for(int i = _retries.count() - 1; i >= 0; i--) {
+        if(_retries[i].setID == setID) {
+            hashes.append(_retries[i].tile.hash());
+            _retries.removeAt(i);
+        }
+    }
+    QList<QNetworkReply*> replies = _replies.keys();
+    foreach(QNetworkReply* reply, replies) {
+        Download download = _replies[reply];
+        if(download.setID == setID) {
+            hashes.append(download.tile.hash());
+            _replies.remove(reply);
+            _active[download.provider]--;
+            reply->abort();
+            reply->deleteLater();
+        }
+    }
+    _samples.remove(setID);
+    _pending.remove(setID);
+    _startDownloads();
+    return hashes;
+}
+
+//-----------------------------------------------------------------------------
+int
+QGCTileDownloadScheduler::pendingCount(quint64 setID)
+{
+    return _pending.value(setID);
+}
+
+//-----------------------------------------------------------------------------
+QNetworkRequest
+QGCTileDownloadScheduler::_createRequest(const QGCTile& tile)
+{
+    return getQGCMapEngine()->urlFactory()->getTileURL(tile.type(), tile.x(), tile.y(), tile.z(), _networkManager);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::_startDownloads()
+{
+    foreach(const QString& provider, _queues.keys()) {
+        _startDownloads(provider);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::_startDownloads(const QString& provider)
+{
+    QHash<QString, QList<Download> >::iterator it = _queues.find(provider);
+    if(it == _queues.end()) {
+        return;
+    }
+    if(!_networkManager) {
+        _networkManager     = new QNetworkAccessManager(this);
+        _ownNetworkManager  = true;
+    }
+    //-- Queues are kept per provider so a finished reply only looks at the queue of its own provider
+    QList<Download>& queue = it.value();
+    while(queue.count() && _active.value(provider) < providerConcurrency(queue.first().tile.type())) {
+        Download download = queue.takeFirst();
+        QNetworkRequest request = _createRequest(download.tile);
+#if !defined(__mobile__)
+        QNetworkProxy proxy = _networkManager->proxy();
+        QNetworkProxy tProxy;
+        tProxy.setType(QNetworkProxy::DefaultProxy);
+        _networkManager->setProxy(tProxy);
+#endif
+        QNetworkReply* reply = _networkManager->get(request);
+        reply->setParent(0);
+        connect(reply, &QNetworkReply::finished, this, &QGCTileDownloadScheduler::_replyFinished);
+#if !defined(__mobile__)
+        _networkManager->setProxy(proxy);
+#endif
+        download.attempts++;
+        _active[provider]++;
+        _replies.insert(reply, download);
+    }
+    if(queue.isEmpty()) {
+        _queues.erase(it);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::_replyFinished()
+{
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(QObject::sender());
+    if(!reply || !_replies.contains(reply)) {
+        //-- Cancelled
+        return;
+    }
+    Download download = _replies.take(reply);
+    _active[download.provider]--;
+    reply->deleteLater();
+    int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if(reply->error() == QNetworkReply::NoError) {
+        QByteArray image = reply->readAll();
+        qCDebug(QGCTileDownloadLog) << "Tile fetched" << download.tile.hash() << image.size();
+        _addSample(download.setID, image.size());
+        _downloadDone(download.setID);
+        emit tileDownloaded(download.setID, download.tile.hash(), download.tile.type(), image);
+    } else {
+        //-- Only retry errors which may go away: server side (5xx), rate limiting (429) and network errors
+        bool transient = status == 0 || status == 429 || status >= 500;
+        qCDebug(QGCTileDownloadLog) << "Tile error" << download.tile.hash() << status << reply->errorString() << "attempt" << download.attempts;
+        if(transient && download.attempts <= _maxRetries) {
+            _scheduleRetry(download);
+        } else {
+            _downloadDone(download.setID);
+            emit tileFailed(download.setID, download.tile.hash(), reply->errorString());
+        }
+    }
+    _startDownloads(download.provider);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::_scheduleRetry(const Download& download)
+{
+    Download retry = download;
+    qint64 delay = qMin((qint64)_retryDelay << (download.attempts - 1), (qint64)MAX_RETRY_DELAY);
+    retry.retryTime = _clock.elapsed() + delay;
+    int i = 0;
+    while(i < _retries.count() && _retries[i].retryTime <= retry.retryTime) {
+        i++;
+    }
+    _retries.insert(i, retry);
+    _retryTimer.start(qMax((qint64)0, _retries.first().retryTime - _clock.elapsed()));
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::_retryTimeout()
+{
+    qint64 now = _clock.elapsed();
+    //-- Retries go to the front of the queue so a set doesn't finish with a long tail of failures
+    QHash<QString, int> insertIndex;
+    while(_retries.count() && _retries.first().retryTime <= now) {
+        Download retry = _retries.takeFirst();
+        _queues[retry.provider].insert(insertIndex[retry.provider]++, retry);
+    }
+    if(_retries.count()) {
+        _retryTimer.start(qMax((qint64)0, _retries.first().retryTime - now));
+    }
+    _startDownloads();
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::_downloadDone(quint64 setID)
+{
+    QHash<quint64, int>::iterator it = _pending.find(setID);
+    if(it != _pending.end() && --it.value() <= 0) {
+        _pending.erase(it);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::_addSample(quint64 setID, quint64 bytes)
+{
+    Sample sample;
+    sample.time     = _clock.elapsed();
+    sample.bytes    = bytes;
+    _samples[setID].append(sample);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::_pruneSamples()
+{
+    qint64 oldest = _clock.elapsed() - THROUGHPUT_WINDOW;
+    QMutableHashIterator<quint64, QList<Sample> > it(_samples);
+    while(it.hasNext()) {
+        it.next();
+        QList<Sample>& samples = it.value();
+        while(samples.count() && samples.first().time < oldest) {
+            samples.removeFirst();
+        }
+        if(samples.isEmpty()) {
+            it.remove();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+double
+QGCTileDownloadScheduler::tilesPerSecond(quint64 setID)
+{
+    double tiles, bytes;
+    throughput(setID, tiles, bytes);
+    return tiles;
+}
+
+//-----------------------------------------------------------------------------
+double
+QGCTileDownloadScheduler::bytesPerSecond(quint64 setID)
+{
+    double tiles, bytes;
+    throughput(setID, tiles, bytes);
+    return bytes;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::throughput(quint64 setID, double& tilesPerSecond, double& bytesPerSecond)
+{
+    _pruneSamples();
+    const QList<Sample> samples = _samples.value(setID);
+    quint64 bytes = 0;
+    foreach(const Sample& sample, samples) {
+        bytes += sample.bytes;
+    }
+    tilesPerSecond = samples.count() * 1000.0 / THROUGHPUT_WINDOW;
+    bytesPerSecond = bytes * 1000.0 / THROUGHPUT_WINDOW;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileDownloadScheduler::_throughputTimeout()
+{
+    _pruneSamples();
+    emit throughputChanged();
+    //-- Stop once idle and the rates have dropped to zero
+    if(_queues.isEmpty() && _retries.isEmpty() && _replies.isEmpty() && _samples.isEmpty()) {
+        _throughputTimer.stop();
+    }
+}
@@ -0,0 +1,127 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file
+ *   @brief Offline tile set download scheduler
+ *
+ */
+
+#ifndef QGC_TILE_DOWNLOAD_SCHEDULER_H
+#define QGC_TILE_DOWNLOAD_SCHEDULER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+
+#include "QGCLoggingCategory.h"
+#include "QGCMapEngineData.h"
+
+Q_DECLARE_LOGGING_CATEGORY(QGCTileDownloadLog)
+
+Q_DECLARE_METATYPE(UrlFactory::MapType)
+
+//-----------------------------------------------------------------------------
+// Downloads tiles for offline tile sets. It is shared by all tile sets so the
+// number of concurrent requests is limited per map provider, no matter how many
+// sets are downloading. Failed requests are retried with exponential backoff.
+// Downloaded tiles are reported through tileDownloaded(), persisting them (and
+// their download state) is up to the tile set.
+class QGCTileDownloadScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    //-- settingsGroup overrides the group provider concurrency is persisted in
+    QGCTileDownloadScheduler    (QObject* parent = NULL, const QString& settingsGroup = QString());
+    ~QGCTileDownloadScheduler   ();
+
+    //-- Queues tiles for download. Takes ownership of the tiles.
+    void        addTiles                (quint64 setID, const QList<QGCTile*>& tiles);
+    //-- Drops all queued and active downloads for a set. Returns the hashes of the tiles not downloaded.
+    QStringList cancelSet               (quint64 setID);
+    //-- Number of tiles queued, downloading or waiting to be retried for a set
+    int         pendingCount            (quint64 setID);
+
+    double      tilesPerSecond          (quint64 setID);
+    double      bytesPerSecond          (quint64 setID);
+    //-- Both rates, taken from the same sample window
+    void        throughput              (quint64 setID, double& tilesPerSecond, double& bytesPerSecond);
+
+    int         maxRetries              () { return _maxRetries; }
+    void        setMaxRetries           (int retries) { _maxRetries = retries; }
+    int         retryDelay              () { return _retryDelay; }
+    void        setRetryDelay           (int msecs) { _retryDelay = msecs; }
+
+    //-- Maximum number of concurrent downloads for the provider of a map type. Settings are persisted.
+    int         providerConcurrency     (UrlFactory::MapType type);
+    void        setProviderConcurrency  (const QString& provider, int count);
+
+    static QString provider             (UrlFactory::MapType type);
+
+    void        setNetworkManager       (QNetworkAccessManager* networkManager);
+
+signals:
+    void        tileDownloaded          (quint64 setID, QString hash, UrlFactory::MapType type, QByteArray image);
+    void        tileFailed              (quint64 setID, QString hash, QString errorString);
+    void        throughputChanged       ();
+
+protected:
+    virtual QNetworkRequest _createRequest  (const QGCTile& tile);
+
+private slots:
+    void        _replyFinished          ();
+    void        _retryTimeout           ();
+    void        _throughputTimeout      ();
+
+private:
+    struct Download {
+        quint64     setID;
+        QGCTile     tile;
+        int         attempts;
+        qint64      retryTime;
+        QString     provider;
+    };
+
+    struct Sample {
+        qint64      time;
+        quint64     bytes;
+    };
+
+    void        _startDownloads         ();
+    void        _startDownloads         (const QString& provider);
+    void        _scheduleRetry          (const Download& download);
+    void        _downloadDone           (quint64 setID);
+    void        _addSample              (quint64 setID, quint64 bytes);
+    void        _pruneSamples           ();
+
+    const QString                   _settingsGroup; ///< Settings group provider concurrency is persisted in
+    QNetworkAccessManager*          _networkManager;
+    bool                            _ownNetworkManager;
+    QHash<QString, QList<Download> >  _queues;       ///< Queued downloads per provider
+    QHash<quint64, int>             _pending;       ///< Queued, active and retrying downloads per set
+    QList<Download>                 _retries;       ///< Sorted by retry time
+    QHash<QNetworkReply*, Download> _replies;
+    QHash<QString, int>             _active;        ///< Active downloads per provider
+    QHash<QString, int>             _concurrency;   ///< Cached provider settings
+    QHash<quint64, QList<Sample> >  _samples;       ///< Completed downloads per set, for throughput
+    QTimer                          _retryTimer;
+    QTimer                          _throughputTimer;
+    QElapsedTimer                   _clock;
+    int                             _maxRetries;
+    int                             _retryDelay;
+};
+
+#endif // QGC_TILE_DOWNLOAD_SCHEDULER_H
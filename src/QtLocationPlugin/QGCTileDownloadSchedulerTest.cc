@@ -0,0 +1,221 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "QGCTileDownloadSchedulerTest.h"
+#include "QGCMapEngine.h"
+
+#include <QSignalSpy>
+#include <QSettings>
+#include <QTimer>
+
+static const char* kTileData = "tile";
+
+const char* TestTileDownloadScheduler::settingsGroup = "TileDownloadConcurrencyTest";
+
+TileHttpServer::TileHttpServer(void)
+    : failCount     (0)
+    , status        (200)
+    , delayMSecs    (0)
+    , requestCount  (0)
+    , inFlight      (0)
+    , maxInFlight   (0)
+{
+    connect(this, &QTcpServer::newConnection, this, &TileHttpServer::_newConnection);
+    listen(QHostAddress::LocalHost);
+}
+
+void TileHttpServer::_newConnection(void)
+{
+    while (hasPendingConnections()) {
+        QTcpSocket* socket = nextPendingConnection();
+        connect(socket, &QTcpSocket::readyRead,     this,   &TileHttpServer::_readRequest);
+        connect(socket, &QTcpSocket::disconnected,  socket, &QObject::deleteLater);
+    }
+}
+
+void TileHttpServer::_readRequest(void)
+{
+    QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+    QByteArray request = socket->property("request").toByteArray() + socket->readAll();
+    socket->setProperty("request", request);
+    if (!request.contains("\r\n\r\n")) {
+        return;
+    }
+    socket->setProperty("request", QByteArray());
+
+    requestCount++;
+    inFlight++;
+    maxInFlight = qMax(maxInFlight, inFlight);
+    QTimer::singleShot(delayMSecs, socket, [this, socket]() { _respond(socket); });
+}
+
+void TileHttpServer::_respond(QTcpSocket* socket)
+{
+    inFlight--;
+
+    int responseStatus = status;
+    if (failCount > 0) {
+        failCount--;
+        responseStatus = 503;
+    }
+
+    QByteArray body = responseStatus == 200 ? QByteArray(kTileData) : QByteArray();
+    QByteArray response = QString("HTTP/1.1 %1 Status\r\nContent-Length: %2\r\nConnection: close\r\n\r\n").arg(responseStatus).arg(body.size()).toLatin1();
+    socket->write(response + body);
+    socket->disconnectFromHost();
+}
+
+QNetworkRequest TestTileDownloadScheduler::_createRequest(const QGCTile& tile)
+{
+    return QNetworkRequest(QUrl(QString("http://127.0.0.1:%1/%2").arg(_port).arg(tile.hash())));
+}
+
+void QGCTileDownloadSchedulerTest::init(void)
+{
+    UnitTest::init();
+
+    QSettings settings;
+    settings.remove(TestTileDownloadScheduler::settingsGroup);
+}
+
+void QGCTileDownloadSchedulerTest::cleanup(void)
+{
+    QSettings settings;
+    settings.remove(TestTileDownloadScheduler::settingsGroup);
+
+    UnitTest::cleanup();
+}
+
+QList<QGCTile*> QGCTileDownloadSchedulerTest::_createTiles(int count)
+{
+    QList<QGCTile*> tiles;
+
+    for (int i=0; i<count; i++) {
+        QGCTile* tile = new QGCTile;
+        tile->setType(UrlFactory::GoogleMap);
+        tile->setHash(QString("tile%1").arg(i));
+        tiles.append(tile);
+    }
+    return tiles;
+}
+
+void QGCTileDownloadSchedulerTest::_download_test(void)
+{
+    TileHttpServer              server;
+    TestTileDownloadScheduler   scheduler(server.serverPort());
+    QSignalSpy                  downloadedSpy(&scheduler, &QGCTileDownloadScheduler::tileDownloaded);
+    QSignalSpy                  failedSpy(&scheduler, &QGCTileDownloadScheduler::tileFailed);
+
+    scheduler.addTiles(1, _createTiles(10));
+    QCOMPARE(scheduler.pendingCount(1), 10);
+    QCOMPARE(scheduler.pendingCount(2), 0);
+
+    for (int i=0; i<50 && downloadedSpy.count() < 10; i++) {
+        downloadedSpy.wait(100);
+    }
+    QCOMPARE(downloadedSpy.count(), 10);
+    QCOMPARE(failedSpy.count(), 0);
+    QCOMPARE(scheduler.pendingCount(1), 0);
+    QCOMPARE(downloadedSpy[0][0].toULongLong(), 1ull);
+    QCOMPARE(downloadedSpy[0][3].toByteArray(), QByteArray(kTileData));
+
+    // Throughput is averaged over the last few seconds. Both rates come from the same window so
+    // samples aging out between two calls can't skew the comparison.
+    double tilesPerSecond, bytesPerSecond;
+    scheduler.throughput(1, tilesPerSecond, bytesPerSecond);
+    QVERIFY(tilesPerSecond > 0);
+    QCOMPARE(bytesPerSecond, tilesPerSecond * qstrlen(kTileData));
+    QCOMPARE(scheduler.tilesPerSecond(2), 0.0);
+}
+
+void QGCTileDownloadSchedulerTest::_retry_test(void)
+{
+    TileHttpServer              server;
+    TestTileDownloadScheduler   scheduler(server.serverPort());
+    QSignalSpy                  downloadedSpy(&scheduler, &QGCTileDownloadScheduler::tileDownloaded);
+    QSignalSpy                  failedSpy(&scheduler, &QGCTileDownloadScheduler::tileFailed);
+
+    // First two attempts fail with a server error, the third succeeds
+    server.failCount = 2;
+    scheduler.setRetryDelay(10);
+    scheduler.setMaxRetries(2);
+    scheduler.addTiles(1, _createTiles(1));
+
+    QVERIFY(downloadedSpy.wait(5000));
+    QCOMPARE(server.requestCount, 3);
+    QCOMPARE(failedSpy.count(), 0);
+
+    // Out of retries
+    server.failCount = 3;
+    scheduler.addTiles(1, _createTiles(1));
+    QVERIFY(failedSpy.wait(5000));
+    QCOMPARE(server.requestCount, 6);
+    QCOMPARE(downloadedSpy.count(), 1);
+    QCOMPARE(scheduler.pendingCount(1), 0);
+}
+
+void QGCTileDownloadSchedulerTest::_notFound_test(void)
+{
+    TileHttpServer              server;
+    TestTileDownloadScheduler   scheduler(server.serverPort());
+    QSignalSpy                  failedSpy(&scheduler, &QGCTileDownloadScheduler::tileFailed);
+
+    // Client errors are not retried
+    server.status = 404;
+    scheduler.setRetryDelay(10);
+    scheduler.addTiles(1, _createTiles(1));
+    QVERIFY(failedSpy.wait(5000));
+    QCOMPARE(failedSpy[0][1].toString(), QStringLiteral("tile0"));
+    QTest::qWait(100);
+    QCOMPARE(server.requestCount, 1);
+}
+
+void QGCTileDownloadSchedulerTest::_concurrency_test(void)
+{
+    TileHttpServer              server;
+    TestTileDownloadScheduler   scheduler(server.serverPort());
+    QSignalSpy                  downloadedSpy(&scheduler, &QGCTileDownloadScheduler::tileDownloaded);
+    QString                     provider = QGCTileDownloadScheduler::provider(UrlFactory::GoogleMap);
+
+    // The limit is per provider, shared by all sets
+    server.delayMSecs = 50;
+    scheduler.setProviderConcurrency(provider, 2);
+    QCOMPARE(scheduler.providerConcurrency(UrlFactory::GoogleSatellite), 2);
+    scheduler.addTiles(1, _createTiles(4));
+    scheduler.addTiles(2, _createTiles(4));
+
+    for (int i=0; i<50 && downloadedSpy.count() < 8; i++) {
+        downloadedSpy.wait(100);
+    }
+    QCOMPARE(downloadedSpy.count(), 8);
+    QCOMPARE(server.maxInFlight, 2);
+    QCOMPARE(scheduler.pendingCount(1), 0);
+    QCOMPARE(scheduler.pendingCount(2), 0);
+}
+
+void QGCTileDownloadSchedulerTest::_cancel_test(void)
+{
+    TileHttpServer              server;
+    TestTileDownloadScheduler   scheduler(server.serverPort());
+    QSignalSpy                  downloadedSpy(&scheduler, &QGCTileDownloadScheduler::tileDownloaded);
+
+    server.delayMSecs = 50;
+    scheduler.addTiles(1, _createTiles(20));
+    scheduler.addTiles(2, _createTiles(1));
+
+    // Cancelling returns every tile not yet downloaded, active or queued
+    QStringList cancelled = scheduler.cancelSet(1);
+    QCOMPARE(cancelled.count(), 20);
+    QCOMPARE(scheduler.pendingCount(1), 0);
+
+    QVERIFY(downloadedSpy.wait(5000));
+    QTest::qWait(200);
+    QCOMPARE(downloadedSpy.count(), 1);
+    QCOMPARE(downloadedSpy[0][0].toULongLong(), 2ull);
+}
@@ -0,0 +1,75 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+#include "QGCTileDownloadScheduler.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+
+/// Minimal local HTTP server standing in for a map tile provider
+class TileHttpServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    TileHttpServer(void);
+
+    int     failCount;      ///< Number of requests answered with 503 before succeeding
+    int     status;         ///< Status returned once failCount is used up
+    int     delayMSecs;     ///< Delay before each response
+    int     requestCount;
+    int     inFlight;
+    int     maxInFlight;
+
+private slots:
+    void _newConnection (void);
+    void _readRequest   (void);
+
+private:
+    void _respond(QTcpSocket* socket);
+};
+
+/// Scheduler which downloads from TileHttpServer instead of the real provider
+class TestTileDownloadScheduler : public QGCTileDownloadScheduler
+{
+    Q_OBJECT
+
+public:
+    TestTileDownloadScheduler(quint16 port) : QGCTileDownloadScheduler(NULL, settingsGroup), _port(port) { }
+
+    static const char* settingsGroup;   ///< Keeps test provider limits out of the real settings
+
+protected:
+    QNetworkRequest _createRequest(const QGCTile& tile) final;
+
+private:
+    quint16 _port;
+};
+
+/// Unit test for QGCTileDownloadScheduler
+class QGCTileDownloadSchedulerTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void init               (void);
+    void cleanup            (void);
+
+    void _download_test     (void);
+    void _retry_test        (void);
+    void _notFound_test     (void);
+    void _concurrency_test  (void);
+    void _cancel_test       (void);
+
+private:
+    QList<QGCTile*> _createTiles(int count);
+};
@@ -0,0 +1,206 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file
+ *   @brief In memory map tile cache shared by all map views
+ *
+ */
+
+#include "QGCTileMemCache.h"
+
+#include <QMutexLocker>
+
+//-----------------------------------------------------------------------------
+QGCTileMemCache::QGCTileMemCache()
+    : _maxBytes(0)
+    , _generation(0)
+{
+    for(int i = 0; i < kShardCount; i++) {
+        _shards[i].head     = NULL;
+        _shards[i].tail     = NULL;
+        _shards[i].bytes    = 0;
+        _shards[i].maxBytes = 0;
+        _shards[i].hits     = 0;
+        _shards[i].misses   = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+QGCTileMemCache::~QGCTileMemCache()
+{
+    clear();
+}
+
+//-----------------------------------------------------------------------------
+bool
+QGCTileMemCache::find(const QString& hash, QByteArray& img, QString& format, UrlFactory::MapType& type)
+{
+    Shard& shard = _shard(hash);
+    QMutexLocker lock(&shard.mutex);
+    Entry* entry = shard.entries.value(hash, NULL);
+    if(!entry) {
+        shard.misses++;
+        return false;
+    }
+    shard.hits++;
+    if(entry != shard.head) {
+        _unlink(shard, entry);
+        _pushFront(shard, entry);
+    }
+    //-- Implicitly shared, no copy of the image is made
+    img     = entry->img;
+    format  = entry->format;
+    type    = entry->type;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileMemCache::insert(const QString& hash, const QByteArray& img, const QString& format, UrlFactory::MapType type, int generation)
+{
+    Shard& shard = _shard(hash);
+    QMutexLocker lock(&shard.mutex);
+    //-- Tile was looked up before the cache was cleared, it may have been deleted since
+    if(generation != _generation.load()) {
+        return;
+    }
+    //-- Tiles larger than a shard would just flush it
+    if((quint64)img.size() > shard.maxBytes) {
+        return;
+    }
+    Entry* entry = shard.entries.value(hash, NULL);
+    if(entry) {
+        shard.bytes -= entry->img.size();
+        _unlink(shard, entry);
+    } else {
+        entry = new Entry;
+        entry->hash = hash;
+        shard.entries.insert(hash, entry);
+    }
+    entry->img      = img;
+    entry->format   = format;
+    entry->type     = type;
+    shard.bytes    += img.size();
+    _pushFront(shard, entry);
+    _evict(shard);
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileMemCache::clear()
+{
+    //-- New generation first, inserts checking under a shard lock either see it or get cleared below
+    _generation.fetchAndAddOrdered(1);
+    for(int i = 0; i < kShardCount; i++) {
+        Shard& shard = _shards[i];
+        QMutexLocker lock(&shard.mutex);
+        qDeleteAll(shard.entries);
+        shard.entries.clear();
+        shard.head  = NULL;
+        shard.tail  = NULL;
+        shard.bytes = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileMemCache::setMaxBytes(quint64 maxBytes)
+{
+    _maxBytes = maxBytes;
+    for(int i = 0; i < kShardCount; i++) {
+        Shard& shard = _shards[i];
+        QMutexLocker lock(&shard.mutex);
+        shard.maxBytes = maxBytes / kShardCount;
+        _evict(shard);
+    }
+}
+
+//-----------------------------------------------------------------------------
+quint64
+QGCTileMemCache::bytes()
+{
+    quint64 total = 0;
+    for(int i = 0; i < kShardCount; i++) {
+        QMutexLocker lock(&_shards[i].mutex);
+        total += _shards[i].bytes;
+    }
+    return total;
+}
+
+//-----------------------------------------------------------------------------
+quint64
+QGCTileMemCache::hits()
+{
+    quint64 total = 0;
+    for(int i = 0; i < kShardCount; i++) {
+        QMutexLocker lock(&_shards[i].mutex);
+        total += _shards[i].hits;
+    }
+    return total;
+}
+
+//-----------------------------------------------------------------------------
+quint64
+QGCTileMemCache::misses()
+{
+    quint64 total = 0;
+    for(int i = 0; i < kShardCount; i++) {
+        QMutexLocker lock(&_shards[i].mutex);
+        total += _shards[i].misses;
+    }
+    return total;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileMemCache::_unlink(Shard& shard, Entry* entry)
+{
+    if(entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        shard.head = entry->next;
+    }
+    if(entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        shard.tail = entry->prev;
+    }
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileMemCache::_pushFront(Shard& shard, Entry* entry)
+{
+    entry->prev = NULL;
+    entry->next = shard.head;
+    if(shard.head) {
+        shard.head->prev = entry;
+    }
+    shard.head = entry;
+    if(!shard.tail) {
+        shard.tail = entry;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void
+QGCTileMemCache::_evict(Shard& shard)
+{
+    while(shard.bytes > shard.maxBytes && shard.tail) {
+        Entry* entry = shard.tail;
+        _unlink(shard, entry);
+        shard.entries.remove(entry->hash);
+        shard.bytes -= entry->img.size();
+        delete entry;
+    }
+}
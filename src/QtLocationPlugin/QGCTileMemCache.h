@@ -0,0 +1,86 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+
+/**
+ * @file
+ *   @brief In memory map tile cache shared by all map views
+ *
+ */
+
+#ifndef QGC_TILE_MEM_CACHE_H
+#define QGC_TILE_MEM_CACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QAtomicInt>
+
+#include "QGCMapUrlEngine.h"
+
+//-----------------------------------------------------------------------------
+// Byte bounded LRU of encoded tile images, keyed by tile hash. It sits in front
+// of the SQLite cache and is accessed directly from the requesting thread. The
+// cache is split into shards, each with its own lock and LRU list, so lookups
+// from different threads rarely contend.
+//
+// Every clear starts a new generation. Callers pick up the generation before
+// they start looking for a tile and pass it back when inserting it, so a tile
+// read or downloaded before a clear can't put deleted data back in the cache.
+class QGCTileMemCache
+{
+public:
+    QGCTileMemCache     ();
+    ~QGCTileMemCache    ();
+
+    bool        find            (const QString& hash, QByteArray& img, QString& format, UrlFactory::MapType& type);
+    void        insert          (const QString& hash, const QByteArray& img, const QString& format, UrlFactory::MapType type, int generation);
+    void        clear           ();
+    int         generation      () const { return _generation.load(); }
+    void        setMaxBytes     (quint64 maxBytes);
+    quint64     maxBytes        () { return _maxBytes; }
+    quint64     bytes           ();
+    quint64     hits            ();
+    quint64     misses          ();
+
+private:
+    struct Entry {
+        QString             hash;
+        QByteArray          img;
+        QString             format;
+        UrlFactory::MapType type;
+        Entry*              prev;
+        Entry*              next;
+    };
+
+    struct Shard {
+        QMutex                  mutex;
+        QHash<QString, Entry*>  entries;
+        Entry*                  head;       ///< Most recently used
+        Entry*                  tail;       ///< Least recently used
+        quint64                 bytes;
+        quint64                 maxBytes;
+        quint64                 hits;
+        quint64                 misses;
+    };
+
+    Shard&      _shard          (const QString& hash) { return _shards[qHash(hash) % kShardCount]; }
+    void        _unlink         (Shard& shard, Entry* entry);
+    void        _pushFront      (Shard& shard, Entry* entry);
+    void        _evict          (Shard& shard);
+
+    static const int kShardCount = 16;
+
+    Shard       _shards[kShardCount];
+    quint64     _maxBytes;
+    QAtomicInt  _generation;
+};
+
+#endif // QGC_TILE_MEM_CACHE_H
@@ -61,6 +61,7 @@ QGeoTiledMapReplyQGC::QGeoTiledMapReplyQGC(QNetworkAccessManager *networkManager
     , _reply(NULL)
     , _request(request)
     , _networkManager(networkManager)
+    , _memCacheGeneration(getQGCMapEngine()->memCacheGeneration())
 {
     if(_request.url().isEmpty()) {
         if(!_badMapbox.size()) {
@@ -72,6 +73,10 @@ QGeoTiledMapReplyQGC::QGeoTiledMapReplyQGC(QNetworkAccessManager *networkManager
         setMapImageFormat("png");
         setFinished(true);
         setCached(false);
+    } else if(_findMemTile()) {
+        //-- Tile was recently shown (possibly in a different map view), no need to go to the database
+        setFinished(true);
+        setCached(true);
     } else {
         QGCFetchTileTask* task = getQGCMapEngine()->createFetchTileTask((UrlFactory::MapType)spec.mapId(), spec.x(), spec.y(), spec.zoom());
         connect(task, &QGCFetchTileTask::tileFetched, this, &QGeoTiledMapReplyQGC::cacheReply);
@@ -137,6 +142,7 @@ QGeoTiledMapReplyQGC::networkReplyFinished()
         if(!format.isEmpty()) {
             setMapImageFormat(format);
             getQGCMapEngine()->cacheTile((UrlFactory::MapType)tileSpec().mapId(), tileSpec().x(), tileSpec().y(), tileSpec().zoom(), a, format);
+            _cacheMemTile(a, format);
         }
         setFinished(true);
     }
@@ -215,10 +221,40 @@ QGeoTiledMapReplyQGC::cacheReply(QGCCacheTile* tile)
         setMapImageFormat(tile->format());
         setFinished(true);
         setCached(true);
+        _cacheMemTile(tile->img(), tile->format());
     }
     tile->deleteLater();
 }
 
+//-----------------------------------------------------------------------------
+bool
+QGeoTiledMapReplyQGC::_findMemTile()
+{
+    //-- Elevation data is handled by the terrain cache, and its signal isn't connected yet at this point
+    UrlFactory::MapType type = (UrlFactory::MapType)tileSpec().mapId();
+    if(type == UrlFactory::MapType::AirmapElevation) {
+        return false;
+    }
+    QByteArray image;
+    QString format;
+    QString hash = QGCMapEngine::getTileHash(type, tileSpec().x(), tileSpec().y(), tileSpec().zoom());
+    if(!getQGCMapEngine()->findMemTile(hash, image, format, type)) {
+        return false;
+    }
+    setMapImageData(image);
+    setMapImageFormat(format);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+void
+QGeoTiledMapReplyQGC::_cacheMemTile(const QByteArray& image, const QString& format)
+{
+    UrlFactory::MapType type = (UrlFactory::MapType)tileSpec().mapId();
+    QString hash = QGCMapEngine::getTileHash(type, tileSpec().x(), tileSpec().y(), tileSpec().zoom());
+    getQGCMapEngine()->cacheMemTile(hash, image, format, type, _memCacheGeneration);
+}
+
 //-----------------------------------------------------------------------------
 void
 QGeoTiledMapReplyQGC::timeout()
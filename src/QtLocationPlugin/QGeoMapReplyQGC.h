@@ -73,6 +73,8 @@ private slots:
 
 private:
     void _clearReply            ();
+    bool _findMemTile           ();
+    void _cacheMemTile          (const QByteArray& image, const QString& format);
 
 private:
     QNetworkReply*          _reply;
@@ -81,6 +83,7 @@ private:
     QByteArray              _badMapbox;
     QByteArray              _badTile;
     QTimer                  _timer;
+    int                     _memCacheGeneration;    ///< Memory cache generation when the tile was first looked up
     static int              _requestCount;
 };
 
@@ -28,6 +28,7 @@ const char* AppSettings::batteryPercentRemainingAnnounceSettingsName =  "battery
 const char* AppSettings::defaultMissionItemAltitudeSettingsName =       "DefaultMissionItemAltitude";
 const char* AppSettings::telemetrySaveName =                            "PromptFLightDataSave";
 const char* AppSettings::telemetrySaveNotArmedName =                    "PromptFLightDataSaveNotArmed";
+const char* AppSettings::telemetrySaveSyncIntervalName =                "TelemetrySaveSyncInterval";
 const char* AppSettings::audioMutedName =                               "AudioMuted";
 const char* AppSettings::virtualJoystickName =                          "VirtualTabletJoystick";
 const char* AppSettings::appFontPointSizeName =                         "BaseDeviceFontPointSize";
@@ -35,6 +36,8 @@ const char* AppSettings::indoorPaletteName =                            "StyleIs
 const char* AppSettings::showLargeCompassName =                         "ShowLargeCompass";
 const char* AppSettings::savePathName =                                 "SavePath";
 const char* AppSettings::autoLoadMissionsName =                         "AutoLoadMissions";
+const char* AppSettings::planTransferWindowName =                       "PlanTransferWindow";
+const char* AppSettings::parameterDownloadFTPName =                     "ParameterDownloadFTP";
 const char* AppSettings::useChecklistName =                             "UseChecklist";
 const char* AppSettings::mapboxTokenName =                              "MapboxToken";
 const char* AppSettings::esriTokenName =                                "EsriToken";
@@ -71,6 +74,7 @@ AppSettings::AppSettings(QObject* parent)
     , _defaultMissionItemAltitudeFact       (NULL)
     , _telemetrySaveFact                    (NULL)
     , _telemetrySaveNotArmedFact            (NULL)
+    , _telemetrySaveSyncIntervalFact        (NULL)
     , _audioMutedFact                       (NULL)
     , _virtualJoystickFact                  (NULL)
     , _appFontPointSizeFact                 (NULL)
@@ -78,6 +82,8 @@ AppSettings::AppSettings(QObject* parent)
     , _showLargeCompassFact                 (NULL)
     , _savePathFact                         (NULL)
     , _autoLoadMissionsFact                 (NULL)
+    , _planTransferWindowFact               (NULL)
+    , _parameterDownloadFTPFact             (NULL)
     , _useChecklistFact                     (NULL)
     , _mapboxTokenFact                      (NULL)
     , _esriTokenFact                        (NULL)
@@ -215,6 +221,15 @@ Fact* AppSettings::telemetrySaveNotArmed(void)
     return _telemetrySaveNotArmedFact;
 }
 
+Fact* AppSettings::telemetrySaveSyncInterval(void)
+{
+    if (!_telemetrySaveSyncIntervalFact) {
+        _telemetrySaveSyncIntervalFact = _createSettingsFact(telemetrySaveSyncIntervalName);
+    }
+
+    return _telemetrySaveSyncIntervalFact;
+}
+
 Fact* AppSettings::audioMuted(void)
 {
     if (!_audioMutedFact) {
@@ -369,6 +384,24 @@ Fact* AppSettings::autoLoadMissions(void)
     return _autoLoadMissionsFact;
 }
 
+Fact* AppSettings::planTransferWindow(void)
+{
+    if (!_planTransferWindowFact) {
+        _planTransferWindowFact = _createSettingsFact(planTransferWindowName);
+    }
+
+    return _planTransferWindowFact;
+}
+
+Fact* AppSettings::parameterDownloadFTP(void)
+{
+    if (!_parameterDownloadFTPFact) {
+        _parameterDownloadFTPFact = _createSettingsFact(parameterDownloadFTPName);
+    }
+
+    return _parameterDownloadFTPFact;
+}
+
 Fact* AppSettings::mapboxToken(void)
 {
     if (!_mapboxTokenFact) {
@@ -30,6 +30,7 @@ public:
     Q_PROPERTY(Fact* defaultMissionItemAltitude         READ defaultMissionItemAltitude         CONSTANT)
     Q_PROPERTY(Fact* telemetrySave                      READ telemetrySave                      CONSTANT)
     Q_PROPERTY(Fact* telemetrySaveNotArmed              READ telemetrySaveNotArmed              CONSTANT)
+    Q_PROPERTY(Fact* telemetrySaveSyncInterval          READ telemetrySaveSyncInterval          CONSTANT)
     Q_PROPERTY(Fact* audioMuted                         READ audioMuted                         CONSTANT)
     Q_PROPERTY(Fact* virtualJoystick                    READ virtualJoystick                    CONSTANT)
     Q_PROPERTY(Fact* appFontPointSize                   READ appFontPointSize                   CONSTANT)
@@ -37,6 +38,8 @@ public:
     Q_PROPERTY(Fact* showLargeCompass                   READ showLargeCompass                   CONSTANT)
     Q_PROPERTY(Fact* savePath                           READ savePath                           CONSTANT)
     Q_PROPERTY(Fact* autoLoadMissions                   READ autoLoadMissions                   CONSTANT)
+    Q_PROPERTY(Fact* planTransferWindow                 READ planTransferWindow                 CONSTANT)
+    Q_PROPERTY(Fact* parameterDownloadFTP               READ parameterDownloadFTP               CONSTANT)
     Q_PROPERTY(Fact* useChecklist                       READ useChecklist                       CONSTANT)
     Q_PROPERTY(Fact* mapboxToken                        READ mapboxToken                        CONSTANT)
     Q_PROPERTY(Fact* esriToken                          READ esriToken                          CONSTANT)
@@ -69,6 +72,7 @@ public:
     Fact* defaultMissionItemAltitude        (void);
     Fact* telemetrySave                     (void);
     Fact* telemetrySaveNotArmed             (void);
+    Fact* telemetrySaveSyncInterval         (void);
     Fact* audioMuted                        (void);
     Fact* virtualJoystick                   (void);
     Fact* appFontPointSize                  (void);
@@ -76,6 +80,8 @@ public:
     Fact* showLargeCompass                  (void);
     Fact* savePath                          (void);
     Fact* autoLoadMissions                  (void);
+    Fact* planTransferWindow                (void);
+    Fact* parameterDownloadFTP              (void);
     Fact* useChecklist                      (void);
     Fact* mapboxToken                       (void);
     Fact* esriToken                         (void);
@@ -106,6 +112,7 @@ public:
     static const char* defaultMissionItemAltitudeSettingsName;
     static const char* telemetrySaveName;
     static const char* telemetrySaveNotArmedName;
+    static const char* telemetrySaveSyncIntervalName;
     static const char* audioMutedName;
     static const char* virtualJoystickName;
     static const char* appFontPointSizeName;
@@ -113,6 +120,8 @@ public:
     static const char* showLargeCompassName;
     static const char* savePathName;
     static const char* autoLoadMissionsName;
+    static const char* planTransferWindowName;
+    static const char* parameterDownloadFTPName;
     static const char* useChecklistName;
     static const char* mapboxTokenName;
     static const char* esriTokenName;
@@ -157,6 +166,7 @@ private:
     SettingsFact* _defaultMissionItemAltitudeFact;
     SettingsFact* _telemetrySaveFact;
     SettingsFact* _telemetrySaveNotArmedFact;
+    SettingsFact* _telemetrySaveSyncIntervalFact;
     SettingsFact* _audioMutedFact;
     SettingsFact* _virtualJoystickFact;
     SettingsFact* _appFontPointSizeFact;
@@ -164,6 +174,8 @@ private:
     SettingsFact* _showLargeCompassFact;
     SettingsFact* _savePathFact;
     SettingsFact* _autoLoadMissionsFact;
+    SettingsFact* _planTransferWindowFact;
+    SettingsFact* _parameterDownloadFTPFact;
     SettingsFact* _useChecklistFact;
     SettingsFact* _mapboxTokenFact;
     SettingsFact* _esriTokenFact;
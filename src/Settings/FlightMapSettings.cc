@@ -21,11 +21,13 @@ const char* FlightMapSettings::settingsGroup =              "FlightMap";
 
 const char* FlightMapSettings::mapProviderSettingsName =    "MapProvider";
 const char* FlightMapSettings::mapTypeSettingsName =        "MapType";
+const char* FlightMapSettings::trajectoryHistoryLengthSettingsName = "TrajectoryHistoryLength";
 
 FlightMapSettings::FlightMapSettings(QObject* parent)
     : SettingsGroup(name, settingsGroup, parent)
     , _mapProviderFact(NULL)
     , _mapTypeFact(NULL)
+    , _trajectoryHistoryLengthFact(NULL)
 {
     QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
     qmlRegisterUncreatableType<FlightMapSettings>("QGroundControl.SettingsManager", 1, 0, "FlightMapSettings", "Reference only");
@@ -66,6 +68,15 @@ Fact* FlightMapSettings::mapType(void)
     return _mapTypeFact;
 }
 
+Fact* FlightMapSettings::trajectoryHistoryLength(void)
+{
+    if (!_trajectoryHistoryLengthFact) {
+        _trajectoryHistoryLengthFact = _createSettingsFact(trajectoryHistoryLengthSettingsName);
+    }
+
+    return _trajectoryHistoryLengthFact;
+}
+
 void FlightMapSettings::_excludeProvider(MapProvider_t provider)
 {
     FactMetaData* metaData = _nameToMetaDataMap[mapProviderSettingsName];
@@ -40,15 +40,18 @@ public:
 
     Q_PROPERTY(Fact* mapProvider     READ mapProvider   CONSTANT)               ///< Currently selected map provider
     Q_PROPERTY(Fact* mapType         READ mapType       NOTIFY mapTypeChanged)  ///< Current selected map type
+    Q_PROPERTY(Fact* trajectoryHistoryLength READ trajectoryHistoryLength CONSTANT) ///< Minutes of flight path kept per vehicle
 
-    Fact* mapProvider   (void);
-    Fact* mapType       (void);
+    Fact* mapProvider               (void);
+    Fact* mapType                   (void);
+    Fact* trajectoryHistoryLength   (void);
 
     static const char* name;
     static const char* settingsGroup;
 
     static const char* mapProviderSettingsName;
     static const char* mapTypeSettingsName;
+    static const char* trajectoryHistoryLengthSettingsName;
 
 signals:
     void mapTypeChanged(void);
@@ -62,6 +65,7 @@ private:
 
     SettingsFact*   _mapProviderFact;
     SettingsFact*   _mapTypeFact;
+    SettingsFact*   _trajectoryHistoryLengthFact;
     QStringList     _savedMapTypeStrings;
     QVariantList    _savedMapTypeValues;
 };
@@ -17,11 +17,13 @@ const char* RTKSettings::settingsGroup =                        "RTK";
 
 const char* RTKSettings::surveyInAccuracyLimitName =            "SurveyInAccuracyLimit";
 const char* RTKSettings::surveyInMinObservationDurationName =   "SurveyInMinObservationDuration";
+const char* RTKSettings::correctionBandwidthLimitName =         "CorrectionBandwidthLimit";
 
 RTKSettings::RTKSettings(QObject* parent)
     : SettingsGroup(name, settingsGroup, parent)
     , _surveyInAccuracyLimitFact(NULL)
     , _surveyInMinObservationDurationFact(NULL)
+    , _correctionBandwidthLimitFact(NULL)
 {
     QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
     qmlRegisterUncreatableType<RTKSettings>("QGroundControl.SettingsManager", 1, 0, "RTKSettings", "Reference only");
@@ -44,3 +46,12 @@ Fact* RTKSettings::surveyInMinObservationDuration(void)
 
     return _surveyInMinObservationDurationFact;
 }
+
+Fact* RTKSettings::correctionBandwidthLimit(void)
+{
+    if (!_correctionBandwidthLimitFact) {
+        _correctionBandwidthLimitFact = _createSettingsFact(correctionBandwidthLimitName);
+    }
+
+    return _correctionBandwidthLimitFact;
+}
@@ -20,17 +20,21 @@ public:
 
     Q_PROPERTY(Fact* surveyInAccuracyLimit          READ surveyInAccuracyLimit          CONSTANT)
     Q_PROPERTY(Fact* surveyInMinObservationDuration READ surveyInMinObservationDuration CONSTANT)
+    Q_PROPERTY(Fact* correctionBandwidthLimit       READ correctionBandwidthLimit       CONSTANT)
 
     Fact* surveyInAccuracyLimit         (void);
     Fact* surveyInMinObservationDuration(void);
+    Fact* correctionBandwidthLimit      (void);
 
     static const char* name;
     static const char* settingsGroup;
 
     static const char* surveyInAccuracyLimitName;
     static const char* surveyInMinObservationDurationName;
+    static const char* correctionBandwidthLimitName;
 
 private:
     SettingsFact* _surveyInAccuracyLimitFact;
     SettingsFact* _surveyInMinObservationDurationFact;
+    SettingsFact* _correctionBandwidthLimitFact;
 };
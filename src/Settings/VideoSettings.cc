@@ -33,6 +33,7 @@ const char* VideoSettings::enableStorageLimitName = "EnableStorageLimit";
 const char* VideoSettings::rtspTimeoutName =        "RtspTimeout";
 const char* VideoSettings::streamEnabledName =      "StreamEnabled";
 const char* VideoSettings::disableWhenDisarmedName ="DisableWhenDisarmed";
+const char* VideoSettings::lowLatencyModeName =     "LowLatencyMode";
 
 const char* VideoSettings::videoSourceNoVideo =     "No Video Available";
 const char* VideoSettings::videoDisabled =          "Video Stream Disabled";
@@ -55,6 +56,7 @@ VideoSettings::VideoSettings(QObject* parent)
     , _rtspTimeoutFact(NULL)
     , _streamEnabledFact(NULL)
     , _disableWhenDisarmedFact(NULL)
+    , _lowLatencyModeFact(NULL)
 {
     QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
     qmlRegisterUncreatableType<VideoSettings>("QGroundControl.SettingsManager", 1, 0, "VideoSettings", "Reference only");
@@ -203,6 +205,14 @@ Fact* VideoSettings::disableWhenDisarmed(void)
     return _disableWhenDisarmedFact;
 }
 
+Fact* VideoSettings::lowLatencyMode(void)
+{
+    if (!_lowLatencyModeFact) {
+        _lowLatencyModeFact = _createSettingsFact(lowLatencyModeName);
+    }
+    return _lowLatencyModeFact;
+}
+
 bool VideoSettings::streamConfigured(void)
 {
 #if !defined(QGC_GST_STREAMING)
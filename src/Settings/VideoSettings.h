@@ -32,6 +32,7 @@ public:
     Q_PROPERTY(Fact* rtspTimeout            READ rtspTimeout            CONSTANT)
     Q_PROPERTY(Fact* streamEnabled          READ streamEnabled          CONSTANT)
     Q_PROPERTY(Fact* disableWhenDisarmed    READ disableWhenDisarmed    CONSTANT)
+    Q_PROPERTY(Fact* lowLatencyMode         READ lowLatencyMode         CONSTANT)
     Q_PROPERTY(bool  streamConfigured       READ streamConfigured       NOTIFY streamConfiguredChanged)
 
     Fact* videoSource           (void);
@@ -47,6 +48,7 @@ public:
     Fact* rtspTimeout           (void);
     Fact* streamEnabled         (void);
     Fact* disableWhenDisarmed   (void);
+    Fact* lowLatencyMode        (void);
     bool  streamConfigured      (void);
 
     static const char* name;
@@ -65,6 +67,7 @@ public:
     static const char* rtspTimeoutName;
     static const char* streamEnabledName;
     static const char* disableWhenDisarmedName;
+    static const char* lowLatencyModeName;
 
     static const char* videoSourceNoVideo;
     static const char* videoDisabled;
@@ -92,6 +95,7 @@ private:
     SettingsFact* _rtspTimeoutFact;
     SettingsFact* _streamEnabledFact;
     SettingsFact* _disableWhenDisarmedFact;
+    SettingsFact* _lowLatencyModeFact;
 };
 
 #endif
@@ -11,6 +11,7 @@
 #include "QGCMapEngine.h"
 #include "QGeoMapReplyQGC.h"
 #include "QGCApplication.h"
+#include "TerrainTileStore.h"
 
 #include <QUrl>
 #include <QUrlQuery>
@@ -306,11 +307,17 @@ void TerrainOfflineAirMapQuery::requestCarpetHeights(const QGeoCoordinate& swCoo
         return;
     }
 
-    // TODO
-    Q_UNUSED(swCoord);
-    Q_UNUSED(neCoord);
-    Q_UNUSED(statsOnly);
-    qWarning() << "Carpet queries are currently not supported from offline air map data";
+    _terrainTileManager->addCarpetQuery(this, swCoord, neCoord, statsOnly);
+}
+
+void TerrainOfflineAirMapQuery::requestPolyPathHeights(const QList<QGeoCoordinate>& polyPath)
+{
+    if (qgcApp()->runningUnitTests()) {
+        emit polyPathHeightsReceived(false, QList<TerrainPathHeightInfo_t>());
+        return;
+    }
+
+    _terrainTileManager->addPolyPathQuery(this, polyPath);
 }
 
 void TerrainOfflineAirMapQuery::_signalCoordinateHeights(bool success, QList<double> heights)
@@ -323,6 +330,11 @@ void TerrainOfflineAirMapQuery::_signalPathHeights(bool success, double latStep,
     emit pathHeightsReceived(success, latStep, lonStep, heights);
 }
 
+void TerrainOfflineAirMapQuery::_signalPolyPathHeights(bool success, const QList<TerrainPathHeightInfo_t>& rgPathHeightInfo)
+{
+    emit polyPathHeightsReceived(success, rgPathHeightInfo);
+}
+
 void TerrainOfflineAirMapQuery::_signalCarpetHeights(bool success, double minHeight, double maxHeight, const QList<QList<double>>& carpet)
 {
     emit carpetHeightsReceived(success, minHeight, maxHeight, carpet);
@@ -333,39 +345,25 @@ TerrainTileManager::TerrainTileManager(void)
 
 }
 
-void TerrainTileManager::addCoordinateQuery(TerrainOfflineAirMapQuery* terrainQueryInterface, const QList<QGeoCoordinate>& coordinates)
+TerrainTileManager::~TerrainTileManager()
 {
-    qCDebug(TerrainQueryLog) << "TerrainTileManager::addCoordinateQuery count" << coordinates.count();
-
-    if (coordinates.length() > 0) {
-        bool error;
-        QList<double> altitudes;
-
-        if (!_getAltitudesForCoordinates(coordinates, altitudes, error)) {
-            qCDebug(TerrainQueryLog) << "TerrainTileManager::addPathQuery queue count" << _requestQueue.count();
-            QueuedRequestInfo_t queuedRequestInfo = { terrainQueryInterface, QueryMode::QueryModeCoordinates, 0, 0, coordinates };
-            _requestQueue.append(queuedRequestInfo);
-            return;
-        }
-
-        if (error) {
-            QList<double> noAltitudes;
-            qCWarning(TerrainQueryLog) << "addCoordinateQuery: signalling failure due to internal error";
-            terrainQueryInterface->_signalCoordinateHeights(false, noAltitudes);
-        } else {
-            qCDebug(TerrainQueryLog) << "addCoordinateQuery: All altitudes taken from cached data";
-            terrainQueryInterface->_signalCoordinateHeights(coordinates.count() == altitudes.count(), altitudes);
-        }
+    // Outstanding replies reference _networkManager so they must go away before it does. They are disconnected
+    // first since aborting a reply signals terrainDone.
+    QList<QGeoTiledMapReplyQGC*> replies = findChildren<QGeoTiledMapReplyQGC*>(QString(), Qt::FindDirectChildrenOnly);
+    foreach (QGeoTiledMapReplyQGC* reply, replies) {
+        disconnect(reply, &QGeoTiledMapReplyQGC::terrainDone, this, &TerrainTileManager::_terrainDone);
+        reply->abort();
+        delete reply;
     }
 }
 
-void TerrainTileManager::addPathQuery(TerrainOfflineAirMapQuery* terrainQueryInterface, const QGeoCoordinate &startPoint, const QGeoCoordinate &endPoint)
+/// Splits the path between the two points into coordinates spaced at the resolution of the terrain data
+QList<QGeoCoordinate> TerrainTileManager::_pathCoordinates(const QGeoCoordinate& startPoint, const QGeoCoordinate& endPoint, double& latStep, double& lonStep)
 {
-    // Convert to individual coordinate queries
     QList<QGeoCoordinate> coordinates;
     double lat = startPoint.latitude();
     double lon = startPoint.longitude();
-    double steps = ceil(endPoint.distanceTo(startPoint) / TerrainTile::terrainAltitudeSpacing);
+    double steps = qMax(ceil(endPoint.distanceTo(startPoint) / TerrainTile::terrainAltitudeSpacing), 1.0);
     double latDiff = endPoint.latitude() - lat;
     double lonDiff = endPoint.longitude() - lon;
     for (double i = 0.0; i <= steps; i = i + 1) {
@@ -373,175 +371,321 @@ void TerrainTileManager::addPathQuery(TerrainOfflineAirMapQuery* terrainQueryInt
     }
     // We always have one too many and we always want the last one to be the endpoint
     coordinates.last() = endPoint;
-    double latStep = coordinates[1].latitude() - coordinates[0].latitude();
-    double lonStep = coordinates[1].longitude() - coordinates[0].longitude();
+    latStep = coordinates[1].latitude() - coordinates[0].latitude();
+    lonStep = coordinates[1].longitude() - coordinates[0].longitude();
+
+    return coordinates;
+}
+
+void TerrainTileManager::addCoordinateQuery(TerrainOfflineAirMapQuery* terrainQueryInterface, const QList<QGeoCoordinate>& coordinates)
+{
+    qCDebug(TerrainQueryLog) << "TerrainTileManager::addCoordinateQuery count" << coordinates.count();
+
+    if (coordinates.length() > 0) {
+        QueuedRequestInfo_t requestInfo = { terrainQueryInterface, QueryModeCoordinates, coordinates, {}, {}, {}, 0, false, {} };
+        _addRequest(requestInfo);
+    }
+}
+
+void TerrainTileManager::addPathQuery(TerrainOfflineAirMapQuery* terrainQueryInterface, const QGeoCoordinate &startPoint, const QGeoCoordinate &endPoint)
+{
+    double latStep, lonStep;
+    QList<QGeoCoordinate> coordinates = _pathCoordinates(startPoint, endPoint, latStep, lonStep);
 
     qCDebug(TerrainQueryLog) << "TerrainTileManager::addPathQuery start:end:coordCount" << startPoint << endPoint << coordinates.count();
 
-    bool error;
-    QList<double> altitudes;
-    if (!_getAltitudesForCoordinates(coordinates, altitudes, error)) {
-        qCDebug(TerrainQueryLog) << "TerrainTileManager::addPathQuery queue count" << _requestQueue.count();
-        QueuedRequestInfo_t queuedRequestInfo = { terrainQueryInterface, QueryMode::QueryModePath, latStep, lonStep, coordinates };
-        _requestQueue.append(queuedRequestInfo);
+    QueuedRequestInfo_t requestInfo = { terrainQueryInterface, QueryModePath, coordinates, { latStep }, { lonStep }, {}, 0, false, {} };
+    _addRequest(requestInfo);
+}
+
+void TerrainTileManager::addPolyPathQuery(TerrainOfflineAirMapQuery* terrainQueryInterface, const QList<QGeoCoordinate>& polyPath)
+{
+    qCDebug(TerrainQueryLog) << "TerrainTileManager::addPolyPathQuery count" << polyPath.count();
+
+    if (polyPath.count() < 2) {
+        terrainQueryInterface->_signalPolyPathHeights(false, QList<TerrainPathHeightInfo_t>());
         return;
     }
 
-    if (error) {
-        QList<double> noAltitudes;
-        qCWarning(TerrainQueryLog) << "addPathQuery: signalling failure due to internal error";
-        terrainQueryInterface->_signalPathHeights(false, latStep, lonStep, noAltitudes);
-    } else {
-        qCDebug(TerrainQueryLog) << "addPathQuery: All altitudes taken from cached data";
-        terrainQueryInterface->_signalPathHeights(coordinates.count() == altitudes.count(), latStep, lonStep, altitudes);
+    // All paths go into a single request. The end point of one path is the start of the next, those
+    // duplicates are taken care of when looking up the altitudes.
+    QueuedRequestInfo_t requestInfo = { terrainQueryInterface, QueryModePolyPath, {}, {}, {}, {}, 0, false, {} };
+    for (int i=0; i<polyPath.count() - 1; i++) {
+        double latStep, lonStep;
+        QList<QGeoCoordinate> coordinates = _pathCoordinates(polyPath[i], polyPath[i+1], latStep, lonStep);
+        requestInfo.coordinates += coordinates;
+        requestInfo.latSteps.append(latStep);
+        requestInfo.lonSteps.append(lonStep);
+        requestInfo.pathCounts.append(coordinates.count());
     }
+    _addRequest(requestInfo);
 }
 
-/// Either returns altitudes from cache or queues database request
+void TerrainTileManager::addCarpetQuery(TerrainOfflineAirMapQuery* terrainQueryInterface, const QGeoCoordinate& swCoord, const QGeoCoordinate& neCoord, bool statsOnly)
+{
+    // Sample the area on a grid at the resolution of the terrain data, rows go from south to north
+    int latSteps = qMax(static_cast<int>(ceil(swCoord.distanceTo(QGeoCoordinate(neCoord.latitude(), swCoord.longitude())) / TerrainTile::terrainAltitudeSpacing)), 1);
+    int lonSteps = qMax(static_cast<int>(ceil(swCoord.distanceTo(QGeoCoordinate(swCoord.latitude(), neCoord.longitude())) / TerrainTile::terrainAltitudeSpacing)), 1);
+    double latDiff = neCoord.latitude() - swCoord.latitude();
+    double lonDiff = neCoord.longitude() - swCoord.longitude();
+
+    qCDebug(TerrainQueryLog) << "TerrainTileManager::addCarpetQuery sw:ne:rows:columns" << swCoord << neCoord << latSteps + 1 << lonSteps + 1;
+
+    QueuedRequestInfo_t requestInfo = { terrainQueryInterface, QueryModeCarpet, {}, {}, {}, {}, lonSteps + 1, statsOnly, {} };
+    for (int i=0; i<=latSteps; i++) {
+        for (int j=0; j<=lonSteps; j++) {
+            requestInfo.coordinates.append(QGeoCoordinate(swCoord.latitude() + latDiff * i / latSteps, swCoord.longitude() + lonDiff * j / lonSteps));
+        }
+    }
+    _addRequest(requestInfo);
+}
+
+bool TerrainTileManager::getAltitudesForCoordinates(const QList<QGeoCoordinate>& coordinates, QList<double>& altitudes, bool& error)
+{
+    QList<QGeoCoordinate> missingTiles;
+    return _lookupAltitudes(coordinates, altitudes, error, missingTiles);
+}
+
+/// Looks up altitudes from the tile store, identical coordinates are only looked up once
 ///     @param[out] error true: altitude not returned due to error, false: altitudes returned
-/// @return true: altitude returned (check error as well), false: database query queued (altitudes not returned)
-bool TerrainTileManager::_getAltitudesForCoordinates(const QList<QGeoCoordinate>& coordinates, QList<double>& altitudes, bool& error)
+///     @param[out] missingTiles One coordinate within each tile which is not available
+/// @return true: altitudes returned (check error as well), false: tiles are missing
+bool TerrainTileManager::_lookupAltitudes(const QList<QGeoCoordinate>& coordinates, QList<double>& altitudes, bool& error, QList<QGeoCoordinate>& missingTiles)
 {
     error = false;
 
-    foreach (const QGeoCoordinate& coordinate, coordinates) {
-        QString tileHash = _getTileHash(coordinate);
-        qCDebug(TerrainQueryLog) << "TerrainTileManager::_getAltitudesForCoordinates hash:coordinate" << tileHash << coordinate;
-
-        _tilesMutex.lock();
-        if (_tiles.contains(tileHash)) {
-            if (_tiles[tileHash].isIn(coordinate)) {
-                double elevation = _tiles[tileHash].elevation(coordinate);
-                if (qIsNaN(elevation)) {
-                    error = true;
-                    qCWarning(TerrainQueryLog) << "TerrainTileManager::_getAltitudesForCoordinates Internal Error: negative elevation in tile cache";
-                } else {
-                    qCDebug(TerrainQueryLog) << "TerrainTileManager::_getAltitudesForCoordinates returning elevation from tile cache" << elevation;
-                }
-                altitudes.push_back(elevation);
-            } else {
-                qCWarning(TerrainQueryLog) << "TerrainTileManager::_getAltitudesForCoordinates Internal Error: coordinate not in tile region";
-                altitudes.push_back(qQNaN());
-                error = true;
-            }
-        } else {
-            if (_state != State::Downloading) {
-                QNetworkRequest request = getQGCMapEngine()->urlFactory()->getTileURL(UrlFactory::AirmapElevation, QGCMapEngine::long2elevationTileX(coordinate.longitude(), 1), QGCMapEngine::lat2elevationTileY(coordinate.latitude(), 1), 1, &_networkManager);
-                qCDebug(TerrainQueryLog) << "TerrainTileManager::_getAltitudesForCoordinates query from database" << request.url();
-                QGeoTileSpec spec;
-                spec.setX(QGCMapEngine::long2elevationTileX(coordinate.longitude(), 1));
-                spec.setY(QGCMapEngine::lat2elevationTileY(coordinate.latitude(), 1));
-                spec.setZoom(1);
-                spec.setMapId(UrlFactory::AirmapElevation);
-                QGeoTiledMapReplyQGC* reply = new QGeoTiledMapReplyQGC(&_networkManager, request, spec);
-                connect(reply, &QGeoTiledMapReplyQGC::terrainDone, this, &TerrainTileManager::_terrainDone);
-                _state = State::Downloading;
-            }
-            _tilesMutex.unlock();
+    QHash<QPair<double, double>, int>   uniqueIndices;
+    QList<QGeoCoordinate>               uniqueCoordinates;
+    QVector<int>                        coordinateIndices(coordinates.count());
+    for (int i=0; i<coordinates.count(); i++) {
+        QPair<double, double> key(coordinates[i].latitude(), coordinates[i].longitude());
+        QHash<QPair<double, double>, int>::const_iterator it = uniqueIndices.constFind(key);
+        if (it == uniqueIndices.constEnd()) {
+            it = uniqueIndices.insert(key, uniqueCoordinates.count());
+            uniqueCoordinates.append(coordinates[i]);
+        }
+        coordinateIndices[i] = it.value();
+    }
+
+    QList<double> uniqueAltitudes;
+    if (!TerrainTileStore::instance()->elevations(uniqueCoordinates, uniqueAltitudes, missingTiles)) {
+        return false;
+    }
 
-            return false;
+    altitudes.clear();
+    altitudes.reserve(coordinates.count());
+    for (int i=0; i<coordinates.count(); i++) {
+        double altitude = uniqueAltitudes[coordinateIndices[i]];
+        if (qIsNaN(altitude)) {
+            qCWarning(TerrainQueryLog) << "TerrainTileManager::_lookupAltitudes Internal Error: invalid elevation in tile cache";
+            error = true;
         }
-        _tilesMutex.unlock();
+        altitudes.append(altitude);
     }
+    qCDebug(TerrainQueryVerboseLog) << "TerrainTileManager::_lookupAltitudes coordinates:unique" << coordinates.count() << uniqueCoordinates.count();
 
     return true;
 }
 
-void TerrainTileManager::_tileFailed(void)
+/// Answers the request from cached tiles, or queues it and fetches the tiles which are missing
+void TerrainTileManager::_addRequest(QueuedRequestInfo_t& requestInfo)
 {
-    QList<double>    noAltitudes;
+    if (_answerRequest(requestInfo)) {
+        qCDebug(TerrainQueryLog) << "TerrainTileManager::_addRequest All altitudes taken from cached data";
+        return;
+    }
+    int requestId = _nextRequestId++;
+    _requests.insert(requestId, requestInfo);
+    _waitForTiles(requestId, requestInfo);
+    qCDebug(TerrainQueryLog) << "TerrainTileManager::_addRequest queue count:missing tiles" << _requests.count() << requestInfo.missingTiles.count();
+}
 
-    foreach (const QueuedRequestInfo_t& requestInfo, _requestQueue) {
-        if (requestInfo.queryMode == QueryMode::QueryModeCoordinates) {
-            requestInfo.terrainQueryInterface->_signalCoordinateHeights(false, noAltitudes);
-        } else if (requestInfo.queryMode == QueryMode::QueryModePath) {
-            requestInfo.terrainQueryInterface->_signalPathHeights(false, requestInfo.latStep, requestInfo.lonStep, noAltitudes);
+/// Registers the request against each tile it is missing so it can be found when the tile arrives
+void TerrainTileManager::_waitForTiles(int requestId, const QueuedRequestInfo_t& requestInfo)
+{
+    foreach (const QString& hash, requestInfo.missingTiles) {
+        _tileRequests[hash].append(requestId);
+    }
+}
+
+/// Signals the result of the request if all of its tiles are available. Otherwise fetches the missing tiles.
+/// @return true: request answered, false: request is waiting for tiles
+bool TerrainTileManager::_answerRequest(QueuedRequestInfo_t& requestInfo)
+{
+    bool                    error;
+    QList<double>           altitudes;
+    QList<QGeoCoordinate>   missingTiles;
+
+    if (!_lookupAltitudes(requestInfo.coordinates, altitudes, error, missingTiles)) {
+        foreach (const QGeoCoordinate& coordinate, missingTiles) {
+            requestInfo.missingTiles.insert(TerrainTileStore::tileHash(coordinate));
+            _fetchTile(coordinate);
+        }
+        return false;
+    }
+
+    if (error) {
+        qCWarning(TerrainQueryLog) << "TerrainTileManager::_answerRequest signalling failure due to internal error";
+    }
+    _signalRequest(requestInfo, !error, error ? QList<double>() : altitudes);
+    return true;
+}
+
+void TerrainTileManager::_signalRequest(const QueuedRequestInfo_t& requestInfo, bool success, const QList<double>& altitudes)
+{
+    TerrainOfflineAirMapQuery* terrainQueryInterface = requestInfo.terrainQueryInterface.data();
+    if (!terrainQueryInterface) {
+        // Requester went away while waiting for tiles
+        return;
+    }
+
+    switch (requestInfo.queryMode) {
+    case QueryModeCoordinates:
+        terrainQueryInterface->_signalCoordinateHeights(success, altitudes);
+        break;
+    case QueryModePath:
+        terrainQueryInterface->_signalPathHeights(success, requestInfo.latSteps[0], requestInfo.lonSteps[0], altitudes);
+        break;
+    case QueryModePolyPath:
+    {
+        QList<TerrainPathHeightInfo_t> rgPathHeightInfo;
+        if (success) {
+            int index = 0;
+            for (int i=0; i<requestInfo.pathCounts.count(); i++) {
+                TerrainPathHeightInfo_t pathHeightInfo;
+                pathHeightInfo.latStep = requestInfo.latSteps[i];
+                pathHeightInfo.lonStep = requestInfo.lonSteps[i];
+                pathHeightInfo.heights = altitudes.mid(index, requestInfo.pathCounts[i]);
+                rgPathHeightInfo.append(pathHeightInfo);
+                index += requestInfo.pathCounts[i];
+            }
+        }
+        terrainQueryInterface->_signalPolyPathHeights(success, rgPathHeightInfo);
+        break;
+    }
+    case QueryModeCarpet:
+    {
+        double                  minHeight = qQNaN();
+        double                  maxHeight = qQNaN();
+        QList<QList<double>>    carpet;
+        if (success) {
+            for (int i=0; i<altitudes.count(); i++) {
+                if (i == 0 || altitudes[i] < minHeight) {
+                    minHeight = altitudes[i];
+                }
+                if (i == 0 || altitudes[i] > maxHeight) {
+                    maxHeight = altitudes[i];
+                }
+                if (!requestInfo.statsOnly) {
+                    if (i % requestInfo.carpetColumns == 0) {
+                        carpet.append(QList<double>());
+                    }
+                    carpet.last().append(altitudes[i]);
+                }
+            }
+        }
+        terrainQueryInterface->_signalCarpetHeights(success, minHeight, maxHeight, carpet);
+        break;
+    }
+    }
+}
+
+/// Queues a fetch of the tile holding the coordinate, unless one is already pending
+void TerrainTileManager::_fetchTile(const QGeoCoordinate& coordinate)
+{
+    QString hash = TerrainTileStore::tileHash(coordinate);
+    if (_pendingTiles.contains(hash)) {
+        qCDebug(TerrainQueryVerboseLog) << "TerrainTileManager::_fetchTile already pending" << hash;
+        return;
+    }
+    _pendingTiles.insert(hash);
+    _tileQueue.append(coordinate);
+    _startTileFetches();
+}
+
+void TerrainTileManager::_startTileFetches(void)
+{
+    while (_activeTileFetches < _maxActiveTileFetches && !_tileQueue.isEmpty()) {
+        _activeTileFetches++;
+        _requestTile(_tileQueue.takeFirst());
+    }
+}
+
+void TerrainTileManager::_requestTile(const QGeoCoordinate& coordinate)
+{
+    QNetworkRequest request = getQGCMapEngine()->urlFactory()->getTileURL(UrlFactory::AirmapElevation, QGCMapEngine::long2elevationTileX(coordinate.longitude(), 1), QGCMapEngine::lat2elevationTileY(coordinate.latitude(), 1), 1, &_networkManager);
+    qCDebug(TerrainQueryLog) << "TerrainTileManager::_requestTile query from database" << request.url();
+    QGeoTileSpec spec;
+    spec.setX(QGCMapEngine::long2elevationTileX(coordinate.longitude(), 1));
+    spec.setY(QGCMapEngine::lat2elevationTileY(coordinate.latitude(), 1));
+    spec.setZoom(1);
+    spec.setMapId(UrlFactory::AirmapElevation);
+    QGeoTiledMapReplyQGC* reply = new QGeoTiledMapReplyQGC(&_networkManager, request, spec, this);
+    connect(reply, &QGeoTiledMapReplyQGC::terrainDone, this, &TerrainTileManager::_terrainDone);
+}
+
+/// Fails all requests which are waiting for the specified tile
+void TerrainTileManager::_tileFailed(const QString& hash)
+{
+    // Ids of requests which already failed on another tile are no longer in _requests
+    foreach (int requestId, _tileRequests.take(hash)) {
+        if (_requests.contains(requestId)) {
+            _signalRequest(_requests.take(requestId), false, QList<double>());
         }
     }
-    _requestQueue.clear();
 }
 
 void TerrainTileManager::_terrainDone(QByteArray responseBytes, QNetworkReply::NetworkError error)
 {
     QGeoTiledMapReplyQGC* reply = qobject_cast<QGeoTiledMapReplyQGC*>(QObject::sender());
-    _state = State::Idle;
 
     if (!reply) {
         qCWarning(TerrainQueryLog) << "Elevation tile fetched but invalid reply data type.";
         return;
     }
+    reply->deleteLater();
 
-    // remove from download queue
     QGeoTileSpec spec = reply->tileSpec();
-    QString hash = QGCMapEngine::getTileHash(UrlFactory::AirmapElevation, spec.x(), spec.y(), spec.zoom());
+    _tileDone(QGCMapEngine::getTileHash(UrlFactory::AirmapElevation, spec.x(), spec.y(), spec.zoom()), responseBytes, error);
+}
+
+/// Stores the fetched tile and answers the requests which were waiting for it
+void TerrainTileManager::_tileDone(const QString& hash, const QByteArray& responseBytes, QNetworkReply::NetworkError error)
+{
+    // remove from download queue
+    _activeTileFetches--;
+    _pendingTiles.remove(hash);
 
     // handle potential errors
     if (error != QNetworkReply::NoError) {
         qCWarning(TerrainQueryLog) << "Elevation tile fetching returned error (" << error << ")";
-        _tileFailed();
-        reply->deleteLater();
-        return;
-    }
-    if (responseBytes.isEmpty()) {
+        _tileFailed(hash);
+    } else if (responseBytes.isEmpty()) {
         qCWarning(TerrainQueryLog) << "Error in fetching elevation tile. Empty response.";
-        _tileFailed();
-        reply->deleteLater();
-        return;
-    }
-
-    qWarning() << "Received some bytes of terrain data: " << responseBytes.size();
-
-    TerrainTile* terrainTile = new TerrainTile(responseBytes);
-    if (terrainTile->isValid()) {
-        _tilesMutex.lock();
-        if (!_tiles.contains(hash)) {
-            _tiles.insert(hash, *terrainTile);
-        } else {
-            delete terrainTile;
-        }
-        _tilesMutex.unlock();
-    } else {
+        _tileFailed(hash);
+    } else if (!TerrainTileStore::instance()->insert(hash, responseBytes)) {
         qCWarning(TerrainQueryLog) << "Received invalid tile";
-    }
-    reply->deleteLater();
-
-    // now try to query the data again
-    for (int i = _requestQueue.count() - 1; i >= 0; i--) {
-        bool error;
-        QList<double> altitudes;
-        QueuedRequestInfo_t& requestInfo = _requestQueue[i];
-
-        if (_getAltitudesForCoordinates(requestInfo.coordinates, altitudes, error)) {
-            if (requestInfo.queryMode == QueryMode::QueryModeCoordinates) {
-                if (error) {
-                    QList<double> noAltitudes;
-                    qCWarning(TerrainQueryLog) << "_terrainDone(coordinateQuery): signalling failure due to internal error";
-                    requestInfo.terrainQueryInterface->_signalCoordinateHeights(false, noAltitudes);
-                } else {
-                    qCDebug(TerrainQueryLog) << "_terrainDone(coordinateQuery): All altitudes taken from cached data";
-                    requestInfo.terrainQueryInterface->_signalCoordinateHeights(requestInfo.coordinates.count() == altitudes.count(), altitudes);
-                }
-            } else if (requestInfo.queryMode == QueryMode::QueryModePath) {
-                if (error) {
-                    QList<double> noAltitudes;
-                    qCWarning(TerrainQueryLog) << "_terrainDone(coordinateQuery): signalling failure due to internal error";
-                    requestInfo.terrainQueryInterface->_signalPathHeights(false, requestInfo.latStep, requestInfo.lonStep, noAltitudes);
-                } else {
-                    qCDebug(TerrainQueryLog) << "_terrainDone(coordinateQuery): All altitudes taken from cached data";
-                    requestInfo.terrainQueryInterface->_signalPathHeights(requestInfo.coordinates.count() == altitudes.count(), requestInfo.latStep, requestInfo.lonStep, altitudes);
-                }
+        _tileFailed(hash);
+    } else {
+        qCDebug(TerrainQueryLog) << "Received some bytes of terrain data: " << responseBytes.size();
+
+        // Answer the requests which were waiting for this tile. A request which spans several tiles
+        // stays queued until the last one arrives.
+        foreach (int requestId, _tileRequests.take(hash)) {
+            QHash<int, QueuedRequestInfo_t>::iterator it = _requests.find(requestId);
+            if (it == _requests.end() || !it.value().missingTiles.remove(hash) || !it.value().missingTiles.isEmpty()) {
+                continue;
+            }
+            QueuedRequestInfo_t requestInfo = _requests.take(requestId);
+            if (!_answerRequest(requestInfo)) {
+                // A tile was dropped from the store while waiting, it is being fetched again
+                _requests.insert(requestId, requestInfo);
+                _waitForTiles(requestId, requestInfo);
             }
-            _requestQueue.removeAt(i);
         }
     }
-}
 
-QString TerrainTileManager::_getTileHash(const QGeoCoordinate& coordinate)
-{
-    QString ret = QGCMapEngine::getTileHash(UrlFactory::AirmapElevation, QGCMapEngine::long2elevationTileX(coordinate.longitude(), 1), QGCMapEngine::lat2elevationTileY(coordinate.latitude(), 1), 1);
-    qCDebug(TerrainQueryVerboseLog) << "Computing unique tile hash for " << coordinate << ret;
-
-    return ret;
+    _startTileFetches();
 }
 
 TerrainAtCoordinateBatchManager::TerrainAtCoordinateBatchManager(void)
@@ -693,6 +837,11 @@ void TerrainAtCoordinateQuery::requestData(const QList<QGeoCoordinate>& coordina
     _TerrainAtCoordinateBatchManager->addQuery(this, coordinates);
 }
 
+bool TerrainAtCoordinateQuery::getAltitudesForCoordinates(const QList<QGeoCoordinate>& coordinates, QList<double>& altitudes, bool& error)
+{
+    return _terrainTileManager->getAltitudesForCoordinates(coordinates, altitudes, error);
+}
+
 void TerrainAtCoordinateQuery::_signalTerrainData(bool success, QList<double>& heights)
 {
     emit terrainDataReceived(success, heights);
@@ -720,10 +869,9 @@ void TerrainPathQuery::_pathHeights(bool success, double latStep, double lonStep
 }
 
 TerrainPolyPathQuery::TerrainPolyPathQuery(QObject* parent)
-    : QObject   (parent)
-    , _curIndex (0)
+    : QObject(parent)
 {
-    connect(&_pathQuery, &TerrainPathQuery::terrainDataReceived, this, &TerrainPolyPathQuery::_terrainDataReceived);
+    connect(&_terrainQuery, &TerrainQueryInterface::polyPathHeightsReceived, this, &TerrainPolyPathQuery::terrainDataReceived);
 }
 
 void TerrainPolyPathQuery::requestData(const QVariantList& polyPath)
@@ -741,31 +889,7 @@ void TerrainPolyPathQuery::requestData(const QList<QGeoCoordinate>& polyPath)
 {
     qCDebug(TerrainQueryLog) << "TerrainPolyPathQuery::requestData count" << polyPath.count();
 
-    // Kick off first request
-    _rgCoords = polyPath;
-    _curIndex = 0;
-    _pathQuery.requestData(_rgCoords[0], _rgCoords[1]);
-}
-
-void TerrainPolyPathQuery::_terrainDataReceived(bool success, const TerrainPathQuery::PathHeightInfo_t& pathHeightInfo)
-{
-    qCDebug(TerrainQueryLog) << "TerrainPolyPathQuery::_terrainDataReceived success:_curIndex" << success << _curIndex;
-
-    if (!success) {
-        _rgPathHeightInfo.clear();
-        emit terrainDataReceived(false /* success */, _rgPathHeightInfo);
-        return;
-    }
-
-    _rgPathHeightInfo.append(pathHeightInfo);
-
-    if (++_curIndex >= _rgCoords.count() - 1) {
-        // We've finished all requests
-        qCDebug(TerrainQueryLog) << "TerrainPolyPathQuery::_terrainDataReceived complete";
-        emit terrainDataReceived(true /* success */, _rgPathHeightInfo);
-    } else {
-        _pathQuery.requestData(_rgCoords[_curIndex], _rgCoords[_curIndex+1]);
-    }
+    _terrainQuery.requestPolyPathHeights(polyPath);
 }
 
 TerrainCarpetQuery::TerrainCarpetQuery(QObject* parent)
@@ -18,6 +18,9 @@
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QTimer>
+#include <QPointer>
+#include <QSet>
+#include <QHash>
 #include <QtLocation/private/qgeotiledmapreply_p.h>
 
 Q_DECLARE_LOGGING_CATEGORY(TerrainQueryLog)
@@ -25,6 +28,13 @@ Q_DECLARE_LOGGING_CATEGORY(TerrainQueryVerboseLog)
 
 class TerrainAtCoordinateQuery;
 
+/// Terrain heights along a path
+typedef struct {
+    double          latStep;    ///< Amount of latitudinal distance between each returned height
+    double          lonStep;    ///< Amount of longitudinal distance between each returned height
+    QList<double>   heights;    ///< Terrain heights along path
+} TerrainPathHeightInfo_t;
+
 /// Base class for offline/online terrain queries
 class TerrainQueryInterface : public QObject
 {
@@ -52,6 +62,7 @@ public:
 signals:
     void coordinateHeightsReceived(bool success, QList<double> heights);
     void pathHeightsReceived(bool success, double latStep, double lonStep, const QList<double>& heights);
+    void polyPathHeightsReceived(bool success, const QList<TerrainPathHeightInfo_t>& rgPathHeightInfo);
     void carpetHeightsReceived(bool success, double minHeight, double maxHeight, const QList<QList<double>>& carpet);
 };
 
@@ -102,54 +113,91 @@ public:
     void requestPathHeights(const QGeoCoordinate& fromCoord, const QGeoCoordinate& toCoord) final;
     void requestCarpetHeights(const QGeoCoordinate& swCoord, const QGeoCoordinate& neCoord, bool statsOnly) final;
 
+    /// Requests terrain heights along all the paths between the specified coordinates in a single query.
+    /// Signals: polyPathHeightsReceived
+    void requestPolyPathHeights(const QList<QGeoCoordinate>& polyPath);
+
     // Internal methods
     void _signalCoordinateHeights(bool success, QList<double> heights);
     void _signalPathHeights(bool success, double latStep, double lonStep, const QList<double>& heights);
+    void _signalPolyPathHeights(bool success, const QList<TerrainPathHeightInfo_t>& rgPathHeightInfo);
     void _signalCarpetHeights(bool success, double minHeight, double maxHeight, const QList<QList<double>>& carpet);
 };
 
-/// Used internally by TerrainOfflineAirMapQuery to manage terrain tiles
+/// Used internally by TerrainOfflineAirMapQuery to manage terrain tiles. All offline queries go through the single
+/// instance, which acts as a broker between the queries and the tiles:
+///     - Requests whose tiles are all in the TerrainTileStore are answered synchronously
+///     - Identical coordinates within a request are only looked up once
+///     - Requests waiting for the same tile share a single fetch of that tile
 class TerrainTileManager : public QObject {
     Q_OBJECT
 
 public:
     TerrainTileManager(void);
+    ~TerrainTileManager();
 
     void addCoordinateQuery (TerrainOfflineAirMapQuery* terrainQueryInterface, const QList<QGeoCoordinate>& coordinates);
     void addPathQuery       (TerrainOfflineAirMapQuery* terrainQueryInterface, const QGeoCoordinate& startPoint, const QGeoCoordinate& endPoint);
+    void addPolyPathQuery   (TerrainOfflineAirMapQuery* terrainQueryInterface, const QList<QGeoCoordinate>& polyPath);
+    void addCarpetQuery     (TerrainOfflineAirMapQuery* terrainQueryInterface, const QGeoCoordinate& swCoord, const QGeoCoordinate& neCoord, bool statsOnly);
+
+    /// Returns altitudes from the tile cache only, no tiles are fetched
+    ///     @param[out] error true: altitudes not returned due to error
+    /// @return true: all tiles were available (check error as well), false: tiles are missing
+    bool getAltitudesForCoordinates(const QList<QGeoCoordinate>& coordinates, QList<double>& altitudes, bool& error);
+
+    int pendingRequestCount (void) const { return _requests.count(); }
+    int pendingTileCount    (void) const { return _pendingTiles.count(); }
+
+protected:
+    /// Starts the download of the tile holding the coordinate. The result must be passed to _tileDone once this returns.
+    virtual void _requestTile(const QGeoCoordinate& coordinate);
+
+    void _tileDone(const QString& hash, const QByteArray& responseBytes, QNetworkReply::NetworkError error);
 
 private slots:
     void _terrainDone       (QByteArray responseBytes, QNetworkReply::NetworkError error);
 
 private:
-    enum class State {
-        Idle,
-        Downloading,
-    };
-
     enum QueryMode {
         QueryModeCoordinates,
         QueryModePath,
+        QueryModePolyPath,
         QueryModeCarpet
     };
 
     typedef struct {
-        TerrainOfflineAirMapQuery*  terrainQueryInterface;
+        QPointer<TerrainOfflineAirMapQuery> terrainQueryInterface;
         QueryMode                   queryMode;
-        double                      latStep, lonStep;
-        QList<QGeoCoordinate>       coordinates;
+        QList<QGeoCoordinate>       coordinates;    ///< Coordinates to return heights for
+        QList<double>               latSteps;       ///< Path: one entry, PolyPath: one entry per path
+        QList<double>               lonSteps;
+        QList<int>                  pathCounts;     ///< PolyPath: number of coordinates in each path
+        int                         carpetColumns;
+        bool                        statsOnly;
+        QSet<QString>               missingTiles;   ///< Hashes of tiles the request is waiting on
     } QueuedRequestInfo_t;
 
-    void    _tileFailed                         (void);
-    bool    _getAltitudesForCoordinates         (const QList<QGeoCoordinate>& coordinates, QList<double>& altitudes, bool& error);
-    QString _getTileHash                        (const QGeoCoordinate& coordinate);
-
-    QList<QueuedRequestInfo_t>  _requestQueue;
-    State                       _state = State::Idle;
+    void    _addRequest                 (QueuedRequestInfo_t& requestInfo);
+    void    _waitForTiles               (int requestId, const QueuedRequestInfo_t& requestInfo);
+    bool    _answerRequest              (QueuedRequestInfo_t& requestInfo);
+    void    _signalRequest              (const QueuedRequestInfo_t& requestInfo, bool success, const QList<double>& altitudes);
+    void    _fetchTile                  (const QGeoCoordinate& coordinate);
+    void    _startTileFetches           (void);
+    void    _tileFailed                 (const QString& hash);
+    bool    _lookupAltitudes            (const QList<QGeoCoordinate>& coordinates, QList<double>& altitudes, bool& error, QList<QGeoCoordinate>& missingTiles);
+
+    static QList<QGeoCoordinate> _pathCoordinates(const QGeoCoordinate& startPoint, const QGeoCoordinate& endPoint, double& latStep, double& lonStep);
+
+    QHash<int, QueuedRequestInfo_t> _requests;      ///< Requests waiting for tiles, keyed by request id
+    QHash<QString, QList<int>>  _tileRequests;      ///< Ids of the requests waiting on each tile, keyed by tile hash
+    int                         _nextRequestId = 0;
+    QSet<QString>               _pendingTiles;      ///< Tiles queued or being fetched
+    QList<QGeoCoordinate>       _tileQueue;         ///< One coordinate within each tile waiting to be fetched
+    int                         _activeTileFetches = 0;
     QNetworkAccessManager       _networkManager;
 
-    QMutex                      _tilesMutex;
-    QHash<QString, TerrainTile> _tiles;
+    static const int            _maxActiveTileFetches = 4;
 };
 
 /// Used internally by TerrainAtCoordinateQuery to batch coordinate requests together
@@ -207,6 +255,12 @@ public:
     ///     @param coordinates to query
     void requestData(const QList<QGeoCoordinate>& coordinates);
 
+    /// Synchronous terrain query which only uses tiles which are already cached. No request is queued.
+    ///     @param[out] altitudes Terrain height for each coordinate
+    ///     @param[out] error true: altitudes not returned due to error
+    /// @return true: all tiles were cached (check error as well), false: use requestData instead
+    static bool getAltitudesForCoordinates(const QList<QGeoCoordinate>& coordinates, QList<double>& altitudes, bool& error);
+
     // Internal method
     void _signalTerrainData(bool success, QList<double>& heights);
 
@@ -226,11 +280,7 @@ public:
     ///     @param coordinates to query
     void requestData(const QGeoCoordinate& fromCoord, const QGeoCoordinate& toCoord);
 
-    typedef struct {
-        double          latStep;    ///< Amount of latitudinal distance between each returned height
-        double          lonStep;    ///< Amount of longitudinal distance between each returned height
-        QList<double>   heights;    ///< Terrain heights along path
-    } PathHeightInfo_t;
+    typedef TerrainPathHeightInfo_t PathHeightInfo_t;
 
 signals:
     /// Signalled when terrain data comes back from server
@@ -253,7 +303,8 @@ public:
     TerrainPolyPathQuery(QObject* parent = NULL);
 
     /// Async terrain query for terrain heights for the paths between each specified QGeoCoordinate.
-    /// When the query is done, the terrainData() signal is emitted.
+    /// When the query is done, the terrainData() signal is emitted. All paths are queried together so
+    /// they share the tiles they have in common.
     ///     @param polyPath List of QGeoCoordinate
     void requestData(const QVariantList& polyPath);
     void requestData(const QList<QGeoCoordinate>& polyPath);
@@ -262,14 +313,8 @@ signals:
     /// Signalled when terrain data comes back from server
     void terrainDataReceived(bool success, const QList<TerrainPathQuery::PathHeightInfo_t>& rgPathHeightInfo);
 
-private slots:
-    void _terrainDataReceived(bool success, const TerrainPathQuery::PathHeightInfo_t& pathHeightInfo);
-
 private:
-    int                                         _curIndex;
-    QList<QGeoCoordinate>                       _rgCoords;
-    QList<TerrainPathQuery::PathHeightInfo_t>   _rgPathHeightInfo;
-    TerrainPathQuery                            _pathQuery;
+    TerrainOfflineAirMapQuery _terrainQuery;
 };
 
 
@@ -292,6 +337,6 @@ signals:
     void terrainDataReceived(bool success, double minHeight, double maxHeight, const QList<QList<double>>& carpet);
 
 private:
-    TerrainAirMapQuery _terrainQuery;
+    TerrainOfflineAirMapQuery _terrainQuery;
 };
 
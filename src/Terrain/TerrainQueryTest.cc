@@ -0,0 +1,264 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TerrainQueryTest.h"
+#include "TerrainTileStore.h"
+#include "TerrainTileStoreTest.h"
+
+void TestTerrainTileManager::_requestTile(const QGeoCoordinate& coordinate)
+{
+    requestedTiles.append(TerrainTileStore::tileHash(coordinate));
+}
+
+void TerrainQueryTest::init(void)
+{
+    UnitTest::init();
+
+    // Run against an empty tile store, with a single tile available
+    _tempDir = new QTemporaryDir();
+    _savedCacheDirectory = TerrainTileStore::instance()->cacheDirectory();
+    TerrainTileStore::instance()->clear();
+    TerrainTileStore::instance()->setCacheDirectory(_tempDir->path());
+
+    QGeoCoordinate southWest(47.0, 8.0);
+    QVERIFY(TerrainTileStore::instance()->insert(TerrainTileStore::tileHash(QGeoCoordinate(47.005, 8.005)), TerrainTileStoreTest::createTile(southWest, 0.01)));
+}
+
+void TerrainQueryTest::cleanup(void)
+{
+    TerrainTileStore::instance()->clear();
+    TerrainTileStore::instance()->setCacheDirectory(_savedCacheDirectory);
+    delete _tempDir;
+    _tempDir = NULL;
+
+    UnitTest::cleanup();
+}
+
+void TerrainQueryTest::_polyPath_test(void)
+{
+    TerrainTileManager              manager;
+    TerrainOfflineAirMapQuery       query;
+    bool                            signalled = false;
+    bool                            success = false;
+    QList<TerrainPathHeightInfo_t>  rgPathHeightInfo;
+
+    connect(&query, &TerrainQueryInterface::polyPathHeightsReceived, [&](bool querySuccess, const QList<TerrainPathHeightInfo_t>& queryPathHeightInfo) {
+        signalled = true;
+        success = querySuccess;
+        rgPathHeightInfo = queryPathHeightInfo;
+    });
+
+    QList<QGeoCoordinate> polyPath;
+    polyPath << QGeoCoordinate(47.001, 8.001) << QGeoCoordinate(47.009, 8.001) << QGeoCoordinate(47.009, 8.009);
+    manager.addPolyPathQuery(&query, polyPath);
+
+    // All tiles are cached so the answer comes back synchronously
+    QVERIFY(signalled);
+    QVERIFY(success);
+    QCOMPARE(manager.pendingRequestCount(), 0);
+    QCOMPARE(rgPathHeightInfo.count(), 2);
+
+    TerrainTileStore::TilePtr tile = TerrainTileStore::instance()->tile(TerrainTileStore::tileHash(polyPath[0]));
+    QVERIFY(tile);
+    for (int i=0; i<rgPathHeightInfo.count(); i++) {
+        const QList<double>& heights = rgPathHeightInfo[i].heights;
+        QVERIFY(heights.count() > 2);
+        QCOMPARE(heights.first(), tile->elevation(polyPath[i]));
+        QCOMPARE(heights.last(), tile->elevation(polyPath[i+1]));
+    }
+    QVERIFY(qAbs(rgPathHeightInfo[0].lonStep) < 1e-9);
+    QVERIFY(rgPathHeightInfo[0].latStep > 0);
+}
+
+void TerrainQueryTest::_carpet_test(void)
+{
+    TerrainTileManager          manager;
+    TerrainOfflineAirMapQuery   query;
+    int                         signalCount = 0;
+    double                      minHeight = qQNaN();
+    double                      maxHeight = qQNaN();
+    QList<QList<double>>        carpet;
+
+    connect(&query, &TerrainQueryInterface::carpetHeightsReceived, [&](bool success, double queryMinHeight, double queryMaxHeight, const QList<QList<double>>& queryCarpet) {
+        QVERIFY(success);
+        signalCount++;
+        minHeight = queryMinHeight;
+        maxHeight = queryMaxHeight;
+        carpet = queryCarpet;
+    });
+
+    manager.addCarpetQuery(&query, QGeoCoordinate(47.002, 8.002), QGeoCoordinate(47.008, 8.008), false /* statsOnly */);
+    QCOMPARE(signalCount, 1);
+    QVERIFY(carpet.count() > 1);
+    int columns = carpet[0].count();
+    QVERIFY(columns > 1);
+    double carpetMin = carpet[0][0];
+    double carpetMax = carpet[0][0];
+    foreach (const QList<double>& row, carpet) {
+        QCOMPARE(row.count(), columns);
+        foreach (double height, row) {
+            carpetMin = qMin(carpetMin, height);
+            carpetMax = qMax(carpetMax, height);
+        }
+    }
+    QCOMPARE(minHeight, carpetMin);
+    QCOMPARE(maxHeight, carpetMax);
+    QVERIFY(carpet.first().first() < carpet.last().last());
+
+    manager.addCarpetQuery(&query, QGeoCoordinate(47.002, 8.002), QGeoCoordinate(47.008, 8.008), true /* statsOnly */);
+    QCOMPARE(signalCount, 2);
+    QVERIFY(carpet.isEmpty());
+    QCOMPARE(minHeight, carpetMin);
+    QCOMPARE(maxHeight, carpetMax);
+}
+
+void TerrainQueryTest::_dedupe_test(void)
+{
+    TestTerrainTileManager      manager;
+    TerrainOfflineAirMapQuery*  query1 = new TerrainOfflineAirMapQuery();
+    TerrainOfflineAirMapQuery*  query2 = new TerrainOfflineAirMapQuery();
+    TerrainOfflineAirMapQuery   query3;
+    bool                        query1Signalled = false;
+    int                         query3SignalCount = 0;
+    bool                        query3Success = false;
+    QList<double>               query3Heights;
+
+    connect(query1, &TerrainQueryInterface::coordinateHeightsReceived, [&](bool, QList<double>) {
+        query1Signalled = true;
+    });
+    connect(&query3, &TerrainQueryInterface::pathHeightsReceived, [&](bool success, double, double, const QList<double>& heights) {
+        query3SignalCount++;
+        query3Success = success;
+        query3Heights = heights;
+    });
+
+    // All requests need the same uncached tile, which must only be fetched once
+    QGeoCoordinate missingCoordinate(47.025, 8.025);
+    QString missingHash = TerrainTileStore::tileHash(missingCoordinate);
+    QList<QGeoCoordinate> coordinates;
+    coordinates << missingCoordinate << missingCoordinate << QGeoCoordinate(47.005, 8.005);
+    manager.addCoordinateQuery(query1, coordinates);
+    manager.addPathQuery(query2, QGeoCoordinate(47.021, 8.021), QGeoCoordinate(47.029, 8.029));
+    manager.addPathQuery(&query3, QGeoCoordinate(47.021, 8.021), QGeoCoordinate(47.029, 8.029));
+    QCOMPARE(manager.pendingRequestCount(), 3);
+    QCOMPARE(manager.pendingTileCount(), 1);
+    QCOMPARE(manager.requestedTiles, QStringList() << missingHash);
+
+    // Requesters going away while waiting must not be signalled
+    delete query1;
+    delete query2;
+
+    // Cached tiles are still answered synchronously while others are pending
+    bool            error;
+    QList<double>   altitudes;
+    QVERIFY(manager.getAltitudesForCoordinates(QList<QGeoCoordinate>() << QGeoCoordinate(47.005, 8.005), altitudes, error));
+    QVERIFY(!error);
+    QCOMPARE(altitudes.count(), 1);
+    QVERIFY(!manager.getAltitudesForCoordinates(coordinates, altitudes, error));
+    QCOMPARE(query3SignalCount, 0);
+
+    // Tile arrives: all waiting requests are answered, only the live one is signalled
+    manager.deliverTile(missingHash, TerrainTileStoreTest::createTile(QGeoCoordinate(47.02, 8.02), 0.01));
+    QCOMPARE(manager.pendingRequestCount(), 0);
+    QCOMPARE(manager.pendingTileCount(), 0);
+    QVERIFY(!query1Signalled);
+    QCOMPARE(query3SignalCount, 1);
+    QVERIFY(query3Success);
+    QVERIFY(query3Heights.count() > 2);
+    QVERIFY(manager.getAltitudesForCoordinates(coordinates, altitudes, error));
+    QVERIFY(!error);
+    QCOMPARE(altitudes.count(), coordinates.count());
+    QCOMPARE(altitudes[0], altitudes[1]);
+    QCOMPARE(manager.requestedTiles.count(), 1);
+}
+
+void TerrainQueryTest::_tileFailed_test(void)
+{
+    TestTerrainTileManager      manager;
+    TerrainOfflineAirMapQuery   query;
+    int                         signalCount = 0;
+    bool                        success = true;
+
+    connect(&query, &TerrainQueryInterface::coordinateHeightsReceived, [&](bool querySuccess, QList<double>) {
+        signalCount++;
+        success = querySuccess;
+    });
+
+    QGeoCoordinate missingCoordinate(47.025, 8.025);
+    QString missingHash = TerrainTileStore::tileHash(missingCoordinate);
+    manager.addCoordinateQuery(&query, QList<QGeoCoordinate>() << missingCoordinate);
+    QCOMPARE(manager.requestedTiles.count(), 1);
+
+    manager.deliverTile(missingHash, QByteArray(), QNetworkReply::TimeoutError);
+    QCOMPARE(signalCount, 1);
+    QVERIFY(!success);
+    QCOMPARE(manager.pendingRequestCount(), 0);
+    QCOMPARE(manager.pendingTileCount(), 0);
+
+    // A failed tile is fetched again by the next request which needs it
+    manager.addCoordinateQuery(&query, QList<QGeoCoordinate>() << missingCoordinate);
+    QCOMPARE(manager.requestedTiles, QStringList() << missingHash << missingHash);
+    manager.deliverTile(missingHash, QByteArray());
+    QCOMPARE(signalCount, 2);
+    QVERIFY(!success);
+}
+
+void TerrainQueryTest::_multipleTiles_test(void)
+{
+    TestTerrainTileManager      manager;
+    TerrainOfflineAirMapQuery   query1;
+    TerrainOfflineAirMapQuery   query2;
+    int                         query1SignalCount = 0;
+    int                         query2SignalCount = 0;
+    bool                        query1Success = false;
+
+    connect(&query1, &TerrainQueryInterface::coordinateHeightsReceived, [&](bool success, QList<double>) {
+        query1SignalCount++;
+        query1Success = success;
+    });
+    connect(&query2, &TerrainQueryInterface::coordinateHeightsReceived, [&](bool, QList<double>) {
+        query2SignalCount++;
+    });
+
+    // query1 spans two missing tiles, query2 only needs the second one
+    QGeoCoordinate coordinate1(47.025, 8.025);
+    QGeoCoordinate coordinate2(47.035, 8.025);
+    QString hash1 = TerrainTileStore::tileHash(coordinate1);
+    QString hash2 = TerrainTileStore::tileHash(coordinate2);
+    QVERIFY(hash1 != hash2);
+    manager.addCoordinateQuery(&query1, QList<QGeoCoordinate>() << coordinate1 << coordinate2);
+    manager.addCoordinateQuery(&query2, QList<QGeoCoordinate>() << coordinate2);
+    QCOMPARE(manager.pendingRequestCount(), 2);
+    QCOMPARE(manager.pendingTileCount(), 2);
+
+    // A request stays queued until its last tile arrives
+    manager.deliverTile(hash2, TerrainTileStoreTest::createTile(QGeoCoordinate(47.03, 8.02), 0.01));
+    QCOMPARE(query1SignalCount, 0);
+    QCOMPARE(query2SignalCount, 1);
+    QCOMPARE(manager.pendingRequestCount(), 1);
+
+    manager.deliverTile(hash1, TerrainTileStoreTest::createTile(QGeoCoordinate(47.02, 8.02), 0.01));
+    QCOMPARE(query1SignalCount, 1);
+    QVERIFY(query1Success);
+    QCOMPARE(query2SignalCount, 1);
+    QCOMPARE(manager.pendingRequestCount(), 0);
+    QCOMPARE(manager.pendingTileCount(), 0);
+
+    // Failure of one tile fails the request once, the other tile arriving later does not signal again
+    QGeoCoordinate coordinate3(47.045, 8.025);
+    QGeoCoordinate coordinate4(47.055, 8.025);
+    manager.addCoordinateQuery(&query1, QList<QGeoCoordinate>() << coordinate3 << coordinate4);
+    QCOMPARE(manager.pendingTileCount(), 2);
+    manager.deliverTile(TerrainTileStore::tileHash(coordinate3), QByteArray(), QNetworkReply::TimeoutError);
+    QCOMPARE(query1SignalCount, 2);
+    QVERIFY(!query1Success);
+    manager.deliverTile(TerrainTileStore::tileHash(coordinate4), TerrainTileStoreTest::createTile(QGeoCoordinate(47.05, 8.02), 0.01));
+    QCOMPARE(query1SignalCount, 2);
+    QCOMPARE(manager.pendingRequestCount(), 0);
+}
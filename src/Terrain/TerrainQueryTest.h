@@ -0,0 +1,50 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+#include "TerrainQuery.h"
+
+#include <QTemporaryDir>
+
+/// Tile manager which records tile fetches instead of going to the network. Tests deliver the results.
+class TestTerrainTileManager : public TerrainTileManager
+{
+    Q_OBJECT
+
+public:
+    void deliverTile(const QString& hash, const QByteArray& responseBytes, QNetworkReply::NetworkError error = QNetworkReply::NoError) { _tileDone(hash, responseBytes, error); }
+
+    QStringList requestedTiles; ///< Hashes of the tiles which were fetched, in order
+
+protected:
+    void _requestTile(const QGeoCoordinate& coordinate) final;
+};
+
+/// Unit test for the offline terrain query broker (TerrainTileManager)
+class TerrainQueryTest : public UnitTest
+{
+    Q_OBJECT
+
+protected slots:
+    void init(void);
+    void cleanup(void);
+
+private slots:
+    void _polyPath_test     (void);
+    void _carpet_test       (void);
+    void _dedupe_test       (void);
+    void _tileFailed_test   (void);
+    void _multipleTiles_test(void);
+
+private:
+    QTemporaryDir*  _tempDir;
+    QString         _savedCacheDirectory;
+};
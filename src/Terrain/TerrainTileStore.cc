@@ -0,0 +1,403 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TerrainTileStore.h"
+#include "QGCMapEngine.h"
+#include "QGCLoggingCategory.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QVector>
+
+QGC_LOGGING_CATEGORY(TerrainTileStoreLog, "TerrainTileStoreLog")
+
+Q_GLOBAL_STATIC(TerrainTileStore, _terrainTileStore)
+
+const char* TerrainTileStore::_fileExtension = ".qgcterrain";
+
+TerrainTileStore::TerrainTileStore(void)
+    : _head         (NULL)
+    , _tail         (NULL)
+    , _maxTiles     (defaultMaxTiles)
+    , _diskScanned  (false)
+    , _diskBytes    (0)
+    , _maxDiskBytes (defaultMaxDiskBytes)
+{
+
+}
+
+TerrainTileStore::~TerrainTileStore()
+{
+    _clearMemory();
+}
+
+TerrainTileStore* TerrainTileStore::instance(void)
+{
+    return _terrainTileStore();
+}
+
+QString TerrainTileStore::tileHash(const QGeoCoordinate& coordinate)
+{
+    return QGCMapEngine::getTileHash(UrlFactory::AirmapElevation, QGCMapEngine::long2elevationTileX(coordinate.longitude(), 1), QGCMapEngine::lat2elevationTileY(coordinate.latitude(), 1), 1);
+}
+
+QString TerrainTileStore::cacheDirectory(void)
+{
+    QMutexLocker lock(&_mutex);
+    return _cacheDirectory();
+}
+
+/// Must be called with _mutex held
+QString TerrainTileStore::_cacheDirectory(void)
+{
+    if (_cacheDirectoryPath.isEmpty() && !getQGCMapEngine()->getCachePath().isEmpty()) {
+        _cacheDirectoryPath = getQGCMapEngine()->getCachePath() + QStringLiteral("/TerrainTiles");
+        QDir().mkpath(_cacheDirectoryPath);
+    }
+    return _cacheDirectoryPath;
+}
+
+void TerrainTileStore::setCacheDirectory(const QString& directory)
+{
+    QDir().mkpath(directory);
+
+    QMutexLocker lock(&_mutex);
+    _cacheDirectoryPath = directory;
+    _clearMemory();
+    _diskScanned = false;
+    _diskTileBytes.clear();
+    _diskTileOrder.clear();
+    _diskBytes = 0;
+}
+
+QString TerrainTileStore::_fileName(const QString& hash)
+{
+    QString directory = cacheDirectory();
+    return directory.isEmpty() ? QString() : directory + QStringLiteral("/") + hash + _fileExtension;
+}
+
+int TerrainTileStore::count(void)
+{
+    QMutexLocker lock(&_mutex);
+    return _tiles.count();
+}
+
+void TerrainTileStore::setMaxTiles(int maxTiles)
+{
+    QMutexLocker lock(&_mutex);
+    _maxTiles = qMax(1, maxTiles);
+    _evict();
+}
+
+qint64 TerrainTileStore::diskBytes(void)
+{
+    QMutexLocker lock(&_mutex);
+    _scanDisk();
+    return _diskBytes;
+}
+
+void TerrainTileStore::setMaxDiskBytes(qint64 maxDiskBytes)
+{
+    QMutexLocker lock(&_mutex);
+    _maxDiskBytes = maxDiskBytes;
+    _scanDisk();
+    _trimDisk();
+}
+
+void TerrainTileStore::clear(void)
+{
+    QMutexLocker lock(&_mutex);
+    _clearMemory();
+}
+
+void TerrainTileStore::remove(const QStringList& hashes)
+{
+    QMutexLocker lock(&_mutex);
+    _scanDisk();
+    foreach (const QString& hash, hashes) {
+        _removeTile(hash);
+    }
+}
+
+void TerrainTileStore::removeAll(void)
+{
+    QMutexLocker lock(&_mutex);
+
+    _clearMemory();
+    QString directory = _cacheDirectory();
+    if (!directory.isEmpty()) {
+        // Go by what is on disk, not by what we have counted, so files left behind by earlier runs go as well
+        QDir dir(directory);
+        foreach (const QString& fileName, dir.entryList(QStringList(QStringLiteral("*") + _fileExtension), QDir::Files)) {
+            dir.remove(fileName);
+        }
+    }
+    _diskTileBytes.clear();
+    _diskTileOrder.clear();
+    _diskBytes = 0;
+    _diskScanned = true;
+}
+
+/// Looks for the tile in memory only
+TerrainTileStore::TilePtr TerrainTileStore::_findTile(const QString& hash)
+{
+    QMutexLocker lock(&_mutex);
+
+    Entry* entry = _tiles.value(hash, NULL);
+    if (!entry) {
+        return TilePtr();
+    }
+    if (entry != _head) {
+        _unlink(entry);
+        _pushFront(entry);
+    }
+    return entry->tile;
+}
+
+void TerrainTileStore::_addTile(const QString& hash, TilePtr tile)
+{
+    QMutexLocker lock(&_mutex);
+
+    Entry* entry = _tiles.value(hash, NULL);
+    if (entry) {
+        _unlink(entry);
+    } else {
+        entry = new Entry;
+        entry->hash = hash;
+        _tiles.insert(hash, entry);
+    }
+    entry->tile = tile;
+    _pushFront(entry);
+    _evict();
+}
+
+/// Accounts for a tile file which was just written and deletes the oldest files if the cache is over its size
+void TerrainTileStore::_addDiskTile(const QString& hash, qint64 bytes)
+{
+    QMutexLocker lock(&_mutex);
+
+    _scanDisk();
+    if (_diskTileBytes.contains(hash)) {
+        // Rewritten tile keeps its place
+        _diskBytes -= _diskTileBytes[hash];
+    } else {
+        _diskTileOrder.enqueue(hash);
+    }
+    _diskTileBytes[hash] = bytes;
+    _diskBytes += bytes;
+    _trimDisk();
+}
+
+/// Counts the tile files already in the cache directory, once per directory. Must be called with _mutex held.
+void TerrainTileStore::_scanDisk(void)
+{
+    if (_diskScanned) {
+        return;
+    }
+    QString directory = _cacheDirectory();
+    if (directory.isEmpty()) {
+        return;
+    }
+    _diskScanned = true;
+
+    QFileInfoList fileInfos = QDir(directory).entryInfoList(QStringList(QStringLiteral("*") + _fileExtension), QDir::Files, QDir::Time | QDir::Reversed);
+    int extensionLength = static_cast<int>(qstrlen(_fileExtension));
+    foreach (const QFileInfo& fileInfo, fileInfos) {
+        QString hash = fileInfo.fileName();
+        hash.chop(extensionLength);
+        if (!_diskTileBytes.contains(hash)) {
+            _diskTileOrder.enqueue(hash);
+            _diskTileBytes[hash] = fileInfo.size();
+            _diskBytes += fileInfo.size();
+        }
+    }
+    qCDebug(TerrainTileStoreLog) << "Scanned tile files:bytes" << _diskTileBytes.count() << _diskBytes;
+}
+
+/// Deletes the oldest tile files until the cache is within its size. The newest file is always kept. Must be called
+/// with _mutex held.
+void TerrainTileStore::_trimDisk(void)
+{
+    while (_diskBytes > _maxDiskBytes && _diskTileBytes.count() > 1 && !_diskTileOrder.isEmpty()) {
+        QString hash = _diskTileOrder.dequeue();
+        if (_diskTileBytes.contains(hash)) {
+            qCDebug(TerrainTileStoreLog) << "Deleting tile file" << hash;
+            _removeTile(hash);
+        }
+    }
+}
+
+/// Removes a tile from memory and disk. Anyone still holding the tile can keep using it. Must be called with _mutex held.
+void TerrainTileStore::_removeTile(const QString& hash)
+{
+    Entry* entry = _tiles.take(hash);
+    if (entry) {
+        _unlink(entry);
+        delete entry;
+    }
+
+    if (_diskTileBytes.contains(hash)) {
+        _diskBytes -= _diskTileBytes.take(hash);
+    }
+    QString directory = _cacheDirectory();
+    if (!directory.isEmpty()) {
+        QFile::remove(directory + QStringLiteral("/") + hash + _fileExtension);
+    }
+}
+
+void TerrainTileStore::_unlink(Entry* entry)
+{
+    if (entry->prev) {
+        entry->prev->next = entry->next;
+    } else {
+        _head = entry->next;
+    }
+    if (entry->next) {
+        entry->next->prev = entry->prev;
+    } else {
+        _tail = entry->prev;
+    }
+    entry->prev = NULL;
+    entry->next = NULL;
+}
+
+void TerrainTileStore::_pushFront(Entry* entry)
+{
+    entry->prev = NULL;
+    entry->next = _head;
+    if (_head) {
+        _head->prev = entry;
+    }
+    _head = entry;
+    if (!_tail) {
+        _tail = entry;
+    }
+}
+
+/// Drops least recently used tiles from memory until within _maxTiles. Evicted tiles stay valid for anyone still
+/// holding them. Must be called with _mutex held.
+void TerrainTileStore::_evict(void)
+{
+    while (_tiles.count() > _maxTiles && _tail) {
+        Entry* entry = _tail;
+        qCDebug(TerrainTileStoreLog) << "Evicting" << entry->hash;
+        _unlink(entry);
+        _tiles.remove(entry->hash);
+        delete entry;
+    }
+}
+
+/// Must be called with _mutex held
+void TerrainTileStore::_clearMemory(void)
+{
+    qDeleteAll(_tiles);
+    _tiles.clear();
+    _head = NULL;
+    _tail = NULL;
+}
+
+TerrainTileStore::TilePtr TerrainTileStore::tile(const QString& hash)
+{
+    TilePtr tile = _findTile(hash);
+    if (tile) {
+        return tile;
+    }
+
+    // Not in memory, map it from disk. This happens outside the lock, at worst two threads map the same file.
+    QString fileName = _fileName(hash);
+    if (fileName.isEmpty() || !QFile::exists(fileName)) {
+        return TilePtr();
+    }
+    QSharedPointer<TerrainTile> mappedTile(new TerrainTile());
+    if (!mappedTile->mapFile(fileName)) {
+        qCWarning(TerrainTileStoreLog) << "Removing bad terrain tile file" << fileName;
+        QFile::remove(fileName);
+        return TilePtr();
+    }
+    qCDebug(TerrainTileStoreLog) << "Mapped" << fileName;
+    _addTile(hash, mappedTile);
+    return mappedTile;
+}
+
+TerrainTileStore::TilePtr TerrainTileStore::insert(const QString& hash, const QByteArray& serializedTile)
+{
+    // Parsing first also converts tiles from caches written by earlier versions
+    QSharedPointer<TerrainTile> newTile(new TerrainTile(serializedTile));
+    if (!newTile->isValid()) {
+        return TilePtr();
+    }
+
+    // Switch the tile over to the mapped file. If there's no disk cache the tile stays on the heap.
+    QString fileName = _fileName(hash);
+    if (!fileName.isEmpty()) {
+        QByteArray bytes = newTile->serializedData();
+        QSaveFile file(fileName);
+        if (file.open(QIODevice::WriteOnly) && file.write(bytes) == bytes.size() && file.commit()) {
+            _addDiskTile(hash, bytes.size());
+            QSharedPointer<TerrainTile> mappedTile(new TerrainTile());
+            if (mappedTile->mapFile(fileName)) {
+                newTile = mappedTile;
+            }
+        } else {
+            qCWarning(TerrainTileStoreLog) << "Unable to write terrain tile file" << fileName << file.errorString();
+        }
+    }
+
+    _addTile(hash, newTile);
+    return newTile;
+}
+
+bool TerrainTileStore::elevations(const QList<QGeoCoordinate>& coordinates, QList<double>& elevations, QList<QGeoCoordinate>& missingTiles)
+{
+    // Group the coordinates by tile so each tile is looked up once and then sampled in one pass
+    QHash<quint64, QVector<int>> tileIndices;
+    for (int i = 0; i < coordinates.count(); i++) {
+        quint64 x = static_cast<quint32>(QGCMapEngine::long2elevationTileX(coordinates[i].longitude(), 1));
+        quint64 y = static_cast<quint32>(QGCMapEngine::lat2elevationTileY(coordinates[i].latitude(), 1));
+        tileIndices[(x << 32) | y].append(i);
+    }
+
+    QVector<double> results(coordinates.count());
+    QVector<double> latitudes;
+    QVector<double> longitudes;
+    QVector<double> tileElevations;
+
+    missingTiles.clear();
+    for (QHash<quint64, QVector<int>>::const_iterator it = tileIndices.constBegin(); it != tileIndices.constEnd(); ++it) {
+        const QVector<int>& indices = it.value();
+        TilePtr terrainTile = tile(tileHash(coordinates[indices[0]]));
+        if (!terrainTile) {
+            missingTiles.append(coordinates[indices[0]]);
+            continue;
+        }
+        if (!missingTiles.isEmpty()) {
+            // Results will be thrown away, just find the missing tiles
+            continue;
+        }
+
+        latitudes.resize(indices.count());
+        longitudes.resize(indices.count());
+        tileElevations.resize(indices.count());
+        for (int i = 0; i < indices.count(); i++) {
+            latitudes[i] = coordinates[indices[i]].latitude();
+            longitudes[i] = coordinates[indices[i]].longitude();
+        }
+        terrainTile->elevations(latitudes.constData(), longitudes.constData(), indices.count(), tileElevations.data());
+        for (int i = 0; i < indices.count(); i++) {
+            results[indices[i]] = tileElevations[i];
+        }
+    }
+
+    if (!missingTiles.isEmpty()) {
+        return false;
+    }
+    elevations = results.toList();
+    return true;
+}
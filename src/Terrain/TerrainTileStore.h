@@ -0,0 +1,114 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "TerrainTile.h"
+
+#include <QHash>
+#include <QQueue>
+#include <QStringList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(TerrainTileStoreLog)
+
+/// Holds the terrain tiles used by terrain queries. Tiles are kept as flat files in a cache directory which
+/// are memory mapped on use, so a tile costs no heap memory for its elevation data and the OS page cache
+/// decides what stays resident. The number of mapped tiles is bounded, least recently used tiles are dropped
+/// first. The tile files are bounded by total size, the oldest files are deleted first.
+///
+/// The store is thread safe. The mutex only protects the tile lookup: tiles are handed out as shared
+/// pointers, elevations are sampled without holding it. Batch lookups take it once per tile, not once per
+/// coordinate.
+class TerrainTileStore
+{
+public:
+    typedef QSharedPointer<const TerrainTile> TilePtr;
+
+    TerrainTileStore(void);
+    ~TerrainTileStore();
+
+    static TerrainTileStore* instance(void);
+
+    /// @return Tile for the specified hash, NULL if it is neither in memory nor on disk
+    TilePtr tile(const QString& hash);
+
+    /// Adds a tile to the store and writes it to the cache directory
+    ///     @param serializedTile Tile data as returned by TerrainTile::serialize
+    /// @return The added tile, NULL if the data is not a valid tile
+    TilePtr insert(const QString& hash, const QByteArray& serializedTile);
+
+    /// Looks up the elevations for a list of coordinates
+    ///     @param[out] elevations Elevation for each coordinate, only valid if true is returned
+    ///     @param[out] missingTiles One coordinate within each tile which is needed but not available
+    /// @return false: Tiles are missing
+    bool elevations(const QList<QGeoCoordinate>& coordinates, QList<double>& elevations, QList<QGeoCoordinate>& missingTiles);
+
+    /// Drops all tiles held in memory. Tiles on disk are kept.
+    void clear(void);
+
+    /// Removes the specified tiles from memory and disk
+    void remove(const QStringList& hashes);
+
+    /// Removes all tiles from memory and disk
+    void removeAll(void);
+
+    int     count           (void);
+    int     maxTiles        (void) const { return _maxTiles; }
+    void    setMaxTiles     (int maxTiles);
+    qint64  diskBytes       (void);
+    qint64  maxDiskBytes    (void) const { return _maxDiskBytes; }
+    void    setMaxDiskBytes (qint64 maxDiskBytes);
+    QString cacheDirectory  (void);
+    void    setCacheDirectory(const QString& directory);
+
+    /// @return Hash of the elevation tile which holds the specified coordinate
+    static QString tileHash(const QGeoCoordinate& coordinate);
+
+    static const int    defaultMaxTiles     = 1024;
+    static const qint64 defaultMaxDiskBytes = 512ll * 1024 * 1024;
+
+private:
+    struct Entry {
+        QString hash;
+        TilePtr tile;
+        Entry*  prev;
+        Entry*  next;
+    };
+
+    TilePtr _findTile       (const QString& hash);
+    void    _addTile        (const QString& hash, TilePtr tile);
+    void    _addDiskTile    (const QString& hash, qint64 bytes);
+    QString _fileName       (const QString& hash);
+    QString _cacheDirectory (void);
+    void    _scanDisk       (void);
+    void    _trimDisk       (void);
+    void    _removeTile     (const QString& hash);
+    void    _unlink         (Entry* entry);
+    void    _pushFront      (Entry* entry);
+    void    _evict          (void);
+    void    _clearMemory    (void);
+
+    QMutex                  _mutex;         ///< Protects all members below
+    QHash<QString, Entry*>  _tiles;
+    Entry*                  _head;          ///< Most recently used
+    Entry*                  _tail;          ///< Least recently used
+    int                     _maxTiles;
+    QString                 _cacheDirectoryPath;
+
+    bool                    _diskScanned;   ///< true: Tile files in the cache directory have been counted
+    QHash<QString, qint64>  _diskTileBytes; ///< Size of each tile file
+    QQueue<QString>         _diskTileOrder; ///< Tile files oldest first, may hold hashes which were removed since
+    qint64                  _diskBytes;
+    qint64                  _maxDiskBytes;
+
+    static const char*      _fileExtension;
+};
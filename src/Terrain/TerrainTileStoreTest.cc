@@ -0,0 +1,212 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TerrainTileStoreTest.h"
+#include "TerrainTileStore.h"
+
+#include <QDir>
+#include <QTemporaryDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+QByteArray TerrainTileStoreTest::createTile(const QGeoCoordinate& southWest, double size)
+{
+    QJsonArray carpet;
+    for (int row=0; row<3; row++) {
+        QJsonArray rowArray;
+        for (int col=0; col<3; col++) {
+            rowArray.append(10 * row + col);
+        }
+        carpet.append(rowArray);
+    }
+
+    QJsonObject bounds;
+    bounds["sw"] = QJsonArray({ southWest.latitude(), southWest.longitude() });
+    bounds["ne"] = QJsonArray({ southWest.latitude() + size, southWest.longitude() + size });
+
+    QJsonObject stats;
+    stats["min"] = 0;
+    stats["max"] = 22;
+    stats["avg"] = 11;
+
+    QJsonObject data;
+    data["bounds"] = bounds;
+    data["stats"] = stats;
+    data["carpet"] = carpet;
+
+    QJsonObject root;
+    root["status"] = "success";
+    root["data"] = data;
+
+    return TerrainTile::serialize(QJsonDocument(root).toJson());
+}
+
+void TerrainTileStoreTest::_bilinear_test(void)
+{
+    QGeoCoordinate  southWest(47.0, 8.0);
+    TerrainTile     tile(createTile(southWest, 0.02));
+
+    QVERIFY(tile.isValid());
+    QVERIFY(TerrainTile::isSerializedFormat(tile.serializedData()));
+    QCOMPARE(tile.minElevation(), 0.0);
+    QCOMPARE(tile.maxElevation(), 22.0);
+
+    // Grid points
+    QCOMPARE(tile.elevation(southWest), 0.0);
+    QCOMPARE(tile.elevation(QGeoCoordinate(47.02, 8.02)), 22.0);
+    QCOMPARE(tile.elevation(QGeoCoordinate(47.01, 8.0)), 10.0);
+
+    // Between grid points
+    double latitudes[]  = { 47.005,  47.015,  47.0,    47.03 };
+    double longitudes[] = { 8.005,   8.0,     8.015,   8.03 };
+    double expected[]   = { 5.5,     15.0,    1.5,     22.0 };
+    double elevations[4];
+    tile.elevations(latitudes, longitudes, 4, elevations);
+    for (int i=0; i<4; i++) {
+        QVERIFY(qAbs(elevations[i] - expected[i]) < 0.001);
+    }
+}
+
+void TerrainTileStoreTest::_store_test(void)
+{
+    QTemporaryDir       tempDir;
+    TerrainTileStore    store;
+    QGeoCoordinate      southWest(47.0, 8.0);
+    QString             hash = TerrainTileStore::tileHash(southWest);
+
+    store.setCacheDirectory(tempDir.path());
+    QVERIFY(!store.tile(hash));
+    QVERIFY(!store.insert(hash, QByteArray("bad")));
+
+    TerrainTileStore::TilePtr tile = store.insert(hash, createTile(southWest, 0.01));
+    QVERIFY(tile);
+    QCOMPARE(store.count(), 1);
+
+    // Tile is mapped again from disk once dropped from memory
+    store.clear();
+    QCOMPARE(store.count(), 0);
+    TerrainTileStore::TilePtr mappedTile = store.tile(hash);
+    QVERIFY(mappedTile);
+    QCOMPARE(mappedTile->elevation(QGeoCoordinate(47.005, 8.005)), tile->elevation(QGeoCoordinate(47.005, 8.005)));
+    QCOMPARE(store.count(), 1);
+}
+
+void TerrainTileStoreTest::_eviction_test(void)
+{
+    QTemporaryDir       tempDir;
+    TerrainTileStore    store;
+    QList<QString>      hashes;
+
+    store.setCacheDirectory(tempDir.path());
+    store.setMaxTiles(2);
+    for (int i=0; i<3; i++) {
+        QGeoCoordinate southWest(47.0 + i * 0.01, 8.0);
+        hashes.append(TerrainTileStore::tileHash(southWest));
+        QVERIFY(store.insert(hashes.last(), createTile(southWest, 0.01)));
+        if (i == 1) {
+            // Makes the second tile the least recently used one
+            QVERIFY(store.tile(hashes[0]));
+        }
+    }
+    QCOMPARE(store.count(), 2);
+
+    // Evicted tiles still come back from disk
+    QVERIFY(store.tile(hashes[1]));
+    QCOMPARE(store.count(), 2);
+}
+
+void TerrainTileStoreTest::_batch_test(void)
+{
+    QTemporaryDir           tempDir;
+    TerrainTileStore        store;
+    QGeoCoordinate          southWest(47.0, 8.0);
+    QList<QGeoCoordinate>   coordinates;
+    QList<double>           elevations;
+    QList<QGeoCoordinate>   missingTiles;
+
+    store.setCacheDirectory(tempDir.path());
+
+    coordinates << QGeoCoordinate(47.005, 8.005) << QGeoCoordinate(47.015, 8.005) << QGeoCoordinate(47.001, 8.001);
+    QVERIFY(!store.elevations(coordinates, elevations, missingTiles));
+    QCOMPARE(missingTiles.count(), 2);
+
+    // Hashes are taken from inside the tiles, corners may round to the neighbouring tile
+    store.insert(TerrainTileStore::tileHash(coordinates[0]), createTile(southWest, 0.01));
+    store.insert(TerrainTileStore::tileHash(coordinates[1]), createTile(QGeoCoordinate(47.01, 8.0), 0.01));
+    QVERIFY(store.elevations(coordinates, elevations, missingTiles));
+    QCOMPARE(missingTiles.count(), 0);
+    QCOMPARE(elevations.count(), coordinates.count());
+    for (int i=0; i<coordinates.count(); i++) {
+        TerrainTileStore::TilePtr tile = store.tile(TerrainTileStore::tileHash(coordinates[i]));
+        QCOMPARE(elevations[i], tile->elevation(coordinates[i]));
+    }
+}
+
+void TerrainTileStoreTest::_diskLimit_test(void)
+{
+    QTemporaryDir       tempDir;
+    TerrainTileStore    store;
+    QList<QString>      hashes;
+
+    store.setCacheDirectory(tempDir.path());
+    for (int i=0; i<2; i++) {
+        QGeoCoordinate southWest(47.0 + i * 0.01, 8.0);
+        hashes.append(TerrainTileStore::tileHash(southWest));
+        QVERIFY(store.insert(hashes.last(), createTile(southWest, 0.01)));
+    }
+    qint64 tileBytes = store.diskBytes() / 2;
+    QVERIFY(tileBytes > 0);
+
+    // Room for two tile files, the oldest one goes when the third is written
+    store.setMaxDiskBytes(tileBytes * 2);
+    QGeoCoordinate southWest(47.02, 8.0);
+    hashes.append(TerrainTileStore::tileHash(southWest));
+    QVERIFY(store.insert(hashes.last(), createTile(southWest, 0.01)));
+    QCOMPARE(store.diskBytes(), tileBytes * 2);
+
+    store.clear();
+    QVERIFY(!store.tile(hashes[0]));
+    QVERIFY(store.tile(hashes[1]));
+    QVERIFY(store.tile(hashes[2]));
+
+    // A new store picks up the existing files and trims them to its own limit
+    TerrainTileStore reopenedStore;
+    reopenedStore.setCacheDirectory(tempDir.path());
+    QCOMPARE(reopenedStore.diskBytes(), tileBytes * 2);
+    reopenedStore.setMaxDiskBytes(tileBytes);
+    QCOMPARE(reopenedStore.diskBytes(), tileBytes);
+    QCOMPARE(QDir(tempDir.path()).entryList(QDir::Files).count(), 1);
+}
+
+void TerrainTileStoreTest::_remove_test(void)
+{
+    QTemporaryDir       tempDir;
+    TerrainTileStore    store;
+    QList<QString>      hashes;
+
+    store.setCacheDirectory(tempDir.path());
+    for (int i=0; i<3; i++) {
+        QGeoCoordinate southWest(47.0 + i * 0.01, 8.0);
+        hashes.append(TerrainTileStore::tileHash(southWest));
+        QVERIFY(store.insert(hashes.last(), createTile(southWest, 0.01)));
+    }
+
+    store.remove(QStringList(hashes[1]));
+    QCOMPARE(store.count(), 2);
+    QVERIFY(!store.tile(hashes[1]));
+    QVERIFY(store.tile(hashes[0]));
+
+    store.removeAll();
+    QCOMPARE(store.count(), 0);
+    QCOMPARE(store.diskBytes(), 0LL);
+    QVERIFY(!store.tile(hashes[0]));
+    QVERIFY(!store.tile(hashes[2]));
+    QVERIFY(QDir(tempDir.path()).entryList(QDir::Files).isEmpty());
+}
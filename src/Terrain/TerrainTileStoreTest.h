@@ -0,0 +1,30 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit test for TerrainTile sampling and TerrainTileStore
+class TerrainTileStoreTest : public UnitTest
+{
+    Q_OBJECT
+
+public:
+    /// Creates a serialized 3x3 tile with elevation = 10 * row + column
+    static QByteArray createTile(const QGeoCoordinate& southWest, double size);
+
+private slots:
+    void _bilinear_test     (void);
+    void _store_test        (void);
+    void _eviction_test     (void);
+    void _batch_test        (void);
+    void _diskLimit_test    (void);
+    void _remove_test       (void);
+};
@@ -7,6 +7,8 @@
 #include <QJsonArray>
 #include <QDataStream>
 
+#include <cstring>
+
 QGC_LOGGING_CATEGORY(TerrainTileLog, "TerrainTileLog")
 
 const char*  TerrainTile::_jsonStatusKey        = "status";
@@ -32,18 +34,6 @@ TerrainTile::TerrainTile()
 
 }
 
-TerrainTile::~TerrainTile()
-{
-    if (_data) {
-        for (int i = 0; i < _gridSizeLat; i++) {
-            delete _data[i];
-        }
-        delete _data;
-        _data = NULL;
-    }
-}
-
-
 TerrainTile::TerrainTile(QByteArray byteArray)
     : _minElevation(-1.0)
     , _maxElevation(-1.0)
@@ -52,54 +42,115 @@ TerrainTile::TerrainTile(QByteArray byteArray)
     , _gridSizeLat(-1)
     , _gridSizeLon(-1)
     , _isValid(false)
+{
+    if (!isSerializedFormat(byteArray)) {
+        byteArray = _convertLegacy(byteArray);
+    }
+    _load(byteArray);
+}
+
+bool TerrainTile::mapFile(const QString& fileName)
+{
+    QSharedPointer<QFile> file(new QFile(fileName));
+    if (!file->open(QIODevice::ReadOnly)) {
+        qCWarning(TerrainTileLog) << "Unable to open terrain tile file" << fileName << file->errorString();
+        return false;
+    }
+    qint64 size = file->size();
+    uchar* mapped = file->map(0, size);
+    if (!mapped) {
+        qCWarning(TerrainTileLog) << "Unable to map terrain tile file" << fileName << file->errorString();
+        return false;
+    }
+    // The mapping stays valid after the file is closed, it is released when the last copy of the tile goes away
+    file->close();
+    if (!_load(QByteArray::fromRawData(reinterpret_cast<const char*>(mapped), static_cast<int>(size)))) {
+        return false;
+    }
+    _mappedFile = file;
+    return true;
+}
+
+bool TerrainTile::isSerializedFormat(const QByteArray& bytes)
+{
+    if (bytes.size() < static_cast<int>(sizeof(FlatTileHeader_t))) {
+        return false;
+    }
+    const FlatTileHeader_t* header = reinterpret_cast<const FlatTileHeader_t*>(bytes.constData());
+    return header->magic == _flatTileMagic && header->version == _flatTileVersion;
+}
+
+/// Converts the serialized format of earlier versions to the flat format
+QByteArray TerrainTile::_convertLegacy(const QByteArray& bytes)
 {
     int cTileHeaderBytes = static_cast<int>(sizeof(TileInfo_t));
-    int cTileBytesAvailable = byteArray.size();
+    int cTileBytesAvailable = bytes.size();
 
     if (cTileBytesAvailable < cTileHeaderBytes) {
         qWarning() << "Terrain tile binary data too small for TileInfo_s header";
-        return;
+        return QByteArray();
     }
 
-    const TileInfo_t* tileInfo = reinterpret_cast<const TileInfo_t*>(byteArray.constData());
-    _southWest.setLatitude(tileInfo->swLat);
-    _southWest.setLongitude(tileInfo->swLon);
-    _northEast.setLatitude(tileInfo->neLat);
-    _northEast.setLongitude(tileInfo->neLon);
-    _minElevation = tileInfo->minElevation;
-    _maxElevation = tileInfo->maxElevation;
-    _avgElevation = tileInfo->avgElevation;
-    _gridSizeLat = tileInfo->gridSizeLat;
-    _gridSizeLon = tileInfo->gridSizeLon;
-
-    qCDebug(TerrainTileLog) << "Loading terrain tile: " << _southWest << " - " << _northEast;
-    qCDebug(TerrainTileLog) << "min:max:avg:sizeLat:sizeLon" << _minElevation << _maxElevation << _avgElevation << _gridSizeLat << _gridSizeLon;
-
-    int cTileDataBytes = static_cast<int>(sizeof(int16_t)) * _gridSizeLat * _gridSizeLon;
-    if (cTileBytesAvailable < cTileHeaderBytes + cTileDataBytes) {
+    const TileInfo_t* tileInfo = reinterpret_cast<const TileInfo_t*>(bytes.constData());
+    int cTileDataBytes = static_cast<int>(sizeof(int16_t)) * tileInfo->gridSizeLat * tileInfo->gridSizeLon;
+    if (tileInfo->gridSizeLat <= 0 || tileInfo->gridSizeLon <= 0 || cTileBytesAvailable < cTileHeaderBytes + cTileDataBytes) {
         qWarning() << "Terrain tile binary data too small for tile data";
-        return;
+        return QByteArray();
     }
 
-    _data = new int16_t*[_gridSizeLat];
-    for (int k = 0; k < _gridSizeLat; k++) {
-        _data[k] = new int16_t[_gridSizeLon];
+    QByteArray byteArray(static_cast<int>(sizeof(FlatTileHeader_t)) + cTileDataBytes, 0);
+    FlatTileHeader_t* header = reinterpret_cast<FlatTileHeader_t*>(byteArray.data());
+    header->magic           = _flatTileMagic;
+    header->version         = _flatTileVersion;
+    header->swLat           = tileInfo->swLat;
+    header->swLon           = tileInfo->swLon;
+    header->neLat           = tileInfo->neLat;
+    header->neLon           = tileInfo->neLon;
+    header->avgElevation    = tileInfo->avgElevation;
+    header->gridSizeLat     = tileInfo->gridSizeLat;
+    header->gridSizeLon     = tileInfo->gridSizeLon;
+    header->minElevation    = tileInfo->minElevation;
+    header->maxElevation    = tileInfo->maxElevation;
+    memcpy(byteArray.data() + sizeof(FlatTileHeader_t), bytes.constData() + cTileHeaderBytes, static_cast<size_t>(cTileDataBytes));
+
+    return byteArray;
+}
+
+bool TerrainTile::_load(const QByteArray& bytes)
+{
+    if (!isSerializedFormat(bytes)) {
+        qCWarning(TerrainTileLog) << "Terrain tile binary data has unknown format";
+        return false;
     }
 
-    int valueIndex = 0;
-    const int16_t* pTileData = reinterpret_cast<const int16_t*>(&reinterpret_cast<const uint8_t*>(byteArray.constData())[cTileHeaderBytes]);
-    for (int i = 0; i < _gridSizeLat; i++) {
-        for (int j = 0; j < _gridSizeLon; j++) {
-            _data[i][j] = pTileData[valueIndex++];
-        }
+    const FlatTileHeader_t* header = reinterpret_cast<const FlatTileHeader_t*>(bytes.constData());
+    qint64 cTileDataBytes = static_cast<qint64>(sizeof(int16_t)) * header->gridSizeLat * header->gridSizeLon;
+    if (header->gridSizeLat <= 0 || header->gridSizeLon <= 0 || bytes.size() < static_cast<qint64>(sizeof(FlatTileHeader_t)) + cTileDataBytes) {
+        qWarning() << "Terrain tile binary data too small for tile data";
+        return false;
     }
 
+    _southWest.setLatitude(header->swLat);
+    _southWest.setLongitude(header->swLon);
+    _northEast.setLatitude(header->neLat);
+    _northEast.setLongitude(header->neLon);
+    _minElevation = header->minElevation;
+    _maxElevation = header->maxElevation;
+    _avgElevation = header->avgElevation;
+    _gridSizeLat = header->gridSizeLat;
+    _gridSizeLon = header->gridSizeLon;
+
+    qCDebug(TerrainTileLog) << "Loading terrain tile: " << _southWest << " - " << _northEast;
+    qCDebug(TerrainTileLog) << "min:max:avg:sizeLat:sizeLon" << _minElevation << _maxElevation << _avgElevation << _gridSizeLat << _gridSizeLon;
+
+    // No copy, the grid is used in place
+    _bytes = bytes;
+    _data = reinterpret_cast<const int16_t*>(_bytes.constData() + sizeof(FlatTileHeader_t));
     _isValid = true;
 
-    return;
+    return true;
 }
 
-
 bool TerrainTile::isIn(const QGeoCoordinate& coordinate) const
 {
     if (!_isValid) {
@@ -116,21 +167,55 @@ double TerrainTile::elevation(const QGeoCoordinate& coordinate) const
 {
     if (_isValid) {
         qCDebug(TerrainTileLog) << "elevation: " << coordinate << " , in sw " << _southWest << " , ne " << _northEast;
-        // Get the index at resolution of 1 arc second
-        int indexLat = _latToDataIndex(coordinate.latitude());
-        int indexLon = _lonToDataIndex(coordinate.longitude());
-        if (indexLat == -1 || indexLon == -1) {
-            qCWarning(TerrainTileLog) << "Internal error indexLat:indexLon == -1" << indexLat << indexLon;
-            return qQNaN();
-        }
-        qCDebug(TerrainTileLog) << "indexLat:indexLon" << indexLat << indexLon << "elevation" << _data[indexLat][indexLon];
-        return static_cast<double>(_data[indexLat][indexLon]);
+        double latitude = coordinate.latitude();
+        double longitude = coordinate.longitude();
+        double elevation;
+        elevations(&latitude, &longitude, 1, &elevation);
+        return elevation;
     } else {
         qCWarning(TerrainTileLog) << "Asking for elevation, but no valid data.";
         return qQNaN();
     }
 }
 
+void TerrainTile::elevations(const double* latitudes, const double* longitudes, int count, double* elevations) const
+{
+    if (!_isValid) {
+        qCWarning(TerrainTileLog) << "Asking for elevations, but no valid data.";
+        for (int i = 0; i < count; i++) {
+            elevations[i] = qQNaN();
+        }
+        return;
+    }
+
+    // Everything which doesn't depend on the coordinate is computed once, which keeps the loop below
+    // free of branches other than the clamping so the compiler can vectorize it.
+    const double    swLat       = _southWest.latitude();
+    const double    swLon       = _southWest.longitude();
+    const double    latScale    = (_gridSizeLat - 1) / (_northEast.latitude() - swLat);
+    const double    lonScale    = (_gridSizeLon - 1) / (_northEast.longitude() - swLon);
+    const int       maxLatIndex = qMax(_gridSizeLat - 2, 0);
+    const int       maxLonIndex = qMax(_gridSizeLon - 2, 0);
+    const int       latStride   = _gridSizeLat > 1 ? _gridSizeLon : 0;
+    const int       lonStride   = _gridSizeLon > 1 ? 1 : 0;
+    const double    maxLatPos   = _gridSizeLat - 1;
+    const double    maxLonPos   = _gridSizeLon - 1;
+
+    for (int i = 0; i < count; i++) {
+        double latPos = qBound(0.0, (latitudes[i] - swLat) * latScale, maxLatPos);
+        double lonPos = qBound(0.0, (longitudes[i] - swLon) * lonScale, maxLonPos);
+        int latIndex = qMin(static_cast<int>(latPos), maxLatIndex);
+        int lonIndex = qMin(static_cast<int>(lonPos), maxLonIndex);
+        double latFraction = latPos - latIndex;
+        double lonFraction = lonPos - lonIndex;
+
+        const int16_t* p = _data + latIndex * _gridSizeLon + lonIndex;
+        double south = p[0]         + (p[lonStride] - p[0]) * lonFraction;
+        double north = p[latStride] + (p[latStride + lonStride] - p[latStride]) * lonFraction;
+        elevations[i] = south + (north - south) * latFraction;
+    }
+}
+
 QGeoCoordinate TerrainTile::centerCoordinate(void) const
 {
     return _southWest.atDistanceAndAzimuth(_southWest.distanceTo(_northEast) / 2.0, _southWest.azimuthTo(_northEast));
@@ -219,8 +304,11 @@ QByteArray TerrainTile::serialize(QByteArray input)
     qCDebug(TerrainTileLog) << "Received tile has size in latitude direction: " << gridSizeLat;
     qCDebug(TerrainTileLog) << "Received tile has size in longitued direction: " << gridSizeLon;
 
-    TileInfo_t tileInfo;
+    FlatTileHeader_t tileInfo;
 
+    memset(&tileInfo, 0, sizeof(tileInfo));
+    tileInfo.magic = _flatTileMagic;
+    tileInfo.version = _flatTileVersion;
     tileInfo.swLat = swArray[0].toDouble();
     tileInfo.swLon = swArray[1].toDouble();
     tileInfo.neLat = neArray[0].toDouble();
@@ -228,15 +316,15 @@ QByteArray TerrainTile::serialize(QByteArray input)
     tileInfo.minElevation = static_cast<int16_t>(statsObject[_jsonMinElevationKey].toInt());
     tileInfo.maxElevation = static_cast<int16_t>(statsObject[_jsonMaxElevationKey].toInt());
     tileInfo.avgElevation = statsObject[_jsonAvgElevationKey].toDouble();
-    tileInfo.gridSizeLat = static_cast<int16_t>(gridSizeLat);
-    tileInfo.gridSizeLon = static_cast<int16_t>(gridSizeLon);
+    tileInfo.gridSizeLat = gridSizeLat;
+    tileInfo.gridSizeLon = gridSizeLon;
 
-    int cTileHeaderBytes = static_cast<int>(sizeof(TileInfo_t));
+    int cTileHeaderBytes = static_cast<int>(sizeof(FlatTileHeader_t));
     int cTileDataBytes = static_cast<int>(sizeof(int16_t)) * gridSizeLat * gridSizeLon;
 
     QByteArray byteArray(cTileHeaderBytes + cTileDataBytes, 0);
 
-    TileInfo_t* pTileInfo = reinterpret_cast<TileInfo_t*>(byteArray.data());
+    FlatTileHeader_t* pTileInfo = reinterpret_cast<FlatTileHeader_t*>(byteArray.data());
     int16_t*    pTileData = reinterpret_cast<int16_t*>(&reinterpret_cast<uint8_t*>(byteArray.data())[cTileHeaderBytes]);
 
     *pTileInfo = tileInfo;
@@ -257,23 +345,3 @@ QByteArray TerrainTile::serialize(QByteArray input)
     return byteArray;
 }
 
-
-int TerrainTile::_latToDataIndex(double latitude) const
-{
-    if (isValid() && _southWest.isValid() && _northEast.isValid()) {
-        return qRound((latitude - _southWest.latitude()) / (_northEast.latitude() - _southWest.latitude()) * (_gridSizeLat - 1));
-    } else {
-        qCWarning(TerrainTileLog) << "TerrainTile::_latToDataIndex internal error" << isValid() << _southWest.isValid() << _northEast.isValid();
-        return -1;
-    }
-}
-
-int TerrainTile::_lonToDataIndex(double longitude) const
-{
-    if (isValid() && _southWest.isValid() && _northEast.isValid()) {
-        return qRound((longitude - _southWest.longitude()) / (_northEast.longitude() - _southWest.longitude()) * (_gridSizeLon - 1));
-    } else {
-        qCWarning(TerrainTileLog) << "TerrainTile::_lonToDataIndex internal error" << isValid() << _southWest.isValid() << _northEast.isValid();
-        return -1;
-    }
-}
@@ -4,6 +4,8 @@
 #include "QGCLoggingCategory.h"
 
 #include <QGeoCoordinate>
+#include <QSharedPointer>
+#include <QFile>
 
 Q_DECLARE_LOGGING_CATEGORY(TerrainTileLog)
 
@@ -11,13 +13,16 @@ Q_DECLARE_LOGGING_CATEGORY(TerrainTileLog)
  * @brief The TerrainTile class
  *
  * Implements an interface for https://developers.airmap.com/v2.0/docs/elevation-api
+ *
+ * Tiles are stored in a flat binary format: a fixed size header followed by the elevation grid as
+ * row major int16 values (rows south to north). The format can be memory mapped from disk as is,
+ * see mapFile. Copies of a tile share the same elevation data.
  */
 
 class TerrainTile
 {
 public:
     TerrainTile();
-    ~TerrainTile();
 
     /**
     * Constructor from json doc with elevation data (either from file or web)
@@ -33,6 +38,14 @@ public:
     */
     TerrainTile(QByteArray byteArray);
 
+    /**
+    * Loads the tile by memory mapping a file holding serialized elevation data
+    *
+    * @param fileName
+    * @return true if the file was mapped and holds a valid tile
+    */
+    bool mapFile(const QString& fileName);
+
     /**
     * Check for whether a coordinate lies within this tile
     *
@@ -56,6 +69,17 @@ public:
     */
     double elevation(const QGeoCoordinate& coordinate) const;
 
+    /**
+    * Evaluates the elevation at each of the given coordinates, interpolating bilinearly between
+    * the grid points. Coordinates outside of the tile are clamped to the tile edge.
+    *
+    * @param latitudes
+    * @param longitudes
+    * @param count number of coordinates
+    * @param elevations output, count values
+    */
+    void elevations(const double* latitudes, const double* longitudes, int count, double* elevations) const;
+
     /**
     * Accessor for the minimum elevation of the tile
     *
@@ -84,6 +108,14 @@ public:
     */
     QGeoCoordinate centerCoordinate(void) const;
 
+    /**
+    * Accessor for the tile in serialized form. The data is not copied, for a memory mapped tile
+    * it is only valid while the tile exists.
+    *
+    * @return serialized data
+    */
+    QByteArray serializedData(void) const { return _bytes; }
+
     /**
     * Serialize data
     *
@@ -91,10 +123,18 @@ public:
     */
     static QByteArray serialize(QByteArray input);
 
+    /**
+    * Check whether serialized data is in the current flat binary format
+    *
+    * @return true if current format
+    */
+    static bool isSerializedFormat(const QByteArray& bytes);
+
     /// Approximate spacing of the elevation data measurement points
     static constexpr double terrainAltitudeSpacing = 30.0;
 
 private:
+    /// Header of the serialized format from earlier versions, still found in older map caches
     typedef struct {
         double  swLat,swLon, neLat, neLon;
         int16_t minElevation;
@@ -104,8 +144,21 @@ private:
         int16_t gridSizeLon;
     } TileInfo_t;
 
-    inline int _latToDataIndex(double latitude) const;
-    inline int _lonToDataIndex(double longitude) const;
+    /// Header of the flat serialized format. Naturally aligned, the elevation data follows directly.
+    typedef struct {
+        quint32 magic;
+        quint32 version;
+        double  swLat, swLon, neLat, neLon;
+        double  avgElevation;
+        qint32  gridSizeLat;
+        qint32  gridSizeLon;
+        int16_t minElevation;
+        int16_t maxElevation;
+        quint32 reserved;
+    } FlatTileHeader_t;
+
+    bool _load(const QByteArray& bytes);
+    static QByteArray _convertLegacy(const QByteArray& bytes);
 
     QGeoCoordinate      _southWest;                                     /// South west corner of the tile
     QGeoCoordinate      _northEast;                                     /// North east corner of the tile
@@ -114,11 +167,16 @@ private:
     int16_t             _maxElevation;                                  /// Maximum elevation in tile
     double              _avgElevation;                                  /// Average elevation of the tile
 
-    int16_t**           _data;                                          /// 2D elevation data array
-    int16_t             _gridSizeLat;                                   /// data grid size in latitude direction
-    int16_t             _gridSizeLon;                                   /// data grid size in longitude direction
+    QByteArray          _bytes;                                         /// serialized tile, shared between copies
+    QSharedPointer<QFile> _mappedFile;                                  /// keeps memory mapped tile data alive
+    const int16_t*      _data;                                          /// elevation grid, row major, within _bytes
+    int                 _gridSizeLat;                                   /// data grid size in latitude direction
+    int                 _gridSizeLon;                                   /// data grid size in longitude direction
     bool                _isValid;                                       /// data loaded is valid
 
+    static const quint32 _flatTileMagic     = 0x54544751;               /// "QGTT"
+    static const quint32 _flatTileVersion   = 1;
+
     // Json keys
     static const char*  _jsonStatusKey;
     static const char*  _jsonDataKey;
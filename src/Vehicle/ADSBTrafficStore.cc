@@ -0,0 +1,311 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ADSBTrafficStore.h"
+#include "ADSBVehicle.h"
+#include "QGCLoggingCategory.h"
+
+#include <QSet>
+#include <QtMath>
+
+#include <algorithm>
+
+QGC_LOGGING_CATEGORY(ADSBTrafficStoreLog, "ADSBTrafficStoreLog")
+
+const double    ADSBTrafficStore::cellDegrees = 0.1;
+const int       ADSBTrafficStore::_lonCells =   3600;   // 360 / cellDegrees
+
+ADSBTrafficStore::ADSBTrafficStore(int expirationMSecs, int tickMSecs, QObject* parent)
+    : QObject           (parent)
+    , _tickMSecs        (qMax(1, tickMSecs))
+    , _nextId           (1)
+    , _currentTick      (0)
+    , _expirationTicks  (static_cast<quint32>(qMax(1, (expirationMSecs + _tickMSecs - 1) / _tickMSecs)))
+{
+    _wheel.resize(_expirationTicks + 1);
+
+    _expirationTimer.setSingleShot(false);
+    _expirationTimer.setInterval(_tickMSecs);
+    connect(&_expirationTimer, &QTimer::timeout, this, &ADSBTrafficStore::_expirationTick);
+    _expirationTimer.start();
+    _clock.start();
+
+    _modelUpdateTimer.setSingleShot(true);
+    _modelUpdateTimer.setInterval(modelUpdateMSecs);
+    connect(&_modelUpdateTimer, &QTimer::timeout, this, &ADSBTrafficStore::flushModel);
+}
+
+void ADSBTrafficStore::update(mavlink_adsb_vehicle_t& adsbVehicle)
+{
+    if (!(adsbVehicle.flags & ADSB_FLAGS_VALID_COORDS)) {
+        return;
+    }
+
+    QHash<uint32_t, quint32>::const_iterator it = _icaoIds.constFind(adsbVehicle.ICAO_address);
+    if (it != _icaoIds.constEnd()) {
+        quint32 id = it.value();
+        if (adsbVehicle.tslc > maxTimeSinceLastSeenSecs) {
+            _remove(id);
+        } else {
+            _entries[id].vehicle->update(adsbVehicle);
+            _touch(id);
+        }
+    } else if (adsbVehicle.tslc <= maxTimeSinceLastSeenSecs) {
+        _add(new ADSBVehicle(adsbVehicle, this), adsbVehicle.ICAO_address, QString());
+    }
+}
+
+void ADSBTrafficStore::update(const QString& trafficId, bool alert, const QGeoCoordinate& location, float heading)
+{
+    QHash<QString, quint32>::const_iterator it = _trafficIds.constFind(trafficId);
+    if (it != _trafficIds.constEnd()) {
+        quint32 id = it.value();
+        _entries[id].vehicle->update(alert, location, heading);
+        _touch(id);
+    } else {
+        _add(new ADSBVehicle(location, heading, alert, this), 0, trafficId);
+    }
+}
+
+quint32 ADSBTrafficStore::_add(ADSBVehicle* vehicle, uint32_t icaoAddress, const QString& trafficId)
+{
+    quint32 id = _nextId++;
+
+    Entry_t& entry = _entries[id];
+    entry.vehicle           = vehicle;
+    entry.icaoAddress       = icaoAddress;
+    entry.trafficId         = trafficId;
+    entry.cell              = _invalidCell;
+    entry.lastUpdateTick    = _currentTick;
+
+    if (trafficId.isEmpty()) {
+        _icaoIds[icaoAddress] = id;
+    } else {
+        _trafficIds[trafficId] = id;
+    }
+    _setCell(id, entry);
+    _scheduleExpiration(id, _currentTick + _expirationTicks);
+
+    _pendingAdditions.append(vehicle);
+    if (!_modelUpdateTimer.isActive()) {
+        _modelUpdateTimer.start();
+    }
+
+    qCDebug(ADSBTrafficStoreLog) << "Added" << icaoAddress << trafficId << "count" << _entries.count();
+
+    return id;
+}
+
+void ADSBTrafficStore::_touch(quint32 id)
+{
+    Entry_t& entry = _entries[id];
+
+    // The expiration slot isn't moved here, that happens lazily when the old slot comes around
+    entry.lastUpdateTick = _currentTick;
+    _setCell(id, entry);
+}
+
+void ADSBTrafficStore::_remove(quint32 id)
+{
+    Entry_t entry = _entries.take(id);
+
+    if (entry.trafficId.isEmpty()) {
+        _icaoIds.remove(entry.icaoAddress);
+    } else {
+        _trafficIds.remove(entry.trafficId);
+    }
+
+    if (entry.cell != _invalidCell) {
+        QHash<quint32, QList<quint32>>::iterator cellIt = _grid.find(entry.cell);
+        cellIt.value().removeOne(id);
+        if (cellIt.value().isEmpty()) {
+            _grid.erase(cellIt);
+        }
+    }
+
+    if (_pendingAdditions.removeOne(entry.vehicle)) {
+        // Never made it into the model
+        entry.vehicle->deleteLater();
+    } else {
+        _pendingRemovals.append(entry.vehicle);
+        if (!_modelUpdateTimer.isActive()) {
+            _modelUpdateTimer.start();
+        }
+    }
+
+    qCDebug(ADSBTrafficStoreLog) << "Removed" << entry.icaoAddress << entry.trafficId << "count" << _entries.count();
+}
+
+void ADSBTrafficStore::_setCell(quint32 id, Entry_t& entry)
+{
+    quint32 cell = _cell(entry.vehicle->coordinate());
+    if (cell == entry.cell) {
+        return;
+    }
+
+    if (entry.cell != _invalidCell) {
+        QHash<quint32, QList<quint32>>::iterator cellIt = _grid.find(entry.cell);
+        cellIt.value().removeOne(id);
+        if (cellIt.value().isEmpty()) {
+            _grid.erase(cellIt);
+        }
+    }
+    if (cell != _invalidCell) {
+        _grid[cell].append(id);
+    }
+    entry.cell = cell;
+}
+
+void ADSBTrafficStore::_scheduleExpiration(quint32 id, quint32 tick)
+{
+    _wheel[tick % _wheel.count()].append(id);
+}
+
+void ADSBTrafficStore::_expirationTick(void)
+{
+    // The tick comes from elapsed time, not from counting timer firings. A late or skipped timeout (busy ui thread,
+    // suspended app) then catches up instead of stretching the expiration period.
+    _advanceTo(static_cast<quint32>(_clock.elapsed() / _tickMSecs));
+}
+
+void ADSBTrafficStore::_advanceTo(quint32 tick)
+{
+    while (_currentTick < tick) {
+        _currentTick++;
+
+        // Only traffic which was due at this tick is looked at. Anything updated since then gets rescheduled for one
+        // expiration period after its last update.
+        QList<quint32> ids;
+        ids.swap(_wheel[_currentTick % _wheel.count()]);
+
+        foreach (quint32 id, ids) {
+            QHash<quint32, Entry_t>::const_iterator it = _entries.constFind(id);
+            if (it == _entries.constEnd()) {
+                // Already removed
+                continue;
+            }
+
+            quint32 expirationTick = it.value().lastUpdateTick + _expirationTicks;
+            if (expirationTick <= _currentTick) {
+                _remove(id);
+            } else {
+                _scheduleExpiration(id, expirationTick);
+            }
+        }
+    }
+}
+
+void ADSBTrafficStore::flushModel(void)
+{
+    _modelUpdateTimer.stop();
+
+    if (!_pendingRemovals.isEmpty()) {
+        QSet<QObject*> removals = QSet<QObject*>::fromList(_pendingRemovals);
+
+        // Back to front so indices stay valid while removing
+        QList<QObject*>* objectList = _model.objectList();
+        for (int i=objectList->count() - 1; i>=0 && !removals.isEmpty(); i--) {
+            QObject* object = objectList->at(i);
+            if (removals.remove(object)) {
+                _model.removeAt(i);
+                object->deleteLater();
+            }
+        }
+        _pendingRemovals.clear();
+    }
+
+    if (!_pendingAdditions.isEmpty()) {
+        _model.append(_pendingAdditions);
+        _pendingAdditions.clear();
+    }
+}
+
+int ADSBTrafficStore::_latIndex(double latitude)
+{
+    return qBound(0, static_cast<int>(floor((latitude + 90.0) / cellDegrees)), static_cast<int>(180.0 / cellDegrees));
+}
+
+int ADSBTrafficStore::_lonIndex(double longitude)
+{
+    int index = static_cast<int>(floor((longitude + 180.0) / cellDegrees)) % _lonCells;
+    return index < 0 ? index + _lonCells : index;
+}
+
+quint32 ADSBTrafficStore::_cell(const QGeoCoordinate& coordinate)
+{
+    if (!coordinate.isValid()) {
+        return _invalidCell;
+    }
+    return static_cast<quint32>((_latIndex(coordinate.latitude()) * _lonCells) + _lonIndex(coordinate.longitude()));
+}
+
+QList<ADSBVehicle*> ADSBTrafficStore::withinRadius(const QGeoCoordinate& coordinate, double radiusMeters) const
+{
+    static const double metersPerDegree = 111320.0;
+
+    QList<QPair<double, ADSBVehicle*>> found;
+
+    if (!coordinate.isValid() || radiusMeters < 0) {
+        return QList<ADSBVehicle*>();
+    }
+
+    double latSpan = radiusMeters / metersPerDegree;
+    double minLat = qMax(-90.0, coordinate.latitude() - latSpan);
+    double maxLat = qMin(90.0, coordinate.latitude() + latSpan);
+
+    // Longitude cells are narrowest at the latitude furthest from the equator, near the poles every cell is searched
+    double cosLat = cos(qDegreesToRadians(qMax(qAbs(minLat), qAbs(maxLat))));
+    int firstLonIndex = 0;
+    int lonCellCount = _lonCells;
+    if (cosLat > 1e-6 && radiusMeters / (metersPerDegree * cosLat) < 180.0) {
+        double lonSpan = radiusMeters / (metersPerDegree * cosLat);
+        firstLonIndex = _lonIndex(coordinate.longitude() - lonSpan);
+        lonCellCount = _lonIndex(coordinate.longitude() + lonSpan) - firstLonIndex + 1;
+        if (lonCellCount <= 0) {
+            // Crosses the antimeridian
+            lonCellCount += _lonCells;
+        }
+    }
+
+    for (int latIndex=_latIndex(minLat); latIndex<=_latIndex(maxLat); latIndex++) {
+        for (int i=0; i<lonCellCount; i++) {
+            quint32 cell = static_cast<quint32>((latIndex * _lonCells) + ((firstLonIndex + i) % _lonCells));
+
+            QHash<quint32, QList<quint32>>::const_iterator cellIt = _grid.constFind(cell);
+            if (cellIt == _grid.constEnd()) {
+                continue;
+            }
+            foreach (quint32 id, cellIt.value()) {
+                ADSBVehicle* vehicle = _entries.constFind(id).value().vehicle;
+                double distance = coordinate.distanceTo(vehicle->coordinate());
+                if (distance <= radiusMeters) {
+                    found.append(qMakePair(distance, vehicle));
+                }
+            }
+        }
+    }
+
+    std::sort(found.begin(), found.end(), [](const QPair<double, ADSBVehicle*>& a, const QPair<double, ADSBVehicle*>& b) { return a.first < b.first; });
+
+    QList<ADSBVehicle*> vehicles;
+    vehicles.reserve(found.count());
+    for (int i=0; i<found.count(); i++) {
+        vehicles.append(found[i].second);
+    }
+    return vehicles;
+}
+
+QList<ADSBVehicle*> ADSBTrafficStore::nearest(const QGeoCoordinate& coordinate, int count, double maxRadiusMeters) const
+{
+    QList<ADSBVehicle*> vehicles = withinRadius(coordinate, maxRadiusMeters);
+    if (vehicles.count() > count) {
+        vehicles.erase(vehicles.begin() + qMax(0, count), vehicles.end());
+    }
+    return vehicles;
+}
@@ -0,0 +1,111 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QGeoCoordinate>
+#include <QLoggingCategory>
+
+#include "QGCMAVLink.h"
+#include "QmlObjectListModel.h"
+
+class ADSBVehicle;
+
+Q_DECLARE_LOGGING_CATEGORY(ADSBTrafficStoreLog)
+
+/// Holds the air traffic reported to a vehicle, both from ADSB_VEHICLE messages and from airspace traffic updates.
+///
+/// Traffic is indexed by a lat/lon grid so proximity queries only look at nearby cells, and expired by a timer wheel
+/// so each tick only looks at the traffic last updated one expiration period ago. Adding and removing traffic from the
+/// QML model is batched so a busy sky doesn't rebuild map delegates for every message.
+class ADSBTrafficStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///     @param expirationMSecs Traffic is removed when it hasn't been updated for this long
+    ///     @param tickMSecs Expiration granularity
+    ADSBTrafficStore(int expirationMSecs = defaultExpirationMSecs, int tickMSecs = defaultTickMSecs, QObject* parent = NULL);
+
+    /// Model of ADSBVehicle objects for display
+    QmlObjectListModel* model(void) { return &_model; }
+
+    /// @return Number of traffic entries, including ones not in the model yet
+    int count(void) const { return _entries.count(); }
+
+    /// Adds or updates traffic from an ADSB_VEHICLE message. Traffic which hasn't been seen for too long is removed.
+    void update(mavlink_adsb_vehicle_t& adsbVehicle);
+
+    /// Adds or updates traffic reported by the airspace provider
+    void update(const QString& trafficId, bool alert, const QGeoCoordinate& location, float heading);
+
+    /// @return Traffic within radiusMeters of coordinate, nearest first
+    QList<ADSBVehicle*> withinRadius(const QGeoCoordinate& coordinate, double radiusMeters) const;
+
+    /// @return Up to count traffic entries nearest to coordinate which are within maxRadiusMeters, nearest first
+    QList<ADSBVehicle*> nearest(const QGeoCoordinate& coordinate, int count, double maxRadiusMeters) const;
+
+    /// Applies pending additions and removals to the model right away instead of on the next batch
+    void flushModel(void);
+
+    static const int    defaultExpirationMSecs =    120000; ///< Airspace providers send updates every second, but keep traffic for 2 minutes for now
+    static const int    defaultTickMSecs =          1000;
+    static const int    maxTimeSinceLastSeenSecs =  15;     ///< ADSB_VEHICLE.tslc past which traffic is dropped
+    static const int    modelUpdateMSecs =          250;    ///< Batching interval for model changes
+    static const double cellDegrees;                        ///< Size of a spatial index cell
+
+private slots:
+    void _expirationTick(void);
+
+private:
+    typedef struct {
+        ADSBVehicle*    vehicle;
+        uint32_t        icaoAddress;        ///< 0 for airspace traffic
+        QString         trafficId;          ///< Empty for ADS-B traffic
+        quint32         cell;
+        quint32         lastUpdateTick;
+    } Entry_t;
+
+    quint32 _add            (ADSBVehicle* vehicle, uint32_t icaoAddress, const QString& trafficId);
+    void    _touch          (quint32 id);
+    void    _remove         (quint32 id);
+    void    _scheduleExpiration(quint32 id, quint32 tick);
+    void    _setCell        (quint32 id, Entry_t& entry);
+    void    _advanceTo      (quint32 tick);
+
+    static quint32 _cell    (const QGeoCoordinate& coordinate);
+    static int     _latIndex(double latitude);
+    static int     _lonIndex(double longitude);
+
+    QmlObjectListModel          _model;
+    QHash<quint32, Entry_t>     _entries;           ///< Keyed by an id which is never reused
+    QHash<uint32_t, quint32>    _icaoIds;
+    QHash<QString, quint32>     _trafficIds;
+    QHash<quint32, QList<quint32>> _grid;           ///< Cell to ids of the traffic in it
+    QVector<QList<quint32>>     _wheel;             ///< Ids to check for expiration, slot per tick
+    QList<QObject*>             _pendingAdditions;
+    QList<QObject*>             _pendingRemovals;
+    QTimer                      _expirationTimer;
+    QTimer                      _modelUpdateTimer;
+    QElapsedTimer               _clock;             ///< Ticks are derived from this, timer firings can be late or coalesced
+    int                         _tickMSecs;
+    quint32                     _nextId;
+    quint32                     _currentTick;
+    quint32                     _expirationTicks;
+
+    static const int        _lonCells;
+    static const quint32    _invalidCell = 0xFFFFFFFF;     ///< Traffic without a valid coordinate, never visited by queries
+
+    friend class ADSBTrafficStoreTest;
+};
@@ -0,0 +1,200 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "ADSBTrafficStoreTest.h"
+#include "ADSBTrafficStore.h"
+#include "ADSBVehicle.h"
+
+#include <QSignalSpy>
+
+#include <string.h>
+
+mavlink_adsb_vehicle_t ADSBTrafficStoreTest::_adsbVehicle(uint32_t icaoAddress, const QGeoCoordinate& coordinate, uint8_t tslc)
+{
+    mavlink_adsb_vehicle_t adsbVehicle;
+
+    memset(&adsbVehicle, 0, sizeof(adsbVehicle));
+    adsbVehicle.ICAO_address =  icaoAddress;
+    adsbVehicle.lat =           static_cast<int32_t>(coordinate.latitude() * 1e7);
+    adsbVehicle.lon =           static_cast<int32_t>(coordinate.longitude() * 1e7);
+    adsbVehicle.altitude =      100000;
+    adsbVehicle.heading =       9000;
+    adsbVehicle.flags =         ADSB_FLAGS_VALID_COORDS | ADSB_FLAGS_VALID_ALTITUDE | ADSB_FLAGS_VALID_HEADING;
+    adsbVehicle.tslc =          tslc;
+    strncpy(adsbVehicle.callsign, "TEST", sizeof(adsbVehicle.callsign));
+
+    return adsbVehicle;
+}
+
+void ADSBTrafficStoreTest::_testAddUpdateRemove(void)
+{
+    ADSBTrafficStore store;
+    QGeoCoordinate coordinate(47.3977, 8.5456);
+
+    mavlink_adsb_vehicle_t adsbVehicle = _adsbVehicle(1234, coordinate);
+    store.update(adsbVehicle);
+    store.flushModel();
+    QCOMPARE(store.count(), 1);
+    QCOMPARE(store.model()->count(), 1);
+
+    ADSBVehicle* vehicle = store.model()->value<ADSBVehicle*>(0);
+    QCOMPARE(vehicle->icaoAddress(), 1234);
+    QCOMPARE(vehicle->altitude(), 100.0);
+    QCOMPARE(vehicle->heading(), 90.0);
+
+    // Update moves the same object
+    QGeoCoordinate newCoordinate = coordinate.atDistanceAndAzimuth(500, 90);
+    adsbVehicle = _adsbVehicle(1234, newCoordinate);
+    store.update(adsbVehicle);
+    QCOMPARE(store.count(), 1);
+    QVERIFY(vehicle->coordinate().distanceTo(newCoordinate) < 1);
+    QCOMPARE(store.nearest(newCoordinate, 1, 100).count(), 1);
+    QCOMPARE(store.nearest(coordinate, 1, 100).count(), 0);
+
+    // Invalid coordinates are ignored
+    adsbVehicle.flags = 0;
+    adsbVehicle.ICAO_address = 5678;
+    store.update(adsbVehicle);
+    QCOMPARE(store.count(), 1);
+
+    // Traffic which hasn't been seen for too long is dropped, and never added
+    adsbVehicle = _adsbVehicle(1234, newCoordinate, ADSBTrafficStore::maxTimeSinceLastSeenSecs + 1);
+    store.update(adsbVehicle);
+    adsbVehicle = _adsbVehicle(5678, newCoordinate, ADSBTrafficStore::maxTimeSinceLastSeenSecs + 1);
+    store.update(adsbVehicle);
+    QCOMPARE(store.count(), 0);
+    store.flushModel();
+    QCOMPARE(store.model()->count(), 0);
+
+    // Airspace traffic lives in the same store
+    store.update(QStringLiteral("traffic1"), true, coordinate, 45);
+    store.update(QStringLiteral("traffic1"), false, newCoordinate, 45);
+    store.flushModel();
+    QCOMPARE(store.count(), 1);
+    QCOMPARE(store.model()->count(), 1);
+    QCOMPARE(store.model()->value<ADSBVehicle*>(0)->alert(), false);
+}
+
+void ADSBTrafficStoreTest::_testModelBatching(void)
+{
+    const int trafficCount = 200;
+
+    ADSBTrafficStore store;
+    QGeoCoordinate center(47.3977, 8.5456);
+    QSignalSpy countSpy(store.model(), &QmlObjectListModel::countChanged);
+
+    for (int i=0; i<trafficCount; i++) {
+        mavlink_adsb_vehicle_t adsbVehicle = _adsbVehicle(i + 1, center.atDistanceAndAzimuth(i * 100, i));
+        store.update(adsbVehicle);
+    }
+    QCOMPARE(store.count(), trafficCount);
+    QCOMPARE(store.model()->count(), 0);
+
+    // All additions land in the model in one go
+    QTRY_COMPARE(store.model()->count(), trafficCount);
+    QCOMPARE(countSpy.count(), 1);
+
+    // Traffic added and removed within one batch never touches the model
+    countSpy.clear();
+    mavlink_adsb_vehicle_t adsbVehicle = _adsbVehicle(9999, center);
+    store.update(adsbVehicle);
+    adsbVehicle.tslc = ADSBTrafficStore::maxTimeSinceLastSeenSecs + 1;
+    store.update(adsbVehicle);
+    store.flushModel();
+    QCOMPARE(countSpy.count(), 0);
+    QCOMPARE(store.model()->count(), trafficCount);
+}
+
+void ADSBTrafficStoreTest::_testExpiration(void)
+{
+    // Ticks are driven directly, the store's own timer can't reach them while the test runs
+    ADSBTrafficStore store(10000 /* expirationMSecs */, 1000 /* tickMSecs */);
+    const quint32 expirationTicks = store._expirationTicks;
+    QGeoCoordinate coordinate(47.3977, 8.5456);
+
+    mavlink_adsb_vehicle_t staleVehicle = _adsbVehicle(1, coordinate);
+    mavlink_adsb_vehicle_t liveVehicle = _adsbVehicle(2, coordinate);
+    store.update(staleVehicle);
+    store.update(liveVehicle);
+    store.update(QStringLiteral("traffic1"), false, coordinate, 0);
+    QCOMPARE(store.count(), 3);
+
+    // Keep one vehicle updated past the expiration of the others
+    for (quint32 tick=1; tick<=expirationTicks * 2; tick++) {
+        store.update(liveVehicle);
+        store._advanceTo(tick);
+        QCOMPARE(store.count(), tick < expirationTicks ? 3 : 1);
+    }
+    store.flushModel();
+    QCOMPARE(store.model()->count(), 1);
+    QCOMPARE(store.model()->value<ADSBVehicle*>(0)->icaoAddress(), 2);
+
+    // Last updated one tick before the end of the loop
+    store._advanceTo((expirationTicks * 3) - 2);
+    QCOMPARE(store.count(), 1);
+    store._advanceTo((expirationTicks * 3) - 1);
+    QCOMPARE(store.count(), 0);
+
+    // Jumping many ticks at once, as after a stall, still expires everything which is due
+    store.update(liveVehicle);
+    store.update(staleVehicle);
+    QCOMPARE(store.count(), 2);
+    store._advanceTo(store._currentTick + (expirationTicks * 5) + 3);
+    QCOMPARE(store.count(), 0);
+}
+
+void ADSBTrafficStoreTest::_testProximityQuery(void)
+{
+    ADSBTrafficStore store;
+    QGeoCoordinate center(47.3977, 8.5456);
+
+    // Rings of traffic at increasing distance, spanning several index cells
+    const double distances[] = { 50000, 200, 5000, 1000, 20000 };
+    for (size_t i=0; i<sizeof(distances)/sizeof(distances[0]); i++) {
+        mavlink_adsb_vehicle_t adsbVehicle = _adsbVehicle(static_cast<uint32_t>(i + 1), center.atDistanceAndAzimuth(distances[i], i * 70.0));
+        store.update(adsbVehicle);
+    }
+
+    QList<ADSBVehicle*> vehicles = store.withinRadius(center, 6000);
+    QCOMPARE(vehicles.count(), 3);
+    QCOMPARE(vehicles[0]->icaoAddress(), 2);
+    QCOMPARE(vehicles[1]->icaoAddress(), 4);
+    QCOMPARE(vehicles[2]->icaoAddress(), 3);
+
+    vehicles = store.nearest(center, 2, 100000);
+    QCOMPARE(vehicles.count(), 2);
+    QCOMPARE(vehicles[0]->icaoAddress(), 2);
+    QCOMPARE(vehicles[1]->icaoAddress(), 4);
+
+    vehicles = store.withinRadius(center, 100000);
+    QCOMPARE(vehicles.count(), 5);
+    QCOMPARE(vehicles.last()->icaoAddress(), 1);
+
+    QCOMPARE(store.withinRadius(center, 100).count(), 0);
+    QCOMPARE(store.withinRadius(QGeoCoordinate(), 100000).count(), 0);
+}
+
+void ADSBTrafficStoreTest::_testAntimeridianQuery(void)
+{
+    ADSBTrafficStore store;
+
+    mavlink_adsb_vehicle_t adsbVehicle = _adsbVehicle(1, QGeoCoordinate(-16.5, 179.98));
+    store.update(adsbVehicle);
+    adsbVehicle = _adsbVehicle(2, QGeoCoordinate(-16.5, -179.98));
+    store.update(adsbVehicle);
+
+    // Both are within about 4.3km of each other across the antimeridian
+    QCOMPARE(store.withinRadius(QGeoCoordinate(-16.5, 179.99), 5000).count(), 2);
+    QCOMPARE(store.withinRadius(QGeoCoordinate(-16.5, -179.99), 5000).count(), 2);
+
+    // Close to the pole every longitude cell is searched
+    adsbVehicle = _adsbVehicle(3, QGeoCoordinate(89.99, 10));
+    store.update(adsbVehicle);
+    QCOMPARE(store.withinRadius(QGeoCoordinate(89.99, -170), 5000).count(), 1);
+}
@@ -0,0 +1,31 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+#include "QGCMAVLink.h"
+
+#include <QGeoCoordinate>
+
+/// Unit test for ADSBTrafficStore
+class ADSBTrafficStoreTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testAddUpdateRemove(void);
+    void _testModelBatching(void);
+    void _testExpiration(void);
+    void _testProximityQuery(void);
+    void _testAntimeridianQuery(void);
+
+private:
+    mavlink_adsb_vehicle_t _adsbVehicle(uint32_t icaoAddress, const QGeoCoordinate& coordinate, uint8_t tslc = 0);
+};
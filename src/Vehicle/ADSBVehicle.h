@@ -11,7 +11,6 @@
 
 #include <QObject>
 #include <QGeoCoordinate>
-#include <QElapsedTimer>
 
 #include "QGCMAVLink.h"
 
@@ -43,9 +42,6 @@ public:
 
     void update(bool alert, const QGeoCoordinate& location, float heading);
 
-    /// check if the vehicle is expired and should be removed
-    bool expired();
-
 signals:
     void coordinateChanged  ();
     void callsignChanged    ();
@@ -54,18 +50,10 @@ signals:
     void alertChanged       ();
 
 private:
-    /* According with Thomas Voß, we should be using 2 minutes for the time being
-    static constexpr qint64 expirationTimeoutMs = 5000; ///< timeout with no update in ms after which the vehicle is removed.
-                                                        ///< AirMap sends updates for each vehicle every second.
-    */
-    static constexpr qint64 expirationTimeoutMs = 120000;
-
     uint32_t        _icaoAddress;
     QString         _callsign;
     QGeoCoordinate  _coordinate;
     double          _altitude;
     double          _heading;
     bool            _alert;
-
-    QElapsedTimer   _lastUpdateTimer;
 };
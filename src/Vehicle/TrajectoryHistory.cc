@@ -0,0 +1,289 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TrajectoryHistory.h"
+
+#include <QPair>
+#include <QPointF>
+#include <QtMath>
+
+const double TrajectoryHistory::tolerancePixels = 1.0;
+
+TrajectoryHistory::TrajectoryHistory(int maxPoints, QObject* parent)
+    : QObject           (parent)
+    , _points           (qMax(2, maxPoints))
+    , _firstSequence    (0)
+    , _count            (0)
+    , _zoomLevel        (20)
+    , _simplifyZoomLevel(20)
+    , _pathDirty        (false)
+    , _stalePoints      (0)
+{
+
+}
+
+void TrajectoryHistory::setZoomLevel(double zoomLevel)
+{
+    if (zoomLevel == _zoomLevel) {
+        return;
+    }
+    _zoomLevel = zoomLevel;
+    emit zoomLevelChanged(_zoomLevel);
+
+    // Only whole zoom levels matter, otherwise pinch zooming would throw away the cache for every frame
+    int simplifyZoomLevel = qMax(0, static_cast<int>(floor(zoomLevel)));
+    if (simplifyZoomLevel != _simplifyZoomLevel) {
+        _simplifyZoomLevel = simplifyZoomLevel;
+        _chunkCache.clear();
+        _pathDirty = true;
+        emit pathChanged();
+    }
+}
+
+void TrajectoryHistory::setMaxPoints(int maxPoints)
+{
+    maxPoints = qMax(2, maxPoints);
+    if (maxPoints == _points.count()) {
+        return;
+    }
+
+    int keepCount = qMin(_count, maxPoints);
+    quint64 firstSequence = _firstSequence + static_cast<quint64>(_count - keepCount);
+
+    QVector<Point_t> points(maxPoints);
+    for (int i=0; i<keepCount; i++) {
+        quint64 sequence = firstSequence + static_cast<quint64>(i);
+        points[static_cast<int>(sequence % static_cast<quint64>(maxPoints))] = _point(sequence);
+    }
+
+    _points.swap(points);
+    _firstSequence = firstSequence;
+    _count = keepCount;
+    _chunkCache.clear();
+    _pathDirty = true;
+    emit pathChanged();
+}
+
+void TrajectoryHistory::append(const QGeoCoordinate& coordinate)
+{
+    if (!coordinate.isValid()) {
+        return;
+    }
+
+    bool rebuildPath = _pathDirty;
+
+    if (_count == _points.count()) {
+        // Drop the oldest point, the chunk it started is no longer complete
+        if (_firstSequence % chunkPoints == 0) {
+            _chunkCache.remove(_firstSequence / chunkPoints);
+        }
+        _firstSequence++;
+        _count--;
+
+        // Rebuilding for every dropped point would make each append O(n) once the ring is full
+        if (++_stalePoints >= maxStalePoints()) {
+            rebuildPath = true;
+        }
+    }
+
+    quint64 sequence = _firstSequence + static_cast<quint64>(_count);
+    Point_t& point = _points[static_cast<int>(sequence % static_cast<quint64>(_points.count()))];
+    point.lat = static_cast<qint32>(qRound64(coordinate.latitude() * 1e7));
+    point.lon = static_cast<qint32>(qRound64(coordinate.longitude() * 1e7));
+    _count++;
+
+    // The new point completes the tail chunk, which now needs to be simplified
+    if (sequence != _firstSequence && sequence % chunkPoints == 0) {
+        rebuildPath = true;
+    }
+
+    if (rebuildPath) {
+        _pathDirty = true;
+        emit pathChanged();
+    } else {
+        QGeoCoordinate pathCoordinate = _toCoordinate(point);
+        _path.append(QVariant::fromValue(pathCoordinate));
+        emit pointAdded(pathCoordinate);
+    }
+}
+
+void TrajectoryHistory::clear(void)
+{
+    _firstSequence = 0;
+    _count = 0;
+    _chunkCache.clear();
+    _pathDirty = true;
+    emit pathChanged();
+}
+
+QGeoCoordinate TrajectoryHistory::coordinate(int index) const
+{
+    if (index < 0 || index >= _count) {
+        return QGeoCoordinate();
+    }
+    return _toCoordinate(_point(_firstSequence + static_cast<quint64>(index)));
+}
+
+QGeoCoordinate TrajectoryHistory::_toCoordinate(const Point_t& point)
+{
+    return QGeoCoordinate(point.lat * 1e-7, point.lon * 1e-7);
+}
+
+double TrajectoryHistory::toleranceMeters(int zoomLevel, double latitude)
+{
+    // Ground resolution of a 256 pixel web mercator tile at zoom 0 at the equator
+    static const double metersPerPixelZoom0 = 156543.03392;
+
+    return tolerancePixels * metersPerPixelZoom0 * cos(qDegreesToRadians(latitude)) / pow(2.0, zoomLevel);
+}
+
+QVariantList TrajectoryHistory::path(void)
+{
+    if (_pathDirty) {
+        _updatePath();
+        _pathDirty = false;
+    }
+    return _path;
+}
+
+QList<QGeoCoordinate> TrajectoryHistory::simplifiedPath(void)
+{
+    QList<QGeoCoordinate> coordinates;
+
+    QVariantList pathList = path();
+    coordinates.reserve(pathList.count());
+    foreach (const QVariant& coordinate, pathList) {
+        coordinates.append(coordinate.value<QGeoCoordinate>());
+    }
+    return coordinates;
+}
+
+void TrajectoryHistory::_updatePath(void)
+{
+    _path.clear();
+    _stalePoints = 0;
+
+    if (_count == 0) {
+        return;
+    }
+    if (_count == 1) {
+        _path.append(QVariant::fromValue(_toCoordinate(_point(_firstSequence))));
+        return;
+    }
+
+    // Chunk n covers sequence numbers n*chunkPoints through (n+1)*chunkPoints, sharing its last point with the next chunk.
+    // Only chunks which are complete at the end are simplified, the tail is added as is so append can extend it.
+    quint64 lastSequence = _firstSequence + static_cast<quint64>(_count) - 1;
+    for (quint64 chunk=_firstSequence / chunkPoints; (chunk + 1) * chunkPoints <= lastSequence; chunk++) {
+        quint64 chunkFirstSequence = chunk * chunkPoints;
+        quint64 chunkLastSequence = chunkFirstSequence + chunkPoints;
+
+        QVector<Point_t> simplified;
+        if (chunkFirstSequence >= _firstSequence && chunkLastSequence <= lastSequence) {
+            QHash<quint64, QVector<Point_t>>::const_iterator it = _chunkCache.constFind(chunk);
+            if (it == _chunkCache.constEnd()) {
+                it = _chunkCache.insert(chunk, _simplify(chunkFirstSequence, chunkLastSequence));
+            }
+            simplified = it.value();
+        } else {
+            simplified = _simplify(qMax(chunkFirstSequence, _firstSequence), qMin(chunkLastSequence, lastSequence));
+        }
+
+        for (int i=_path.isEmpty() ? 0 : 1; i<simplified.count(); i++) {
+            _path.append(QVariant::fromValue(_toCoordinate(simplified[i])));
+        }
+    }
+
+    quint64 tailFirstSequence = qMax((lastSequence / chunkPoints) * chunkPoints, _firstSequence);
+    for (quint64 sequence=_path.isEmpty() ? tailFirstSequence : tailFirstSequence + 1; sequence<=lastSequence; sequence++) {
+        _path.append(QVariant::fromValue(_toCoordinate(_point(sequence))));
+    }
+}
+
+/// Douglas-Peucker simplification of the points from firstSequence through lastSequence
+QVector<TrajectoryHistory::Point_t> TrajectoryHistory::_simplify(quint64 firstSequence, quint64 lastSequence) const
+{
+    static const double metersPerDegree = 111320.0;
+
+    int pointCount = static_cast<int>(lastSequence - firstSequence) + 1;
+    QVector<Point_t> simplified;
+
+    if (pointCount <= 2) {
+        for (int i=0; i<pointCount; i++) {
+            simplified.append(_point(firstSequence + static_cast<quint64>(i)));
+        }
+        return simplified;
+    }
+
+    // A local plane around the first point is plenty accurate over the span of a chunk
+    const Point_t& origin = _point(firstSequence);
+    double latScale = metersPerDegree * 1e-7;
+    double lonScale = latScale * cos(qDegreesToRadians(origin.lat * 1e-7));
+
+    QVector<QPointF> plane(pointCount);
+    for (int i=0; i<pointCount; i++) {
+        const Point_t& point = _point(firstSequence + static_cast<quint64>(i));
+        qint64 lonDelta = static_cast<qint64>(point.lon) - origin.lon;
+        if (lonDelta > 1800000000LL) {
+            lonDelta -= 3600000000LL;
+        } else if (lonDelta < -1800000000LL) {
+            lonDelta += 3600000000LL;
+        }
+        plane[i] = QPointF(lonDelta * lonScale, (static_cast<qint64>(point.lat) - origin.lat) * latScale);
+    }
+
+    double tolerance = toleranceMeters(_simplifyZoomLevel, origin.lat * 1e-7);
+    double toleranceSquared = tolerance * tolerance;
+
+    QVector<bool> keep(pointCount, false);
+    keep[0] = true;
+    keep[pointCount - 1] = true;
+
+    // Explicit stack instead of recursion, a straight flight can split one point at a time
+    QVector<QPair<int, int>> ranges;
+    ranges.append(qMakePair(0, pointCount - 1));
+    while (!ranges.isEmpty()) {
+        QPair<int, int> range = ranges.takeLast();
+
+        const QPointF& start = plane[range.first];
+        double dx = plane[range.second].x() - start.x();
+        double dy = plane[range.second].y() - start.y();
+        double lengthSquared = (dx * dx) + (dy * dy);
+
+        int farthestIndex = -1;
+        double farthestSquared = toleranceSquared;
+        for (int i=range.first + 1; i<range.second; i++) {
+            double px = plane[i].x() - start.x();
+            double py = plane[i].y() - start.y();
+
+            // Distance to the segment rather than the line, so out and back legs keep their turn point
+            double t = lengthSquared > 0 ? qBound(0.0, ((px * dx) + (py * dy)) / lengthSquared, 1.0) : 0;
+            double ex = px - (t * dx);
+            double ey = py - (t * dy);
+            double distanceSquared = (ex * ex) + (ey * ey);
+            if (distanceSquared > farthestSquared) {
+                farthestSquared = distanceSquared;
+                farthestIndex = i;
+            }
+        }
+
+        if (farthestIndex != -1) {
+            keep[farthestIndex] = true;
+            ranges.append(qMakePair(range.first, farthestIndex));
+            ranges.append(qMakePair(farthestIndex, range.second));
+        }
+    }
+
+    for (int i=0; i<pointCount; i++) {
+        if (keep[i]) {
+            simplified.append(_point(firstSequence + static_cast<quint64>(i)));
+        }
+    }
+    return simplified;
+}
@@ -0,0 +1,100 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QVariantList>
+#include <QGeoCoordinate>
+
+/// Flight path of a vehicle for display on the map.
+///
+/// Points are kept in a fixed size ring buffer of packed 1e-7 degree coordinates, so hours of history cost a few
+/// hundred kilobytes. The path shown on the map is simplified with Douglas-Peucker to what is visible at the current
+/// zoom level. Simplification is done in fixed size chunks and completed chunks are cached.
+///
+/// The newest, still incomplete chunk is shown unsimplified so new points can be added to the end of the map polyline
+/// through pointAdded. The whole path is only rebuilt through pathChanged when a chunk completes, when the oldest points
+/// have been dropped from the ring or when the zoom level changes. Until then the path can still start with up to
+/// maxStalePoints() points which have already been dropped.
+class TrajectoryHistory : public QObject
+{
+    Q_OBJECT
+
+public:
+    ///     @param maxPoints Number of points kept, older points are dropped
+    TrajectoryHistory(int maxPoints = defaultMaxPoints, QObject* parent = NULL);
+
+    Q_PROPERTY(QVariantList path        READ path                           NOTIFY pathChanged)         ///< Simplified path for a MapPolyline
+    Q_PROPERTY(double       zoomLevel   READ zoomLevel  WRITE setZoomLevel  NOTIFY zoomLevelChanged)    ///< Map zoom level the path is simplified for
+
+    QVariantList    path        (void);
+    double          zoomLevel   (void) const { return _zoomLevel; }
+    void            setZoomLevel(double zoomLevel);
+
+    /// @return Simplified path as coordinates
+    QList<QGeoCoordinate> simplifiedPath(void);
+
+    int     count       (void) const { return _count; }
+    int     maxPoints   (void) const { return _points.count(); }
+
+    /// @return Number of dropped points which are let to pile up at the start of the path before it is rebuilt
+    int     maxStalePoints(void) const { return qBound(1, _points.count() / 16, static_cast<int>(chunkPoints)); }
+
+    /// Changes the number of points kept, the newest points are preserved
+    void setMaxPoints(int maxPoints);
+
+    /// Adds a point to the end of the path. Invalid coordinates are ignored.
+    void append(const QGeoCoordinate& coordinate);
+
+    void clear(void);
+
+    /// @return Point at index, 0 is the oldest
+    QGeoCoordinate coordinate(int index) const;
+
+    /// @return Distance in meters below which path detail isn't visible
+    static double toleranceMeters(int zoomLevel, double latitude);
+
+    static const int    defaultMaxPoints =  3 * 60;     ///< Three minutes at one point per second
+    static const int    chunkPoints =       256;        ///< Points simplified together
+    static const double tolerancePixels;
+
+signals:
+    /// The path needs to be rebuilt from scratch
+    void pathChanged        (void);
+
+    /// A point was added to the end of the path without anything else changing
+    void pointAdded         (const QGeoCoordinate& coordinate);
+
+    void zoomLevelChanged   (double zoomLevel);
+
+private:
+    typedef struct {
+        qint32 lat;     ///< Degrees * 1e7
+        qint32 lon;     ///< Degrees * 1e7
+    } Point_t;
+
+    const Point_t&      _point          (quint64 sequence) const { return _points[static_cast<int>(sequence % static_cast<quint64>(_points.count()))]; }
+    QVector<Point_t>    _simplify       (quint64 firstSequence, quint64 lastSequence) const;
+    void                _updatePath     (void);
+
+    static QGeoCoordinate _toCoordinate(const Point_t& point);
+
+    QVector<Point_t>                    _points;
+    quint64                             _firstSequence;     ///< Sequence number of the oldest point
+    int                                 _count;
+    double                              _zoomLevel;
+    int                                 _simplifyZoomLevel; ///< Whole zoom level the chunk cache was built for
+    QHash<quint64, QVector<Point_t>>    _chunkCache;        ///< Chunk index to simplified points of completed chunks
+    QVariantList                        _path;
+    bool                                _pathDirty;
+    int                                 _stalePoints;       ///< Points dropped from the ring which are still in _path
+};
@@ -0,0 +1,230 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TrajectoryHistoryTest.h"
+#include "TrajectoryHistory.h"
+
+#include <QSignalSpy>
+
+static const QGeoCoordinate _baseCoordinate(47.3977, 8.5456);
+
+/// Flight north with every other point offset to the east
+static QGeoCoordinate _zigZagCoordinate(int index)
+{
+    QGeoCoordinate coordinate = _baseCoordinate.atDistanceAndAzimuth(index * 20.0, 0);
+    return index & 1 ? coordinate.atDistanceAndAzimuth(10, 90) : coordinate;
+}
+
+void TrajectoryHistoryTest::_testRingBuffer(void)
+{
+    TrajectoryHistory history(10);
+
+    for (int i=0; i<25; i++) {
+        history.append(_baseCoordinate.atDistanceAndAzimuth(i * 10.0, 0));
+    }
+    QCOMPARE(history.count(), 10);
+    QVERIFY(history.coordinate(0).distanceTo(_baseCoordinate.atDistanceAndAzimuth(150, 0)) < 0.05);
+    QVERIFY(history.coordinate(9).distanceTo(_baseCoordinate.atDistanceAndAzimuth(240, 0)) < 0.05);
+    QVERIFY(!history.coordinate(10).isValid());
+
+    history.append(QGeoCoordinate());
+    QCOMPARE(history.count(), 10);
+
+    history.clear();
+    QCOMPARE(history.count(), 0);
+    QCOMPARE(history.path().count(), 0);
+}
+
+void TrajectoryHistoryTest::_testSetMaxPoints(void)
+{
+    TrajectoryHistory history(100);
+
+    for (int i=0; i<50; i++) {
+        history.append(_zigZagCoordinate(i));
+    }
+
+    // Shrinking keeps the newest points
+    history.setMaxPoints(20);
+    QCOMPARE(history.maxPoints(), 20);
+    QCOMPARE(history.count(), 20);
+    QVERIFY(history.coordinate(0).distanceTo(_zigZagCoordinate(30)) < 0.05);
+    QVERIFY(history.coordinate(19).distanceTo(_zigZagCoordinate(49)) < 0.05);
+
+    // Growing keeps everything
+    history.setMaxPoints(200);
+    QCOMPARE(history.count(), 20);
+    QVERIFY(history.coordinate(0).distanceTo(_zigZagCoordinate(30)) < 0.05);
+    for (int i=50; i<150; i++) {
+        history.append(_zigZagCoordinate(i));
+    }
+    QCOMPARE(history.count(), 120);
+    QVERIFY(history.coordinate(119).distanceTo(_zigZagCoordinate(149)) < 0.05);
+}
+
+void TrajectoryHistoryTest::_testSimplifyStraightLine(void)
+{
+    // Ends on a chunk boundary, an incomplete tail chunk isn't simplified
+    const int pointCount = (4 * TrajectoryHistory::chunkPoints) + 1;
+
+    TrajectoryHistory history(pointCount);
+    history.setZoomLevel(16);
+
+    for (int i=0; i<pointCount; i++) {
+        history.append(_baseCoordinate.atDistanceAndAzimuth(i * 10.0, 45));
+    }
+
+    // Each chunk collapses to its end points
+    QList<QGeoCoordinate> path = history.simplifiedPath();
+    QVERIFY(path.count() >= 2);
+    QVERIFY(path.count() <= (pointCount / TrajectoryHistory::chunkPoints) + 2);
+    QVERIFY(path.first().distanceTo(history.coordinate(0)) < 0.01);
+    QVERIFY(path.last().distanceTo(history.coordinate(pointCount - 1)) < 0.01);
+}
+
+void TrajectoryHistoryTest::_testSimplifyByZoom(void)
+{
+    const int pointCount = TrajectoryHistory::chunkPoints + 1;
+
+    TrajectoryHistory history(pointCount);
+    for (int i=0; i<pointCount; i++) {
+        history.append(_zigZagCoordinate(i));
+    }
+
+    // Zoomed in every turn is visible
+    history.setZoomLevel(20);
+    QCOMPARE(history.path().count(), pointCount);
+
+    // Zoomed out the whole flight is a few pixels
+    history.setZoomLevel(5);
+    QCOMPARE(history.path().count(), 2);
+
+    QVERIFY(TrajectoryHistory::toleranceMeters(10, 0) > TrajectoryHistory::toleranceMeters(11, 0));
+    QVERIFY(TrajectoryHistory::toleranceMeters(10, 60) < TrajectoryHistory::toleranceMeters(10, 0));
+}
+
+void TrajectoryHistoryTest::_testChunkJoins(void)
+{
+    const int maxPoints = 600;
+
+    // Wrap the ring so the oldest point isn't on a chunk boundary
+    TrajectoryHistory history(maxPoints);
+    for (int i=0; i<1000; i++) {
+        history.append(_zigZagCoordinate(i));
+    }
+    QCOMPARE(history.count(), maxPoints);
+
+    QList<QGeoCoordinate> path = history.simplifiedPath();
+    QCOMPARE(path.count(), maxPoints);
+    for (int i=0; i<maxPoints; i++) {
+        QVERIFY(path[i].distanceTo(history.coordinate(i)) < 0.01);
+    }
+
+    // Cached chunks are dropped as the oldest points go away, the path may lag behind by a few dropped points
+    for (int i=1000; i<1000 + TrajectoryHistory::chunkPoints + 1; i++) {
+        history.append(_zigZagCoordinate(i));
+
+        path = history.simplifiedPath();
+        int stalePoints = path.count() - maxPoints;
+        QVERIFY(stalePoints >= 0 && stalePoints < history.maxStalePoints());
+        QVERIFY(path[stalePoints].distanceTo(history.coordinate(0)) < 0.01);
+        QVERIFY(path.last().distanceTo(history.coordinate(maxPoints - 1)) < 0.01);
+    }
+}
+
+void TrajectoryHistoryTest::_testZoomLevelSignals(void)
+{
+    TrajectoryHistory history;
+    QSignalSpy pathSpy(&history, &TrajectoryHistory::pathChanged);
+    QSignalSpy zoomSpy(&history, &TrajectoryHistory::zoomLevelChanged);
+
+    history.setZoomLevel(10.2);
+    QCOMPARE(zoomSpy.count(), 1);
+    QCOMPARE(pathSpy.count(), 1);
+
+    // Fractional zoom changes don't change the simplification
+    history.setZoomLevel(10.7);
+    QCOMPARE(zoomSpy.count(), 2);
+    QCOMPARE(pathSpy.count(), 1);
+
+    history.setZoomLevel(11);
+    QCOMPARE(pathSpy.count(), 2);
+
+    history.append(_baseCoordinate);
+    QCOMPARE(pathSpy.count(), 3);
+}
+
+void TrajectoryHistoryTest::_testIncrementalAppend(void)
+{
+    qRegisterMetaType<QGeoCoordinate>();
+
+    TrajectoryHistory history(1000);
+    TrajectoryHistory rebuilt(1000);
+    QSignalSpy pathSpy(&history, &TrajectoryHistory::pathChanged);
+    QSignalSpy pointSpy(&history, &TrajectoryHistory::pointAdded);
+
+    // Points in the tail chunk are only added to the end of the path
+    for (int i=0; i<TrajectoryHistory::chunkPoints; i++) {
+        history.append(_zigZagCoordinate(i));
+        rebuilt.append(_zigZagCoordinate(i));
+    }
+    QCOMPARE(pathSpy.count(), 0);
+    QCOMPARE(pointSpy.count(), TrajectoryHistory::chunkPoints);
+    QVERIFY(pointSpy.last()[0].value<QGeoCoordinate>().distanceTo(_zigZagCoordinate(TrajectoryHistory::chunkPoints - 1)) < 0.01);
+
+    // Completing the chunk rebuilds the path so it can be simplified
+    history.append(_zigZagCoordinate(TrajectoryHistory::chunkPoints));
+    rebuilt.append(_zigZagCoordinate(TrajectoryHistory::chunkPoints));
+    QCOMPARE(pathSpy.count(), 1);
+    QCOMPARE(pointSpy.count(), TrajectoryHistory::chunkPoints);
+
+    history.path();
+    pathSpy.clear();
+    history.append(_zigZagCoordinate(TrajectoryHistory::chunkPoints + 1));
+    rebuilt.append(_zigZagCoordinate(TrajectoryHistory::chunkPoints + 1));
+    QCOMPARE(pathSpy.count(), 0);
+    QCOMPARE(pointSpy.count(), TrajectoryHistory::chunkPoints + 1);
+
+    // The path built up by appending matches one built from scratch
+    QList<QGeoCoordinate> appendedPath = history.simplifiedPath();
+    // Nothing has read the path of rebuilt yet, so it is built from scratch here
+    QList<QGeoCoordinate> rebuiltPath = rebuilt.simplifiedPath();
+    QCOMPARE(appendedPath.count(), rebuiltPath.count());
+    for (int i=0; i<appendedPath.count(); i++) {
+        QVERIFY(appendedPath[i].distanceTo(rebuiltPath[i]) < 0.01);
+    }
+}
+
+void TrajectoryHistoryTest::_testIncrementalWrap(void)
+{
+    const int maxPoints = 64;
+
+    TrajectoryHistory history(maxPoints);
+    for (int i=0; i<maxPoints; i++) {
+        history.append(_zigZagCoordinate(i));
+    }
+    history.path();
+
+    QSignalSpy pathSpy(&history, &TrajectoryHistory::pathChanged);
+    QSignalSpy pointSpy(&history, &TrajectoryHistory::pointAdded);
+
+    // Dropped points pile up at the start of the path until there are enough to be worth a rebuild
+    int staleLimit = history.maxStalePoints();
+    for (int i=0; i<staleLimit - 1; i++) {
+        history.append(_zigZagCoordinate(maxPoints + i));
+    }
+    QCOMPARE(pathSpy.count(), 0);
+    QCOMPARE(pointSpy.count(), staleLimit - 1);
+    QCOMPARE(history.path().count(), maxPoints + staleLimit - 1);
+
+    history.append(_zigZagCoordinate(maxPoints + staleLimit - 1));
+    QCOMPARE(pathSpy.count(), 1);
+    QList<QGeoCoordinate> path = history.simplifiedPath();
+    QCOMPARE(path.count(), maxPoints);
+    QVERIFY(path.first().distanceTo(history.coordinate(0)) < 0.01);
+}
@@ -0,0 +1,28 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+/// Unit test for TrajectoryHistory
+class TrajectoryHistoryTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testRingBuffer(void);
+    void _testSetMaxPoints(void);
+    void _testSimplifyStraightLine(void);
+    void _testSimplifyByZoom(void);
+    void _testChunkJoins(void);
+    void _testZoomLevelSignals(void);
+    void _testIncrementalAppend(void);
+    void _testIncrementalWrap(void);
+};
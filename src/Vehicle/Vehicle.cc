@@ -24,7 +24,6 @@
 #include "PlanMasterController.h"
 #include "GeoFenceManager.h"
 #include "RallyPointManager.h"
-#include "CoordinateVector.h"
 #include "ParameterManager.h"
 #include "QGCApplication.h"
 #include "QGCImageProvider.h"
@@ -276,13 +275,13 @@ Vehicle::Vehicle(LinkInterface*             link,
     _mapTrajectoryTimer.setInterval(_mapTrajectoryMsecsBetweenPoints);
     connect(&_mapTrajectoryTimer, &QTimer::timeout, this, &Vehicle::_addNewMapTrajectoryPoint);
 
+    Fact* trajectoryHistoryLengthFact = _settingsManager->flightMapSettings()->trajectoryHistoryLength();
+    _trajectoryHistoryLengthChanged(trajectoryHistoryLengthFact->rawValue());
+    connect(trajectoryHistoryLengthFact, &Fact::rawValueChanged, this, &Vehicle::_trajectoryHistoryLengthChanged);
+
     // Create camera manager instance
     _cameras = _firmwarePlugin->createCameraManager(this);
     emit dynamicCamerasChanged();
-
-    connect(&_adsbTimer, &QTimer::timeout, this, &Vehicle::_adsbTimerTimeout);
-    _adsbTimer.setSingleShot(false);
-    _adsbTimer.start(1000);
 }
 
 // Disconnected Vehicle for offline editing
@@ -1799,7 +1798,12 @@ bool Vehicle::sendMessageOnLink(LinkInterface* link, mavlink_message_t message)
         return false;
     }
 
-    emit _sendMessageOnLinkOnThread(link, message);
+    if (QThread::currentThread() == thread()) {
+        // The link send queue is thread safe, so there is no need to bounce the message through the event loop
+        _sendMessageOnLink(link, message);
+    } else {
+        emit _sendMessageOnLinkOnThread(link, message);
+    }
 
     return true;
 }
@@ -1820,11 +1824,8 @@ void Vehicle::_sendMessageOnLink(LinkInterface* link, mavlink_message_t message)
     // Give the plugin a chance to adjust
     _firmwarePlugin->adjustOutgoingMavlinkMessage(this, link, &message);
 
-    // Write message into buffer, prepending start sign
-    uint8_t buffer[MAVLINK_MAX_PACKET_LEN];
-    int len = mavlink_msg_to_send_buffer(buffer, &message);
-
-    link->writeBytesSafe((const char*)buffer, len);
+    // Serialized straight into the link send queue
+    link->writeMessageSafe(message);
     _messagesSent++;
     emit messagesSentChanged();
 }
@@ -2377,15 +2378,9 @@ void Vehicle::_rallyPointManagerError(int errorCode, const QString& errorMsg)
 void Vehicle::_addNewMapTrajectoryPoint(void)
 {
     if (_mapTrajectoryHaveFirstCoordinate) {
-        // Keep three minutes of trajectory on mobile due to perf impact of lines
-#ifdef __mobile__
-        if (_mapTrajectoryList.count() * _mapTrajectoryMsecsBetweenPoints > 3 * 1000 * 60) {
-            _mapTrajectoryList.removeAt(0)->deleteLater();
-        }
-#endif
-        _mapTrajectoryList.append(new CoordinateVector(_mapTrajectoryLastCoordinate, _coordinate, this));
         _flightDistanceFact.setRawValue(_flightDistanceFact.rawValue().toDouble() + _mapTrajectoryLastCoordinate.distanceTo(_coordinate));
     }
+    _trajectory.append(_coordinate);
     _mapTrajectoryHaveFirstCoordinate = true;
     _mapTrajectoryLastCoordinate = _coordinate;
     _flightTimeFact.setRawValue((double)_flightTimer.elapsed() / 1000.0);
@@ -2393,7 +2388,7 @@ void Vehicle::_addNewMapTrajectoryPoint(void)
 
 void Vehicle::_clearTrajectoryPoints(void)
 {
-    _mapTrajectoryList.clearAndDeleteContents();
+    _trajectory.clear();
 }
 
 void Vehicle::_clearCameraTriggerPoints(void)
@@ -2416,6 +2411,11 @@ void Vehicle::_mapTrajectoryStop()
     _mapTrajectoryTimer.stop();
 }
 
+void Vehicle::_trajectoryHistoryLengthChanged(QVariant value)
+{
+    _trajectory.setMaxPoints((value.toInt() * 60 * 1000) / _mapTrajectoryMsecsBetweenPoints);
+}
+
 void Vehicle::_startPlanRequest(void)
 {
     if (_missionManagerInitialRequestSent) {
@@ -3528,25 +3528,9 @@ bool Vehicle::autoDisarm(void)
 void Vehicle::_handleADSBVehicle(const mavlink_message_t& message)
 {
     mavlink_adsb_vehicle_t adsbVehicle;
-    static const int maxTimeSinceLastSeen = 15;
 
     mavlink_msg_adsb_vehicle_decode(&message, &adsbVehicle);
-    if (adsbVehicle.flags | ADSB_FLAGS_VALID_COORDS) {
-        if (_adsbICAOMap.contains(adsbVehicle.ICAO_address)) {
-            if (adsbVehicle.tslc > maxTimeSinceLastSeen) {
-                ADSBVehicle* vehicle = _adsbICAOMap[adsbVehicle.ICAO_address];
-                _adsbVehicles.removeOne(vehicle);
-                _adsbICAOMap.remove(adsbVehicle.ICAO_address);
-                vehicle->deleteLater();
-            } else {
-                _adsbICAOMap[adsbVehicle.ICAO_address]->update(adsbVehicle);
-            }
-        } else if (adsbVehicle.tslc <= maxTimeSinceLastSeen) {
-            ADSBVehicle* vehicle = new ADSBVehicle(adsbVehicle, this);
-            _adsbICAOMap[adsbVehicle.ICAO_address] = vehicle;
-            _adsbVehicles.append(vehicle);
-        }
-    }
+    _adsbTraffic.update(adsbVehicle);
 }
 
 void Vehicle::_updateDistanceToHome(void)
@@ -3629,28 +3613,7 @@ void Vehicle::_trafficUpdate(bool alert, QString traffic_id, QString vehicle_id,
     Q_UNUSED(vehicle_id);
     // qDebug() << "traffic update:" << traffic_id << vehicle_id << heading << location;
     // TODO: filter based on minimum altitude?
-    if (_trafficVehicleMap.contains(traffic_id)) {
-        _trafficVehicleMap[traffic_id]->update(alert, location, heading);
-    } else {
-        ADSBVehicle* vehicle = new ADSBVehicle(location, heading, alert, this);
-        _trafficVehicleMap[traffic_id] = vehicle;
-        _adsbVehicles.append(vehicle);
-    }
-
-}
-void Vehicle::_adsbTimerTimeout()
-{
-    // TODO: take into account _adsbICAOMap as well? Needs to be tested, especially the timeout
-
-    for (auto it = _trafficVehicleMap.begin(); it != _trafficVehicleMap.end();) {
-        if (it.value()->expired()) {
-            _adsbVehicles.removeOne(it.value());
-            delete it.value();
-            it = _trafficVehicleMap.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    _adsbTraffic.update(traffic_id, alert, location, heading);
 }
 
 void Vehicle::_mavlinkMessageStatus(int uasId, uint64_t totalSent, uint64_t totalReceived, uint64_t totalLoss, float lossPercent)
@@ -3802,14 +3765,15 @@ VehicleClockFactGroup::VehicleClockFactGroup(QObject* parent)
     // Start out as not available "--.--"
     _currentTimeFact.setRawValue    (std::numeric_limits<float>::quiet_NaN());
     _currentDateFact.setRawValue    (std::numeric_limits<float>::quiet_NaN());
+
+    connect(&_clockTimer, &QTimer::timeout, this, &VehicleClockFactGroup::_updateClock);
+    _clockTimer.start(_updateRateMSecs);
 }
 
-void VehicleClockFactGroup::_updateAllValues(void)
+void VehicleClockFactGroup::_updateClock(void)
 {
     _currentTimeFact.setRawValue(QTime::currentTime().toString());
     _currentDateFact.setRawValue(QDateTime::currentDateTime().toString(QLocale::system().dateFormat(QLocale::ShortFormat)));
-
-    FactGroup::_updateAllValues();
 }
 
 const char* VehicleSetpointFactGroup::_rollFactName =       "roll";
@@ -12,6 +12,7 @@
 #include <QObject>
 #include <QVariantList>
 #include <QGeoCoordinate>
+#include <QTimer>
 
 #include "FactGroup.h"
 #include "LinkInterface.h"
@@ -20,6 +21,8 @@
 #include "MAVLinkProtocol.h"
 #include "UASMessageHandler.h"
 #include "SettingsFact.h"
+#include "ADSBTrafficStore.h"
+#include "TrajectoryHistory.h"
 
 class UAS;
 class UASInterface;
@@ -351,11 +354,12 @@ public:
     static const char* _settingsGroup;
 
 private slots:
-    void _updateAllValues(void) override;
+    void _updateClock(void);
 
 private:
     Fact            _currentTimeFact;
     Fact            _currentDateFact;
+    QTimer          _clockTimer;
 };
 
 class VehicleEstimatorStatusFactGroup : public FactGroup
@@ -545,7 +549,7 @@ public:
     Q_PROPERTY(QStringList          flightModes             READ flightModes                                            NOTIFY flightModesChanged)
     Q_PROPERTY(QString              flightMode              READ flightMode             WRITE setFlightMode             NOTIFY flightModeChanged)
     Q_PROPERTY(bool                 hilMode                 READ hilMode                WRITE setHilMode                NOTIFY hilModeChanged)
-    Q_PROPERTY(QmlObjectListModel*  trajectoryPoints        READ trajectoryPoints                                       CONSTANT)
+    Q_PROPERTY(TrajectoryHistory*   trajectory              READ trajectory                                             CONSTANT)
     Q_PROPERTY(QmlObjectListModel*  cameraTriggerPoints     READ cameraTriggerPoints                                    CONSTANT)
     Q_PROPERTY(float                latitude                READ latitude                                               NOTIFY coordinateChanged)
     Q_PROPERTY(float                longitude               READ longitude                                              NOTIFY coordinateChanged)
@@ -852,9 +856,12 @@ public:
     QString prearmError(void) const { return _prearmError; }
     void setPrearmError(const QString& prearmError);
 
-    QmlObjectListModel* trajectoryPoints(void) { return &_mapTrajectoryList; }
+    TrajectoryHistory*  trajectory(void) { return &_trajectory; }
     QmlObjectListModel* cameraTriggerPoints(void) { return &_cameraTriggerPoints; }
-    QmlObjectListModel* adsbVehicles(void) { return &_adsbVehicles; }
+    QmlObjectListModel* adsbVehicles(void) { return _adsbTraffic.model(); }
+
+    /// Air traffic around the vehicle, supports proximity queries for collision alerts
+    ADSBTrafficStore* adsbTraffic(void) { return &_adsbTraffic; }
 
     int  flowImageIndex() { return _flowImageIndex; }
 
@@ -1175,6 +1182,7 @@ private slots:
     void _offlineVehicleTypeSettingChanged(QVariant value);
     void _offlineCruiseSpeedSettingChanged(QVariant value);
     void _offlineHoverSpeedSettingChanged(QVariant value);
+    void _trajectoryHistoryLengthChanged(QVariant value);
     void _updateHighLatencyLink(bool sendCommand = true);
 
     void _handleTextMessage                 (int newCount);
@@ -1195,7 +1203,6 @@ private slots:
     void _mavlinkMessageStatus(int uasId, uint64_t totalSent, uint64_t totalReceived, uint64_t totalLoss, float lossPercent);
 
     void _trafficUpdate         (bool alert, QString traffic_id, QString vehicle_id, QGeoCoordinate location, float heading);
-    void _adsbTimerTimeout      ();
 
 private:
     bool _containsLink(LinkInterface* link);
@@ -1385,17 +1392,14 @@ private:
 
     QTime               _flightTimer;
     QTimer              _mapTrajectoryTimer;
-    QmlObjectListModel  _mapTrajectoryList;
+    TrajectoryHistory   _trajectory;
     QGeoCoordinate      _mapTrajectoryLastCoordinate;
     bool                _mapTrajectoryHaveFirstCoordinate;
     static const int    _mapTrajectoryMsecsBetweenPoints = 1000;
 
     QmlObjectListModel  _cameraTriggerPoints;
 
-    QmlObjectListModel              _adsbVehicles;
-    QMap<uint32_t, ADSBVehicle*>    _adsbICAOMap;
-    QMap<QString, ADSBVehicle*>     _trafficVehicleMap;
-    QTimer                          _adsbTimer;
+    ADSBTrafficStore                _adsbTraffic;
 
     // Toolbox references
     FirmwarePluginManager*      _firmwarePluginManager;
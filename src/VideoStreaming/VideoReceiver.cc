@@ -45,6 +45,9 @@ static const char* kVideoMuxes[] =
 
 #define NUM_MUXES (sizeof(kVideoMuxes) / sizeof(char*))
 
+// Anything longer is a clock jump (recording resets the base time), not a real measurement
+static const qint64 kMaxLatencyUSecs = 10 * 1000 * 1000;
+
 #endif
 
 
@@ -64,12 +67,21 @@ VideoReceiver::VideoReceiver(QObject* parent)
     , _socket(NULL)
     , _serverPresent(false)
     , _rtspTestInterval_ms(5000)
+    , _lowLatency(false)
+    , _latencyProbeId(0)
 #endif
     , _videoSurface(NULL)
     , _videoRunning(false)
     , _showFullScreen(false)
     , _videoSettings(NULL)
+    , _latencyFact(0, "latency", FactMetaData::valueTypeDouble)
 {
+    FactMetaData* latencyMetaData = new FactMetaData(FactMetaData::valueTypeDouble, "latency", this);
+    latencyMetaData->setShortDescription(tr("Video latency"));
+    latencyMetaData->setRawUnits("ms");
+    latencyMetaData->setDecimalPlaces(0);
+    _latencyFact.setMetaData(latencyMetaData);
+
     _videoSurface = new VideoSurface;
     _videoSettings = qgcApp()->toolbox()->settingsManager()->videoSettings();
 #if defined(QGC_GST_STREAMING)
@@ -114,6 +126,15 @@ VideoReceiver::_setVideoSink(GstElement* sink)
 }
 #endif
 
+//-----------------------------------------------------------------------------
+#if defined(QGC_GST_STREAMING)
+static bool
+hasProperty(GstElement* element, const char* name)
+{
+    return g_object_class_find_property(G_OBJECT_GET_CLASS(element), name) != NULL;
+}
+#endif
+
 //-----------------------------------------------------------------------------
 void
 VideoReceiver::grabImage(QString imageFile)
@@ -200,10 +221,40 @@ VideoReceiver::_timeout()
 }
 #endif
 
+//-----------------------------------------------------------------------------
+// Low latency profile, trades smooth playback for latency:
+// -Decoded frames go through a one frame leaky queue, a display which falls behind drops stale frames instead of
+//  queueing them. The queue in front of the decoder stays lossless, dropping coded frames would corrupt the picture
+//  until the next keyframe.
+// -Slice threading in the decoder. Frame threading holds back one frame per decoder thread.
+// -The RTSP jitter buffer doesn't hold packets back.
+// -The sink shows frames as soon as they are decoded instead of waiting for their timestamp, see start().
+#if defined(QGC_GST_STREAMING)
+void
+VideoReceiver::_configureLowLatency(GstElement* dataSource, GstElement* decoder, GstElement* queue1)
+{
+    g_object_set(G_OBJECT(queue1),
+                 "leaky",               2,      // downstream, drop the oldest frame
+                 "max-size-buffers",    1,
+                 "max-size-bytes",      0,
+                 "max-size-time",       static_cast<guint64>(0),
+                 NULL);
+
+    // Older avdec_h264 has no thread-type, but already picks slice threading for live sources
+    if(hasProperty(decoder, "thread-type")) {
+        g_object_set(G_OBJECT(decoder), "thread-type", 2 /* slice */, NULL);
+    }
+
+    if(hasProperty(dataSource, "drop-on-latency")) {
+        g_object_set(G_OBJECT(dataSource), "latency", 0, "drop-on-latency", TRUE, NULL);
+    }
+}
+#endif
+
 //-----------------------------------------------------------------------------
 // When we finish our pipeline will look like this:
 //
-//                                   +-->queue-->decoder-->_videosink
+//                                   +-->queue-->decoder-->queue1-->_videosink
 //                                   |
 //    datasource-->demux-->parser-->tee
 //
@@ -314,8 +365,6 @@ VideoReceiver::start()
         }
 
         if((queue = gst_element_factory_make("queue", NULL)) == NULL)  {
-            // TODO: We may want to add queue2 max-size-buffers=1 to get lower latency
-            //       We should compare gstreamer scripts to QGroundControl to determine the need
             qCritical() << "VideoReceiver::start() failed. Error with gst_element_factory_make('queue')";
             break;
         }
@@ -330,6 +379,15 @@ VideoReceiver::start()
             break;
         }
 
+        _lowLatency = _videoSettings->lowLatencyMode()->rawValue().toBool();
+        if(_lowLatency) {
+            _configureLowLatency(dataSource, decoder, queue1);
+        }
+        // The sink is reused from one pipeline to the next so sync needs to be set either way
+        if(hasProperty(_videoSink, "sync")) {
+            g_object_set(G_OBJECT(_videoSink), "sync", _lowLatency ? FALSE : TRUE, NULL);
+        }
+
         gst_bin_add_many(GST_BIN(_pipeline), dataSource, demux, parser, _tee, queue, decoder, queue1, _videoSink, NULL);
         pipelineUp = true;
 
@@ -351,12 +409,21 @@ VideoReceiver::start()
             g_signal_connect(demux, "pad-added", G_CALLBACK(newPadCB), parser);
         } else {
             g_signal_connect(dataSource, "pad-added", G_CALLBACK(newPadCB), demux);
-            if(!gst_element_link_many(demux, parser, _tee, queue, decoder, _videoSink, NULL)) {
+            if(!gst_element_link_many(demux, parser, _tee, queue, decoder, queue1, _videoSink, NULL)) {
                 qCritical() << "Unable to link RTSP elements.";
                 break;
             }
         }
 
+        // Buffers from TCP carry stream timestamps rather than arrival times, so there is nothing to measure
+        if(!isTCP) {
+            GstPad* probepad = gst_element_get_static_pad(_videoSink, "sink");
+            if(probepad) {
+                _latencyProbeId = gst_pad_add_probe(probepad, GST_PAD_PROBE_TYPE_BUFFER, _latencyProbe, this, NULL);
+                gst_object_unref(probepad);
+            }
+        }
+
         dataSource = demux = parser = queue = decoder = queue1 = NULL;
 
         GstBus* bus = NULL;
@@ -479,6 +546,18 @@ VideoReceiver::_shutdownPipeline() {
         bus = NULL;
     }
     gst_element_set_state(_pipeline, GST_STATE_NULL);
+    if(_latencyProbeId) {
+        GstPad* probepad = gst_element_get_static_pad(_videoSink, "sink");
+        if(probepad) {
+            gst_pad_remove_probe(probepad, _latencyProbeId);
+            gst_object_unref(probepad);
+        }
+        _latencyProbeId = 0;
+    }
+    _latencySumUSecs.store(0);
+    _latencyMaxUSecs.store(0);
+    _latencyFrames.store(0);
+    _latencyFact.setRawValue(0);
     gst_bin_remove(GST_BIN(_pipeline), _videoSink);
     gst_object_unref(_pipeline);
     _pipeline = NULL;
@@ -840,11 +919,91 @@ VideoReceiver::_keyframeWatch(GstPad* pad, GstPadProbeInfo* info, gpointer user_
 }
 #endif
 
+//-----------------------------------------------------------------------------
+// Called on the streaming thread for every frame handed to the video sink
+#if defined(QGC_GST_STREAMING)
+GstPadProbeReturn
+VideoReceiver::_latencyProbe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data)
+{
+    if(info != NULL && user_data != NULL) {
+        VideoReceiver* pThis = (VideoReceiver*)user_data;
+        GstBuffer* buf = gst_pad_probe_info_get_buffer(info);
+        GstElement* sink = gst_pad_get_parent_element(pad);
+        GstClock* clock = sink ? gst_element_get_clock(sink) : NULL;
+        if(buf && clock && GST_BUFFER_PTS_IS_VALID(buf)) {
+            // Live sources stamp buffers with the running time they arrived at
+            GstClockTime arrival = GST_BUFFER_PTS(buf);
+            GstEvent* segmentEvent = gst_pad_get_sticky_event(pad, GST_EVENT_SEGMENT, 0);
+            if(segmentEvent) {
+                const GstSegment* segment;
+                gst_event_parse_segment(segmentEvent, &segment);
+                arrival = gst_segment_to_running_time(segment, GST_FORMAT_TIME, arrival);
+                gst_event_unref(segmentEvent);
+            }
+            GstClockTime now = gst_clock_get_time(clock) - gst_element_get_base_time(sink);
+            if(GST_CLOCK_TIME_IS_VALID(arrival) && now > arrival) {
+                qint64 latencyUSecs = static_cast<qint64>(GST_TIME_AS_USECONDS(now - arrival));
+                if(latencyUSecs < kMaxLatencyUSecs) {
+                    pThis->_latencySumUSecs.fetchAndAddOrdered(latencyUSecs);
+                    pThis->_latencyFrames.fetchAndAddOrdered(1);
+                    int maxUSecs = pThis->_latencyMaxUSecs.load();
+                    while(latencyUSecs > maxUSecs && !pThis->_latencyMaxUSecs.testAndSetOrdered(maxUSecs, static_cast<int>(latencyUSecs))) {
+                        maxUSecs = pThis->_latencyMaxUSecs.load();
+                    }
+                }
+            }
+        }
+        if(clock) {
+            gst_object_unref(clock);
+        }
+        if(sink) {
+            gst_object_unref(sink);
+        }
+    }
+    return GST_PAD_PROBE_OK;
+}
+#endif
+
+//-----------------------------------------------------------------------------
+#if defined(QGC_GST_STREAMING)
+void
+VideoReceiver::_updateLatency()
+{
+    int frames      = _latencyFrames.fetchAndStoreOrdered(0);
+    qint64 sumUSecs = _latencySumUSecs.fetchAndStoreOrdered(0);
+    int maxUSecs    = _latencyMaxUSecs.fetchAndStoreOrdered(0);
+    if(frames == 0) {
+        return;
+    }
+
+    double latencyMSecs = (sumUSecs / 1000.0) / frames;
+
+    // With sync on, the sink holds each frame until its timestamp plus the pipeline latency before showing it
+    if(!_lowLatency && _pipeline) {
+        GstQuery* query = gst_query_new_latency();
+        if(gst_element_query(_pipeline, query)) {
+            gboolean live;
+            GstClockTime minLatency;
+            GstClockTime maxLatency;
+            gst_query_parse_latency(query, &live, &minLatency, &maxLatency);
+            if(live && GST_CLOCK_TIME_IS_VALID(minLatency)) {
+                latencyMSecs = qMax(latencyMSecs, GST_TIME_AS_USECONDS(minLatency) / 1000.0);
+            }
+        }
+        gst_query_unref(query);
+    }
+
+    _latencyFact.setRawValue(latencyMSecs);
+    qCDebug(VideoReceiverLog) << "Latency(ms) average:" << latencyMSecs << "max:" << maxUSecs / 1000.0 << "frames:" << frames << "low latency:" << _lowLatency;
+}
+#endif
+
 //-----------------------------------------------------------------------------
 void
 VideoReceiver::_updateTimer()
 {
 #if defined(QGC_GST_STREAMING)
+    _updateLatency();
     if(_videoSurface) {
         if(stopping() || starting()) {
             return;
@@ -21,8 +21,11 @@
 #include <QObject>
 #include <QTimer>
 #include <QTcpSocket>
+#include <QAtomicInt>
+#include <QAtomicInteger>
 
 #include "VideoSurface.h"
+#include "Fact.h"
 
 #if defined(QGC_GST_STREAMING)
 #include <gst/gst.h>
@@ -44,6 +47,7 @@ public:
     Q_PROPERTY(QString          imageFile           READ    imageFile           NOTIFY  imageFileChanged)
     Q_PROPERTY(QString          videoFile           READ    videoFile           NOTIFY  videoFileChanged)
     Q_PROPERTY(bool             showFullScreen      READ    showFullScreen      WRITE   setShowFullScreen     NOTIFY showFullScreenChanged)
+    Q_PROPERTY(Fact*            latency             READ    latency             CONSTANT)
 
     explicit VideoReceiver(QObject* parent = 0);
     ~VideoReceiver();
@@ -62,6 +66,10 @@ public:
     virtual QString         videoFile       () { return _videoFile; }
     virtual bool            showFullScreen  () { return _showFullScreen; }
 
+    /// Average time in milliseconds from a frame arriving to it being handed to the video sink over the last second.
+    /// Measured from the buffer PTS, which live sources stamp with the arrival time. Not available for TCP streams.
+    virtual Fact*           latency         () { return &_latencyFact; }
+
     virtual void            grabImage       (QString imageFile);
 
     virtual void        setShowFullScreen   (bool show) { _showFullScreen = show; emit showFullScreenChanged(); }
@@ -121,12 +129,15 @@ protected:
     static gboolean             _onBusMessage           (GstBus* bus, GstMessage* message, gpointer user_data);
     static GstPadProbeReturn    _unlinkCallBack         (GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
     static GstPadProbeReturn    _keyframeWatch          (GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+    static GstPadProbeReturn    _latencyProbe           (GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
 
     virtual void                _detachRecordingBranch  (GstPadProbeInfo* info);
     virtual void                _shutdownRecordingBranch();
     virtual void                _shutdownPipeline       ();
     virtual void                _cleanupOldVideos       ();
     virtual void                _setVideoSink           (GstElement* sink);
+    virtual void                _configureLowLatency    (GstElement* dataSource, GstElement* decoder, GstElement* queue1);
+    virtual void                _updateLatency          ();
 
     GstElement*     _pipeline;
     GstElement*     _pipelineStopRec;
@@ -139,6 +150,12 @@ protected:
     bool            _serverPresent;
     int             _rtspTestInterval_ms;
 
+    bool            _lowLatency;            ///< Low latency profile was used for the running pipeline
+    gulong          _latencyProbeId;
+    QAtomicInteger<qint64> _latencySumUSecs; ///< Updated from the streaming thread, reset every second
+    QAtomicInt      _latencyMaxUSecs;
+    QAtomicInt      _latencyFrames;
+
 #endif
 
     QString         _uri;
@@ -148,6 +165,7 @@ protected:
     bool            _videoRunning;
     bool            _showFullScreen;
     VideoSettings*  _videoSettings;
+    Fact            _latencyFact;
 };
 
 #endif // VIDEORECEIVER_H
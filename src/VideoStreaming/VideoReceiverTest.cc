@@ -0,0 +1,92 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "VideoReceiverTest.h"
+#include "VideoReceiver.h"
+#include "SettingsManager.h"
+#include "QGCApplication.h"
+
+void VideoReceiverTest::init(void)
+{
+    UnitTest::init();
+
+    VideoSettings* videoSettings = qgcApp()->toolbox()->settingsManager()->videoSettings();
+    _savedVideoSource = videoSettings->videoSource()->rawValue();
+    _savedLowLatencyMode = videoSettings->lowLatencyMode()->rawValue();
+}
+
+void VideoReceiverTest::cleanup(void)
+{
+    VideoSettings* videoSettings = qgcApp()->toolbox()->settingsManager()->videoSettings();
+    videoSettings->videoSource()->setRawValue(_savedVideoSource);
+    videoSettings->lowLatencyMode()->setRawValue(_savedLowLatencyMode);
+
+    UnitTest::cleanup();
+}
+
+void VideoReceiverTest::_testLatency(void)
+{
+    _streamAndMeasure(false);
+}
+
+void VideoReceiverTest::_testLowLatency(void)
+{
+    _streamAndMeasure(true);
+}
+
+void VideoReceiverTest::_streamAndMeasure(bool lowLatency)
+{
+#if defined(QGC_GST_STREAMING)
+    // The stand-in camera needs an H.264 encoder, which not every GStreamer install has
+    GstElementFactory* encoderFactory = gst_element_factory_find("x264enc");
+    if (!encoderFactory) {
+        QSKIP("x264enc not available");
+    }
+    gst_object_unref(encoderFactory);
+
+    VideoSettings* videoSettings = qgcApp()->toolbox()->settingsManager()->videoSettings();
+    videoSettings->videoSource()->setRawValue(VideoSettings::videoSourceUDP);
+    videoSettings->lowLatencyMode()->setRawValue(lowLatency);
+
+    QString senderPipeline = QStringLiteral("videotestsrc is-live=true ! video/x-raw,width=320,height=240,framerate=30/1 ! "
+                                            "x264enc tune=zerolatency speed-preset=ultrafast key-int-max=30 ! "
+                                            "rtph264pay config-interval=1 pt=96 ! udpsink host=127.0.0.1 port=%1").arg(_udpPort);
+    GError* error = NULL;
+    GstElement* sender = gst_parse_launch(senderPipeline.toUtf8().constData(), &error);
+    if (error) {
+        QString message(error->message);
+        g_error_free(error);
+        if (sender) {
+            gst_object_unref(sender);
+        }
+        QFAIL(qPrintable(message));
+    }
+
+    VideoReceiver* receiver = new VideoReceiver(this);
+    receiver->setUri(QStringLiteral("udp://0.0.0.0:%1").arg(_udpPort));
+    receiver->start();
+    QVERIFY(receiver->running());
+
+    gboolean sync = TRUE;
+    g_object_get(G_OBJECT(receiver->videoSurface()->videoSink()), "sync", &sync, NULL);
+    QCOMPARE(sync == TRUE, !lowLatency);
+
+    QVERIFY(gst_element_set_state(sender, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+
+    // Latency is published once a second. The value itself depends too much on machine load to check.
+    QTRY_VERIFY_WITH_TIMEOUT(receiver->latency()->rawValue().toDouble() > 0, 10000);
+
+    gst_element_set_state(sender, GST_STATE_NULL);
+    gst_object_unref(sender);
+    delete receiver;
+#else
+    Q_UNUSED(lowLatency);
+    QSKIP("Video streaming not available");
+#endif
+}
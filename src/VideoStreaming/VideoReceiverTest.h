@@ -0,0 +1,35 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+
+#include <QVariant>
+
+/// Unit test for VideoReceiver. Streams a local videotestsrc to the receiver over UDP.
+class VideoReceiverTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void init(void);
+    void cleanup(void);
+
+    void _testLatency(void);
+    void _testLowLatency(void);
+
+private:
+    void _streamAndMeasure(bool lowLatency);
+
+    QVariant _savedVideoSource;
+    QVariant _savedLowLatencyMode;
+
+    static const int _udpPort = 5610;   ///< Out of the way of the default video port used by the app's own receiver
+};
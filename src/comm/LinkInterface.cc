@@ -48,7 +48,6 @@ LinkInterface::LinkInterface(SharedLinkConfigurationPointer& config, bool isPX4F
     , _highLatency              (config->isHighLatency())
     , _mavlinkChannelSet        (false)
     , _enableRateCollection     (false)
-    , _decodedFirstMavlinkPacket(false)
     , _isPX4Flow                (isPX4Flow)
 {
     QQmlEngine::setObjectOwnership(this, QQmlEngine::CppOwnership);
@@ -66,7 +65,15 @@ LinkInterface::LinkInterface(SharedLinkConfigurationPointer& config, bool isPX4F
     memset(_outDataWriteTimes,  0, sizeof(_outDataWriteTimes));
 
     QObject::connect(this, &LinkInterface::_invokeWriteBytes, this, &LinkInterface::_writeBytes);
+
+    // Always queued, even for links living on the calling thread, so messages sent together go out in one batch
+    QObject::connect(this, &LinkInterface::_invokeFlushSendQueue, this, &LinkInterface::_flushSendQueue, Qt::QueuedConnection);
+    _sendStatsTimer.start();
     qRegisterMetaType<LinkInterface*>("LinkInterface*");
+    qRegisterMetaType<MAVLinkMessageBatch>("MAVLinkMessageBatch");
+
+    // Parsing must happen on the thread which received the bytes, hence the direct connection
+    QObject::connect(this, &LinkInterface::bytesReceived, this, &LinkInterface::_parseBytes, Qt::DirectConnection);
 }
 
 /// This function logs the send times and amounts of datas for input. Data is used for calculating
@@ -87,6 +94,67 @@ void LinkInterface::_logOutputDataRate(quint64 byteCount, qint64 time) {
         _logDataRateToBuffer(_outDataWriteAmounts, _outDataWriteTimes, &_outDataIndex, byteCount, time);
 }
 
+void LinkInterface::_emitBytesReceived(const char* data, int length)
+{
+    QByteArray bytes;
+    if (receivers(SIGNAL(bytesReceived(LinkInterface*, QByteArray))) > 1) {
+        // Someone other than our own parser is listening and may hold on to the data past this call
+        bytes = QByteArray(data, length);
+    } else {
+        bytes = QByteArray::fromRawData(data, length);
+    }
+    emit bytesReceived(this, bytes);
+}
+
+bool LinkInterface::writeMessageSafe(const mavlink_message_t& message)
+{
+    if (!_sendQueue.enqueue(message)) {
+        qCDebug(LinkSendQueueLog) << "Send queue full, dropping message" << getName() << message.msgid;
+        return false;
+    }
+
+    // Only the first message since the last flush needs to wake up the link thread
+    if (_sendFlushPending.testAndSetOrdered(0, 1)) {
+        emit _invokeFlushSendQueue();
+    }
+
+    return true;
+}
+
+void LinkInterface::_flushSendQueue(void)
+{
+    // Cleared before draining so anything queued from here on triggers another flush
+    _sendFlushPending.store(0);
+
+    if (!isConnected()) {
+        _sendQueue.clear();
+        return;
+    }
+
+    // Messages are given their sequence numbers as they are dequeued, so they match the order they go out on the link
+    while (true) {
+        QByteArray batch;
+        batch.reserve(_maxSendBatchBytes);
+        if (_sendQueue.dequeue(batch, _maxSendBatchBytes) == 0) {
+            break;
+        }
+        _writeBytes(batch);
+    }
+
+    if (LinkSendQueueLog().isDebugEnabled() && _sendStatsTimer.elapsed() > _sendStatsIntervalMSecs) {
+        _sendStatsTimer.restart();
+        for (int i=0; i<LinkSendQueue::PriorityCount; i++) {
+            LinkSendQueue::Stats_t stats = _sendQueue.stats(static_cast<LinkSendQueue::Priority_t>(i));
+            qCDebug(LinkSendQueueLog) << getName() << "priority" << i
+                                      << "sent" << stats.sent
+                                      << "dropped" << stats.dropped
+                                      << "maxDepth" << stats.maxDepth
+                                      << "avgLatency(usecs)" << stats.avgLatencyUSecs
+                                      << "maxLatency(usecs)" << stats.maxLatencyUSecs;
+        }
+    }
+}
+
 /**
      * @brief logDataRateToBuffer Stores transmission times/amounts for statistics
      *
@@ -182,6 +250,23 @@ void LinkInterface::_setMavlinkChannel(uint8_t channel)
     }
     _mavlinkChannelSet = true;
     _mavlinkChannel = channel;
+    _parser.setChannel(channel);
+}
+
+void LinkInterface::_parseBytes(LinkInterface* link, QByteArray bytes)
+{
+    Q_UNUSED(link);
+
+    if (!_mavlinkChannelSet) {
+        // Link has not been added to LinkManager yet
+        return;
+    }
+
+    MAVLinkMessageBatch batch;
+    if (_parser.parse(bytes, batch)) {
+        _pendingMessageBatches.ref();
+        emit messagesReceived(this, batch);
+    }
 }
 
 void LinkInterface::_activeChanged(bool active, int vehicle_id)
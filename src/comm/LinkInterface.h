@@ -22,6 +22,8 @@
 #include "QGCMAVLink.h"
 #include "LinkConfiguration.h"
 #include "MavlinkMessagesTimer.h"
+#include "MAVLinkParser.h"
+#include "LinkSendQueue.h"
 
 class LinkManager;
 
@@ -130,8 +132,28 @@ public:
     ///     signals: highLatencyChanged
     bool highLatency(void) const { return _highLatency; }
 
-    bool decodedFirstMavlinkPacket(void) const { return _decodedFirstMavlinkPacket; }
-    bool setDecodedFirstMavlinkPacket(bool decodedFirstMavlinkPacket) { return _decodedFirstMavlinkPacket = decodedFirstMavlinkPacket; }
+    bool decodedFirstMavlinkPacket(void) const { return _parser.decodedFirstMavlinkPacket(); }
+
+    /// Resets the parser counters and sequence tracking for this link. Safe to call from any thread.
+    void resetParser(void) { _parser.requestReset(); }
+
+    /// Switches outbound traffic between mavlink 1 and 2. Safe to call from any thread.
+    void setOutboundMavlink1(bool mavlink1) { _parser.setOutboundMavlink1(mavlink1); }
+
+    /// @return Number of message batches signalled by messagesReceived which MAVLinkProtocol hasn't processed yet.
+    /// Safe to call from any thread.
+    int pendingMessageBatches(void) const { return _pendingMessageBatches.load(); }
+
+    /// Called by MAVLinkProtocol once it has processed a batch from messagesReceived
+    void messageBatchProcessed(void) { _pendingMessageBatches.deref(); }
+
+    /// Queues a MAVLink message for sending. The message is serialized straight into the send queue slot for its
+    /// priority class and written out in batches on the link thread. Safe to call from any thread.
+    ///     @return false: send queue for the message priority is full, message was dropped
+    bool writeMessageSafe(const mavlink_message_t& message);
+
+    /// @return Send queue statistics for the specified priority class. Safe to call from any thread.
+    LinkSendQueue::Stats_t sendQueueStats(LinkSendQueue::Priority_t priority) const { return _sendQueue.stats(priority); }
 
     // These are left unimplemented in order to cause linker errors which indicate incorrect usage of
     // connect/disconnect on link directly. All connect/disconnect calls should be made through LinkManager.
@@ -148,6 +170,9 @@ public slots:
      * communication arbitrary byte lengths can be written. The method ensures
      * thread safety regardless of the underlying LinkInterface implementation.
      *
+     * The bytes bypass the send queue used by writeMessageSafe. This is only meant for traffic which isn't
+     * MAVLink, like the NSH prompt probe, so it has no sequence number to keep in order and no length limit.
+     *
      * @param bytes The pointer to the byte array containing the data
      * @param length The length of the data array
      **/
@@ -159,12 +184,19 @@ public slots:
 private slots:
     virtual void _writeBytes(const QByteArray) = 0;
 
+    /// Runs on the thread which emitted bytesReceived (normally the link thread)
+    void _parseBytes(LinkInterface* link, QByteArray bytes);
+
     void _activeChanged(bool active, int vehicle_id);
+
+    /// Writes everything in the send queue, runs on the link thread
+    void _flushSendQueue(void);
     
 signals:
     void autoconnectChanged(bool autoconnect);
     void activeChanged(LinkInterface* link, bool active, int vehicle_id);
     void _invokeWriteBytes(QByteArray);
+    void _invokeFlushSendQueue(void);
     void highLatencyChanged(bool highLatency);
 
     /// Signalled when a link suddenly goes away due to it being removed by for example pulling the cable to the connection.
@@ -182,6 +214,10 @@ signals:
      */
     void bytesReceived(LinkInterface* link, QByteArray data);
 
+    /// Messages which were parsed from bytesReceived on the link thread. The batch is implicitly shared
+    /// so the cross thread delivery does not copy the messages.
+    void messagesReceived(LinkInterface* link, MAVLinkMessageBatch batch);
+
     /**
      * @brief This signal is emitted instantly when the link is connected
      **/
@@ -218,6 +254,13 @@ protected:
     ///     @param time Time in ms receive occurred
     void _logOutputDataRate(quint64 byteCount, qint64 time);
 
+    /// Emits bytesReceived for data which lives in a buffer owned by the link. If the parser is the only
+    /// listener the data is handed over without copying, so it only needs to stay valid for the duration
+    /// of the call. Other listeners (which may be queued) receive a deep copy.
+    ///     @param data Received bytes
+    ///     @param length Number of bytes in data
+    void _emitBytesReceived(const char* data, int length);
+
     SharedLinkConfigurationPointer _config;
     bool _highLatency;
 
@@ -300,7 +343,14 @@ private:
     mutable QMutex _dataRateMutex; // Mutex for accessing the data rate member variables
 
     bool _enableRateCollection;
-    bool _decodedFirstMavlinkPacket;    ///< true: link has correctly decoded it's first mavlink packet
+    MAVLinkParser _parser;              ///< Parses incoming bytes on the link thread
+    QAtomicInt    _pendingMessageBatches;   ///< Batches signalled to MAVLinkProtocol and not processed yet
+    LinkSendQueue _sendQueue;           ///< Outbound messages waiting for the link thread
+    QAtomicInt    _sendFlushPending;    ///< 1: A flush has been queued to the link thread and hasn't started yet
+    QElapsedTimer _sendStatsTimer;      ///< Time since send queue statistics were last logged
+
+    static const int _maxSendBatchBytes =       1024;   ///< Keeps a batch within a single UDP datagram
+    static const int _sendStatsIntervalMSecs =  5000;
     bool _isPX4Flow;
 
     QMap<int /* vehicle id */, MavlinkMessagesTimer*> _mavlinkMessagesTimers;
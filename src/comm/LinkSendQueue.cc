@@ -0,0 +1,288 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "LinkSendQueue.h"
+#include "QGCLoggingCategory.h"
+
+#include <string.h>
+
+QGC_LOGGING_CATEGORY(LinkSendQueueLog, "LinkSendQueueLog")
+
+// Ring sizes must be a power of two
+const int       LinkSendQueue::_ringCapacity[LinkSendQueue::PriorityCount] = { 64, 256, 512 };
+const double    LinkSendQueue::_latencyFilter = 0.1;
+
+LinkSendQueue::LinkSendQueue(void)
+    : _sequence(0)
+{
+    for (int i=0; i<PriorityCount; i++) {
+        Ring_t& ring = _rings[i];
+
+        ring.slots = new Slot_t[_ringCapacity[i]];
+        ring.mask = static_cast<quint32>(_ringCapacity[i] - 1);
+        for (int j=0; j<_ringCapacity[i]; j++) {
+            ring.slots[j].sequence.store(static_cast<quint32>(j));
+        }
+
+        memset(&_stats[i], 0, sizeof(_stats[i]));
+    }
+
+    _clock.start();
+}
+
+LinkSendQueue::~LinkSendQueue()
+{
+    for (int i=0; i<PriorityCount; i++) {
+        delete[] _rings[i].slots;
+    }
+}
+
+LinkSendQueue::Priority_t LinkSendQueue::priority(uint32_t msgid)
+{
+    switch (msgid) {
+    case MAVLINK_MSG_ID_HEARTBEAT:
+    case MAVLINK_MSG_ID_COMMAND_LONG:
+    case MAVLINK_MSG_ID_COMMAND_INT:
+    case MAVLINK_MSG_ID_COMMAND_ACK:
+    case MAVLINK_MSG_ID_SET_MODE:
+    case MAVLINK_MSG_ID_MANUAL_CONTROL:
+    case MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE:
+        return PriorityHigh;
+
+    case MAVLINK_MSG_ID_GPS_RTCM_DATA:
+    case MAVLINK_MSG_ID_GPS_INJECT_DATA:
+    case MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL:
+    case MAVLINK_MSG_ID_PARAM_REQUEST_LIST:
+    case MAVLINK_MSG_ID_PARAM_REQUEST_READ:
+    case MAVLINK_MSG_ID_LOG_REQUEST_LIST:
+    case MAVLINK_MSG_ID_LOG_REQUEST_DATA:
+        return PriorityBulk;
+
+    default:
+        return PriorityNormal;
+    }
+}
+
+/// Claims the next free slot in the ring
+///     @param[out] pos Position of the claimed slot
+/// @return NULL: ring is full
+LinkSendQueue::Slot_t* LinkSendQueue::_reserve(Ring_t& ring, quint32& pos)
+{
+    pos = ring.enqueuePos.loadAcquire();
+
+    while (true) {
+        Slot_t* slot = &ring.slots[pos & ring.mask];
+        qint32 diff = static_cast<qint32>(slot->sequence.loadAcquire() - pos);
+
+        if (diff == 0) {
+            // Slot is free, try to claim it before another producer does
+            if (ring.enqueuePos.testAndSetOrdered(pos, pos + 1)) {
+                return slot;
+            }
+        } else if (diff < 0) {
+            // Slot still holds a message from the previous lap
+            return NULL;
+        }
+        pos = ring.enqueuePos.loadAcquire();
+    }
+}
+
+/// Publishes a filled slot to the consumer
+void LinkSendQueue::_commit(Slot_t* slot, quint32 pos)
+{
+    slot->enqueueNSecs = _clock.nsecsElapsed();
+    slot->sequence.storeRelease(pos + 1);
+}
+
+bool LinkSendQueue::enqueue(const mavlink_message_t& message)
+{
+    Ring_t& ring = _rings[priority(message.msgid)];
+
+    quint32 pos;
+    Slot_t* slot = _reserve(ring, pos);
+    if (!slot) {
+        ring.dropped.fetchAndAddRelaxed(1);
+        return false;
+    }
+
+    slot->length = mavlink_msg_to_send_buffer(reinterpret_cast<uint8_t*>(slot->bytes), &message);
+
+    // Signed messages can't be changed without signing them again, they keep the sequence number they were packed with
+    const mavlink_msg_entry_t* msgEntry = mavlink_get_msg_entry(message.msgid);
+    slot->stampSequence = msgEntry && !(message.incompat_flags & MAVLINK_IFLAG_SIGNED);
+    slot->crcExtra = msgEntry ? msgEntry->crc_extra : 0;
+
+    _commit(slot, pos);
+    ring.enqueued.fetchAndAddRelaxed(1);
+
+    return true;
+}
+
+bool LinkSendQueue::enqueue(Priority_t priority, const char* bytes, int length)
+{
+    Ring_t& ring = _rings[priority];
+
+    quint32 pos;
+    Slot_t* slot = length > 0 && length <= slotBytes ? _reserve(ring, pos) : NULL;
+    if (!slot) {
+        ring.dropped.fetchAndAddRelaxed(1);
+        return false;
+    }
+
+    memcpy(slot->bytes, bytes, length);
+    slot->length = length;
+    slot->stampSequence = false;
+    _commit(slot, pos);
+    ring.enqueued.fetchAndAddRelaxed(1);
+
+    return true;
+}
+
+int LinkSendQueue::dequeue(QByteArray& batch, int maxBytes)
+{
+    int packetCount = 0;
+    qint64 nowNSecs = _clock.nsecsElapsed();
+
+    for (int i=0; i<PriorityCount; i++) {
+        Ring_t& ring = _rings[i];
+        int depth = this->depth(static_cast<Priority_t>(i));
+        int sent = 0;
+        qint64 totalLatencyNSecs = 0;
+        qint64 maxLatencyNSecs = 0;
+        bool batchFull = false;
+
+        quint32 pos = ring.dequeuePos.load();
+        while (true) {
+            Slot_t& slot = ring.slots[pos & ring.mask];
+            if (static_cast<qint32>(slot.sequence.loadAcquire() - (pos + 1)) < 0) {
+                // Nothing more committed in this ring
+                break;
+            }
+            if (batch.size() + slot.length > maxBytes && !batch.isEmpty()) {
+                batchFull = true;
+                break;
+            }
+
+            if (slot.stampSequence) {
+                _stampSequence(slot);
+            }
+            batch.append(slot.bytes, slot.length);
+
+            qint64 latencyNSecs = nowNSecs - slot.enqueueNSecs;
+            totalLatencyNSecs += latencyNSecs;
+            maxLatencyNSecs = qMax(maxLatencyNSecs, latencyNSecs);
+            sent++;
+
+            // Hand the slot back to the producers for the next lap
+            slot.sequence.storeRelease(pos + ring.mask + 1);
+            pos++;
+            ring.dequeuePos.storeRelease(pos);
+        }
+
+        if (sent) {
+            _updateStats(static_cast<Priority_t>(i), depth, sent, totalLatencyNSecs, maxLatencyNSecs);
+            packetCount += sent;
+        }
+        if (batchFull) {
+            break;
+        }
+    }
+
+    return packetCount;
+}
+
+/// Gives a serialized message the next outgoing sequence number and recalculates its checksum
+void LinkSendQueue::_stampSequence(Slot_t& slot)
+{
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(slot.bytes);
+
+    bool mavlink1 = bytes[0] == MAVLINK_STX_MAVLINK1;
+    int sequenceOffset = mavlink1 ? 2 : 4;
+    int checksumOffset = (mavlink1 ? MAVLINK_CORE_HEADER_MAVLINK1_LEN : MAVLINK_CORE_HEADER_LEN) + 1 + bytes[1];
+    if (checksumOffset + MAVLINK_NUM_CHECKSUM_BYTES > slot.length) {
+        return;
+    }
+
+    bytes[sequenceOffset] = _sequence++;
+
+    // Checksum covers everything after the start byte up to the checksum, seeded with the message crc extra
+    uint16_t checksum = crc_calculate(&bytes[1], static_cast<uint16_t>(checksumOffset - 1));
+    crc_accumulate(slot.crcExtra, &checksum);
+    bytes[checksumOffset]       = static_cast<uint8_t>(checksum & 0xFF);
+    bytes[checksumOffset + 1]   = static_cast<uint8_t>(checksum >> 8);
+}
+
+void LinkSendQueue::_updateStats(Priority_t priority, int depth, int sent, qint64 totalLatencyNSecs, qint64 maxLatencyNSecs)
+{
+    QMutexLocker locker(&_statsMutex);
+    Stats_t& stats = _stats[priority];
+
+    double avgLatencyUSecs = (totalLatencyNSecs / 1000.0) / sent;
+
+    stats.sent += sent;
+    stats.maxDepth = qMax(stats.maxDepth, depth);
+    stats.maxLatencyUSecs = qMax(stats.maxLatencyUSecs, maxLatencyNSecs / 1000);
+    if (stats.avgLatencyUSecs == 0) {
+        stats.avgLatencyUSecs = avgLatencyUSecs;
+    } else {
+        stats.avgLatencyUSecs += (avgLatencyUSecs - stats.avgLatencyUSecs) * _latencyFilter;
+    }
+}
+
+void LinkSendQueue::clear(void)
+{
+    for (int i=0; i<PriorityCount; i++) {
+        Ring_t& ring = _rings[i];
+
+        quint32 pos = ring.dequeuePos.load();
+        while (true) {
+            Slot_t& slot = ring.slots[pos & ring.mask];
+            if (static_cast<qint32>(slot.sequence.loadAcquire() - (pos + 1)) < 0) {
+                break;
+            }
+            slot.sequence.storeRelease(pos + ring.mask + 1);
+            pos++;
+        }
+        ring.dequeuePos.storeRelease(pos);
+    }
+}
+
+bool LinkSendQueue::isEmpty(void) const
+{
+    for (int i=0; i<PriorityCount; i++) {
+        if (depth(static_cast<Priority_t>(i)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int LinkSendQueue::depth(Priority_t priority) const
+{
+    const Ring_t& ring = _rings[priority];
+
+    // Positions can be claimed but not yet committed, so this is only a snapshot
+    qint32 depth = static_cast<qint32>(ring.enqueuePos.loadAcquire() - ring.dequeuePos.loadAcquire());
+    return qMax(0, static_cast<int>(depth));
+}
+
+LinkSendQueue::Stats_t LinkSendQueue::stats(Priority_t priority) const
+{
+    Stats_t stats;
+    {
+        QMutexLocker locker(&_statsMutex);
+        stats = _stats[priority];
+    }
+
+    stats.enqueued  = _rings[priority].enqueued.loadAcquire();
+    stats.dropped   = _rings[priority].dropped.loadAcquire();
+    stats.depth     = depth(priority);
+
+    return stats;
+}
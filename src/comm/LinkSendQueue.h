@@ -0,0 +1,118 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QLoggingCategory>
+
+#include "QGCMAVLink.h"
+
+Q_DECLARE_LOGGING_CATEGORY(LinkSendQueueLog)
+
+/// Outbound message queue for a link.
+///
+/// Each priority class has its own bounded ring of fixed size slots. Producers on any thread serialize a message
+/// straight into a slot without taking a lock, the link thread is the single consumer which drains the rings in
+/// priority order into write batches. Messages which don't fit into a full ring are dropped and counted, a backed up
+/// link never blocks the caller.
+class LinkSendQueue
+{
+public:
+    LinkSendQueue(void);
+    ~LinkSendQueue();
+
+    typedef enum {
+        PriorityHigh = 0,   ///< Heartbeats, commands and manual control
+        PriorityNormal,     ///< Everything which isn't classified otherwise
+        PriorityBulk,       ///< RTCM injection, FTP, parameter and log transfers
+        PriorityCount
+    } Priority_t;
+
+    typedef struct {
+        quint32 enqueued;           ///< Messages accepted into the queue
+        quint32 dropped;            ///< Messages dropped because the queue was full
+        quint32 sent;               ///< Messages handed to the link
+        int     depth;              ///< Messages currently waiting
+        int     maxDepth;           ///< Largest number of waiting messages seen by the consumer
+        double  avgLatencyUSecs;    ///< Filtered time from enqueue to write
+        qint64  maxLatencyUSecs;    ///< Largest time from enqueue to write
+    } Stats_t;
+
+    /// @return Priority class for the specified message id
+    static Priority_t priority(uint32_t msgid);
+
+    /// Serializes the message into the queue for its priority class. Safe to call from any thread.
+    ///     @return false: queue is full, message was dropped
+    bool enqueue(const mavlink_message_t& message);
+
+    /// Adds raw bytes to the queue. Safe to call from any thread.
+    ///     @return false: queue is full or bytes don't fit in a slot, bytes were dropped
+    bool enqueue(Priority_t priority, const char* bytes, int length);
+
+    /// Moves queued packets to the end of batch, highest priority first, until the next packet would take the batch
+    /// past maxBytes. Messages get their sequence number here rather than when they were packed, so the sequence
+    /// numbers on the link stay in order even though priority classes overtake each other. Must only be called from
+    /// the consumer thread.
+    ///     @return Number of packets added to the batch
+    int dequeue(QByteArray& batch, int maxBytes);
+
+    /// Throws away everything in the queue. Must only be called from the consumer thread.
+    void clear(void);
+
+    bool isEmpty(void) const;
+
+    /// @return Number of messages waiting in the specified priority class. Safe to call from any thread.
+    int depth(Priority_t priority) const;
+
+    /// @return Statistics for the specified priority class. Safe to call from any thread.
+    Stats_t stats(Priority_t priority) const;
+
+    /// @return Number of slots in the ring for the specified priority class
+    static int capacity(Priority_t priority) { return _ringCapacity[priority]; }
+
+    static const int slotBytes = MAVLINK_MAX_PACKET_LEN;
+
+private:
+    typedef struct {
+        QAtomicInteger<quint32> sequence;       ///< Slot is writable when sequence == position, readable when position + 1
+        qint64                  enqueueNSecs;
+        int                     length;
+        bool                    stampSequence;  ///< Slot holds an unsigned message which gets its sequence number on dequeue
+        quint8                  crcExtra;       ///< Checksum seed for the message id, used when re-stamping
+        char                    bytes[slotBytes];
+    } Slot_t;
+
+    typedef struct {
+        Slot_t*                 slots;
+        quint32                 mask;
+        QAtomicInteger<quint32> enqueuePos;
+        QAtomicInteger<quint32> dequeuePos;     ///< Only written by the consumer, atomic so depth can be read anywhere
+        QAtomicInteger<quint32> enqueued;
+        QAtomicInteger<quint32> dropped;
+    } Ring_t;
+
+    Slot_t* _reserve(Ring_t& ring, quint32& pos);
+    void    _commit (Slot_t* slot, quint32 pos);
+    void    _stampSequence(Slot_t& slot);
+    void    _updateStats(Priority_t priority, int depth, int sent, qint64 totalLatencyNSecs, qint64 maxLatencyNSecs);
+
+    Ring_t          _rings[PriorityCount];
+    QElapsedTimer   _clock;                 ///< Monotonic time base for latency
+    quint8          _sequence;              ///< Next outgoing message sequence number, consumer only
+
+    mutable QMutex  _statsMutex;            ///< Consumer side statistics, never taken on the enqueue path
+    Stats_t         _stats[PriorityCount];
+
+    static const int    _ringCapacity[PriorityCount];
+    static const double _latencyFilter;
+};
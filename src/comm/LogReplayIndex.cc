@@ -0,0 +1,229 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "LogReplayIndex.h"
+#include "QGCMAVLink.h"
+#include "QGCLoggingCategory.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include <algorithm>
+
+QGC_LOGGING_CATEGORY(LogReplayIndexLog, "LogReplayIndexLog")
+
+const char* LogReplayIndex::_indexFileExtension = "idx";
+
+LogReplayIndex::LogReplayIndex(void)
+{
+    clear();
+}
+
+void LogReplayIndex::clear(void)
+{
+    _entries.clear();
+    _logFileSize    = 0;
+    _lastTimeUSecs  = 0;
+    _lastOffset     = 0;
+    _haveLast       = false;
+}
+
+QString LogReplayIndex::indexFileName(const QString& logFilename)
+{
+    return QStringLiteral("%1.%2").arg(logFilename).arg(_indexFileExtension);
+}
+
+quint64 LogReplayIndex::parseTimestamp(const char* bytes)
+{
+    quint64 timestamp = qFromBigEndian<quint64>(reinterpret_cast<const uchar*>(bytes));
+    quint64 currentTimestamp = ((quint64)QDateTime::currentMSecsSinceEpoch()) * 1000;
+
+    // Now if the parsed timestamp is in the future, it must be an old file where the timestamp was stored as
+    // little endian, so switch it.
+    if (timestamp > currentTimestamp) {
+        timestamp = qbswap(timestamp);
+    }
+
+    return timestamp;
+}
+
+void LogReplayIndex::addMessage(quint64 timeUSecs, qint64 offset)
+{
+    // Like build(), messages which go back in time are left out of the index. They are still replayed, they just
+    // can't be seek targets, and the entries stay sorted for entryForTime.
+    if (!_entries.isEmpty() && timeUSecs < _lastTimeUSecs) {
+        qCDebug(LogReplayIndexLog) << "Skipping non-monotonic timestamp:last" << timeUSecs << _lastTimeUSecs;
+        return;
+    }
+
+    if (_entries.isEmpty() || timeUSecs - _entries.last().timeUSecs >= _entryIntervalUSecs) {
+        Entry_t entry = { timeUSecs, offset };
+        _entries.append(entry);
+        _haveLast = false;
+    } else {
+        _haveLast = true;
+    }
+    _lastTimeUSecs  = timeUSecs;
+    _lastOffset     = offset;
+}
+
+void LogReplayIndex::finish(qint64 logFileSize)
+{
+    if (_haveLast) {
+        Entry_t entry = { _lastTimeUSecs, _lastOffset };
+        _entries.append(entry);
+        _haveLast = false;
+    }
+    _entries.squeeze();
+    _logFileSize = logFileSize;
+}
+
+LogReplayIndex::Entry_t LogReplayIndex::entryForTime(quint64 timeUSecs) const
+{
+    if (_entries.isEmpty()) {
+        Entry_t entry = { 0, 0 };
+        return entry;
+    }
+
+    QVector<Entry_t>::const_iterator it = std::upper_bound(_entries.constBegin(), _entries.constEnd(), timeUSecs,
+                                                           [](quint64 time, const Entry_t& entry) { return time < entry.timeUSecs; });
+    if (it == _entries.constBegin()) {
+        return _entries.first();
+    }
+    return *(it - 1);
+}
+
+bool LogReplayIndex::load(const QString& logFilename)
+{
+    clear();
+
+    QFile indexFile(indexFileName(logFilename));
+    if (!indexFile.open(QFile::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&indexFile);
+    quint32 magic, version, count;
+    qint64  logFileSize;
+    stream >> magic >> version >> logFileSize >> count;
+    if (stream.status() != QDataStream::Ok || magic != _indexFileMagic || version != _indexFileVersion) {
+        qCDebug(LogReplayIndexLog) << "Ignoring index with bad header" << indexFile.fileName();
+        return false;
+    }
+    if (logFileSize != QFileInfo(logFilename).size()) {
+        qCDebug(LogReplayIndexLog) << "Ignoring out of date index" << indexFile.fileName();
+        return false;
+    }
+
+    _entries.resize(count);
+    for (quint32 i=0; i<count; i++) {
+        stream >> _entries[i].timeUSecs >> _entries[i].offset;
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qCDebug(LogReplayIndexLog) << "Ignoring truncated index" << indexFile.fileName();
+        clear();
+        return false;
+    }
+    _logFileSize = logFileSize;
+
+    qCDebug(LogReplayIndexLog) << "Loaded index" << indexFile.fileName() << "entries" << count;
+    return true;
+}
+
+bool LogReplayIndex::save(const QString& logFilename) const
+{
+    QFile indexFile(indexFileName(logFilename));
+    if (!indexFile.open(QFile::WriteOnly | QFile::Truncate)) {
+        qCWarning(LogReplayIndexLog) << "Unable to write index" << indexFile.fileName() << indexFile.errorString();
+        return false;
+    }
+
+    return writeHeader(indexFile, _logFileSize, _entries.count()) && writeEntries(indexFile, _entries);
+}
+
+bool LogReplayIndex::writeHeader(QIODevice& indexFile, qint64 logFileSize, int entryCount)
+{
+    QDataStream stream(&indexFile);
+    stream << _indexFileMagic << _indexFileVersion << logFileSize << static_cast<quint32>(entryCount);
+    return stream.status() == QDataStream::Ok;
+}
+
+bool LogReplayIndex::writeEntries(QIODevice& indexFile, const QVector<Entry_t>& entries)
+{
+    QDataStream stream(&indexFile);
+    foreach (const Entry_t& entry, entries) {
+        stream << entry.timeUSecs << entry.offset;
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+bool LogReplayIndex::build(QFile& logFile)
+{
+    const int cbTimestamp = sizeof(quint64);
+
+    clear();
+
+    qint64 size     = logFile.size();
+    qint64 savedPos = logFile.pos();
+
+    // Map the file if possible so we don't have to pull a multi-hour log into memory
+    QByteArray  fileBytes;
+    const uchar* data = logFile.map(0, size);
+    bool mapped = data != NULL;
+    if (!mapped) {
+        logFile.seek(0);
+        fileBytes = logFile.readAll();
+        data = reinterpret_cast<const uchar*>(fileBytes.constData());
+        size = fileBytes.size();
+    }
+
+    // Walk the file frame by frame using the mavlink header lengths rather than parsing byte by byte. If we
+    // hit something which doesn't look like a frame we slide forward a byte at a time until we find one.
+    qint64 pos          = 0;
+    qint64 skippedBytes = 0;
+    while (pos + cbTimestamp + 3 <= size) {
+        const uchar*    frame       = data + pos + cbTimestamp;
+        qint64          frameLen    = 0;
+
+        if (frame[0] == MAVLINK_STX_MAVLINK1) {
+            frameLen = MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1 + frame[1] + MAVLINK_NUM_CHECKSUM_BYTES;
+        } else if (frame[0] == MAVLINK_STX) {
+            frameLen = MAVLINK_CORE_HEADER_LEN + 1 + frame[1] + MAVLINK_NUM_CHECKSUM_BYTES;
+            if (frame[2] & MAVLINK_IFLAG_SIGNED) {
+                frameLen += MAVLINK_SIGNATURE_BLOCK_LEN;
+            }
+        }
+
+        quint64 timeUSecs = parseTimestamp(reinterpret_cast<const char*>(data + pos));
+        // Timestamps must move forward by a sane amount, which also weeds out false frame starts when resyncing
+        bool timeValid = _entries.isEmpty() || (timeUSecs >= _lastTimeUSecs && timeUSecs - _lastTimeUSecs < _maxTimeGapUSecs);
+
+        if (frameLen == 0 || !timeValid || pos + cbTimestamp + frameLen > size) {
+            pos++;
+            skippedBytes++;
+            continue;
+        }
+
+        addMessage(timeUSecs, pos);
+        pos += cbTimestamp + frameLen;
+    }
+
+    if (mapped) {
+        logFile.unmap(const_cast<uchar*>(data));
+    }
+    logFile.seek(savedPos);
+
+    finish(logFile.size());
+
+    qCDebug(LogReplayIndexLog) << "Built index entries:skippedBytes" << _entries.count() << skippedBytes;
+
+    return !_entries.isEmpty();
+}
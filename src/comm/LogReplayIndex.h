@@ -0,0 +1,92 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QVector>
+#include <QString>
+#include <QFile>
+#include <QLoggingCategory>
+
+Q_DECLARE_LOGGING_CATEGORY(LogReplayIndexLog)
+
+/// Time index for timestamped (.tlog/.mavlink) telemetry logs. Each entry maps a log timestamp to the file
+/// offset of the timestamp record which precedes the message. Entries are sampled at most every
+/// _entryIntervalUSecs of log time, plus the last message in the log.
+///
+/// The index is stored in a sidecar file next to the log (see indexFileName). It is either streamed out
+/// while the log is written or built on first open of a log which doesn't have one. A streamed index gets
+/// its header filled in when the log is closed, until then it doesn't match the log and load() ignores it.
+class LogReplayIndex
+{
+public:
+    LogReplayIndex(void);
+
+    typedef struct {
+        quint64 timeUSecs;  ///< Unix timestamp in microseconds UTC
+        qint64  offset;     ///< File offset of the timestamp record for the message
+    } Entry_t;
+
+    /// Adds a message to the index. Messages must be added in file order. Messages with a timestamp earlier than
+    /// the previous message are not indexed.
+    void addMessage(quint64 timeUSecs, qint64 offset);
+
+    /// Must be called once all messages have been added. Makes sure the last message is part of the index.
+    void finish(qint64 logFileSize);
+
+    void clear(void);
+
+    bool    isEmpty         (void) const { return _entries.isEmpty(); }
+    int     count           (void) const { return _entries.count(); }
+    quint64 startTimeUSecs  (void) const { return _entries.isEmpty() ? 0 : _entries.first().timeUSecs; }
+    quint64 endTimeUSecs    (void) const { return _entries.isEmpty() ? 0 : _entries.last().timeUSecs; }
+    Entry_t entry           (int index) const { return _entries[index]; }
+
+    /// Returns the last entry with a time at or before the specified time. O(log n).
+    Entry_t entryForTime(quint64 timeUSecs) const;
+
+    /// Loads the sidecar index for the specified log file
+    ///     @return false: No index, or index is out of date with respect to the log
+    bool load(const QString& logFilename);
+
+    /// Saves the sidecar index for the specified log file
+    bool save(const QString& logFilename) const;
+
+    /// Writes the sidecar header. The header has a fixed size so a streamed index can rewrite it in place.
+    ///     @param logFileSize Size of the log the index is for, -1 while the log is still being written
+    static bool writeHeader(QIODevice& indexFile, qint64 logFileSize, int entryCount);
+
+    /// Appends entries to a sidecar index after its header
+    static bool writeEntries(QIODevice& indexFile, const QVector<Entry_t>& entries);
+
+    /// Builds the index by walking the mavlink frames in the log file. The file position is restored on return.
+    ///     @return false: No valid messages found
+    bool build(QFile& logFile);
+
+    /// @return Name of the sidecar index file for the specified log file
+    static QString indexFileName(const QString& logFilename);
+
+    /// Parses a BigEndian quint64 timestamp. Old logs stored little endian timestamps which are detected by
+    /// the value being in the future.
+    /// @return A Unix timestamp in microseconds UTC
+    static quint64 parseTimestamp(const char* bytes);
+
+private:
+    QVector<Entry_t>    _entries;
+    qint64              _logFileSize;
+    quint64             _lastTimeUSecs;
+    qint64              _lastOffset;
+    bool                _haveLast;
+
+    static const quint64    _entryIntervalUSecs = 100000;
+    static const quint64    _maxTimeGapUSecs    = 24ull * 60 * 60 * 1000000;
+    static const char*      _indexFileExtension;
+    static const quint32    _indexFileMagic     = 0x5849514C;   // "LQIX"
+    static const quint32    _indexFileVersion   = 1;
+};
@@ -70,6 +70,7 @@ LogReplayLink::LogReplayLink(SharedLinkConfigurationPointer& config)
     , _logReplayConfig(qobject_cast<LogReplayLinkConfiguration*>(config.data()))
     , _connected(false)
     , _replayAccelerationFactor(1.0f)
+    , _fastReplay(false)
 {
     if (!_logReplayConfig) {
         qWarning() << "Internal error";
@@ -83,6 +84,7 @@ LogReplayLink::LogReplayLink(SharedLinkConfigurationPointer& config)
     QObject::connect(this, &LogReplayLink::_playOnThread, this, &LogReplayLink::_play);
     QObject::connect(this, &LogReplayLink::_pauseOnThread, this, &LogReplayLink::_pause);
     QObject::connect(this, &LogReplayLink::_setAccelerationFactorOnThread, this, &LogReplayLink::_setAccelerationFactor);
+    QObject::connect(this, &LogReplayLink::_setFastReplayOnThread, this, &LogReplayLink::_setFastReplay);
     
     moveToThread(this);
 }
@@ -164,16 +166,10 @@ void LogReplayLink::_writeBytes(const QByteArray bytes)
 /// @return A Unix timestamp in microseconds UTC for found message or 0 if parsing failed
 quint64 LogReplayLink::_parseTimestamp(const QByteArray& bytes)
 {
-    quint64 timestamp = qFromBigEndian(*((quint64*)(bytes.constData())));
-    quint64 currentTimestamp = ((quint64)QDateTime::currentMSecsSinceEpoch()) * 1000;
-    
-    // Now if the parsed timestamp is in the future, it must be an old file where the timestamp was stored as
-    // little endian, so switch it.
-    if (timestamp > currentTimestamp) {
-        timestamp = qbswap(timestamp);
+    if (bytes.size() < cbTimestamp) {
+        return 0;
     }
-    
-    return timestamp;
+    return LogReplayIndex::parseTimestamp(bytes.constData());
 }
 
 /// Reads the next mavlink message from the log
@@ -258,27 +254,18 @@ bool LogReplayLink::_loadLogFile(void)
     _logTimestamped = logFilename.endsWith(".tlog");
     
     if (_logTimestamped) {
-        // Get the first timestamp from the log
-        // This should be a big-endian uint64.
-        QByteArray timestamp = _logFile.read(cbTimestamp);
-        quint64 startTimeUSecs = _parseTimestamp(timestamp);
-        
-        // Now find the last timestamp by scanning for the last MAVLink packet and
-        // find the timestamp before it. To do this we start searchin a little before
-        // the end of the file, specifically the maximum MAVLink packet size + the
-        // timestamp size. This guarantees that we will hit a MAVLink packet before
-        // the end of the file. Unfortunately, it basically guarantees that we will
-        // hit more than one. This is why we have to search for a bit.
-        qint64 fileLoc = _logFile.size() - MAVLINK_MAX_PACKET_LEN - cbTimestamp;
-        _logFile.seek(fileLoc);
-        quint64 endTimeUSecs = startTimeUSecs; // Set a sane default for the endtime
-        mavlink_message_t msg;
-        quint64 messageTimeUSecs;
-        while ((messageTimeUSecs = _seekToNextMavlinkMessage(&msg)) > endTimeUSecs) {
-            endTimeUSecs = messageTimeUSecs;
+        // Seeking uses the time index. Use the sidecar index if there is an up to date one, otherwise build it
+        // now and save it for the next time this log is opened.
+        if (!_index.load(logFilename)) {
+            if (_index.build(_logFile)) {
+                _index.save(logFilename);
+            }
         }
-        
-        if (endTimeUSecs == startTimeUSecs) {
+
+        quint64 startTimeUSecs  = _index.startTimeUSecs();
+        quint64 endTimeUSecs    = _index.endTimeUSecs();
+
+        if (_index.isEmpty() || endTimeUSecs == startTimeUSecs) {
             errorMsg = tr("The log file '%1' is corrupt. No valid timestamps were found at the end of the file.").arg(logFilename);
             goto Error;
         }
@@ -289,8 +276,8 @@ bool LogReplayLink::_loadLogFile(void)
         _logDurationUSecs = endTimeUSecs - startTimeUSecs;
         _logCurrentTimeUSecs = startTimeUSecs;
 
-        // Reset our log file so when we go to read it for the first time, we start at the beginning.
-        _logFile.reset();
+        // Position the log file at the first message, skipping any leading garbage found by the index.
+        _logFile.seek(_index.entryForTime(startTimeUSecs).offset + cbTimestamp);
         
         logDurationSecondsTotal = (_logDurationUSecs) / 1000000;
     } else {
@@ -337,6 +324,45 @@ void LogReplayLink::_readNextLogEntry(void)
 {
     QByteArray bytes;
 
+    if (_fastReplay) {
+        // Send out as much as we can per tick. The tick timer runs with a zero interval so we still go back to the
+        // event loop between chunks to process pause and seek requests. MAVLinkProtocol processes the batches on
+        // the main thread, so back off while it is behind instead of piling batches up in its event queue.
+        if (pendingMessageBatches() >= _fastReplayMaxPendingBatches) {
+            if (_readTickTimer.interval() != _fastReplayThrottleMSecs) {
+                _readTickTimer.start(_fastReplayThrottleMSecs);
+            }
+            return;
+        }
+        if (_readTickTimer.interval() != 0) {
+            _readTickTimer.start(0);
+        }
+
+        if (_logTimestamped) {
+            QByteArray chunk;
+            while (chunk.size() < _fastReplayChunkBytes) {
+                qint64 nextTimeUSecs = _readNextMavlinkMessage(bytes);
+                chunk.append(bytes);
+                if (_logFile.atEnd()) {
+                    break;
+                }
+                _logCurrentTimeUSecs = nextTimeUSecs;
+            }
+            emit bytesReceived(this, chunk);
+            emit playbackPercentCompleteChanged(((float)(_logCurrentTimeUSecs - _logStartTimeUSecs) / (float)_logDurationUSecs) * 100);
+            emit currentLogTimeSecs((_logCurrentTimeUSecs - _logStartTimeUSecs) / 1000000);
+        } else {
+            QByteArray chunk = _logFile.read(_fastReplayChunkBytes);
+            emit bytesReceived(this, chunk);
+            emit playbackPercentCompleteChanged(((float)_logFile.pos() / (float)_logFileSize) * 100);
+        }
+
+        if (_logFile.atEnd()) {
+            _finishPlayback();
+        }
+        return;
+    }
+
     // If we have a file with timestamps, try and pace this out following the time differences
     // between the timestamps and the current playback speed.
     if (_logTimestamped) {
@@ -376,14 +402,13 @@ void LogReplayLink::_readNextLogEntry(void)
     else
     {
         // Binary format - read at fixed rate
-        const int len = 100;
-        QByteArray chunk = _logFile.read(len);
+        QByteArray chunk = _logFile.read(_binaryChunkBytes);
         
         emit bytesReceived(this, chunk);
         emit playbackPercentCompleteChanged(((float)_logFile.pos() / (float)_logFileSize) * 100);
         
         // Check if reached end of file before reading next timestamp
-        if (chunk.length() < len || _logFile.atEnd())
+        if (chunk.length() < _binaryChunkBytes || _logFile.atEnd())
         {
             _finishPlayback();
             return;
@@ -409,16 +434,12 @@ void LogReplayLink::_play(void)
     _playbackStartTimeMSecs = (quint64)QDateTime::currentMSecsSinceEpoch() - ((_logCurrentTimeUSecs - _logStartTimeUSecs) / 1000);
     
     // Start timer
-    if (_logTimestamped) {
+    if (_fastReplay) {
+        _readTickTimer.start(0);
+    } else if (_logTimestamped) {
         _readTickTimer.start(1);
     } else {
-        // Read len bytes at a time
-        int len = 100;
-        // Calculate the number of times to read 100 bytes per second
-        // to guarantee the baud rate, then divide 1000 by the number of read
-        // operations to obtain the interval in milliseconds
-        int interval = 1000 / ((_binaryBaudRate / 10) / len);
-        _readTickTimer.start(interval / _replayAccelerationFactor);
+        _readTickTimer.start(_binaryReadInterval() / _replayAccelerationFactor);
     }
     
     emit playbackStarted();
@@ -439,7 +460,11 @@ void LogReplayLink::_pause(void)
 void LogReplayLink::_resetPlaybackToBeginning(void)
 {
     if (_logFile.isOpen()) {
-        _logFile.reset();
+        if (_logTimestamped) {
+            _logFile.seek(_index.entryForTime(_logStartTimeUSecs).offset + cbTimestamp);
+        } else {
+            _logFile.reset();
+        }
     }
     
     // And since we haven't starting playback, clear the time of initial playback and the current timestamp.
@@ -462,42 +487,13 @@ void LogReplayLink::movePlayhead(int percentComplete)
     float floatPercentComplete = (float)percentComplete / 100.0f;
     
     if (_logTimestamped) {
-        // But if we have a timestamped MAVLink log, then actually aim to hit that percentage in terms of
-        // time through the file.
-        qint64 newFilePos = (qint64)(floatPercentComplete * (float)_logFile.size());
-        
-        // Now seek to the appropriate position, failing gracefully if we can't.
-        if (!_logFile.seek(newFilePos)) {
-            _replayError(tr("Unable to seek to new position"));
+        // Timestamped logs use the time index so the playhead position maps to log time
+        if (!_seekToTime(_logStartTimeUSecs + (quint64)(floatPercentComplete * _logDurationUSecs))) {
             return;
         }
         
-        // But we do align to the next MAVLink message for consistency.
-        mavlink_message_t dummy;
-        _logCurrentTimeUSecs = _seekToNextMavlinkMessage(&dummy);
-        
-        // Now calculate the current file location based on time.
-        float newRelativeTimeUSecs = (float)(_logCurrentTimeUSecs - _logStartTimeUSecs);
-        
-        // Calculate the effective baud rate of the file in bytes/s.
-        float baudRate = _logFile.size() / (float)_logDurationUSecs / 1e6;
-        
-        // And the desired time is:
-        float desiredTimeUSecs = floatPercentComplete * _logDurationUSecs;
-        
-        // And now jump the necessary number of bytes in the proper direction
-        qint64 offset = (newRelativeTimeUSecs - desiredTimeUSecs) * baudRate;
-        if (!_logFile.seek(_logFile.pos() + offset)) {
-            _replayError(tr("Unable to seek to new position"));
-            return;
-        }
-        
-        // And scan until we reach the start of a MAVLink message. We make sure to record this timestamp for
-        // smooth jumping around the file.
-        _logCurrentTimeUSecs = _seekToNextMavlinkMessage(&dummy);
-        
         // Now update the UI with our actual final position.
-        newRelativeTimeUSecs = (float)(_logCurrentTimeUSecs - _logStartTimeUSecs);
+        float newRelativeTimeUSecs = (float)(_logCurrentTimeUSecs - _logStartTimeUSecs);
         percentComplete = (newRelativeTimeUSecs / _logDurationUSecs) * 100;
         emit playbackPercentCompleteChanged(percentComplete);
     } else {
@@ -517,6 +513,39 @@ void LogReplayLink::movePlayhead(int percentComplete)
     }
 }
 
+void LogReplayLink::movePlayheadToTime(int secs)
+{
+    if (isPlaying()) {
+        qWarning() << "Should not move playhead while playing, pause first";
+        return;
+    }
+
+    if (!_logTimestamped) {
+        qWarning() << "movePlayheadToTime requires a timestamped log";
+        return;
+    }
+
+    if (_seekToTime(_logStartTimeUSecs + (quint64)qMax(secs, 0) * 1000000)) {
+        emit playbackPercentCompleteChanged(((float)(_logCurrentTimeUSecs - _logStartTimeUSecs) / (float)_logDurationUSecs) * 100);
+        emit currentLogTimeSecs((_logCurrentTimeUSecs - _logStartTimeUSecs) / 1000000);
+    }
+}
+
+/// Positions the log file at the indexed message closest to, but not after, the specified time. The file
+/// is left positioned at the start of the message with _logCurrentTimeUSecs set to its timestamp.
+bool LogReplayLink::_seekToTime(quint64 timeUSecs)
+{
+    LogReplayIndex::Entry_t entry = _index.entryForTime(timeUSecs);
+
+    if (!_logFile.seek(entry.offset + cbTimestamp)) {
+        _replayError(tr("Unable to seek to new position"));
+        return false;
+    }
+    _logCurrentTimeUSecs = entry.timeUSecs;
+
+    return true;
+}
+
 void LogReplayLink::_setAccelerationFactor(int factor)
 {
     // factor: -100: 0.01X, 0: 1.0X, 100: 100.0X
@@ -534,15 +563,32 @@ void LogReplayLink::_setAccelerationFactor(int factor)
     }
     
     // Update timer interval
-    if (!_logTimestamped) {
-        // Read len bytes at a time
-        int len = 100;
-        // Calculate the number of times to read 100 bytes per second
-        // to guarantee the baud rate, then divide 1000 by the number of read
-        // operations to obtain the interval in milliseconds
-        int interval = 1000 / ((_binaryBaudRate / 10) / len);
+    if (!_logTimestamped && !_fastReplay) {
+        _readTickTimer.stop();
+        _readTickTimer.start(_binaryReadInterval() / _replayAccelerationFactor);
+    }
+}
+
+/// @return Timer interval in msecs which paces binary logs at their recorded baud rate
+int LogReplayLink::_binaryReadInterval(void)
+{
+    // Calculate the number of times to read _binaryChunkBytes per second
+    // to guarantee the baud rate, then divide 1000 by the number of read
+    // operations to obtain the interval in milliseconds
+    return 1000 / ((_binaryBaudRate / 10) / _binaryChunkBytes);
+}
+
+void LogReplayLink::_setFastReplay(bool fastReplay)
+{
+    if (fastReplay == _fastReplay) {
+        return;
+    }
+    _fastReplay = fastReplay;
+
+    if (_readTickTimer.isActive()) {
+        // Restart playback from the current position with the new pacing
         _readTickTimer.stop();
-        _readTickTimer.start(interval / _replayAccelerationFactor);
+        _play();
     }
 }
 
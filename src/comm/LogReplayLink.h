@@ -14,6 +14,7 @@
 #include "LinkInterface.h"
 #include "LinkConfiguration.h"
 #include "MAVLinkProtocol.h"
+#include "LogReplayIndex.h"
 
 #include <QTimer>
 #include <QFile>
@@ -68,6 +69,13 @@ public:
     /// Move the playhead to the specified percent complete
     void movePlayhead(int percentComplete);
 
+    /// Move the playhead to the specified time from the start of the log. Timestamped logs only.
+    void movePlayheadToTime(int secs);
+
+    /// Replays the log as fast as possible, without pacing to the log timestamps. Used for batch
+    /// reprocessing of logs.
+    void setFastReplay(bool fastReplay) { emit _setFastReplayOnThread(fastReplay); }
+
     /// Sets the acceleration factor: -100: 0.01X, 0: 1.0X, 100: 100.0X
     void setAccelerationFactor(int factor) { emit _setAccelerationFactorOnThread(factor); }
 
@@ -100,12 +108,14 @@ signals:
     void _playOnThread(void);
     void _pauseOnThread(void);
     void _setAccelerationFactorOnThread(int factor);
+    void _setFastReplayOnThread(bool fastReplay);
 
 private slots:
     void _readNextLogEntry(void);
     void _play(void);
     void _pause(void);
     void _setAccelerationFactor(int factor);
+    void _setFastReplay(bool fastReplay);
 
 private:
     // Links are only created/destroyed by LinkManager so constructor/destructor is not public
@@ -115,6 +125,8 @@ private:
     void _replayError(const QString& errorMsg);
     quint64 _parseTimestamp(const QByteArray& bytes);
     quint64 _seekToNextMavlinkMessage(mavlink_message_t* nextMsg);
+    bool _seekToTime(quint64 timeUSecs);
+    int  _binaryReadInterval(void);
     quint64 _readNextMavlinkMessage(QByteArray& bytes);
     bool _loadLogFile(void);
     void _finishPlayback(void);
@@ -151,8 +163,14 @@ private:
     QFile               _logFile;
     quint64             _logFileSize;
     bool                _logTimestamped;    ///< true: Timestamped log format, false: no timestamps
+    LogReplayIndex      _index;             ///< Time index for timestamped logs
+    bool                _fastReplay;        ///< true: Replay as fast as possible without pacing
 
     static const int cbTimestamp = sizeof(quint64);
+    static const int _binaryChunkBytes      = 100;          ///< Bytes read per tick for paced binary logs
+    static const int _fastReplayChunkBytes  = 64 * 1024;    ///< Bytes sent per tick in fast replay
+    static const int _fastReplayMaxPendingBatches   = 4;    ///< Fast replay waits while this many batches are queued for MAVLinkProtocol
+    static const int _fastReplayThrottleMSecs       = 5;    ///< Tick interval while fast replay is waiting on MAVLinkProtocol
 };
 
 #endif
@@ -0,0 +1,160 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "MAVLinkParser.h"
+#include "QGCLoggingCategory.h"
+
+#include <string.h>
+
+QGC_LOGGING_CATEGORY(MAVLinkParserLog, "MAVLinkParserLog")
+
+MAVLinkMessageBatch::MAVLinkMessageBatch(void)
+    : totalReceived         (0)
+    , totalLoss             (0)
+    , lossPercent           (0.0f)
+    , statusUpdate          (false)
+    , nonMavlinkBytes       (0)
+    , firstMavlinkPacket    (false)
+    , switchedToMavlink2    (false)
+    , radioMavlink1Count    (0)
+{
+
+}
+
+MAVLinkParser::MAVLinkParser(void)
+    : _channel(0)
+{
+    _reset();
+}
+
+void MAVLinkParser::requestReset(void)
+{
+    _resetRequested.store(1);
+    _decodedFirstMavlinkPacket.store(0);
+}
+
+void MAVLinkParser::setOutboundMavlink1(bool mavlink1)
+{
+    QMutexLocker locker(&_channelStatusMutex);
+
+    mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(_channel);
+    if (mavlink1) {
+        mavlinkStatus->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+    } else {
+        mavlinkStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+    }
+}
+
+void MAVLinkParser::_reset(void)
+{
+    memset(&_message,       0, sizeof(_message));
+    memset(&_status,        0, sizeof(_status));
+    memset(_lastIndex,      0, sizeof(_lastIndex));
+    memset(_firstMessage,   1, sizeof(_firstMessage));
+
+    _totalReceiveCounter    = 0;
+    _totalLossCounter       = 0;
+    _runningLossPercent     = 0.0f;
+
+    _decodedFirstMavlinkPacket.store(0);
+}
+
+/// Updates the sequence based loss statistics for the link
+void MAVLinkParser::_updateLossCounters(const mavlink_message_t& message)
+{
+    uint8_t expectedSeq = _lastIndex[message.sysid][message.compid] + 1;
+
+    _totalReceiveCounter++;
+
+    // Determine what the next expected sequence number is, accounting for
+    // never having seen a message for this system/component pair.
+    if (_firstMessage[message.sysid][message.compid]) {
+        _firstMessage[message.sysid][message.compid] = 0;
+        expectedSeq = message.seq;
+    }
+
+    // And if we didn't encounter that sequence number, record the error
+    if (message.seq != expectedSeq) {
+        int lostMessages = 0;
+        //-- Account for overflow during packet loss
+        if (message.seq < expectedSeq) {
+            lostMessages = (message.seq + 255) - expectedSeq;
+        } else {
+            lostMessages = message.seq - expectedSeq;
+        }
+        _totalLossCounter += static_cast<uint64_t>(lostMessages);
+    }
+
+    _lastIndex[message.sysid][message.compid] = message.seq;
+
+    // Calculate new loss ratio
+    uint64_t totalSent = _totalReceiveCounter + _totalLossCounter;
+    float receiveLossPercent = static_cast<float>(static_cast<double>(_totalLossCounter) / static_cast<double>(totalSent));
+    receiveLossPercent *= 100.0f;
+    _runningLossPercent = (receiveLossPercent * 0.5f) + (_runningLossPercent * 0.5f);
+}
+
+bool MAVLinkParser::parse(const QByteArray& bytes, MAVLinkMessageBatch& batch)
+{
+    if (_resetRequested.testAndSetOrdered(1, 0)) {
+        _reset();
+    }
+
+    // mavlink_parse_char updates the channel status flags as well, so the whole chunk is parsed under the lock
+    QMutexLocker locker(&_channelStatusMutex);
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(bytes.constData());
+    const int count = bytes.size();
+
+    for (int position = 0; position < count; position++) {
+        if (mavlink_parse_char(_channel, data[position], &_message, &_status)) {
+            // Got a valid message
+            if (!_decodedFirstMavlinkPacket.load()) {
+                _decodedFirstMavlinkPacket.store(1);
+                batch.firstMavlinkPacket = true;
+                mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(_channel);
+                if (!(mavlinkStatus->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1) && (mavlinkStatus->flags & MAVLINK_STATUS_FLAG_OUT_MAVLINK1)) {
+                    qCDebug(MAVLinkParserLog) << "Switching outbound to mavlink 2.0 due to incoming mavlink 2.0 packet:" << _channel << mavlinkStatus->flags;
+                    mavlinkStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+                    batch.switchedToMavlink2 = true;
+                }
+            }
+
+            _updateLossCounters(_message);
+
+            // Detect if we are talking to an old radio not supporting v2
+            if (_message.msgid == MAVLINK_MSG_ID_RADIO_STATUS) {
+                mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(_channel);
+                if ((mavlinkStatus->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1) && !(mavlinkStatus->flags & MAVLINK_STATUS_FLAG_OUT_MAVLINK1)) {
+                    batch.radioMavlink1Count++;
+                }
+            }
+
+            // Status is reported on every 32th packet
+            if ((_totalReceiveCounter & 0x1F) == 0) {
+                batch.statusUpdate = true;
+            }
+
+            batch.messages.append(_message);
+
+            // Reset message parsing
+            memset(&_status,  0, sizeof(_status));
+            memset(&_message, 0, sizeof(_message));
+        } else if (!_decodedFirstMavlinkPacket.load()) {
+            // No formed message yet
+            batch.nonMavlinkBytes++;
+        }
+    }
+
+    batch.totalReceived = _totalReceiveCounter;
+    batch.totalLoss     = _totalLossCounter;
+    batch.lossPercent   = _runningLossPercent;
+
+    return !batch.isEmpty();
+}
@@ -0,0 +1,92 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMetaType>
+#include <QLoggingCategory>
+
+#include "QGCMAVLink.h"
+
+Q_DECLARE_LOGGING_CATEGORY(MAVLinkParserLog)
+
+/// Set of messages decoded from a single chunk of link bytes. The message vector is implicitly shared
+/// so passing a batch through a queued signal only bumps a reference count instead of copying each
+/// mavlink_message_t.
+class MAVLinkMessageBatch
+{
+public:
+    MAVLinkMessageBatch(void);
+
+    bool isEmpty(void) const { return messages.isEmpty() && nonMavlinkBytes == 0; }
+
+    QVector<mavlink_message_t> messages;
+
+    // Link statistics as of the last message in the batch
+    uint64_t    totalReceived;          ///< Total number of messages received on the link
+    uint64_t    totalLoss;              ///< Total number of messages lost on the link, based on sequence numbers
+    float       lossPercent;            ///< Filtered loss rate
+    bool        statusUpdate;           ///< true: Batch crossed a status reporting boundary (every 32 messages)
+
+    int         nonMavlinkBytes;        ///< Number of bytes seen prior to the first decoded mavlink packet
+    bool        firstMavlinkPacket;     ///< true: First mavlink packet for the link is in this batch
+    bool        switchedToMavlink2;     ///< true: Outbound was switched to mavlink 2 due to incoming mavlink 2 traffic
+    int         radioMavlink1Count;     ///< Number of RADIO_STATUS messages received as mavlink 1 on a mavlink 2 link
+};
+
+Q_DECLARE_METATYPE(MAVLinkMessageBatch)
+
+/// Per-link MAVLink parser. The parser runs on the thread of the link which owns it so that byte level
+/// framing, CRC checks and sequence/loss accounting happen off the GUI thread. Only finished message
+/// batches are handed to MAVLinkProtocol.
+class MAVLinkParser
+{
+public:
+    MAVLinkParser(void);
+
+    /// Sets the mavlink channel used for parsing. Must be called before parse.
+    void setChannel(uint8_t channel) { _channel = channel; }
+
+    /// Parses the specified bytes, appending any completed messages to the batch.
+    ///     @return true: batch has content which should be delivered
+    bool parse(const QByteArray& bytes, MAVLinkMessageBatch& batch);
+
+    /// Requests a reset of all counters and sequence tracking. Safe to call from any thread, the reset
+    /// takes effect before the next chunk of bytes is parsed.
+    void requestReset(void);
+
+    bool decodedFirstMavlinkPacket(void) const { return _decodedFirstMavlinkPacket.load() != 0; }
+
+    /// Switches outbound traffic on the channel between mavlink 1 and 2. Safe to call from any thread, the
+    /// channel status flags are only changed while holding the lock the parser holds while parsing.
+    void setOutboundMavlink1(bool mavlink1);
+
+private:
+    void _reset             (void);
+    void _updateLossCounters(const mavlink_message_t& message);
+
+    uint8_t             _channel;
+    mavlink_message_t   _message;
+    mavlink_status_t    _status;
+
+    QMutex              _channelStatusMutex;        ///< Guards the flags of the mavlink channel status
+    QAtomicInt          _resetRequested;
+    QAtomicInt          _decodedFirstMavlinkPacket;
+
+    uint64_t            _totalReceiveCounter;
+    uint64_t            _totalLossCounter;
+    float               _runningLossPercent;
+
+    uint8_t             _lastIndex[256][256];       ///< Last received sequence ID for each system/component pair
+    uint8_t             _firstMessage[256][256];    ///< First message flag for each system/component pair
+};
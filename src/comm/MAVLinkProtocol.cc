@@ -64,10 +64,7 @@ MAVLinkProtocol::MAVLinkProtocol(QGCApplication* app, QGCToolbox* toolbox)
     , _linkMgr(nullptr)
     , _multiVehicleManager(nullptr)
 {
-    memset(totalReceiveCounter, 0, sizeof(totalReceiveCounter));
-    memset(totalLossCounter,    0, sizeof(totalLossCounter));
-    memset(runningLossPercent,  0, sizeof(runningLossPercent));
-    memset(firstMessage,        1, sizeof(firstMessage));
+
 }
 
 MAVLinkProtocol::~MAVLinkProtocol()
@@ -81,14 +78,8 @@ void MAVLinkProtocol::setVersion(unsigned version)
     QList<LinkInterface*> links = _linkMgr->links();
 
     for (int i = 0; i < links.length(); i++) {
-        mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(links[i]->mavlinkChannel());
-
-        // Set flags for version
-        if (version < 200) {
-            mavlinkStatus->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
-        } else {
-            mavlinkStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
-        }
+        // The link parser owns the channel status flags
+        links[i]->setOutboundMavlink1(version < 200);
     }
 
     _current_version = version;
@@ -105,13 +96,15 @@ void MAVLinkProtocol::setToolbox(QGCToolbox *toolbox)
 
    loadSettings();
 
-   // All the *Counter variables are not initialized here, as they should be initialized
-   // on a per-link basis before those links are used. @see resetMetadataForLink().
+   // Receive counters are maintained per link by MAVLinkParser. @see resetMetadataForLink().
 
    connect(this, &MAVLinkProtocol::protocolStatusMessage,   _app, &QGCApplication::criticalMessageBoxOnMainThread);
    connect(this, &MAVLinkProtocol::saveTelemetryLog,        _app, &QGCApplication::saveTelemetryLogOnMainThread);
    connect(this, &MAVLinkProtocol::checkTelemetrySavePath,  _app, &QGCApplication::checkTelemetrySavePathOnMainThread);
 
+   connect(&_logWriter, &TelemetryLogWriter::writeError,        this, &MAVLinkProtocol::_logWriteError,      Qt::QueuedConnection);
+   connect(&_logWriter, &TelemetryLogWriter::messagesDropped,   this, &MAVLinkProtocol::_logMessagesDropped, Qt::QueuedConnection);
+
    connect(_multiVehicleManager, &MultiVehicleManager::vehicleAdded, this, &MAVLinkProtocol::_vehicleCountChanged);
    connect(_multiVehicleManager, &MultiVehicleManager::vehicleRemoved, this, &MAVLinkProtocol::_vehicleCountChanged);
 
@@ -145,32 +138,27 @@ void MAVLinkProtocol::storeSettings()
 
 void MAVLinkProtocol::resetMetadataForLink(LinkInterface *link)
 {
-    int channel = link->mavlinkChannel();
-    totalReceiveCounter[channel] = 0;
-    totalLossCounter[channel]    = 0;
-    runningLossPercent[channel]  = 0.0f;
-    for(int i = 0; i < 256; i++) {
-        firstMessage[channel][i] =  1;
-    }
-    link->setDecodedFirstMavlinkPacket(false);
+    // Counters live in the link's parser since that is where they are updated
+    link->resetParser();
 }
 
 /**
- * This method parses all incoming bytes and constructs a MAVLink packet.
- * It can handle multiple links in parallel, as each link has it's own buffer/
- * parsing state machine.
- * @param link The interface to read from
- * @see LinkInterface
+ * Handles messages which were parsed on the link thread. Framing, CRC checks and loss accounting
+ * have already been done by the link's MAVLinkParser. What is left here is logging, heartbeat
+ * detection and dispatch to the consumers of messageReceived.
+ * @param link The interface the messages were received on
+ * @param batch Messages parsed from the link
+ * @see MAVLinkParser
  **/
-
-void MAVLinkProtocol::receiveBytes(LinkInterface* link, QByteArray b)
+void MAVLinkProtocol::receiveMessages(LinkInterface* link, MAVLinkMessageBatch batch)
 {
-    // Since receiveBytes signals cross threads we can end up with signals in the queue
+    // Since messagesReceived signals cross threads we can end up with signals in the queue
     // that come through after the link is disconnected. For these we just drop the data
     // since the link is closed.
     if (!_linkMgr->containsLink(link)) {
         return;
     }
+    link->messageBatchProcessed();
 
     uint8_t mavlinkChannel = link->mavlinkChannel();
 
@@ -178,160 +166,94 @@ void MAVLinkProtocol::receiveBytes(LinkInterface* link, QByteArray b)
     static bool checkedUserNonMavlink = false;
     static bool warnedUserNonMavlink  = false;
 
-    for (int position = 0; position < b.size(); position++) {
-        if (mavlink_parse_char(mavlinkChannel, static_cast<uint8_t>(b[position]), &_message, &_status)) {
-            // Got a valid message
-            if (!link->decodedFirstMavlinkPacket()) {
-                link->setDecodedFirstMavlinkPacket(true);
-                mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(mavlinkChannel);
-                if (!(mavlinkStatus->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1) && (mavlinkStatus->flags & MAVLINK_STATUS_FLAG_OUT_MAVLINK1)) {
-                    qDebug() << "Switching outbound to mavlink 2.0 due to incoming mavlink 2.0 packet:" << mavlinkStatus << mavlinkChannel << mavlinkStatus->flags;
-                    mavlinkStatus->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
-                    // Set all links to v2
-                    setVersion(200);
-                }
-            }
-
-            //-----------------------------------------------------------------
-            // MAVLink Status
-            uint8_t lastSeq = lastIndex[_message.sysid][_message.compid];
-            uint8_t expectedSeq = lastSeq + 1;
-            // Increase receive counter
-            totalReceiveCounter[mavlinkChannel]++;
-            // Determine what the next expected sequence number is, accounting for
-            // never having seen a message for this system/component pair.
-            if(firstMessage[_message.sysid][_message.compid]) {
-                firstMessage[_message.sysid][_message.compid] = 0;
-                lastSeq     = _message.seq;
-                expectedSeq = _message.seq;
-            }
-            // And if we didn't encounter that sequence number, record the error
-            //int foo = 0;
-            if (_message.seq != expectedSeq)
-            {
-                //foo = 1;
-                int lostMessages = 0;
-                //-- Account for overflow during packet loss
-                if(_message.seq < expectedSeq) {
-                    lostMessages = (_message.seq + 255) - expectedSeq;
-                } else {
-                    lostMessages = _message.seq - expectedSeq;
-                }
-                // Log how many were lost
-                totalLossCounter[mavlinkChannel] += static_cast<uint64_t>(lostMessages);
-            }
-
-            // And update the last sequence number for this system/component pair
-            lastIndex[_message.sysid][_message.compid] = _message.seq;;
-            // Calculate new loss ratio
-            uint64_t totalSent = totalReceiveCounter[mavlinkChannel] + totalLossCounter[mavlinkChannel];
-            float receiveLossPercent = static_cast<float>(static_cast<double>(totalLossCounter[mavlinkChannel]) / static_cast<double>(totalSent));
-            receiveLossPercent *= 100.0f;
-            receiveLossPercent = (receiveLossPercent * 0.5f) + (runningLossPercent[mavlinkChannel] * 0.5f);
-            runningLossPercent[mavlinkChannel] = receiveLossPercent;
-
-            //qDebug() << foo << _message.seq << expectedSeq << lastSeq << totalLossCounter[mavlinkChannel] << totalReceiveCounter[mavlinkChannel] << totalSentCounter[mavlinkChannel] << "(" << _message.sysid << _message.compid << ")";
-
-            //-----------------------------------------------------------------
-            // Log data
-            if (!_logSuspendError && !_logSuspendReplay && _tempLogFile.isOpen()) {
-                uint8_t buf[MAVLINK_MAX_PACKET_LEN+sizeof(quint64)];
-
-                // Write the uint64 time in microseconds in big endian format before the message.
-                // This timestamp is saved in UTC time. We are only saving in ms precision because
-                // getting more than this isn't possible with Qt without a ton of extra code.
-                quint64 time = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() * 1000);
-                qToBigEndian(time, buf);
-
-                // Then write the message to the buffer
-                int len = mavlink_msg_to_send_buffer(buf + sizeof(quint64), &_message);
-
-                // Determine how many bytes were written by adding the timestamp size to the message size
-                len += sizeof(quint64);
-
-                // Now write this timestamp/message pair to the log.
-                QByteArray b(reinterpret_cast<const char*>(buf), len);
-                if(_tempLogFile.write(b) != len)
-                {
-                    // If there's an error logging data, raise an alert and stop logging.
-                    emit protocolStatusMessage(tr("MAVLink Protocol"), tr("MAVLink Logging failed. Could not write to file %1, logging disabled.").arg(_tempLogFile.fileName()));
-                    _stopLogging();
-                    _logSuspendError = true;
-                }
+    if (batch.switchedToMavlink2) {
+        // Set all links to v2
+        setVersion(200);
+    }
 
-                // Check for the vehicle arming going by. This is used to trigger log save.
-                if (!_vehicleWasArmed && _message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                    mavlink_heartbeat_t state;
-                    mavlink_msg_heartbeat_decode(&_message, &state);
-                    if (state.base_mode & MAV_MODE_FLAG_DECODE_POSITION_SAFETY) {
-                        _vehicleWasArmed = true;
-                    }
+    // Log timestamps are in microseconds UTC. We are only saving in ms precision because
+    // getting more than this isn't possible with Qt without a ton of extra code.
+    quint64 logTime = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch() * 1000);
+
+    for (int i=0; i<batch.messages.count(); i++) {
+        const mavlink_message_t& message = batch.messages.at(i);
+
+        //-----------------------------------------------------------------
+        // Log data
+        if (!_logSuspendError && !_logSuspendReplay && _logWriter.isOpen()) {
+            // The writer thread does the disk I/O, this only queues the message. If storage can't keep
+            // up the message is dropped and counted by the writer.
+            _logWriter.writeMessage(logTime, message);
+
+            // Check for the vehicle arming going by. This is used to trigger log save.
+            if (!_vehicleWasArmed && message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+                mavlink_heartbeat_t state;
+                mavlink_msg_heartbeat_decode(&message, &state);
+                if (state.base_mode & MAV_MODE_FLAG_DECODE_POSITION_SAFETY) {
+                    _vehicleWasArmed = true;
                 }
             }
+        }
 
-            if (_message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
-                _startLogging();
-                mavlink_heartbeat_t heartbeat;
-                mavlink_msg_heartbeat_decode(&_message, &heartbeat);
-                emit vehicleHeartbeatInfo(link, _message.sysid, _message.compid, heartbeat.autopilot, heartbeat.type);
-            }
-
-            if (_message.msgid == MAVLINK_MSG_ID_HIGH_LATENCY2) {
-                _startLogging();
-                mavlink_high_latency2_t highLatency2;
-                mavlink_msg_high_latency2_decode(&_message, &highLatency2);
-                emit vehicleHeartbeatInfo(link, _message.sysid, _message.compid, highLatency2.autopilot, highLatency2.type);
-            }
+        if (message.msgid == MAVLINK_MSG_ID_HEARTBEAT) {
+            _startLogging();
+            mavlink_heartbeat_t heartbeat;
+            mavlink_msg_heartbeat_decode(&message, &heartbeat);
+            emit vehicleHeartbeatInfo(link, message.sysid, message.compid, heartbeat.autopilot, heartbeat.type);
+        }
 
-            // Detect if we are talking to an old radio not supporting v2
-            mavlink_status_t* mavlinkStatus = mavlink_get_channel_status(mavlinkChannel);
-            if (_message.msgid == MAVLINK_MSG_ID_RADIO_STATUS) {
-                if ((mavlinkStatus->flags & MAVLINK_STATUS_FLAG_IN_MAVLINK1)
-                && !(mavlinkStatus->flags & MAVLINK_STATUS_FLAG_OUT_MAVLINK1)) {
+        if (message.msgid == MAVLINK_MSG_ID_HIGH_LATENCY2) {
+            _startLogging();
+            mavlink_high_latency2_t highLatency2;
+            mavlink_msg_high_latency2_decode(&message, &highLatency2);
+            emit vehicleHeartbeatInfo(link, message.sysid, message.compid, highLatency2.autopilot, highLatency2.type);
+        }
 
-                    _radio_version_mismatch_count++;
-                }
-            }
+        // The message is handed out directly since consumers live on this thread
+        emit messageReceived(link, message);
+    }
 
-            if (_radio_version_mismatch_count == 5) {
-                // Warn the user if the radio continues to send v1 while the link uses v2
-                emit protocolStatusMessage(tr("MAVLink Protocol"), tr("Detected radio still using MAVLink v1.0 on a link with MAVLink v2.0 enabled. Please upgrade the radio firmware."));
-                // Ensure the warning can't get stuck
-                _radio_version_mismatch_count++;
-                // Flick link back to v1
-                qDebug() << "Switching outbound to mavlink 1.0 due to incoming mavlink 1.0 packet:" << mavlinkStatus << mavlinkChannel << mavlinkStatus->flags;
-                mavlinkStatus->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
-            }
+    // Detect if we are talking to an old radio not supporting v2
+    if (batch.radioMavlink1Count && _radio_version_mismatch_count < 5) {
+        _radio_version_mismatch_count = qMin(_radio_version_mismatch_count + batch.radioMavlink1Count, 5u);
+        if (_radio_version_mismatch_count == 5) {
+            // Warn the user if the radio continues to send v1 while the link uses v2
+            emit protocolStatusMessage(tr("MAVLink Protocol"), tr("Detected radio still using MAVLink v1.0 on a link with MAVLink v2.0 enabled. Please upgrade the radio firmware."));
+            // Ensure the warning can't get stuck
+            _radio_version_mismatch_count++;
+            // Flick link back to v1
+            qDebug() << "Switching outbound to mavlink 1.0 due to incoming mavlink 1.0 packet:" << mavlinkChannel;
+            link->setOutboundMavlink1(true);
+        }
+    }
 
-            // Update MAVLink status on every 32th packet
-            if ((totalReceiveCounter[mavlinkChannel] & 0x1F) == 0) {
-                emit mavlinkMessageStatus(_message.sysid, totalSent, totalReceiveCounter[mavlinkChannel], totalLossCounter[mavlinkChannel], receiveLossPercent);
+    // Update MAVLink status on every 32th packet. The counters are for the whole link, so every system which is
+    // part of the batch gets them rather than just whichever one happened to send the last message.
+    if (batch.statusUpdate) {
+        QList<int> statusSystemIds;
+        foreach (const mavlink_message_t& message, batch.messages) {
+            if (!statusSystemIds.contains(message.sysid)) {
+                statusSystemIds.append(message.sysid);
+                emit mavlinkMessageStatus(message.sysid, batch.totalReceived + batch.totalLoss, batch.totalReceived, batch.totalLoss, batch.lossPercent);
             }
+        }
+    }
 
-            // The packet is emitted as a whole, as it is only 255 - 261 bytes short
-            // kind of inefficient, but no issue for a groundstation pc.
-            // It buys as reentrancy for the whole code over all threads
-            emit messageReceived(link, _message);
-            // Reset message parsing
-            memset(&_status,  0, sizeof(_status));
-            memset(&_message, 0, sizeof(_message));
-        } else if (!link->decodedFirstMavlinkPacket()) {
-            // No formed message yet
-            nonmavlinkCount++;
-            if (nonmavlinkCount > 1000 && !warnedUserNonMavlink) {
-                // 1000 bytes with no mavlink message. Are we connected to a mavlink capable device?
-                if (!checkedUserNonMavlink) {
-                    link->requestReset();
-                    checkedUserNonMavlink = true;
-                } else {
-                    warnedUserNonMavlink = true;
-                    // Disconnect the link since it's some other device and
-                    // QGC clinging on to it and feeding it data might have unintended
-                    // side effects (e.g. if its a modem)
-                    qDebug() << "disconnected link" << link->getName() << "as it contained no MAVLink data";
-                    QMetaObject::invokeMethod(_linkMgr, "disconnectLink", Q_ARG( LinkInterface*, link ) );
-                    return;
-                }
+    if (batch.nonMavlinkBytes && !link->decodedFirstMavlinkPacket()) {
+        nonmavlinkCount += batch.nonMavlinkBytes;
+        if (nonmavlinkCount > 1000 && !warnedUserNonMavlink) {
+            // 1000 bytes with no mavlink message. Are we connected to a mavlink capable device?
+            if (!checkedUserNonMavlink) {
+                link->requestReset();
+                checkedUserNonMavlink = true;
+            } else {
+                warnedUserNonMavlink = true;
+                // Disconnect the link since it's some other device and
+                // QGC clinging on to it and feeding it data might have unintended
+                // side effects (e.g. if its a modem)
+                qDebug() << "disconnected link" << link->getName() << "as it contained no MAVLink data";
+                QMetaObject::invokeMethod(_linkMgr, "disconnectLink", Q_ARG( LinkInterface*, link ) );
+                return;
             }
         }
     }
@@ -381,14 +303,19 @@ void MAVLinkProtocol::_vehicleCountChanged(void)
 /// @brief Closes the log file if it is open
 bool MAVLinkProtocol::_closeLogFile(void)
 {
-    if (_tempLogFile.isOpen()) {
-        if (_tempLogFile.size() == 0) {
+    if (_logWriter.isOpen()) {
+        _logWriter.closeLog();
+        if (_logWriter.droppedMessageCount()) {
+            quint64 totalCount = _logWriter.messageCount() + _logWriter.droppedMessageCount();
+            qCWarning(MAVLinkProtocolLog) << "Telemetry log dropped" << _logWriter.droppedMessageCount() << "of" << totalCount << "messages";
+            _app->showMessage(tr("Flight Data log is incomplete. %1 of %2 messages were dropped since storage could not keep up.").arg(_logWriter.droppedMessageCount()).arg(totalCount));
+        }
+        if (QFileInfo(_tempLogFile.fileName()).size() == 0) {
             // Don't save zero byte files
             _tempLogFile.remove();
+            QFile::remove(LogReplayIndex::indexFileName(_tempLogFile.fileName()));
             return false;
         } else {
-            _tempLogFile.flush();
-            _tempLogFile.close();
             return true;
         }
     }
@@ -401,20 +328,25 @@ void MAVLinkProtocol::_startLogging(void)
     if (qgcApp()->runningUnitTests()) {
         return;
     }
+    AppSettings* appSettings = _app->toolbox()->settingsManager()->appSettings();
 #ifdef __mobile__
     //-- Mobile build don't write to /tmp unless told to do so
-    if (!_app->toolbox()->settingsManager()->appSettings()->telemetrySave()->rawValue().toBool()) {
+    if (!appSettings->telemetrySave()->rawValue().toBool()) {
         return;
     }
 #endif
     //-- Log is always written to a temp file. If later the user decides they want
     //   it, it's all there for them.
-    if (!_tempLogFile.isOpen()) {
+    if (!_logWriter.isOpen()) {
         if (!_logSuspendReplay) {
-            if (!_tempLogFile.open()) {
+            // The temp file is only used to pick a unique name, the writer thread does the actual writing
+            bool opened = _tempLogFile.open();
+            _tempLogFile.close();
+            _logWriter.setSyncInterval(appSettings->telemetrySaveSyncInterval()->rawValue().toInt() * 1000);
+            if (!opened || !_logWriter.openLog(_tempLogFile.fileName())) {
                 emit protocolStatusMessage(tr("MAVLink Protocol"), tr("Opening Flight Data file for writing failed. "
                                                                       "Unable to write to %1. Please choose a different file location.").arg(_tempLogFile.fileName()));
-                _closeLogFile();
+                _tempLogFile.remove();
                 _logSuspendError = true;
                 return;
             }
@@ -429,13 +361,14 @@ void MAVLinkProtocol::_startLogging(void)
 
 void MAVLinkProtocol::_stopLogging(void)
 {
-    if (_tempLogFile.isOpen()) {
+    if (_logWriter.isOpen()) {
         if (_closeLogFile()) {
             if ((_vehicleWasArmed || _app->toolbox()->settingsManager()->appSettings()->telemetrySaveNotArmed()->rawValue().toBool()) &&
                 _app->toolbox()->settingsManager()->appSettings()->telemetrySave()->rawValue().toBool()) {
                 emit saveTelemetryLog(_tempLogFile.fileName());
             } else {
                 QFile::remove(_tempLogFile.fileName());
+                QFile::remove(LogReplayIndex::indexFileName(_tempLogFile.fileName()));
             }
         }
     }
@@ -458,12 +391,27 @@ void MAVLinkProtocol::checkForLostLogFiles(void)
         if (fileInfo.size() == 0) {
             // Delete all zero length files
             QFile::remove(fileInfo.filePath());
+            QFile::remove(LogReplayIndex::indexFileName(fileInfo.filePath()));
             continue;
         }
         emit saveTelemetryLog(fileInfo.filePath());
     }
 }
 
+void MAVLinkProtocol::_logWriteError(const QString& errorString)
+{
+    // If there's an error logging data, raise an alert and stop logging.
+    emit protocolStatusMessage(tr("MAVLink Protocol"), tr("MAVLink Logging failed. Could not write to file %1 (%2), logging disabled.").arg(_tempLogFile.fileName()).arg(errorString));
+    _stopLogging();
+    _logSuspendError = true;
+}
+
+void MAVLinkProtocol::_logMessagesDropped(void)
+{
+    // Logging continues, but let the user know right away that the log will have gaps
+    _app->showMessage(tr("Flight Data logging is not keeping up with incoming data. Messages are being dropped from the log."));
+}
+
 void MAVLinkProtocol::suspendLogForReplay(bool suspend)
 {
     _logSuspendReplay = suspend;
@@ -473,8 +421,9 @@ void MAVLinkProtocol::deleteTempLogFiles(void)
 {
     QDir tempDir(QStandardPaths::writableLocation(QStandardPaths::TempLocation));
 
-    QString filter(QString("*.%1").arg(_logFileExtension));
-    QFileInfoList fileInfoList = tempDir.entryInfoList(QStringList(filter), QDir::Files);
+    QStringList filters;
+    filters << QString("*.%1").arg(_logFileExtension) << LogReplayIndex::indexFileName(QString("*.%1").arg(_logFileExtension));
+    QFileInfoList fileInfoList = tempDir.entryInfoList(filters, QDir::Files);
 
     foreach(const QFileInfo fileInfo, fileInfoList) {
         QFile::remove(fileInfo.filePath());
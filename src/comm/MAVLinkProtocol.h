@@ -23,6 +23,7 @@
 #include "QGCMAVLink.h"
 #include "QGC.h"
 #include "QGCTemporaryFile.h"
+#include "TelemetryLogWriter.h"
 #include "QGCToolbox.h"
 
 class LinkManager;
@@ -80,8 +81,8 @@ public:
     virtual void setToolbox(QGCToolbox *toolbox);
 
 public slots:
-    /** @brief Receive bytes from a communication interface */
-    void receiveBytes(LinkInterface* link, QByteArray b);
+    /** @brief Receive messages parsed on the thread of a communication interface */
+    void receiveMessages(LinkInterface* link, MAVLinkMessageBatch batch);
     
     /** @brief Set the system id of this application */
     void setSystemId(int id);
@@ -102,14 +103,6 @@ public slots:
 
 protected:
     bool        m_enable_version_check;                         ///< Enable checking of version match of MAV and QGC
-    uint8_t     lastIndex[256][256];                            ///< Store the last received sequence ID for each system/componenet pair
-    uint8_t     firstMessage[256][256];                         ///< First message flag
-    uint64_t    totalReceiveCounter[MAVLINK_COMM_NUM_BUFFERS];  ///< The total number of successfully received messages
-    uint64_t    totalLossCounter[MAVLINK_COMM_NUM_BUFFERS];     ///< Total messages lost during transmission.
-    float       runningLossPercent[MAVLINK_COMM_NUM_BUFFERS];   ///< Loss rate
-
-    mavlink_message_t _message = {};
-    mavlink_status_t _status   = {};
 
     bool        versionMismatchIgnore;
     int         systemId;
@@ -153,6 +146,8 @@ signals:
 
 private slots:
     void _vehicleCountChanged(void);
+    void _logWriteError(const QString& errorString);
+    void _logMessagesDropped(void);
     
 private:
     bool _closeLogFile(void);
@@ -163,7 +158,8 @@ private:
     bool _logSuspendReplay;     ///< true: Logging suspended due to replay
     bool _vehicleWasArmed;      ///< true: Vehicle was armed during log sequence
 
-    QGCTemporaryFile    _tempLogFile;            ///< File to log to
+    QGCTemporaryFile    _tempLogFile;            ///< Provides the unique name of the file to log to
+    TelemetryLogWriter  _logWriter;              ///< Writes the log file on a separate thread
     static const char*  _tempLogFileTemplate;    ///< Template for temporary log file
     static const char*  _logFileExtension;       ///< Extension for log files
 
@@ -14,11 +14,13 @@
 
 #ifdef UNITTEST_BUILD
 #include "UnitTest.h"
+#include "ParameterFTPLoader.h"
 #endif
 
 #include <QTimer>
 #include <QDebug>
 #include <QFile>
+#include <QtEndian>
 
 #include <string.h>
 
@@ -78,6 +80,9 @@ MockLink::MockLink(SharedLinkConfigurationPointer& config)
     , _sendGPSPositionDelayCount            (100)   // No gps lock for 5 seconds
     , _currentParamRequestListComponentIndex(-1)
     , _currentParamRequestListParamIndex    (-1)
+    , _logDownloadFileSize                  (1000)
+    , _logDownloadPacketsPerTick            (1)
+    , _logDownloadLossPct                   (0)
     , _logDownloadCurrentOffset             (0)
     , _logDownloadBytesRemaining            (0)
     , _adsbAngle                            (0)
@@ -101,6 +106,10 @@ MockLink::MockLink(SharedLinkConfigurationPointer& config)
     moveToThread(this);
 
     _loadParams();
+    if (_firmwareType == MAV_AUTOPILOT_ARDUPILOTMEGA) {
+        // ArduPilot also serves the autopilot parameters as a single file over FTP
+        _fileServer->setFileContents(ParameterFTPLoader::packedFilePath, _packedParamFile());
+    }
 
     _adsbVehicleCoordinate = QGeoCoordinate(_vehicleLatitude, _vehicleLongitude).atDistanceAndAzimuth(1000, _adsbAngle);
     _adsbVehicleCoordinate.setAltitude(100);
@@ -297,6 +306,71 @@ void MockLink::_loadParams(void)
     }
 }
 
+/// Creates the packed parameter file for the autopilot component, see ParameterFTPLoader for the format
+QByteArray MockLink::_packedParamFile(void)
+{
+    const QMap<QString, QVariant>&  params = _mapParamName2Value[_vehicleComponentId];
+    QByteArray                      bytes;
+    uchar                           buffer[4];
+
+    qToLittleEndian<quint16>(ParameterFTPLoader::packedFileMagic, buffer);
+    bytes.append(reinterpret_cast<const char*>(buffer), 2);
+    qToLittleEndian<quint16>(static_cast<quint16>(params.count()), buffer);
+    bytes.append(reinterpret_cast<const char*>(buffer), 2);
+    bytes.append(reinterpret_cast<const char*>(buffer), 2);
+
+    QString previousName;
+    foreach (const QString& paramName, params.keys()) {
+        // Only the part of the name which differs from the previous one is stored
+        int commonCount = 0;
+        while (commonCount < 15 && commonCount < paramName.length() - 1 && commonCount < previousName.length() && paramName[commonCount] == previousName[commonCount]) {
+            commonCount++;
+        }
+        QByteArray nameSuffix = paramName.mid(commonCount).toLatin1();
+        previousName = paramName;
+
+        // ArduPilot only has signed integer and float parameters
+        int         type;
+        int         valueSize;
+        QVariant    value = params[paramName];
+        switch (_mapParamName2MavParamType[paramName]) {
+        case MAV_PARAM_TYPE_INT8:
+            type = 1;
+            valueSize = 1;
+            buffer[0] = static_cast<uchar>(value.toInt());
+            break;
+        case MAV_PARAM_TYPE_UINT8:
+        case MAV_PARAM_TYPE_INT16:
+            type = 2;
+            valueSize = 2;
+            qToLittleEndian<qint16>(static_cast<qint16>(value.toInt()), buffer);
+            break;
+        case MAV_PARAM_TYPE_REAL32:
+        {
+            float   floatValue = value.toFloat();
+            quint32 floatBits;
+            memcpy(&floatBits, &floatValue, sizeof(floatBits));
+            type = 4;
+            valueSize = 4;
+            qToLittleEndian<quint32>(floatBits, buffer);
+        }
+            break;
+        default:
+            type = 3;
+            valueSize = 4;
+            qToLittleEndian<qint32>(static_cast<qint32>(value.toLongLong()), buffer);
+            break;
+        }
+
+        bytes.append(static_cast<char>(type));
+        bytes.append(static_cast<char>(commonCount | ((nameSuffix.length() - 1) << 4)));
+        bytes.append(nameSuffix);
+        bytes.append(reinterpret_cast<const char*>(buffer), valueSize);
+    }
+
+    return bytes;
+}
+
 void MockLink::_sendHeartBeat(void)
 {
     mavlink_message_t   msg;
@@ -1318,6 +1392,21 @@ void MockLink::_handleLogRequestData(const mavlink_message_t& msg)
     _logDownloadBytesRemaining = request.count;
 }
 
+void MockLink::setLogDownloadSimulation(uint32_t fileSize, int packetsPerTick, int lossPct)
+{
+    _logDownloadFileSize = fileSize;
+    _logDownloadPacketsPerTick = packetsPerTick;
+    _logDownloadLossPct = lossPct;
+
+    // Create a large file up front, doing it on the first request would stall the download
+    if (!_logDownloadFilename.isEmpty()) {
+        QFile::remove(_logDownloadFilename);
+    }
+#ifdef UNITTEST_BUILD
+    _logDownloadFilename = UnitTest::createRandomFile(_logDownloadFileSize);
+#endif
+}
+
 void MockLink::_logDownloadWorker(void)
 {
     if (_logDownloadBytesRemaining != 0) {
@@ -1325,25 +1414,32 @@ void MockLink::_logDownloadWorker(void)
         if (file.open(QIODevice::ReadOnly)) {
             uint8_t buffer[MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN];
 
-            qint64 bytesToRead = qMin(_logDownloadBytesRemaining, (uint32_t)MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
-            Q_ASSERT(file.seek(_logDownloadCurrentOffset));
-            Q_ASSERT(file.read((char *)buffer, bytesToRead) == bytesToRead);
-
-            qDebug() << "MockLink::_logDownloadWorker" << _logDownloadCurrentOffset << _logDownloadBytesRemaining;
-
-            mavlink_message_t responseMsg;
-            mavlink_msg_log_data_pack_chan(_vehicleSystemId,
-                                           _vehicleComponentId,
-                                           _mavlinkChannel,
-                                           &responseMsg,
-                                           _logDownloadLogId,
-                                           _logDownloadCurrentOffset,
-                                           bytesToRead,
-                                           &buffer[0]);
-            respondWithMavlinkMessage(responseMsg);
-
-            _logDownloadCurrentOffset += bytesToRead;
-            _logDownloadBytesRemaining -= bytesToRead;
+            for (int i=0; i<_logDownloadPacketsPerTick && _logDownloadBytesRemaining != 0; i++) {
+                qint64 bytesToRead = qMin(_logDownloadBytesRemaining, (uint32_t)MAVLINK_MSG_LOG_DATA_FIELD_DATA_LEN);
+                bool seekOk = file.seek(_logDownloadCurrentOffset);
+                bool readOk = file.read((char *)buffer, bytesToRead) == bytesToRead;
+                Q_ASSERT(seekOk && readOk);
+                Q_UNUSED(seekOk);
+                Q_UNUSED(readOk);
+
+                qCDebug(MockLinkVerboseLog) << "MockLink::_logDownloadWorker" << _logDownloadCurrentOffset << _logDownloadBytesRemaining;
+
+                if (_logDownloadLossPct == 0 || (qrand() % 100) >= _logDownloadLossPct) {
+                    mavlink_message_t responseMsg;
+                    mavlink_msg_log_data_pack_chan(_vehicleSystemId,
+                                                   _vehicleComponentId,
+                                                   _mavlinkChannel,
+                                                   &responseMsg,
+                                                   _logDownloadLogId,
+                                                   _logDownloadCurrentOffset,
+                                                   bytesToRead,
+                                                   &buffer[0]);
+                    respondWithMavlinkMessage(responseMsg);
+                }
+
+                _logDownloadCurrentOffset += bytesToRead;
+                _logDownloadBytesRemaining -= bytesToRead;
+            }
 
             file.close();
         } else {
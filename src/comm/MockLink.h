@@ -148,9 +148,16 @@ public:
     /// Reset the state of the MissionItemHandler to no items, no transactions in progress.
     void resetMissionItemHandler(void) { _missionItemHandler.reset(); }
 
+    /// Adds latency and loss to mission item protocol responses
+    void setMissionItemLinkSimulation(int latencyMsecs, int lossPct) { _missionItemHandler.setLinkSimulation(latencyMsecs, lossPct); }
+
     /// Returns the filename for the simulated log file. Only available after a download is requested.
     QString logDownloadFile(void) { return _logDownloadFilename; }
 
+    /// Sets the size of the simulated log file, how many LOG_DATA packets are sent every 2 msecs and the
+    /// percentage of them which are lost. Must be called before the log list is requested.
+    void setLogDownloadSimulation(uint32_t fileSize, int packetsPerTick, int lossPct);
+
     static MockLink* startPX4MockLink            (bool sendStatusText, MockConfiguration::FailureMode_t failureMode = MockConfiguration::FailNone);
     static MockLink* startGenericMockLink        (bool sendStatusText, MockConfiguration::FailureMode_t failureMode = MockConfiguration::FailNone);
     static MockLink* startAPMArduCopterMockLink  (bool sendStatusText, MockConfiguration::FailureMode_t failureMode = MockConfiguration::FailNone);
@@ -179,6 +186,7 @@ private:
     void _handleIncomingNSHBytes(const char* bytes, int cBytes);
     void _handleIncomingMavlinkBytes(const uint8_t* bytes, int cBytes);
     void _loadParams(void);
+    QByteArray _packedParamFile(void);
     void _handleHeartBeat(const mavlink_message_t& msg);
     void _handleSetMode(const mavlink_message_t& msg);
     void _handleParamRequestList(const mavlink_message_t& msg);
@@ -243,7 +251,9 @@ private:
     int _currentParamRequestListParamIndex;     // Current parameter index for param request list workflow
 
     static const uint16_t _logDownloadLogId = 0;        ///< Id of siumulated log file
-    static const uint32_t _logDownloadFileSize = 1000;  ///< Size of simulated log file
+    uint32_t    _logDownloadFileSize;       ///< Size of simulated log file
+    int         _logDownloadPacketsPerTick; ///< Number of LOG_DATA packets sent each time _logDownloadWorker runs
+    int         _logDownloadLossPct;        ///< Percentage of LOG_DATA packets which are dropped
 
     QString _logDownloadFilename;           ///< Filename for log download which is in progress
     uint32_t    _logDownloadCurrentOffset;  ///< Current offset we are sending from
@@ -27,6 +27,8 @@ const MockLinkFileServer::FileTestCase MockLinkFileServer::rgFileTestCases[MockL
     { "exact.qgc",      sizeof(((FileManager::Request*)0)->data),         1,    true },
     // File is larger than a single Read Ack packets, requires multiple Reads
     { "multi.qgc",      sizeof(((FileManager::Request*)0)->data) + 1,     2,    false },
+    // File requires many bursts
+    { "large.qgc",      (sizeof(((FileManager::Request*)0)->data) * 200) + 17,   201,    false },
 };
 
 // We only support a single fixed session
@@ -39,7 +41,8 @@ MockLinkFileServer::MockLinkFileServer(uint8_t systemIdServer, uint8_t component
     _mockLink(mockLink),
     _lastReplyValid(false),
     _lastReplySequence(0),
-    _randomDropsEnabled(false)
+    _randomDropsEnabled(false),
+    _dataLossPercent(0)
 {
     srand(0); // make sure unit tests are deterministic
 }
@@ -128,7 +131,13 @@ void MockLinkFileServer::_openCommand(uint8_t senderSystemId, uint8_t senderComp
     // Check path against one of our known test cases
 
     bool found = false;
-    for (size_t i=0; i<cFileTestCases; i++) {
+    _readFileContents.clear();
+    if (_fileContents.contains(path)) {
+        found = true;
+        _readFileContents = _fileContents[path];
+        _readFileLength = _readFileContents.size();
+    }
+    for (size_t i=0; !found && i<cFileTestCases; i++) {
         if (path == rgFileTestCases[i].filename) {
             found = true;
             _readFileLength = rgFileTestCases[i].length;
@@ -151,6 +160,15 @@ void MockLinkFileServer::_openCommand(uint8_t senderSystemId, uint8_t senderComp
     _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
 }
 
+/// @brief Returns the byte at the offset in the active file. Test case file data is a repeating sequence of 0x00, 0x01, .. 0xFF.
+uint8_t MockLinkFileServer::_fileByte(uint32_t offset)
+{
+    if (_readFileContents.isEmpty()) {
+        return offset & 0xFF;
+    }
+    return static_cast<uint8_t>(_readFileContents[offset]);
+}
+
 void MockLinkFileServer::_readCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber)
 {
     FileManager::Request	response;
@@ -181,9 +199,9 @@ void MockLinkFileServer::_readCommand(uint8_t senderSystemId, uint8_t senderComp
         return;
     }
     
-    // Write file bytes. Data is a repeating sequence of 0x00, 0x01, .. 0xFF.
+    // Write file bytes
     for (; cDataBytes < sizeof(response.data) && readOffset < _readFileLength; readOffset++, cDataBytes++) {
-        response.data[cDataBytes] = readOffset & 0xFF;
+        response.data[cDataBytes] = _fileByte(readOffset);
     }
     
     // We should always have written something, otherwise there is something wrong with the code above
@@ -194,6 +212,7 @@ void MockLinkFileServer::_readCommand(uint8_t senderSystemId, uint8_t senderComp
     response.hdr.offset = request->hdr.offset;
     response.hdr.opcode = FileManager::kRspAck;
 	response.hdr.req_opcode = FileManager::kCmdReadFile;
+    response.hdr.burstComplete = 0;
 
     _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
 }
@@ -208,11 +227,11 @@ void MockLinkFileServer::_streamCommand(uint8_t senderSystemId, uint8_t senderCo
         return;
     }
     
-    uint32_t readOffset = 0;	// offset into file for reading
-    uint32_t ackOffset = 0;     // offset for ack
-    uint8_t cDataAck;           // number of bytes in ack
+    uint32_t readOffset = request->hdr.offset;  // offset into file for reading
+    uint8_t cDataAck;                           // number of bytes in ack
+    int cPackets = 0;                           // number of packets sent in this burst
     
-    while (readOffset < _readFileLength) {
+    while (readOffset < _readFileLength && cPackets < burstMaxPackets) {
         cDataAck = 0;
         
         if (readOffset != 0) {
@@ -227,27 +246,33 @@ void MockLinkFileServer::_streamCommand(uint8_t senderSystemId, uint8_t senderCo
             }
         }
         
-        // Write file bytes. Data is a repeating sequence of 0x00, 0x01, .. 0xFF.
+        uint32_t ackOffset = readOffset;
+        
+        // Write file bytes
         for (; cDataAck < sizeof(response.data) && readOffset < _readFileLength; readOffset++, cDataAck++) {
-            response.data[cDataAck] = readOffset & 0xFF;
+            response.data[cDataAck] = _fileByte(readOffset);
         }
         
         // We should always have written something, otherwise there is something wrong with the code above
         Q_ASSERT(cDataAck);
+        cPackets++;
         
         response.hdr.session = _sessionId;
         response.hdr.size = cDataAck;
         response.hdr.offset = ackOffset;
         response.hdr.opcode = FileManager::kRspAck;
         response.hdr.req_opcode = FileManager::kCmdBurstReadFile;
+        // The client sends the next Burst request when it sees the end of this one
+        response.hdr.burstComplete = cPackets == burstMaxPackets && readOffset < _readFileLength;
         
         _sendResponse(senderSystemId, senderComponentId, &response, outgoingSeqNumber);
         
         outgoingSeqNumber = _nextSeqNumber(outgoingSeqNumber);
-        ackOffset += cDataAck;
     }
 	
-    _sendNak(senderSystemId, senderComponentId, FileManager::kErrEOF, outgoingSeqNumber, FileManager::kCmdBurstReadFile);
+    if (readOffset >= _readFileLength) {
+        _sendNak(senderSystemId, senderComponentId, FileManager::kErrEOF, outgoingSeqNumber, FileManager::kCmdBurstReadFile);
+    }
 }
 
 void MockLinkFileServer::_terminateCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber)
@@ -412,6 +437,12 @@ void MockLinkFileServer::_sendResponse(uint8_t targetSystemId, uint8_t targetCom
 	        return;
 	    }
 	}
+
+    if (_dataLossPercent > 0 && (request->hdr.req_opcode == FileManager::kCmdReadFile || request->hdr.req_opcode == FileManager::kCmdBurstReadFile)) {
+        if (rand() % 100 < _dataLossPercent) {
+            return;
+        }
+    }
     
     _mockLink->respondWithMavlinkMessage(_lastReply);
 }
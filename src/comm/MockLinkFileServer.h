@@ -17,6 +17,7 @@
 #include "FileManager.h"
 
 #include <QStringList>
+#include <QMap>
 
 class MockLink;
 
@@ -31,6 +32,9 @@ public:
     /// @brief Sets the list of files returned by the List command. Prepend names with F or D
     /// to indicate (F)ile or (D)irectory.
     void setFileList(QStringList& fileList) { _fileList = fileList; }
+
+    /// @brief Adds a file with real contents which can be downloaded, in addition to the test case files.
+    void setFileContents(const QString& path, const QByteArray& contents) { _fileContents[path] = contents; }
     
     /// @brief By calling setErrorMode with one of these modes you can cause the server to simulate an error.
     typedef enum {
@@ -59,19 +63,25 @@ public:
     /// @brief Used to represent a single test case for download testing.
     struct FileTestCase {
         const char* filename;               ///< Filename to download
-        uint8_t     length;                 ///< Length of file in bytes
+        uint32_t    length;                 ///< Length of file in bytes
 		int			packetCount;			///< Number of packets required for data
         bool        exactFit;				///< true: last packet is exact fit, false: last packet is partially filled
     };
     
     /// @brief The numbers of test cases in the rgFileTestCases array.
-    static const size_t cFileTestCases = 3;
+    static const size_t cFileTestCases = 4;
     
     /// @brief The set of files supported by the mock server for testing purposes. Each one represents a different edge case for testing.
     static const FileTestCase rgFileTestCases[cFileTestCases];
     
     void enableRandromDrops(bool enable) { _randomDropsEnabled = enable; }
 
+    /// Drops the given percentage of outgoing Read and Burst responses
+    void setDataLossPercent(int percent) { _dataLossPercent = percent; }
+
+    /// Maximum number of packets sent in response to a single Burst request
+    static const int burstMaxPackets = 20;
+
 signals:
     /// You can connect to this signal to be notified when the server receives a Terminate command.
     void terminateCommandReceived(void);
@@ -90,14 +100,17 @@ private:
     void _terminateCommand(uint8_t senderSystemId, uint8_t senderComponentId, FileManager::Request* request, uint16_t seqNumber);
     void _resetCommand(uint8_t senderSystemId, uint8_t senderComponentId, uint16_t seqNumber);
     uint16_t _nextSeqNumber(uint16_t seqNumber);
+    uint8_t _fileByte(uint32_t offset);
     
     /// if request is a string, this ensures it's null-terminated
     static void ensureNullTemination(FileManager::Request* request);
 
     QStringList _fileList;  ///< List of files returned by List command
+    QMap<QString, QByteArray> _fileContents;    ///< Files set with setFileContents, keyed by path
     
     static const uint8_t    _sessionId;
-    uint8_t                 _readFileLength;    ///< Length of active file being read
+    uint32_t                _readFileLength;    ///< Length of active file being read
+    QByteArray              _readFileContents;  ///< Contents of active file being read, empty for test case files
     ErrorMode_t             _errMode;           ///< Currently set error mode, as specified by setErrorMode
     const uint8_t           _systemIdServer;    ///< System ID for server
     const uint8_t           _componentIdServer; ///< Component ID for server
@@ -108,6 +121,7 @@ private:
     mavlink_message_t _lastReply;
 
     bool _randomDropsEnabled;
+    int  _dataLossPercent;
 };
 
 #endif
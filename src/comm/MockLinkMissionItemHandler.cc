@@ -24,6 +24,9 @@ MockLinkMissionItemHandler::MockLinkMissionItemHandler(MockLink* mockLink, MAVLi
     , _failReadRequestListFirstResponse(true)
     , _failReadRequest1FirstResponse(true)
     , _failWriteMissionCountFirstResponse(true)
+    , _latencyMsecs(0)
+    , _lossPct(0)
+    , _lossRandom(1)
 {
     Q_ASSERT(mockLink);
 }
@@ -39,7 +42,8 @@ void MockLinkMissionItemHandler::_startMissionItemResponseTimer(void)
         _missionItemResponseTimer = new QTimer();
         connect(_missionItemResponseTimer, &QTimer::timeout, this, &MockLinkMissionItemHandler::_missionItemResponseTimeout);
     }
-    _missionItemResponseTimer->start(500);
+    // Allow for the round trip when simulating a slow link
+    _missionItemResponseTimer->start(500 + (2 * _latencyMsecs));
 }
 
 bool MockLinkMissionItemHandler::handleMessage(const mavlink_message_t& msg)
@@ -163,7 +167,7 @@ void MockLinkMissionItemHandler::_handleMissionRequestList(const mavlink_message
                                             msg.compid,                 // Target is original sender
                                             itemCount,                  // Number of mission items
                                             _requestType);
-        _mockLink->respondWithMavlinkMessage(responseMsg);
+        _respond(responseMsg);
     }
 }
 
@@ -237,7 +241,7 @@ void MockLinkMissionItemHandler::_handleMissionRequest(const mavlink_message_t&
                                                item.param1, item.param2, item.param3, item.param4,
                                                item.x, item.y, item.z,
                                                _requestType);
-            _mockLink->respondWithMavlinkMessage(responseMsg);
+            _respond(responseMsg);
         }
     }
 }
@@ -317,7 +321,7 @@ void MockLinkMissionItemHandler::_requestNextMissionItem(int sequenceNumber)
                                                   _mavlinkProtocol->getComponentId(),
                                                   sequenceNumber,
                                                   _requestType);
-            _mockLink->respondWithMavlinkMessage(message);
+            _respond(message);
 
             // If response with Mission Item doesn't come before timer fires it's an error
             _startMissionItemResponseTimer();
@@ -339,7 +343,7 @@ void MockLinkMissionItemHandler::_sendAck(MAV_MISSION_RESULT ackType)
                                       _mavlinkProtocol->getComponentId(),
                                       ackType,
                                       _requestType);
-    _mockLink->respondWithMavlinkMessage(message);
+    _respond(message, false /* allowDrop */);
 }
 
 void MockLinkMissionItemHandler::_handleMissionItem(const mavlink_message_t& msg)
@@ -388,6 +392,13 @@ void MockLinkMissionItemHandler::_handleMissionItem(const mavlink_message_t& msg
 
 void MockLinkMissionItemHandler::_missionItemResponseTimeout(void)
 {
+    if (_lossPct > 0) {
+        // Our request may have been dropped, ask again like a real vehicle would
+        qCDebug(MockLinkMissionItemHandlerLog) << "_missionItemResponseTimeout requesting again" << _writeSequenceIndex;
+        _requestNextMissionItem(_writeSequenceIndex);
+        return;
+    }
+
     qWarning() << "Timeout waiting for next MISSION_ITEM";
     Q_ASSERT(false);
 }
@@ -414,6 +425,31 @@ void MockLinkMissionItemHandler::setMissionItemFailureMode(FailureMode_t failure
     _failureMode = failureMode;
 }
 
+void MockLinkMissionItemHandler::setLinkSimulation(int latencyMsecs, int lossPct)
+{
+    _latencyMsecs = qMax(latencyMsecs, 0);
+    _lossPct = qBound(0, lossPct, 100);
+    _lossRandom = 1;
+}
+
+void MockLinkMissionItemHandler::_respond(const mavlink_message_t& message, bool allowDrop)
+{
+    if (allowDrop && _lossPct > 0) {
+        _lossRandom = (_lossRandom * 1103515245) + 12345;
+        if (static_cast<int>((_lossRandom >> 16) % 100) < _lossPct) {
+            qCDebug(MockLinkMissionItemHandlerLog) << "_respond dropping message" << message.msgid;
+            return;
+        }
+    }
+
+    if (_latencyMsecs > 0) {
+        MockLink* mockLink = _mockLink;
+        QTimer::singleShot(_latencyMsecs, mockLink, [mockLink, message]() { mockLink->respondWithMavlinkMessage(message); });
+    } else {
+        _mockLink->respondWithMavlinkMessage(message);
+    }
+}
+
 void MockLinkMissionItemHandler::shutdown(void)
 {
     if (_missionItemResponseTimer) {
@@ -80,6 +80,13 @@ public:
 
     void setSendHomePositionOnEmptyList(bool sendHomePositionOnEmptyList) { _sendHomePositionOnEmptyList = sendHomePositionOnEmptyList; }
 
+    /// Simulates a slow, lossy link for benchmarking plan transfers. Acks are never dropped since the protocol has no
+    /// way to recover them. A dropped MISSION_REQUEST during a write is sent again when the item doesn't arrive, the
+    /// same as a real vehicle.
+    ///     @param latencyMsecs Delay added to each response
+    ///     @param lossPct Percentage of MISSION_COUNT, MISSION_ITEM and MISSION_REQUEST responses which are dropped
+    void setLinkSimulation(int latencyMsecs, int lossPct);
+
 private slots:
     void _missionItemResponseTimeout(void);
 
@@ -92,6 +99,7 @@ private:
     void _requestNextMissionItem(int sequenceNumber);
     void _sendAck(MAV_MISSION_RESULT ackType);
     void _startMissionItemResponseTimer(void);
+    void _respond(const mavlink_message_t& message, bool allowDrop = true);
 
 private:
     MockLink* _mockLink;
@@ -113,6 +121,9 @@ private:
     bool                _failReadRequestListFirstResponse;
     bool                _failReadRequest1FirstResponse;
     bool                _failWriteMissionCountFirstResponse;
+    int                 _latencyMsecs;
+    int                 _lossPct;
+    quint32             _lossRandom;        ///< Fixed seed so benchmark runs are repeatable
 };
 
 #endif
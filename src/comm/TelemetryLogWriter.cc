@@ -0,0 +1,264 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "TelemetryLogWriter.h"
+#include "QGCLoggingCategory.h"
+
+#include <QtEndian>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+QGC_LOGGING_CATEGORY(TelemetryLogWriterLog, "TelemetryLogWriterLog")
+
+TelemetryLogWriter::TelemetryLogWriter(QObject* parent)
+    : QThread               (parent)
+    , _open                 (false)
+    , _stopRequested        (false)
+    , _appendOffset         (0)
+    , _indexEntriesWritten  (0)
+    , _messageCount         (0)
+    , _droppedMessageCount  (0)
+    , _bytesWritten         (0)
+    , _syncIntervalMsecs    (0)
+    , _writeFailed          (false)
+{
+
+}
+
+TelemetryLogWriter::~TelemetryLogWriter()
+{
+    closeLog();
+}
+
+bool TelemetryLogWriter::openLog(const QString& fileName)
+{
+    if (_open) {
+        qWarning() << "TelemetryLogWriter::openLog called while log already open";
+        closeLog();
+    }
+
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(TelemetryLogWriterLog) << "Unable to open" << fileName << _file.errorString();
+        return false;
+    }
+
+    _currentBlock.clear();
+    _currentBlock.reserve(blockSize);
+    _fullBlocks.clear();
+    _index.clear();
+    _indexEntriesWritten    = 0;
+    _appendOffset           = 0;
+    _stopRequested          = false;
+    _writeFailed            = false;
+    _messageCount           = 0;
+    _droppedMessageCount    = 0;
+    _bytesWritten           = 0;
+    _open                   = true;
+
+    // The index header is written with no log size, so a log which is never closed properly gets its index rebuilt
+    _indexFile.setFileName(LogReplayIndex::indexFileName(fileName));
+    if (!_indexFile.open(QIODevice::WriteOnly | QIODevice::Truncate) || !LogReplayIndex::writeHeader(_indexFile, -1, 0)) {
+        qCWarning(TelemetryLogWriterLog) << "Unable to write index" << _indexFile.fileName() << _indexFile.errorString();
+        _indexFile.close();
+    }
+
+    _syncTimer.start();
+    start(QThread::LowPriority);
+
+    return true;
+}
+
+void TelemetryLogWriter::closeLog(void)
+{
+    if (!_open) {
+        return;
+    }
+
+    _mutex.lock();
+    _stopRequested = true;
+    _blockAvailable.wakeOne();
+    _mutex.unlock();
+
+    wait();
+
+    _file.flush();
+    _syncToStorage();
+    _file.close();
+    _open = false;
+
+    if (_writeFailed) {
+        _indexFile.close();
+        _indexFile.remove();
+    } else {
+        _index.finish(_appendOffset);
+        if (_indexFile.isOpen()) {
+            _streamIndexEntries();
+            if (!_indexFile.seek(0) || !LogReplayIndex::writeHeader(_indexFile, _appendOffset, _index.count())) {
+                qCWarning(TelemetryLogWriterLog) << "Unable to complete index" << _indexFile.fileName() << _indexFile.errorString();
+            }
+            _indexFile.close();
+        } else {
+            _index.save(_file.fileName());
+        }
+    }
+
+    qCDebug(TelemetryLogWriterLog) << "Closed" << _file.fileName() << "messages:bytes:dropped" << _messageCount << _bytesWritten << _droppedMessageCount;
+}
+
+bool TelemetryLogWriter::writeMessage(quint64 timestamp, const mavlink_message_t& message)
+{
+    uint8_t buf[MAVLINK_MAX_PACKET_LEN+sizeof(quint64)];
+
+    // The uint64 time in microseconds goes before the message in big endian format
+    qToBigEndian(timestamp, buf);
+    int len = mavlink_msg_to_send_buffer(buf + sizeof(quint64), &message) + sizeof(quint64);
+
+    QMutexLocker lock(&_mutex);
+
+    if (_writeFailed) {
+        return false;
+    }
+
+    if (_currentBlock.size() + len > blockSize) {
+        if (_fullBlocks.count() >= maxQueuedBlocks) {
+            // Storage is not keeping up. Drop the message rather than stalling the caller.
+            if (_droppedMessageCount++ == 0) {
+                lock.unlock();
+                emit messagesDropped();
+            }
+            return false;
+        }
+        _queueCurrentBlock();
+    }
+
+    _currentBlock.append(reinterpret_cast<const char*>(buf), len);
+    _index.addMessage(timestamp, _appendOffset);
+    _appendOffset += len;
+    _messageCount++;
+
+    return true;
+}
+
+/// Moves the current block to the write queue and starts a new one. Must be called with _mutex held.
+void TelemetryLogWriter::_queueCurrentBlock(void)
+{
+    _fullBlocks.enqueue(_currentBlock);
+    if (_freeBlocks.isEmpty()) {
+        _currentBlock = QByteArray();
+        _currentBlock.reserve(blockSize);
+    } else {
+        _currentBlock = _freeBlocks.takeLast();
+    }
+    _blockAvailable.wakeOne();
+}
+
+void TelemetryLogWriter::run(void)
+{
+    forever {
+        QByteArray block;
+
+        _mutex.lock();
+        if (_fullBlocks.isEmpty() && !_stopRequested) {
+            if (!_blockAvailable.wait(&_mutex, _idleFlushMsecs) && !_currentBlock.isEmpty()) {
+                // Traffic is slow, write out the partial block so the file doesn't lag behind too far.
+                // The next block starts at an unaligned file offset, which is fine since writes go through QFile.
+                _queueCurrentBlock();
+            }
+        }
+        if (_fullBlocks.isEmpty() && _stopRequested && !_currentBlock.isEmpty()) {
+            _queueCurrentBlock();
+        }
+        if (_fullBlocks.isEmpty()) {
+            bool stop = _stopRequested;
+            _mutex.unlock();
+            if (stop) {
+                break;
+            }
+            continue;
+        }
+        block = _fullBlocks.dequeue();
+        _mutex.unlock();
+
+        if (!_writeBlock(block)) {
+            QMutexLocker lock(&_mutex);
+            _writeFailed = true;
+            _fullBlocks.clear();
+            _currentBlock.resize(0);
+            break;
+        }
+
+        _streamIndexEntries();
+
+        if (_syncIntervalMsecs > 0 && _syncTimer.elapsed() > _syncIntervalMsecs) {
+            _file.flush();
+            _syncToStorage();
+            _syncTimer.restart();
+        }
+
+        // Hand the buffer back for reuse. Capacity is kept since it was reserved.
+        block.resize(0);
+        _mutex.lock();
+        _freeBlocks.append(block);
+        _mutex.unlock();
+    }
+}
+
+bool TelemetryLogWriter::_writeBlock(const QByteArray& block)
+{
+    if (_file.write(block) != block.size()) {
+        qCWarning(TelemetryLogWriterLog) << "Write failed" << _file.fileName() << _file.errorString();
+        emit writeError(_file.errorString());
+        return false;
+    }
+    _bytesWritten += static_cast<quint64>(block.size());
+    return true;
+}
+
+/// Appends the index entries which point into data already written to the log to the sidecar index
+void TelemetryLogWriter::_streamIndexEntries(void)
+{
+    if (!_indexFile.isOpen()) {
+        return;
+    }
+
+    QVector<LogReplayIndex::Entry_t> entries;
+    {
+        QMutexLocker lock(&_mutex);
+        while (_indexEntriesWritten < _index.count()) {
+            LogReplayIndex::Entry_t entry = _index.entry(_indexEntriesWritten);
+            if (entry.offset >= static_cast<qint64>(_bytesWritten)) {
+                break;
+            }
+            entries.append(entry);
+            _indexEntriesWritten++;
+        }
+    }
+
+    if (!entries.isEmpty() && !LogReplayIndex::writeEntries(_indexFile, entries)) {
+        qCWarning(TelemetryLogWriterLog) << "Index write failed" << _indexFile.fileName() << _indexFile.errorString();
+        _indexFile.close();
+    }
+}
+
+void TelemetryLogWriter::_syncToStorage(void)
+{
+    if (_syncIntervalMsecs <= 0 || !_file.isOpen()) {
+        return;
+    }
+#ifdef Q_OS_WIN
+    _commit(_file.handle());
+#else
+    fsync(_file.handle());
+#endif
+}
@@ -0,0 +1,111 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include <QThread>
+#include <QFile>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QLoggingCategory>
+
+#include "QGCMAVLink.h"
+#include "LogReplayIndex.h"
+
+Q_DECLARE_LOGGING_CATEGORY(TelemetryLogWriterLog)
+
+/// Writes timestamped mavlink messages to a .mavlink telemetry log on a dedicated thread.
+///
+/// Messages are serialized into blocks of up to blockSize bytes. A full block is handed to the writer thread
+/// while the caller keeps filling the next one, so the receive path never waits on disk I/O. When traffic is
+/// slow the partially filled block is written after _idleFlushMsecs, so file writes are not block aligned.
+/// The number of blocks waiting to be written is bounded; if storage can't keep up, messages are dropped and
+/// counted instead of stalling the caller.
+///
+/// A LogReplayIndex is built as messages are queued. Its entries are streamed to the sidecar index file as the
+/// blocks they point into reach the log, and the index header is completed when the log is closed, so replay
+/// doesn't have to scan the log to seek.
+class TelemetryLogWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    TelemetryLogWriter(QObject* parent = NULL);
+    ~TelemetryLogWriter();
+
+    /// Opens the specified file for writing and starts the writer thread.
+    ///     @return false: file could not be opened
+    bool openLog(const QString& fileName);
+
+    /// Writes out all queued data, stops the writer thread and closes the file.
+    void closeLog(void);
+
+    bool isOpen(void) const { return _open; }
+
+    /// Queues a message for writing. Never blocks on disk I/O.
+    ///     @param timestamp Time in microseconds since epoch (UTC) to write before the message
+    ///     @return false: message was dropped since the write queue is full
+    bool writeMessage(quint64 timestamp, const mavlink_message_t& message);
+
+    /// Sets the interval at which written data is forced to storage with fsync. 0 disables fsync.
+    void setSyncInterval(int msecs) { _syncIntervalMsecs = msecs; }
+
+    quint64 messageCount        (void) const { return _messageCount; }
+    quint64 droppedMessageCount (void) const { return _droppedMessageCount; }
+    quint64 bytesWritten        (void) const { return _bytesWritten; }
+
+    static const int blockSize          = 64 * 1024;    ///< Data is written to disk in chunks of at most this size
+    static const int maxQueuedBlocks    = 32;           ///< Maximum number of full blocks waiting to be written
+
+signals:
+    /// Emitted from the writer thread when a write fails. No further data is written after an error.
+    void writeError(const QString& errorString);
+
+    /// Emitted from the caller of writeMessage when the first message of the log is dropped
+    void messagesDropped(void);
+
+protected:
+    // Overrides from QThread
+    void run(void) final;
+
+private:
+    void _queueCurrentBlock (void);
+    bool _writeBlock        (const QByteArray& block);
+    void _syncToStorage     (void);
+    void _streamIndexEntries(void);
+
+    QFile           _file;
+    bool            _open;
+
+    QMutex          _mutex;             ///< Protects all members below, up to the counters
+    QWaitCondition  _blockAvailable;
+    QByteArray      _currentBlock;      ///< Block currently being filled by writeMessage
+    QQueue<QByteArray> _fullBlocks;     ///< Blocks waiting for the writer thread
+    QList<QByteArray>  _freeBlocks;     ///< Written blocks ready for reuse
+    bool            _stopRequested;
+
+    LogReplayIndex  _index;             ///< Time index of written messages, updated from writeMessage
+    qint64          _appendOffset;      ///< File offset of the next message queued by writeMessage
+    int             _indexEntriesWritten;   ///< Number of _index entries already in the sidecar file
+
+    QFile           _indexFile;         ///< Sidecar index, only accessed from the writer thread while it runs
+
+    quint64         _messageCount;
+    quint64         _droppedMessageCount;
+    quint64         _bytesWritten;      ///< Only updated from the writer thread
+
+    int             _syncIntervalMsecs;
+    QElapsedTimer   _syncTimer;
+    bool            _writeFailed;
+
+    static const unsigned long _idleFlushMsecs = 1000;  ///< Partial blocks are written after this much idle time
+};
@@ -30,6 +30,9 @@
 #include "QGCApplication.h"
 #include "SettingsManager.h"
 #include "AutoConnectSettings.h"
+#include "QGCLoggingCategory.h"
+
+QGC_LOGGING_CATEGORY(UDPLinkLog, "UDPLinkLog")
 
 #define REMOVE_GONE_HOSTS 0
 
@@ -94,6 +97,7 @@ UDPLink::UDPLink(SharedLinkConfigurationPointer& config)
     foreach (const QHostAddress &address, QNetworkInterface::allAddresses()) {
         _localAddress.append(QHostAddress(address));
     }
+    _receiveBuffer.resize(_receiveBufferSize);
     moveToThread(this);
 }
 
@@ -105,6 +109,8 @@ UDPLink::~UDPLink()
     // Clear client list
     qDeleteAll(_sessionTargets);
     _sessionTargets.clear();
+    _sessionTargetKeys.clear();
+    _knownSenders.clear();
     quit();
     // Wait for it to exit
     wait();
@@ -173,7 +179,7 @@ void UDPLink::_writeBytes(const QByteArray data)
     // Send to all manually targeted systems
     foreach(UDPCLient* target, _udpConfig->targetHosts()) {
         // Skip it if it's part of the session clients below
-        if(!contains_target(_sessionTargets, target->address, target->port)) {
+        if(!_sessionTargetKeys.contains(UDPClientKey(target->address, target->port))) {
             _writeDataGram(data, target);
         }
     }
@@ -199,45 +205,74 @@ void UDPLink::_writeDataGram(const QByteArray data, const UDPCLient* target)
 
 /**
  * @brief Read a number of bytes from the interface.
+ *
+ * All pending datagrams are read back to back into the preallocated receive buffer and handed
+ * over to the parser as a single batch.
  **/
 void UDPLink::readBytes()
 {
     if (!_socket) {
         return;
     }
-    QByteArray databuffer;
+    char*   buffer          = _receiveBuffer.data();
+    int     bufferCount     = 0;
+    qint64  totalBytes      = 0;
     while (_socket->hasPendingDatagrams())
     {
-        QByteArray datagram;
-        datagram.resize(_socket->pendingDatagramSize());
+        if (_receiveBufferSize - bufferCount < _maxDatagramSize) {
+            // Not enough room left to guarantee the next datagram fits. Send over what we have.
+            _emitBytesReceived(buffer, bufferCount);
+            bufferCount = 0;
+        }
         QHostAddress sender;
         quint16 senderPort;
         //-- Note: This call is broken in Qt 5.9.3 on Windows. It always returns a blank sender and 0 for the port.
-        _socket->readDatagram(datagram.data(), datagram.size(), &sender, &senderPort);
-        databuffer.append(datagram);
-        //-- Wait a bit before sending it over
-        if(databuffer.size() > 10 * 1024) {
-            emit bytesReceived(this, databuffer);
-            databuffer.clear();
-        }
-        _logInputDataRate(datagram.length(), QDateTime::currentMSecsSinceEpoch());
-        // TODO: This doesn't validade the sender. Anything sending UDP packets to this port gets
-        // added to the list and will start receiving datagrams from here. Even a port scanner
-        // would trigger this.
-        // Add host to broadcast list if not yet present, or update its port
-        QHostAddress asender = sender;
-        if(_isIpLocal(sender)) {
-            asender = QHostAddress(QString("127.0.0.1"));
-        }
-        if(!contains_target(_sessionTargets, asender, senderPort)) {
-            qDebug() << "Adding target" << asender << senderPort;
-            UDPCLient* target = new UDPCLient(asender, senderPort);
-            _sessionTargets.append(target);
+        qint64 length = _socket->readDatagram(buffer + bufferCount, _receiveBufferSize - bufferCount, &sender, &senderPort);
+        if (length < 0) {
+            break;
         }
+        bufferCount += static_cast<int>(length);
+        totalBytes  += length;
+        _addSessionTarget(sender, senderPort);
     }
     //-- Send whatever is left
-    if(databuffer.size()) {
-        emit bytesReceived(this, databuffer);
+    if (bufferCount) {
+        _emitBytesReceived(buffer, bufferCount);
+    }
+    if (totalBytes) {
+        _logInputDataRate(totalBytes, QDateTime::currentMSecsSinceEpoch());
+    }
+}
+
+/// Adds the sender to the session targets if it is not yet known. This runs for every datagram so
+/// the lookups are hashed, and senders which were already processed skip the local address check.
+/// The sender cache is only a shortcut, so it is simply dropped once it reaches _maxKnownSenders to
+/// keep a port scan or spoofed source addresses from growing it without bound.
+void UDPLink::_addSessionTarget(const QHostAddress& sender, quint16 senderPort)
+{
+    UDPClientKey senderKey(sender, senderPort);
+    if (_knownSenders.contains(senderKey)) {
+        return;
+    }
+    if (_knownSenders.count() >= _maxKnownSenders) {
+        qCDebug(UDPLinkLog) << "Known sender cache full, clearing" << _knownSenders.count();
+        _knownSenders.clear();
+    }
+    _knownSenders.insert(senderKey);
+    // TODO: This doesn't validade the sender. Anything sending UDP packets to this port gets
+    // added to the list and will start receiving datagrams from here. Even a port scanner
+    // would trigger this.
+    // Add host to broadcast list if not yet present, or update its port
+    QHostAddress asender = sender;
+    if(_isIpLocal(sender)) {
+        asender = QHostAddress(QString("127.0.0.1"));
+    }
+    UDPClientKey targetKey(asender, senderPort);
+    if(!_sessionTargetKeys.contains(targetKey)) {
+        qCDebug(UDPLinkLog) << "Adding target" << asender << senderPort;
+        UDPCLient* target = new UDPCLient(asender, senderPort);
+        _sessionTargets.append(target);
+        _sessionTargetKeys.insert(targetKey);
     }
 }
 
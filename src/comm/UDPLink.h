@@ -26,6 +26,9 @@
 #include <QMutexLocker>
 #include <QQueue>
 #include <QByteArray>
+#include <QSet>
+#include <QPair>
+#include <QLoggingCategory>
 
 #if defined(QGC_ZEROCONF_ENABLED)
 #include <dns_sd.h>
@@ -34,6 +37,8 @@
 #include "QGCConfig.h"
 #include "LinkManager.h"
 
+Q_DECLARE_LOGGING_CATEGORY(UDPLinkLog)
+
 class UDPCLient {
 public:
     UDPCLient(const QHostAddress& address_, quint16 port_)
@@ -48,6 +53,9 @@ public:
     quint16         port;
 };
 
+/// Address/port pair used for hashed sender lookups
+typedef QPair<QHostAddress, quint16> UDPClientKey;
+
 class UDPConfiguration : public LinkConfiguration
 {
     Q_OBJECT
@@ -190,6 +198,7 @@ private:
     void    _registerZeroconf       (uint16_t port, const std::string& regType);
     void    _deregisterZeroconf     ();
     void    _writeDataGram          (const QByteArray data, const UDPCLient* target);
+    void    _addSessionTarget       (const QHostAddress& sender, quint16 senderPort);
 
 #if defined(QGC_ZEROCONF_ENABLED)
     DNSServiceRef  _dnssServiceRef;
@@ -200,8 +209,18 @@ private:
     UDPConfiguration*       _udpConfig;
     bool                    _connectState;
     QList<UDPCLient*>       _sessionTargets;
+    QSet<UDPClientKey>      _sessionTargetKeys;     ///< Hashed copy of _sessionTargets for fast lookups
+    QSet<UDPClientKey>      _knownSenders;          ///< Raw sender addresses which have already been processed, capped at _maxKnownSenders
     QList<QHostAddress>     _localAddress;
 
+    /// Preallocated buffer which incoming datagrams are read into back to back. The whole batch is
+    /// handed to the parser in one go without copying.
+    QByteArray              _receiveBuffer;
+
+    static const int        _receiveBufferSize  = 256 * 1024;
+    static const int        _maxDatagramSize    = 64 * 1024;
+    static const int        _maxKnownSenders    = 1024;
+
 };
 
 #endif // UDPLINK_H
@@ -175,18 +175,20 @@ int main(int argc, char *argv[])
     // which need to be handled before a QApplication object is started.
 
     bool stressUnitTests = false;       // Stress test unit tests
+    bool benchmarkUnitTests = false;    // Run unit tests including benchmarks
     bool quietWindowsAsserts = false;   // Don't let asserts pop dialog boxes
 
     QString unitTestOptions;
     CmdLineOpt_t rgCmdLineOptions[] = {
         { "--unittest",             &runUnitTests,          &unitTestOptions },
         { "--unittest-stress",      &stressUnitTests,       &unitTestOptions },
+        { "--unittest-benchmark",   &benchmarkUnitTests,    &unitTestOptions },
         { "--no-windows-assert-ui", &quietWindowsAsserts,   NULL },
         // Add additional command line option flags here
     };
 
     ParseCmdLineOptions(argc, argv, rgCmdLineOptions, sizeof(rgCmdLineOptions)/sizeof(rgCmdLineOptions[0]), false);
-    if (stressUnitTests) {
+    if (stressUnitTests || benchmarkUnitTests) {
         runUnitTests = true;
     }
 
@@ -228,6 +230,7 @@ int main(int argc, char *argv[])
 
 #ifdef UNITTEST_BUILD
     if (runUnitTests) {
+        UnitTest::setBenchmarksEnabled(benchmarkUnitTests);
         for (int i=0; i < (stressUnitTests ? 20 : 1); i++) {
             if (!app->_initForUnitTests()) {
                 return -1;
@@ -41,6 +41,7 @@ void FileManagerTest::init(void)
     
     // Reset any internal state back to normal
     _fileServer->setErrorMode(MockLinkFileServer::errModeNone);
+    _fileServer->setDataLossPercent(0);
     _fileListReceived.clear();
 
     connect(_fileManager, &FileManager::listEntry, this, &FileManagerTest::listEntry);
@@ -199,6 +200,62 @@ void FileManagerTest::_listTest(void)
     _fileServer->enableRandromDrops(false);
 }
 
+/// Burst downloads a file which needs many bursts, with the given percentage of data packets dropped by the server
+void FileManagerTest::_burstDownload(int lossPercent)
+{
+    Q_ASSERT(_fileManager);
+    Q_ASSERT(_multiSpy);
+    Q_ASSERT(_multiSpy->checkNoSignals() == true);
+
+    const MockLinkFileServer::FileTestCase* testCase = &MockLinkFileServer::rgFileTestCases[MockLinkFileServer::cFileTestCases - 1];
+    QString filePath = QDir::temp().absoluteFilePath(testCase->filename);
+    QFile::remove(filePath);
+
+    _fileServer->setDataLossPercent(lossPercent);
+    _fileManager->streamPath(testCase->filename, QDir::temp());
+    QVERIFY(_multiSpy->waitForSignalByIndex(commandCompleteSignalIndex, 10000));
+    QCOMPARE(_multiSpy->checkNoSignalByMask(commandErrorSignalMask), true);
+    _multiSpy->clearAllSignals();
+    _fileServer->setDataLossPercent(0);
+
+    _validateFileContents(filePath, testCase->length);
+    qCDebug(FileManagerLog) << "Burst download loss:" << lossPercent << "bytes/sec:" << _fileManager->downloadBytesPerSecond() << "repairs:" << _fileManager->downloadRepairCount();
+    QFile::remove(filePath);
+}
+
+void FileManagerTest::_burstDownloadTest(void)
+{
+    _burstDownload(0);
+    QCOMPARE(_fileManager->downloadRepairCount(), 0);
+}
+
+void FileManagerTest::_burstDownloadLossTest(void)
+{
+    _burstDownload(20);
+
+    // Dropped burst packets must have been filled in with Read requests
+    QVERIFY(_fileManager->downloadRepairCount() > 0);
+}
+
+void FileManagerTest::_validateFileContents(const QString& filePath, uint32_t length)
+{
+	QFile file(filePath);
+	
+	// Make sure file size is correct
+	QCOMPARE(file.size(), (qint64)length);
+	
+	// Read data
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QByteArray bytes = file.readAll();
+	file.close();
+	
+	// Validate file contents:
+	//      Repeating 0x00, 0x01 .. 0xFF until file is full
+	for (int i=0; i<bytes.length(); i++) {
+		QCOMPARE((uint8_t)bytes[i], (uint8_t)(i & 0xFF));
+	}
+}
+
 #if 0
 // Trying to write test code for read and burst mode download as well as implement support in MockLineFileServer reached a point
 // of diminishing returns where the test code and mock server were generating more bugs in themselves than finding problems.
@@ -374,22 +431,4 @@ void FileManagerTest::_streamDownloadTest(void)
     }
 }
 
-void FileManagerTest::_validateFileContents(const QString& filePath, uint8_t length)
-{
-	QFile file(filePath);
-	
-	// Make sure file size is correct
-	QCOMPARE(file.size(), (qint64)length);
-	
-	// Read data
-	QVERIFY(file.open(QIODevice::ReadOnly));
-	QByteArray bytes = file.readAll();
-	file.close();
-	
-	// Validate file contents:
-	//      Repeating 0x00, 0x01 .. 0xFF until file is full
-	for (uint8_t i=0; i<bytes.length(); i++) {
-		QCOMPARE((uint8_t)bytes[i], (uint8_t)(i & 0xFF));
-	}
-}
 #endif
@@ -0,0 +1,303 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "LinkSendQueueTest.h"
+#include "LinkSendQueue.h"
+
+#include <QtConcurrent>
+#include <QElapsedTimer>
+
+/// Parses the messages in a batch, checking the checksums along the way
+QList<mavlink_message_t> LinkSendQueueTest::_parseBatch(const QByteArray& batch)
+{
+    const uint8_t channel = MAVLINK_COMM_NUM_BUFFERS - 1;
+
+    QList<mavlink_message_t> messages;
+    mavlink_message_t   message;
+    mavlink_status_t    status;
+
+    mavlink_reset_channel_status(channel);
+    for (int i=0; i<batch.size(); i++) {
+        if (mavlink_parse_char(channel, static_cast<uint8_t>(batch[i]), &message, &status)) {
+            messages.append(message);
+        }
+    }
+    return messages;
+}
+
+void LinkSendQueueTest::_testPriorityOrder(void)
+{
+    LinkSendQueue queue;
+
+    QVERIFY(queue.isEmpty());
+
+    // Queued lowest priority first, must come out highest priority first, fifo within a class
+    QVERIFY(queue.enqueue(LinkSendQueue::PriorityBulk,     "b1", 2));
+    QVERIFY(queue.enqueue(LinkSendQueue::PriorityNormal,   "n1", 2));
+    QVERIFY(queue.enqueue(LinkSendQueue::PriorityBulk,     "b2", 2));
+    QVERIFY(queue.enqueue(LinkSendQueue::PriorityHigh,     "h1", 2));
+    QVERIFY(queue.enqueue(LinkSendQueue::PriorityNormal,   "n2", 2));
+    QVERIFY(queue.enqueue(LinkSendQueue::PriorityHigh,     "h2", 2));
+
+    QCOMPARE(queue.depth(LinkSendQueue::PriorityHigh), 2);
+    QCOMPARE(queue.depth(LinkSendQueue::PriorityNormal), 2);
+    QCOMPARE(queue.depth(LinkSendQueue::PriorityBulk), 2);
+
+    QByteArray batch;
+    QCOMPARE(queue.dequeue(batch, 1024), 6);
+    QCOMPARE(batch, QByteArray("h1h2n1n2b1b2"));
+    QVERIFY(queue.isEmpty());
+
+    LinkSendQueue::Stats_t stats = queue.stats(LinkSendQueue::PriorityHigh);
+    QCOMPARE(stats.enqueued, 2u);
+    QCOMPARE(stats.sent, 2u);
+    QCOMPARE(stats.dropped, 0u);
+    QCOMPARE(stats.depth, 0);
+    QCOMPARE(stats.maxDepth, 2);
+
+    batch.clear();
+    QCOMPARE(queue.dequeue(batch, 1024), 0);
+    QVERIFY(batch.isEmpty());
+}
+
+void LinkSendQueueTest::_testMessageSerialization(void)
+{
+    QCOMPARE(LinkSendQueue::priority(MAVLINK_MSG_ID_HEARTBEAT),             LinkSendQueue::PriorityHigh);
+    QCOMPARE(LinkSendQueue::priority(MAVLINK_MSG_ID_COMMAND_LONG),          LinkSendQueue::PriorityHigh);
+    QCOMPARE(LinkSendQueue::priority(MAVLINK_MSG_ID_MISSION_ITEM_INT),      LinkSendQueue::PriorityNormal);
+    QCOMPARE(LinkSendQueue::priority(MAVLINK_MSG_ID_GPS_RTCM_DATA),         LinkSendQueue::PriorityBulk);
+    QCOMPARE(LinkSendQueue::priority(MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL),LinkSendQueue::PriorityBulk);
+    QCOMPARE(LinkSendQueue::priority(MAVLINK_MSG_ID_PARAM_REQUEST_READ),    LinkSendQueue::PriorityBulk);
+
+    mavlink_message_t ftpMessage;
+    mavlink_message_t heartbeatMessage;
+    uint8_t payload[MAVLINK_MSG_FILE_TRANSFER_PROTOCOL_FIELD_PAYLOAD_LEN];
+    memset(payload, 0x55, sizeof(payload));
+    mavlink_msg_file_transfer_protocol_pack_chan(255, 190, 0, &ftpMessage, 0, 1, 1, payload);
+    mavlink_msg_heartbeat_pack_chan(255, 190, 0, &heartbeatMessage, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, MAV_MODE_MANUAL_ARMED, 0, MAV_STATE_ACTIVE);
+
+    LinkSendQueue queue;
+    QVERIFY(queue.enqueue(ftpMessage));
+    QVERIFY(queue.enqueue(heartbeatMessage));
+
+    QByteArray batch;
+    QCOMPARE(queue.dequeue(batch, 1024), 2);
+
+    QList<mavlink_message_t> messages = _parseBatch(batch);
+    QCOMPARE(messages.count(), 2);
+    QCOMPARE(static_cast<uint32_t>(messages[0].msgid), static_cast<uint32_t>(MAVLINK_MSG_ID_HEARTBEAT));
+    QCOMPARE(static_cast<uint32_t>(messages[1].msgid), static_cast<uint32_t>(MAVLINK_MSG_ID_FILE_TRANSFER_PROTOCOL));
+    QCOMPARE(mavlink_msg_heartbeat_get_type(&messages[0]), static_cast<uint8_t>(MAV_TYPE_GCS));
+
+    uint8_t payloadOut[MAVLINK_MSG_FILE_TRANSFER_PROTOCOL_FIELD_PAYLOAD_LEN];
+    mavlink_msg_file_transfer_protocol_get_payload(&messages[1], payloadOut);
+    QCOMPARE(memcmp(payload, payloadOut, sizeof(payload)), 0);
+}
+
+void LinkSendQueueTest::_testSequenceStamping(void)
+{
+    LinkSendQueue queue;
+    mavlink_message_t message;
+    char paramId[MAVLINK_MSG_PARAM_REQUEST_READ_FIELD_PARAM_ID_LEN] = { };
+
+    // Packed in this order, so the sequence numbers from packing run opposite to the send order
+    for (int i=0; i<4; i++) {
+        mavlink_msg_param_request_read_pack_chan(255, 190, 0, &message, 1, 1, paramId, i);
+        QVERIFY(queue.enqueue(message));
+    }
+    for (int i=0; i<2; i++) {
+        mavlink_msg_heartbeat_pack_chan(255, 190, 0, &message, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, MAV_MODE_MANUAL_ARMED, 0, MAV_STATE_ACTIVE);
+        QVERIFY(queue.enqueue(message));
+    }
+
+    // The link sees consecutive sequence numbers in send order, with valid checksums
+    QByteArray batch;
+    QCOMPARE(queue.dequeue(batch, 1024), 6);
+    QList<mavlink_message_t> messages = _parseBatch(batch);
+    QCOMPARE(messages.count(), 6);
+    for (int i=0; i<messages.count(); i++) {
+        QCOMPARE(static_cast<uint32_t>(messages[i].msgid), static_cast<uint32_t>(i < 2 ? MAVLINK_MSG_ID_HEARTBEAT : MAVLINK_MSG_ID_PARAM_REQUEST_READ));
+        QCOMPARE(messages[i].seq, static_cast<uint8_t>(messages[0].seq + i));
+    }
+    QCOMPARE(mavlink_msg_param_request_read_get_param_index(&messages[5]), static_cast<int16_t>(3));
+
+    // Numbering carries on across batches and wraps
+    for (int i=0; i<300; i++) {
+        QVERIFY(queue.enqueue(message));
+        batch.clear();
+        QCOMPARE(queue.dequeue(batch, 1024), 1);
+        messages = _parseBatch(batch);
+        QCOMPARE(messages.count(), 1);
+        QCOMPARE(messages[0].seq, static_cast<uint8_t>(6 + i));
+    }
+}
+
+void LinkSendQueueTest::_testBatchLimit(void)
+{
+    LinkSendQueue queue;
+    QByteArray packet(100, 'x');
+
+    for (int i=0; i<10; i++) {
+        QVERIFY(queue.enqueue(LinkSendQueue::PriorityNormal, packet.constData(), packet.size()));
+    }
+
+    // Only whole packets go into a batch
+    QByteArray batch;
+    QCOMPARE(queue.dequeue(batch, 250), 2);
+    QCOMPARE(batch.size(), 200);
+
+    // A high priority packet queued while a backlog is waiting goes out in the next batch
+    QVERIFY(queue.enqueue(LinkSendQueue::PriorityHigh, "hh", 2));
+    batch.clear();
+    QCOMPARE(queue.dequeue(batch, 250), 3);
+    QVERIFY(batch.startsWith("hh"));
+    QCOMPARE(batch.size(), 202);
+
+    // Oversized raw writes are refused
+    QByteArray oversized(LinkSendQueue::slotBytes + 1, 'x');
+    QCOMPARE(queue.enqueue(LinkSendQueue::PriorityNormal, oversized.constData(), oversized.size()), false);
+}
+
+void LinkSendQueueTest::_testQueueFull(void)
+{
+    LinkSendQueue queue;
+    int capacity = LinkSendQueue::capacity(LinkSendQueue::PriorityNormal);
+
+    for (int i=0; i<capacity; i++) {
+        QVERIFY(queue.enqueue(LinkSendQueue::PriorityNormal, "n", 1));
+    }
+    QCOMPARE(queue.enqueue(LinkSendQueue::PriorityNormal, "n", 1), false);
+
+    // Other classes are not affected by a full ring
+    QVERIFY(queue.enqueue(LinkSendQueue::PriorityHigh, "h", 1));
+
+    LinkSendQueue::Stats_t stats = queue.stats(LinkSendQueue::PriorityNormal);
+    QCOMPARE(stats.enqueued, static_cast<quint32>(capacity));
+    QCOMPARE(stats.dropped, 1u);
+    QCOMPARE(stats.depth, capacity);
+
+    // Space frees up again after draining, slots are reused on the next lap
+    QByteArray batch;
+    QCOMPARE(queue.dequeue(batch, capacity * 2), capacity + 1);
+    for (int lap=0; lap<3; lap++) {
+        for (int i=0; i<capacity; i++) {
+            QVERIFY(queue.enqueue(LinkSendQueue::PriorityNormal, "n", 1));
+        }
+        batch.clear();
+        QCOMPARE(queue.dequeue(batch, capacity), capacity);
+    }
+
+    QVERIFY(queue.enqueue(LinkSendQueue::PriorityBulk, "b", 1));
+    queue.clear();
+    QVERIFY(queue.isEmpty());
+}
+
+void LinkSendQueueTest::_testMultipleProducers(void)
+{
+    const int   producerCount =     4;
+    const int   packetsPerProducer = 20000;
+
+    LinkSendQueue queue;
+    QAtomicInt cancel(0);
+
+    // Each packet carries the producer id and a per producer sequence number
+    QList<QFuture<void>> producers;
+    for (int producer=0; producer<producerCount; producer++) {
+        producers.append(QtConcurrent::run([&queue, &cancel, producer, packetsPerProducer]() {
+            for (qint32 sequence=0; sequence<packetsPerProducer; sequence++) {
+                qint32 packet[2] = { producer, sequence };
+                while (!queue.enqueue(LinkSendQueue::PriorityNormal, reinterpret_cast<const char*>(packet), sizeof(packet))) {
+                    if (cancel.load()) {
+                        return;
+                    }
+                    QThread::yieldCurrentThread();
+                }
+            }
+        }));
+    }
+
+    // Verification happens after the producers are finished, they must not outlive the queue
+    QVector<qint32> nextSequence(producerCount, 0);
+    int received = 0;
+    int outOfOrder = 0;
+    QElapsedTimer timeout;
+    timeout.start();
+    while (received < producerCount * packetsPerProducer && timeout.elapsed() < 30000) {
+        QByteArray batch;
+        if (queue.dequeue(batch, 1024) == 0) {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        const qint32* packets = reinterpret_cast<const qint32*>(batch.constData());
+        int packetCount = batch.size() / static_cast<int>(2 * sizeof(qint32));
+        for (int i=0; i<packetCount; i++) {
+            int producer = packets[i * 2];
+            if (producer < 0 || producer >= producerCount || packets[(i * 2) + 1] != nextSequence[producer]) {
+                outOfOrder++;
+            } else {
+                nextSequence[producer]++;
+            }
+        }
+        received += packetCount;
+    }
+
+    cancel.store(1);
+    for (int i=0; i<producers.count(); i++) {
+        producers[i].waitForFinished();
+    }
+
+    QCOMPARE(outOfOrder, 0);
+    QCOMPARE(received, producerCount * packetsPerProducer);
+    QVERIFY(queue.isEmpty());
+    QCOMPARE(queue.stats(LinkSendQueue::PriorityNormal).sent, static_cast<quint32>(producerCount * packetsPerProducer));
+}
+
+void LinkSendQueueTest::_benchmarkQueue(void)
+{
+    UT_BENCHMARK();
+
+    const int messageCount = 200000;
+
+    mavlink_message_t message;
+    mavlink_msg_heartbeat_pack_chan(255, 190, 0, &message, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, MAV_MODE_MANUAL_ARMED, 0, MAV_STATE_ACTIVE);
+
+    LinkSendQueue queue;
+    QByteArray batch;
+    int sent = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i=0; i<messageCount; i++) {
+        queue.enqueue(message);
+        if (queue.depth(LinkSendQueue::PriorityHigh) == LinkSendQueue::capacity(LinkSendQueue::PriorityHigh)) {
+            while (true) {
+                batch.clear();
+                int count = queue.dequeue(batch, 1024);
+                if (count == 0) {
+                    break;
+                }
+                sent += count;
+            }
+        }
+    }
+    while (true) {
+        batch.clear();
+        int count = queue.dequeue(batch, 1024);
+        if (count == 0) {
+            break;
+        }
+        sent += count;
+    }
+    qint64 elapsed = timer.elapsed();
+
+    QCOMPARE(sent, messageCount);
+    qCDebug(LinkSendQueueLog) << "LinkSendQueue:" << messageCount << "messages in" << elapsed << "msecs"
+             << "avg latency(usecs)" << queue.stats(LinkSendQueue::PriorityHigh).avgLatencyUSecs;
+}
@@ -0,0 +1,31 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#pragma once
+
+#include "UnitTest.h"
+#include "QGCMAVLink.h"
+
+/// Unit test for the per-link outbound priority queue
+class LinkSendQueueTest : public UnitTest
+{
+    Q_OBJECT
+
+private slots:
+    void _testPriorityOrder(void);
+    void _testMessageSerialization(void);
+    void _testSequenceStamping(void);
+    void _testBatchLimit(void);
+    void _testQueueFull(void);
+    void _testMultipleProducers(void);
+    void _benchmarkQueue(void);
+
+private:
+    QList<mavlink_message_t> _parseBatch(const QByteArray& batch);
+};
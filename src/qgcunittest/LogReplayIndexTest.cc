@@ -0,0 +1,97 @@
+/****************************************************************************
+ *
+ *   (c) 2009-2016 QGROUNDCONTROL PROJECT <http://www.qgroundcontrol.org>
+ *
+ * QGroundControl is licensed according to the terms in the file
+ * COPYING.md in the root of the source code directory.
+ *
+ ****************************************************************************/
+
+#include "LogReplayIndexTest.h"
+#include "LogReplayIndex.h"
+#include "TelemetryLogWriter.h"
+
+#include <QTemporaryDir>
+
+static const quint64 _baseTimeUSecs = 1500000000000000ull;
+
+void LogReplayIndexTest::_testEntryForTime(void)
+{
+    LogReplayIndex index;
+
+    // One message every 50 msecs, only every other one makes it into the index
+    for (int i=0; i<10; i++) {
+        index.addMessage(_baseTimeUSecs + (i * 50000), i * 100);
+    }
+    index.finish(1000);
+
+    QCOMPARE(index.count(), 6);
+    QCOMPARE(index.startTimeUSecs(), _baseTimeUSecs);
+    QCOMPARE(index.endTimeUSecs(), _baseTimeUSecs + 450000);
+
+    QCOMPARE(index.entryForTime(0).offset, 0LL);
+    QCOMPARE(index.entryForTime(_baseTimeUSecs + 150000).offset, 200LL);
+    QCOMPARE(index.entryForTime(_baseTimeUSecs + 200000).offset, 400LL);
+    QCOMPARE(index.entryForTime(_baseTimeUSecs + 1000000).offset, 900LL);
+}
+
+void LogReplayIndexTest::_testBackwardsTimestamp(void)
+{
+    LogReplayIndex index;
+
+    index.addMessage(_baseTimeUSecs,            0);
+    index.addMessage(_baseTimeUSecs + 200000,   100);
+    // Going back in time must not wrap around into a huge interval and add an out of order entry
+    index.addMessage(_baseTimeUSecs + 50000,    200);
+    index.addMessage(_baseTimeUSecs + 400000,   300);
+    index.finish(400);
+
+    QCOMPARE(index.count(), 3);
+    QCOMPARE(index.endTimeUSecs(), _baseTimeUSecs + 400000);
+    QCOMPARE(index.entryForTime(_baseTimeUSecs + 100000).offset, 0LL);
+    QCOMPARE(index.entryForTime(_baseTimeUSecs + 250000).offset, 100LL);
+    QCOMPARE(index.entryForTime(_baseTimeUSecs + 400000).offset, 300LL);
+
+    // A backwards timestamp as the last message must not become the final entry either
+    index.clear();
+    index.addMessage(_baseTimeUSecs,            0);
+    index.addMessage(_baseTimeUSecs + 50000,    100);
+    index.addMessage(_baseTimeUSecs + 10000,    200);
+    index.finish(300);
+
+    QCOMPARE(index.count(), 2);
+    QCOMPARE(index.endTimeUSecs(), _baseTimeUSecs + 50000);
+}
+
+void LogReplayIndexTest::_testStreamedIndex(void)
+{
+    QTemporaryDir       tempDir;
+    QString             logFilename = tempDir.path() + "/streamed.tlog";
+    TelemetryLogWriter  writer;
+    LogReplayIndex      index;
+
+    QVERIFY(tempDir.isValid());
+    QVERIFY(writer.openLog(logFilename));
+    for (int i=0; i<1000; i++) {
+        mavlink_message_t message;
+        mavlink_msg_heartbeat_pack_chan(1, 1, 0, &message, MAV_TYPE_QUADROTOR, MAV_AUTOPILOT_PX4, 0, 0, MAV_STATE_ACTIVE);
+        QVERIFY(writer.writeMessage(_baseTimeUSecs + (i * 10000), message));
+    }
+
+    // The sidecar doesn't match the log until the log is closed
+    QVERIFY(!index.load(logFilename));
+    writer.closeLog();
+    QVERIFY(index.load(logFilename));
+
+    // Streamed index must be the same as one built from the log
+    QFile           logFile(logFilename);
+    LogReplayIndex  builtIndex;
+    QVERIFY(logFile.open(QFile::ReadOnly));
+    QVERIFY(builtIndex.build(logFile));
+    QCOMPARE(index.count(), builtIndex.count());
+    for (int i=0; i<index.count(); i++) {
+        QCOMPARE(index.entry(i).timeUSecs, builtIndex.entry(i).timeUSecs);
+        QCOMPARE(index.entry(i).offset, builtIndex.entry(i).offset);
+    }
+    QCOMPARE(index.endTimeUSecs(), _baseTimeUSecs + (999 * 10000));
+}
@@ -33,6 +33,8 @@ QStringList UnitTest::_fileDialogResponse;
 enum UnitTest::FileDialogType UnitTest::_fileDialogExpectedType = getOpenFileName;
 int UnitTest::_missedFileDialogCount = 0;
 
+bool UnitTest::_benchmarksEnabled = false;
+
 UnitTest::UnitTest(void)
     : _linkManager(NULL)
     , _mockLink(NULL)
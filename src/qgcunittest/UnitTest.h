@@ -28,6 +28,9 @@
 
 #define UT_REGISTER_TEST(className) static UnitTestWrapper<className> className(#className);
 
+/// Skips the calling test unless benchmarks were requested with --unittest-benchmark
+#define UT_BENCHMARK() if (!UnitTest::benchmarksEnabled()) { QSKIP("Benchmark, run with --unittest-benchmark"); }
+
 class QGCMessageBox;
 class QGCQFileDialog;
 class LinkManager;
@@ -46,6 +49,10 @@ public:
     /// @brief Called to run all the registered unit tests
     ///     @param singleTest Name of test to just run a single test
     static int run(QString& singleTest);
+
+    /// @brief Benchmark tests are skipped unless enabled (--unittest-benchmark)
+    static bool benchmarksEnabled(void) { return _benchmarksEnabled; }
+    static void setBenchmarksEnabled(bool enabled) { _benchmarksEnabled = enabled; }
     
     /// @brief Sets up for an expected QGCMessageBox
     ///     @param response Response to take on message box
@@ -193,6 +200,8 @@ private:
     static QStringList  _fileDialogResponse;            ///< Response to next file dialog
     static enum FileDialogType _fileDialogExpectedType; ///< type of file dialog expected to show
     static int          _missedFileDialogCount;         ///< Count of file dialogs not checked with call to UnitTest::fileDialogWasDisplayed
+
+    static bool _benchmarksEnabled;     ///< true: run tests marked with UT_BENCHMARK
     
     bool _unitTestRun;              ///< true: Unit Test was run
     bool _initCalled;               ///< true: UnitTest::_init was called
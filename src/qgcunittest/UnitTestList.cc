@@ -13,10 +13,13 @@
 
 #include "FactSystemTestGeneric.h"
 #include "FactSystemTestPX4.h"
+#include "FactUpdateSchedulerTest.h"
 #include "FileDialogTest.h"
 #include "FlightGearTest.h"
 #include "GeoTest.h"
 #include "LinkManagerTest.h"
+#include "LinkSendQueueTest.h"
+#include "LogReplayIndexTest.h"
 #include "MessageBoxTest.h"
 #include "MissionItemTest.h"
 #include "SimpleMissionItemTest.h"
@@ -29,8 +32,11 @@
 #include "FileManagerTest.h"
 #include "TCPLinkTest.h"
 #include "ParameterManagerTest.h"
+#include "ParameterCacheTest.h"
+#include "ParameterRequestSchedulerTest.h"
 #include "MissionCommandTreeTest.h"
 #include "LogDownloadTest.h"
+#include "GeoTagParserTest.h"
 #include "SendMavCommandTest.h"
 #include "VisualMissionItemTest.h"
 #include "CameraSectionTest.h"
@@ -44,13 +50,25 @@
 #include "CorridorScanComplexItemTest.h"
 #include "TransectStyleComplexItemTest.h"
 #include "CameraCalcTest.h"
+#include "QGCTileDownloadSchedulerTest.h"
+#include "TerrainQueryTest.h"
+#include "TerrainTileStoreTest.h"
+#include "PolygonScanlineClipperTest.h"
+#include "TransectRouteOptimizerTest.h"
+#include "ADSBTrafficStoreTest.h"
+#include "RTCM/RTCMMavlinkTest.h"
+#include "TrajectoryHistoryTest.h"
+#include "VideoReceiverTest.h"
 
 UT_REGISTER_TEST(FactSystemTestGeneric)
 UT_REGISTER_TEST(FactSystemTestPX4)
+UT_REGISTER_TEST(FactUpdateSchedulerTest)
 UT_REGISTER_TEST(FileDialogTest)
 UT_REGISTER_TEST(FlightGearUnitTest)
 UT_REGISTER_TEST(GeoTest)
 UT_REGISTER_TEST(LinkManagerTest)
+UT_REGISTER_TEST(LinkSendQueueTest)
+UT_REGISTER_TEST(LogReplayIndexTest)
 UT_REGISTER_TEST(MessageBoxTest)
 UT_REGISTER_TEST(MissionItemTest)
 UT_REGISTER_TEST(SimpleMissionItemTest)
@@ -60,8 +78,11 @@ UT_REGISTER_TEST(RadioConfigTest)
 UT_REGISTER_TEST(TCPLinkTest)
 UT_REGISTER_TEST(FileManagerTest)
 UT_REGISTER_TEST(ParameterManagerTest)
+UT_REGISTER_TEST(ParameterCacheTest)
+UT_REGISTER_TEST(ParameterRequestSchedulerTest)
 UT_REGISTER_TEST(MissionCommandTreeTest)
 UT_REGISTER_TEST(LogDownloadTest)
+UT_REGISTER_TEST(GeoTagParserTest)
 UT_REGISTER_TEST(SendMavCommandTest)
 UT_REGISTER_TEST(SurveyComplexItemTest)
 UT_REGISTER_TEST(CameraSectionTest)
@@ -75,6 +96,15 @@ UT_REGISTER_TEST(CorridorScanComplexItemTest)
 UT_REGISTER_TEST(TransectStyleComplexItemTest)
 UT_REGISTER_TEST(QGCMapPolylineTest)
 UT_REGISTER_TEST(CameraCalcTest)
+UT_REGISTER_TEST(QGCTileDownloadSchedulerTest)
+UT_REGISTER_TEST(TerrainQueryTest)
+UT_REGISTER_TEST(TerrainTileStoreTest)
+UT_REGISTER_TEST(PolygonScanlineClipperTest)
+UT_REGISTER_TEST(TransectRouteOptimizerTest)
+UT_REGISTER_TEST(ADSBTrafficStoreTest)
+UT_REGISTER_TEST(RTCMMavlinkTest)
+UT_REGISTER_TEST(TrajectoryHistoryTest)
+UT_REGISTER_TEST(VideoReceiverTest)
 
 // List of unit test which are currently disabled.
 // If disabling a new test, include reason in comment.
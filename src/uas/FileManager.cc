@@ -27,8 +27,13 @@ FileManager::FileManager(QObject* parent, Vehicle* vehicle)
     , _vehicle(vehicle)
     , _dedicatedLink(NULL)
     , _activeSession(0)
-    , _missingDownloadedBytes(0)
-    , _downloadingMissingParts(false)
+    , _downloadFileSize(0)
+    , _downloadChunksReceived(0)
+    , _downloadBytesReceived(0)
+    , _downloadElapsedMSecs(0)
+    , _downloadRepairCount(0)
+    , _repairScanChunk(0)
+    , _repairProgress(false)
     , _systemIdQGC(0)
 {
     connect(&_ackTimer, &QTimer::timeout, this, &FileManager::_ackTimeout);
@@ -53,14 +58,16 @@ void FileManager::_openAckResponse(Request* openAck)
     // File length comes back in data
     Q_ASSERT(openAck->hdr.size == sizeof(uint32_t));
     _downloadFileSize = openAck->openFileLength;
+
+    if (!_openDownloadFile()) {
+        _closeDownloadSession(false /* failure */);
+        _emitErrorMessage(tr("Unable to open local file for writing (%1)").arg(_downloadFile.fileName()));
+        return;
+    }
     
     // Start the sequence of read commands
 
     _downloadOffset = 0;            // Start reading at beginning of file
-    _readFileAccumulator.clear();   // Start with an empty file
-    _missingDownloadedBytes = 0;
-    _downloadingMissingParts = false;
-    _missingData.clear();
 
     Request request;
     request.hdr.session = _activeSession;
@@ -72,75 +79,226 @@ void FileManager::_openAckResponse(Request* openAck)
     _sendRequest(&request);
 }
 
-/// request the next missing part of a (partially) downloaded file
-void FileManager::_requestMissingData()
+/// Opens the local file for the download and sets up the chunk bitmap. Data is written to the file as it arrives so
+/// memory use doesn't grow with the file size.
+bool FileManager::_openDownloadFile(void)
 {
-    if (_missingData.empty()) {
-        _downloadingMissingParts = false;
-        _missingDownloadedBytes = 0;
-        // there might be more data missing at the end
-        if ((uint32_t)_readFileAccumulator.length() != _downloadFileSize) {
-            _downloadOffset = _readFileAccumulator.length();
-            qCDebug(FileManagerLog) << QString("_requestMissingData: missing parts done, downloadOffset(%1) downloadFileSize(%2)")
-                    .arg(_downloadOffset).arg(_downloadFileSize);
-        } else {
-            _closeDownloadSession(true);
+    int chunkCount = static_cast<int>((_downloadFileSize + _downloadChunkSize - 1) / _downloadChunkSize);
+
+    _downloadChunks.fill(false, chunkCount);
+    _downloadChunksReceived = 0;
+    _downloadBytesReceived = 0;
+    _downloadElapsedMSecs = 0;
+    _downloadRepairCount = 0;
+    _downloadTimer.start();
+
+    _downloadFile.setFileName(_readFileDownloadDir.absoluteFilePath(_readFileDownloadFilename));
+    if (!_downloadFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    // Allocate the whole file up front, burst data and gap repairs are written in place
+    return _downloadFile.resize(_downloadFileSize);
+}
+
+/// Writes downloaded data to the local file and marks the chunks it completes as received.
+///     @return false: write failed or data is outside of the file
+bool FileManager::_writeDownloadData(uint32_t offset, const uint8_t* data, uint32_t size)
+{
+    if (offset + size > _downloadFileSize) {
+        return false;
+    }
+
+    if (!_downloadFile.seek(offset) || _downloadFile.write((const char*)data, size) != static_cast<qint64>(size)) {
+        return false;
+    }
+
+    // Data normally lines up with chunks. If it doesn't, only chunks which are fully covered count as received and
+    // the rest are picked up by gap repair.
+    uint32_t dataEnd = offset + size;
+    for (int chunk = static_cast<int>((offset + _downloadChunkSize - 1) / _downloadChunkSize); chunk < _downloadChunks.count(); chunk++) {
+        uint32_t chunkStart = chunk * _downloadChunkSize;
+        uint32_t chunkEnd = qMin(chunkStart + _downloadChunkSize, _downloadFileSize);
+        if (chunkEnd > dataEnd) {
+            break;
+        }
+        if (!_downloadChunks.testBit(chunk)) {
+            _downloadChunks.setBit(chunk);
+            _downloadChunksReceived++;
+            _downloadBytesReceived += chunkEnd - chunkStart;
+        }
+    }
+    _downloadElapsedMSecs = _downloadTimer.elapsed();
+
+    return true;
+}
+
+void FileManager::_emitDownloadProgress(void)
+{
+    if (_downloadFileSize != 0) {
+        emit commandProgress(100 * ((float)_downloadBytesReceived / (float)_downloadFileSize));
+    }
+}
+
+double FileManager::downloadBytesPerSecond(void) const
+{
+    if (_downloadElapsedMSecs <= 0) {
+        return 0;
+    }
+    return (_downloadBytesReceived * 1000.0) / _downloadElapsedMSecs;
+}
+
+/// Starts filling the gaps left by a download. Read requests for missing chunks are pipelined, up to repairWindow of
+/// them are outstanding at once. Each is sent with its own sequence number and matched up by the response sequence number.
+void FileManager::_startRepair(void)
+{
+    qCDebug(FileManagerLog) << QString("_startRepair: missingChunks(%1)").arg(_downloadChunks.count() - _downloadChunksReceived);
+
+    _currentOperation = kCORepair;
+    _repairRequests.clear();
+    _repairScanChunk = 0;
+    _repairProgress = false;
+
+    _ackNumTries = 0;
+    _ackTimer.setSingleShot(false);
+    _ackTimer.start(ackTimerTimeoutMsecs);
+
+    _fillRepairWindow();
+}
+
+/// Sends Read requests for missing chunks which are not already requested until the window is full
+void FileManager::_fillRepairWindow(void)
+{
+    QList<int> outstandingChunks;
+    foreach (const RepairRequest_t& repairRequest, _repairRequests) {
+        outstandingChunks.append(repairRequest.chunk);
+    }
+
+    int chunkCount = _downloadChunks.count();
+    for (int checked = 0; checked < chunkCount && _repairRequests.count() < repairWindow; checked++) {
+        if (_repairScanChunk >= chunkCount) {
+            _repairScanChunk = 0;
+        }
+        int chunk = _repairScanChunk++;
+        if (_downloadChunks.testBit(chunk) || outstandingChunks.contains(chunk)) {
+            continue;
+        }
+
+        Request request;
+        request.hdr.session = _activeSession;
+        request.hdr.opcode = kCmdReadFile;
+        request.hdr.offset = chunk * _downloadChunkSize;
+        request.hdr.size = sizeof(request.data);
+        request.hdr.seqNumber = ++_lastOutgoingRequest.hdr.seqNumber;
+
+        RepairRequest_t repairRequest;
+        repairRequest.chunk = chunk;
+        repairRequest.sentMSecs = _downloadTimer.elapsed();
+        _repairRequests[request.hdr.seqNumber + 1] = repairRequest;
+        outstandingChunks.append(chunk);
+        _downloadRepairCount++;
+
+        qCDebug(FileManagerLog) << QString("_fillRepairWindow: offset(%1) seqNumber(%2)").arg(request.hdr.offset).arg(request.hdr.seqNumber);
+        _sendRequestNoAck(&request);
+    }
+}
+
+/// Handles all responses while repairing. Responses can come back in any order, so the usual sequence number check
+/// does not apply.
+void FileManager::_repairResponse(Request* response)
+{
+    bool requested = _repairRequests.remove(response->hdr.seqNumber) != 0;
+
+    if (response->hdr.opcode == kRspAck &&
+            (response->hdr.req_opcode == kCmdReadFile || response->hdr.req_opcode == kCmdBurstReadFile) &&
+            response->hdr.session == _activeSession) {
+        // Late data from a timed out request or from the burst is just as good, keep it
+        if (!_writeDownloadData(response->hdr.offset, response->data, response->hdr.size)) {
+            _clearAckTimeout();
+            _closeDownloadSession(false /* failure */);
+            _emitErrorMessage(tr("Unable to write data to local file (%1)").arg(_downloadFile.fileName()));
             return;
         }
+        _repairProgress = true;
+        _emitDownloadProgress();
+    } else if (requested) {
+        _clearAckTimeout();
+        _closeDownloadSession(false /* failure */);
+        if (response->hdr.opcode == kRspNak) {
+            _emitErrorMessage(tr("Nak received, error: %1").arg(errorString(response->data[0])));
+        } else {
+            _emitErrorMessage(tr("Download: Unexpected response while filling gaps"));
+        }
+        return;
     } else {
-        qCDebug(FileManagerLog) << QString("_requestMissingData: offset(%1) size(%2)").arg(_missingData.head().offset).arg(_missingData.head().size);
+        qCDebug(FileManagerLog) << "_repairResponse: ignoring unrequested response seqNumber:" << response->hdr.seqNumber;
+        return;
+    }
 
-        _downloadOffset = _missingData.head().offset;
+    if (_downloadChunksReceived == _downloadChunks.count()) {
+        _clearAckTimeout();
+        _closeDownloadSession(true /* success */);
+    } else {
+        _fillRepairWindow();
     }
+}
 
-    Request request;
-    _currentOperation = kCORead;
-    request.hdr.session = _activeSession;
-    request.hdr.opcode = kCmdReadFile;
-    request.hdr.offset = _downloadOffset;
-    request.hdr.size = sizeof(request.data);
+/// Requests which have been outstanding for a full timeout are taken as lost and requested again. The download fails
+/// only if nothing at all comes back for ackTimerMaxRetries timeouts in a row.
+void FileManager::_repairTimeout(void)
+{
+    if (_repairProgress) {
+        _repairProgress = false;
+        _ackNumTries = 0;
+    } else if (++_ackNumTries > ackTimerMaxRetries) {
+        _clearAckTimeout();
+        _closeDownloadSession(false /* failure */);
+        _emitErrorMessage(tr("Timeout waiting for ack: Download failed"));
+        return;
+    }
 
-    _sendRequest(&request);
+    qint64 nowMSecs = _downloadTimer.elapsed();
+    QMap<uint16_t, RepairRequest_t>::iterator iter = _repairRequests.begin();
+    while (iter != _repairRequests.end()) {
+        if (nowMSecs - iter.value().sentMSecs >= ackTimerTimeoutMsecs) {
+            iter = _repairRequests.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+
+    _fillRepairWindow();
 }
 
-/// Closes out a download session by writing the file and doing cleanup.
+/// Closes out a download session by closing the file and doing cleanup.
 ///     @param success true: successful download completion, false: error during download
 void FileManager::_closeDownloadSession(bool success)
 {
-    qCDebug(FileManagerLog) << QString("_closeDownloadSession: success(%1) missingBytes(%2)").arg(success).arg(_missingDownloadedBytes);
+    qCDebug(FileManagerLog) << QString("_closeDownloadSession: success(%1) missingChunks(%2)").arg(success).arg(_downloadChunks.count() - _downloadChunksReceived);
     
     _currentOperation = kCOIdle;
+    _repairRequests.clear();
     
     if (success) {
-        if (_missingDownloadedBytes > 0 || (uint32_t)_readFileAccumulator.length() < _downloadFileSize) {
-            // we're not done yet: request the missing parts individually (either we had missing parts or
-            // the last (few) packets right before the EOF got dropped)
-            _downloadingMissingParts = true;
-            _requestMissingData();
+        if (_downloadChunksReceived < _downloadChunks.count()) {
+            // we're not done yet: either we had gaps in a burst or the last (few) packets right before the EOF got dropped
+            _startRepair();
             return;
         }
 
-        QString downloadFilePath = _readFileDownloadDir.absoluteFilePath(_readFileDownloadFilename);
-
-        QFile file(downloadFilePath);
-        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-            _emitErrorMessage(tr("Unable to open local file for writing (%1)").arg(downloadFilePath));
-            return;
-        }
-
-        qint64 bytesWritten = file.write((const char *)_readFileAccumulator, _readFileAccumulator.length());
-        if (bytesWritten != _readFileAccumulator.length()) {
-            file.close();
-            _emitErrorMessage(tr("Unable to write data to local file (%1)").arg(downloadFilePath));
-            return;
+        _downloadFile.close();
+        if (_downloadFile.error() != QFile::NoError) {
+            _emitErrorMessage(tr("Unable to write data to local file (%1)").arg(_downloadFile.fileName()));
+        } else {
+            qCDebug(FileManagerLog) << QString("_closeDownloadSession: bytes(%1) msecs(%2) bytesPerSecond(%3) repairCount(%4)")
+                                       .arg(_downloadBytesReceived).arg(_downloadElapsedMSecs).arg(downloadBytesPerSecond()).arg(_downloadRepairCount);
+            emit commandComplete();
         }
-        file.close();
-
-        emit commandComplete();
+    } else if (_downloadFile.isOpen()) {
+        // Don't leave a partial file behind
+        _downloadFile.remove();
     }
     
-    _readFileAccumulator.clear();
-    
     // Close the open session
     _sendResetCommand();
 }
@@ -173,52 +331,28 @@ void FileManager::_downloadAckResponse(Request* readAck, bool readFile)
         return;
     }
 
-    if (readAck->hdr.offset != _downloadOffset) {
-        if (readFile) {
-            _closeDownloadSession(false /* failure */);
-            _emitErrorMessage(tr("Download: Offset returned (%1) differs from offset requested/expected (%2)").arg(readAck->hdr.offset).arg(_downloadOffset));
-            return;
-        } else { // burst
-            if (readAck->hdr.offset < _downloadOffset) { // old data: ignore it
-                _setupAckTimeout();
-                return;
-            }
-            // keep track of missing data chunks
-            MissingData missingData;
-            missingData.offset = _downloadOffset;
-            missingData.size = readAck->hdr.offset - _downloadOffset;
-            _missingData.push_back(missingData);
-            _missingDownloadedBytes += readAck->hdr.offset - _downloadOffset;
-            qCDebug(FileManagerLog) << QString("_downloadAckResponse: missing data: offset(%1) size(%2)").arg(missingData.offset).arg(missingData.size);
-            _downloadOffset = readAck->hdr.offset;
-            _readFileAccumulator.resize(_downloadOffset); // placeholder for the missing data
-        }
+    if (readFile && readAck->hdr.offset != _downloadOffset) {
+        _closeDownloadSession(false /* failure */);
+        _emitErrorMessage(tr("Download: Offset returned (%1) differs from offset requested/expected (%2)").arg(readAck->hdr.offset).arg(_downloadOffset));
+        return;
     }
     
     qCDebug(FileManagerLog) << QString("_downloadAckResponse: offset(%1) size(%2) burstComplete(%3)").arg(readAck->hdr.offset).arg(readAck->hdr.size).arg(readAck->hdr.burstComplete);
 
-    if (_downloadingMissingParts) {
-        Q_ASSERT(_missingData.head().offset == _downloadOffset);
-        _missingDownloadedBytes -= readAck->hdr.size;
-        _readFileAccumulator.replace(_downloadOffset, readAck->hdr.size, (const char*)readAck->data, readAck->hdr.size);
-        if (_missingData.head().size <= readAck->hdr.size) {
-            _missingData.pop_front();
-        } else {
-            _missingData.head().size -= readAck->hdr.size;
-            _missingData.head().offset += readAck->hdr.size;
-        }
-    } else {
-        _downloadOffset += readAck->hdr.size;
-        _readFileAccumulator.append((const char*)readAck->data, readAck->hdr.size);
+    if (!_writeDownloadData(readAck->hdr.offset, readAck->data, readAck->hdr.size)) {
+        _closeDownloadSession(false /* failure */);
+        _emitErrorMessage(tr("Unable to write data to local file (%1)").arg(_downloadFile.fileName()));
+        return;
     }
-    
-    if (_downloadFileSize != 0) {
-        emit commandProgress(100 * ((float)(_readFileAccumulator.length() - _missingDownloadedBytes) / (float)_downloadFileSize));
+
+    // Burst packets which were dropped simply leave their chunks unset in the bitmap, they are filled in at the end
+    if (readAck->hdr.offset + readAck->hdr.size > _downloadOffset) {
+        _downloadOffset = readAck->hdr.offset + readAck->hdr.size;
     }
+    
+    _emitDownloadProgress();
 
-    if (_downloadingMissingParts) {
-        _requestMissingData();
-    } else if (readFile || readAck->hdr.burstComplete) {
+    if (readFile || readAck->hdr.burstComplete) {
         // Possibly still more data to read, send next read request
 
         Request request;
@@ -228,7 +362,7 @@ void FileManager::_downloadAckResponse(Request* readAck, bool readFile)
         request.hdr.size = 0;
 
         _sendRequest(&request);
-    } else if (!readFile) {
+    } else {
         // Streaming, so next ack should come automatically
         _setupAckTimeout();
     }
@@ -391,6 +525,11 @@ void FileManager::receiveMessage(mavlink_message_t message)
     
     Request* request = (Request*)&data.payload[0];
 
+    if (_currentOperation == kCORepair) {
+        _repairResponse(request);
+        return;
+    }
+
     uint16_t incomingSeqNumber = request->hdr.seqNumber;
     
     // Make sure we have a good sequence number
@@ -768,6 +907,11 @@ void FileManager::_clearAckTimeout(void)
 void FileManager::_ackTimeout(void)
 {
     qCDebug(FileManagerLog) << "_ackTimeout";
+
+    if (_currentOperation == kCORepair) {
+        _repairTimeout();
+        return;
+    }
     
     if (++_ackNumTries <= ackTimerMaxRetries) {
         qCDebug(FileManagerLog) << "ack timeout - retrying";
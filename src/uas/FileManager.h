@@ -14,7 +14,10 @@
 #include <QObject>
 #include <QDir>
 #include <QTimer>
-#include <QQueue>
+#include <QFile>
+#include <QBitArray>
+#include <QMap>
+#include <QElapsedTimer>
 
 #include "UASInterface.h"
 #include "QGCLoggingCategory.h"
@@ -47,6 +50,9 @@ public:
 
     static const int ackTimerMaxRetries = 6;
 
+    /// Maximum number of Read requests outstanding while filling gaps left by a burst download
+    static const int repairWindow = 8;
+
 	/// Downloads the specified file.
 	///     @param from File to download from UAS, fully qualified path
 	///     @param downloadDir Local directory to download file to
@@ -67,6 +73,12 @@ public:
     /// Create a remote directory
     void createDirectory(const QString& directory);
 
+    /// @return Unique bytes per second received for the current or last download
+    double downloadBytesPerSecond(void) const;
+
+    /// @return Number of Read requests sent to fill gaps during the current or last download
+    int downloadRepairCount(void) const { return _downloadRepairCount; }
+
 signals:
     // Signals associated with the listDirectory method
     
@@ -178,6 +190,7 @@ private:
 			kCOOpenBurst,   // waiting for Open response, followed by Burst download
             kCORead,		// waiting for Read response
 			kCOBurst,		// waiting for Burst response
+            kCORepair,      // waiting for Read responses filling gaps in a download
             kCOWrite,       // waiting for Write response
             kCOCreate,      // waiting for Create response
             kCOCreateDir,   // waiting for Create Directory response
@@ -202,7 +215,13 @@ private:
     void _closeDownloadSession(bool success);
     void _closeUploadSession(bool success);
     void _downloadWorker(const QString& from, const QDir& downloadDir, bool readFile);
-    void _requestMissingData();
+    bool _openDownloadFile(void);
+    bool _writeDownloadData(uint32_t offset, const uint8_t* data, uint32_t size);
+    void _emitDownloadProgress(void);
+    void _startRepair(void);
+    void _fillRepairWindow(void);
+    void _repairResponse(Request* response);
+    void _repairTimeout(void);
     
     static QString errorString(uint8_t errorCode);
 
@@ -227,18 +246,28 @@ private:
     uint32_t    _writeFileSize;             ///< Size of file being uploaded
     QByteArray  _writeFileAccumulator;      ///< Holds file being uploaded
     
-    struct MissingData {
-        uint32_t offset;
-        uint32_t size;
-    };
+    typedef struct {
+        int     chunk;      ///< Chunk requested
+        qint64  sentMSecs;  ///< Download time the request was sent at
+    } RepairRequest_t;
+
+    /// Downloads are tracked in chunks of the size of a full Read response
+    static const uint32_t _downloadChunkSize = sizeof(((Request*)0)->data);
+
     uint32_t    _downloadOffset;            ///< current download offset
-    uint32_t    _missingDownloadedBytes;    ///< number of missing bytes for burst download
-    QQueue<MissingData> _missingData;       ///< missing chunks of downloaded file (for burst downloads)
-    bool        _downloadingMissingParts;   ///< true if we are currently downloading missing parts
-    QByteArray  _readFileAccumulator;       ///< Holds file being downloaded
     QDir        _readFileDownloadDir;       ///< Directory to download file to
     QString     _readFileDownloadFilename;  ///< Filename (no path) for download file
     uint32_t    _downloadFileSize;          ///< Size of file being downloaded
+    QFile       _downloadFile;              ///< Local file data is written to as it arrives
+    QBitArray   _downloadChunks;            ///< One bit per chunk, set once the chunk is written
+    int         _downloadChunksReceived;    ///< Number of bits set in _downloadChunks
+    uint32_t    _downloadBytesReceived;     ///< Unique bytes written to the local file
+    QElapsedTimer _downloadTimer;           ///< Started when the download file is opened
+    qint64      _downloadElapsedMSecs;      ///< Download time at the last received data
+    int         _downloadRepairCount;       ///< Number of Read requests sent to fill gaps
+    int         _repairScanChunk;           ///< Next chunk to check for a gap
+    bool        _repairProgress;            ///< true: repair data arrived since the last timeout
+    QMap<uint16_t, RepairRequest_t> _repairRequests;    ///< Outstanding repair requests keyed by expected response sequence number
 
     uint8_t     _systemIdQGC;               ///< System ID for QGC
     uint8_t     _systemIdServer;            ///< System ID for server
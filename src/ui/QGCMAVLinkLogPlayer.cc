@@ -18,6 +18,7 @@
 QGCMAVLinkLogPlayer::QGCMAVLinkLogPlayer(QWidget *parent)
     : QWidget           (parent)
     , _replayLink       (NULL)
+    , _logTimestamped   (false)
     , _lastCurrentTime  (0)
     , _ui               (new Ui::QGCMAVLinkLogPlayer)
 {
@@ -29,6 +30,7 @@ QGCMAVLinkLogPlayer::QGCMAVLinkLogPlayer(QWidget *parent)
     connect(_ui->playButton,        &QPushButton::clicked,      this, &QGCMAVLinkLogPlayer::_playPauseToggle);
     connect(_ui->positionSlider,    &QSlider::valueChanged,     this, &QGCMAVLinkLogPlayer::_setPlayheadFromSlider);
     connect(_ui->positionSlider,    &QSlider::sliderPressed,    this, &QGCMAVLinkLogPlayer::_pause);
+    connect(_ui->fastReplayCheckBox, &QCheckBox::toggled,       this, &QGCMAVLinkLogPlayer::_setFastReplay);
 
 #if 0
     // Speed slider is removed from 3.0 release. Too broken to fix.
@@ -102,6 +104,7 @@ void QGCMAVLinkLogPlayer::_selectLogFileForPlayback(void)
 #if 0
     _ui->speedSlider->setValue(0);
 #endif
+    _replayLink->setFastReplay(_ui->fastReplayCheckBox->isChecked());
 }
 
 void QGCMAVLinkLogPlayer::_playbackError(void)
@@ -126,13 +129,18 @@ void QGCMAVLinkLogPlayer::_logFileStats(bool    logTimestamped,         ///< tru
                                         int     logDurationSeconds,     ///< Log duration
                                         int     binaryBaudRate)         ///< Baud rate for non-timestamped log
 {
-    Q_UNUSED(logTimestamped);
     Q_UNUSED(binaryBaudRate);
 
     qDebug() << "_logFileStats" << logDurationSeconds;
 
+    _logTimestamped = logTimestamped;
     _logDurationSeconds = logDurationSeconds;
 
+    // Timestamped logs seek by time, which gives one second steps on long logs instead of one percent
+    _ui->positionSlider->blockSignals(true);
+    _ui->positionSlider->setMaximum(_logTimestamped ? qMax(logDurationSeconds, 1) : 100);
+    _ui->positionSlider->blockSignals(false);
+
     _ui->logLengthTime->setText(_secondsToHMS(logDurationSeconds));
 }
 
@@ -155,6 +163,10 @@ void QGCMAVLinkLogPlayer::_playbackPaused(void)
 
 void QGCMAVLinkLogPlayer::_playbackPercentCompleteChanged(int percentComplete)
 {
+    if (_logTimestamped) {
+        // Slider follows the log time instead
+        return;
+    }
     _ui->positionSlider->blockSignals(true);
     _ui->positionSlider->setValue(percentComplete);
     _ui->positionSlider->blockSignals(false);
@@ -163,7 +175,18 @@ void QGCMAVLinkLogPlayer::_playbackPercentCompleteChanged(int percentComplete)
 void QGCMAVLinkLogPlayer::_setPlayheadFromSlider(int value)
 {
     if (_replayLink) {
-        _replayLink->movePlayhead(value);
+        if (_logTimestamped) {
+            _replayLink->movePlayheadToTime(value);
+        } else {
+            _replayLink->movePlayhead(value);
+        }
+    }
+}
+
+void QGCMAVLinkLogPlayer::_setFastReplay(bool fastReplay)
+{
+    if (_replayLink) {
+        _replayLink->setFastReplay(fastReplay);
     }
 }
 
@@ -215,4 +238,9 @@ void QGCMAVLinkLogPlayer::_setCurrentLogTime(int secs)
         _lastCurrentTime = secs;
         _ui->logCurrentTime->setText(_secondsToHMS(secs));
     }
+    if (_logTimestamped) {
+        _ui->positionSlider->blockSignals(true);
+        _ui->positionSlider->setValue(secs);
+        _ui->positionSlider->blockSignals(false);
+    }
 }
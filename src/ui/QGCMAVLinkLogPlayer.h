@@ -33,6 +33,7 @@ private slots:
     void _playPauseToggle(void);
     void _pause(void);
     void _setPlayheadFromSlider(int value);
+    void _setFastReplay(bool fastReplay);
 #if 0
     void _setAccelerationFromSlider(int value);
 #endif
@@ -50,6 +51,7 @@ private:
     void _enablePlaybackControls(bool enabled);
 
     LogReplayLink*  _replayLink;
+    bool            _logTimestamped;        ///< true: Position slider is in seconds, false: percent of the file
     int             _logDurationSeconds;
     int             _lastCurrentTime;
     
@@ -41,7 +41,11 @@ QGCView {
     property real _valueFieldWidth:             ScreenTools.defaultFontPixelWidth * 8
     property Fact _mapProvider:                 QGroundControl.settingsManager.flightMapSettings.mapProvider
     property Fact _mapType:                     QGroundControl.settingsManager.flightMapSettings.mapType
+    property Fact _trajectoryHistoryLength:     QGroundControl.settingsManager.flightMapSettings.trajectoryHistoryLength
+    property var  _videoReceiver:               QGroundControl.videoManager.videoReceiver
     property Fact _followTarget:                QGroundControl.settingsManager.appSettings.followTarget
+    property var  _rtcmMavlink:                 QGroundControl.gpsManager ? QGroundControl.gpsManager.rtcmMavlink : null
+    property bool _showRtcmStatistics:          _rtcmMavlink ? true : false
     property real _panelWidth:                  _qgcView.width * _internalWidthRatio
     property real _margins:                     ScreenTools.defaultFontPixelWidth
 
@@ -174,6 +178,16 @@ QGCView {
                                     }
                                 }
 
+                                QGCLabel {
+                                    text:       qsTr("Flight Path History")
+                                    visible:    _trajectoryHistoryLength.visible
+                                }
+                                FactTextField {
+                                    Layout.preferredWidth:  _valueFieldWidth
+                                    fact:                   _trajectoryHistoryLength
+                                    visible:                _trajectoryHistoryLength.visible
+                                }
+
                                 QGCLabel {
                                     text:       qsTr("Stream GCS Position")
                                     visible:    _followTarget.visible
@@ -413,6 +427,28 @@ QGCView {
                                 Layout.preferredWidth:  _valueFieldWidth
                                 fact:                   QGroundControl.settingsManager.rtkSettings.surveyInMinObservationDuration
                             }
+
+                            QGCLabel { text: qsTr("Correction bandwidth limit") }
+                            FactTextField {
+                                Layout.preferredWidth:  _valueFieldWidth
+                                fact:                   QGroundControl.settingsManager.rtkSettings.correctionBandwidthLimit
+                            }
+
+                            // Correction injection statistics, only while an RTK GPS is connected
+                            QGCLabel { text: qsTr("Correction input rate");     visible: _showRtcmStatistics }
+                            QGCLabel { text: _rtcmMavlink ? qsTr("%1 B/s").arg(_rtcmMavlink.inputBytesPerSecond.toFixed(0)) : "";   visible: _showRtcmStatistics }
+
+                            QGCLabel { text: qsTr("Correction output rate");    visible: _showRtcmStatistics }
+                            QGCLabel { text: _rtcmMavlink ? qsTr("%1 B/s").arg(_rtcmMavlink.outputBytesPerSecond.toFixed(0)) : "";  visible: _showRtcmStatistics }
+
+                            QGCLabel { text: qsTr("Correction links");          visible: _showRtcmStatistics }
+                            QGCLabel { text: _rtcmMavlink ? _rtcmMavlink.linkCount : "";                                            visible: _showRtcmStatistics }
+
+                            QGCLabel { text: qsTr("Pending correction data");   visible: _showRtcmStatistics }
+                            QGCLabel { text: _rtcmMavlink ? qsTr("%1 bytes").arg(_rtcmMavlink.pendingBytes) : "";                   visible: _showRtcmStatistics }
+
+                            QGCLabel { text: qsTr("Dropped corrections");       visible: _showRtcmStatistics }
+                            QGCLabel { text: _rtcmMavlink ? _rtcmMavlink.droppedMessages : "";                                      visible: _showRtcmStatistics }
                         }
                     }
 
@@ -599,6 +635,25 @@ QGCView {
                                 fact:       QGroundControl.settingsManager.videoSettings.disableWhenDisarmed
                                 visible:    QGroundControl.videoManager.isGStreamer && videoSource.currentIndex && videoSource.currentIndex < 3 && QGroundControl.settingsManager.videoSettings.gridLines.visible
                             }
+
+                            QGCLabel {
+                                text:       qsTr("Low Latency Mode")
+                                visible:    QGroundControl.videoManager.isGStreamer && videoSource.currentIndex && videoSource.currentIndex < 3 && QGroundControl.settingsManager.videoSettings.lowLatencyMode.visible
+                            }
+                            FactCheckBox {
+                                text:       ""
+                                fact:       QGroundControl.settingsManager.videoSettings.lowLatencyMode
+                                visible:    QGroundControl.videoManager.isGStreamer && videoSource.currentIndex && videoSource.currentIndex < 3 && QGroundControl.settingsManager.videoSettings.lowLatencyMode.visible
+                            }
+
+                            QGCLabel {
+                                text:       qsTr("Video Latency")
+                                visible:    QGroundControl.videoManager.isGStreamer && videoSource.currentIndex && videoSource.currentIndex < 3 && _videoReceiver && _videoReceiver.videoRunning
+                            }
+                            QGCLabel {
+                                text:       _videoReceiver ? _videoReceiver.latency.valueString + " " + _videoReceiver.latency.units : ""
+                                visible:    QGroundControl.videoManager.isGStreamer && videoSource.currentIndex && videoSource.currentIndex < 3 && _videoReceiver && _videoReceiver.videoRunning
+                            }
                         }
                     }
 